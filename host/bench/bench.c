@@ -0,0 +1,235 @@
+/*
+ * Benchmarki modułów firmware na hoście
+ *
+ *   ./host_bench            - wszystkie przypadki
+ *   ./host_bench eq         - tylko przypadki, których nazwa zawiera "eq"
+ *
+ * Czas na iterację z zegara monotonicznego, cykle z TSC (x86-64). Wyniki hosta nie
+ * przekładają się 1:1 na Xtensa - służą do porównań przed/po zmianie i między
+ * wariantami algorytmu.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "nvs.h"
+#include "esp_http_client.h"
+#include "radio_browser.h"
+#include "radio_stations.h"
+#include "eq_filter.h"
+#include "eq_reference.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+typedef struct {
+    const char *name;
+    void (*setup)(void);
+    void (*run)(void);
+    void (*teardown)(void);
+    int iterations;
+    const char *unit;           // Jednostka pracy jednej iteracji (do przeliczenia)
+    double units_per_iter;
+    void (*report)(void);       // Dodatkowe wyniki po pomiarze (przed teardown), opcjonalne
+} bench_case_t;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t now_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// ============================================
+// radio_browser: 20 stacji w JSON
+// ============================================
+
+static char *stations_json;
+static radio_browser_station_t rb_results[RADIO_BROWSER_MAX_RESULTS];
+
+static void rb_setup(void)
+{
+    size_t size = 32768, len = 0;
+    stations_json = malloc(size);
+    len += snprintf(stations_json + len, size - len, "[");
+    for (int i = 0; i < RADIO_BROWSER_MAX_RESULTS; i++) {
+        len += snprintf(stations_json + len, size - len,
+                        "%s{\"changeuuid\":\"%08x-0000-0000-0000-000000000000\",\"name\":\"Stacja %d\","
+                        "\"url\":\"http://s%d.example/live\",\"url_resolved\":\"http://s%d.example/live.mp3\","
+                        "\"homepage\":\"http://s%d.example/\",\"favicon\":\"\",\"tags\":\"pop,rock,news\","
+                        "\"country\":\"Poland\",\"countrycode\":\"PL\",\"language\":\"polish\","
+                        "\"votes\":%d,\"codec\":\"MP3\",\"bitrate\":128,\"hls\":0,\"lastcheckok\":1}",
+                        i ? "," : "", i, i, i, i, i, 1000 - i);
+    }
+    snprintf(stations_json + len, size - len, "]");
+    host_http_reset();
+    // Jedna porcja - jedno vTaskDelay(1) (1 ms) na zapytanie, reszta to klient i parser
+    host_http_add_response("/stations/", 200, stations_json, 32768, false);
+}
+
+static void rb_run(void)
+{
+    radio_browser_search_by_name("stacja", "PL", rb_results, RADIO_BROWSER_MAX_RESULTS);
+}
+
+static void rb_teardown(void)
+{
+    host_http_reset();
+    free(stations_json);
+}
+
+// ============================================
+// radio_stations: zapis i odczyt listy z NVS (tyle stacji, ile mieści jeden wpis)
+// ============================================
+
+#define BENCH_STATIONS 25
+
+static void stations_setup(void)
+{
+    host_nvs_reset();
+    radio_stations_init();
+    for (int i = 0; i < BENCH_STATIONS; i++) {
+        char name[32], url[64];
+        snprintf(name, sizeof(name), "Stacja %d", i);
+        snprintf(url, sizeof(url), "http://s%d.example/live.mp3", i);
+        radio_stations_add(name, url, NULL);
+    }
+}
+
+static void stations_run(void)
+{
+    radio_stations_save();
+    radio_stations_load();
+}
+
+// ============================================
+// eq_filter: blok 1152 ramek stereo, wszystkie pasma aktywne
+//
+// Stockowy `equalizer` ESP-ADF to zamknięta biblioteka tylko dla Xtensa - na hoście
+// porównanie jest z kaskadą w double (test/eq_reference.h): czas bloku obu wariantów
+// i błąd wyjścia eq_filter względem referencji.
+// ============================================
+
+#define EQ_BLOCK_FRAMES 1152
+static const int eq_band_freq[EQ_FILTER_BANDS] = {
+    31, 62, 125, 250, 500, 1000, 2000, 4000, 8000, 16000
+};
+static audio_element_handle_t eq;
+static int16_t eq_in[EQ_BLOCK_FRAMES * 2], eq_out[EQ_BLOCK_FRAMES * 2];
+static int eq_gains[EQ_FILTER_BANDS * 2];
+static eq_ref_t eq_ref;
+static double eq_ref_out[EQ_BLOCK_FRAMES * 2];
+
+static void eq_setup(void)
+{
+    eq_filter_cfg_t cfg = DEFAULT_EQ_FILTER_CONFIG();
+    cfg.band_freq = eq_band_freq;
+    eq = eq_filter_init(&cfg);
+    for (int i = 0; i < EQ_FILTER_BANDS * 2; i++) {
+        eq_gains[i] = (i % 2) ? 6 : -4;
+    }
+    eq_filter_set_all_gains(eq, eq_gains, false);
+    // Poziom bez przesterowania po +6 dB w pięciu pasmach (błąd bez wpływu nasycenia)
+    srand(1);
+    for (int i = 0; i < EQ_BLOCK_FRAMES * 2; i++) {
+        eq_in[i] = (int16_t)((rand() % 6000) - 3000);
+    }
+}
+
+static void eq_run(void)
+{
+    host_audio_element_run(eq, eq_in, sizeof(eq_in), eq_out, sizeof(eq_out));
+}
+
+static void eq_teardown(void)
+{
+    audio_element_deinit(eq);
+}
+
+// Błąd względem referencji na 50 blokach z tego samego stanu początkowego
+static void eq_report(void)
+{
+    eq_filter_cfg_t cfg = DEFAULT_EQ_FILTER_CONFIG();
+    cfg.band_freq = eq_band_freq;
+    cfg.set_gain = eq_gains;
+    audio_element_handle_t fresh = eq_filter_init(&cfg);
+    eq_ref_init(&eq_ref, eq_band_freq, eq_gains, 44100, 2);
+
+    double max = 0, sum = 0, sum2 = 0;
+    long count = 0;
+    for (int blk = 0; blk < 50; blk++) {
+        host_audio_element_run(fresh, eq_in, sizeof(eq_in), eq_out, sizeof(eq_out));
+        eq_ref_process(&eq_ref, eq_in, eq_ref_out, EQ_BLOCK_FRAMES);
+        for (int i = 0; i < EQ_BLOCK_FRAMES * 2; i++) {
+            double e = eq_out[i] - eq_ref_out[i];
+            max = fabs(e) > max ? fabs(e) : max;
+            sum += e;
+            sum2 += e * e;
+            count++;
+        }
+    }
+    audio_element_deinit(fresh);
+    printf("    error vs double reference: max %.3f LSB, rms %.3f LSB, dc %+.4f LSB\n",
+           max, sqrt(sum2 / count), sum / count);
+}
+
+static void eq_ref_setup(void)
+{
+    eq_setup();
+    eq_ref_init(&eq_ref, eq_band_freq, eq_gains, 44100, 2);
+}
+
+static void eq_ref_run(void)
+{
+    eq_ref_process(&eq_ref, eq_in, eq_ref_out, EQ_BLOCK_FRAMES);
+}
+
+// ============================================
+// Rejestr przypadków
+// ============================================
+
+static const bench_case_t cases[] = {
+    { "radio_browser_parse_20", rb_setup, rb_run, rb_teardown, 2000, "station", RADIO_BROWSER_MAX_RESULTS },
+    { "radio_stations_save_load", stations_setup, stations_run, NULL, 500, "station", BENCH_STATIONS },
+    { "eq_filter_10band_block", eq_setup, eq_run, eq_teardown, 2000, "frame", EQ_BLOCK_FRAMES, eq_report },
+    { "eq_reference_double_block", eq_ref_setup, eq_ref_run, eq_teardown, 2000, "frame", EQ_BLOCK_FRAMES },
+};
+
+int main(int argc, char **argv)
+{
+    const char *filter = argc > 1 ? argv[1] : NULL;
+
+    printf("%-28s %10s %12s %14s %14s\n", "case", "iters", "us/iter", "cycles/iter", "ns/unit");
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        const bench_case_t *c = &cases[i];
+        if (filter && !strstr(c->name, filter)) {
+            continue;
+        }
+        if (c->setup) c->setup();
+        c->run();   // Rozgrzewka
+        double start = now_s();
+        uint64_t start_cycles = now_cycles();
+        for (int n = 0; n < c->iterations; n++) {
+            c->run();
+        }
+        double cycles = (double)(now_cycles() - start_cycles) / c->iterations;
+        double per_iter = (now_s() - start) / c->iterations;
+
+        printf("%-28s %10d %12.2f %14.0f %10.1f/%s\n", c->name, c->iterations,
+               per_iter * 1e6, cycles, per_iter * 1e9 / c->units_per_iter, c->unit);
+        if (c->report) c->report();
+        if (c->teardown) c->teardown();
+    }
+    return 0;
+}
@@ -0,0 +1,104 @@
+/*
+ * Host fake: audio_player
+ * Część API odtwarzacza, której używają moduły budowane na hoście
+ */
+
+#include <string.h>
+
+#include "audio_player.h"
+#include "audio_settings.h"
+#include "eq_filter.h"
+#include "host_player.h"
+
+static audio_element_handle_t equalizer = NULL;
+static char last_url[512];
+static int play_count = 0;
+static int eq_gains[EQ_FILTER_BANDS];
+static int volume = 50;
+
+void host_player_set_equalizer(audio_element_handle_t eq)
+{
+    equalizer = eq;
+}
+
+void host_player_reset(void)
+{
+    equalizer = NULL;
+    last_url[0] = '\0';
+    play_count = 0;
+    memset(eq_gains, 0, sizeof(eq_gains));
+    volume = 50;
+}
+
+const char *host_player_last_url(void)
+{
+    return last_url;
+}
+
+int host_player_play_count(void)
+{
+    return play_count;
+}
+
+const int *host_player_eq_gains(void)
+{
+    return eq_gains;
+}
+
+esp_err_t audio_player_play_url(const char *url)
+{
+    if (url == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    strncpy(last_url, url, sizeof(last_url) - 1);
+    play_count++;
+    return ESP_OK;
+}
+
+audio_element_handle_t audio_player_get_equalizer(void)
+{
+    return equalizer;
+}
+
+// Jak w audio_player.c: pasma obu kanałów z przesunięciem balansu
+static esp_err_t apply_eq_gains(void)
+{
+    if (equalizer == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    int left_atten, right_atten;
+    audio_settings_get_balance_db(&left_atten, &right_atten);
+    int gains[EQ_FILTER_BANDS * 2];
+    for (int i = 0; i < EQ_FILTER_BANDS; i++) {
+        int l = eq_gains[i] + left_atten, r = eq_gains[i] + right_atten;
+        gains[i] = l < -13 ? -13 : (l > 13 ? 13 : l);
+        gains[i + EQ_FILTER_BANDS] = r < -13 ? -13 : (r > 13 ? 13 : r);
+    }
+    return eq_filter_set_all_gains(equalizer, gains, false);
+}
+
+esp_err_t audio_player_set_eq_band(int band, int gain_db)
+{
+    if (band < 0 || band >= EQ_FILTER_BANDS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    eq_gains[band] = gain_db;
+    return apply_eq_gains();
+}
+
+esp_err_t audio_player_set_eq_all_bands(const int *gains_db)
+{
+    memcpy(eq_gains, gains_db, sizeof(eq_gains));
+    return apply_eq_gains();
+}
+
+esp_err_t audio_player_set_volume(int value)
+{
+    volume = value;
+    return ESP_OK;
+}
+
+int audio_player_get_volume(void)
+{
+    return volume;
+}
@@ -0,0 +1,21 @@
+/*
+ * Host fake: audio_player
+ * Zamiast pipeline ESP-ADF - zapamiętuje wywołania, EQ przekazuje do prawdziwego eq_filter
+ */
+
+#ifndef HOST_PLAYER_H
+#define HOST_PLAYER_H
+
+#include "audio_player.h"
+
+// Element EQ zwracany przez audio_player_get_equalizer() (NULL - odtwarzacz bez EQ)
+void host_player_set_equalizer(audio_element_handle_t eq);
+
+void host_player_reset(void);
+const char *host_player_last_url(void);
+int host_player_play_count(void);
+
+// Ostatnie wzmocnienia ustawione przez audio_player_set_eq_all_bands/set_eq_band (dB)
+const int *host_player_eq_gains(void);
+
+#endif // HOST_PLAYER_H
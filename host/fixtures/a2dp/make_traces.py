@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+"""
+Ślady przyjścia pakietów A2DP dla test_jitter_buffer (host/test/test_jitter_buffer.c).
+
+Format: linie "czas_przyjścia_us długość_bajtów" (PCM 44.1 kHz stereo 16 bit po SBC),
+komentarze od "#". Ten sam format daje bluetooth_sink.c z SINK_ARRIVAL_TRACE = 1:
+
+  python3 host/fixtures/a2dp/make_traces.py                     # modele nadawców poniżej
+  python3 host/fixtures/a2dp/make_traces.py --from-log monitor.txt phone.trace
+"""
+
+import argparse
+import os
+import random
+import re
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+RATE = 44100
+FRAME_BYTES = 4
+PACKET_FRAMES = 512                 # Typowy pakiet SBC (bitpool 53) po dekodowaniu
+
+
+def model(seconds, ppm, jitter_us, stall_prob=0.0, stall_us=(10000, 40000), per_send=1,
+          pause_at=None, pause_s=0.0, seed=1):
+    """Nadawca taktowany zegarem (1 + ppm) względem I2S. Opóźnione pakiety przychodzą
+    jeden za drugim (kolejka w stosie BT), nigdy w innej kolejności."""
+    rnd = random.Random(seed)
+    dur = PACKET_FRAMES / RATE * 1e6 / (1 + ppm * 1e-6)
+    t = 0.0
+    last = 0.0
+    stall_left = 0.0
+    out = []
+    i = 0
+    while t < seconds * 1e6:
+        if pause_at is not None and pause_at * 1e6 <= t < (pause_at + pause_s) * 1e6:
+            t = (pause_at + pause_s) * 1e6
+            last = t
+        # Telefon wysyła po per_send pakietów naraz
+        send_at = t + dur * (per_send - 1 - i % per_send)
+        delay = abs(rnd.gauss(0, jitter_us))
+        if stall_left <= 0 and rnd.random() < stall_prob:
+            stall_left = rnd.uniform(*stall_us)
+        if stall_left > 0:
+            delay += stall_left
+            stall_left -= dur
+        arrival = max(send_at + delay, last + 150)
+        out.append((int(arrival), PACKET_FRAMES * FRAME_BYTES))
+        last = arrival
+        t += dur
+        i += 1
+    return out
+
+
+TRACES = {
+    # Telefon obok, zegar +30 ppm
+    'steady.trace': dict(seconds=30, ppm=30, jitter_us=800, seed=1),
+    # Współdzielenie anteny z WiFi: co kilka sekund przestój 10-40 ms i paczka
+    'wifi_coex.trace': dict(seconds=60, ppm=-20, jitter_us=1500, stall_prob=0.004, seed=2),
+    # Wolny zegar telefonu (dryf wychodzi poza strefę bez korekty), po dwa pakiety naraz
+    'slow_clock_pairs.trace': dict(seconds=60, ppm=-200, jitter_us=1000, per_send=2, seed=3),
+    # Pauza nadawcy 2 s w środku (dłużej niż JITTER_GAP_MS)
+    'pause_resume.trace': dict(seconds=30, ppm=10, jitter_us=800, pause_at=15, pause_s=2.0, seed=4),
+}
+
+
+def write_trace(path, packets, comment):
+    with open(path, 'w') as f:
+        f.write('# %s\n' % comment)
+        for at, length in packets:
+            f.write('%d %d\n' % (at, length))
+
+
+def from_log(log_path):
+    """Linie "A2DP_TRACE <us> <len>" z logu monitora; czasy od zera."""
+    packets = []
+    pattern = re.compile(r'A2DP_TRACE (\d+) (\d+)')
+    with open(log_path, errors='replace') as f:
+        for line in f:
+            m = pattern.search(line)
+            if m:
+                packets.append((int(m.group(1)), int(m.group(2))))
+    if packets:
+        t0 = packets[0][0]
+        packets = [(at - t0, length) for at, length in packets]
+    return packets
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    p.add_argument('--from-log', nargs=2, metavar=('LOG', 'TRACE'), help='ślad z logu urządzenia')
+    args = p.parse_args()
+
+    if args.from_log:
+        log_path, trace = args.from_log
+        packets = from_log(log_path)
+        write_trace(trace, packets, 'recorded: %s' % os.path.basename(log_path))
+        print('%s: %d packets' % (trace, len(packets)))
+        return
+
+    for name, params in TRACES.items():
+        comment = 'model: ' + ', '.join('%s=%s' % kv for kv in params.items())
+        write_trace(os.path.join(HERE, name), model(**params), comment)
+        print(name)
+
+
+if __name__ == '__main__':
+    main()
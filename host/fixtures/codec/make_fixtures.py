@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+"""
+Generuje próbki strumieni dla test_codec_detect (host/test/test_codec_detect.c).
+Ramki mają poprawne nagłówki i ciche/stałe treści - test sprawdza tylko detekcję.
+
+  python3 host/fixtures/codec/make_fixtures.py      # nadpisuje *.bin obok skryptu
+"""
+
+import os
+import random
+import struct
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+MP3_V1_L3 = [0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320]
+MP3_V2_L3 = [0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160]
+ADTS_RATES = [96000, 88200, 64000, 48000, 44100, 32000, 24000, 22050, 16000, 12000, 11025, 8000, 7350]
+
+
+def mp3_frames(count, bitrate, sample_rate=44100, mpeg1=True, mono=False):
+    """Layer III; padding jak w koderze (średnia długość = dokładna)."""
+    if mpeg1:
+        sr_idx = [44100, 48000, 32000].index(sample_rate)
+        br_idx = MP3_V1_L3.index(bitrate)
+        coef, b1 = 144, 0xFB
+    else:
+        sr_idx = [22050, 24000, 16000].index(sample_rate)
+        br_idx = MP3_V2_L3.index(bitrate)
+        coef, b1 = 72, 0xF3
+    out = bytearray()
+    exact = coef * bitrate * 1000 / sample_rate
+    acc = 0.0
+    for _ in range(count):
+        acc += exact - int(exact)
+        pad = 1 if acc >= 1.0 else 0
+        acc -= pad
+        length = int(exact) + pad
+        header = bytes([0xFF, b1, (br_idx << 4) | (sr_idx << 2) | (pad << 1), 0xC4 if mono else 0x44])
+        out += header + bytes([0x55]) * (length - 4)
+    return bytes(out)
+
+
+def adts_frames(count, sample_rate, channels, bitrate, crc=False):
+    """ADTS, AAC-LC (profil 1). HE-AAC w ADTS ma nagłówek rdzenia LC z połową częstotliwości."""
+    sr_idx = ADTS_RATES.index(sample_rate)
+    header_len = 9 if crc else 7
+    out = bytearray()
+    exact = bitrate * 1000 / 8 * 1024 / sample_rate
+    acc = 0.0
+    for _ in range(count):
+        acc += exact
+        length = int(acc)
+        acc -= length
+        header = bytes([
+            0xFF, 0xF0 if crc else 0xF1,
+            (1 << 6) | (sr_idx << 2) | (channels >> 2),
+            ((channels & 3) << 6) | (length >> 11),
+            (length >> 3) & 0xFF,
+            ((length & 7) << 5) | 0x1F,
+            0xFC,
+        ]) + (b'\x12\x34' if crc else b'')
+        out += header + bytes([0x21]) * (length - header_len)
+    return bytes(out)
+
+
+def id3v2(payload_len, footer=False):
+    """Tag ID3v2.4 z ramką TIT2 i dopełnieniem; w treści fałszywe synchronizacje MP3."""
+    title = b'\x03Fixture \xff\xfb\x90\x64 title'
+    frame = b'TIT2' + struct.pack('>I', len(title)) + b'\x00\x00' + title
+    body = frame + bytes([0xFF, 0xFB, 0x90, 0x64]) * 4
+    body += bytes(payload_len - len(body))
+    size = len(body)
+    syncsafe = bytes([(size >> 21) & 0x7F, (size >> 14) & 0x7F, (size >> 7) & 0x7F, size & 0x7F])
+    tag = b'ID3\x04\x00' + bytes([0x10 if footer else 0x00]) + syncsafe + body
+    if footer:
+        tag += b'3DI\x04\x00\x10' + syncsafe
+    return tag
+
+
+def box(kind, payload):
+    return struct.pack('>I', 8 + len(payload)) + kind + payload
+
+
+def junk(length, seed):
+    """Losowe bajty (np. resztka ramki innego strumienia) i nagłówki bez potwierdzenia."""
+    rnd = random.Random(seed)
+    out = bytearray(rnd.randrange(256) for _ in range(length))
+    out[0] = 0x00
+    # Poprawny nagłówek MP3 / ADTS, za którym nie ma następnej ramki
+    out[100:104] = bytes([0xFF, 0xFB, 0x90, 0x44])
+    out[300:307] = bytes([0xFF, 0xF1, 0x50, 0x80, 0x2E, 0x7F, 0xFC])
+    # Nie kończymy na 0xFF - koniec śmieci ma nie sklejać się z synchronizacją ramki
+    out[-1] = 0x00
+    return bytes(out)
+
+
+FIXTURES = {
+    'mp3_cbr128.bin': lambda: mp3_frames(12, 128),
+    'mp3_id3.bin': lambda: id3v2(1014) + mp3_frames(12, 128),
+    'mp3_id3_footer.bin': lambda: id3v2(502, footer=True) + mp3_frames(12, 192, 48000),
+    'mp3_id3_large.bin': lambda: id3v2(8000) + mp3_frames(4, 128),
+    'mp3_mpeg2_mono.bin': lambda: mp3_frames(16, 64, 22050, mpeg1=False, mono=True),
+    'adts_lc.bin': lambda: adts_frames(12, 44100, 2, 128),
+    'adts_crc.bin': lambda: adts_frames(12, 48000, 2, 96, crc=True),
+    'adts_he.bin': lambda: adts_frames(16, 24000, 2, 48),
+    'adts_he_mono.bin': lambda: adts_frames(16, 22050, 1, 32),
+    'mp4_ftyp.bin': lambda: box(b'ftyp', b'M4A \x00\x00\x02\x00isomiso2M4A mp42') + box(b'moov', bytes(64)),
+    'fmp4_styp.bin': lambda: box(b'styp', b'msdh\x00\x00\x00\x00msdhmsix') +
+                             box(b'moof', box(b'mfhd', bytes(8))) + box(b'mdat', bytes(256)),
+    'junk_mp3.bin': lambda: junk(1000, 1) + mp3_frames(12, 128),
+    'junk_adts.bin': lambda: junk(700, 2) + adts_frames(12, 44100, 2, 128),
+    'junk_only.bin': lambda: junk(4096, 3),
+}
+
+
+def main():
+    for name, make in FIXTURES.items():
+        with open(os.path.join(HERE, name), 'wb') as f:
+            f.write(make())
+        print(name)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,183 @@
+#!/usr/bin/env python3
+"""
+Próbki plików z tagami dla test_media_tags (host/test/test_media_tags.c).
+Audio to ciche ramki / zera - test sprawdza tylko tagi i długość.
+
+  python3 host/fixtures/tags/make_fixtures.py      # nadpisuje pliki obok skryptu
+"""
+
+import os
+import struct
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+
+def syncsafe(n):
+    return bytes([(n >> 21) & 0x7F, (n >> 14) & 0x7F, (n >> 7) & 0x7F, n & 0x7F])
+
+
+def text(enc, s):
+    if enc == 0:
+        return b'\x00' + s.encode('latin-1')
+    if enc == 1:
+        return b'\x01' + '﻿'.encode('utf-16-le') + s.encode('utf-16-le')
+    if enc == 2:
+        return b'\x02' + s.encode('utf-16-be')
+    return b'\x03' + s.encode('utf-8')
+
+
+def frame(version, fid, data, flags=b'\x00\x00'):
+    if version == 2:
+        return fid.encode() + len(data).to_bytes(3, 'big') + data
+    size = syncsafe(len(data)) if version == 4 else struct.pack('>I', len(data))
+    return fid.encode() + size + flags + data
+
+
+def id3v2(version, frames, padding=64, ext_header=False, footer=False):
+    body = b''
+    flags = 0
+    if ext_header:
+        flags |= 0x40
+        body += syncsafe(6) + b'\x01\x00' if version == 4 else struct.pack('>I', 6) + bytes(6)
+    if footer:
+        flags |= 0x10
+    body += b''.join(frames) + bytes(padding)
+    tag = b'ID3' + bytes([version, 0, flags]) + syncsafe(len(body)) + body
+    if footer:
+        tag += b'3DI' + bytes([version, 0, flags]) + syncsafe(len(body))
+    return tag
+
+
+def id3v1(title, artist, album, track):
+    def field(s, n):
+        return s.encode('latin-1').ljust(n, b' ')
+    return b'TAG' + field(title, 30) + field(artist, 30) + field(album, 30) + b'2001' + \
+        field('', 28) + b'\x00' + bytes([track]) + b'\x0c'
+
+
+def mp3_audio(frames=100):
+    """MPEG-1 Layer III 128 kbps 44.1 kHz, 417 B (bez paddingu)."""
+    return (b'\xff\xfb\x90\x64' + bytes(413)) * frames
+
+
+def atom(kind, payload):
+    return struct.pack('>I', 8 + len(payload)) + kind + payload
+
+
+def ilst_item(kind, value, data_type=1):
+    return atom(kind, atom(b'data', struct.pack('>II', data_type, 0) + value))
+
+
+def m4a(items, mvhd, iso_meta=True):
+    hdlr = atom(b'hdlr', bytes(8) + b'mdirappl' + bytes(9))
+    meta_body = (b'\x00\x00\x00\x00' if iso_meta else b'') + hdlr + atom(b'ilst', b''.join(items))
+    moov = atom(b'moov', mvhd + atom(b'udta', atom(b'meta', meta_body)))
+    return atom(b'ftyp', b'M4A \x00\x00\x02\x00isomM4A ') + atom(b'mdat', bytes(512)) + moov
+
+
+def mvhd_v0(timescale, duration):
+    return atom(b'mvhd', b'\x00\x00\x00\x00' + bytes(8) + struct.pack('>II', timescale, duration) + bytes(80))
+
+
+def mvhd_v1(timescale, duration):
+    return atom(b'mvhd', b'\x01\x00\x00\x00' + bytes(16) + struct.pack('>IQ', timescale, duration) + bytes(80))
+
+
+def flac(comments, rate=44100, samples=44100 * 125, picture=0):
+    si = bytearray(34)
+    si[10] = (rate >> 12) & 0xFF
+    si[11] = (rate >> 4) & 0xFF
+    si[12] = ((rate & 0xF) << 4) | (1 << 1)
+    si[13] = (15 << 4) | ((samples >> 32) & 0xF)
+    si[14:18] = struct.pack('>I', samples & 0xFFFFFFFF)
+    vc = struct.pack('<I', 9) + b'reference' + struct.pack('<I', len(comments))
+    for c in comments:
+        e = c.encode('utf-8')
+        vc += struct.pack('<I', len(e)) + e
+    blocks = [(0, bytes(si)), (4, vc)]
+    if picture:
+        blocks.append((6, bytes(picture)))
+    out = b'fLaC'
+    for i, (kind, data) in enumerate(blocks):
+        last = 0x80 if i == len(blocks) - 1 else 0
+        out += bytes([last | kind]) + len(data).to_bytes(3, 'big') + data
+    return out + bytes(256)
+
+
+def wav(info, rate=8000, channels=1, bits=8, seconds=3):
+    byte_rate = rate * channels * bits // 8
+    fmt = struct.pack('<HHIIHH', 1, channels, rate, byte_rate, channels * bits // 8, bits)
+    info_body = b'INFO'
+    for key, value in info:
+        v = value.encode('latin-1') + b'\x00'
+        info_body += key + struct.pack('<I', len(v)) + v + (b'\x00' if len(v) & 1 else b'')
+    body = b'WAVE' + b'fmt ' + struct.pack('<I', len(fmt)) + fmt
+    body += b'LIST' + struct.pack('<I', len(info_body)) + info_body
+    data = bytes(byte_rate * seconds)
+    body += b'data' + struct.pack('<I', len(data)) + data
+    return b'RIFF' + struct.pack('<I', len(body)) + body
+
+
+FIXTURES = {
+    # v2.3: UTF-16 z BOM, Latin-1, UTF-8, numer "3/12", okładka pomijana bez czytania
+    'id3v23.mp3': lambda: id3v2(3, [
+        frame(3, 'TIT2', text(1, 'Zażółć gęślą jaźń')),
+        frame(3, 'TPE1', text(0, 'Artist Ä')),
+        frame(3, 'APIC', b'\x00image/jpeg\x00\x03\x00' + bytes(5000)),
+        frame(3, 'TALB', text(3, 'Album ✓')),
+        frame(3, 'TRCK', text(0, '3/12')),
+    ]) + mp3_audio(),
+    # v2.4: nagłówek rozszerzony, stopka, UTF-16BE, tylko wykonawca albumu (TPE2),
+    # TALB skompresowany (flaga) - pomijany
+    'id3v24_ext.mp3': lambda: id3v2(4, [
+        frame(4, 'TIT2', text(2, 'Tytuł BE')),
+        frame(4, 'TPE2', text(3, 'Album Artist')),
+        frame(4, 'TALB', text(0, 'Compressed'), flags=b'\x00\x08'),
+        frame(4, 'TRCK', text(3, '11')),
+    ], ext_header=True, footer=True) + mp3_audio(),
+    'id3v22.mp3': lambda: id3v2(2, [
+        frame(2, 'TT2', text(0, 'Old Title')),
+        frame(2, 'TP1', text(0, 'Old Artist')),
+        frame(2, 'TAL', text(0, 'Old Album')),
+        frame(2, 'TRK', text(0, '4')),
+    ]) + mp3_audio(),
+    # Tylko ID3v1.1 na końcu (pola dopełnione spacjami)
+    'id3v1.mp3': lambda: mp3_audio() + id3v1('V1 Title', 'V1 Artist', 'V1 Album', 9),
+    # ID3v2 z tytułem + ID3v1: v2 wygrywa, brakujące pola z v1
+    'id3v2_v1.mp3': lambda: id3v2(3, [frame(3, 'TIT2', text(0, 'V2 Title'))]) + mp3_audio() +
+                            id3v1('V1 Title', 'V1 Artist', '', 0),
+    # Tag zadeklarowany większy niż plik
+    'id3_truncated.mp3': lambda: (b'ID3\x03\x00\x00' + syncsafe(100000) +
+                                  frame(3, 'TIT2', text(0, 'Cut')))[:200],
+    'vorbis.flac': lambda: flac(['title=Flac Title', 'ALBUMARTIST=Flac AA', 'Album=Flac Album',
+                                 'TRACKNUMBER=7/10', 'COMMENT=' + 'x' * 600], picture=3000),
+    # ID3v2 przed FLAC (niektóre programy tak zapisują)
+    'id3_prefixed.flac': lambda: id3v2(3, [frame(3, 'TPE1', text(0, 'Id3 Artist'))]) +
+                                 flac(['TITLE=After Id3'], rate=48000, samples=48000 * 61 + 24000),
+    'itunes.m4a': lambda: m4a([
+        ilst_item(b'\xa9nam', 'M4A Title'.encode()),
+        ilst_item(b'\xa9ART', 'M4A Artist'.encode()),
+        ilst_item(b'\xa9alb', 'M4A Album'.encode()),
+        ilst_item(b'trkn', b'\x00\x00\x00\x05\x00\x0a\x00\x00', 0),
+    ], mvhd_v0(1000, 61234)),
+    # QuickTime: "meta" bez wersji/flag, mvhd w wersji 1, tylko aART
+    'quicktime.m4a': lambda: m4a([
+        ilst_item(b'\xa9nam', 'QT Title'.encode()),
+        ilst_item(b'aART', 'QT Album Artist'.encode()),
+    ], mvhd_v1(44100, 44100 * 200), iso_meta=False),
+    # LIST/INFO przed danymi, wartości o nieparzystej długości
+    'info.wav': lambda: wav([(b'INAM', 'Wav Title'), (b'IART', 'Wav Art'), (b'IPRD', 'Wav Album')]),
+    'plain.wav': lambda: wav([], rate=8000, channels=2, bits=16, seconds=2),
+    'noise.bin': lambda: bytes((i * 37 + 11) & 0x7F for i in range(3000)),
+}
+
+
+def main():
+    for name, make in FIXTURES.items():
+        with open(os.path.join(HERE, name), 'wb') as f:
+            f.write(make())
+        print(name)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,151 @@
+/*
+ * Host shim: audio_element (ESP-ADF)
+ * Bez taska i ring bufferów - wejście i wyjście to bufory testu
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio_element.h"
+
+struct audio_element {
+    audio_element_cfg_t cfg;
+    void *data;
+    audio_element_info_t info;
+    char *buf;
+    bool opened;
+
+    // Bieżące wywołanie host_audio_element_run
+    const char *in;
+    int in_len;
+    int in_pos;
+    char *out;
+    int out_size;
+    int out_pos;
+};
+
+audio_element_handle_t audio_element_init(audio_element_cfg_t *config)
+{
+    if (config == NULL || config->buffer_len <= 0) {
+        return NULL;
+    }
+    struct audio_element *el = calloc(1, sizeof(*el));
+    if (el == NULL) {
+        return NULL;
+    }
+    el->cfg = *config;
+    el->data = config->data;
+    el->buf = malloc(config->buffer_len);
+    if (el->buf == NULL) {
+        free(el);
+        return NULL;
+    }
+    return el;
+}
+
+esp_err_t audio_element_deinit(audio_element_handle_t el)
+{
+    if (el == NULL) return ESP_ERR_INVALID_ARG;
+    host_audio_element_close(el);
+    if (el->cfg.destroy) {
+        el->cfg.destroy(el);
+    }
+    free(el->buf);
+    free(el);
+    return ESP_OK;
+}
+
+void *audio_element_getdata(audio_element_handle_t el)
+{
+    return el->data;
+}
+
+esp_err_t audio_element_setdata(audio_element_handle_t el, void *data)
+{
+    el->data = data;
+    return ESP_OK;
+}
+
+esp_err_t audio_element_getinfo(audio_element_handle_t el, audio_element_info_t *info)
+{
+    *info = el->info;
+    return ESP_OK;
+}
+
+esp_err_t audio_element_setinfo(audio_element_handle_t el, audio_element_info_t *info)
+{
+    el->info = *info;
+    return ESP_OK;
+}
+
+esp_err_t audio_element_set_music_info(audio_element_handle_t el, int sample_rates,
+                                       int channels, int bits)
+{
+    el->info.sample_rates = sample_rates;
+    el->info.channels = channels;
+    el->info.bits = bits;
+    return ESP_OK;
+}
+
+char *audio_element_get_tag(audio_element_handle_t el)
+{
+    return (char *)el->cfg.tag;
+}
+
+audio_element_err_t audio_element_input(audio_element_handle_t el, char *buffer, int wanted_size)
+{
+    int left = el->in_len - el->in_pos;
+    if (left <= 0) {
+        return AEL_IO_DONE;
+    }
+    int n = wanted_size < left ? wanted_size : left;
+    memcpy(buffer, el->in + el->in_pos, n);
+    el->in_pos += n;
+    return n;
+}
+
+audio_element_err_t audio_element_output(audio_element_handle_t el, char *buffer, int write_size)
+{
+    int space = el->out_size - el->out_pos;
+    int n = write_size < space ? write_size : space;
+    if (n > 0) {
+        memcpy(el->out + el->out_pos, buffer, n);
+        el->out_pos += n;
+    }
+    return write_size;
+}
+
+int host_audio_element_run(audio_element_handle_t el, const void *in, int len,
+                           void *out, int out_size)
+{
+    if (!el->opened) {
+        if (el->cfg.open && el->cfg.open(el) != ESP_OK) {
+            return -1;
+        }
+        el->opened = true;
+    }
+
+    el->in = in;
+    el->in_len = len;
+    el->in_pos = 0;
+    el->out = out;
+    el->out_size = out_size;
+    el->out_pos = 0;
+
+    while (el->in_pos < el->in_len) {
+        int r = el->cfg.process(el, el->buf, el->cfg.buffer_len);
+        if (r <= 0) {
+            break;
+        }
+    }
+    return el->out_pos;
+}
+
+esp_err_t host_audio_element_close(audio_element_handle_t el)
+{
+    if (el->opened && el->cfg.close) {
+        el->cfg.close(el);
+    }
+    el->opened = false;
+    return ESP_OK;
+}
@@ -0,0 +1,31 @@
+/*
+ * Host shim: płytka bez kodeka
+ */
+
+#include "board.h"
+
+audio_board_handle_t audio_board_get_handle(void)
+{
+    return NULL;
+}
+
+esp_err_t audio_hal_set_volume(audio_hal_handle_t hal, int volume)
+{
+    (void)hal;
+    (void)volume;
+    return ESP_OK;
+}
+
+esp_err_t audio_hal_get_volume(audio_hal_handle_t hal, int *volume)
+{
+    (void)hal;
+    *volume = 0;
+    return ESP_OK;
+}
+
+esp_err_t audio_hal_set_mute(audio_hal_handle_t hal, bool mute)
+{
+    (void)hal;
+    (void)mute;
+    return ESP_OK;
+}
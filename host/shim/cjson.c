@@ -0,0 +1,621 @@
+/*
+ * Host shim: cJSON
+ * Parser i serializer zgodne z cJSON 1.7 w zakresie używanym przez firmware:
+ * obiekty, tablice, liczby, napisy (z \uXXXX -> UTF-8), true/false/null.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+#include <stdbool.h>
+
+#include "cJSON.h"
+
+static const char *error_ptr = NULL;
+
+static cJSON *new_item(int type)
+{
+    cJSON *item = calloc(1, sizeof(cJSON));
+    if (item) {
+        item->type = type;
+    }
+    return item;
+}
+
+void cJSON_Delete(cJSON *item)
+{
+    while (item) {
+        cJSON *next = item->next;
+        if (!(item->type & cJSON_IsReference) && item->child) {
+            cJSON_Delete(item->child);
+        }
+        if (!(item->type & cJSON_IsReference)) {
+            free(item->valuestring);
+        }
+        if (!(item->type & cJSON_StringIsConst)) {
+            free(item->string);
+        }
+        free(item);
+        item = next;
+    }
+}
+
+void cJSON_free(void *object)
+{
+    free(object);
+}
+
+// ============================================
+// Parser
+// ============================================
+
+typedef struct {
+    const char *p;
+    const char *end;
+} parse_t;
+
+static void skip_ws(parse_t *ps)
+{
+    while (ps->p < ps->end && (unsigned char)*ps->p <= ' ') {
+        ps->p++;
+    }
+}
+
+static cJSON *parse_value(parse_t *ps, int depth);
+
+static int hex4(const char *s, unsigned *out)
+{
+    unsigned v = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = s[i];
+        v <<= 4;
+        if (c >= '0' && c <= '9') v |= c - '0';
+        else if (c >= 'a' && c <= 'f') v |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') v |= c - 'A' + 10;
+        else return 0;
+    }
+    *out = v;
+    return 1;
+}
+
+static char *parse_string_raw(parse_t *ps)
+{
+    if (ps->p >= ps->end || *ps->p != '"') return NULL;
+    const char *s = ++ps->p;
+
+    // Długość wyniku nie przekracza długości źródła
+    const char *q = s;
+    while (q < ps->end && *q != '"') {
+        if (*q == '\\') q++;
+        q++;
+    }
+    if (q >= ps->end) return NULL;
+
+    char *out = malloc((size_t)(q - s) + 1);
+    if (out == NULL) return NULL;
+    char *o = out;
+
+    while (ps->p < q) {
+        char c = *ps->p++;
+        if (c != '\\') {
+            *o++ = c;
+            continue;
+        }
+        c = *ps->p++;
+        switch (c) {
+            case 'b': *o++ = '\b'; break;
+            case 'f': *o++ = '\f'; break;
+            case 'n': *o++ = '\n'; break;
+            case 'r': *o++ = '\r'; break;
+            case 't': *o++ = '\t'; break;
+            case '"': case '\\': case '/': *o++ = c; break;
+            case 'u': {
+                unsigned cp;
+                if (q - ps->p < 4 || !hex4(ps->p, &cp)) goto fail;
+                ps->p += 4;
+                if (cp >= 0xD800 && cp <= 0xDBFF) {
+                    unsigned lo;
+                    if (q - ps->p < 6 || ps->p[0] != '\\' || ps->p[1] != 'u' ||
+                        !hex4(ps->p + 2, &lo) || lo < 0xDC00 || lo > 0xDFFF) goto fail;
+                    ps->p += 6;
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                }
+                if (cp < 0x80) {
+                    *o++ = (char)cp;
+                } else if (cp < 0x800) {
+                    *o++ = (char)(0xC0 | (cp >> 6));
+                    *o++ = (char)(0x80 | (cp & 0x3F));
+                } else if (cp < 0x10000) {
+                    *o++ = (char)(0xE0 | (cp >> 12));
+                    *o++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+                    *o++ = (char)(0x80 | (cp & 0x3F));
+                } else {
+                    *o++ = (char)(0xF0 | (cp >> 18));
+                    *o++ = (char)(0x80 | ((cp >> 12) & 0x3F));
+                    *o++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+                    *o++ = (char)(0x80 | (cp & 0x3F));
+                }
+                break;
+            }
+            default:
+                goto fail;
+        }
+    }
+    *o = '\0';
+    ps->p = q + 1;
+    return out;
+
+fail:
+    free(out);
+    return NULL;
+}
+
+static cJSON *parse_number(parse_t *ps)
+{
+    char tmp[64];
+    size_t n = 0;
+    while (ps->p + n < ps->end && n < sizeof(tmp) - 1 &&
+           strchr("+-0123456789.eE", ps->p[n]) != NULL) {
+        tmp[n] = ps->p[n];
+        n++;
+    }
+    tmp[n] = '\0';
+    char *endp;
+    double d = strtod(tmp, &endp);
+    if (endp == tmp) return NULL;
+    ps->p += endp - tmp;
+
+    cJSON *item = new_item(cJSON_Number);
+    if (item == NULL) return NULL;
+    item->valuedouble = d;
+    if (d >= INT_MAX) item->valueint = INT_MAX;
+    else if (d <= (double)INT_MIN) item->valueint = INT_MIN;
+    else item->valueint = (int)d;
+    return item;
+}
+
+static cJSON *parse_container(parse_t *ps, int depth, bool object)
+{
+    cJSON *item = new_item(object ? cJSON_Object : cJSON_Array);
+    if (item == NULL) return NULL;
+    ps->p++;
+    skip_ws(ps);
+    if (ps->p < ps->end && *ps->p == (object ? '}' : ']')) {
+        ps->p++;
+        return item;
+    }
+
+    cJSON *tail = NULL;
+    while (ps->p < ps->end) {
+        char *key = NULL;
+        if (object) {
+            skip_ws(ps);
+            key = parse_string_raw(ps);
+            if (key == NULL) goto fail;
+            skip_ws(ps);
+            if (ps->p >= ps->end || *ps->p != ':') {
+                free(key);
+                goto fail;
+            }
+            ps->p++;
+        }
+        cJSON *child = parse_value(ps, depth + 1);
+        if (child == NULL) {
+            free(key);
+            goto fail;
+        }
+        child->string = key;
+        if (tail) {
+            tail->next = child;
+            child->prev = tail;
+        } else {
+            item->child = child;
+        }
+        tail = child;
+        item->child->prev = tail;
+
+        skip_ws(ps);
+        if (ps->p < ps->end && *ps->p == ',') {
+            ps->p++;
+            continue;
+        }
+        if (ps->p < ps->end && *ps->p == (object ? '}' : ']')) {
+            ps->p++;
+            return item;
+        }
+        goto fail;
+    }
+
+fail:
+    cJSON_Delete(item);
+    return NULL;
+}
+
+static cJSON *parse_value(parse_t *ps, int depth)
+{
+    if (depth > 1000) return NULL;
+    skip_ws(ps);
+    if (ps->p >= ps->end) return NULL;
+
+    size_t left = (size_t)(ps->end - ps->p);
+    if (left >= 4 && strncmp(ps->p, "null", 4) == 0) {
+        ps->p += 4;
+        return new_item(cJSON_NULL);
+    }
+    if (left >= 4 && strncmp(ps->p, "true", 4) == 0) {
+        ps->p += 4;
+        cJSON *item = new_item(cJSON_True);
+        if (item) item->valueint = 1;
+        return item;
+    }
+    if (left >= 5 && strncmp(ps->p, "false", 5) == 0) {
+        ps->p += 5;
+        return new_item(cJSON_False);
+    }
+    if (*ps->p == '"') {
+        char *s = parse_string_raw(ps);
+        if (s == NULL) return NULL;
+        cJSON *item = new_item(cJSON_String);
+        if (item == NULL) {
+            free(s);
+            return NULL;
+        }
+        item->valuestring = s;
+        return item;
+    }
+    if (*ps->p == '-' || (*ps->p >= '0' && *ps->p <= '9')) {
+        return parse_number(ps);
+    }
+    if (*ps->p == '[') return parse_container(ps, depth, false);
+    if (*ps->p == '{') return parse_container(ps, depth, true);
+    return NULL;
+}
+
+cJSON *cJSON_ParseWithLength(const char *value, size_t length)
+{
+    error_ptr = NULL;
+    if (value == NULL) return NULL;
+
+    parse_t ps = { value, value + length };
+    cJSON *item = parse_value(&ps, 0);
+    if (item == NULL) {
+        error_ptr = ps.p;
+    }
+    return item;
+}
+
+cJSON *cJSON_Parse(const char *value)
+{
+    return value ? cJSON_ParseWithLength(value, strlen(value)) : NULL;
+}
+
+const char *cJSON_GetErrorPtr(void)
+{
+    return error_ptr;
+}
+
+// ============================================
+// Serializer
+// ============================================
+
+typedef struct {
+    char *buf;
+    size_t len;
+    size_t cap;
+    bool ok;
+} print_t;
+
+static void put(print_t *pr, const char *s, size_t n)
+{
+    if (!pr->ok) return;
+    if (pr->len + n + 1 > pr->cap) {
+        size_t cap = pr->cap ? pr->cap : 256;
+        while (pr->len + n + 1 > cap) cap *= 2;
+        char *b = realloc(pr->buf, cap);
+        if (b == NULL) {
+            pr->ok = false;
+            return;
+        }
+        pr->buf = b;
+        pr->cap = cap;
+    }
+    memcpy(pr->buf + pr->len, s, n);
+    pr->len += n;
+    pr->buf[pr->len] = '\0';
+}
+
+static void puts_(print_t *pr, const char *s)
+{
+    put(pr, s, strlen(s));
+}
+
+static void print_string(print_t *pr, const char *s)
+{
+    put(pr, "\"", 1);
+    for (const unsigned char *c = (const unsigned char *)(s ? s : ""); *c; c++) {
+        char esc[8];
+        switch (*c) {
+            case '"': puts_(pr, "\\\""); break;
+            case '\\': puts_(pr, "\\\\"); break;
+            case '\b': puts_(pr, "\\b"); break;
+            case '\f': puts_(pr, "\\f"); break;
+            case '\n': puts_(pr, "\\n"); break;
+            case '\r': puts_(pr, "\\r"); break;
+            case '\t': puts_(pr, "\\t"); break;
+            default:
+                if (*c < 0x20) {
+                    snprintf(esc, sizeof(esc), "\\u%04x", *c);
+                    puts_(pr, esc);
+                } else {
+                    put(pr, (const char *)c, 1);
+                }
+        }
+    }
+    put(pr, "\"", 1);
+}
+
+static void print_number(print_t *pr, double d)
+{
+    char tmp[32];
+    if (isnan(d) || isinf(d)) {
+        snprintf(tmp, sizeof(tmp), "null");
+    } else if (d == (double)(long long)d && fabs(d) < 1e15) {
+        snprintf(tmp, sizeof(tmp), "%lld", (long long)d);
+    } else {
+        snprintf(tmp, sizeof(tmp), "%1.15g", d);
+        if (strtod(tmp, NULL) != d) {
+            snprintf(tmp, sizeof(tmp), "%1.17g", d);
+        }
+    }
+    puts_(pr, tmp);
+}
+
+static void indent(print_t *pr, int depth)
+{
+    for (int i = 0; i < depth; i++) put(pr, "\t", 1);
+}
+
+static void print_value(print_t *pr, const cJSON *item, int depth, bool fmt)
+{
+    switch (item->type & 0xFF) {
+        case cJSON_NULL: puts_(pr, "null"); break;
+        case cJSON_False: puts_(pr, "false"); break;
+        case cJSON_True: puts_(pr, "true"); break;
+        case cJSON_Number: print_number(pr, item->valuedouble); break;
+        case cJSON_String: print_string(pr, item->valuestring); break;
+        case cJSON_Raw: puts_(pr, item->valuestring ? item->valuestring : ""); break;
+        case cJSON_Array:
+        case cJSON_Object: {
+            bool object = (item->type & 0xFF) == cJSON_Object;
+            put(pr, object ? "{" : "[", 1);
+            if (fmt && object && item->child) put(pr, "\n", 1);
+            for (const cJSON *c = item->child; c; c = c->next) {
+                if (fmt && object) indent(pr, depth + 1);
+                if (object) {
+                    print_string(pr, c->string);
+                    put(pr, ":", 1);
+                    if (fmt) put(pr, "\t", 1);
+                }
+                print_value(pr, c, depth + 1, fmt);
+                if (c->next) {
+                    put(pr, ",", 1);
+                    if (fmt && !object) put(pr, " ", 1);
+                }
+                if (fmt && object) put(pr, "\n", 1);
+            }
+            if (fmt && object && item->child) indent(pr, depth);
+            put(pr, object ? "}" : "]", 1);
+            break;
+        }
+        default:
+            pr->ok = false;
+    }
+}
+
+static char *print(const cJSON *item, bool fmt)
+{
+    if (item == NULL) return NULL;
+    print_t pr = { .ok = true };
+    print_value(&pr, item, 0, fmt);
+    if (!pr.ok) {
+        free(pr.buf);
+        return NULL;
+    }
+    return pr.buf;
+}
+
+char *cJSON_Print(const cJSON *item)
+{
+    return print(item, true);
+}
+
+char *cJSON_PrintUnformatted(const cJSON *item)
+{
+    return print(item, false);
+}
+
+// ============================================
+// Dostęp
+// ============================================
+
+int cJSON_GetArraySize(const cJSON *array)
+{
+    int n = 0;
+    if (array == NULL) return 0;
+    for (const cJSON *c = array->child; c; c = c->next) n++;
+    return n;
+}
+
+cJSON *cJSON_GetArrayItem(const cJSON *array, int index)
+{
+    if (array == NULL || index < 0) return NULL;
+    cJSON *c = array->child;
+    while (c && index-- > 0) c = c->next;
+    return c;
+}
+
+static int strcasecmp_ascii(const char *a, const char *b)
+{
+    for (;; a++, b++) {
+        int ca = (*a >= 'A' && *a <= 'Z') ? *a + 32 : *a;
+        int cb = (*b >= 'A' && *b <= 'Z') ? *b + 32 : *b;
+        if (ca != cb || ca == 0) return ca - cb;
+    }
+}
+
+cJSON *cJSON_GetObjectItem(const cJSON *object, const char *string)
+{
+    if (object == NULL || string == NULL) return NULL;
+    for (cJSON *c = object->child; c; c = c->next) {
+        if (c->string && strcasecmp_ascii(c->string, string) == 0) return c;
+    }
+    return NULL;
+}
+
+cJSON *cJSON_GetObjectItemCaseSensitive(const cJSON *object, const char *string)
+{
+    if (object == NULL || string == NULL) return NULL;
+    for (cJSON *c = object->child; c; c = c->next) {
+        if (c->string && strcmp(c->string, string) == 0) return c;
+    }
+    return NULL;
+}
+
+char *cJSON_GetStringValue(const cJSON *item)
+{
+    return cJSON_IsString(item) ? item->valuestring : NULL;
+}
+
+double cJSON_GetNumberValue(const cJSON *item)
+{
+    return cJSON_IsNumber(item) ? item->valuedouble : NAN;
+}
+
+#define TYPE_IS(name, flags) \
+    cJSON_bool cJSON_Is##name(const cJSON *item) { return item && (item->type & 0xFF & (flags)); }
+
+cJSON_bool cJSON_IsInvalid(const cJSON *item) { return item && (item->type & 0xFF) == cJSON_Invalid; }
+TYPE_IS(False, cJSON_False)
+TYPE_IS(True, cJSON_True)
+TYPE_IS(Bool, cJSON_True | cJSON_False)
+TYPE_IS(Null, cJSON_NULL)
+TYPE_IS(Number, cJSON_Number)
+TYPE_IS(String, cJSON_String)
+TYPE_IS(Array, cJSON_Array)
+TYPE_IS(Object, cJSON_Object)
+
+// ============================================
+// Tworzenie
+// ============================================
+
+cJSON *cJSON_CreateNull(void) { return new_item(cJSON_NULL); }
+cJSON *cJSON_CreateTrue(void) { return cJSON_CreateBool(1); }
+cJSON *cJSON_CreateFalse(void) { return cJSON_CreateBool(0); }
+cJSON *cJSON_CreateArray(void) { return new_item(cJSON_Array); }
+cJSON *cJSON_CreateObject(void) { return new_item(cJSON_Object); }
+
+cJSON *cJSON_CreateBool(cJSON_bool boolean)
+{
+    cJSON *item = new_item(boolean ? cJSON_True : cJSON_False);
+    if (item) item->valueint = boolean ? 1 : 0;
+    return item;
+}
+
+cJSON *cJSON_CreateNumber(double num)
+{
+    cJSON *item = new_item(cJSON_Number);
+    if (item == NULL) return NULL;
+    item->valuedouble = num;
+    if (num >= INT_MAX) item->valueint = INT_MAX;
+    else if (num <= (double)INT_MIN) item->valueint = INT_MIN;
+    else item->valueint = (int)num;
+    return item;
+}
+
+cJSON *cJSON_CreateString(const char *string)
+{
+    cJSON *item = new_item(cJSON_String);
+    if (item == NULL) return NULL;
+    item->valuestring = strdup(string ? string : "");
+    if (item->valuestring == NULL) {
+        free(item);
+        return NULL;
+    }
+    return item;
+}
+
+cJSON_bool cJSON_AddItemToArray(cJSON *array, cJSON *item)
+{
+    if (array == NULL || item == NULL || array == item) return 0;
+    if (array->child == NULL) {
+        array->child = item;
+        item->prev = item;
+        item->next = NULL;
+    } else {
+        cJSON *tail = array->child->prev;
+        tail->next = item;
+        item->prev = tail;
+        array->child->prev = item;
+    }
+    return 1;
+}
+
+cJSON_bool cJSON_AddItemToObject(cJSON *object, const char *string, cJSON *item)
+{
+    if (object == NULL || string == NULL || item == NULL) return 0;
+    char *key = strdup(string);
+    if (key == NULL) return 0;
+    if (!(item->type & cJSON_StringIsConst)) free(item->string);
+    item->string = key;
+    item->type &= ~cJSON_StringIsConst;
+    return cJSON_AddItemToArray(object, item);
+}
+
+static cJSON *add_or_delete(cJSON *object, const char *name, cJSON *item)
+{
+    if (cJSON_AddItemToObject(object, name, item)) return item;
+    cJSON_Delete(item);
+    return NULL;
+}
+
+cJSON *cJSON_AddNullToObject(cJSON *object, const char *name)
+{
+    return add_or_delete(object, name, cJSON_CreateNull());
+}
+
+cJSON *cJSON_AddTrueToObject(cJSON *object, const char *name)
+{
+    return add_or_delete(object, name, cJSON_CreateTrue());
+}
+
+cJSON *cJSON_AddFalseToObject(cJSON *object, const char *name)
+{
+    return add_or_delete(object, name, cJSON_CreateFalse());
+}
+
+cJSON *cJSON_AddBoolToObject(cJSON *object, const char *name, cJSON_bool boolean)
+{
+    return add_or_delete(object, name, cJSON_CreateBool(boolean));
+}
+
+cJSON *cJSON_AddNumberToObject(cJSON *object, const char *name, double number)
+{
+    return add_or_delete(object, name, cJSON_CreateNumber(number));
+}
+
+cJSON *cJSON_AddStringToObject(cJSON *object, const char *name, const char *string)
+{
+    return add_or_delete(object, name, cJSON_CreateString(string));
+}
+
+cJSON *cJSON_AddObjectToObject(cJSON *object, const char *name)
+{
+    return add_or_delete(object, name, cJSON_CreateObject());
+}
+
+cJSON *cJSON_AddArrayToObject(cJSON *object, const char *name)
+{
+    return add_or_delete(object, name, cJSON_CreateArray());
+}
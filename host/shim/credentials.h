@@ -0,0 +1,21 @@
+/*
+ * Host shim: credentials.h
+ * Puste dane dostępowe - config.h dołącza "../credentials.h", który na hoście
+ * znajduje się tutaj (shim/include/../credentials.h)
+ */
+
+#ifndef CREDENTIALS_H
+#define CREDENTIALS_H
+
+#define WIFI_SSID               ""
+#define WIFI_PASSWORD           ""
+
+#define MQTT_SERVER_DEFAULT     ""
+#define MQTT_PORT_DEFAULT       1883
+#define MQTT_USER_DEFAULT       ""
+#define MQTT_PASSWORD_DEFAULT   ""
+
+#define SPOTIFY_CLIENT_ID       ""
+#define SPOTIFY_CLIENT_SECRET   ""
+
+#endif // CREDENTIALS_H
@@ -0,0 +1,369 @@
+/*
+ * Host shim: FreeRTOS
+ * Tick = czas monotoniczny w ms od startu + przesunięcie z host_freertos_advance_ms().
+ * Taski to wątki pthread. Timery nie mają własnego wątku: odpalają się w wątku, który
+ * woła host_freertos_advance_ms() lub host_timers_run() - testy są deterministyczne.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/timers.h"
+#include "freertos/semphr.h"
+
+static uint64_t tick_offset_ms = 0;
+static uint64_t tick_start_ms = 0;
+static pthread_mutex_t tick_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t monotonic_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    pthread_mutex_lock(&tick_lock);
+    uint64_t now = monotonic_ms();
+    if (tick_start_ms == 0) {
+        tick_start_ms = now;
+    }
+    uint64_t ticks = now - tick_start_ms + tick_offset_ms;
+    pthread_mutex_unlock(&tick_lock);
+    return (TickType_t)ticks;
+}
+
+void host_portmux_init(portMUX_TYPE *mux)
+{
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&mux->mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+// ============================================
+// Taski
+// ============================================
+
+struct host_task {
+    pthread_t thread;
+    TaskFunction_t fn;
+    void *arg;
+};
+
+static void *task_trampoline(void *p)
+{
+    struct host_task *task = p;
+    task->fn(task->arg);
+    return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth,
+                                   void *arg, UBaseType_t prio, TaskHandle_t *handle,
+                                   BaseType_t core)
+{
+    (void)name;
+    (void)stack_depth;
+    (void)prio;
+    (void)core;
+
+    struct host_task *task = calloc(1, sizeof(*task));
+    if (task == NULL) {
+        return pdFAIL;
+    }
+    task->fn = fn;
+    task->arg = arg;
+    if (pthread_create(&task->thread, NULL, task_trampoline, task) != 0) {
+        free(task);
+        return pdFAIL;
+    }
+    pthread_detach(task->thread);
+    if (handle) {
+        *handle = task;
+    }
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_depth,
+                       void *arg, UBaseType_t prio, TaskHandle_t *handle)
+{
+    return xTaskCreatePinnedToCore(fn, name, stack_depth, arg, prio, handle, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    // Uchwyt zostaje (wątek mógł go jeszcze nie zapisać) - to tylko testy
+    if (task == NULL) {
+        pthread_exit(NULL);
+    }
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    struct timespec ts = {
+        .tv_sec = ticks / 1000,
+        .tv_nsec = (long)(ticks % 1000) * 1000000L,
+    };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return NULL;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+    (void)task;
+    return 1024;
+}
+
+// ============================================
+// Timery
+// ============================================
+
+struct host_timer {
+    TimerCallbackFunction_t callback;
+    void *id;
+    TickType_t period;
+    bool auto_reload;
+    bool active;
+    TickType_t expiry;
+    struct host_timer *next;
+};
+
+static struct host_timer *timers = NULL;
+static pthread_mutex_t timer_lock = PTHREAD_MUTEX_INITIALIZER;
+
+TimerHandle_t xTimerCreate(const char *name, TickType_t period, UBaseType_t auto_reload,
+                           void *timer_id, TimerCallbackFunction_t callback)
+{
+    (void)name;
+    if (period == 0 || callback == NULL) {
+        return NULL;
+    }
+    struct host_timer *t = calloc(1, sizeof(*t));
+    if (t == NULL) {
+        return NULL;
+    }
+    t->callback = callback;
+    t->id = timer_id;
+    t->period = period;
+    t->auto_reload = auto_reload;
+
+    pthread_mutex_lock(&timer_lock);
+    t->next = timers;
+    timers = t;
+    pthread_mutex_unlock(&timer_lock);
+    return t;
+}
+
+BaseType_t xTimerStart(TimerHandle_t timer, TickType_t wait)
+{
+    (void)wait;
+    if (timer == NULL) return pdFAIL;
+    TickType_t now = xTaskGetTickCount();
+    pthread_mutex_lock(&timer_lock);
+    timer->expiry = now + timer->period;
+    timer->active = true;
+    pthread_mutex_unlock(&timer_lock);
+    return pdPASS;
+}
+
+BaseType_t xTimerReset(TimerHandle_t timer, TickType_t wait)
+{
+    return xTimerStart(timer, wait);
+}
+
+BaseType_t xTimerStop(TimerHandle_t timer, TickType_t wait)
+{
+    (void)wait;
+    if (timer == NULL) return pdFAIL;
+    pthread_mutex_lock(&timer_lock);
+    timer->active = false;
+    pthread_mutex_unlock(&timer_lock);
+    return pdPASS;
+}
+
+BaseType_t xTimerChangePeriod(TimerHandle_t timer, TickType_t period, TickType_t wait)
+{
+    if (timer == NULL || period == 0) return pdFAIL;
+    pthread_mutex_lock(&timer_lock);
+    timer->period = period;
+    pthread_mutex_unlock(&timer_lock);
+    return xTimerStart(timer, wait);
+}
+
+BaseType_t xTimerDelete(TimerHandle_t timer, TickType_t wait)
+{
+    (void)wait;
+    if (timer == NULL) return pdFAIL;
+    pthread_mutex_lock(&timer_lock);
+    for (struct host_timer **p = &timers; *p; p = &(*p)->next) {
+        if (*p == timer) {
+            *p = timer->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&timer_lock);
+    free(timer);
+    return pdPASS;
+}
+
+BaseType_t xTimerIsTimerActive(TimerHandle_t timer)
+{
+    if (timer == NULL) return pdFALSE;
+    pthread_mutex_lock(&timer_lock);
+    bool active = timer->active;
+    pthread_mutex_unlock(&timer_lock);
+    return active ? pdTRUE : pdFALSE;
+}
+
+void *pvTimerGetTimerID(TimerHandle_t timer)
+{
+    return timer ? timer->id : NULL;
+}
+
+// Jeden timer naraz, callback bez blokady - może restartować lub usuwać timery
+static struct host_timer *take_expired(TickType_t now)
+{
+    struct host_timer *found = NULL;
+    pthread_mutex_lock(&timer_lock);
+    for (struct host_timer *t = timers; t; t = t->next) {
+        if (t->active && (int32_t)(now - t->expiry) >= 0) {
+            if (found == NULL || (int32_t)(t->expiry - found->expiry) < 0) {
+                found = t;
+            }
+        }
+    }
+    if (found) {
+        if (found->auto_reload) {
+            found->expiry += found->period;
+        } else {
+            found->active = false;
+        }
+    }
+    pthread_mutex_unlock(&timer_lock);
+    return found;
+}
+
+void host_timers_run(void)
+{
+    TickType_t now = xTaskGetTickCount();
+    struct host_timer *t;
+    while ((t = take_expired(now)) != NULL) {
+        t->callback(t);
+    }
+}
+
+void host_freertos_advance_ms(uint32_t ms)
+{
+    pthread_mutex_lock(&tick_lock);
+    tick_offset_ms += ms;
+    pthread_mutex_unlock(&tick_lock);
+    host_timers_run();
+}
+
+// ============================================
+// Semafory
+// ============================================
+
+struct host_sem {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    UBaseType_t count;
+    UBaseType_t max;
+};
+
+static SemaphoreHandle_t sem_create(UBaseType_t max, UBaseType_t initial)
+{
+    struct host_sem *sem = calloc(1, sizeof(*sem));
+    if (sem == NULL) {
+        return NULL;
+    }
+    pthread_mutex_init(&sem->lock, NULL);
+    pthread_cond_init(&sem->cond, NULL);
+    sem->count = initial;
+    sem->max = max;
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return sem_create(1, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return sem_create(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial)
+{
+    return sem_create(max_count, initial);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t wait)
+{
+    if (sem == NULL) return pdFAIL;
+
+    pthread_mutex_lock(&sem->lock);
+    if (wait == portMAX_DELAY) {
+        while (sem->count == 0) {
+            pthread_cond_wait(&sem->cond, &sem->lock);
+        }
+    } else if (sem->count == 0 && wait > 0) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += wait / 1000;
+        deadline.tv_nsec += (long)(wait % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        while (sem->count == 0) {
+            if (pthread_cond_timedwait(&sem->cond, &sem->lock, &deadline) == ETIMEDOUT) {
+                break;
+            }
+        }
+    }
+
+    BaseType_t ret = pdFAIL;
+    if (sem->count > 0) {
+        sem->count--;
+        ret = pdPASS;
+    }
+    pthread_mutex_unlock(&sem->lock);
+    return ret;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    if (sem == NULL) return pdFAIL;
+
+    pthread_mutex_lock(&sem->lock);
+    BaseType_t ret = pdFAIL;
+    if (sem->count < sem->max) {
+        sem->count++;
+        pthread_cond_signal(&sem->cond);
+        ret = pdPASS;
+    }
+    pthread_mutex_unlock(&sem->lock);
+    return ret;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    if (sem == NULL) return;
+    pthread_cond_destroy(&sem->cond);
+    pthread_mutex_destroy(&sem->lock);
+    free(sem);
+}
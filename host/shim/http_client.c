@@ -0,0 +1,228 @@
+/*
+ * Host shim: esp_http_client
+ * Odpowiedzi skryptowane w teście; pierwsza pasująca (strstr po URL) obsługuje żądanie
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <pthread.h>
+
+#include "esp_http_client.h"
+
+#define HOST_HTTP_MAX_RESPONSES 16
+#define HOST_HTTP_MAX_HEADERS   8
+
+typedef struct {
+    char *match;
+    int status;
+    char *body;
+    int chunk;
+    bool chunked;
+} host_response_t;
+
+struct esp_http_client {
+    esp_http_client_config_t config;
+    char url[512];
+    char header_key[HOST_HTTP_MAX_HEADERS][32];
+    char header_value[HOST_HTTP_MAX_HEADERS][128];
+    int header_count;
+    int status;
+    int64_t content_length;
+    bool chunked;
+};
+
+static host_response_t responses[HOST_HTTP_MAX_RESPONSES];
+static int response_count = 0;
+static int request_count = 0;
+static char last_url[512];
+static char last_header_key[HOST_HTTP_MAX_HEADERS][32];
+static char last_header_value[HOST_HTTP_MAX_HEADERS][128];
+static int last_header_count = 0;
+static pthread_mutex_t http_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void host_http_add_response(const char *url_match, int status, const char *body,
+                            int chunk, bool chunked)
+{
+    pthread_mutex_lock(&http_lock);
+    if (response_count < HOST_HTTP_MAX_RESPONSES) {
+        host_response_t *r = &responses[response_count++];
+        r->match = strdup(url_match ? url_match : "");
+        r->status = status;
+        r->body = strdup(body ? body : "");
+        r->chunk = chunk;
+        r->chunked = chunked;
+    }
+    pthread_mutex_unlock(&http_lock);
+}
+
+void host_http_reset(void)
+{
+    pthread_mutex_lock(&http_lock);
+    for (int i = 0; i < response_count; i++) {
+        free(responses[i].match);
+        free(responses[i].body);
+    }
+    response_count = 0;
+    request_count = 0;
+    last_url[0] = '\0';
+    last_header_count = 0;
+    pthread_mutex_unlock(&http_lock);
+}
+
+int host_http_request_count(void)
+{
+    return request_count;
+}
+
+const char *host_http_last_url(void)
+{
+    return last_url;
+}
+
+const char *host_http_last_header(const char *key)
+{
+    for (int i = 0; i < last_header_count; i++) {
+        if (strcasecmp(last_header_key[i], key) == 0) {
+            return last_header_value[i];
+        }
+    }
+    return NULL;
+}
+
+esp_http_client_handle_t esp_http_client_init(const esp_http_client_config_t *config)
+{
+    if (config == NULL || config->url == NULL) {
+        return NULL;
+    }
+    struct esp_http_client *client = calloc(1, sizeof(*client));
+    if (client == NULL) {
+        return NULL;
+    }
+    client->config = *config;
+    strncpy(client->url, config->url, sizeof(client->url) - 1);
+    client->content_length = -1;
+    return client;
+}
+
+esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client)
+{
+    free(client);
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_url(esp_http_client_handle_t client, const char *url)
+{
+    if (client == NULL || url == NULL) return ESP_ERR_INVALID_ARG;
+    strncpy(client->url, url, sizeof(client->url) - 1);
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_method(esp_http_client_handle_t client, esp_http_client_method_t method)
+{
+    if (client == NULL) return ESP_ERR_INVALID_ARG;
+    client->config.method = method;
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_header(esp_http_client_handle_t client, const char *key, const char *value)
+{
+    if (client == NULL || key == NULL || value == NULL) return ESP_ERR_INVALID_ARG;
+    if (client->header_count >= HOST_HTTP_MAX_HEADERS) return ESP_ERR_NO_MEM;
+    strncpy(client->header_key[client->header_count], key, 31);
+    strncpy(client->header_value[client->header_count], value, 127);
+    client->header_count++;
+    return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_post_field(esp_http_client_handle_t client, const char *data, int len)
+{
+    (void)data;
+    (void)len;
+    return client ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t esp_http_client_set_timeout_ms(esp_http_client_handle_t client, int timeout_ms)
+{
+    if (client == NULL) return ESP_ERR_INVALID_ARG;
+    client->config.timeout_ms = timeout_ms;
+    return ESP_OK;
+}
+
+int esp_http_client_get_status_code(esp_http_client_handle_t client)
+{
+    return client ? client->status : -1;
+}
+
+int64_t esp_http_client_get_content_length(esp_http_client_handle_t client)
+{
+    return client ? client->content_length : -1;
+}
+
+bool esp_http_client_is_chunked_response(esp_http_client_handle_t client)
+{
+    return client ? client->chunked : false;
+}
+
+static esp_err_t dispatch(esp_http_client_handle_t client, esp_http_client_event_id_t id,
+                          void *data, int len)
+{
+    if (client->config.event_handler == NULL) {
+        return ESP_OK;
+    }
+    esp_http_client_event_t evt = {
+        .event_id = id,
+        .client = client,
+        .data = data,
+        .data_len = len,
+        .user_data = client->config.user_data,
+    };
+    return client->config.event_handler(&evt);
+}
+
+esp_err_t esp_http_client_perform(esp_http_client_handle_t client)
+{
+    if (client == NULL) return ESP_ERR_INVALID_ARG;
+
+    pthread_mutex_lock(&http_lock);
+    request_count++;
+    snprintf(last_url, sizeof(last_url), "%s", client->url);
+    last_header_count = client->header_count;
+    memcpy(last_header_key, client->header_key, sizeof(last_header_key));
+    memcpy(last_header_value, client->header_value, sizeof(last_header_value));
+
+    host_response_t r = {0};
+    bool found = false;
+    for (int i = 0; i < response_count; i++) {
+        if (strstr(client->url, responses[i].match)) {
+            r = responses[i];
+            r.body = strdup(responses[i].body);
+            found = true;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&http_lock);
+
+    if (!found || r.status == 0) {
+        free(r.body);
+        dispatch(client, HTTP_EVENT_ERROR, NULL, 0);
+        return ESP_ERR_HTTP_CONNECT;
+    }
+
+    dispatch(client, HTTP_EVENT_ON_CONNECTED, NULL, 0);
+    client->status = r.status;
+    client->chunked = r.chunked;
+    int len = (int)strlen(r.body);
+    client->content_length = r.chunked ? -1 : len;
+
+    int chunk = r.chunk > 0 ? r.chunk : len;
+    for (int pos = 0; pos < len; pos += chunk) {
+        int n = len - pos < chunk ? len - pos : chunk;
+        dispatch(client, HTTP_EVENT_ON_DATA, r.body + pos, n);
+    }
+    dispatch(client, HTTP_EVENT_ON_FINISH, NULL, 0);
+    dispatch(client, HTTP_EVENT_DISCONNECTED, NULL, 0);
+
+    free(r.body);
+    return ESP_OK;
+}
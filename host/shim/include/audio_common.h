@@ -0,0 +1,24 @@
+/*
+ * Host shim: audio_common.h (ESP-ADF) - te same wartości typów kodeków
+ */
+
+#ifndef HOST_AUDIO_COMMON_H
+#define HOST_AUDIO_COMMON_H
+
+typedef enum {
+    ESP_CODEC_TYPE_UNKNOW = 0,
+    ESP_CODEC_TYPE_RAW,
+    ESP_CODEC_TYPE_WAV,
+    ESP_CODEC_TYPE_MP3,
+    ESP_CODEC_TYPE_AAC,
+    ESP_CODEC_TYPE_OPUS,
+    ESP_CODEC_TYPE_M4A,
+    ESP_CODEC_TYPE_TSAAC,
+    ESP_CODEC_TYPE_OGG,
+    ESP_CODEC_TYPE_AMRNB,
+    ESP_CODEC_TYPE_AMRWB,
+    ESP_CODEC_TYPE_PCM,
+    ESP_CODEC_TYPE_FLAC,
+} esp_codec_type_t;
+
+#endif // HOST_AUDIO_COMMON_H
@@ -0,0 +1,104 @@
+/*
+ * Host shim: audio_element.h (ESP-ADF)
+ * Element bez własnego taska i ring bufferów. host_audio_element_run() wywołuje
+ * callback process na podanym wejściu i zbiera wyjście - tyle, ile trzeba do
+ * sprawdzania elementów przetwarzających PCM (eq_filter).
+ */
+
+#ifndef HOST_AUDIO_ELEMENT_H
+#define HOST_AUDIO_ELEMENT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "audio_common.h"
+
+typedef struct audio_element *audio_element_handle_t;
+
+typedef enum {
+    AEL_IO_OK = 0,
+    AEL_IO_FAIL = -1,
+    AEL_IO_DONE = -2,
+    AEL_IO_ABORT = -3,
+    AEL_IO_TIMEOUT = -4,
+    AEL_PROCESS_FAIL = -5,
+} audio_element_err_t;
+
+typedef struct {
+    int sample_rates;
+    int channels;
+    int bits;
+    int bps;
+    int64_t byte_pos;
+    int64_t total_bytes;
+    int duration;
+    char *uri;
+    esp_codec_type_t codec_fmt;
+} audio_element_info_t;
+
+typedef esp_err_t (*el_io_func)(audio_element_handle_t self);
+typedef int (*process_func)(audio_element_handle_t self, char *el_buffer, int el_buf_len);
+typedef int (*stream_func)(audio_element_handle_t self, char *buffer, int len,
+                           int ticks_to_wait, void *context);
+
+typedef struct {
+    el_io_func open;
+    el_io_func seek;
+    process_func process;
+    el_io_func close;
+    el_io_func destroy;
+    stream_func read;
+    stream_func write;
+    int buffer_len;
+    int task_stack;
+    int task_prio;
+    int task_core;
+    int out_rb_size;
+    void *data;
+    const char *tag;
+    bool stack_in_ext;
+    int multi_in_rb_num;
+    int multi_out_rb_num;
+} audio_element_cfg_t;
+
+#define DEFAULT_ELEMENT_BUFFER_LENGTH   (1024)
+#define DEFAULT_ELEMENT_RINGBUF_SIZE    (8 * 1024)
+#define DEFAULT_ELEMENT_STACK_SIZE      (2 * 1024)
+#define DEFAULT_ELEMENT_TASK_PRIO       (5)
+#define DEFAULT_ELEMENT_TASK_CORE       (0)
+
+#define DEFAULT_AUDIO_ELEMENT_CONFIG() {                \
+    .buffer_len         = DEFAULT_ELEMENT_BUFFER_LENGTH,\
+    .task_stack         = DEFAULT_ELEMENT_STACK_SIZE,   \
+    .task_prio          = DEFAULT_ELEMENT_TASK_PRIO,    \
+    .task_core          = DEFAULT_ELEMENT_TASK_CORE,    \
+    .out_rb_size        = DEFAULT_ELEMENT_RINGBUF_SIZE, \
+    .multi_in_rb_num    = 0,                            \
+    .multi_out_rb_num   = 0,                            \
+}
+
+audio_element_handle_t audio_element_init(audio_element_cfg_t *config);
+esp_err_t audio_element_deinit(audio_element_handle_t el);
+void *audio_element_getdata(audio_element_handle_t el);
+esp_err_t audio_element_setdata(audio_element_handle_t el, void *data);
+esp_err_t audio_element_getinfo(audio_element_handle_t el, audio_element_info_t *info);
+esp_err_t audio_element_setinfo(audio_element_handle_t el, audio_element_info_t *info);
+esp_err_t audio_element_set_music_info(audio_element_handle_t el, int sample_rates,
+                                       int channels, int bits);
+char *audio_element_get_tag(audio_element_handle_t el);
+audio_element_err_t audio_element_input(audio_element_handle_t el, char *buffer, int wanted_size);
+audio_element_err_t audio_element_output(audio_element_handle_t el, char *buffer, int write_size);
+
+// ============================================
+// Tylko host
+// ============================================
+
+// Otwiera element przy pierwszym wywołaniu, przepuszcza len bajtów z in przez process
+// (w blokach buffer_len) i zapisuje wynik do out. Zwraca liczbę bajtów wyjścia.
+int host_audio_element_run(audio_element_handle_t el, const void *in, int len,
+                           void *out, int out_size);
+
+// Wywołuje close (jeśli otwarty) - następny run zaczyna od open
+esp_err_t host_audio_element_close(audio_element_handle_t el);
+
+#endif // HOST_AUDIO_ELEMENT_H
@@ -0,0 +1,17 @@
+/*
+ * Host shim: audio_hal.h (ESP-ADF) - bez kodeka
+ */
+
+#ifndef HOST_AUDIO_HAL_H
+#define HOST_AUDIO_HAL_H
+
+#include <stdbool.h>
+#include "esp_err.h"
+
+typedef struct audio_hal *audio_hal_handle_t;
+
+esp_err_t audio_hal_set_volume(audio_hal_handle_t hal, int volume);
+esp_err_t audio_hal_get_volume(audio_hal_handle_t hal, int *volume);
+esp_err_t audio_hal_set_mute(audio_hal_handle_t hal, bool mute);
+
+#endif // HOST_AUDIO_HAL_H
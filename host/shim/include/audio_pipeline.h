@@ -0,0 +1,12 @@
+/*
+ * Host shim: audio_pipeline.h (ESP-ADF) - tylko typ uchwytu dla nagłówków odtwarzacza
+ */
+
+#ifndef HOST_AUDIO_PIPELINE_H
+#define HOST_AUDIO_PIPELINE_H
+
+#include "audio_element.h"
+
+typedef struct audio_pipeline *audio_pipeline_handle_t;
+
+#endif // HOST_AUDIO_PIPELINE_H
@@ -0,0 +1,17 @@
+/*
+ * Host shim: board.h (ESP-ADF) - płytka bez kodeka, audio_board_get_handle() zwraca NULL
+ */
+
+#ifndef HOST_BOARD_H
+#define HOST_BOARD_H
+
+#include <stdbool.h>
+#include "audio_hal.h"
+
+typedef struct audio_board_handle {
+    audio_hal_handle_t audio_hal;
+} *audio_board_handle_t;
+
+audio_board_handle_t audio_board_get_handle(void);
+
+#endif // HOST_BOARD_H
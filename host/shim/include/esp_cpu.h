@@ -0,0 +1,28 @@
+/*
+ * Host shim: esp_cpu.h
+ * Licznik cykli: TSC na x86, w pozostałych przypadkach nanosekundy zegara monotonicznego.
+ * Wartości dotyczą procesora hosta - do porównań względnych, nie do budżetu Xtensa.
+ */
+
+#ifndef HOST_ESP_CPU_H
+#define HOST_ESP_CPU_H
+
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+static inline uint32_t esp_cpu_get_cycle_count(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return (uint32_t)__rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+#endif
+}
+
+#endif // HOST_ESP_CPU_H
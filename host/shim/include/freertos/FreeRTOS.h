@@ -0,0 +1,65 @@
+/*
+ * Host shim: FreeRTOS.h
+ * Tick 1 ms. Sekcje krytyczne to rekurencyjne muteksy pthread - naprawdę wykluczają
+ * się między wątkami, więc kod z portMUX_TYPE można sprawdzać testami wielowątkowymi.
+ */
+
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+
+#include "sdkconfig.h"
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef void (*TaskFunction_t)(void *);
+
+#define pdFALSE                 ((BaseType_t)0)
+#define pdTRUE                  ((BaseType_t)1)
+#define pdFAIL                  pdFALSE
+#define pdPASS                  pdTRUE
+#define portMAX_DELAY           ((TickType_t)0xffffffffUL)
+#define configTICK_RATE_HZ      1000
+#define portTICK_PERIOD_MS      ((TickType_t)1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)       ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000))
+#define pdTICKS_TO_MS(t)        ((uint32_t)(((uint64_t)(t) * 1000) / configTICK_RATE_HZ))
+#define tskNO_AFFINITY          0x7FFFFFFF
+
+typedef struct {
+    pthread_mutex_t mutex;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED    { PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP }
+
+void host_portmux_init(portMUX_TYPE *mux);
+
+#define portMUX_INITIALIZE(mux)         host_portmux_init(mux)
+#define spinlock_initialize(mux)        host_portmux_init(mux)
+#define portENTER_CRITICAL(mux)         pthread_mutex_lock(&(mux)->mutex)
+#define portEXIT_CRITICAL(mux)          pthread_mutex_unlock(&(mux)->mutex)
+#define portENTER_CRITICAL_ISR(mux)     portENTER_CRITICAL(mux)
+#define portEXIT_CRITICAL_ISR(mux)      portEXIT_CRITICAL(mux)
+#define portENTER_CRITICAL_SAFE(mux)    portENTER_CRITICAL(mux)
+#define portEXIT_CRITICAL_SAFE(mux)     portEXIT_CRITICAL(mux)
+#define taskENTER_CRITICAL(mux)         portENTER_CRITICAL(mux)
+#define taskEXIT_CRITICAL(mux)          portEXIT_CRITICAL(mux)
+
+#define portYIELD_FROM_ISR()            do { } while (0)
+#define xPortGetCoreID()                0
+
+// ============================================
+// Sterowanie czasem w testach
+// ============================================
+
+// Przesuwa zegar tików o ms (bez czekania) i odpala timery, których czas minął
+void host_freertos_advance_ms(uint32_t ms);
+
+// Odpala timery, których czas minął (w wątku wywołującym)
+void host_timers_run(void);
+
+#endif // HOST_FREERTOS_H
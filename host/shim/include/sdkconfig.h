@@ -0,0 +1,13 @@
+/*
+ * Host shim: sdkconfig.h
+ * Tylko opcje, których używają moduły budowane na hoście
+ */
+
+#ifndef HOST_SDKCONFIG_H
+#define HOST_SDKCONFIG_H
+
+#define CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ     240
+#define CONFIG_FREERTOS_HZ                  1000
+#define CONFIG_SPIRAM                       1
+
+#endif // HOST_SDKCONFIG_H
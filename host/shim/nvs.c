@@ -0,0 +1,291 @@
+/*
+ * Host shim: NVS w pamięci
+ * Lista wpisów (przestrzeń, klucz, typ, dane). Odczyt innym typem niż zapis zwraca
+ * ESP_ERR_NVS_NOT_FOUND - jak w ESP-IDF, gdzie typ jest częścią klucza.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "nvs.h"
+#include "nvs_flash.h"
+
+#define NVS_MAX_NAMESPACES  32
+#define NVS_NS_NAME_MAX     16
+
+typedef enum {
+    NVS_TYPE_U8, NVS_TYPE_I8, NVS_TYPE_U16, NVS_TYPE_I16,
+    NVS_TYPE_U32, NVS_TYPE_I32, NVS_TYPE_U64, NVS_TYPE_I64,
+    NVS_TYPE_STR, NVS_TYPE_BLOB,
+} nvs_type_t;
+
+typedef struct nvs_entry {
+    int ns;
+    char key[NVS_KEY_NAME_MAX_SIZE];
+    nvs_type_t type;
+    void *data;
+    size_t len;
+    struct nvs_entry *next;
+} nvs_entry_t;
+
+static char namespaces[NVS_MAX_NAMESPACES][NVS_NS_NAME_MAX];
+static int ns_count = 0;
+static nvs_entry_t *entries = NULL;
+static int commits = 0;
+static pthread_mutex_t nvs_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Uchwyt = indeks przestrzeni + 1 (0 jest nieprawidłowy), bit 31 - tylko do odczytu
+#define HANDLE_RO   0x80000000u
+
+static int handle_ns(nvs_handle_t handle)
+{
+    int ns = (int)(handle & ~HANDLE_RO) - 1;
+    return (ns >= 0 && ns < ns_count) ? ns : -1;
+}
+
+esp_err_t nvs_flash_init(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void)
+{
+    host_nvs_reset();
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_deinit(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle)
+{
+    if (name == NULL || out_handle == NULL || strlen(name) >= NVS_NS_NAME_MAX) {
+        return ESP_ERR_NVS_INVALID_NAME;
+    }
+
+    pthread_mutex_lock(&nvs_lock);
+    int ns = -1;
+    for (int i = 0; i < ns_count; i++) {
+        if (strcmp(namespaces[i], name) == 0) {
+            ns = i;
+            break;
+        }
+    }
+    if (ns < 0) {
+        if (open_mode == NVS_READONLY) {
+            pthread_mutex_unlock(&nvs_lock);
+            return ESP_ERR_NVS_NOT_FOUND;
+        }
+        if (ns_count >= NVS_MAX_NAMESPACES) {
+            pthread_mutex_unlock(&nvs_lock);
+            return ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+        }
+        ns = ns_count++;
+        strcpy(namespaces[ns], name);
+    }
+    pthread_mutex_unlock(&nvs_lock);
+
+    *out_handle = (nvs_handle_t)(ns + 1) | (open_mode == NVS_READONLY ? HANDLE_RO : 0);
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle)
+{
+    (void)handle;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    if (handle_ns(handle) < 0) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    pthread_mutex_lock(&nvs_lock);
+    commits++;
+    pthread_mutex_unlock(&nvs_lock);
+    return ESP_OK;
+}
+
+static nvs_entry_t **find(int ns, const char *key)
+{
+    for (nvs_entry_t **p = &entries; *p; p = &(*p)->next) {
+        if ((*p)->ns == ns && strcmp((*p)->key, key) == 0) {
+            return p;
+        }
+    }
+    return NULL;
+}
+
+static esp_err_t set_value(nvs_handle_t handle, const char *key, nvs_type_t type,
+                           const void *data, size_t len)
+{
+    int ns = handle_ns(handle);
+    if (ns < 0) return ESP_ERR_NVS_INVALID_HANDLE;
+    if (handle & HANDLE_RO) return ESP_ERR_NVS_READ_ONLY;
+    if (key == NULL || strlen(key) >= NVS_KEY_NAME_MAX_SIZE) return ESP_ERR_NVS_KEY_TOO_LONG;
+
+    void *copy = malloc(len ? len : 1);
+    if (copy == NULL) return ESP_ERR_NO_MEM;
+    memcpy(copy, data, len);
+
+    pthread_mutex_lock(&nvs_lock);
+    nvs_entry_t **p = find(ns, key);
+    nvs_entry_t *e;
+    if (p) {
+        e = *p;
+        free(e->data);
+    } else {
+        e = calloc(1, sizeof(*e));
+        if (e == NULL) {
+            pthread_mutex_unlock(&nvs_lock);
+            free(copy);
+            return ESP_ERR_NO_MEM;
+        }
+        e->ns = ns;
+        strcpy(e->key, key);
+        e->next = entries;
+        entries = e;
+    }
+    e->type = type;
+    e->data = copy;
+    e->len = len;
+    pthread_mutex_unlock(&nvs_lock);
+    return ESP_OK;
+}
+
+// Stała długość (liczby) - out_len NULL; zmienna (str/blob) - semantyka ESP-IDF
+static esp_err_t get_value(nvs_handle_t handle, const char *key, nvs_type_t type,
+                           void *out, size_t fixed_len, size_t *out_len)
+{
+    int ns = handle_ns(handle);
+    if (ns < 0) return ESP_ERR_NVS_INVALID_HANDLE;
+    if (key == NULL) return ESP_ERR_NVS_NOT_FOUND;
+
+    esp_err_t ret = ESP_OK;
+    pthread_mutex_lock(&nvs_lock);
+    nvs_entry_t **p = find(ns, key);
+    if (p == NULL || (*p)->type != type) {
+        ret = ESP_ERR_NVS_NOT_FOUND;
+    } else if (out_len == NULL) {
+        memcpy(out, (*p)->data, fixed_len);
+    } else if (out == NULL) {
+        *out_len = (*p)->len;
+    } else if (*out_len < (*p)->len) {
+        ret = ESP_ERR_NVS_INVALID_LENGTH;
+    } else {
+        memcpy(out, (*p)->data, (*p)->len);
+        *out_len = (*p)->len;
+    }
+    pthread_mutex_unlock(&nvs_lock);
+    return ret;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key)
+{
+    int ns = handle_ns(handle);
+    if (ns < 0) return ESP_ERR_NVS_INVALID_HANDLE;
+    if (handle & HANDLE_RO) return ESP_ERR_NVS_READ_ONLY;
+
+    pthread_mutex_lock(&nvs_lock);
+    nvs_entry_t **p = find(ns, key);
+    if (p == NULL) {
+        pthread_mutex_unlock(&nvs_lock);
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    nvs_entry_t *e = *p;
+    *p = e->next;
+    pthread_mutex_unlock(&nvs_lock);
+    free(e->data);
+    free(e);
+    return ESP_OK;
+}
+
+esp_err_t nvs_erase_all(nvs_handle_t handle)
+{
+    int ns = handle_ns(handle);
+    if (ns < 0) return ESP_ERR_NVS_INVALID_HANDLE;
+    if (handle & HANDLE_RO) return ESP_ERR_NVS_READ_ONLY;
+
+    pthread_mutex_lock(&nvs_lock);
+    nvs_entry_t **p = &entries;
+    while (*p) {
+        nvs_entry_t *e = *p;
+        if (e->ns == ns) {
+            *p = e->next;
+            free(e->data);
+            free(e);
+        } else {
+            p = &e->next;
+        }
+    }
+    pthread_mutex_unlock(&nvs_lock);
+    return ESP_OK;
+}
+
+void host_nvs_reset(void)
+{
+    pthread_mutex_lock(&nvs_lock);
+    while (entries) {
+        nvs_entry_t *e = entries;
+        entries = e->next;
+        free(e->data);
+        free(e);
+    }
+    ns_count = 0;
+    commits = 0;
+    pthread_mutex_unlock(&nvs_lock);
+}
+
+int host_nvs_commit_count(void)
+{
+    pthread_mutex_lock(&nvs_lock);
+    int n = commits;
+    pthread_mutex_unlock(&nvs_lock);
+    return n;
+}
+
+#define NVS_SCALAR(suffix, ctype, tag)                                                  \
+    esp_err_t nvs_set_##suffix(nvs_handle_t handle, const char *key, ctype value)        \
+    {                                                                                   \
+        return set_value(handle, key, tag, &value, sizeof(value));                      \
+    }                                                                                   \
+    esp_err_t nvs_get_##suffix(nvs_handle_t handle, const char *key, ctype *out_value)   \
+    {                                                                                   \
+        return get_value(handle, key, tag, out_value, sizeof(*out_value), NULL);        \
+    }
+
+NVS_SCALAR(u8, uint8_t, NVS_TYPE_U8)
+NVS_SCALAR(i8, int8_t, NVS_TYPE_I8)
+NVS_SCALAR(u16, uint16_t, NVS_TYPE_U16)
+NVS_SCALAR(i16, int16_t, NVS_TYPE_I16)
+NVS_SCALAR(u32, uint32_t, NVS_TYPE_U32)
+NVS_SCALAR(i32, int32_t, NVS_TYPE_I32)
+NVS_SCALAR(u64, uint64_t, NVS_TYPE_U64)
+NVS_SCALAR(i64, int64_t, NVS_TYPE_I64)
+
+esp_err_t nvs_set_str(nvs_handle_t handle, const char *key, const char *value)
+{
+    if (strlen(value) + 1 > NVS_STR_MAX_SIZE) {
+        return ESP_ERR_NVS_VALUE_TOO_LONG;
+    }
+    return set_value(handle, key, NVS_TYPE_STR, value, strlen(value) + 1);
+}
+
+esp_err_t nvs_get_str(nvs_handle_t handle, const char *key, char *out_value, size_t *length)
+{
+    if (length == NULL) return ESP_ERR_INVALID_ARG;
+    return get_value(handle, key, NVS_TYPE_STR, out_value, 0, length);
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length)
+{
+    return set_value(handle, key, NVS_TYPE_BLOB, value, length);
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length)
+{
+    if (length == NULL) return ESP_ERR_INVALID_ARG;
+    return get_value(handle, key, NVS_TYPE_BLOB, out_value, 0, length);
+}
@@ -0,0 +1,313 @@
+#!/usr/bin/env python3
+"""
+Lokalny serwer radia HTTP/ICY do testów wytrzymałościowych odtwarzacza.
+
+Nadaje strumień w tempie bitrate (po początkowym "burst" jak Icecast) i wstrzykuje
+usterki łącza: limit przepustowości, opóźnienia (jitter), przestoje, zerwania
+połączenia, okresy niedostępności serwera i uszkodzone ramki.
+
+Źródło: plik MP3/AAC (ADTS) odtwarzany w pętli albo syntetyczne ramki z poprawnymi
+nagłówkami i cichą treścią (--codec). Klient z nagłówkiem "Icy-MetaData: 1" dostaje
+bloki StreamTitle co --metaint bajtów audio.
+
+Pierwsza linia na stdout: "PORT <n>". Zdarzenia (connect, stall, disconnect, bad_frame)
+jako linie JSON w --events.
+"""
+
+import argparse
+import json
+import random
+import socket
+import socketserver
+import sys
+import threading
+import time
+
+MP3_BITRATES = [0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320]
+ADTS_RATES = [96000, 88200, 64000, 48000, 44100, 32000, 24000, 22050, 16000, 12000, 11025, 8000, 7350]
+
+TICK_S = 0.02
+
+
+# ============================================
+# Źródła ramek
+# ============================================
+
+def synthetic_mp3(bitrate_kbps, sample_rate=44100):
+    """MPEG-1 Layer III, stereo, cisza. Wypełnienie (padding) jak w prawdziwym koderze."""
+    br_idx = MP3_BITRATES.index(bitrate_kbps)
+    sr_idx = {44100: 0, 48000: 1, 32000: 2}[sample_rate]
+    exact = 144 * bitrate_kbps * 1000 / sample_rate
+    acc = 0.0
+    while True:
+        acc += exact - int(exact)
+        padding = 1 if acc >= 1.0 else 0
+        acc -= padding
+        length = int(exact) + padding
+        header = bytes([0xFF, 0xFB, (br_idx << 4) | (sr_idx << 2) | (padding << 1), 0x00])
+        yield header + bytes(length - 4)
+
+
+def synthetic_adts(bitrate_kbps, sample_rate=44100, channels=2):
+    """AAC-LC w ADTS, 1024 próbki na ramkę."""
+    sr_idx = ADTS_RATES.index(sample_rate)
+    exact = bitrate_kbps * 1000 / 8 * 1024 / sample_rate
+    acc = 0.0
+    while True:
+        acc += exact
+        length = int(acc)
+        acc -= length
+        header = bytes([
+            0xFF, 0xF1,
+            (1 << 6) | (sr_idx << 2) | (channels >> 2),
+            ((channels & 3) << 6) | (length >> 11),
+            (length >> 3) & 0xFF,
+            ((length & 7) << 5) | 0x1F,
+            0xFC,
+        ])
+        yield header + bytes(length - 7)
+
+
+def file_frames(path, chunk=1024):
+    """Plik w pętli, porcjami - bez dzielenia na ramki (uszkodzenia trafiają w losowe miejsca)."""
+    with open(path, 'rb') as f:
+        data = f.read()
+    if not data:
+        raise SystemExit('empty file: %s' % path)
+    while True:
+        for pos in range(0, len(data), chunk):
+            yield data[pos:pos + chunk]
+
+
+# ============================================
+# Serwer
+# ============================================
+
+class Faults:
+    def __init__(self, args):
+        self.args = args
+        self.lock = threading.Lock()
+        self.events = open(args.events, 'a') if args.events else None
+        self.down_until = 0.0
+        self.start = time.monotonic()
+
+    def log(self, event, **fields):
+        fields['t'] = round(time.monotonic() - self.start, 3)
+        fields['event'] = event
+        line = json.dumps(fields)
+        with self.lock:
+            if self.events:
+                self.events.write(line + '\n')
+                self.events.flush()
+        if self.args.verbose:
+            print(line, file=sys.stderr, flush=True)
+
+    def next_interval(self, mean_s):
+        """Odstęp do następnego zdarzenia (rozkład wykładniczy); None - wyłączone."""
+        return random.expovariate(1.0 / mean_s) if mean_s > 0 else None
+
+
+class Handler(socketserver.BaseRequestHandler):
+    def setup(self):
+        self.request.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+
+    def read_request(self):
+        data = b''
+        while b'\r\n\r\n' not in data:
+            part = self.request.recv(2048)
+            if not part:
+                return None
+            data += part
+            if len(data) > 16384:
+                return None
+        lines = data.split(b'\r\n\r\n', 1)[0].decode('latin-1').split('\r\n')
+        headers = {}
+        for line in lines[1:]:
+            if ':' in line:
+                key, value = line.split(':', 1)
+                headers[key.strip().lower()] = value.strip()
+        return lines[0], headers
+
+    def handle(self):
+        args, faults = self.server.args, self.server.faults
+        request = self.read_request()
+        if request is None:
+            return
+
+        now = time.monotonic()
+        if now < faults.down_until:
+            faults.log('refused', remaining_ms=int((faults.down_until - now) * 1000))
+            self.request.sendall(b'HTTP/1.0 503 Service Unavailable\r\nContent-Length: 0\r\n\r\n')
+            return
+
+        _, headers = request
+        metaint = args.metaint if headers.get('icy-metadata') == '1' else 0
+        content_type = 'audio/aac' if args.codec == 'aac' else 'audio/mpeg'
+        response = [
+            'HTTP/1.0 200 OK',
+            'Content-Type: %s' % content_type,
+            'icy-name: Soak Test Radio',
+            'icy-br: %d' % args.bitrate,
+            'Cache-Control: no-cache',
+        ]
+        if metaint:
+            response.append('icy-metaint: %d' % metaint)
+        self.request.sendall(('\r\n'.join(response) + '\r\n\r\n').encode('latin-1'))
+        faults.log('connect', metaint=metaint)
+
+        try:
+            self.stream(metaint)
+        except (BrokenPipeError, ConnectionResetError):
+            faults.log('client_closed')
+
+    def stream(self, metaint):
+        args, faults = self.server.args, self.server.faults
+        if args.file:
+            frames = file_frames(args.file)
+        elif args.codec == 'aac':
+            frames = synthetic_adts(args.bitrate)
+        else:
+            frames = synthetic_mp3(args.bitrate)
+
+        byte_rate = args.bitrate * 1000 / 8
+        cap = args.bandwidth_kbps * 1000 / 8 if args.bandwidth_kbps > 0 else None
+        start = time.monotonic()
+        sent_audio = 0
+        due = args.burst_kb * 1024                  # Bajty audio, które powinny już wyjść
+        bucket = cap * TICK_S if cap else 0        # Limit przepustowości (token bucket)
+        pending = b''
+        meta_left = metaint
+        title_no = 0
+        title_sent = -1
+        title_at = start
+
+        stall_in = faults.next_interval(args.stall_every)
+        disconnect_in = faults.next_interval(args.disconnect_every)
+        bad_in = faults.next_interval(60.0 / args.bad_frames_per_min if args.bad_frames_per_min > 0 else 0)
+        last = start
+
+        while True:
+            time.sleep(TICK_S + (random.uniform(0, args.jitter_ms) / 1000.0 if args.jitter_ms else 0))
+            now = time.monotonic()
+            dt = now - last
+            last = now
+            due += byte_rate * dt
+            if cap:
+                # Kubełek na co najwyżej 100 ms - po przestoju łącze nie nadrabia ponad limit
+                bucket = min(bucket + cap * dt, cap * 0.1)
+
+            if disconnect_in is not None:
+                disconnect_in -= dt
+                if disconnect_in <= 0:
+                    faults.log('disconnect', down_ms=args.down_ms)
+                    if args.down_ms:
+                        faults.down_until = now + args.down_ms / 1000.0
+                    self.request.shutdown(socket.SHUT_RDWR)
+                    return
+
+            if stall_in is not None:
+                stall_in -= dt
+                if stall_in <= 0:
+                    stall_s = args.stall_ms / 1000.0
+                    faults.log('stall', ms=args.stall_ms)
+                    time.sleep(stall_s)
+                    stall_in = faults.next_interval(args.stall_every)
+                    # Serwer na żywo po przestoju: opuszczone audio przepada albo jest nadrabiane
+                    if not args.stall_catchup:
+                        due = sent_audio
+                    last = time.monotonic()
+                    continue
+
+            out = bytearray()
+            while sent_audio < due and (cap is None or len(out) < bucket):
+                if not pending:
+                    pending = next(frames)
+                    if bad_in is not None:
+                        bad_in -= len(pending) / byte_rate
+                        if bad_in <= 0:
+                            pending = self.corrupt(pending)
+                            bad_in = faults.next_interval(60.0 / args.bad_frames_per_min)
+                take = len(pending)
+                if metaint:
+                    take = min(take, meta_left)
+                out += pending[:take]
+                pending = pending[take:]
+                sent_audio += take
+                if metaint:
+                    meta_left -= take
+                    if meta_left == 0:
+                        if now - title_at >= args.title_every:
+                            title_no += 1
+                            title_at = now
+                        # Jak Icecast: tytuł w pierwszym bloku i po zmianie, poza tym pusty blok
+                        out += self.meta_block(title_no if title_no != title_sent else None)
+                        title_sent = title_no
+                        meta_left = metaint
+            if out:
+                if cap:
+                    bucket -= len(out)
+                self.request.sendall(bytes(out))
+
+    def corrupt(self, frame):
+        faults = self.server.faults
+        kind = random.choice(['garbage', 'truncated', 'header'])
+        faults.log('bad_frame', kind=kind, len=len(frame))
+        if kind == 'garbage':
+            return bytes(random.randrange(0, 0xFF) for _ in range(len(frame)))
+        if kind == 'truncated':
+            return frame[:max(1, len(frame) // 2)]
+        return bytes([0xFF, 0xE2, 0xFF, 0xFF]) + frame[4:]     # Zarezerwowana wersja/warstwa
+
+    def meta_block(self, title_no):
+        if title_no is None:
+            return b'\x00'
+        text = "StreamTitle='Soak Artist - Track %d';" % title_no
+        raw = text.encode('utf-8')
+        blocks = (len(raw) + 15) // 16
+        return bytes([blocks]) + raw + bytes(blocks * 16 - len(raw))
+
+
+class Server(socketserver.ThreadingTCPServer):
+    daemon_threads = True
+    allow_reuse_address = True
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    p.add_argument('--port', type=int, default=0, help='0 - dowolny wolny port')
+    p.add_argument('--file', help='plik MP3/AAC nadawany w pętli (zamiast ramek syntetycznych)')
+    p.add_argument('--codec', choices=['mp3', 'aac'], default='mp3')
+    p.add_argument('--bitrate', type=int, default=128, help='kbps (tempo nadawania)')
+    p.add_argument('--burst-kb', type=int, default=64, help='audio wysłane od razu po połączeniu')
+    p.add_argument('--metaint', type=int, default=16000)
+    p.add_argument('--title-every', type=float, default=30.0, help='s między zmianami StreamTitle')
+    p.add_argument('--bandwidth-kbps', type=float, default=0, help='limit łącza (0 - bez limitu)')
+    p.add_argument('--jitter-ms', type=float, default=0, help='losowe opóźnienie każdej porcji')
+    p.add_argument('--stall-every', type=float, default=0, help='średni odstęp przestojów (s)')
+    p.add_argument('--stall-ms', type=int, default=3000)
+    p.add_argument('--stall-catchup', action='store_true', help='po przestoju nadrabiaj zaległe audio')
+    p.add_argument('--disconnect-every', type=float, default=0, help='średni odstęp zerwań (s)')
+    p.add_argument('--down-ms', type=int, default=0, help='po zerwaniu serwer odpowiada 503')
+    p.add_argument('--bad-frames-per-min', type=float, default=0)
+    p.add_argument('--seed', type=int)
+    p.add_argument('--events', help='plik zdarzeń (JSON lines)')
+    p.add_argument('-v', '--verbose', action='store_true')
+    args = p.parse_args()
+
+    if args.seed is not None:
+        random.seed(args.seed)
+    if args.codec == 'mp3' and not args.file and args.bitrate not in MP3_BITRATES[1:]:
+        p.error('--bitrate must be a Layer III bitrate for synthetic MP3')
+
+    server = Server(('127.0.0.1', args.port), Handler)
+    server.args = args
+    server.faults = Faults(args)
+    print('PORT %d' % server.server_address[1], flush=True)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,178 @@
+#!/usr/bin/env python3
+"""
+Driver testów wytrzymałościowych: dla każdego scenariusza uruchamia icy_server.py
+z usterkami łącza i soak_player (host build) na zadany czas, zbiera liczniki
+(underrun, czas do pierwszego dźwięku, przerwy przy odnawianiu połączenia,
+szczyt bufora i pamięci) i drukuje tabelę.
+
+  python3 host/soak/soak.py --seconds 300
+  python3 host/soak/soak.py --scenario stalls --scenario hostile --json out.json
+  python3 host/soak/soak.py --baseline before.json        # różnice względem poprzedniego przebiegu
+
+Opcje po "--" trafiają do soak_player (np. -- --buffer-kb 128).
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+# Argumenty icy_server.py dla każdego scenariusza
+SCENARIOS = {
+    'clean':       [],
+    'aac':         ['--codec', 'aac', '--bitrate', '64'],
+    'slow_link':   ['--bandwidth-kbps', '136', '--burst-kb', '0'],
+    'starved':     ['--bandwidth-kbps', '112'],
+    'jitter':      ['--jitter-ms', '400'],
+    'stalls':      ['--stall-every', '20', '--stall-ms', '4000'],
+    'disconnects': ['--disconnect-every', '15'],
+    'outage':      ['--disconnect-every', '40', '--down-ms', '6000'],
+    'bad_frames':  ['--bad-frames-per-min', '30'],
+    'hostile':     ['--bandwidth-kbps', '160', '--jitter-ms', '250', '--stall-every', '30',
+                    '--stall-ms', '3000', '--disconnect-every', '45', '--down-ms', '2000',
+                    '--bad-frames-per-min', '10'],
+}
+
+# Kolumny tabeli: klucz wyniku, nagłówek, kierunek "lepiej" (-1 mniej, +1 więcej, 0 bez oceny)
+COLUMNS = [
+    ('ttfa_ms', 'ttfa', -1),
+    ('underruns', 'underrun', -1),
+    ('rebuffer_ms', 'rebuf_ms', -1),
+    ('dry_ms', 'dry_ms', -1),
+    ('reconnects', 'reconn', 0),
+    ('reconnects_audible', 'audible', -1),
+    ('reconnect_max_gap_ms', 'gap_max', -1),
+    ('give_ups', 'restart', -1),
+    ('bad_frames', 'bad', 0),
+    ('peak_buffer_bytes', 'peak_buf', 0),
+    ('peak_rss_kb', 'rss_kb', -1),
+]
+
+
+def find_player(build_dir):
+    path = os.path.join(build_dir, 'soak_player')
+    if not os.path.exists(path):
+        sys.exit('soak_player not found in %s - build the host target first' % build_dir)
+    return path
+
+
+def run_scenario(name, server_args, player, seconds, player_args, seed):
+    events_path = tempfile.mktemp(prefix='soak_%s_' % name, suffix='.jsonl')
+    cmd = [sys.executable, os.path.join(HERE, 'icy_server.py'), '--events', events_path] + server_args
+    if seed is not None:
+        cmd += ['--seed', str(seed)]
+    server = subprocess.Popen(cmd, stdout=subprocess.PIPE, text=True)
+    try:
+        line = server.stdout.readline()
+        if not line.startswith('PORT '):
+            raise RuntimeError('icy_server.py did not start')
+        url = 'http://127.0.0.1:%d/stream' % int(line.split()[1])
+
+        started = time.monotonic()
+        out = subprocess.run([player, '--url', url, '--seconds', str(seconds), '--json'] + player_args,
+                             stdout=subprocess.PIPE, text=True, timeout=seconds + 30)
+        result = json.loads(out.stdout.strip().splitlines()[-1])
+        result['exit'] = out.returncode
+        result['wall_s'] = round(time.monotonic() - started, 1)
+    finally:
+        server.terminate()
+        server.wait()
+
+    injected = {}
+    if os.path.exists(events_path):
+        with open(events_path) as f:
+            for line in f:
+                kind = json.loads(line)['event']
+                injected[kind] = injected.get(kind, 0) + 1
+        os.unlink(events_path)
+    result['injected'] = injected
+    return result
+
+
+def print_table(results, baseline):
+    header = '%-12s' % 'scenario' + ''.join('%11s' % title for _, title, _ in COLUMNS) + '  injected'
+    print(header)
+    print('-' * len(header))
+    for name, r in results.items():
+        cells = []
+        base = baseline.get(name) if baseline else None
+        for key, _, better in COLUMNS:
+            value = r.get(key, 0)
+            cell = str(value)
+            if base is not None and key in base and base[key] != value:
+                delta = value - base[key]
+                mark = ''
+                if better and delta * better < 0:
+                    mark = '!'
+                cell = '%s%+d%s' % ('', delta, mark)
+                cell = '%d(%s)' % (value, cell)
+            cells.append('%11s' % cell)
+        injected = ' '.join('%s=%d' % kv for kv in sorted(r['injected'].items()) if kv[0] != 'connect')
+        print('%-12s' % name + ''.join(cells) + '  ' + injected)
+
+
+def regressions(results, baseline):
+    found = []
+    for name, r in results.items():
+        base = baseline.get(name)
+        if not base:
+            continue
+        for key, _, better in COLUMNS:
+            if better < 0 and key in base and r.get(key, 0) > base[key]:
+                found.append('%s.%s: %s -> %s' % (name, key, base[key], r.get(key)))
+    return found
+
+
+def main():
+    argv = sys.argv[1:]
+    player_args = []
+    if '--' in argv:
+        split = argv.index('--')
+        argv, player_args = argv[:split], argv[split + 1:]
+
+    p = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    p.add_argument('--build-dir', default=os.path.join(HERE, '..', '..', '_gate_build'))
+    p.add_argument('--seconds', type=int, default=120, help='czas każdego scenariusza')
+    p.add_argument('--scenario', action='append', choices=sorted(SCENARIOS), help='domyślnie wszystkie')
+    p.add_argument('--seed', type=int, default=1, help='ziarno usterek serwera (powtarzalność)')
+    p.add_argument('--json', help='zapis wyników (wejście dla --baseline)')
+    p.add_argument('--baseline', help='wyniki poprzedniego przebiegu do porównania')
+    p.add_argument('--fail-on-regression', action='store_true',
+                   help='kod wyjścia 1, gdy metryka "mniej = lepiej" wzrosła względem --baseline')
+    args = p.parse_args(argv)
+
+    player = find_player(args.build_dir)
+    baseline = None
+    if args.baseline:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+
+    results = {}
+    for name in args.scenario or list(SCENARIOS):
+        print('running %s (%d s)...' % (name, args.seconds), file=sys.stderr, flush=True)
+        results[name] = run_scenario(name, SCENARIOS[name], player, args.seconds, player_args, args.seed)
+
+    print_table(results, baseline)
+    if args.json:
+        with open(args.json, 'w') as f:
+            json.dump(results, f, indent=2)
+
+    failed = [name for name, r in results.items() if r['exit'] != 0]
+    if failed:
+        print('no audio: %s' % ', '.join(failed), file=sys.stderr)
+        return 1
+    if baseline and args.fail_on_regression:
+        found = regressions(results, baseline)
+        for line in found:
+            print('regression: %s' % line, file=sys.stderr)
+        return 1 if found else 0
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
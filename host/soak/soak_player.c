@@ -0,0 +1,505 @@
+/*
+ * Soak player - model toru radia internetowego na hoście
+ *
+ * Łączy się ze strumieniem HTTP/ICY (zwykle host/soak/icy_server.py), usuwa metadane
+ * przez icy_meta, rozpoznaje format przez codec_detect i przechodzi po ramkach jak
+ * dekoder (desynchronizacja = uszkodzona ramka). Zamiast dekodowania bufor HTTP jest
+ * opróżniany w tempie bitrate strumienia.
+ *
+ * Polityka buforowania odwzorowuje audio_player.c: prebuffer_tick (cel ze
+ * station_profile, próg underrun, limit czasu prebufora, stabilne odtwarzanie) i
+ * stream_slot.c: slot_reconnect (backoff z rozrzutem, limit braku danych, rezygnacja
+ * po minucie). Stałe poniżej muszą nadążać za oboma plikami.
+ *
+ *   soak_player --url http://127.0.0.1:8000/stream --seconds 600 [--buffer-kb 256] [--json]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include "icy_meta.h"
+#include "codec_detect.h"
+#include "station_profile.h"
+
+// Jak w audio_player.c i stream_slot.c
+#define PREBUFFER_CHECK_MS          100
+#define PREBUFFER_LOW_WATERMARK_MS  250
+#define PREBUFFER_TIMEOUT_MS        10000
+#define PREBUFFER_STABLE_MS         60000
+#define HTTP_BUFFER_SIZE_KB         256
+#define DEFAULT_BITRATE_KBPS        128
+#define HTTP_READ_TIMEOUT_MS        5000
+#define RECONNECT_BACKOFF_MIN_MS    250
+#define RECONNECT_BACKOFF_MAX_MS    8000
+#define RECONNECT_GIVE_UP_MS        60000
+
+#define READ_CHUNK                  4096
+#define CONNECT_TIMEOUT_MS          2000
+#define WALK_WINDOW                 8192    // Niezweryfikowane bajty strumienia dla przejścia po ramkach
+
+typedef enum {
+    SOAK_CONNECTING = 0,
+    SOAK_BUFFERING,
+    SOAK_PLAYING,
+} soak_state_t;
+
+typedef struct {
+    uint32_t ttfa_ms;                   // Od startu do pierwszego PLAYING
+    uint32_t starts;                    // Pełne (re)starty stacji
+    uint32_t underruns;
+    uint32_t rebuffer_ms;
+    uint32_t rebuffer_max_ms;
+    uint32_t dry_ms;                    // Wyjście bez danych (cisza słyszalna)
+    uint32_t reconnects;
+    uint32_t reconnects_audible;        // Przerwa dłuższa niż zapas w chwili zerwania
+    uint32_t reconnect_failures;
+    uint64_t reconnect_gap_sum_ms;
+    uint32_t reconnect_max_gap_ms;
+    uint32_t give_ups;                  // Minuta bez danych - pełny restart
+    uint32_t bad_frames;                // Desynchronizacje przy przejściu po ramkach
+    uint32_t frames;
+    uint32_t titles;
+    uint64_t bytes_audio;
+    uint64_t bytes_meta;
+    uint32_t peak_buffer_bytes;
+    int target_ms_final;
+} soak_stats_t;
+
+static struct {
+    const char *host;
+    char port[8];
+    char path[256];
+    int seconds;
+    int buffer_bytes;
+    bool json;
+    bool verbose;
+} opt = {
+    .seconds = 60,
+    .buffer_bytes = HTTP_BUFFER_SIZE_KB * 1024,
+};
+
+static soak_stats_t stats;
+static uint64_t t0;
+
+static uint64_t mono_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static uint32_t now_ms(void)
+{
+    return (uint32_t)(mono_ms() - t0);
+}
+
+#define LOG(fmt, ...) do {                                                      \
+        if (opt.verbose) fprintf(stderr, "[%7.3f] " fmt "\n", now_ms() / 1000.0, ##__VA_ARGS__); \
+    } while (0)
+
+// ============================================
+// Połączenie
+// ============================================
+
+static int connect_stream(int *bitrate_kbps, uint8_t *body, int *body_len)
+{
+    struct addrinfo hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM }, *res;
+    if (getaddrinfo(opt.host, opt.port, &hints, &res) != 0) {
+        return -1;
+    }
+    int fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    if (fd < 0 || connect(fd, res->ai_addr, res->ai_addrlen) != 0) {
+        if (fd >= 0) close(fd);
+        freeaddrinfo(res);
+        return -1;
+    }
+    freeaddrinfo(res);
+
+    char req[512];
+    int n = snprintf(req, sizeof(req),
+                     "GET %s HTTP/1.0\r\nHost: %s\r\nUser-Agent: ESP32-AudioPlayer/1.0\r\n"
+                     "Icy-MetaData: 1\r\n\r\n", opt.path, opt.host);
+    if (send(fd, req, n, MSG_NOSIGNAL) != n) {
+        close(fd);
+        return -1;
+    }
+
+    // Nagłówki odpowiedzi; reszta odczytu to początek body
+    char head[4096];
+    int len = 0;
+    char *end = NULL;
+    uint64_t deadline = mono_ms() + CONNECT_TIMEOUT_MS;
+    while (end == NULL) {
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+        int wait = (int)(deadline - mono_ms());
+        if (wait <= 0 || poll(&pfd, 1, wait) <= 0 || len >= (int)sizeof(head) - 1) {
+            close(fd);
+            return -1;
+        }
+        int r = recv(fd, head + len, sizeof(head) - 1 - len, 0);
+        if (r <= 0) {
+            close(fd);
+            return -1;
+        }
+        len += r;
+        head[len] = '\0';
+        end = strstr(head, "\r\n\r\n");
+    }
+
+    int status = 0;
+    sscanf(head, "%*s %d", &status);
+    if (status != 200) {
+        LOG("HTTP %d", status);
+        close(fd);
+        return -1;
+    }
+    char *br = strcasestr(head, "\nicy-br:");
+    if (br && atoi(br + 8) > 0) {
+        *bitrate_kbps = atoi(br + 8);
+    }
+
+    int header_len = (int)(end + 4 - head);
+    *body_len = len - header_len;
+    memcpy(body, head + header_len, *body_len);
+    return fd;
+}
+
+// ============================================
+// Metadane i ramki
+// ============================================
+
+static void icy_callback(const char *meta, void *ctx)
+{
+    char artist[64], title[128];
+    if (icy_meta_parse_title(meta, artist, sizeof(artist), title, sizeof(title))) {
+        stats.titles++;
+        LOG("title: %s - %s", artist, title);
+    }
+}
+
+static uint8_t walk_buf[WALK_WINDOW];
+static int walk_len;
+static esp_codec_type_t codec = ESP_CODEC_TYPE_UNKNOW;
+
+// Przejście po ramkach jak dekoder: każdy bajt przed zsynchronizowaną ramką to uszkodzenie
+static void walk_frames(const uint8_t *data, int len)
+{
+    if (codec == ESP_CODEC_TYPE_M4A) {
+        return;     // Kontener MP4 - bez ramek do przejścia
+    }
+    while (len > 0) {
+        int take = len < WALK_WINDOW - walk_len ? len : WALK_WINDOW - walk_len;
+        memcpy(walk_buf + walk_len, data, take);
+        walk_len += take;
+        data += take;
+        len -= take;
+
+        int pos = 0;
+        for (;;) {
+            codec_frame_info_t info;
+            esp_codec_type_t c = codec_detect_probe(walk_buf + pos, walk_len - pos, &info);
+            if (c == ESP_CODEC_TYPE_M4A && codec == ESP_CODEC_TYPE_UNKNOW) {
+                codec = c;
+                walk_len = 0;
+                return;
+            }
+            if (c == ESP_CODEC_TYPE_UNKNOW || c == ESP_CODEC_TYPE_M4A) {
+                // Pełne okno bez synchronizacji - odrzuć, zostaw ogon na nagłówek
+                if (walk_len - pos == WALK_WINDOW) {
+                    stats.bad_frames++;
+                    pos = walk_len - 16;
+                }
+                break;
+            }
+            if (codec == ESP_CODEC_TYPE_UNKNOW) {
+                codec = c;
+                LOG("codec %s, %d Hz, %d kbps", codec_detect_name(c), info.sample_rate, info.bitrate_kbps);
+            }
+            // Ramka niepotwierdzona następnym nagłówkiem - czekaj na więcej danych
+            if (pos + info.offset + info.frame_len + 7 > walk_len) {
+                pos += info.offset;
+                if (info.offset > 0) stats.bad_frames++;
+                break;
+            }
+            if (info.offset > 0) stats.bad_frames++;
+            pos += info.offset + info.frame_len;
+            stats.frames++;
+        }
+        memmove(walk_buf, walk_buf + pos, walk_len - pos);
+        walk_len -= pos;
+    }
+}
+
+// ============================================
+// Pętla odtwarzania
+// ============================================
+
+static int run(void)
+{
+    station_profile_t *profile = station_profile_get("soak");
+    icy_meta_t icy;
+    static uint8_t buf[READ_CHUNK];
+
+    int fd = -1;
+    int bitrate = DEFAULT_BITRATE_KBPS;
+    soak_state_t state = SOAK_CONNECTING;
+    int64_t buffered = 0;               // Bajty audio w buforze HTTP
+    double drain_acc = 0;
+    uint32_t last_data = 0, last_tick = 0, last_check = 0;
+    uint32_t buffering_started = 0, stable_since = 0, next_attempt = 0;
+    uint32_t backoff = RECONNECT_BACKOFF_MIN_MS;
+    bool reconnecting = false, rebuffering = false, started = false;
+    int buffered_at_loss = 0;
+    uint32_t end_ms = opt.seconds * 1000;
+
+    srand(1);
+    stats.starts = 1;
+    buffering_started = now_ms();
+
+    while (now_ms() < end_ms) {
+        uint32_t now = now_ms();
+
+        // Połączenie: start stacji albo kolejna próba odnowienia
+        if (fd < 0 && now >= next_attempt) {
+            int body_len = 0;
+            fd = connect_stream(&bitrate, buf, &body_len);
+            if (fd < 0) {
+                if (reconnecting) stats.reconnect_failures++;
+                uint32_t wait = backoff / 2 + rand() % (backoff / 2 + 1);
+                backoff = backoff * 2 > RECONNECT_BACKOFF_MAX_MS ? RECONNECT_BACKOFF_MAX_MS : backoff * 2;
+                next_attempt = now_ms() + wait;
+            } else {
+                icy_meta_reset(&icy, icy_callback, NULL);
+                if (reconnecting) {
+                    uint32_t gap = now_ms() - last_data;
+                    stats.reconnects++;
+                    stats.reconnect_gap_sum_ms += gap;
+                    if (gap > stats.reconnect_max_gap_ms) stats.reconnect_max_gap_ms = gap;
+                    if ((int)gap >= buffered_at_loss) stats.reconnects_audible++;
+                    LOG("reconnected after %u ms", gap);
+                    reconnecting = false;
+                }
+                if (state == SOAK_CONNECTING) {
+                    state = SOAK_BUFFERING;
+                }
+                last_data = now_ms();
+                backoff = RECONNECT_BACKOFF_MIN_MS;
+                if (body_len > 0) {
+                    int audio = icy_meta_strip(&icy, buf, body_len);
+                    stats.bytes_meta += body_len - audio;
+                    stats.bytes_audio += audio;
+                    buffered += audio;
+                    walk_frames(buf, audio);
+                }
+            }
+        }
+
+        // Odczyt - tylko gdy bufor HTTP ma miejsce (jak ring buffer http_stream)
+        int space = opt.buffer_bytes - (int)buffered;
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+        int ready = poll(&pfd, fd >= 0 && space > 0 ? 1 : 0, 5);
+        if (fd >= 0 && ready > 0) {
+            int want = icy_meta_read_size(&icy, space < READ_CHUNK ? space : READ_CHUNK);
+            int r = recv(fd, buf, want, 0);
+            if (r > 0) {
+                int audio = icy_meta_strip(&icy, buf, r);
+                stats.bytes_meta += r - audio;
+                stats.bytes_audio += audio;
+                buffered += audio;
+                walk_frames(buf, audio);
+                last_data = now_ms();
+            } else if (r == 0 || (errno != EAGAIN && errno != EINTR)) {
+                close(fd);
+                fd = -1;
+            }
+        }
+        if (fd >= 0 && space > 0 && now_ms() - last_data >= HTTP_READ_TIMEOUT_MS) {
+            LOG("read timeout");
+            close(fd);
+            fd = -1;
+        }
+        if (fd < 0 && !reconnecting && state != SOAK_CONNECTING) {
+            reconnecting = true;
+            buffered_at_loss = (int)(buffered * 8 / bitrate);
+            backoff = RECONNECT_BACKOFF_MIN_MS;
+            next_attempt = now_ms() + backoff / 2 + rand() % (backoff / 2 + 1);
+            backoff *= 2;
+            LOG("connection lost, %d ms buffered", buffered_at_loss);
+        }
+        if (reconnecting && now_ms() - last_data >= RECONNECT_GIVE_UP_MS) {
+            // Task sterujący restartuje stację od zera
+            stats.give_ups++;
+            stats.starts++;
+            reconnecting = false;
+            rebuffering = true;
+            buffered = 0;
+            walk_len = 0;
+            state = SOAK_CONNECTING;
+            buffering_started = now_ms();
+            last_data = now_ms();
+            LOG("gave up, restarting station");
+        }
+
+        // Wyjście zużywa audio w tempie bitrate
+        now = now_ms();
+        uint32_t dt = now - last_tick;
+        last_tick = now;
+        if (state == SOAK_PLAYING) {
+            drain_acc += (double)bitrate * 1000 / 8 * dt / 1000;
+            int64_t drain = (int64_t)drain_acc;
+            drain_acc -= drain;
+            if (buffered >= drain) {
+                buffered -= drain;
+            } else {
+                stats.dry_ms += (uint32_t)((drain - buffered) * 8 / bitrate);
+                buffered = 0;
+            }
+        }
+        if (buffered > stats.peak_buffer_bytes) {
+            stats.peak_buffer_bytes = (uint32_t)buffered;
+        }
+
+        // prebuffer_tick
+        if (now - last_check < PREBUFFER_CHECK_MS) {
+            continue;
+        }
+        last_check = now;
+        int buffered_ms = (int)(buffered * 8 / bitrate);
+        int capacity_ms = (int)((int64_t)opt.buffer_bytes * 8 / bitrate);
+        int target_ms = station_profile_target_ms(profile, capacity_ms);
+
+        if (state == SOAK_BUFFERING || state == SOAK_CONNECTING) {
+            bool timeout = (now - buffering_started >= PREBUFFER_TIMEOUT_MS) && buffered_ms > 0;
+            if (state == SOAK_BUFFERING && (buffered_ms >= target_ms || timeout)) {
+                uint32_t took = now - buffering_started;
+                if (!started) {
+                    started = true;
+                    stats.ttfa_ms = now;
+                } else if (rebuffering) {
+                    stats.rebuffer_ms += took;
+                    if (took > stats.rebuffer_max_ms) stats.rebuffer_max_ms = took;
+                }
+                rebuffering = false;
+                LOG("playing after %u ms (%d/%d ms)", took, buffered_ms, target_ms);
+                stable_since = now;
+                state = SOAK_PLAYING;
+            }
+        } else if (state == SOAK_PLAYING) {
+            if (buffered_ms < PREBUFFER_LOW_WATERMARK_MS && !reconnecting) {
+                station_profile_underrun(profile);
+                stats.underruns++;
+                rebuffering = true;
+                LOG("underrun (%d ms left), target %u ms", buffered_ms, profile->target_ms);
+                buffering_started = now;
+                state = SOAK_BUFFERING;
+            } else if (now - stable_since >= PREBUFFER_STABLE_MS) {
+                station_profile_stable(profile);
+                stable_since = now;
+            }
+        }
+    }
+
+    if (fd >= 0) close(fd);
+    stats.target_ms_final = station_profile_target_ms(profile,
+                                                      (int)((int64_t)opt.buffer_bytes * 8 / bitrate));
+    return started ? 0 : 1;
+}
+
+static void report(void)
+{
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    uint32_t avg_gap = stats.reconnects ? (uint32_t)(stats.reconnect_gap_sum_ms / stats.reconnects) : 0;
+
+    if (opt.json) {
+        printf("{\"seconds\":%d,\"codec\":\"%s\",\"ttfa_ms\":%u,\"starts\":%u,\"underruns\":%u,"
+               "\"rebuffer_ms\":%u,\"rebuffer_max_ms\":%u,\"dry_ms\":%u,"
+               "\"reconnects\":%u,\"reconnects_audible\":%u,\"reconnect_failures\":%u,"
+               "\"reconnect_avg_gap_ms\":%u,\"reconnect_max_gap_ms\":%u,\"give_ups\":%u,"
+               "\"frames\":%u,\"bad_frames\":%u,\"titles\":%u,"
+               "\"bytes_audio\":%llu,\"bytes_meta\":%llu,"
+               "\"peak_buffer_bytes\":%u,\"buffer_bytes\":%d,\"target_ms\":%d,\"peak_rss_kb\":%ld}\n",
+               opt.seconds, codec_detect_name(codec), stats.ttfa_ms, stats.starts, stats.underruns,
+               stats.rebuffer_ms, stats.rebuffer_max_ms, stats.dry_ms,
+               stats.reconnects, stats.reconnects_audible, stats.reconnect_failures,
+               avg_gap, stats.reconnect_max_gap_ms, stats.give_ups,
+               stats.frames, stats.bad_frames, stats.titles,
+               (unsigned long long)stats.bytes_audio, (unsigned long long)stats.bytes_meta,
+               stats.peak_buffer_bytes, opt.buffer_bytes, stats.target_ms_final, ru.ru_maxrss);
+        return;
+    }
+
+    printf("codec              %s\n", codec_detect_name(codec));
+    printf("time to audio      %u ms\n", stats.ttfa_ms);
+    printf("underruns          %u (rebuffer %u ms total, %u ms max)\n",
+           stats.underruns, stats.rebuffer_ms, stats.rebuffer_max_ms);
+    printf("dry output         %u ms\n", stats.dry_ms);
+    printf("reconnects         %u (%u audible, %u failed attempts), gap avg %u / max %u ms\n",
+           stats.reconnects, stats.reconnects_audible, stats.reconnect_failures,
+           avg_gap, stats.reconnect_max_gap_ms);
+    printf("restarts           %u\n", stats.give_ups);
+    printf("frames             %u (%u bad), %u titles\n", stats.frames, stats.bad_frames, stats.titles);
+    printf("peak buffer        %u / %d bytes, target %d ms\n",
+           stats.peak_buffer_bytes, opt.buffer_bytes, stats.target_ms_final);
+    printf("peak RSS           %ld KB\n", ru.ru_maxrss);
+}
+
+static int parse_url(const char *url)
+{
+    static char host[128];
+    if (strncmp(url, "http://", 7) != 0) return -1;
+    const char *p = url + 7;
+    const char *slash = strchr(p, '/');
+    const char *colon = strchr(p, ':');
+    size_t host_len = (colon && (!slash || colon < slash)) ? (size_t)(colon - p)
+                      : (slash ? (size_t)(slash - p) : strlen(p));
+    if (host_len == 0 || host_len >= sizeof(host)) return -1;
+    memcpy(host, p, host_len);
+    host[host_len] = '\0';
+    opt.host = host;
+    snprintf(opt.port, sizeof(opt.port), "%d",
+             (colon && (!slash || colon < slash)) ? atoi(colon + 1) : 80);
+    snprintf(opt.path, sizeof(opt.path), "%s", slash ? slash : "/");
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    const char *url = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--url") && i + 1 < argc) {
+            url = argv[++i];
+        } else if (!strcmp(argv[i], "--seconds") && i + 1 < argc) {
+            opt.seconds = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--buffer-kb") && i + 1 < argc) {
+            opt.buffer_bytes = atoi(argv[++i]) * 1024;
+        } else if (!strcmp(argv[i], "--json")) {
+            opt.json = true;
+        } else if (!strcmp(argv[i], "-v")) {
+            opt.verbose = true;
+        } else {
+            url = NULL;
+            break;
+        }
+    }
+    if (url == NULL || parse_url(url) != 0 || opt.seconds <= 0 || opt.buffer_bytes <= 0) {
+        fprintf(stderr, "usage: %s --url http://host:port/path [--seconds N] [--buffer-kb N] [--json] [-v]\n",
+                argv[0]);
+        return 2;
+    }
+
+    t0 = mono_ms();
+    int ret = run();
+    report();
+    return ret;
+}
@@ -0,0 +1,72 @@
+/*
+ * Referencyjny korektor w double - ta sama kaskada peaking (RBJ cookbook, Q = 1.41,
+ * pomijane pasma 0 dB i powyżej 0.45 * fs) co eq_filter, bez kwantyzacji.
+ *
+ * Stockowy `equalizer` z ESP-ADF jest dostarczany jako zamknięta biblioteka
+ * (libesp_codec, tylko Xtensa), więc na hoście punktem odniesienia dla dokładności
+ * eq_filter jest ta implementacja.
+ */
+
+#ifndef EQ_REFERENCE_H
+#define EQ_REFERENCE_H
+
+#include <math.h>
+#include <string.h>
+#include "eq_filter.h"
+
+typedef struct {
+    double b0, b1, b2, a1, a2;      // a1, a2 w zwykłej postaci (odejmowane)
+    double x1, x2, y1, y2;
+} eq_ref_section_t;
+
+typedef struct {
+    eq_ref_section_t sec[EQ_FILTER_CHANNELS][EQ_FILTER_BANDS];
+    int count[EQ_FILTER_CHANNELS];
+    int channels;
+} eq_ref_t;
+
+static void eq_ref_init(eq_ref_t *r, const int *freq, const int *gains_db, int sample_rate, int channels)
+{
+    memset(r, 0, sizeof(*r));
+    r->channels = channels;
+    for (int ch = 0; ch < channels; ch++) {
+        for (int b = 0; b < EQ_FILTER_BANDS; b++) {
+            int g = gains_db[ch * EQ_FILTER_BANDS + b];
+            if (g == 0 || freq[b] >= sample_rate * 0.45) continue;
+            double a = pow(10.0, g / 40.0);
+            double w0 = 2.0 * M_PI * freq[b] / sample_rate;
+            double alpha = sin(w0) / (2.0 * 1.41);
+            double a0 = 1.0 + alpha / a;
+            eq_ref_section_t *s = &r->sec[ch][r->count[ch]++];
+            s->b0 = (1.0 + alpha * a) / a0;
+            s->b1 = -2.0 * cos(w0) / a0;
+            s->b2 = (1.0 - alpha * a) / a0;
+            s->a1 = -2.0 * cos(w0) / a0;
+            s->a2 = (1.0 - alpha / a) / a0;
+        }
+    }
+}
+
+// Przeplatane int16 -> przeplatane double w skali int16 (bez zaokrąglenia i nasycenia)
+static void eq_ref_process(eq_ref_t *r, const int16_t *in, double *out, int frames)
+{
+    for (int i = 0; i < frames * r->channels; i++) {
+        out[i] = in[i];
+    }
+    for (int ch = 0; ch < r->channels; ch++) {
+        for (int k = 0; k < r->count[ch]; k++) {
+            eq_ref_section_t *s = &r->sec[ch][k];
+            for (int i = ch; i < frames * r->channels; i += r->channels) {
+                double x = out[i];
+                double y = s->b0 * x + s->b1 * s->x1 + s->b2 * s->x2 - s->a1 * s->y1 - s->a2 * s->y2;
+                s->x2 = s->x1;
+                s->x1 = x;
+                s->y2 = s->y1;
+                s->y1 = y;
+                out[i] = y;
+            }
+        }
+    }
+}
+
+#endif // EQ_REFERENCE_H
@@ -0,0 +1,114 @@
+/*
+ * alarm_schedule: dopasowanie minuty i dnia tygodnia, czas do najbliższego alarmu
+ */
+
+#include <stdlib.h>
+#include "test_util.h"
+#include "alarm_schedule.h"
+
+// 2024-01-01 to poniedziałek
+static struct tm at(int mday, int hour, int min, int sec)
+{
+    struct tm t = {
+        .tm_year = 124, .tm_mon = 0, .tm_mday = mday,
+        .tm_hour = hour, .tm_min = min, .tm_sec = sec, .tm_isdst = -1,
+    };
+    time_t ts = mktime(&t);
+    localtime_r(&ts, &t);
+    return t;
+}
+
+static alarm_t make_alarm(int hour, int minute, uint8_t days)
+{
+    alarm_t a = {0};
+    a.enabled = true;
+    a.hour = hour;
+    a.minute = minute;
+    a.days = days;
+    return a;
+}
+
+static void test_day_bits(void)
+{
+    CHECK_INT(alarm_schedule_day_bit(0), ALARM_DAY_SUNDAY);
+    CHECK_INT(alarm_schedule_day_bit(1), ALARM_DAY_MONDAY);
+    CHECK_INT(alarm_schedule_day_bit(5), ALARM_DAY_FRIDAY);
+    CHECK_INT(alarm_schedule_day_bit(6), ALARM_DAY_SATURDAY);
+}
+
+static void test_is_due(void)
+{
+    alarm_t a = make_alarm(7, 30, ALARM_DAY_WEEKDAYS);
+    struct tm mon = at(1, 7, 30, 0);
+    CHECK(alarm_schedule_is_due(&a, &mon));
+
+    // Sekundy bez znaczenia - task budzika nie musi trafić w :00
+    struct tm late = at(1, 7, 30, 4);
+    CHECK(alarm_schedule_is_due(&a, &late));
+
+    struct tm next_min = at(1, 7, 31, 0);
+    CHECK(!alarm_schedule_is_due(&a, &next_min));
+
+    struct tm sat = at(6, 7, 30, 0);
+    CHECK(!alarm_schedule_is_due(&a, &sat));
+    struct tm sun = at(7, 7, 30, 0);
+    CHECK(!alarm_schedule_is_due(&a, &sun));
+
+    a.days = ALARM_DAY_SUNDAY;
+    CHECK(alarm_schedule_is_due(&a, &sun));
+
+    a.enabled = false;
+    CHECK(!alarm_schedule_is_due(&a, &sun));
+}
+
+static void test_minutes_until(void)
+{
+    struct tm mon = at(1, 7, 0, 0);
+
+    alarm_t a = make_alarm(7, 30, ALARM_DAY_EVERYDAY);
+    CHECK_INT(alarm_schedule_minutes_until(&a, &mon), 30);
+
+    // Dziś już minął - jutro
+    a.hour = 6;
+    CHECK_INT(alarm_schedule_minutes_until(&a, &mon), 23 * 60 + 30);
+
+    // Tylko w piątek
+    a = make_alarm(8, 0, ALARM_DAY_FRIDAY);
+    CHECK_INT(alarm_schedule_minutes_until(&a, &mon), 4 * 24 * 60 + 60);
+
+    // Tylko w poniedziałek, godzina minęła - za tydzień (dzień 7)
+    a = make_alarm(6, 0, ALARM_DAY_MONDAY);
+    CHECK_INT(alarm_schedule_minutes_until(&a, &mon), 7 * 24 * 60 - 60);
+
+    // Alarm z bieżącej minuty już się wywołał
+    a = make_alarm(7, 0, ALARM_DAY_MONDAY);
+    CHECK_INT(alarm_schedule_minutes_until(&a, &mon), 7 * 24 * 60);
+
+    // Przez północ niedziela -> poniedziałek
+    struct tm sun = at(7, 23, 50, 0);
+    a = make_alarm(0, 10, ALARM_DAY_MONDAY);
+    CHECK_INT(alarm_schedule_minutes_until(&a, &sun), 20);
+}
+
+static void test_never(void)
+{
+    struct tm mon = at(1, 7, 0, 0);
+    alarm_t a = make_alarm(7, 30, 0);
+    CHECK_INT(alarm_schedule_minutes_until(&a, &mon), -1);
+
+    a = make_alarm(7, 30, ALARM_DAY_EVERYDAY);
+    a.enabled = false;
+    CHECK_INT(alarm_schedule_minutes_until(&a, &mon), -1);
+}
+
+int main(void)
+{
+    setenv("TZ", "UTC0", 1);
+    tzset();
+
+    RUN_TEST(test_day_bits);
+    RUN_TEST(test_is_due);
+    RUN_TEST(test_minutes_until);
+    RUN_TEST(test_never);
+    return TEST_RESULT();
+}
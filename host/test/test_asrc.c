@@ -0,0 +1,343 @@
+/*
+ * asrc: symulacja rozjechanych zegarów - źródło (serwer radia) szybsze lub wolniejsze
+ * o 50-200 ppm od stałego zegara wyjścia (I2S). Przez kilka godzin czasu symulacji
+ * bufor między nimi ma zbiec do punktu pracy i pozostać ograniczony.
+ *
+ * Tor jak w output_read_drift(): odczyty po DRIFT_BLOCK_FRAMES ramek, regulator co
+ * PREBUFFER_CHECK_MS z całkowitym poziomem w ms (buffered_ms). W długiej symulacji
+ * zużycie wejścia liczone jest z kroku resamplera (asrc.step_delta) zamiast przez
+ * interpolację każdej próbki - test_resampler_rate sprawdza, że asrc_process ten krok
+ * dotrzymuje. test_resampler_ratio - stała konwersja 48/32 kHz -> 44.1 kHz dla A2DP.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "test_util.h"
+#include "asrc.h"
+
+#define RATE            44100
+#define BLOCK_FRAMES    512         // DRIFT_BLOCK_FRAMES
+#define CHECK_MS        100         // PREBUFFER_CHECK_MS
+#define PACKET_FRAMES   1152        // Ramka MP3 po dekodowaniu
+#define START_LEVEL_MS  2000
+
+typedef struct {
+    double skew_ppm;                // Zegar źródła względem wyjścia
+    double hours;
+    double relock_at_h;             // > 0 - przerwa w danych (asrc_ctrl_relock) w tej chwili
+} sim_case_t;
+
+typedef struct {
+    double lock_at_s;               // Chwila ustalenia punktu pracy
+    double setpoint_ms;
+    double max_dev_ms;              // Największe odchylenie uśrednionego poziomu od punktu pracy
+    double last_hour_dev_ms;        // To samo w ostatniej godzinie
+    double min_level_ms;            // Chwilowy poziom (z wahaniami od pakietów)
+    double max_level_ms;
+    double ppm_at_end;
+    double integral_at_end;
+    double max_slew;                // Największa zmiana korekty na jedno wywołanie
+    double ppm_before_lock;         // Największa |korekta| przed ustaleniem punktu pracy
+    double relock_dev_ms;           // Zmiana poziomu w czasie ponownego ustalania
+    int underruns;
+} sim_result_t;
+
+static sim_result_t simulate(const sim_case_t *sc)
+{
+    sim_result_t r = { .min_level_ms = 1e9 };
+
+    asrc_t asrc = {0};
+    asrc_reset(&asrc, 1);
+    asrc_set_ppm(&asrc, 0);
+    asrc_ctrl_t ctrl;
+    asrc_ctrl_reset(&ctrl);
+
+    srand(11);
+    int64_t level = (int64_t)START_LEVEL_MS * RATE / 1000;     // Ramki w buforze
+    double produced = 0;                                         // Wyprodukowane, jeszcze nie dostarczone
+    double consumed = 0;                                         // Ułamek ramki wejścia
+    int64_t sink_frames = 0, next_check = RATE * CHECK_MS / 1000;
+    int64_t end = (int64_t)(sc->hours * 3600 * RATE);
+    int64_t relock_at = sc->relock_at_h > 0 ? (int64_t)(sc->relock_at_h * 3600 * RATE) : -1;
+    double relock_level = -1;
+
+    while (sink_frames < end) {
+        // Wyjście gra BLOCK_FRAMES ramek, resampler zużywa ich (1 + step_delta / 2^32) razy więcej
+        int n = BLOCK_FRAMES;
+        consumed += n * (1.0 + asrc.step_delta / 4294967296.0);
+        int64_t frames = (int64_t)consumed;
+        consumed -= frames;
+        if (frames > level) {
+            r.underruns++;
+            frames = level;
+        }
+        level -= frames;
+        sink_frames += n;
+
+        // Źródło: tyle ramek, ile wyprodukował jego zegar w tym czasie, pakietami
+        // z opóźnieniem (do kilkuset ms)
+        produced += n * (1.0 + sc->skew_ppm * 1e-6);
+        while (produced >= PACKET_FRAMES && rand() % 4 != 0) {
+            level += PACKET_FRAMES;
+            produced -= PACKET_FRAMES;
+        }
+
+        if (sink_frames < next_check) {
+            continue;
+        }
+        next_check += RATE * CHECK_MS / 1000;
+
+        double t_s = (double)sink_frames / RATE;
+        int level_ms = (int)(level * 1000 / RATE);
+        if (level_ms < r.min_level_ms) r.min_level_ms = level_ms;
+        if (level_ms > r.max_level_ms) r.max_level_ms = level_ms;
+
+        if (relock_at >= 0 && sink_frames >= relock_at) {
+            asrc_ctrl_relock(&ctrl);
+            relock_at = -1;
+            relock_level = level_ms;
+        }
+
+        float prev = ctrl.ppm;
+        bool was_locked = ctrl.locked;
+        float ppm = asrc_ctrl_update(&ctrl, level_ms, CHECK_MS);
+        asrc_set_ppm(&asrc, ppm);
+
+        if (fabs(ppm - prev) > r.max_slew) r.max_slew = fabs(ppm - prev);
+        if (!was_locked && ctrl.locked) {
+            if (r.lock_at_s == 0) r.lock_at_s = t_s;
+            r.setpoint_ms = ctrl.setpoint_ms;
+            if (relock_level >= 0) {
+                r.relock_dev_ms = fabs(ctrl.setpoint_ms - relock_level);
+            }
+        }
+        if (r.lock_at_s == 0 && fabs(ppm) > r.ppm_before_lock) {
+            r.ppm_before_lock = fabs(ppm);
+        }
+        if (ctrl.locked) {
+            double dev = fabs(ctrl.level_ms - ctrl.setpoint_ms);
+            if (dev > r.max_dev_ms) r.max_dev_ms = dev;
+            if (end - sink_frames < (int64_t)3600 * RATE && dev > r.last_hour_dev_ms) {
+                r.last_hour_dev_ms = dev;
+            }
+        }
+    }
+
+    r.ppm_at_end = ctrl.ppm;
+    r.integral_at_end = ctrl.integral_ppm;
+    return r;
+}
+
+static void print_result(const sim_case_t *sc, const sim_result_t *r)
+{
+    printf("  %+5.0f ppm %.0f h: lock %.0f s, dev max %.1f ms / last hour %.1f ms, "
+           "level %.0f-%.0f ms, ppm %+.2f (integral %+.2f)\n",
+           sc->skew_ppm, sc->hours, r->lock_at_s, r->max_dev_ms, r->last_hour_dev_ms,
+           r->min_level_ms, r->max_level_ms, r->ppm_at_end, r->integral_at_end);
+}
+
+static void test_skew_converges(void)
+{
+    static const double skews[] = { 50, -50, 120, -120, 200, -200 };
+
+    for (size_t i = 0; i < sizeof(skews) / sizeof(skews[0]); i++) {
+        sim_case_t sc = { .skew_ppm = skews[i], .hours = 4 };
+        sim_result_t r = simulate(&sc);
+        print_result(&sc, &r);
+
+        CHECK_INT(r.underruns, 0);
+        // Punkt pracy dopiero po ASRC_SETTLE_MS, wcześniej bez korekty
+        CHECK_NEAR(r.lock_at_s, ASRC_SETTLE_MS / 1000.0, 0.2);
+        CHECK(r.ppm_before_lock == 0);
+        // Ograniczenie szybkości zmian korekty
+        CHECK(r.max_slew <= ASRC_SLEW_PPM_S * CHECK_MS / 1000.0 + 1e-4);
+
+        // Przed korektą bufor dryfuje o skew * 1e-3 ms/s. Pętla z tłumieniem krytycznym
+        // zatrzymuje go po ok. ASRC_LOOP_TAU_S: odchylenie rzędu skew * tau * 1e-3 ms
+        double drift_ms = fabs(skews[i]) * 1e-3 * ASRC_LOOP_TAU_S;
+        CHECK(r.max_dev_ms < drift_ms);
+        // Chwilowy poziom: do tego wahania od opóźnionych pakietów (do ~150 ms)
+        CHECK(r.min_level_ms > START_LEVEL_MS - drift_ms - 150);
+        CHECK(r.max_level_ms < START_LEVEL_MS + drift_ms + 150);
+        // Po kilku stałych czasowych: korekta = dryf, poziom przy punkcie pracy.
+        // Przy 200 ppm potrzebny zapas ponad dryf (ASRC_MAX_PPM) na człon proporcjonalny.
+        CHECK_NEAR(r.integral_at_end, skews[i], 1.0);
+        CHECK_NEAR(r.ppm_at_end, skews[i], 2.0);
+        CHECK(r.last_hour_dev_ms < 10);
+    }
+}
+
+// Przerwa w danych po ustaleniu korekty: nowy punkt pracy, oszacowany dryf zostaje,
+// więc w czasie ponownego ustalania bufor prawie się nie przesuwa
+static void test_relock_keeps_estimate(void)
+{
+    sim_case_t sc = { .skew_ppm = 150, .hours = 4, .relock_at_h = 3 };
+    sim_result_t r = simulate(&sc);
+    print_result(&sc, &r);
+    printf("  relock: setpoint moved %.1f ms\n", r.relock_dev_ms);
+
+    CHECK_INT(r.underruns, 0);
+    // 30 s z 150 ppm bez korekty to 4.5 ms - z zachowaną korektą dużo mniej
+    // (plus wahania poziomu od pakietów)
+    CHECK(r.relock_dev_ms < 40);
+    CHECK_NEAR(r.integral_at_end, sc.skew_ppm, 1.0);
+    CHECK(r.last_hour_dev_ms < 10);
+}
+
+// Skok poziomu (burst z sieci) nie może przestawić korekty szybciej niż ASRC_SLEW_PPM_S
+static void test_burst_is_slew_limited(void)
+{
+    asrc_ctrl_t ctrl;
+    asrc_ctrl_reset(&ctrl);
+    for (int t = 0; t < ASRC_SETTLE_MS; t += CHECK_MS) {
+        asrc_ctrl_update(&ctrl, 1000, CHECK_MS);
+    }
+    CHECK(ctrl.locked);
+    CHECK_NEAR(ctrl.setpoint_ms, 1000, 0.5);
+
+    float ppm = 0;
+    for (int t = 0; t < 10000; t += CHECK_MS) {
+        ppm = asrc_ctrl_update(&ctrl, 9000, CHECK_MS);
+    }
+    CHECK(ppm <= ASRC_SLEW_PPM_S * 10.0f + 1e-3f);
+    CHECK(ppm > 0);
+
+    // Nasycenie na ASRC_MAX_PPM
+    for (int t = 0; t < 3600 * 1000; t += CHECK_MS) {
+        ppm = asrc_ctrl_update(&ctrl, 60000, CHECK_MS);
+    }
+    CHECK_NEAR(ppm, ASRC_MAX_PPM, 1e-3);
+}
+
+// Resampler: liczba ramek wyjścia zgodna z korektą ppm i stosunkiem częstotliwości
+static void test_resampler_rate(void)
+{
+    static int16_t in[BLOCK_FRAMES * 2], out[(BLOCK_FRAMES * 2 + ASRC_EXTRA_FRAMES) * 2];
+    asrc_t asrc = {0};
+    asrc_reset(&asrc, 2);
+
+    asrc_set_ppm(&asrc, 100);
+    long total = 0, blocks = 2000;
+    for (int b = 0; b < blocks; b++) {
+        total += asrc_process(&asrc, in, BLOCK_FRAMES, out, BLOCK_FRAMES + ASRC_EXTRA_FRAMES);
+    }
+    CHECK_NEAR(total, blocks * BLOCK_FRAMES / (1 + 100e-6), 2);
+
+    CHECK(asrc_set_ratio(&asrc, 48000, 44100, 0));
+    total = 0;
+    for (int b = 0; b < blocks; b++) {
+        total += asrc_process(&asrc, in, BLOCK_FRAMES, out, BLOCK_FRAMES * 2);
+    }
+    CHECK_NEAR(total, blocks * BLOCK_FRAMES * 44100.0 / 48000, 2);
+    CHECK(!asrc_set_ratio(&asrc, 96000, 44100, 0));
+}
+
+// Konwersja częstotliwości dla wyjścia A2DP (bt_tee): bloki po 512 ramek do bufora
+// 2 * 512 + ASRC_EXTRA_FRAMES jak bt_out. Sinus 1 kHz po konwersji porównany z idealnym
+// sinusem w częstotliwości wyjścia; podział na bloki nie zmienia wyniku.
+#define TEE_BLOCK       512
+#define TONE_HZ         1000.0
+#define TONE_AMP        16000.0
+
+static double tone_snr_db(int in_rate, int out_rate, int channels, const int *blocks, int block_count,
+                          long *out_total)
+{
+    static int16_t in[TEE_BLOCK * 2], out[(TEE_BLOCK * 2 + ASRC_EXTRA_FRAMES) * 2];
+    asrc_t asrc = {0};
+    asrc_reset(&asrc, channels);
+    CHECK(asrc_set_ratio(&asrc, in_rate, out_rate, 0));
+
+    long n_in = 0, n_out = 0;
+    double signal = 0, noise = 0;
+    for (int b = 0; b < block_count; b++) {
+        int n = blocks[b];
+        for (int i = 0; i < n; i++, n_in++) {
+            for (int c = 0; c < channels; c++) {
+                in[i * channels + c] = (int16_t)lrint(TONE_AMP * sin(2 * M_PI * TONE_HZ * n_in / in_rate + c));
+            }
+        }
+        int got = asrc_process(&asrc, in, n, out, TEE_BLOCK * 2 + ASRC_EXTRA_FRAMES);
+        CHECK(got <= (int)ceil((double)n * out_rate / in_rate) + ASRC_EXTRA_FRAMES);
+        for (int i = 0; i < got; i++, n_out++) {
+            // Wyjście opóźnione o dwie ramki wejścia (interpolacja między hist[1] a hist[2])
+            double t = (double)n_out / out_rate - 2.0 / in_rate;
+            if (n_out < 8) continue;
+            for (int c = 0; c < channels; c++) {
+                double ref = TONE_AMP * sin(2 * M_PI * TONE_HZ * t + c);
+                double err = out[i * channels + c] - ref;
+                signal += ref * ref;
+                noise += err * err;
+            }
+        }
+    }
+    *out_total = n_out;
+    return 10 * log10(signal / (noise > 0 ? noise : 1e-9));
+}
+
+static void test_resampler_ratio(void)
+{
+    enum { BLOCKS = 400 };
+    static int fixed[BLOCKS], varied[BLOCKS];
+    long frames = 0;
+    srand(3);
+    for (int b = 0; b < BLOCKS; b++) {
+        fixed[b] = TEE_BLOCK;
+        varied[b] = 1 + rand() % TEE_BLOCK;     // Zapisy EQ dowolnej długości
+    }
+
+    static const struct { int in_rate, channels; } cases[] = {
+        { 48000, 2 }, { 32000, 2 }, { 44100, 2 }, { 48000, 1 },
+    };
+    for (size_t k = 0; k < sizeof(cases) / sizeof(cases[0]); k++) {
+        int rate = cases[k].in_rate;
+        char name[32];
+        snprintf(name, sizeof(name), "%d Hz %d ch", rate, cases[k].channels);
+        test_current = name;
+
+        long out_fixed, out_varied;
+        double snr = tone_snr_db(rate, 44100, cases[k].channels, fixed, BLOCKS, &out_fixed);
+        double snr_varied = tone_snr_db(rate, 44100, cases[k].channels, varied, BLOCKS, &out_varied);
+        long in_varied = 0;
+        for (int b = 0; b < BLOCKS; b++) in_varied += varied[b];
+        printf("  %-12s SNR %.1f dB\n", name, snr);
+
+        // Hermite przy 1 kHz: błąd interpolacji w okolicy szumu kwantyzacji 16 bit
+        CHECK(snr > 75.0);
+        CHECK_NEAR(snr_varied, snr, 3.0);
+        CHECK_NEAR(out_fixed, (double)BLOCKS * TEE_BLOCK * 44100 / rate, 2);
+        CHECK_NEAR(out_varied, (double)in_varied * 44100 / rate, 2);
+        frames += out_fixed;
+    }
+    test_current = "test_resampler_ratio";
+
+    // Stosunek z korektą ppm (tryb both): oba składniki w liczbie ramek
+    static int16_t in[TEE_BLOCK * 2], out[(TEE_BLOCK * 2 + ASRC_EXTRA_FRAMES) * 2];
+    asrc_t asrc = {0};
+    asrc_reset(&asrc, 2);
+    CHECK(asrc_set_ratio(&asrc, 48000, 44100, 150));
+    long total = 0;
+    for (int b = 0; b < BLOCKS; b++) {
+        total += asrc_process(&asrc, in, TEE_BLOCK, out, TEE_BLOCK * 2 + ASRC_EXTRA_FRAMES);
+    }
+    CHECK_NEAR(total, (double)BLOCKS * TEE_BLOCK * 44100 / 48000 / (1 + 150e-6), 2);
+
+    // Zakres resamplera: krok wejścia 0.5 - 1.5 (22.05 i 96 kHz poza nim)
+    CHECK(asrc_set_ratio(&asrc, 32000, 44100, 0));
+    CHECK(asrc_set_ratio(&asrc, 64000, 44100, 0));
+    CHECK(!asrc_set_ratio(&asrc, 22050, 44100, 0));
+    CHECK(!asrc_set_ratio(&asrc, 96000, 44100, 0));
+    CHECK(!asrc_set_ratio(&asrc, 0, 44100, 0));
+    CHECK(asrc_set_ratio(&asrc, 44100, 44100, 0));
+    CHECK_INT(asrc.step_delta, 0);
+    CHECK(frames > 0);
+}
+
+int main(void)
+{
+    RUN_TEST(test_resampler_rate);
+    RUN_TEST(test_resampler_ratio);
+    RUN_TEST(test_burst_is_slew_limited);
+    RUN_TEST(test_skew_converges);
+    RUN_TEST(test_relock_keeps_estimate);
+    return TEST_RESULT();
+}
@@ -0,0 +1,211 @@
+/*
+ * audio_settings: presety, balans przez eq_filter, odroczony zapis do NVS
+ */
+
+#include <stdlib.h>
+#include "test_util.h"
+#include "freertos/FreeRTOS.h"
+#include "nvs.h"
+#include "audio_settings.h"
+#include "eq_filter.h"
+#include "host_player.h"
+
+static const int band_freq[EQ_FILTER_BANDS] = {
+    31, 62, 125, 250, 500, 1000, 2000, 4000, 8000, 16000
+};
+
+static audio_element_handle_t eq;
+
+// Nowe współczynniki wchodzą na początku następnego bloku
+static int active_bands(void)
+{
+    int16_t pcm[64 * 2] = {0};
+    host_audio_element_run(eq, pcm, sizeof(pcm), pcm, sizeof(pcm));
+    return eq_filter_get_active_bands(eq);
+}
+
+static double channel_rms(const int16_t *pcm, int frames, int ch)
+{
+    double sum = 0;
+    for (int i = 0; i < frames; i++) {
+        double v = pcm[i * 2 + ch];
+        sum += v * v;
+    }
+    return sqrt(sum / frames);
+}
+
+// Sinus 1 kHz w obu kanałach przez EQ - RMS lewego i prawego na wyjściu
+static void measure_lr(double *left, double *right)
+{
+    enum { FRAMES = 8820 };
+    static int16_t in[FRAMES * 2], out[FRAMES * 2];
+    for (int i = 0; i < FRAMES; i++) {
+        int16_t v = (int16_t)(8000 * sin(2 * M_PI * 1000 * i / 44100.0));
+        in[i * 2] = v;
+        in[i * 2 + 1] = v;
+    }
+    host_audio_element_run(eq, in, sizeof(in), out, sizeof(out));
+    // Druga połowa - po stanie przejściowym filtrów
+    *left = channel_rms(out + FRAMES, FRAMES / 2, 0);
+    *right = channel_rms(out + FRAMES, FRAMES / 2, 1);
+}
+
+static void test_debounced_save(void)
+{
+    int commits = host_nvs_commit_count();
+    CHECK_INT(audio_settings_set_volume(30), ESP_OK);
+    host_freertos_advance_ms(500);
+    CHECK_INT(host_nvs_commit_count(), commits);
+
+    // Każda zmiana przesuwa zapis o pełny czas
+    CHECK_INT(audio_settings_set_volume(40), ESP_OK);
+    host_freertos_advance_ms(600);
+    CHECK_INT(host_nvs_commit_count(), commits);
+    host_freertos_advance_ms(500);
+    CHECK_INT(host_nvs_commit_count(), commits + 1);
+
+    audio_settings_get()->volume = 99;
+    CHECK_INT(audio_settings_load(), ESP_OK);
+    CHECK_INT(audio_settings_get_volume(), 40);
+}
+
+static void test_flush(void)
+{
+    int commits = host_nvs_commit_count();
+    CHECK_INT(audio_settings_set_autostart(true), ESP_OK);
+    CHECK_INT(audio_settings_set_last_url("http://radio/stream"), ESP_OK);
+    CHECK_INT(audio_settings_flush(), ESP_OK);
+    CHECK_INT(host_nvs_commit_count(), commits + 1);
+
+    // Timer zatrzymany - bez drugiego zapisu
+    host_freertos_advance_ms(2000);
+    CHECK_INT(host_nvs_commit_count(), commits + 1);
+    // Nic do zapisania
+    CHECK_INT(audio_settings_flush(), ESP_OK);
+    CHECK_INT(host_nvs_commit_count(), commits + 1);
+
+    audio_settings_get()->autostart = false;
+    audio_settings_get()->last_url[0] = '\0';
+    audio_settings_load();
+    CHECK(audio_settings_get_autostart());
+    CHECK_STR(audio_settings_get_last_url(), "http://radio/stream");
+}
+
+static void test_preset_to_eq(void)
+{
+    CHECK_INT(audio_settings_apply_preset(EQ_PRESET_ROCK), ESP_OK);
+    const int *gains = host_player_eq_gains();
+    CHECK_INT(gains[EQ_BAND_31HZ], 3);
+    CHECK_INT(gains[EQ_BAND_250HZ], -3);
+    CHECK_INT(gains[EQ_BAND_16KHZ], 2);
+    CHECK_INT(active_bands(), EQ_BANDS);
+
+    CHECK_INT(audio_settings_apply_preset(EQ_PRESET_FLAT), ESP_OK);
+    CHECK_INT(active_bands(), 0);
+    CHECK_INT(audio_settings_apply_preset(EQ_PRESET_MAX), ESP_ERR_INVALID_ARG);
+}
+
+static void test_set_band(void)
+{
+    CHECK_INT(audio_settings_set_band(EQ_BAND_1KHZ, 200), ESP_OK);
+    CHECK_INT(audio_settings_get_band(EQ_BAND_1KHZ), EQ_MAX);
+    CHECK_INT(audio_settings_get()->preset, EQ_PRESET_CUSTOM);
+    CHECK_INT(host_player_eq_gains()[EQ_BAND_1KHZ], 12);
+    CHECK_INT(audio_settings_set_band(EQ_BANDS, 12), ESP_ERR_INVALID_ARG);
+    audio_settings_apply_preset(EQ_PRESET_FLAT);
+}
+
+static void test_balance(void)
+{
+    double l, r;
+    CHECK_INT(audio_settings_set_balance(0), ESP_OK);
+    measure_lr(&l, &r);
+    CHECK_NEAR(l / r, 1.0, 0.01);
+
+    // Balans w lewo tłumi prawy kanał (-12 dB we wszystkich pasmach)
+    CHECK_INT(audio_settings_set_balance(-100), ESP_OK);
+    measure_lr(&l, &r);
+    CHECK(r < l * 0.4);
+    CHECK_NEAR(l / 8000 * sqrt(2), 1.0, 0.05);
+
+    // Zmiana pasma przy ustawionym balansie - balans zostaje
+    uint8_t bands[EQ_BANDS];
+    memset(bands, EQ_CENTER, sizeof(bands));
+    CHECK_INT(audio_settings_set_all_bands(bands), ESP_OK);
+    measure_lr(&l, &r);
+    CHECK(r < l * 0.4);
+    CHECK_INT(audio_settings_set_band(EQ_BAND_1KHZ, EQ_CENTER + 2), ESP_OK);
+    measure_lr(&l, &r);
+    CHECK(r < l * 0.4);
+    CHECK_INT(audio_settings_set_band(EQ_BAND_1KHZ, EQ_CENTER), ESP_OK);
+
+    CHECK_INT(audio_settings_set_balance(100), ESP_OK);
+    measure_lr(&l, &r);
+    CHECK(l < r * 0.4);
+
+    CHECK_INT(audio_settings_set_balance(0), ESP_OK);
+    measure_lr(&l, &r);
+    CHECK_NEAR(l / r, 1.0, 0.01);
+}
+
+static void test_custom_presets(void)
+{
+    audio_settings_apply_preset(EQ_PRESET_VOCAL);
+    CHECK_INT(audio_settings_save_custom_preset(1, "Podcast z bardzo długą nazwą"), ESP_OK);
+    const custom_preset_t *cp = audio_settings_get_custom_preset(1);
+    CHECK(cp->used);
+    CHECK_INT(strlen(cp->name), CUSTOM_PRESET_NAME_LEN - 1);
+
+    audio_settings_apply_preset(EQ_PRESET_FLAT);
+    CHECK_INT(audio_settings_load_custom_preset(1), ESP_OK);
+    CHECK_INT(audio_settings_get_band(EQ_BAND_500HZ), 16);
+    CHECK_INT(audio_settings_get()->custom_preset, 1);
+
+    // Presety przeżywają restart (zapis odroczony + load)
+    host_freertos_advance_ms(1100);
+    audio_settings_get()->custom_presets[1].used = false;
+    audio_settings_load();
+    CHECK(audio_settings_get_custom_preset(1)->used);
+
+    CHECK_INT(audio_settings_delete_custom_preset(1), ESP_OK);
+    CHECK_INT(audio_settings_get()->custom_preset, -1);
+    CHECK_INT(audio_settings_load_custom_preset(1), ESP_ERR_NOT_FOUND);
+    CHECK_INT(audio_settings_load_custom_preset(CUSTOM_PRESETS_MAX), ESP_ERR_INVALID_ARG);
+    CHECK(audio_settings_get_custom_preset(CUSTOM_PRESETS_MAX) == NULL);
+}
+
+static void test_reset(void)
+{
+    audio_settings_apply_preset(EQ_PRESET_BASS_BOOST);
+    audio_settings_set_balance(50);
+    CHECK_INT(audio_settings_reset(), ESP_OK);
+    CHECK_INT(audio_settings_get_band(EQ_BAND_31HZ), EQ_CENTER);
+    CHECK_INT(audio_settings_get()->balance, 0);
+    CHECK_INT(active_bands(), 0);
+    host_freertos_advance_ms(1100);
+}
+
+int main(void)
+{
+    host_nvs_reset();
+    host_player_reset();
+
+    eq_filter_cfg_t cfg = DEFAULT_EQ_FILTER_CONFIG();
+    cfg.band_freq = band_freq;
+    eq = eq_filter_init(&cfg);
+    CHECK(eq != NULL);
+    host_player_set_equalizer(eq);
+
+    CHECK_INT(audio_settings_init(), ESP_OK);
+
+    RUN_TEST(test_debounced_save);
+    RUN_TEST(test_flush);
+    RUN_TEST(test_preset_to_eq);
+    RUN_TEST(test_set_band);
+    RUN_TEST(test_balance);
+    RUN_TEST(test_custom_presets);
+    RUN_TEST(test_reset);
+
+    audio_element_deinit(eq);
+    return TEST_RESULT();
+}
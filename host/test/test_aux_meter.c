@@ -0,0 +1,210 @@
+/*
+ * aux_meter: wzmocnienie w miejscu, RMS/szczyt w oknach pomiarowych i bramka sygnału
+ * wejścia AUX (atak, histereza, zwolnienie po ciszy)
+ */
+
+#include <stdint.h>
+#include "test_util.h"
+#include "aux_meter.h"
+
+#define RATE            44100
+#define BLOCK_FRAMES    256                 // Odczyt czytnika I2S
+
+// Sinus 1 kHz stereo o amplitudzie amp, ciągły między blokami
+static void sine_block(int16_t *pcm, int frames, double amp, long *phase)
+{
+    for (int i = 0; i < frames; i++, (*phase)++) {
+        int16_t v = (int16_t)lround(amp * sin(2.0 * M_PI * 1000.0 * *phase / RATE));
+        pcm[2 * i] = v;
+        pcm[2 * i + 1] = v;
+    }
+}
+
+// Okno pomiarowe: dokładnie AUX_METER_WINDOW_MS, RMS sinusa 3 dB pod szczytem
+static void test_window_levels(void)
+{
+    aux_meter_t m;
+    aux_meter_init(&m);
+    int16_t pcm[BLOCK_FRAMES * 2];
+    long phase = 0;
+    const long window_frames = RATE * AUX_METER_WINDOW_MS / 1000;
+
+    long frames = 0;
+    while (1) {
+        sine_block(pcm, BLOCK_FRAMES, 16384, &phase);
+        frames += BLOCK_FRAMES;
+        if (aux_meter_process(&m, pcm, BLOCK_FRAMES * 2)) break;
+    }
+    // Okno zamyka pierwszy blok, który dobija do jego długości
+    CHECK(frames >= window_frames && frames < window_frames + BLOCK_FRAMES);
+    CHECK_INT(m.windows, 1);
+    CHECK_NEAR(m.peak_db, -6.02, 0.05);
+    CHECK_NEAR(m.rms_db, -6.02 - 3.01, 0.05);
+    CHECK_INT(m.clipped, 0);
+    CHECK_INT(m.count, 0);
+
+    // Cisza cyfrowa - podłoga, nie -inf
+    memset(pcm, 0, sizeof(pcm));
+    while (!aux_meter_process(&m, pcm, BLOCK_FRAMES * 2)) {}
+    CHECK_NEAR(m.rms_db, AUX_METER_FLOOR_DB, 0.001);
+    CHECK_NEAR(m.peak_db, AUX_METER_FLOOR_DB, 0.001);
+
+    // Pełna skala ujemna: szczyt 0 dBFS
+    for (int i = 0; i < BLOCK_FRAMES * 2; i++) pcm[i] = -32768;
+    while (!aux_meter_process(&m, pcm, BLOCK_FRAMES * 2)) {}
+    CHECK_NEAR(m.peak_db, 0.0, 0.001);
+    CHECK_NEAR(m.rms_db, 0.0, 0.001);
+
+    // Zmiana formatu: okno z liczby kanałów i częstotliwości, bieżące okno od nowa
+    aux_meter_set_format(&m, 48000, 1);
+    CHECK_INT(m.window_samples, 48000 * AUX_METER_WINDOW_MS / 1000);
+    CHECK_INT(m.count, 0);
+    aux_meter_set_format(&m, 0, 0);
+    CHECK_INT(m.window_samples, 44100 * 2 * AUX_METER_WINDOW_MS / 1000);
+}
+
+// Wzmocnienie Q12: jedność bez zmian próbek, +6 dB podwaja z nasyceniem, -6 dB połowa
+static void test_gain(void)
+{
+    aux_meter_t m;
+    aux_meter_init(&m);
+    int16_t pcm[8] = { 0, 1, -1, 1000, -1000, 20000, -20000, 32767 };
+    int16_t copy[8];
+    memcpy(copy, pcm, sizeof(pcm));
+
+    aux_meter_set_gain_db(&m, 0.0f);
+    CHECK_INT(m.gain_q12, AUX_GAIN_Q12_UNITY);
+    aux_meter_process(&m, pcm, 8);
+    CHECK(memcmp(pcm, copy, sizeof(pcm)) == 0);
+
+    aux_meter_set_gain_db(&m, 6.0206f);
+    CHECK_NEAR(m.gain_q12, 2 * AUX_GAIN_Q12_UNITY, 1);
+    aux_meter_process(&m, pcm, 8);
+    CHECK_INT(pcm[3], 2000);
+    CHECK_INT(pcm[4], -2000);
+    CHECK_INT(pcm[5], 32767);
+    CHECK_INT(pcm[6], -32768);
+    CHECK_INT(pcm[7], 32767);
+    CHECK_INT(m.clipped, 3);
+    CHECK_INT(m.peak, 32768);
+
+    memcpy(pcm, copy, sizeof(pcm));
+    aux_meter_set_gain_db(&m, -6.0206f);
+    aux_meter_process(&m, pcm, 8);
+    CHECK_INT(pcm[1], 1);               // Zaokrąglenie do najbliższej
+    CHECK_INT(pcm[3], 500);
+    CHECK_INT(pcm[4], -500);
+    CHECK_INT(pcm[7], 16384);
+    CHECK_INT(m.clipped, 3);
+
+    // Wzmocniony sygnał mierzony po wzmocnieniu
+    aux_meter_t g;
+    aux_meter_init(&g);
+    aux_meter_set_gain_db(&g, 12.0f);
+    int16_t block[BLOCK_FRAMES * 2];
+    long phase = 0;
+    do {
+        sine_block(block, BLOCK_FRAMES, 1000, &phase);
+    } while (!aux_meter_process(&g, block, BLOCK_FRAMES * 2));
+    CHECK_NEAR(g.rms_db, 20.0 * log10(1000.0 / 32768.0) - 3.01 + 12.0, 0.1);
+}
+
+static void test_level_percent(void)
+{
+    CHECK_INT(aux_meter_level_percent(AUX_METER_FLOOR_DB), 0);
+    CHECK_INT(aux_meter_level_percent(-60.0f), 0);
+    CHECK_INT(aux_meter_level_percent(-30.0f), 50);
+    CHECK_INT(aux_meter_level_percent(-0.1f), 99);
+    CHECK_INT(aux_meter_level_percent(0.0f), 100);
+    CHECK_INT(aux_meter_level_percent(6.0f), 100);
+}
+
+// Bramka: atak tylko przy ciągłym sygnale, zwolnienie po silence_ms poniżej histerezy
+static void test_gate(void)
+{
+    const uint32_t dt = AUX_METER_WINDOW_MS;
+    aux_gate_t g;
+    aux_gate_init(&g, -40.0f, 1000);
+
+    // Trzaski wtyku: pojedyncze okna głośne, przeplatane ciszą
+    for (int i = 0; i < 50; i++) {
+        CHECK_INT(aux_gate_update(&g, i % 3 == 0 ? -10.0f : -70.0f, dt), AUX_GATE_NONE);
+    }
+    CHECK(!g.open);
+
+    // Ciągły sygnał: otwarcie po AUX_GATE_ATTACK_MS
+    uint32_t t = 0;
+    aux_gate_event_t ev;
+    while ((ev = aux_gate_update(&g, -40.0f, dt)) == AUX_GATE_NONE) t += dt;
+    t += dt;
+    CHECK_INT(ev, AUX_GATE_OPEN);
+    CHECK_INT(t, AUX_GATE_ATTACK_MS);
+    CHECK(g.open);
+
+    // Cichy fragment w strefie histerezy nie zamyka
+    for (int i = 0; i < 100; i++) {
+        CHECK_INT(aux_gate_update(&g, -40.0f - AUX_GATE_HYSTERESIS_DB + 0.5f, dt), AUX_GATE_NONE);
+    }
+    // Cisza przerwana jednym oknem sygnału liczy się od nowa
+    for (int i = 0; i < 15; i++) aux_gate_update(&g, -80.0f, dt);
+    aux_gate_update(&g, -30.0f, dt);
+    CHECK_INT(g.below_ms, 0);
+
+    t = 0;
+    while ((ev = aux_gate_update(&g, -80.0f, dt)) == AUX_GATE_NONE) t += dt;
+    t += dt;
+    CHECK_INT(ev, AUX_GATE_CLOSE);
+    CHECK_INT(t, 1000);
+    CHECK(!g.open);
+
+    // Reset po zmianie źródła: atak od zera
+    aux_gate_update(&g, -20.0f, dt);
+    CHECK_INT(g.above_ms, dt);
+    aux_gate_reset(&g);
+    CHECK_INT(g.above_ms, 0);
+    CHECK(!g.open);
+
+    // Próg zmieniony w trakcie (ustawienia z UI) - obowiązuje od następnego okna
+    g.threshold_db = -20.0f;
+    for (int i = 0; i < 20; i++) {
+        CHECK_INT(aux_gate_update(&g, -30.0f, dt), AUX_GATE_NONE);
+    }
+}
+
+// Pełny tor: sinus z ciszą przed i po, bramka na oknach z miernika
+static void test_meter_drives_gate(void)
+{
+    aux_meter_t m;
+    aux_meter_init(&m);
+    aux_gate_t g;
+    aux_gate_init(&g, -40.0f, 3000);
+    int16_t pcm[BLOCK_FRAMES * 2];
+    long phase = 0;
+    double opened = -1, closed = -1;
+
+    for (long frames = 0; frames < RATE * 10L; frames += BLOCK_FRAMES) {
+        double t = (double)frames / RATE;
+        sine_block(pcm, BLOCK_FRAMES, t >= 1.0 && t < 4.0 ? 3000 : 20, &phase);
+        if (!aux_meter_process(&m, pcm, BLOCK_FRAMES * 2)) continue;
+        aux_gate_event_t ev = aux_gate_update(&g, m.rms_db, AUX_METER_WINDOW_MS);
+        if (ev == AUX_GATE_OPEN) opened = t;
+        if (ev == AUX_GATE_CLOSE) closed = t;
+    }
+    printf("  open at %.2f s, close at %.2f s\n", opened, closed);
+    // Okno zamyka się na granicy bloku: 9 bloków po 256 ramek = 52.2 ms liczone jako 50 ms
+    const long window_frames = RATE * AUX_METER_WINDOW_MS / 1000;
+    const double window_s = (double)((window_frames + BLOCK_FRAMES - 1) / BLOCK_FRAMES * BLOCK_FRAMES) / RATE;
+    const double scale = window_s * 1000.0 / AUX_METER_WINDOW_MS;
+    CHECK_NEAR(opened, 1.0 + AUX_GATE_ATTACK_MS / 1000.0 * scale, window_s);
+    CHECK_NEAR(closed, 4.0 + 3.0 * scale, window_s);
+}
+
+int main(void)
+{
+    RUN_TEST(test_window_levels);
+    RUN_TEST(test_gain);
+    RUN_TEST(test_level_percent);
+    RUN_TEST(test_gate);
+    RUN_TEST(test_meter_drives_gate);
+    return TEST_RESULT();
+}
@@ -0,0 +1,170 @@
+/*
+ * bt_pacing: głośnik A2DP pobiera po 512 bajtów (~2.9 ms) w swoim takcie, odtwarzacz pisze
+ * paczkami po 2048 bajtów w takcie I2S rozjechanym o 0-150 ppm, spowolnionym o korektę
+ * regulatora. Przez 10 minut czasu symulacji bufor ma zbiec do pre-rollu bez przerw.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "test_util.h"
+#include "bt_pacing.h"
+
+#define BPMS            BT_PACING_BYTES_PER_MS
+#define CB_BYTES        512                 // Callback danych A2DP
+#define BURST_BYTES     2048                // Blok odtwarzacza
+#define RING_BYTES      (16 * 1024)         // BT_SOURCE_RINGBUF_SIZE
+#define PREROLL_MS      40
+
+typedef struct {
+    double level_ms;                // Uśrednione zapełnienie na końcu
+    double ppm;
+    double min_ms, max_ms;          // Chwilowe zapełnienie po ustaleniu (ostatnie 5 minut)
+    uint32_t underruns;             // Callbacki bez pełnego PCM po pre-rollu
+    uint32_t overflows;             // Zapisy odrzucone przez pełny bufor
+} pace_result_t;
+
+// Producent: paczka co 4 callbacki, tempo (1 + drift)(1 - ppm). Bufor to sam licznik bajtów.
+static void simulate(double drift_ppm, double seconds, pace_result_t *r)
+{
+    bt_pacing_t p;
+    bt_pacing_init(&p, PREROLL_MS);
+    bt_pacing_start_preroll(&p);
+    memset(r, 0, sizeof(*r));
+    r->min_ms = 1e9;
+
+    size_t ring = 0;
+    double owed = 0;                // Ułamek ramki producenta przeniesiony na następną paczkę
+    long steps = (long)(seconds * 1000.0 * BPMS / CB_BYTES);
+    for (long i = 0; i < steps; i++) {
+        if (i % 4 == 0) {
+            owed += BURST_BYTES * (1.0 + drift_ppm * 1e-6) * (1.0 - p.ppm * 1e-6);
+            size_t n = (size_t)(owed / 4) * 4;
+            owed -= n;
+            if (ring + n > RING_BYTES) {
+                r->overflows++;
+                n = RING_BYTES - ring;
+            }
+            ring += n;
+            bt_pacing_written(&p, ring);
+        }
+        if (p.prerolling) continue;         // Głośnik dostaje ciszę, bufor się nie zmienia
+
+        size_t got = ring < CB_BYTES ? ring : CB_BYTES;
+        ring -= got;
+        bt_pacing_result_t res = bt_pacing_callback(&p, CB_BYTES, got, ring);
+        if (res != BT_PACING_FULL) r->underruns++;
+        if (i > steps / 2) {
+            double ms = (double)ring / BPMS;
+            if (ms < r->min_ms) r->min_ms = ms;
+            if (ms > r->max_ms) r->max_ms = ms;
+        }
+    }
+    r->level_ms = p.level_ms;
+    r->ppm = p.ppm;
+    printf("  drift %+5.0f ppm: level %5.1f ms, ppm %+6.1f, fill %4.1f..%4.1f ms, "
+           "underrun %u overflow %u\n", drift_ppm, r->level_ms, r->ppm, r->min_ms, r->max_ms,
+           r->underruns, r->overflows);
+}
+
+// Punkt pracy: pre-roll, korekta = różnica zegarów, bez przerw i przepełnień
+static void test_converges_to_preroll(void)
+{
+    static const double DRIFTS[] = { 0, 80, -80, 150, -150 };
+    for (size_t c = 0; c < sizeof(DRIFTS) / sizeof(DRIFTS[0]); c++) {
+        pace_result_t r;
+        simulate(DRIFTS[c], 600, &r);
+        CHECK_NEAR(r.level_ms, PREROLL_MS, 1.0);
+        CHECK_NEAR(r.ppm, DRIFTS[c], 10.0);
+        CHECK_INT(r.underruns, 0);
+        CHECK_INT(r.overflows, 0);
+        // Opóźnienie ograniczone: pre-roll +- paczka producenta
+        CHECK(r.min_ms > PREROLL_MS - 2.0 * BURST_BYTES / BPMS);
+        CHECK(r.max_ms < PREROLL_MS + 2.0 * BURST_BYTES / BPMS);
+    }
+}
+
+// Różnica ponad zakres korekty: regulator w nasyceniu, nadmiar (200 ppm) zbiera się w buforze
+static void test_saturates(void)
+{
+    pace_result_t r;
+    simulate(400, 60, &r);
+    CHECK_NEAR(r.ppm, BT_PACING_MAX_PPM, 0.01);
+    CHECK(r.level_ms > PREROLL_MS + 5);
+    CHECK_INT(r.underruns, 0);
+}
+
+// Pre-roll kończy dokładnie zapis, który doprowadził bufor do progu - jeden raz
+static void test_preroll(void)
+{
+    bt_pacing_t p;
+    bt_pacing_init(&p, PREROLL_MS);
+    CHECK(!p.prerolling);
+    CHECK(!bt_pacing_written(&p, RING_BYTES));
+
+    bt_pacing_start_preroll(&p);
+    CHECK(p.prerolling);
+    CHECK(!bt_pacing_written(&p, PREROLL_MS * BPMS - 4));
+    CHECK(bt_pacing_written(&p, PREROLL_MS * BPMS));
+    CHECK(!p.prerolling);
+    CHECK(!bt_pacing_written(&p, PREROLL_MS * BPMS + 4));
+}
+
+// Klasyfikacja callbacków i ponowny pre-roll po BT_PACING_STARVE_MS samej ciszy
+static void test_starvation(void)
+{
+    bt_pacing_t p;
+    bt_pacing_init(&p, PREROLL_MS);
+    CHECK_INT(bt_pacing_callback(&p, CB_BYTES, CB_BYTES, 4096), BT_PACING_FULL);
+    CHECK_INT(bt_pacing_callback(&p, CB_BYTES, 100, 0), BT_PACING_PARTIAL);
+    CHECK_INT(p.starve_bytes, CB_BYTES - 100);
+
+    // Pojedyncze przerwy przeplatane danymi nie sumują się
+    for (int i = 0; i < 100; i++) {
+        CHECK_INT(bt_pacing_callback(&p, CB_BYTES, 0, 0), BT_PACING_EMPTY);
+        CHECK_INT(bt_pacing_callback(&p, CB_BYTES, CB_BYTES, 0), BT_PACING_FULL);
+    }
+    CHECK_INT(p.starve_bytes, 0);
+
+    // Ciągła cisza: EMPTY do 100 ms, potem STARVED i pre-roll z poziomem i korektą od nowa
+    int empty = 0;
+    bt_pacing_result_t res;
+    while ((res = bt_pacing_callback(&p, CB_BYTES, 0, 0)) == BT_PACING_EMPTY) {
+        empty++;
+    }
+    CHECK_INT(res, BT_PACING_STARVED);
+    CHECK_INT(empty, (BT_PACING_STARVE_MS * BPMS + CB_BYTES - 1) / CB_BYTES - 1);
+    CHECK(p.prerolling);
+    CHECK_NEAR(p.level_ms, PREROLL_MS, 0.001);
+    CHECK_NEAR(p.ppm, 0, 0.001);
+    CHECK_INT(p.starve_bytes, 0);
+}
+
+// Oszacowanie różnicy zegarów przeżywa pre-roll, ale nie zmianę głośnika
+static void test_new_clock(void)
+{
+    bt_pacing_t p;
+    bt_pacing_init(&p, PREROLL_MS);
+    // Bufor stale ponad pre-rollem - rośnie całka
+    for (int i = 0; i < 20000; i++) {
+        bt_pacing_callback(&p, CB_BYTES, CB_BYTES, (PREROLL_MS + 5) * BPMS);
+    }
+    CHECK(p.integral > 50);
+    float integral = p.integral;
+    bt_pacing_start_preroll(&p);
+    CHECK_NEAR(p.integral, integral, 0.001);
+    CHECK_NEAR(p.ppm, 0, 0.001);
+
+    bt_pacing_new_clock(&p);
+    CHECK_NEAR(p.integral, 0, 0.001);
+    CHECK_NEAR(p.ppm, 0, 0.001);
+}
+
+int main(void)
+{
+    RUN_TEST(test_converges_to_preroll);
+    RUN_TEST(test_saturates);
+    RUN_TEST(test_preroll);
+    RUN_TEST(test_starvation);
+    RUN_TEST(test_new_clock);
+    return TEST_RESULT();
+}
@@ -0,0 +1,181 @@
+/*
+ * bt_sink_cache: zapamiętane głośniki - kolejność ponownych połączeń, wypieranie
+ * najdawniej używanego, usuwanie, blob z NVS (inna wersja, uszkodzone pola)
+ */
+
+#include <stdint.h>
+#include "test_util.h"
+#include "bt_sink_cache.h"
+
+static void bda_of(uint8_t *bda, int n)
+{
+    static const uint8_t BASE[6] = { 0x00, 0x1A, 0x7D, 0xDA, 0x71, 0x00 };
+    memcpy(bda, BASE, 6);
+    bda[5] = (uint8_t)n;
+}
+
+static int recent_no(const bt_sink_cache_t *c, int n)
+{
+    const bt_sink_cache_entry_t *e = bt_sink_cache_nth_recent(c, n);
+    return e ? e->bda[5] : -1;
+}
+
+// Kolejność prób połączenia: od ostatnio używanego, ponowne połączenie przesuwa na początek
+static void test_recent_order(void)
+{
+    bt_sink_cache_t c;
+    bt_sink_cache_init(&c);
+    CHECK(bt_sink_cache_nth_recent(&c, 0) == NULL);
+
+    uint8_t bda[6];
+    for (int i = 1; i <= 4; i++) {
+        bda_of(bda, i);
+        char name[16];
+        snprintf(name, sizeof(name), "Speaker %d", i);
+        bt_sink_cache_touch(&c, bda, name);
+    }
+    CHECK_INT(c.count, 4);
+    for (int n = 0; n < 4; n++) {
+        CHECK_INT(recent_no(&c, n), 4 - n);
+    }
+    CHECK_INT(recent_no(&c, 4), -1);
+
+    // Znany głośnik: bez nowego wpisu, nazwa zostaje, gdy nie podano nowej
+    bda_of(bda, 2);
+    bt_sink_cache_entry_t *e = bt_sink_cache_touch(&c, bda, NULL);
+    CHECK_INT(c.count, 4);
+    CHECK_STR(e->name, "Speaker 2");
+    CHECK_INT(recent_no(&c, 0), 2);
+    CHECK_INT(recent_no(&c, 1), 4);
+    CHECK_INT(recent_no(&c, 3), 1);
+
+    // Pusta nazwa też nie nadpisuje, nowa - tak (obcięta do bufora)
+    bt_sink_cache_touch(&c, bda, "");
+    CHECK_STR(e->name, "Speaker 2");
+    char long_name[100];
+    memset(long_name, 'x', sizeof(long_name) - 1);
+    long_name[sizeof(long_name) - 1] = '\0';
+    bt_sink_cache_touch(&c, bda, long_name);
+    CHECK_INT(strlen(e->name), BT_SINK_CACHE_NAME_LEN - 1);
+
+    // Kodek i RSSI zapisane przez bluetooth_source.c przeżywają ponowne połączenie
+    e->sample_rate = 44100;
+    e->channels = 2;
+    e->rssi = -61;
+    bt_sink_cache_touch(&c, bda, "Speaker 2");
+    CHECK_INT(e->sample_rate, 44100);
+    CHECK_INT(e->rssi, -61);
+}
+
+// Pełna tablica: nowy głośnik wypiera najdawniej używany, nie pierwszy dodany
+static void test_eviction(void)
+{
+    bt_sink_cache_t c;
+    bt_sink_cache_init(&c);
+    uint8_t bda[6];
+    for (int i = 1; i <= BT_SINK_CACHE_MAX; i++) {
+        bda_of(bda, i);
+        bt_sink_cache_touch(&c, bda, "s");
+    }
+    bda_of(bda, 1);
+    bt_sink_cache_touch(&c, bda, NULL);         // 1 najnowszy, 2 najstarszy
+
+    bda_of(bda, 100);
+    bt_sink_cache_entry_t *e = bt_sink_cache_touch(&c, bda, "new");
+    CHECK_INT(c.count, BT_SINK_CACHE_MAX);
+    CHECK_STR(e->name, "new");
+    CHECK_INT(e->sample_rate, 0);               // Wpis po wypartym wyzerowany
+    bda_of(bda, 2);
+    CHECK(bt_sink_cache_find(&c, bda) == NULL);
+    bda_of(bda, 1);
+    CHECK(bt_sink_cache_find(&c, bda) != NULL);
+    CHECK_INT(recent_no(&c, 0), 100);
+    CHECK_INT(recent_no(&c, 1), 1);
+    CHECK_INT(recent_no(&c, BT_SINK_CACHE_MAX - 1), 3);
+    CHECK_INT(recent_no(&c, BT_SINK_CACHE_MAX), -1);
+
+    // Długa seria połączeń: zawsze zostaje 8 ostatnich
+    for (int i = 0; i < 1000; i++) {
+        bda_of(bda, 10 + i % 20);
+        bt_sink_cache_touch(&c, bda, NULL);
+    }
+    CHECK_INT(c.count, BT_SINK_CACHE_MAX);
+    for (int n = 0; n < BT_SINK_CACHE_MAX; n++) {
+        CHECK_INT(recent_no(&c, n), 10 + (999 - n) % 20);
+    }
+}
+
+static void test_remove(void)
+{
+    bt_sink_cache_t c;
+    bt_sink_cache_init(&c);
+    uint8_t bda[6];
+    for (int i = 1; i <= 5; i++) {
+        bda_of(bda, i);
+        bt_sink_cache_touch(&c, bda, "s");
+    }
+    bda_of(bda, 2);
+    CHECK(bt_sink_cache_remove(&c, bda));
+    CHECK(!bt_sink_cache_remove(&c, bda));
+    CHECK_INT(c.count, 4);
+    CHECK(bt_sink_cache_find(&c, bda) == NULL);
+    CHECK_INT(recent_no(&c, 0), 5);
+    CHECK_INT(recent_no(&c, 2), 3);
+    CHECK_INT(recent_no(&c, 3), 1);
+    // Zwolnione miejsce wyzerowane - blob w NVS bez śmieci
+    static const bt_sink_cache_entry_t zero;
+    CHECK(memcmp(&c.entries[4], &zero, sizeof(zero)) == 0);
+
+    for (int i = 1; i <= 5; i++) {
+        bda_of(bda, i);
+        bt_sink_cache_remove(&c, bda);
+    }
+    CHECK_INT(c.count, 0);
+    CHECK(bt_sink_cache_nth_recent(&c, 0) == NULL);
+}
+
+// Blob odczytany z NVS: odtworzenie licznika, obcięcie nazw, odrzucenie obcej wersji
+static void test_blob(void)
+{
+    bt_sink_cache_t c;
+    bt_sink_cache_init(&c);
+    uint8_t bda[6];
+    for (int i = 1; i <= 3; i++) {
+        bda_of(bda, i);
+        bt_sink_cache_touch(&c, bda, "s");
+    }
+
+    uint8_t blob[sizeof(c)];
+    memcpy(blob, &c, sizeof(c));
+    bt_sink_cache_t loaded;
+    memcpy(&loaded, blob, sizeof(loaded));
+    loaded.seq = 0;                             // Licznik odtwarzany z wpisów
+    memset(loaded.entries[1].name, 'y', BT_SINK_CACHE_NAME_LEN);
+    CHECK(bt_sink_cache_validate(&loaded));
+    CHECK_INT(loaded.seq, c.seq);
+    CHECK_INT(strlen(loaded.entries[1].name), BT_SINK_CACHE_NAME_LEN - 1);
+    bda_of(bda, 4);
+    bt_sink_cache_touch(&loaded, bda, NULL);    // Nowe połączenie nadal najnowsze
+    CHECK_INT(recent_no(&loaded, 0), 4);
+    CHECK_INT(recent_no(&loaded, 1), 3);
+
+    memcpy(&loaded, blob, sizeof(loaded));
+    loaded.version = BT_SINK_CACHE_VERSION + 1;
+    CHECK(!bt_sink_cache_validate(&loaded));
+    CHECK_INT(loaded.count, 0);
+    CHECK_INT(loaded.version, BT_SINK_CACHE_VERSION);
+
+    memcpy(&loaded, blob, sizeof(loaded));
+    loaded.count = BT_SINK_CACHE_MAX + 1;
+    CHECK(!bt_sink_cache_validate(&loaded));
+    CHECK_INT(loaded.count, 0);
+}
+
+int main(void)
+{
+    RUN_TEST(test_recent_order);
+    RUN_TEST(test_eviction);
+    RUN_TEST(test_remove);
+    RUN_TEST(test_blob);
+    return TEST_RESULT();
+}
@@ -0,0 +1,165 @@
+/*
+ * codec_detect: tablica próbek z fixtures/codec (make_fixtures.py) odtwarzanych jak
+ * pierwsze odczyty http_stream - od 7 bajtów do całego pliku
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "test_util.h"
+#include "codec_detect.h"
+
+#define FIXTURE_MAX     16384
+
+typedef struct {
+    const char *file;
+    esp_codec_type_t codec;         // Wynik dla całego pliku
+    int offset;
+    int sample_rate;
+    int channels;
+    int bitrate_kbps;
+    int frame_len;
+    int decided_by;                 // Od tej długości odczytu wynik musi już być znany
+} probe_case_t;
+
+static const probe_case_t PROBE_CASES[] = {
+    { "mp3_cbr128.bin",     ESP_CODEC_TYPE_MP3,    0, 44100, 2, 128, 417,  7 },
+    // Tag ID3 z fałszywymi nagłówkami MP3 w treści
+    { "mp3_id3.bin",        ESP_CODEC_TYPE_MP3, 1024, 44100, 2, 128, 417, 1031 },
+    { "mp3_id3_footer.bin", ESP_CODEC_TYPE_MP3,  522, 48000, 2, 192, 576, 529 },
+    { "mp3_mpeg2_mono.bin", ESP_CODEC_TYPE_MP3,    0, 22050, 1,  64, 208,  7 },
+    { "adts_lc.bin",        ESP_CODEC_TYPE_AAC,    0, 44100, 2, 127, 371,  7 },
+    { "adts_crc.bin",       ESP_CODEC_TYPE_AAC,    0, 48000, 2,  96, 256,  7 },
+    // HE-AAC: nagłówek ADTS rdzenia LC (połowa częstotliwości, SBR niejawny)
+    { "adts_he.bin",        ESP_CODEC_TYPE_AAC,    0, 24000, 2,  48, 256,  7 },
+    { "adts_he_mono.bin",   ESP_CODEC_TYPE_AAC,    0, 22050, 1,  31, 185,  7 },
+    { "mp4_ftyp.bin",       ESP_CODEC_TYPE_M4A,    0,     0, 0,   0,   0,  8 },
+    // Fragmentowany MP4 (HLS/DASH) zaczyna się od 'styp'
+    { "fmp4_styp.bin",      ESP_CODEC_TYPE_M4A,    0,     0, 0,   0,   0,  8 },
+    // Śmieci przed synchronizacją (z nagłówkami bez następnej ramki) - potrzebne dwie ramki
+    { "junk_mp3.bin",       ESP_CODEC_TYPE_MP3, 1000, 44100, 2, 128, 417, 1000 + 417 + 7 },
+    { "junk_adts.bin",      ESP_CODEC_TYPE_AAC,  700, 44100, 2, 127, 371, 700 + 371 + 7 },
+    { "junk_only.bin",      ESP_CODEC_TYPE_UNKNOW, 0, 0, 0, 0, 0, 0 },
+};
+
+static int load_fixture(const char *name, uint8_t *buf)
+{
+    char path[128];
+    snprintf(path, sizeof(path), "fixtures/codec/%s", name);
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        fprintf(stderr, "missing fixture %s\n", path);
+        return -1;
+    }
+    int len = (int)fread(buf, 1, FIXTURE_MAX, f);
+    fclose(f);
+    return len;
+}
+
+static void test_probe_table(void)
+{
+    static uint8_t buf[FIXTURE_MAX];
+    static const int reads[] = { 0, 7, 16, 64, 512, 1024, 2048, 4096 };
+
+    for (size_t c = 0; c < sizeof(PROBE_CASES) / sizeof(PROBE_CASES[0]); c++) {
+        const probe_case_t *pc = &PROBE_CASES[c];
+        int len = load_fixture(pc->file, buf);
+        CHECK(len > 0);
+        if (len <= 0) continue;
+        test_current = pc->file;
+
+        codec_frame_info_t info = {0};
+        CHECK_INT(codec_detect_probe(buf, len, &info), pc->codec);
+        CHECK_INT(info.offset, pc->offset);
+        CHECK_INT(info.sample_rate, pc->sample_rate);
+        CHECK_INT(info.channels, pc->channels);
+        CHECK_INT(info.bitrate_kbps, pc->bitrate_kbps);
+        CHECK_INT(info.frame_len, pc->frame_len);
+
+        // Krótszy pierwszy odczyt: wynik nieznany albo ten sam - nigdy inny kodek
+        for (size_t r = 0; r < sizeof(reads) / sizeof(reads[0]); r++) {
+            int n = reads[r] < len ? reads[r] : len;
+            esp_codec_type_t got = codec_detect_probe(buf, n, NULL);
+            CHECK(got == pc->codec || got == ESP_CODEC_TYPE_UNKNOW);
+        }
+        for (int n = 0; n <= len; n++) {
+            esp_codec_type_t got = codec_detect_probe(buf, n, NULL);
+            if (got != pc->codec && got != ESP_CODEC_TYPE_UNKNOW) {
+                fprintf(stderr, "%s: %d bytes -> %s\n", pc->file, n, codec_detect_name(got));
+                CHECK(false);
+                break;
+            }
+            if (n >= pc->decided_by && pc->codec != ESP_CODEC_TYPE_UNKNOW && got != pc->codec) {
+                fprintf(stderr, "%s: %d bytes -> not decided\n", pc->file, n);
+                CHECK(false);
+                break;
+            }
+        }
+    }
+    test_current = "test_probe_table";
+}
+
+// Tag ID3 większy niż pierwszy odczyt - decyzję zostawiamy Content-Type
+static void test_id3_larger_than_read(void)
+{
+    static uint8_t buf[FIXTURE_MAX];
+    int len = load_fixture("mp3_id3_large.bin", buf);
+    CHECK(len > 8010);
+    CHECK_INT(codec_detect_probe(buf, 4096, NULL), ESP_CODEC_TYPE_UNKNOW);
+
+    codec_frame_info_t info = {0};
+    CHECK_INT(codec_detect_probe(buf, len, &info), ESP_CODEC_TYPE_MP3);
+    CHECK_INT(info.offset, 8010);
+}
+
+typedef struct {
+    const char *file;               // Fixture albo NULL (tylko ścieżka)
+    const char *path;
+    esp_codec_type_t codec;
+} file_case_t;
+
+static void test_file_table(void)
+{
+    static uint8_t buf[FIXTURE_MAX];
+    static const file_case_t FILE_CASES[] = {
+        { "mp3_cbr128.bin",    "/sdcard/a.bin",  ESP_CODEC_TYPE_MP3 },
+        // Sygnatura wygrywa z rozszerzeniem
+        { "adts_lc.bin",       "/sdcard/a.mp3",  ESP_CODEC_TYPE_AAC },
+        { "mp4_ftyp.bin",      "/sdcard/a.m4a",  ESP_CODEC_TYPE_M4A },
+        // ID3: nagłówek nie jest analizowany, rozszerzenie albo MP3
+        { "mp3_id3_large.bin", "/sdcard/a.MP3",  ESP_CODEC_TYPE_MP3 },
+        { "mp3_id3_large.bin", "/sdcard/a.flac", ESP_CODEC_TYPE_FLAC },
+        { "mp3_id3_large.bin", "/sdcard/noext",  ESP_CODEC_TYPE_MP3 },
+        { "junk_only.bin",     "/sdcard/a.wav",  ESP_CODEC_TYPE_WAV },
+        { "junk_only.bin",     "/sdcard/a.txt",  ESP_CODEC_TYPE_UNKNOW },
+        { NULL,                "/sdcard/b.Ogg",  ESP_CODEC_TYPE_OGG },
+        { NULL,                "/sdcard/b.aac",  ESP_CODEC_TYPE_AAC },
+    };
+
+    for (size_t c = 0; c < sizeof(FILE_CASES) / sizeof(FILE_CASES[0]); c++) {
+        const file_case_t *fc = &FILE_CASES[c];
+        int len = fc->file ? load_fixture(fc->file, buf) : 0;
+        if (len > 4096) len = 4096;     // SD_PROBE_SIZE w sd_source.c
+        esp_codec_type_t got = codec_detect_file(fc->file ? buf : NULL, len, fc->path);
+        if (got != fc->codec) {
+            fprintf(stderr, "%s %s -> %s\n", fc->file ? fc->file : "-", fc->path, codec_detect_name(got));
+        }
+        CHECK_INT(got, fc->codec);
+    }
+
+    // Sygnatury kontenerów
+    uint8_t sig[16] = {0};
+    memcpy(sig, "fLaC", 4);
+    CHECK_INT(codec_detect_file(sig, sizeof(sig), "/x.mp3"), ESP_CODEC_TYPE_FLAC);
+    memcpy(sig, "RIFF\0\0\0\0WAVE", 12);
+    CHECK_INT(codec_detect_file(sig, sizeof(sig), NULL), ESP_CODEC_TYPE_WAV);
+    memcpy(sig, "OggS", 4);
+    CHECK_INT(codec_detect_file(sig, sizeof(sig), NULL), ESP_CODEC_TYPE_OGG);
+}
+
+int main(void)
+{
+    RUN_TEST(test_probe_table);
+    RUN_TEST(test_id3_larger_than_read);
+    RUN_TEST(test_file_table);
+    return TEST_RESULT();
+}
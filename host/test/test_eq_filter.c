@@ -0,0 +1,262 @@
+/*
+ * eq_filter: dokładność stałoprzecinkowej kaskady względem referencji w double
+ * (test/eq_reference.h), podmiana współczynników na granicy bloku, równoległe settery
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "test_util.h"
+#include "eq_reference.h"
+
+#define FRAMES      1152
+#define RATE        44100
+
+static const int band_freq[EQ_FILTER_BANDS] = {
+    31, 62, 125, 250, 500, 1000, 2000, 4000, 8000, 16000
+};
+
+typedef struct {
+    double max_err;     // LSB int16
+    double rms_err;
+    double mean_err;    // Składowa stała błędu
+} eq_error_t;
+
+// blocks bloków FRAMES ramek stereo przez eq_filter i referencję; błąd liczony
+// po pierwszym bloku (start obu filtrów z zerowego stanu jest identyczny)
+static eq_error_t measure(const int *gains, int16_t (*gen)(int n, int ch), int blocks)
+{
+    static int16_t in[FRAMES * 2], out[FRAMES * 2];
+    static double ref_out[FRAMES * 2];
+
+    eq_filter_cfg_t cfg = DEFAULT_EQ_FILTER_CONFIG();
+    cfg.band_freq = band_freq;
+    cfg.set_gain = gains;
+    audio_element_handle_t eq = eq_filter_init(&cfg);
+    eq_ref_t ref;
+    eq_ref_init(&ref, band_freq, gains, RATE, 2);
+
+    double sum = 0, sum2 = 0, max = 0;
+    long count = 0;
+    for (int blk = 0; blk < blocks; blk++) {
+        for (int i = 0; i < FRAMES; i++) {
+            in[2 * i] = gen(blk * FRAMES + i, 0);
+            in[2 * i + 1] = gen(blk * FRAMES + i, 1);
+        }
+        host_audio_element_run(eq, in, sizeof(in), out, sizeof(out));
+        eq_ref_process(&ref, in, ref_out, FRAMES);
+        for (int i = 0; i < FRAMES * 2; i++) {
+            double e = out[i] - ref_out[i];
+            sum += e;
+            sum2 += e * e;
+            if (fabs(e) > max) max = fabs(e);
+            count++;
+        }
+    }
+    audio_element_deinit(eq);
+    return (eq_error_t){ max, sqrt(sum2 / count), sum / count };
+}
+
+static int16_t gen_noise(int n, int ch)
+{
+    (void)n;
+    (void)ch;
+    return (int16_t)((rand() % 6000) - 3000);
+}
+
+// Cichy sygnał w paśmie 31 Hz - tu biegun jest najbliżej koła jednostkowego i błąd
+// zaokrągleń w sprzężeniu zwrotnym jest wzmacniany najbardziej
+static int16_t gen_quiet_bass(int n, int ch)
+{
+    return (int16_t)lrint(40.0 * sin(2 * M_PI * 40.0 * n / RATE + ch));
+}
+
+static void test_accuracy_noise(void)
+{
+    int gains[EQ_FILTER_BANDS * 2];
+    for (int i = 0; i < EQ_FILTER_BANDS * 2; i++) {
+        gains[i] = (i % 2) ? 6 : -4;
+    }
+    srand(1);
+    eq_error_t e = measure(gains, gen_noise, 40);
+    printf("  noise: max %.3f LSB, rms %.3f LSB, mean %+.4f LSB\n", e.max_err, e.rms_err, e.mean_err);
+    // Samo zaokrąglenie do int16 daje 0.5 LSB max / 0.29 LSB RMS
+    CHECK(e.max_err < 1.0);
+    CHECK(e.rms_err < 0.35);
+    CHECK(fabs(e.mean_err) < 0.02);
+}
+
+static void test_accuracy_bass_boost(void)
+{
+    int gains[EQ_FILTER_BANDS * 2] = {0};
+    gains[0] = gains[EQ_FILTER_BANDS] = EQ_FILTER_GAIN_MAX;
+    gains[1] = gains[EQ_FILTER_BANDS + 1] = EQ_FILTER_GAIN_MAX;
+    eq_error_t e = measure(gains, gen_quiet_bass, 80);
+    printf("  bass:  max %.3f LSB, rms %.3f LSB, mean %+.4f LSB\n", e.max_err, e.rms_err, e.mean_err);
+    CHECK(e.max_err < 1.0);
+    CHECK(e.rms_err < 0.35);
+    CHECK(fabs(e.mean_err) < 0.02);
+}
+
+// Cisza na wejściu po sygnale: wyjście wraca do zera (bez cyklu granicznego / offsetu)
+static int16_t gen_burst(int n, int ch)
+{
+    return n < FRAMES * 4 ? (int16_t)((rand() % 2000) - 1000) : 0;
+}
+
+static void test_decays_to_silence(void)
+{
+    int gains[EQ_FILTER_BANDS * 2];
+    for (int i = 0; i < EQ_FILTER_BANDS * 2; i++) {
+        gains[i] = EQ_FILTER_GAIN_MAX;
+    }
+    static int16_t in[FRAMES * 2], out[FRAMES * 2];
+    eq_filter_cfg_t cfg = DEFAULT_EQ_FILTER_CONFIG();
+    cfg.band_freq = band_freq;
+    cfg.set_gain = gains;
+    audio_element_handle_t eq = eq_filter_init(&cfg);
+    srand(5);
+    int nonzero = 0;
+    for (int blk = 0; blk < 200; blk++) {
+        for (int i = 0; i < FRAMES * 2; i++) {
+            in[i] = gen_burst(blk * FRAMES + i / 2, i % 2);
+        }
+        host_audio_element_run(eq, in, sizeof(in), out, sizeof(out));
+        if (blk == 199) {
+            for (int i = 0; i < FRAMES * 2; i++) {
+                nonzero += out[i] != 0;
+            }
+        }
+    }
+    CHECK_INT(nonzero, 0);
+    audio_element_deinit(eq);
+}
+
+static void test_gain_change_applies_next_block(void)
+{
+    static int16_t in[FRAMES * 2], out[FRAMES * 2];
+    eq_filter_cfg_t cfg = DEFAULT_EQ_FILTER_CONFIG();
+    cfg.band_freq = band_freq;
+    audio_element_handle_t eq = eq_filter_init(&cfg);
+
+    host_audio_element_run(eq, in, sizeof(in), out, sizeof(out));
+    CHECK_INT(eq_filter_get_active_bands(eq), 0);
+
+    eq_filter_set_gain_info(eq, 3, 5, true);
+    eq_filter_set_gain_info(eq, 12, -5, false);     // Pasmo 2, tylko prawy kanał
+    CHECK_INT(eq_filter_get_active_bands(eq), 0);
+    host_audio_element_run(eq, in, sizeof(in), out, sizeof(out));
+    CHECK_INT(eq_filter_get_active_bands(eq), 1);
+
+    CHECK_INT(eq_filter_set_gain_info(eq, EQ_FILTER_BANDS * 2, 1, true), ESP_ERR_INVALID_ARG);
+    audio_element_deinit(eq);
+}
+
+// Każdy wątek przestawia swoje pasmo i kończy na wartości niezerowej. Bez kopii
+// parametrów pod blokadą i numeru zmiany publikacja starszej kopii mogła nadpisać nowszą
+// i jedno z pasm znikało z kaskady.
+#define SETTER_THREADS  4
+#define SETTER_ROUNDS   20000
+
+static audio_element_handle_t race_eq;
+
+static void *setter_thread(void *arg)
+{
+    int band = (int)(intptr_t)arg;
+    for (int n = 0; n < SETTER_ROUNDS; n++) {
+        int db = (n == SETTER_ROUNDS - 1) ? band + 1 : (n % 3) - 1;
+        if (n % 2) {
+            eq_filter_set_gain_info(race_eq, band, db, true);
+        } else {
+            eq_filter_set_gain_info(race_eq, band, db, false);
+            eq_filter_set_gain_info(race_eq, band + EQ_FILTER_BANDS, db, false);
+        }
+    }
+    return NULL;
+}
+
+static void test_concurrent_setters(void)
+{
+    static int16_t in[FRAMES * 2], out[FRAMES * 2], expect[FRAMES * 2];
+    eq_filter_cfg_t cfg = DEFAULT_EQ_FILTER_CONFIG();
+    cfg.band_freq = band_freq;
+    race_eq = eq_filter_init(&cfg);
+
+    pthread_t threads[SETTER_THREADS];
+    for (int t = 0; t < SETTER_THREADS; t++) {
+        pthread_create(&threads[t], NULL, setter_thread, (void *)(intptr_t)(t * 2));
+    }
+    for (int t = 0; t < SETTER_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+
+    srand(9);
+    for (int i = 0; i < FRAMES * 2; i++) {
+        in[i] = (int16_t)((rand() % 2000) - 1000);
+    }
+    host_audio_element_run(race_eq, in, sizeof(in), out, sizeof(out));
+    CHECK_INT(eq_filter_get_active_bands(race_eq), SETTER_THREADS);
+
+    // Wynik jak z filtra utworzonego od razu z końcowymi wzmocnieniami
+    int gains[EQ_FILTER_BANDS * 2] = {0};
+    for (int t = 0; t < SETTER_THREADS; t++) {
+        gains[t * 2] = gains[t * 2 + EQ_FILTER_BANDS] = t * 2 + 1;
+    }
+    cfg.set_gain = gains;
+    audio_element_handle_t fresh = eq_filter_init(&cfg);
+    host_audio_element_run(fresh, in, sizeof(in), expect, sizeof(expect));
+    CHECK(memcmp(out, expect, sizeof(out)) == 0);
+
+    audio_element_deinit(fresh);
+    audio_element_deinit(race_eq);
+}
+
+// Odczyty z ring buffera o długości niebędącej wielokrotnością ramki (nieparzyste bajty,
+// pół ramki): wynik identyczny jak przy blokach wyrównanych do ramek
+static void test_partial_frames(void)
+{
+    enum { BLOCKS = 4 };
+    static int16_t in[FRAMES * 2 * BLOCKS], expect[FRAMES * 2 * BLOCKS], out[FRAMES * 2 * BLOCKS];
+    int gains[EQ_FILTER_BANDS * 2] = {0};
+    gains[2] = 6;
+    gains[EQ_FILTER_BANDS + 7] = -6;    // Różne kanały - zamiana L/R zmienia wynik
+    eq_filter_cfg_t cfg = DEFAULT_EQ_FILTER_CONFIG();
+    cfg.band_freq = band_freq;
+    cfg.set_gain = gains;
+
+    srand(11);
+    for (size_t i = 0; i < sizeof(in) / sizeof(in[0]); i++) {
+        in[i] = (int16_t)((rand() % 8000) - 4000);
+    }
+    audio_element_handle_t ref = eq_filter_init(&cfg);
+    host_audio_element_run(ref, in, sizeof(in), expect, sizeof(expect));
+    audio_element_deinit(ref);
+
+    static const int chunks[] = { 1, 3, 2, 7, 1001, 6, 4095, 5 };
+    audio_element_handle_t eq = eq_filter_init(&cfg);
+    const char *src = (const char *)in;
+    char *dst = (char *)out;
+    int pos = 0, written = 0;
+    for (int c = 0; pos < (int)sizeof(in); c++) {
+        int len = chunks[c % (sizeof(chunks) / sizeof(chunks[0]))];
+        if (len > (int)sizeof(in) - pos) len = sizeof(in) - pos;
+        int n = host_audio_element_run(eq, src + pos, len, dst + written, sizeof(out) - written);
+        CHECK(n % 4 == 0);
+        written += n;
+        pos += len;
+    }
+    CHECK_INT(written, sizeof(out));
+    CHECK(memcmp(out, expect, sizeof(out)) == 0);
+    audio_element_deinit(eq);
+}
+
+int main(void)
+{
+    RUN_TEST(test_accuracy_noise);
+    RUN_TEST(test_accuracy_bass_boost);
+    RUN_TEST(test_decays_to_silence);
+    RUN_TEST(test_gain_change_applies_next_block);
+    RUN_TEST(test_concurrent_setters);
+    RUN_TEST(test_partial_frames);
+    return TEST_RESULT();
+}
@@ -0,0 +1,311 @@
+/*
+ * icy_meta: bloki metadanych przechodzące przez granice odczytów, bajt długości na
+ * granicy, bloki zerowej długości, icy-metaint z nagłówka i z wyszukiwania, utrata synchronizacji
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "test_util.h"
+#include "icy_meta.h"
+
+#define METAINT     1000
+#define BLOCKS      12
+#define STREAM_MAX  (BLOCKS * (METAINT + 1 + 64) + 16)
+
+static uint8_t stream[STREAM_MAX], audio[STREAM_MAX];
+static int stream_len, audio_len;
+
+static char titles[16][ICY_META_TEXT_MAX + 1];
+static int title_count;
+
+static void on_meta(const char *meta, void *ctx)
+{
+    if (title_count < 16) {
+        strcpy(titles[title_count], meta);
+    }
+    title_count++;
+}
+
+// Strumień: METAINT bajtów audio, bajt długości, blok (pusty = długość 0), ...
+static void build_stream(const char *const *blocks, int count)
+{
+    srand(7);
+    stream_len = audio_len = 0;
+    for (int b = 0; b < BLOCKS; b++) {
+        for (int i = 0; i < METAINT; i++) {
+            uint8_t v = (uint8_t)rand();
+            stream[stream_len++] = v;
+            audio[audio_len++] = v;
+        }
+        const char *text = blocks[b % count];
+        int units = ((int)strlen(text) + 15) / 16;
+        stream[stream_len++] = (uint8_t)units;
+        memset(stream + stream_len, 0, units * 16);
+        memcpy(stream + stream_len, text, strlen(text));
+        stream_len += units * 16;
+    }
+}
+
+// Podaje strumień odczytami po chunk bajtów (capped - rozmiar z icy_meta_read_size)
+static int feed(icy_meta_t *icy, int chunk, bool capped, uint8_t *out)
+{
+    static uint8_t buf[4096];
+    int out_len = 0;
+    for (int pos = 0; pos < stream_len;) {
+        int n = capped ? icy_meta_read_size(icy, chunk) : chunk;
+        if (n > stream_len - pos) n = stream_len - pos;
+        memcpy(buf, stream + pos, n);
+        pos += n;
+        int a = icy_meta_strip(icy, buf, n);
+        CHECK(a >= 0 && a <= n);
+        memcpy(out + out_len, buf, a);
+        out_len += a;
+    }
+    return out_len;
+}
+
+static const char *const BLOCK_TEXTS[] = {
+    "StreamTitle='Artist A - Song 1';",
+    "",
+    "StreamTitle='Only title';StreamUrl='';",
+    "StreamTitle='Rock'n'Roll - X - Y';",
+};
+
+static void test_split_reads(void)
+{
+    static uint8_t out[STREAM_MAX];
+    build_stream(BLOCK_TEXTS, 4);
+
+    for (int chunk = 1; chunk < 3000; chunk += (chunk < 40 ? 1 : 97)) {
+        for (int capped = 0; capped < 2; capped++) {
+            icy_meta_t icy;
+            icy_meta_reset(&icy, on_meta, NULL);
+            title_count = 0;
+            int out_len = feed(&icy, chunk, capped, out);
+
+            CHECK_INT(icy.metaint, METAINT);
+            CHECK(icy_meta_active(&icy));
+            // 12 bloków, co czwarty pusty - pusty blok nie wywołuje callbacku
+            CHECK_INT(title_count, 9);
+            CHECK_STR(titles[0], BLOCK_TEXTS[0]);
+            CHECK_STR(titles[1], BLOCK_TEXTS[2]);
+            CHECK_STR(titles[2], BLOCK_TEXTS[3]);
+
+            // Pierwszy blok jest wykrywany po treści. Gdy wzorzec (bajt długości +
+            // "StreamTitle='") przechodzi przez granicę odczytu, jego początek poszedł już
+            // jako audio - wyszukiwanie nie ogranicza odczytów, więc dotyczy to obu trybów.
+            // Od drugiego bloku audio musi się zgadzać co do bajtu.
+            int last_read = ((METAINT + 13) / chunk) * chunk;
+            int leak = last_read > METAINT ? last_read - METAINT : 0;
+            CHECK_INT(out_len, audio_len + leak);
+            CHECK(memcmp(out, audio, METAINT) == 0);
+            CHECK(memcmp(out + METAINT + leak, audio + METAINT, audio_len - METAINT) == 0);
+        }
+    }
+}
+
+// Synchronizacja na pierwszym bloku, potem odczyty kończące się tuż przed, na i tuż po
+// bajcie długości
+static void test_length_byte_at_boundary(void)
+{
+    const char *texts[] = { "StreamTitle='A - B';", "StreamTitle='C - D';" };
+    build_stream(texts, 2);
+
+    int first_block_end = METAINT + 1 + 32;
+    int second_len_at = first_block_end + METAINT;
+    int cuts[][3] = {
+        { second_len_at, second_len_at + 1, stream_len },       // Odczyt = sam bajt długości
+        { second_len_at, second_len_at + 2, stream_len },       // Bajt długości na początku odczytu
+        { second_len_at + 1, second_len_at + 5, stream_len },   // Bajt długości na końcu odczytu
+        { second_len_at - 1, second_len_at + 33, stream_len },  // Ostatni bajt audio + cały blok
+    };
+
+    for (size_t c = 0; c < sizeof(cuts) / sizeof(cuts[0]); c++) {
+        static uint8_t buf[STREAM_MAX], out[STREAM_MAX];
+        icy_meta_t icy;
+        icy_meta_reset(&icy, on_meta, NULL);
+        title_count = 0;
+
+        int points[] = { first_block_end, cuts[c][0], cuts[c][1], cuts[c][2] };
+        int pos = 0, out_len = 0;
+        for (int p = 0; p < 4; p++) {
+            int n = points[p] - pos;
+            memcpy(buf, stream + pos, n);
+            int a = icy_meta_strip(&icy, buf, n);
+            memcpy(out + out_len, buf, a);
+            out_len += a;
+            pos = points[p];
+        }
+        CHECK_INT(out_len, audio_len);
+        CHECK(memcmp(out, audio, audio_len) == 0);
+        CHECK_INT(title_count, BLOCKS);
+        CHECK_STR(titles[1], texts[1]);
+    }
+}
+
+static void test_zero_length_blocks(void)
+{
+    static uint8_t out[STREAM_MAX];
+    // Typowy Icecast: tytuł w pierwszym bloku, potem puste bloki do zmiany
+    const char *texts[] = { "StreamTitle='First';", "", "", "", "", "" };
+    build_stream(texts, 6);
+
+    icy_meta_t icy;
+    icy_meta_reset(&icy, on_meta, NULL);
+    title_count = 0;
+    int out_len = feed(&icy, 333, false, out);
+    CHECK_INT(out_len, audio_len);
+    CHECK(memcmp(out, audio, audio_len) == 0);
+    CHECK_INT(title_count, 2);
+
+    // Odczyty ograniczone przez icy_meta_read_size: bajt długości 0 czytany osobno
+    // od razu wraca do audio
+    icy_meta_reset(&icy, on_meta, NULL);
+    title_count = 0;
+    out_len = feed(&icy, 2048, true, out);
+    CHECK_INT(out_len, audio_len);
+    CHECK(memcmp(out, audio, audio_len) == 0);
+    CHECK_INT(title_count, 2);
+    CHECK_INT(icy.state, ICY_STATE_AUDIO);
+    CHECK_INT(icy.audio_left, METAINT);
+}
+
+// Puste bloki przed pierwszym tytułem - odstęp tylko z nagłówka icy-metaint
+static void test_header_leading_empty_blocks(void)
+{
+    static uint8_t out[STREAM_MAX];
+    const char *texts[] = { "", "", "StreamTitle='Late - Title';", "", "", "" };
+    build_stream(texts, 6);
+
+    for (int chunk = 1; chunk < 3000; chunk += (chunk < 40 ? 1 : 97)) {
+        for (int capped = 0; capped < 2; capped++) {
+            icy_meta_t icy;
+            icy_meta_reset(&icy, on_meta, NULL);
+            CHECK(icy_meta_set_interval(&icy, "1000"));
+            title_count = 0;
+            int out_len = feed(&icy, chunk, capped, out);
+
+            CHECK_INT(out_len, audio_len);
+            CHECK(memcmp(out, audio, audio_len) == 0);
+            CHECK_INT(title_count, 2);
+            CHECK_STR(titles[0], texts[2]);
+            CHECK(icy_meta_active(&icy));
+        }
+    }
+}
+
+// Nieprawidłowy nagłówek - metadane ignorowane, dane bez zmian
+static void test_header_invalid(void)
+{
+    static uint8_t out[STREAM_MAX];
+    build_stream(BLOCK_TEXTS, 4);
+    const char *bad[] = { "0", "-8192", "abc", "", "100", "1000000", "8192x" };
+
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        icy_meta_t icy;
+        icy_meta_reset(&icy, on_meta, NULL);
+        CHECK(!icy_meta_set_interval(&icy, bad[i]));
+        CHECK(!icy_meta_active(&icy));
+        title_count = 0;
+        int out_len = feed(&icy, 777, false, out);
+        CHECK_INT(out_len, stream_len);
+        CHECK(memcmp(out, stream, stream_len) == 0);
+        CHECK_INT(title_count, 0);
+    }
+
+    // Brak nagłówka - zostaje wyszukiwanie
+    icy_meta_t icy;
+    icy_meta_reset(&icy, on_meta, NULL);
+    CHECK(!icy_meta_set_interval(&icy, NULL));
+    CHECK_INT(icy.state, ICY_STATE_SEARCH);
+    CHECK(icy_meta_set_interval(&icy, "8192 "));
+    CHECK_INT(icy.metaint, 8192);
+}
+
+static void test_no_metadata(void)
+{
+    static uint8_t buf[4096];
+    icy_meta_t icy;
+    icy_meta_reset(&icy, on_meta, NULL);
+    srand(3);
+    for (int total = 0; total < 140 * 1024; total += sizeof(buf)) {
+        for (size_t i = 0; i < sizeof(buf); i++) buf[i] = (uint8_t)rand();
+        CHECK_INT(icy_meta_strip(&icy, buf, sizeof(buf)), sizeof(buf));
+    }
+    // Po limicie wyszukiwania dane przechodzą bez analizy
+    CHECK(!icy_meta_active(&icy));
+    CHECK_INT(icy_meta_read_size(&icy, 1234), 1234);
+}
+
+static void test_lost_sync(void)
+{
+    static uint8_t out[STREAM_MAX];
+    const char *texts[] = { "StreamTitle='Ok';", "garbage without key" };
+    build_stream(texts, 2);
+
+    icy_meta_t icy;
+    icy_meta_reset(&icy, on_meta, NULL);
+    title_count = 0;
+    int out_len = feed(&icy, 512, false, out);
+
+    // Blok bez "klucz=" - synchronizacja utracona, reszta przechodzi bez zmian
+    CHECK(!icy_meta_active(&icy));
+    CHECK_INT(title_count, 1);
+    int second_block_end = 2 * (METAINT + 1 + 32);
+    CHECK_INT(out_len, 2 * METAINT + (stream_len - second_block_end));
+}
+
+static void test_metaint_too_small(void)
+{
+    // StreamTitle po kilku bajtach audio - to nie jest odstęp metadanych
+    static uint8_t buf[256];
+    memset(buf, 0x55, sizeof(buf));
+    buf[99] = 2;
+    memcpy(buf + 100, "StreamTitle='x';", 16);
+    icy_meta_t icy;
+    icy_meta_reset(&icy, on_meta, NULL);
+    CHECK_INT(icy_meta_strip(&icy, buf, sizeof(buf)), sizeof(buf));
+    CHECK_INT(icy.state, ICY_STATE_SEARCH);
+}
+
+static void test_parse_title(void)
+{
+    char artist[32], title[32];
+    CHECK(icy_meta_parse_title("StreamTitle='Artist A - Song 1';", artist, sizeof(artist),
+                               title, sizeof(title)));
+    CHECK_STR(artist, "Artist A");
+    CHECK_STR(title, "Song 1");
+
+    CHECK(icy_meta_parse_title("StreamTitle='Only title';StreamUrl='';", artist, sizeof(artist),
+                               title, sizeof(title)));
+    CHECK_STR(artist, "");
+    CHECK_STR(title, "Only title");
+
+    // Apostrof w tytule, separator tylko pierwszy
+    CHECK(icy_meta_parse_title("StreamTitle='Rock'n'Roll - X - Y';", artist, sizeof(artist),
+                               title, sizeof(title)));
+    CHECK_STR(artist, "Rock'n'Roll");
+    CHECK_STR(title, "X - Y");
+
+    // Obcięty blok (bez "';"), obcięcie do bufora
+    CHECK(icy_meta_parse_title("StreamTitle='  Very long artist name here - t'", artist, 8,
+                               title, sizeof(title)));
+    CHECK_STR(artist, "Very lo");
+    CHECK_STR(title, "t");
+
+    CHECK(!icy_meta_parse_title("StreamUrl='http://x';", artist, sizeof(artist), title, sizeof(title)));
+}
+
+int main(void)
+{
+    RUN_TEST(test_split_reads);
+    RUN_TEST(test_length_byte_at_boundary);
+    RUN_TEST(test_zero_length_blocks);
+    RUN_TEST(test_header_leading_empty_blocks);
+    RUN_TEST(test_header_invalid);
+    RUN_TEST(test_no_metadata);
+    RUN_TEST(test_lost_sync);
+    RUN_TEST(test_metaint_too_small);
+    RUN_TEST(test_parse_title);
+    return TEST_RESULT();
+}
@@ -0,0 +1,181 @@
+/*
+ * jitter_buffer: odtworzenie śladów przyjścia pakietów A2DP (fixtures/a2dp) przeciw
+ * odczytom I2S taktowanym dokładnie 44.1 kHz - głębokość docelowa, underrun, poślizgi
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "test_util.h"
+#include "jitter_buffer.h"
+
+#define RATE            44100
+#define FRAME_BYTES     4
+#define READ_FRAMES     256                 // Odczyt etapu wyjściowego
+#define JB_SIZE         (32 * 1024)         // SINK_JITTER_SIZE
+
+typedef struct {
+    uint32_t target_max;            // Największa głębokość docelowa
+    uint32_t target_end;
+    uint32_t underruns;
+    uint32_t late;
+    uint32_t lost;
+    uint32_t slipped;
+    uint32_t packets;
+    uint32_t max_depth_ms;
+    double avg_depth_ms;            // Średnia głębokość w trakcie odtwarzania (opóźnienie)
+    double seconds;
+} replay_t;
+
+static bool replay(const char *name, replay_t *r)
+{
+    static uint8_t mem[JB_SIZE], pkt[8192], out[READ_FRAMES * FRAME_BYTES];
+    memset(r, 0, sizeof(*r));
+    char path[128];
+    snprintf(path, sizeof(path), "fixtures/a2dp/%s", name);
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        fprintf(stderr, "missing trace %s\n", path);
+        return false;
+    }
+
+    jitter_buffer_t jb;
+    jitter_buffer_init(&jb, mem, sizeof(mem));
+    jitter_buffer_start(&jb, RATE, FRAME_BYTES);
+
+    const double read_us = READ_FRAMES * 1e6 / RATE;
+    double next_read = -1;
+    double depth_sum = 0;
+    long depth_n = 0;
+    char line[128];
+    long long at = 0;
+
+    while (fgets(line, sizeof(line), f)) {
+        unsigned len;
+        if (line[0] == '#' || sscanf(line, "%lld %u", &at, &len) != 2) continue;
+        if (len > sizeof(pkt)) len = sizeof(pkt);
+
+        // Odczyty I2S, które wypadły przed tym pakietem
+        while (next_read >= 0 && next_read <= at) {
+            int n = jitter_buffer_read(&jb, out, sizeof(out));
+            jitter_buffer_stats_t s;
+            jitter_buffer_get_stats(&jb, &s);
+            if (n > 0) {
+                depth_sum += s.depth_ms;
+                depth_n++;
+                if (s.depth_ms > r->max_depth_ms) r->max_depth_ms = s.depth_ms;
+            }
+            next_read += read_us;
+        }
+        jitter_buffer_write(&jb, pkt, len, at);
+        if (next_read < 0) next_read = at;
+
+        jitter_buffer_stats_t s;
+        jitter_buffer_get_stats(&jb, &s);
+        if (s.target_ms > r->target_max) r->target_max = s.target_ms;
+    }
+    fclose(f);
+
+    jitter_buffer_stats_t s;
+    jitter_buffer_get_stats(&jb, &s);
+    r->target_end = s.target_ms;
+    r->underruns = s.underruns;
+    r->late = s.late;
+    r->lost = s.lost;
+    r->slipped = s.slipped;
+    r->packets = s.packets;
+    r->avg_depth_ms = depth_n ? depth_sum / depth_n : 0;
+    r->seconds = at / 1e6;
+    printf("  %-24s %5u pkt, target max %2u end %2u ms, depth avg %4.1f max %3u ms, "
+           "underrun %u late %u lost %u slipped %u\n",
+           name, r->packets, r->target_max, r->target_end, r->avg_depth_ms, r->max_depth_ms,
+           r->underruns, r->late, r->lost, r->slipped);
+    return true;
+}
+
+typedef struct {
+    const char *trace;
+    double clock_ppm;               // Zegar nadawcy względem I2S (z make_traces.py)
+    uint32_t target_min, target_max;
+    uint32_t max_underruns;
+} trace_case_t;
+
+static void test_traces(void)
+{
+    static const trace_case_t CASES[] = {
+        { "steady.trace",           30, JITTER_MIN_MS, 30,            0 },
+        // Przestoje 10-40 ms: cel rośnie, jedno-dwa opróżnienia zanim urośnie
+        { "wifi_coex.trace",       -20, 40,            JITTER_MAX_MS, 2 },
+        // Pakiety parami: cel obejmuje podwójny odstęp
+        { "slow_clock_pairs.trace",-200, 30,           45,            0 },
+        // Pauza nadawcy: jedno opróżnienie bufora na pauzie, bez narastania celu
+        { "pause_resume.trace",     10, JITTER_MIN_MS, 30,            1 },
+    };
+
+    for (size_t c = 0; c < sizeof(CASES) / sizeof(CASES[0]); c++) {
+        const trace_case_t *tc = &CASES[c];
+        replay_t r;
+        test_current = tc->trace;
+        CHECK(replay(tc->trace, &r));
+
+        CHECK(r.target_max >= tc->target_min && r.target_max <= tc->target_max);
+        CHECK(r.target_end >= JITTER_MIN_MS && r.target_end <= JITTER_MAX_MS);
+        CHECK(r.underruns <= tc->max_underruns);
+        CHECK_INT(r.lost, 0);
+        // Opóźnienie: średnio blisko celu, nigdy ponad rozmiar bufora
+        CHECK(r.avg_depth_ms <= r.target_max + JITTER_SLIP_MS);
+        CHECK(r.max_depth_ms < 185);
+
+        // Poślizgi: poziom trzymany między 3/4 celu a celem + JITTER_SLIP_MS. Dryf zegara
+        // mieszczący się w tej strefie nie wymaga korekty; ponad nią - ramka za ramkę.
+        // Do tego zejście z głębokości po spadku celu (szczyt opóźnienia zanika).
+        double drift_frames = fabs(tc->clock_ppm) * 1e-6 * RATE * r.seconds;
+        double band_frames = (r.target_max * 0.25 + JITTER_SLIP_MS) * RATE / 1000.0;
+        double swing_frames = (r.target_max - JITTER_MIN_MS + JITTER_SLIP_MS) * RATE / 1000.0;
+        CHECK(r.slipped >= drift_frames - band_frames);
+        CHECK(r.slipped <= drift_frames + swing_frames);
+    }
+    test_current = "test_traces";
+}
+
+// Paczka pakietów po przerwie zwiększa cel, który potem wraca do minimum
+static void test_target_follows_jitter(void)
+{
+    static uint8_t mem[JB_SIZE], pkt[2048];
+    jitter_buffer_t jb;
+    jitter_buffer_init(&jb, mem, sizeof(mem));
+    jitter_buffer_start(&jb, RATE, FRAME_BYTES);
+
+    const int64_t dur = 512 * 1000000LL / RATE;
+    int64_t t = 0;
+    for (int i = 0; i < 100; i++, t += dur) {
+        jitter_buffer_write(&jb, pkt, sizeof(pkt), t);
+    }
+    jitter_buffer_stats_t s;
+    jitter_buffer_get_stats(&jb, &s);
+    CHECK_INT(s.target_ms, JITTER_MIN_MS);
+
+    // 40 ms przerwy, potem zaległe pakiety naraz
+    t += 40000;
+    for (int i = 0; i < 4; i++) {
+        jitter_buffer_write(&jb, pkt, sizeof(pkt), t + i * 100);
+    }
+    jitter_buffer_get_stats(&jb, &s);
+    CHECK(s.jitter_ms >= 38 && s.jitter_ms <= 41);
+    // Szczyt + jeden pakiet (11.6 ms) + zapas
+    CHECK_NEAR(s.target_ms, s.jitter_ms + 11.6 + JITTER_MARGIN_MS, 1);
+
+    // Szczyt zanika ze stałą JITTER_PEAK_DECAY_MS
+    t += 400;
+    for (int i = 0; i < 6 * JITTER_PEAK_DECAY_MS * 1000 / dur; i++, t += dur) {
+        jitter_buffer_write(&jb, pkt, sizeof(pkt), t);
+    }
+    jitter_buffer_get_stats(&jb, &s);
+    CHECK_INT(s.target_ms, JITTER_MIN_MS);
+}
+
+int main(void)
+{
+    RUN_TEST(test_traces);
+    RUN_TEST(test_target_follows_jitter);
+    return TEST_RESULT();
+}
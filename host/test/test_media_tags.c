@@ -0,0 +1,86 @@
+/*
+ * media_tags: próbki z fixtures/tags (make_fixtures.py) - ID3v2.2-2.4, ID3v1, FLAC,
+ * MP4/M4A i WAV, oczekiwane tagi i długość
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "test_util.h"
+#include "media_tags.h"
+
+typedef struct {
+    const char *file;
+    bool found;
+    const char *title;
+    const char *artist;
+    const char *album;
+    int track;
+    int duration_ms;
+} tags_case_t;
+
+static const tags_case_t TAG_CASES[] = {
+    // UTF-16 z BOM, Latin-1 i UTF-8 w jednym tagu; okładka przed albumem
+    { "id3v23.mp3",        true, "Zażółć gęślą jaźń", "Artist Ä", "Album ✓", 3, 2606 },
+    // Nagłówek rozszerzony + stopka, UTF-16BE, wykonawca z TPE2, skompresowany TALB pominięty
+    { "id3v24_ext.mp3",    true, "Tytuł BE", "Album Artist", "", 11, 2606 },
+    { "id3v22.mp3",        true, "Old Title", "Old Artist", "Old Album", 4, 2606 },
+    // Długość liczona z rozmiaru pliku razem ze 128 B tagu ID3v1
+    { "id3v1.mp3",         true, "V1 Title", "V1 Artist", "V1 Album", 9, 2614 },
+    { "id3v2_v1.mp3",      true, "V2 Title", "V1 Artist", "", 0, 2614 },
+    { "id3_truncated.mp3", true, "Cut", "", "", 0, 0 },
+    { "vorbis.flac",       true, "Flac Title", "Flac AA", "Flac Album", 7, 125000 },
+    { "id3_prefixed.flac", true, "After Id3", "Id3 Artist", "", 0, 61500 },
+    { "itunes.m4a",        true, "M4A Title", "M4A Artist", "M4A Album", 5, 61234 },
+    // "meta" bez wersji/flag (QuickTime), mvhd w wersji 1
+    { "quicktime.m4a",     true, "QT Title", "QT Album Artist", "", 0, 200000 },
+    { "info.wav",          true, "Wav Title", "Wav Art", "Wav Album", 0, 3000 },
+    { "plain.wav",         true, "", "", "", 0, 2000 },
+    { "noise.bin",         false, "", "", "", 0, 0 },
+};
+
+static void test_tag_table(void)
+{
+    for (size_t c = 0; c < sizeof(TAG_CASES) / sizeof(TAG_CASES[0]); c++) {
+        const tags_case_t *tc = &TAG_CASES[c];
+        char path[128];
+        snprintf(path, sizeof(path), "fixtures/tags/%s", tc->file);
+        test_current = tc->file;
+
+        FILE *f = fopen(path, "rb");
+        CHECK(f != NULL);
+        if (f == NULL) continue;
+
+        media_tags_t tags;
+        memset(&tags, 0x5A, sizeof(tags));     // Parser musi sam wyczyścić pola
+        CHECK_INT(media_tags_read(f, &tags), tc->found);
+        CHECK_STR(tags.title, tc->title);
+        CHECK_STR(tags.artist, tc->artist);
+        CHECK_STR(tags.album, tc->album);
+        CHECK_INT(tags.track, tc->track);
+        CHECK_INT(tags.duration_ms, tc->duration_ms);
+        fclose(f);
+    }
+}
+
+// Wynik nie zależy od pozycji w pliku, na której zostawiono FILE*
+static void test_read_from_any_position(void)
+{
+    FILE *f = fopen("fixtures/tags/id3v23.mp3", "rb");
+    CHECK(f != NULL);
+    if (f == NULL) return;
+
+    media_tags_t first, again;
+    CHECK(media_tags_read(f, &first));
+    fseek(f, 1234, SEEK_SET);
+    CHECK(media_tags_read(f, &again));
+    CHECK_STR(again.title, first.title);
+    CHECK_INT(again.duration_ms, first.duration_ms);
+    fclose(f);
+}
+
+int main(void)
+{
+    RUN_TEST(test_tag_table);
+    RUN_TEST(test_read_from_any_position);
+    return TEST_RESULT();
+}
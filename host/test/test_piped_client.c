@@ -0,0 +1,146 @@
+/*
+ * piped_client: wyniki wyszukiwania, wybór strumienia audio, odtwarzanie przez atrapę
+ */
+
+#include <stdbool.h>
+#include "test_util.h"
+#include "esp_http_client.h"
+#include "piped_client.h"
+#include "host_player.h"
+
+#define BASE "http://piped.test"
+
+static const char *SEARCH_JSON =
+    "{\"items\": ["
+    "  {\"url\": \"/watch?v=dQw4w9WgXcQ\", \"title\": \"Never Gonna Give You Up\","
+    "   \"uploaderName\": \"Rick Astley\", \"duration\": 213, \"views\": 1500000000,"
+    "   \"thumbnail\": \"http://img.test/1.jpg\"},"
+    "  {\"url\": \"/channel/UCxyz\", \"title\": \"Kanał - bez v=\"},"
+    "  {\"url\": \"abcdefghijk\", \"title\": \"Samo ID\", \"duration\": -1}"
+    "], \"nextpage\": \"token123\"}";
+
+static const char *STREAMS_JSON =
+    "{\"title\": \"Never Gonna Give You Up\", \"uploader\": \"Rick Astley\","
+    " \"duration\": 213, \"thumbnailUrl\": \"http://img.test/t.jpg\","
+    " \"audioStreams\": ["
+    "  {\"url\": \"http://a.test/48\", \"bitrate\": 48000, \"mimeType\": \"audio/mp4\"},"
+    "  {\"url\": \"http://a.test/256\", \"bitrate\": 256000, \"mimeType\": \"audio/webm\"},"
+    "  {\"url\": \"http://a.test/160\", \"bitrate\": 160000, \"mimeType\": \"audio/webm\","
+    "   \"quality\": \"160 kbps\", \"codec\": \"opus\"},"
+    "  {\"url\": \"http://a.test/128\", \"bitrate\": 128000, \"mimeType\": \"audio/mp4\"},"
+    "  {\"bitrate\": 190000}"
+    " ]}";
+
+static void test_search(void)
+{
+    piped_search_results_t results;
+    host_http_reset();
+    host_http_add_response("/search?", 200, SEARCH_JSON, 64, false);
+
+    CHECK_INT(piped_search("never gonna", NULL, &results), ESP_OK);
+    CHECK_STR(host_http_last_url(), BASE "/search?q=never%20gonna&filter=music_songs");
+    CHECK_INT(results.count, 2);
+    CHECK_STR(results.items[0].video_id, "dQw4w9WgXcQ");
+    CHECK_STR(results.items[0].title, "Never Gonna Give You Up");
+    CHECK_STR(results.items[0].artist, "Rick Astley");
+    CHECK_INT(results.items[0].duration_seconds, 213);
+    CHECK_INT(results.items[0].views, 1500000000);
+    CHECK_STR(results.items[0].thumbnail_url, "http://img.test/1.jpg");
+    // Kanał bez v= pominięty, samo 11-znakowe ID przyjęte
+    CHECK_STR(results.items[1].video_id, "abcdefghijk");
+    CHECK(results.has_more);
+    CHECK_STR(results.next_page, "token123");
+
+    CHECK_INT(piped_search("x", "videos", &results), ESP_OK);
+    CHECK_STR(host_http_last_url(), BASE "/search?q=x&filter=videos");
+}
+
+static void test_search_errors(void)
+{
+    piped_search_results_t results;
+
+    host_http_reset();
+    host_http_add_response("/search?", 200, "{\"error\": \"x\"}", 64, false);
+    CHECK_INT(piped_search("q", NULL, &results), ESP_ERR_INVALID_RESPONSE);
+
+    host_http_reset();
+    host_http_add_response("/search?", 200, "not json", 64, false);
+    CHECK_INT(piped_search("q", NULL, &results), ESP_ERR_INVALID_RESPONSE);
+
+    host_http_reset();
+    host_http_add_response("/search?", 503, "{}", 64, false);
+    CHECK(piped_search("q", NULL, &results) != ESP_OK);
+}
+
+static void test_stream_selection(void)
+{
+    piped_stream_info_t stream;
+    host_http_reset();
+    host_http_add_response("/streams/dQw4w9WgXcQ", 200, STREAMS_JSON, 100, false);
+
+    CHECK_INT(piped_get_stream("dQw4w9WgXcQ", &stream), ESP_OK);
+    CHECK_STR(host_http_last_url(), BASE "/streams/dQw4w9WgXcQ");
+    CHECK_STR(stream.title, "Never Gonna Give You Up");
+    CHECK_STR(stream.artist, "Rick Astley");
+    CHECK_INT(stream.duration_seconds, 213);
+    // Najwyższy bitrate do 192 kbps; 256 kbps odrzucony, wpis bez URL pominięty
+    CHECK_STR(stream.audio.url, "http://a.test/160");
+    CHECK_INT(stream.audio.bitrate, 160000);
+    CHECK_STR(stream.audio.mime_type, "audio/webm");
+    CHECK_STR(stream.audio.quality, "160 kbps");
+    CHECK_STR(stream.audio.codec, "opus");
+
+    char url[64];
+    CHECK_INT(piped_get_audio_url("dQw4w9WgXcQ", url, sizeof(url)), ESP_OK);
+    CHECK_STR(url, "http://a.test/160");
+
+    host_http_reset();
+    host_http_add_response("/streams/", 200, "{\"title\": \"x\", \"audioStreams\": []}", 100, false);
+    CHECK_INT(piped_get_stream("aaaaaaaaaaa", &stream), ESP_ERR_NOT_FOUND);
+}
+
+static void test_play(void)
+{
+    host_player_reset();
+    host_http_reset();
+    host_http_add_response("/search?", 200, SEARCH_JSON, 64, false);
+    host_http_add_response("/streams/dQw4w9WgXcQ", 200, STREAMS_JSON, 100, false);
+
+    CHECK_INT(piped_play_search("never gonna"), ESP_OK);
+    CHECK_INT(host_player_play_count(), 1);
+    CHECK_STR(host_player_last_url(), "http://a.test/160");
+
+    // Brak strumienia - odtwarzacz nie jest ruszany
+    host_http_reset();
+    host_http_add_response("/streams/", 404, "{}", 64, false);
+    CHECK(piped_play_video("zzzzzzzzzzz") != ESP_OK);
+    CHECK_INT(host_player_play_count(), 1);
+}
+
+static void test_instances(void)
+{
+    host_http_reset();
+    host_http_add_response("api.piped.yt/healthcheck", 200, "ok", 64, false);
+    host_http_add_response("/healthcheck", 0, "", 64, false);
+
+    CHECK_INT(piped_find_working_instance(), ESP_OK);
+    CHECK_STR(piped_client_get_instance(), PIPED_INSTANCE_BACKUP_1);
+    CHECK_INT(host_http_request_count(), 2);
+    piped_client_set_instance(BASE);
+}
+
+int main(void)
+{
+    CHECK_INT(piped_search("x", NULL, NULL), ESP_ERR_INVALID_STATE);
+    CHECK_INT(piped_client_init(BASE), ESP_OK);
+
+    RUN_TEST(test_search);
+    RUN_TEST(test_search_errors);
+    RUN_TEST(test_stream_selection);
+    RUN_TEST(test_play);
+    RUN_TEST(test_instances);
+
+    piped_client_deinit();
+    host_http_reset();
+    return TEST_RESULT();
+}
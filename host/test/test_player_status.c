@@ -0,0 +1,251 @@
+/*
+ * player_status: maska zmienionych pól, pozycja liczona lokalnie i próg zgłaszania skoków
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "test_util.h"
+#include "player_status.h"
+#include "config.h"
+
+static void test_defaults(void)
+{
+    player_status_t s;
+    player_status_get(&s);
+    CHECK_INT(s.state, PLAYER_STATE_IDLE);
+    CHECK_INT(s.source, AUDIO_SOURCE_NONE);
+    CHECK_INT(s.volume, DEFAULT_VOLUME);
+    CHECK_STR(s.current_url, "");
+    CHECK_INT(player_status_take_changed(), 0);
+}
+
+static void test_change_mask(void)
+{
+    player_status_set_volume(70);
+    player_status_set_title("Tytuł");
+    player_status_set_state(PLAYER_STATE_PLAYING);
+    player_status_set_source(AUDIO_SOURCE_HTTP);
+    CHECK_INT(player_status_take_changed(), PLAYER_STATUS_VOLUME | PLAYER_STATUS_TITLE |
+                                            PLAYER_STATUS_STATE | PLAYER_STATUS_SOURCE);
+    CHECK_INT(player_status->state, PLAYER_STATE_PLAYING);
+    CHECK_INT(player_status->source, AUDIO_SOURCE_HTTP);
+    CHECK_INT(player_status_take_changed(), 0);
+
+    // Ta sama wartość - bez bitu
+    player_status_set_volume(70);
+    player_status_set_title("Tytuł");
+    player_status_set_state(PLAYER_STATE_PLAYING);
+    player_status_set_muted(false);
+    CHECK_INT(player_status_take_changed(), 0);
+
+    // NULL czyści pole
+    player_status_set_artist("Ktoś");
+    player_status_set_artist(NULL);
+    CHECK_STR(player_status->current_artist, "");
+    CHECK_INT(player_status_take_changed(), PLAYER_STATUS_ARTIST);
+
+    // Zbyt długi napis obcinany; porównanie obejmuje tylko mieszczącą się część
+    char longer[sizeof(player_status->current_album) + 16];
+    memset(longer, 'a', sizeof(longer) - 1);
+    longer[sizeof(longer) - 1] = '\0';
+    player_status_set_album(longer);
+    CHECK_INT(strlen(player_status->current_album), sizeof(player_status->current_album) - 1);
+    CHECK_INT(player_status_take_changed(), PLAYER_STATUS_ALBUM);
+    player_status_set_album(longer);
+    CHECK_INT(player_status_take_changed(), 0);
+
+    // Kilka pól w jednym zapisie
+    player_status_t *w = player_status_write_begin();
+    w->muted = true;
+    w->volume = 0;
+    player_status_write_end(PLAYER_STATUS_MUTED | PLAYER_STATUS_VOLUME);
+    player_status_t s;
+    player_status_get(&s);
+    CHECK(s.muted);
+    CHECK_INT(s.volume, 0);
+    CHECK_INT(player_status_take_changed(), PLAYER_STATUS_MUTED | PLAYER_STATUS_VOLUME);
+}
+
+static void test_position(void)
+{
+    // Zegar pozycji rusza od 10 s w chwili 1000 ms
+    player_status_set_position(60000, 10000, 1000, 1000, 1500);
+    CHECK_INT(player_status_take_changed(), PLAYER_STATUS_POSITION);
+
+    player_status_t s;
+    player_status_get(&s);
+    CHECK_INT(player_status_position_ms(&s, 1000), 10000);
+    CHECK_INT(player_status_position_ms(&s, 6000), 15000);
+    // Nie dalej niż długość
+    CHECK_INT(player_status_position_ms(&s, 100000), 60000);
+
+    // Raport zgodny z lokalnym zegarem (w granicach slack) - bez powiadomienia
+    player_status_set_position(60000, 14900, 5000, 6000, 1500);
+    CHECK_INT(player_status_take_changed(), 0);
+
+    // Skok (przewinięcie)
+    player_status_set_position(60000, 40000, 6000, 6000, 1500);
+    CHECK_INT(player_status_take_changed(), PLAYER_STATUS_POSITION);
+
+    // Pauza - zegar staje, pozycja nie biegnie
+    player_status_set_position(60000, 40000, 0, 6000, 1500);
+    CHECK_INT(player_status_take_changed(), PLAYER_STATUS_POSITION);
+    player_status_get(&s);
+    CHECK_INT(player_status_position_ms(&s, 50000), 40000);
+
+    // Inna długość (następny utwór)
+    player_status_set_position(30000, 40000, 0, 7000, 1500);
+    CHECK_INT(player_status_take_changed(), PLAYER_STATUS_POSITION);
+
+    // Strumień bez długości - bez obcinania
+    player_status_set_position(0, 0, 1000, 1000, 1500);
+    player_status_get(&s);
+    CHECK_INT(player_status_position_ms(&s, 3601000), 3600000);
+    player_status_take_changed();
+}
+
+// ============================================
+// Wielu czytelników i piszących naraz
+// ============================================
+
+#define STRESS_WRITES   200000
+#define STRESS_READERS  4
+
+static atomic_bool stress_done;
+static atomic_int stress_torn;
+static atomic_long stress_reads;
+static atomic_uint stress_changed;
+
+// Para pól zapisywana razem: volume == title == album
+static void *writer_pair(void *arg)
+{
+    for (int n = 1; n <= STRESS_WRITES; n++) {
+        player_status_t *w = player_status_write_begin();
+        w->volume = n;
+        snprintf(w->current_title, sizeof(w->current_title), "%d", n);
+        snprintf(w->current_album, sizeof(w->current_album), "%d", n);
+        player_status_write_end(PLAYER_STATUS_VOLUME | PLAYER_STATUS_TITLE | PLAYER_STATUS_ALBUM);
+    }
+    return NULL;
+}
+
+// Pozycja zatrzymana: position_ms == duration_ms w każdej kopii
+static void *writer_position(void *arg)
+{
+    for (uint32_t n = 1; n <= STRESS_WRITES; n++) {
+        player_status_set_position(n, n, 0, 0, 0);
+    }
+    return NULL;
+}
+
+// Długi napis podmieniany w całości - rozerwana kopia miałaby dwie różne litery
+static void *writer_url(void *arg)
+{
+    static char url[2][sizeof(player_status->current_url)];
+    memset(url[0], 'A', sizeof(url[0]) - 1);
+    memset(url[1], 'B', sizeof(url[1]) - 1);
+    for (int n = 0; n < STRESS_WRITES; n++) {
+        player_status_set_url(url[n & 1]);
+        player_status_set_state(n & 1 ? PLAYER_STATE_PLAYING : PLAYER_STATE_BUFFERING);
+    }
+    return NULL;
+}
+
+static bool status_consistent(const player_status_t *s)
+{
+    if (s->volume != atoi(s->current_title) || strcmp(s->current_title, s->current_album) != 0) {
+        return false;
+    }
+    if (s->position_ms != s->duration_ms) {
+        return false;
+    }
+    size_t len = strlen(s->current_url);
+    if (len != 0 && len != sizeof(s->current_url) - 1) {
+        return false;
+    }
+    for (size_t i = 1; i < len; i++) {
+        if (s->current_url[i] != s->current_url[0]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void *reader(void *arg)
+{
+    player_status_t s;
+    long reads = 0;
+    while (!atomic_load(&stress_done)) {
+        player_status_get(&s);
+        if (!status_consistent(&s)) {
+            atomic_fetch_add(&stress_torn, 1);
+        }
+        reads++;
+    }
+    atomic_fetch_add(&stress_reads, reads);
+    return NULL;
+}
+
+static void *collector(void *arg)
+{
+    while (!atomic_load(&stress_done)) {
+        atomic_fetch_or(&stress_changed, player_status_take_changed());
+    }
+    atomic_fetch_or(&stress_changed, player_status_take_changed());
+    return NULL;
+}
+
+static void test_concurrent(void)
+{
+    // Stan początkowy spełniający niezmienniki
+    player_status_t *w = player_status_write_begin();
+    w->volume = 0;
+    strcpy(w->current_title, "0");
+    strcpy(w->current_album, "0");
+    w->current_url[0] = '\0';
+    w->duration_ms = w->position_ms = w->position_at_ms = 0;
+    player_status_write_end(0);
+    player_status_take_changed();
+
+    pthread_t writers[3], readers[STRESS_READERS], coll;
+    for (int i = 0; i < STRESS_READERS; i++) {
+        pthread_create(&readers[i], NULL, reader, NULL);
+    }
+    pthread_create(&coll, NULL, collector, NULL);
+    pthread_create(&writers[0], NULL, writer_pair, NULL);
+    pthread_create(&writers[1], NULL, writer_position, NULL);
+    pthread_create(&writers[2], NULL, writer_url, NULL);
+
+    for (int i = 0; i < 3; i++) {
+        pthread_join(writers[i], NULL);
+    }
+    atomic_store(&stress_done, true);
+    for (int i = 0; i < STRESS_READERS; i++) {
+        pthread_join(readers[i], NULL);
+    }
+    pthread_join(coll, NULL);
+
+    printf("  %ld reads, %d torn\n", atomic_load(&stress_reads), atomic_load(&stress_torn));
+    CHECK_INT(atomic_load(&stress_torn), 0);
+    CHECK(atomic_load(&stress_reads) > STRESS_READERS);
+    CHECK_INT(atomic_load(&stress_changed),
+              PLAYER_STATUS_VOLUME | PLAYER_STATUS_TITLE | PLAYER_STATUS_ALBUM |
+              PLAYER_STATUS_POSITION | PLAYER_STATUS_URL | PLAYER_STATUS_STATE);
+
+    player_status_t s;
+    player_status_get(&s);
+    CHECK_INT(s.volume, STRESS_WRITES);
+    CHECK_INT(s.duration_ms, STRESS_WRITES);
+    CHECK(status_consistent(&s));
+}
+
+int main(void)
+{
+    RUN_TEST(test_defaults);
+    RUN_TEST(test_change_mask);
+    RUN_TEST(test_position);
+    RUN_TEST(test_concurrent);
+    return TEST_RESULT();
+}
@@ -0,0 +1,132 @@
+/*
+ * radio_browser: parsowanie odpowiedzi JSON przychodzącej w małych porcjach,
+ * budowanie zapytań i obsługa błędów HTTP
+ */
+
+#include <stdbool.h>
+#include "test_util.h"
+#include "esp_http_client.h"
+#include "radio_browser.h"
+
+static const char *STATIONS_JSON =
+    "[\n"
+    "  {\"name\": \"RMF FM\", \"url\": \"http://rmf.example/old\","
+    "   \"url_resolved\": \"http://rmf.example/stream.mp3\", \"country\": \"Poland\","
+    "   \"tags\": \"pop,hits\", \"bitrate\": 128, \"votes\": 5021},\n"
+    "  {\"name\": \"Bez resolved\", \"url\": \"http://plain.example/live\","
+    "   \"url_resolved\": \"\", \"bitrate\": 64},\n"
+    "  {\"name\": \"Bez URL\", \"url\": \"\", \"votes\": 3},\n"
+    "  {\"url_resolved\": \"http://anon.example/a.aac\", \"country\": null, \"votes\": 1},\n"
+    "  {\"name\": \"Czwarta \\\"cytat\\\" \\u0141\\u00f3d\\u017a\", \"url\": \"http://lodz.example/\"}\n"
+    "]";
+
+static void test_parse_chunked_body(void)
+{
+    radio_browser_station_t results[RADIO_BROWSER_MAX_RESULTS];
+    memset(results, 0, sizeof(results));
+
+    // Porcje po 7 bajtów - odpowiedź składana z wielu zdarzeń ON_DATA
+    host_http_reset();
+    host_http_add_response("/stations/search", 200, STATIONS_JSON, 7, false);
+
+    int n = radio_browser_search_by_name("rmf", NULL, results, RADIO_BROWSER_MAX_RESULTS);
+    CHECK_INT(n, 4);
+    CHECK_STR(results[0].name, "RMF FM");
+    CHECK_STR(results[0].url, "http://rmf.example/stream.mp3");
+    CHECK_STR(results[0].country, "Poland");
+    CHECK_STR(results[0].tags, "pop,hits");
+    CHECK_INT(results[0].bitrate, 128);
+    CHECK_INT(results[0].votes, 5021);
+
+    // Pusty url_resolved - zwykły url
+    CHECK_STR(results[1].url, "http://plain.example/live");
+    CHECK_INT(results[1].votes, 0);
+
+    // Stacja bez URL pominięta, brak nazwy - "Unknown"
+    CHECK_STR(results[2].name, "Unknown");
+    CHECK_STR(results[2].country, "");
+    CHECK_STR(results[3].name, "Czwarta \"cytat\" \xc5\x81\xc3\xb3\x64\xc5\xba");
+}
+
+static void test_max_results(void)
+{
+    radio_browser_station_t results[2];
+    memset(results, 0, sizeof(results));
+    host_http_reset();
+    host_http_add_response("/stations/topvote/2", 200, STATIONS_JSON, 4096, false);
+
+    CHECK_INT(radio_browser_get_top_stations(NULL, results, 2), 2);
+    CHECK_STR(host_http_last_url(), "http://de1.api.radio-browser.info/json/stations/topvote/2");
+    CHECK_INT(radio_browser_get_top_stations(NULL, results, 0), 0);
+}
+
+static void test_query_encoding(void)
+{
+    radio_browser_station_t results[4];
+    host_http_reset();
+    host_http_add_response("/stations/", 200, "[]", 4096, false);
+
+    CHECK_INT(radio_browser_search_by_name("Radio Nowy Świat", "PL", results, 4), 0);
+    CHECK_STR(host_http_last_url(),
+              "http://de1.api.radio-browser.info/json/stations/search?"
+              "name=Radio%20Nowy%20%C5%9Awiat&countrycode=PL&limit=4&order=votes&reverse=true");
+    CHECK_STR(host_http_last_header("User-Agent"), "ESP32-AudioPlayer/1.0");
+    CHECK_STR(host_http_last_header("Accept"), "application/json");
+
+    radio_browser_search_by_tag("rock&roll", NULL, results, 4);
+    CHECK_STR(host_http_last_url(),
+              "http://de1.api.radio-browser.info/json/stations/bytag/rock%26roll?"
+              "limit=4&order=votes&reverse=true");
+
+    radio_browser_search_by_country("DE", results, 4);
+    CHECK_STR(host_http_last_url(),
+              "http://de1.api.radio-browser.info/json/stations/bycountrycodeexact/DE?"
+              "limit=4&order=votes&reverse=true");
+    CHECK_INT(host_http_request_count(), 3);
+}
+
+static void test_errors(void)
+{
+    radio_browser_station_t results[4];
+
+    host_http_reset();
+    host_http_add_response("/stations/", 500, "[{\"name\":\"x\",\"url\":\"http://x\"}]", 4096, false);
+    CHECK_INT(radio_browser_search_by_name("x", NULL, results, 4), 0);
+
+    // Status 0 - błąd połączenia
+    host_http_reset();
+    host_http_add_response("/stations/", 0, "", 4096, false);
+    CHECK_INT(radio_browser_search_by_name("x", NULL, results, 4), 0);
+
+    // Obcięty JSON
+    host_http_reset();
+    host_http_add_response("/stations/", 200, "[{\"name\":\"x\",\"url\":", 4096, false);
+    CHECK_INT(radio_browser_search_by_name("x", NULL, results, 4), 0);
+
+    // Obiekt zamiast tablicy
+    host_http_reset();
+    host_http_add_response("/stations/", 200, "{\"error\":\"rate limited\"}", 4096, false);
+    CHECK_INT(radio_browser_search_by_name("x", NULL, results, 4), 0);
+
+    CHECK_INT(radio_browser_search_by_name(NULL, NULL, results, 4), 0);
+}
+
+static void test_countries(void)
+{
+    char countries[5][32];
+    CHECK_INT(radio_browser_get_countries(countries, 5), 5);
+    CHECK_STR(countries[0], "PL");
+    CHECK_STR(countries[4], "FR");
+}
+
+int main(void)
+{
+    radio_browser_init();
+    RUN_TEST(test_parse_chunked_body);
+    RUN_TEST(test_max_results);
+    RUN_TEST(test_query_encoding);
+    RUN_TEST(test_errors);
+    RUN_TEST(test_countries);
+    host_http_reset();
+    return TEST_RESULT();
+}
@@ -0,0 +1,129 @@
+/*
+ * radio_stations: lista stacji i zapis JSON w NVS
+ */
+
+#include "test_util.h"
+#include "nvs.h"
+#include "radio_stations.h"
+
+static void setup(void)
+{
+    host_nvs_reset();
+    CHECK_INT(radio_stations_init(), ESP_OK);
+}
+
+static void test_load_empty_nvs(void)
+{
+    setup();
+    CHECK_INT(radio_stations_load(), ESP_ERR_NOT_FOUND);
+    uint8_t count = 99;
+    radio_stations_get_all(&count);
+    CHECK_INT(count, 0);
+}
+
+static void test_defaults_roundtrip(void)
+{
+    setup();
+    CHECK_INT(radio_stations_load_defaults(), ESP_OK);
+    uint8_t count;
+    radio_station_t *all = radio_stations_get_all(&count);
+    CHECK_INT(count, 6);
+    CHECK_STR(all[0].name, "RMF FM");
+
+    uint8_t fav_count;
+    radio_stations_get_favorites(&fav_count);
+    CHECK_INT(fav_count, 2);
+
+    // Nowy start: lista tylko z NVS
+    CHECK_INT(radio_stations_init(), ESP_OK);
+    CHECK_INT(radio_stations_load(), ESP_OK);
+    all = radio_stations_get_all(&count);
+    CHECK_INT(count, 6);
+    CHECK_STR(all[5].name, "Radioparty DJ Mixes");
+    CHECK_STR(all[1].url, "http://ic1.smcdn.pl/3990-1.mp3");
+    CHECK(all[0].favorite);
+    CHECK(!all[2].favorite);
+}
+
+static void test_add_remove_update(void)
+{
+    setup();
+    CHECK_INT(radio_stations_add("A", "http://a/", "http://a/logo.png"), ESP_OK);
+    CHECK_INT(radio_stations_add("B", "http://b/", NULL), ESP_OK);
+    CHECK_INT(radio_stations_add("C", "http://c/", NULL), ESP_OK);
+    CHECK_INT(radio_stations_get(3) != NULL, 1);
+
+    // Usunięcie ze środka przesuwa resztę, nowe ID to max + 1
+    CHECK_INT(radio_stations_remove(2), ESP_OK);
+    CHECK_INT(radio_stations_remove(2), ESP_ERR_NOT_FOUND);
+    CHECK_INT(radio_stations_add("D", "http://d/", NULL), ESP_OK);
+    uint8_t count;
+    radio_station_t *all = radio_stations_get_all(&count);
+    CHECK_INT(count, 3);
+    CHECK_STR(all[1].name, "C");
+    CHECK_INT(all[2].id, 4);
+    CHECK_STR(all[2].logo_url, "");     // Bez pozostałości po przesuniętym wpisie
+
+    CHECK_INT(radio_stations_update(1, NULL, "http://a2/", NULL), ESP_OK);
+    CHECK_STR(radio_stations_get(1)->url, "http://a2/");
+    CHECK_STR(radio_stations_get(1)->name, "A");
+    CHECK_INT(radio_stations_update(9, "X", NULL, NULL), ESP_ERR_NOT_FOUND);
+
+    CHECK_INT(radio_stations_set_favorite(4, true), ESP_OK);
+    uint8_t fav_count;
+    radio_station_t *fav = radio_stations_get_favorites(&fav_count);
+    CHECK_INT(fav_count, 1);
+    CHECK_STR(fav[0].name, "D");
+}
+
+static void test_json_escaping(void)
+{
+    setup();
+    CHECK_INT(radio_stations_add("Radio \"Zet\" \\ Łódź", "http://x/?a=1&b=\"2\"", NULL), ESP_OK);
+    CHECK_INT(radio_stations_init(), ESP_OK);
+    CHECK_INT(radio_stations_load(), ESP_OK);
+    radio_station_t *s = radio_stations_get(1);
+    CHECK(s != NULL);
+    if (s) {
+        CHECK_STR(s->name, "Radio \"Zet\" \\ Łódź");
+        CHECK_STR(s->url, "http://x/?a=1&b=\"2\"");
+    }
+}
+
+static void test_long_strings_truncated(void)
+{
+    setup();
+    char name[200];
+    memset(name, 'n', sizeof(name) - 1);
+    name[sizeof(name) - 1] = '\0';
+    CHECK_INT(radio_stations_add(name, "http://long/", NULL), ESP_OK);
+    CHECK_INT(strlen(radio_stations_get(1)->name), sizeof(((radio_station_t *)0)->name) - 1);
+}
+
+static void test_capacity(void)
+{
+    setup();
+    for (int i = 0; i < MAX_RADIO_STATIONS; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "S%d", i);
+        CHECK_INT(radio_stations_add(name, "http://s/", NULL), ESP_OK);
+    }
+    CHECK_INT(radio_stations_add("over", "http://s/", NULL), ESP_ERR_NO_MEM);
+
+    CHECK_INT(radio_stations_init(), ESP_OK);
+    CHECK_INT(radio_stations_load(), ESP_OK);
+    uint8_t count;
+    radio_stations_get_all(&count);
+    CHECK_INT(count, MAX_RADIO_STATIONS);
+}
+
+int main(void)
+{
+    RUN_TEST(test_load_empty_nvs);
+    RUN_TEST(test_defaults_roundtrip);
+    RUN_TEST(test_add_remove_update);
+    RUN_TEST(test_json_escaping);
+    RUN_TEST(test_long_strings_truncated);
+    RUN_TEST(test_capacity);
+    return TEST_RESULT();
+}
@@ -0,0 +1,304 @@
+/*
+ * sd_bookmark: dziennik zakładek na dysku hosta - odtworzenie po każdym możliwym
+ * urwaniu zapisu (zanik zasilania), przerwane przepisywanie, wypieranie, limit dziennika
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include "test_util.h"
+#include "sd_bookmark.h"
+
+static char dir[] = "/tmp/sd_bookmark_XXXXXX";
+static char journal[64], journal_tmp[72], scratch[64];
+
+static sd_bookmarks_t bm, loaded;       // Duże struktury - poza stosem
+
+static void path_of(int n, char *buf, size_t size)
+{
+    snprintf(buf, size, "/sdcard/Audiobooki/Rozdział %03d.mp3", n);
+}
+
+static long file_size(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) return -1;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fclose(f);
+    return size;
+}
+
+static void copy_prefix(const char *from, const char *to, long len)
+{
+    FILE *in = fopen(from, "rb"), *out = fopen(to, "wb");
+    for (long i = 0; i < len; i++) fputc(fgetc(in), out);
+    fclose(in);
+    fclose(out);
+}
+
+static void reset_journal(void)
+{
+    remove(journal);
+    remove(journal_tmp);
+}
+
+// Zakładki 0..n-1 w sd_bookmarks_t zgodne z oczekiwanymi pozycjami (0 - brak)
+static void check_state(const sd_bookmarks_t *b, const uint32_t *expected, int n)
+{
+    char path[64];
+    int count = 0;
+    for (int i = 0; i < n; i++) {
+        uint32_t pos = 0;
+        path_of(i, path, sizeof(path));
+        bool found = sd_bookmark_get(b, path, &pos);
+        CHECK_INT(found ? pos : 0, expected[i]);
+        count += expected[i] != 0;
+    }
+    CHECK_INT(b->count, count);
+}
+
+static void test_round_trip(void)
+{
+    reset_journal();
+    uint32_t expected[8] = {0};
+    char path[64];
+
+    sd_bookmark_load(&bm, journal);
+    CHECK_INT(bm.count, 0);
+    CHECK(!sd_bookmark_dirty(&bm));
+    CHECK(sd_bookmark_flush(&bm));
+    CHECK_INT(bm.writes, 0);                    // Nic do zapisania - karta nietknięta
+
+    for (int i = 0; i < 8; i++) {
+        path_of(i, path, sizeof(path));
+        sd_bookmark_set(&bm, path, expected[i] = 1000 * (i + 1));
+    }
+    CHECK(sd_bookmark_dirty(&bm));
+    CHECK(sd_bookmark_flush(&bm));
+    CHECK_INT(bm.records, 8);
+    CHECK_INT(file_size(journal), 8 * 16);
+
+    // Ta sama pozycja nie jest zapisywana ponownie; usunięcie to jeden rekord
+    path_of(3, path, sizeof(path));
+    sd_bookmark_set(&bm, path, 4000);
+    CHECK(!sd_bookmark_dirty(&bm));
+    sd_bookmark_set(&bm, path, 0);
+    expected[3] = 0;
+    path_of(5, path, sizeof(path));
+    sd_bookmark_set(&bm, path, expected[5] = 99999);
+    sd_bookmark_set(&bm, "/sdcard/nieznany.mp3", 0);
+    CHECK(sd_bookmark_flush(&bm));
+    CHECK_INT(bm.records, 10);
+    check_state(&bm, expected, 8);
+
+    sd_bookmark_load(&loaded, journal);
+    CHECK(!loaded.rewrite);
+    CHECK_INT(loaded.records, 10);
+    check_state(&loaded, expected, 8);
+    CHECK_INT(loaded.seq, bm.seq);
+}
+
+// Zanik zasilania w dowolnym bajcie: stan = rekordy zapisane w całości, reszta pominięta,
+// a następny zapis przepisuje dziennik zamiast dopisywać za urwanym rekordem
+static void test_torn_writes(void)
+{
+    enum { FILES = 6, STEPS = 20 };
+    static uint32_t after[STEPS + 1][FILES];    // Stan po każdym rekordzie
+    char path[64];
+
+    reset_journal();
+    sd_bookmark_load(&bm, journal);
+    srand(5);
+    for (int s = 1; s <= STEPS; s++) {
+        memcpy(after[s], after[s - 1], sizeof(after[s]));
+        int n = rand() % FILES;
+        uint32_t pos = (rand() % 4 == 0 && after[s][n]) ? 0 : 1 + rand() % 3600000;
+        if (pos == after[s][n]) pos++;
+        after[s][n] = pos;
+        path_of(n, path, sizeof(path));
+        sd_bookmark_set(&bm, path, pos);
+        CHECK(sd_bookmark_flush(&bm));          // Rekord na zapis - kolejność w dzienniku
+    }
+    long size = file_size(journal);
+    CHECK_INT(size, STEPS * 16);
+
+    for (long len = 0; len <= size; len++) {
+        copy_prefix(journal, scratch, len);
+        sd_bookmark_load(&loaded, scratch);
+        int whole = (int)(len / 16);
+        check_state(&loaded, after[whole], FILES);
+        CHECK_INT(loaded.rewrite, len % 16 != 0);
+
+        if (len % 16 != 0) {
+            // Po przepisaniu dziennik znów odtwarza się bez strat
+            path_of(0, path, sizeof(path));
+            sd_bookmark_set(&loaded, path, 777);
+            CHECK(sd_bookmark_flush(&loaded));
+            CHECK_INT(file_size(scratch) % 16, 0);
+            uint32_t expected[FILES];
+            memcpy(expected, after[whole], sizeof(expected));
+            expected[0] = 777;
+            sd_bookmark_load(&loaded, scratch);
+            CHECK(!loaded.rewrite);
+            check_state(&loaded, expected, FILES);
+        }
+    }
+    remove(scratch);
+}
+
+static void test_corrupt_record(void)
+{
+    reset_journal();
+    uint32_t expected[3] = { 100, 200, 300 };
+    char path[64];
+    sd_bookmark_load(&bm, journal);
+    for (int i = 0; i < 3; i++) {
+        path_of(i, path, sizeof(path));
+        sd_bookmark_set(&bm, path, expected[i]);
+        CHECK(sd_bookmark_flush(&bm));
+    }
+
+    // Przekłamany bajt środkowego rekordu
+    FILE *f = fopen(journal, "r+b");
+    fseek(f, 16 + 5, SEEK_SET);
+    fputc(0x5A, f);
+    fclose(f);
+
+    sd_bookmark_load(&loaded, journal);
+    CHECK(loaded.rewrite);
+    expected[1] = 0;
+    check_state(&loaded, expected, 3);
+    CHECK(sd_bookmark_dirty(&loaded));
+    CHECK(sd_bookmark_flush(&loaded));
+    CHECK_INT(file_size(journal), 2 * 16);
+}
+
+// Przepisywanie przerwane między usunięciem dziennika a zmianą nazwy: zostaje tylko .tmp
+static void test_interrupted_rewrite(void)
+{
+    reset_journal();
+    uint32_t expected[4] = { 11, 22, 33, 44 };
+    char path[64];
+    sd_bookmark_load(&bm, journal);
+    for (int i = 0; i < 4; i++) {
+        path_of(i, path, sizeof(path));
+        sd_bookmark_set(&bm, path, expected[i]);
+    }
+    CHECK(sd_bookmark_flush(&bm));
+    CHECK(rename(journal, journal_tmp) == 0);
+
+    sd_bookmark_load(&loaded, journal);
+    CHECK(loaded.rewrite);
+    check_state(&loaded, expected, 4);
+    CHECK(sd_bookmark_flush(&loaded));
+    CHECK_INT(file_size(journal), 4 * 16);
+    CHECK_INT(file_size(journal_tmp), -1);
+
+    // Przerwane przed usunięciem starego: niepełny .tmp obok całego dziennika - ignorowany
+    FILE *f = fopen(journal_tmp, "wb");
+    fwrite("garbage", 1, 7, f);
+    fclose(f);
+    sd_bookmark_load(&loaded, journal);
+    CHECK(!loaded.rewrite);
+    check_state(&loaded, expected, 4);
+}
+
+// Więcej plików niż SD_BOOKMARK_MAX: wypierane najdawniej zapisane, dziennik przepisany
+// bez nich, limit rekordów dziennika trzymany przy częstych zapisach pozycji
+static void test_eviction_and_growth(void)
+{
+    enum { FILES = SD_BOOKMARK_MAX + 40 };
+    static uint32_t expected[FILES];
+    char path[64];
+
+    reset_journal();
+    memset(expected, 0, sizeof(expected));
+    sd_bookmark_load(&bm, journal);
+    for (int i = 0; i < FILES; i++) {
+        path_of(i, path, sizeof(path));
+        sd_bookmark_set(&bm, path, expected[i] = 5000 + i);
+        CHECK(sd_bookmark_flush(&bm));
+    }
+    for (int i = 0; i < FILES - SD_BOOKMARK_MAX; i++) expected[i] = 0;
+    check_state(&bm, expected, FILES);
+    CHECK_INT(bm.records, SD_BOOKMARK_MAX);
+
+    sd_bookmark_load(&loaded, journal);
+    CHECK(!loaded.rewrite);
+    check_state(&loaded, expected, FILES);
+
+    // Odtwarzanie jednego długiego pliku: zapis pozycji co 10 s przez kilka godzin
+    path_of(FILES - 1, path, sizeof(path));
+    for (int t = 1; t <= 3000; t++) {
+        sd_bookmark_set(&bm, path, expected[FILES - 1] = t * 10000);
+        CHECK(sd_bookmark_flush(&bm));
+        CHECK(bm.records <= SD_BOOKMARK_JOURNAL_MAX);
+    }
+    CHECK(file_size(journal) <= SD_BOOKMARK_JOURNAL_MAX * 16);
+    CHECK(bm.writes < 3000 + FILES + 10);
+    sd_bookmark_load(&loaded, journal);
+    check_state(&loaded, expected, FILES);
+}
+
+static void test_write_error(void)
+{
+    char bad[96];
+    snprintf(bad, sizeof(bad), "%s/nie_ma/bookmarks.bin", dir);
+    sd_bookmark_load(&bm, bad);
+    sd_bookmark_set(&bm, "/sdcard/a.mp3", 1234);
+    CHECK(!sd_bookmark_flush(&bm));
+    CHECK(bm.rewrite);                          // Następna próba przepisze całość
+    CHECK(sd_bookmark_dirty(&bm));
+    uint32_t pos = 0;
+    CHECK(sd_bookmark_get(&bm, "/sdcard/a.mp3", &pos));
+    CHECK_INT(pos, 1234);
+}
+
+// Przepisywanie, którego .tmp nie da się zapisać (pełna karta): stary dziennik nietknięty
+static void test_rewrite_write_error(void)
+{
+    reset_journal();
+    uint32_t expected[3] = { 100, 200, 300 };
+    char path[64];
+    sd_bookmark_load(&bm, journal);
+    for (int i = 0; i < 3; i++) {
+        path_of(i, path, sizeof(path));
+        sd_bookmark_set(&bm, path, expected[i]);
+    }
+    CHECK(sd_bookmark_flush(&bm));
+
+    CHECK(symlink("/dev/full", journal_tmp) == 0);  // Każdy zapis .tmp kończy się ENOSPC
+    bm.rewrite = true;
+    CHECK(!sd_bookmark_flush(&bm));
+    CHECK(bm.rewrite);
+    CHECK_INT(file_size(journal), 3 * 16);
+    CHECK_INT(file_size(journal_tmp), -1);
+
+    sd_bookmark_load(&loaded, journal);
+    check_state(&loaded, expected, 3);
+}
+
+int main(void)
+{
+    if (mkdtemp(dir) == NULL) {
+        perror("mkdtemp");
+        return 1;
+    }
+    snprintf(journal, sizeof(journal), "%s/bookmarks.bin", dir);
+    snprintf(journal_tmp, sizeof(journal_tmp), "%s.tmp", journal);
+    snprintf(scratch, sizeof(scratch), "%s/scratch.bin", dir);
+
+    RUN_TEST(test_round_trip);
+    RUN_TEST(test_torn_writes);
+    RUN_TEST(test_corrupt_record);
+    RUN_TEST(test_interrupted_rewrite);
+    RUN_TEST(test_eviction_and_growth);
+    RUN_TEST(test_write_error);
+    RUN_TEST(test_rewrite_write_error);
+
+    reset_journal();
+    remove(scratch);
+    rmdir(dir);
+    return TEST_RESULT();
+}
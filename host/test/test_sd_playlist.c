@@ -0,0 +1,204 @@
+/*
+ * sd_playlist: odtworzenie ścieżek z areny, limity, sortowanie, tasowanie
+ * i budżet pamięci dla 10 000 plików
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "test_util.h"
+#include "sd_playlist.h"
+
+static uint32_t lcg_state;
+
+static uint32_t lcg(void)
+{
+    lcg_state = lcg_state * 1664525u + 1013904223u;
+    return lcg_state >> 8;
+}
+
+static const char *path_at(const sd_playlist_t *pl, uint32_t index)
+{
+    static char buf[256];
+    if (sd_playlist_get_path(pl, index, buf, sizeof(buf)) == 0) {
+        return NULL;
+    }
+    return buf;
+}
+
+static void test_round_trip(void)
+{
+    static const char *paths[] = {
+        "/sdcard/Muzyka/01 - Intro.mp3",
+        "/sdcard/Muzyka/02 - Zażółć.flac",
+        "/sdcard/Inne/nagranie.wav",
+        "/sdcard/Muzyka/03 - Outro.m4a",          // Powrót do wcześniejszego katalogu
+        "/sdcard/Inne/WIELKIE.MP3",               // Rozszerzenie bez kodu - zostaje w nazwie
+        "/sdcard/Inne/bez_rozszerzenia",
+        "/sdcard/Inne/.mp3",                      // Sama kropka - nie skracać do pustej nazwy
+        "/sdcard/Inne/podwójne.flac.mp3",
+        "/sdcard/audio.aac",
+        "/top.mp3",
+    };
+    sd_playlist_t pl;
+    sd_playlist_init(&pl, 100);
+    for (size_t i = 0; i < sizeof(paths) / sizeof(paths[0]); i++) {
+        CHECK(sd_playlist_add(&pl, paths[i]));
+    }
+    CHECK_INT(pl.count, sizeof(paths) / sizeof(paths[0]));
+    CHECK_INT(pl.dir_count, 4);
+    for (uint32_t i = 0; i < pl.count; i++) {
+        test_current = paths[i];
+        CHECK_STR(path_at(&pl, i), paths[i]);
+    }
+    test_current = "test_round_trip";
+    CHECK(path_at(&pl, pl.count) == NULL);
+    CHECK(!sd_playlist_add(&pl, "/sdcard/Muzyka/"));
+    sd_playlist_free(&pl);
+}
+
+static void test_get_path_buffer_size(void)
+{
+    sd_playlist_t pl;
+    sd_playlist_init(&pl, 4);
+    CHECK(sd_playlist_add(&pl, "/sd/a.mp3"));
+
+    char buf[16];
+    CHECK_INT(sd_playlist_get_path(&pl, 0, buf, 10), 9);     // Dokładnie na "/sd/a.mp3\0"
+    CHECK_STR(buf, "/sd/a.mp3");
+    CHECK_INT(sd_playlist_get_path(&pl, 0, buf, 9), 0);
+    CHECK_INT(sd_playlist_get_path(&pl, 0, buf, 0), 0);
+    sd_playlist_free(&pl);
+}
+
+static void test_limits(void)
+{
+    sd_playlist_t pl;
+    sd_playlist_init(&pl, 3);
+    CHECK(sd_playlist_add(&pl, "/a/1.mp3"));
+    CHECK(sd_playlist_add(&pl, "/a/2.mp3"));
+    CHECK(sd_playlist_add(&pl, "/a/3.mp3"));
+    CHECK(!sd_playlist_add(&pl, "/a/4.mp3"));
+    CHECK_INT(pl.count, 3);
+    sd_playlist_free(&pl);
+
+    // Limit katalogów: odrzucony wpis nie zostawia śladu w arenie
+    char path[64];
+    sd_playlist_init(&pl, SD_PLAYLIST_MAX_DIRS + 10);
+    for (int d = 0; d < SD_PLAYLIST_MAX_DIRS; d++) {
+        snprintf(path, sizeof(path), "/d%d/x.mp3", d);
+        CHECK(sd_playlist_add(&pl, path));
+    }
+    uint32_t arena = pl.arena_size;
+    CHECK(!sd_playlist_add(&pl, "/nowy/x.mp3"));
+    CHECK_INT(pl.arena_size, arena);
+    CHECK(sd_playlist_add(&pl, "/d17/y.mp3"));
+    CHECK_STR(path_at(&pl, pl.count - 1), "/d17/y.mp3");
+    CHECK_STR(path_at(&pl, SD_PLAYLIST_MAX_DIRS - 1), "/d8191/x.mp3");
+    sd_playlist_free(&pl);
+}
+
+static void test_sort_tail(void)
+{
+    sd_playlist_t pl;
+    sd_playlist_init(&pl, 10);
+    CHECK(sd_playlist_add(&pl, "/z/zzz.mp3"));         // Poprzedni katalog - nie ruszać
+    CHECK(sd_playlist_add(&pl, "/b/charlie.mp3"));
+    CHECK(sd_playlist_add(&pl, "/a/Bravo.flac"));
+    CHECK(sd_playlist_add(&pl, "/c/alpha.wav"));
+    sd_playlist_sort_tail(&pl, 1);
+
+    // Po nazwie pliku, bez wielkości liter, niezależnie od katalogu
+    CHECK_STR(path_at(&pl, 0), "/z/zzz.mp3");
+    CHECK_STR(path_at(&pl, 1), "/c/alpha.wav");
+    CHECK_STR(path_at(&pl, 2), "/a/Bravo.flac");
+    CHECK_STR(path_at(&pl, 3), "/b/charlie.mp3");
+    sd_playlist_free(&pl);
+}
+
+static void test_shuffle(void)
+{
+    enum { N = 500 };
+    char path[64];
+    sd_playlist_t pl;
+    sd_playlist_init(&pl, N);
+    for (int i = 0; i < N; i++) {
+        snprintf(path, sizeof(path), "/sd/%03d.mp3", i);
+        CHECK(sd_playlist_add(&pl, path));
+    }
+
+    lcg_state = 1;
+    CHECK_INT(sd_playlist_shuffle(&pl, 123, lcg), 0);
+    CHECK_STR(path_at(&pl, 0), "/sd/123.mp3");
+
+    // Permutacja: każdy plik dokładnie raz, kolejność faktycznie zmieniona
+    static bool seen[N];
+    int in_place = 0;
+    for (int i = 0; i < N; i++) {
+        const char *p = path_at(&pl, i);
+        CHECK(p != NULL);
+        if (p == NULL) continue;
+        int n = atoi(p + 4);
+        CHECK(!seen[n]);
+        seen[n] = true;
+        in_place += (n == i);
+    }
+    CHECK(in_place < N / 10);
+
+    CHECK_INT(sd_playlist_shuffle(&pl, -1, lcg), -1);
+    CHECK_INT(sd_playlist_shuffle(&pl, N, lcg), -1);
+    sd_playlist_free(&pl);
+
+    sd_playlist_init(&pl, 4);
+    CHECK(sd_playlist_add(&pl, "/sd/one.mp3"));
+    CHECK_INT(sd_playlist_shuffle(&pl, 0, lcg), 0);
+    CHECK_STR(path_at(&pl, 0), "/sd/one.mp3");
+    sd_playlist_free(&pl);
+}
+
+// Budżet z nagłówka: 10 000 plików "NN - Tytuł.mp3" z 12-znakowym rdzeniem nazwy ~190 KB
+static void test_memory_budget(void)
+{
+    enum { N = 10000 };
+    char path[96];
+    sd_playlist_t pl;
+    sd_playlist_init(&pl, N);
+    for (int i = 0; i < N; i++) {
+        snprintf(path, sizeof(path), "/sdcard/Artist %03d/Album/%02d - Song%03d.mp3",
+                 i / 12, i % 12, i % 1000);
+        CHECK(sd_playlist_add(&pl, path));
+    }
+    sd_playlist_compact(&pl);
+    CHECK_INT(pl.count, N);
+    CHECK_INT(pl.capacity, N);
+    CHECK_INT(pl.arena_capacity, pl.arena_size);
+    // Wpis: 4 B offsetu + 2 B nagłówka + 12 B nazwy + '\0'; katalogi osobno
+    size_t dirs = (size_t)pl.dir_capacity * sizeof(uint32_t) + pl.dir_count * sizeof("/sdcard/Artist 000/Album");
+    size_t mem = sd_playlist_memory(&pl);
+    printf("  10000 entries: %zu KB\n", mem / 1024);
+    CHECK_INT(mem, (size_t)N * 19 + dirs);
+    CHECK_STR(path_at(&pl, N - 1), "/sdcard/Artist 833/Album/03 - Song999.mp3");
+
+    // clear zostawia bufory - ponowne zbudowanie tej samej listy nie rośnie
+    sd_playlist_clear(&pl);
+    CHECK_INT(pl.count, 0);
+    CHECK(path_at(&pl, 0) == NULL);
+    for (int i = 0; i < N; i++) {
+        snprintf(path, sizeof(path), "/sdcard/Artist %03d/Album/%02d - Song%03d.mp3",
+                 i / 12, i % 12, i % 1000);
+        CHECK(sd_playlist_add(&pl, path));
+    }
+    CHECK_INT(sd_playlist_memory(&pl), mem);
+    sd_playlist_free(&pl);
+    CHECK_INT(sd_playlist_memory(&pl), 0);
+}
+
+int main(void)
+{
+    RUN_TEST(test_round_trip);
+    RUN_TEST(test_get_path_buffer_size);
+    RUN_TEST(test_limits);
+    RUN_TEST(test_sort_tail);
+    RUN_TEST(test_shuffle);
+    RUN_TEST(test_memory_budget);
+    return TEST_RESULT();
+}
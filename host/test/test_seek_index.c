@@ -0,0 +1,853 @@
+/*
+ * seek_index: pliki budowane w teście (tmpfile) ze znanymi offsetami ramek -
+ * MP3 (bez TOC, Xing, VBRI, Info/CBR), FLAC z SEEKTABLE i bez, WAV; granice utworu
+ * z LAME / iTunSMPB i przycinanie PCM między kolejnymi utworami (gapless)
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include "test_util.h"
+#include "seek_index.h"
+
+#define MP3_SPF         1152
+#define FLAC_BLOCK      4096
+#define RATE            44100
+
+static const int MP3_KBPS[15] = {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320};
+
+static uint32_t rnd_state;
+
+static uint32_t rnd(void)
+{
+    rnd_state = rnd_state * 1664525u + 1013904223u;
+    return rnd_state >> 8;
+}
+
+static void put_be(uint8_t *p, uint64_t v, int n)
+{
+    for (int i = n - 1; i >= 0; i--, v >>= 8) p[i] = (uint8_t)v;
+}
+
+static void put_le(uint8_t *p, uint32_t v, int n)
+{
+    for (int i = 0; i < n; i++, v >>= 8) p[i] = (uint8_t)v;
+}
+
+// ============================================
+// MP3
+// ============================================
+
+typedef enum { MP3_PLAIN, MP3_XING, MP3_VBRI, MP3_INFO } mp3_kind_t;
+
+typedef struct {
+    FILE *f;
+    uint32_t frames;
+    uint32_t *offsets;          // Początki ramek audio
+} test_file_t;
+
+static int mp3_frame(uint8_t *buf, int br_idx, int padding)
+{
+    int len = 144 * MP3_KBPS[br_idx] * 1000 / RATE + padding;
+    memset(buf, 0, len);
+    buf[0] = 0xFF;
+    buf[1] = 0xFB;
+    buf[2] = (uint8_t)((br_idx << 4) | (padding << 1));
+    buf[3] = 0x64;
+    return len;
+}
+
+// Tag ID3v2 na początku, ramka informacyjna (Xing/VBRI/Info) i audio. VBR: bitrate losowy
+// z 112-256 kbps, CBR: 128 kbps z dopełnieniem jak w koderze.
+static test_file_t mp3_file(mp3_kind_t kind, uint32_t frames)
+{
+    test_file_t t = { tmpfile(), frames, malloc(frames * sizeof(uint32_t)) };
+    uint8_t *frame_buf = malloc(2048);
+    uint8_t *lens = malloc(frames);
+    uint16_t *sizes = malloc(frames * sizeof(uint16_t));
+
+    static const uint8_t id3[10 + 118] = { 'I', 'D', '3', 3, 0, 0, 0, 0, 0, 118 };
+    fwrite(id3, 1, sizeof(id3), t.f);
+
+    // Najpierw długości ramek - ramka informacyjna potrzebuje sumy i TOC
+    uint32_t total_bytes = 0, acc = 0;
+    for (uint32_t i = 0; i < frames; i++) {
+        int padding = 0;
+        if (kind == MP3_INFO) {
+            lens[i] = 9;
+            acc += 144 * 128000 % RATE;
+            if (acc >= RATE) {
+                acc -= RATE;
+                padding = 1;
+            }
+        } else {
+            lens[i] = 8 + rnd() % 6;
+        }
+        sizes[i] = (uint16_t)(144 * MP3_KBPS[lens[i]] * 1000 / RATE + padding);
+        total_bytes += sizes[i];
+    }
+
+    uint32_t pos = sizeof(id3);
+    if (kind != MP3_PLAIN) {
+        int info_len = mp3_frame(frame_buf, 9, 0);
+        uint8_t *x = frame_buf + 4 + 32;
+        if (kind == MP3_VBRI) {
+            // 10 odcinków po frames/10 ramek, wpisy 3-bajtowe w bajtach (skala 1)
+            uint32_t per = frames / 10;
+            memcpy(x, "VBRI", 4);
+            put_be(x + 10, total_bytes + info_len, 4);
+            put_be(x + 14, frames, 4);
+            put_be(x + 18, 10, 2);
+            put_be(x + 20, 1, 2);
+            put_be(x + 22, 3, 2);
+            put_be(x + 24, per, 2);
+            for (uint32_t e = 0, f = 0; e < 10; e++) {
+                uint32_t bytes = 0;
+                for (uint32_t k = 0; k < per; k++) bytes += sizes[f++];
+                put_be(x + 26 + e * 3, bytes, 3);
+            }
+        } else {
+            memcpy(x, kind == MP3_XING ? "Xing" : "Info", 4);
+            put_be(x + 4, kind == MP3_XING ? 7 : 3, 4);
+            put_be(x + 8, frames, 4);
+            put_be(x + 12, total_bytes + info_len, 4);
+            if (kind == MP3_XING) {
+                uint32_t bytes = 0, f = 0;
+                for (int i = 0; i < 100; i++) {
+                    while (f < i * frames / 100) bytes += sizes[f++];
+                    x[16 + i] = (uint8_t)((uint64_t)(bytes + info_len) * 256 / (total_bytes + info_len));
+                }
+            }
+        }
+        fwrite(frame_buf, 1, info_len, t.f);
+        pos += info_len;
+    }
+
+    for (uint32_t i = 0; i < frames; i++) {
+        int len = mp3_frame(frame_buf, lens[i], sizes[i] != 144 * MP3_KBPS[lens[i]] * 1000 / RATE);
+        t.offsets[i] = pos;
+        fwrite(frame_buf, 1, len, t.f);
+        pos += len;
+    }
+    fflush(t.f);
+    free(frame_buf);
+    free(lens);
+    free(sizes);
+    return t;
+}
+
+static void test_file_close(test_file_t *t)
+{
+    fclose(t->f);
+    free(t->offsets);
+}
+
+// Wynik dokładny: początek właściwej ramki i przycięcie do próbki celu
+static void check_exact(const test_file_t *t, uint32_t ms, const seek_point_t *p)
+{
+    uint64_t target = (uint64_t)ms * RATE / 1000;
+    uint32_t frame = (uint32_t)(target / MP3_SPF);
+    if (frame >= t->frames) {
+        frame = t->frames - 1;
+        target = (uint64_t)frame * MP3_SPF;
+    }
+    CHECK(p->exact);
+    CHECK_INT(p->byte_pos, t->offsets[frame]);
+    CHECK_INT(p->sample, (uint64_t)frame * MP3_SPF);
+    CHECK_INT(p->sample + p->skip_samples, target);
+    CHECK_INT(p->sample_rate, RATE);
+    CHECK_INT(p->header_len, 0);
+}
+
+static int frame_at(const test_file_t *t, uint32_t pos)
+{
+    for (uint32_t i = 0; i < t->frames; i++) {
+        if (t->offsets[i] == pos) return (int)i;
+    }
+    return -1;
+}
+
+static const uint32_t TARGETS_MS[] = { 0, 1, 26, 1000, 12345, 30000, 47111, 52000, 999999 };
+#define TARGET_COUNT (sizeof(TARGETS_MS) / sizeof(TARGETS_MS[0]))
+
+static void test_mp3_frame_table(void)
+{
+    test_file_t t = mp3_file(MP3_PLAIN, 2000);     // ~52 s
+    CHECK(seek_index_mp3_needs_table(t.f));
+
+    seek_mp3_table_t table;
+    CHECK(seek_index_mp3_build(t.f, &table));
+    CHECK_INT(table.total_frames, 2000);
+    CHECK_INT(table.count, (2000 + SEEK_MP3_FRAMES_PER_ENTRY - 1) / SEEK_MP3_FRAMES_PER_ENTRY);
+    CHECK_INT(table.samples_per_frame, MP3_SPF);
+    CHECK_INT(table.offsets[1], t.offsets[SEEK_MP3_FRAMES_PER_ENTRY]);
+
+    for (size_t i = 0; i < TARGET_COUNT; i++) {
+        seek_point_t p;
+        CHECK(seek_index_locate(t.f, ESP_CODEC_TYPE_MP3, TARGETS_MS[i], &table, &p));
+        check_exact(&t, TARGETS_MS[i], &p);
+    }
+
+    // Bez tabeli: szacunek z bitrate pierwszej ramki - początek jakiejś ramki, bez przycinania
+    for (size_t i = 0; i < TARGET_COUNT; i++) {
+        seek_point_t p;
+        CHECK(seek_index_locate(t.f, ESP_CODEC_TYPE_MP3, TARGETS_MS[i], NULL, &p));
+        CHECK(!p.exact || TARGETS_MS[i] == 0);
+        CHECK(frame_at(&t, p.byte_pos) >= 0);
+        CHECK_INT(p.skip_samples, 0);
+    }
+    seek_index_mp3_free(&table);
+    test_file_close(&t);
+}
+
+static void test_mp3_table_file(void)
+{
+    test_file_t t = mp3_file(MP3_PLAIN, 300);
+    seek_mp3_table_t table, loaded;
+    CHECK(seek_index_mp3_build(t.f, &table));
+
+    char path[] = "/tmp/seek_index_XXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    close(fd);
+    CHECK(seek_index_mp3_save(path, &table));
+    CHECK(seek_index_mp3_load(path, table.file_size, &loaded));
+    CHECK_INT(loaded.count, table.count);
+    CHECK_INT(loaded.total_frames, table.total_frames);
+    CHECK_INT(loaded.sample_rate, RATE);
+    CHECK(memcmp(loaded.offsets, table.offsets, table.count * sizeof(uint32_t)) == 0);
+    seek_index_mp3_free(&loaded);
+
+    // Tabela innego pliku (rozmiar) i uszkodzony plik tabeli
+    CHECK(!seek_index_mp3_load(path, table.file_size + 1, &loaded));
+    CHECK(loaded.offsets == NULL);
+    FILE *f = fopen(path, "r+b");
+    fseek(f, 20, SEEK_SET);
+    uint32_t bogus = 0xFFFFFF;
+    fwrite(&bogus, sizeof(bogus), 1, f);
+    fclose(f);
+    CHECK(!seek_index_mp3_load(path, table.file_size, &loaded));
+    CHECK(!seek_index_mp3_load("/tmp/seek_index_missing.idx", table.file_size, &loaded));
+    remove(path);
+
+    seek_index_mp3_free(&table);
+    test_file_close(&t);
+}
+
+static void test_mp3_vbri(void)
+{
+    test_file_t t = mp3_file(MP3_VBRI, 2000);
+    CHECK(!seek_index_mp3_needs_table(t.f));
+    for (size_t i = 0; i < TARGET_COUNT; i++) {
+        seek_point_t p;
+        CHECK(seek_index_locate(t.f, ESP_CODEC_TYPE_MP3, TARGETS_MS[i], NULL, &p));
+        check_exact(&t, TARGETS_MS[i], &p);
+    }
+    test_file_close(&t);
+}
+
+// TOC Xing ma rozdzielczość 1% pliku i 1/256 rozmiaru - pozycja w kilku ramkach od celu
+static void test_mp3_xing_toc(void)
+{
+    test_file_t t = mp3_file(MP3_XING, 2000);
+    CHECK(seek_index_mp3_needs_table(t.f));
+    for (size_t i = 0; i < TARGET_COUNT; i++) {
+        seek_point_t p;
+        CHECK(seek_index_locate(t.f, ESP_CODEC_TYPE_MP3, TARGETS_MS[i], NULL, &p));
+        uint32_t frame = (uint32_t)((uint64_t)TARGETS_MS[i] * RATE / 1000 / MP3_SPF);
+        if (frame >= t.frames) frame = t.frames - 1;
+        int found = frame_at(&t, p.byte_pos);
+        CHECK(found >= 0);
+        CHECK(abs(found - (int)frame) <= 12);
+        CHECK(!p.exact);
+    }
+
+    // Z tabelą ramek - dokładnie mimo TOC
+    seek_mp3_table_t table;
+    CHECK(seek_index_mp3_build(t.f, &table));
+    CHECK_INT(table.offsets[0], t.offsets[0]);      // Bez ramki Xing
+    for (size_t i = 0; i < TARGET_COUNT; i++) {
+        seek_point_t p;
+        CHECK(seek_index_locate(t.f, ESP_CODEC_TYPE_MP3, TARGETS_MS[i], &table, &p));
+        check_exact(&t, TARGETS_MS[i], &p);
+    }
+    seek_index_mp3_free(&table);
+    test_file_close(&t);
+}
+
+// Info (CBR) z dopełnieniem co kilka ramek - szacunek trafia w ramkę
+static void test_mp3_info_cbr(void)
+{
+    test_file_t t = mp3_file(MP3_INFO, 2000);
+    CHECK(!seek_index_mp3_needs_table(t.f));
+    for (size_t i = 0; i < TARGET_COUNT; i++) {
+        seek_point_t p;
+        CHECK(seek_index_locate(t.f, ESP_CODEC_TYPE_MP3, TARGETS_MS[i], NULL, &p));
+        check_exact(&t, TARGETS_MS[i], &p);
+    }
+    test_file_close(&t);
+}
+
+// ============================================
+// FLAC
+// ============================================
+
+static uint8_t crc8(const uint8_t *p, int len)
+{
+    uint8_t crc = 0;
+    while (len--) {
+        crc ^= *p++;
+        for (int i = 0; i < 8; i++) crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+    }
+    return crc;
+}
+
+// Stały blok 4096, stereo 16 bit; treść ramek losowa (bez 0xFF - bez fałszywych synchronizacji)
+static test_file_t flac_file(uint32_t frames, int seek_every, uint8_t *streaminfo)
+{
+    test_file_t t = { tmpfile(), frames, malloc(frames * sizeof(uint32_t)) };
+    uint64_t samples = (uint64_t)frames * FLAC_BLOCK;
+
+    uint8_t *si = streaminfo;
+    memset(si, 0, 34);
+    put_be(si, FLAC_BLOCK, 2);
+    put_be(si + 2, FLAC_BLOCK, 2);
+    put_be(si + 4, 100, 3);
+    put_be(si + 7, 9000, 3);
+    si[10] = (RATE >> 12) & 0xFF;
+    si[11] = (RATE >> 4) & 0xFF;
+    si[12] = ((RATE & 0xF) << 4) | (1 << 1);
+    si[13] = (15 << 4) | ((samples >> 32) & 0xF);
+    put_be(si + 14, samples & 0xFFFFFFFF, 4);
+
+    uint8_t **bodies = malloc(frames * sizeof(uint8_t *));
+    uint32_t *lens = malloc(frames * sizeof(uint32_t));
+    uint32_t rel = 0;
+    for (uint32_t n = 0; n < frames; n++) {
+        uint8_t h[16] = { 0xFF, 0xF8, 0xC9, 0x18 };
+        int hl = 4;
+        if (n < 0x80) {
+            h[hl++] = n;
+        } else {
+            h[hl++] = 0xC0 | (n >> 6);
+            h[hl++] = 0x80 | (n & 0x3F);
+        }
+        h[hl] = crc8(h, hl);
+        hl++;
+        uint32_t body = 1500 + rnd() % 6000;
+        lens[n] = hl + body;
+        bodies[n] = malloc(lens[n]);
+        memcpy(bodies[n], h, hl);
+        for (uint32_t i = 0; i < body; i++) bodies[n][hl + i] = rnd() % 0xFE;
+        t.offsets[n] = rel;
+        rel += lens[n];
+    }
+
+    fwrite("fLaC", 1, 4, t.f);
+    uint8_t bh[4] = { seek_every ? 0x00 : 0x80, 0, 0, 34 };
+    fwrite(bh, 1, 4, t.f);
+    fwrite(si, 1, 34, t.f);
+    uint32_t header = 4 + 4 + 34;
+    if (seek_every) {
+        uint32_t points = (frames + seek_every - 1) / seek_every + 2;     // + 2 zastępcze
+        put_be(bh + 1, points * 18, 3);
+        bh[0] = 0x83;
+        fwrite(bh, 1, 4, t.f);
+        for (uint32_t n = 0; n < frames; n += seek_every) {
+            uint8_t sp[18];
+            put_be(sp, (uint64_t)n * FLAC_BLOCK, 8);
+            put_be(sp + 8, t.offsets[n], 8);
+            put_be(sp + 16, FLAC_BLOCK, 2);
+            fwrite(sp, 1, sizeof(sp), t.f);
+        }
+        for (int i = 0; i < 2; i++) {
+            uint8_t sp[18];
+            memset(sp, 0xFF, 8);
+            memset(sp + 8, 0, 10);
+            fwrite(sp, 1, sizeof(sp), t.f);
+        }
+        header += 4 + points * 18;
+    }
+    for (uint32_t n = 0; n < frames; n++) {
+        fwrite(bodies[n], 1, lens[n], t.f);
+        free(bodies[n]);
+        t.offsets[n] += header;
+    }
+    fflush(t.f);
+    free(bodies);
+    free(lens);
+    return t;
+}
+
+static void check_flac(const test_file_t *t, const uint8_t *si, uint32_t ms, const seek_point_t *p)
+{
+    uint64_t target = (uint64_t)ms * RATE / 1000;
+    uint64_t total = (uint64_t)t->frames * FLAC_BLOCK;
+    if (target >= total) target = total - 1;
+    uint32_t frame = (uint32_t)(target / FLAC_BLOCK);
+    CHECK(p->exact);
+    CHECK_INT(p->byte_pos, t->offsets[frame]);
+    CHECK_INT(p->sample, (uint64_t)frame * FLAC_BLOCK);
+    CHECK_INT(p->skip_samples, target - p->sample);
+    CHECK_INT(p->header_len, 42);
+    CHECK(memcmp(p->header, "fLaC\x80\x00\x00\x22", 8) == 0);
+    CHECK(memcmp(p->header + 8, si, 34) == 0);
+}
+
+static void test_flac(void)
+{
+    static const int seek_every[] = { 20, 0 };     // SEEKTABLE co 20 ramek / bez
+    for (int k = 0; k < 2; k++) {
+        test_current = seek_every[k] ? "flac seektable" : "flac bisection";
+        uint8_t si[34];
+        test_file_t t = flac_file(600, seek_every[k], si);     // ~56 s, ~2.7 MB
+        for (size_t i = 0; i < TARGET_COUNT; i++) {
+            seek_point_t p;
+            CHECK(seek_index_locate(t.f, ESP_CODEC_TYPE_FLAC, TARGETS_MS[i], NULL, &p));
+            check_flac(&t, si, TARGETS_MS[i], &p);
+        }
+        seek_track_info_t info;
+        CHECK(seek_index_track_info(t.f, ESP_CODEC_TYPE_FLAC, &info));
+        CHECK_INT(info.sample_rate, RATE);
+        CHECK_INT(info.channels, 2);
+        CHECK_INT(info.bits, 16);
+        test_file_close(&t);
+    }
+}
+
+// ============================================
+// WAV i formaty bez przewijania
+// ============================================
+
+static void test_wav(void)
+{
+    // Chunk przed fmt, WAVE_FORMAT_EXTENSIBLE, 24 bit stereo 48 kHz
+    FILE *f = tmpfile();
+    uint8_t h[12 + 8 + 3 + 1 + 8 + 40 + 8];
+    memset(h, 0, sizeof(h));
+    uint32_t data_len = 48000 * 6 * 3;
+    memcpy(h, "RIFF", 4);
+    put_le(h + 4, sizeof(h) - 8 + data_len, 4);
+    memcpy(h + 8, "WAVE", 4);
+    memcpy(h + 12, "junk", 4);
+    put_le(h + 16, 3, 4);                       // Nieparzysty - bajt dopełnienia
+    uint8_t *fmt = h + 12 + 8 + 4;
+    memcpy(fmt, "fmt ", 4);
+    put_le(fmt + 4, 40, 4);
+    put_le(fmt + 8, 0xFFFE, 2);
+    put_le(fmt + 10, 2, 2);
+    put_le(fmt + 12, 48000, 4);
+    put_le(fmt + 16, 48000 * 6, 4);
+    put_le(fmt + 20, 6, 2);
+    put_le(fmt + 22, 24, 2);
+    uint8_t *data = fmt + 8 + 40;
+    memcpy(data, "data", 4);
+    put_le(data + 4, data_len, 4);
+    fwrite(h, 1, sizeof(h), f);
+    uint8_t *pcm = calloc(1, data_len);
+    fwrite(pcm, 1, data_len, f);
+    free(pcm);
+    fflush(f);
+    uint32_t data_pos = sizeof(h);
+
+    seek_point_t p;
+    CHECK(seek_index_locate(f, ESP_CODEC_TYPE_WAV, 1500, NULL, &p));
+    CHECK(p.exact);
+    CHECK_INT(p.sample, 72000);
+    CHECK_INT(p.byte_pos, data_pos + 72000 * 6);
+    CHECK_INT(p.skip_samples, 0);
+    CHECK_INT(p.sample_rate, 48000);
+    CHECK_INT(p.header_len, 44);
+    uint32_t remaining = data_len - 72000 * 6;
+    CHECK(memcmp(p.header, "RIFF", 4) == 0 && memcmp(p.header + 8, "WAVEfmt ", 8) == 0);
+    CHECK_INT(p.header[4] | (p.header[5] << 8) | (p.header[6] << 16) | ((uint32_t)p.header[7] << 24),
+              36 + remaining);
+    CHECK_INT(p.header[20], 1);                 // EXTENSIBLE -> PCM
+    CHECK_INT(p.header[22], 2);
+    CHECK_INT(p.header[34], 24);
+    CHECK_INT(p.header[40] | (p.header[41] << 8) | (p.header[42] << 16) | ((uint32_t)p.header[43] << 24),
+              remaining);
+
+    // Za końcem - ostatnia ramka PCM
+    CHECK(seek_index_locate(f, ESP_CODEC_TYPE_WAV, 60000, NULL, &p));
+    CHECK_INT(p.sample, 48000 * 3 - 1);
+    fclose(f);
+}
+
+static void test_unsupported(void)
+{
+    test_file_t t = mp3_file(MP3_PLAIN, 50);
+    seek_point_t p;
+    CHECK(!seek_index_locate(t.f, ESP_CODEC_TYPE_M4A, 1000, NULL, &p));
+    CHECK(!seek_index_locate(t.f, ESP_CODEC_TYPE_AAC, 1000, NULL, &p));
+    CHECK(!seek_index_locate(t.f, ESP_CODEC_TYPE_FLAC, 1000, NULL, &p));
+    CHECK(!seek_index_locate(t.f, ESP_CODEC_TYPE_WAV, 1000, NULL, &p));
+    test_file_close(&t);
+
+    FILE *f = tmpfile();
+    for (int i = 0; i < 20000; i++) fputc(rnd() & 0x7F, f);
+    fflush(f);
+    CHECK(!seek_index_locate(f, ESP_CODEC_TYPE_MP3, 1000, NULL, &p));
+    seek_mp3_table_t table;
+    CHECK(!seek_index_mp3_build(f, &table));
+    CHECK(table.offsets == NULL);
+    fclose(f);
+}
+
+// ============================================
+// Granice utworu i przycinanie (gapless)
+// ============================================
+
+#define DECODER_DELAY   529
+
+// Info + znacznik LAME (lub "Lavc" z ffmpeg): delay/padding po 12 bitów
+static FILE *lame_mp3(uint32_t frames, uint32_t delay, uint32_t padding, const char *encoder)
+{
+    FILE *f = tmpfile();
+    uint8_t buf[2048];
+    static const uint8_t id3[10 + 22] = { 'I', 'D', '3', 4, 0, 0, 0, 0, 0, 22 };
+    fwrite(id3, 1, sizeof(id3), f);
+
+    int len = mp3_frame(buf, 9, 0);
+    uint8_t *x = buf + 4 + 32;
+    memcpy(x, "Info", 4);
+    put_be(x + 4, 0xF, 4);                  // Ramki, bajty, TOC, jakość
+    put_be(x + 8, frames, 4);
+    put_be(x + 12, (frames + 1) * len, 4);
+    uint8_t *l = x + 8 + 4 + 4 + 100 + 4;
+    memcpy(l, encoder, 4);
+    l[21] = delay >> 4;
+    l[22] = ((delay & 0x0F) << 4) | (padding >> 8);
+    l[23] = padding & 0xFF;
+    fwrite(buf, 1, len, f);
+    for (uint32_t i = 0; i < frames; i++) {
+        fwrite(buf, 1, mp3_frame(buf, 9, 0), f);
+    }
+    fflush(f);
+    return f;
+}
+
+static void test_track_info_lame(void)
+{
+    static const char *encoders[] = { "LAME", "Lavc" };
+    for (int e = 0; e < 2; e++) {
+        test_current = encoders[e];
+        FILE *f = lame_mp3(400, 576, 1260, encoders[e]);
+        seek_track_info_t info;
+        CHECK(seek_index_track_info(f, ESP_CODEC_TYPE_MP3, &info));
+        CHECK_INT(info.start_pos, 32 + 417);    // Za ramką Info
+        CHECK_INT(info.skip_samples, 576 + DECODER_DELAY);
+        CHECK_INT(info.total_samples, 400 * MP3_SPF - 576 - 1260);
+        CHECK_INT(info.sample_rate, RATE);
+        CHECK_INT(info.channels, 2);
+        CHECK_INT(info.bits, 16);
+        fclose(f);
+    }
+
+    // Nieznany koder w miejscu znacznika - bez przycinania
+    test_current = "no tag";
+    FILE *f = lame_mp3(400, 576, 1260, "XXXX");
+    seek_track_info_t info;
+    CHECK(seek_index_track_info(f, ESP_CODEC_TYPE_MP3, &info));
+    CHECK_INT(info.start_pos, 32 + 417);
+    CHECK_INT(info.skip_samples, 0);
+    CHECK_INT(info.total_samples, 0);
+    fclose(f);
+}
+
+// iTunes zapisuje iTunSMPB także w MP3: ramka COMM w UTF-16 z BOM
+static void test_track_info_itunsmpb_mp3(void)
+{
+    static const char smpb[] = " 00000000 00000840 000001C0 0000000000046E00";
+    uint8_t comm[256];
+    int n = 0;
+    comm[n++] = 1;
+    memcpy(comm + n, "eng", 3);
+    n += 3;
+    const char *parts[] = { "iTunSMPB", smpb };
+    for (int p = 0; p < 2; p++) {
+        comm[n++] = 0xFF;
+        comm[n++] = 0xFE;
+        for (const char *c = parts[p]; *c; c++) {
+            comm[n++] = *c;
+            comm[n++] = 0;
+        }
+        if (p == 0) {
+            comm[n++] = 0;
+            comm[n++] = 0;
+        }
+    }
+
+    FILE *f = tmpfile();
+    uint8_t hdr[10] = { 'I', 'D', '3', 3, 0, 0 };
+    uint32_t tag = 10 + n + 16;
+    hdr[6] = (tag >> 21) & 0x7F;
+    hdr[7] = (tag >> 14) & 0x7F;
+    hdr[8] = (tag >> 7) & 0x7F;
+    hdr[9] = tag & 0x7F;
+    fwrite(hdr, 1, sizeof(hdr), f);
+    uint8_t fh[10] = { 'C', 'O', 'M', 'M' };
+    put_be(fh + 4, n, 4);
+    fwrite(fh, 1, sizeof(fh), f);
+    fwrite(comm, 1, n, f);
+    uint8_t buf[2048] = {0};
+    fwrite(buf, 1, 16, f);
+    for (int i = 0; i < 100; i++) {
+        fwrite(buf, 1, mp3_frame(buf, 9, 0), f);
+    }
+    fflush(f);
+
+    seek_track_info_t info;
+    CHECK(seek_index_track_info(f, ESP_CODEC_TYPE_MP3, &info));
+    CHECK_INT(info.start_pos, 10 + tag);
+    CHECK_INT(info.skip_samples, 0x840);
+    CHECK_INT(info.total_samples, 0x46E00);
+    fclose(f);
+}
+
+static void atom(FILE *f, const char *type, const void *body, uint32_t len)
+{
+    uint8_t h[8];
+    put_be(h, 8 + len, 4);
+    memcpy(h + 4, type, 4);
+    fwrite(h, 1, 8, f);
+    if (body) fwrite(body, 1, len, f);
+}
+
+// M4A: stsd mp4a (format) i wpis "----" iTunSMPB w moov/udta/meta/ilst, moov za mdat
+static void test_track_info_m4a(void)
+{
+    static const char smpb[] = " 00000000 00000840 00000154 00000000001D2E6C 00000000";
+    uint8_t entry[36] = {0};
+    put_be(entry, 36, 4);
+    memcpy(entry + 4, "mp4a", 4);
+    put_be(entry + 14, 1, 2);
+    put_be(entry + 24, 2, 2);
+    put_be(entry + 26, 16, 2);
+    put_be(entry + 32, 44100, 2);
+    uint8_t stsd[8 + 36] = {0};
+    put_be(stsd + 4, 1, 4);
+    memcpy(stsd + 8, entry, 36);
+
+    uint32_t data_len = 8 + sizeof(smpb) - 1;
+    uint32_t item_len = (8 + 4 + 16) + (8 + 4 + 8) + (8 + data_len);
+    uint32_t ilst_len = 8 + 8 + item_len;
+    uint32_t hdlr_len = 8 + 25;
+    uint32_t meta_len = 8 + 4 + hdlr_len + ilst_len;
+    uint32_t stbl_len = 8 + sizeof(stsd) + 8;
+    uint32_t trak_len = 8 + 8 + 8 + stbl_len;      // trak/mdia/minf/stbl
+
+    FILE *f = tmpfile();
+    atom(f, "ftyp", "M4A \0\0\0\0", 8);
+    static const uint8_t mdat[2000];
+    atom(f, "mdat", mdat, sizeof(mdat));
+    atom(f, "moov", NULL, 8 + 100 + trak_len + 8 + meta_len);
+    static const uint8_t mvhd[100];
+    atom(f, "mvhd", mvhd, sizeof(mvhd));
+    atom(f, "trak", NULL, trak_len - 8);
+    atom(f, "mdia", NULL, trak_len - 16);
+    atom(f, "minf", NULL, trak_len - 24);
+    atom(f, "stbl", NULL, stbl_len - 8);
+    atom(f, "stsd", stsd, sizeof(stsd));
+    atom(f, "udta", NULL, meta_len);
+    atom(f, "meta", "\0\0\0\0", 4);
+    // Rozmiar meta obejmuje dzieci - poprawiony niżej
+    long meta_pos = ftell(f) - 12;
+    static const uint8_t hdlr[25];
+    atom(f, "hdlr", hdlr, sizeof(hdlr));
+    atom(f, "ilst", NULL, 8 + item_len);
+    atom(f, "----", NULL, item_len);
+    atom(f, "mean", "\0\0\0\0com.apple.iTunes", 20);
+    atom(f, "name", "\0\0\0\0iTunSMPB", 12);
+    uint8_t data[128];
+    put_be(data, 1, 4);
+    put_be(data + 4, 0, 4);
+    memcpy(data + 8, smpb, sizeof(smpb) - 1);
+    atom(f, "data", data, data_len);
+    uint8_t size[4];
+    put_be(size, meta_len, 4);
+    fseek(f, meta_pos, SEEK_SET);
+    fwrite(size, 1, 4, f);
+    fflush(f);
+
+    seek_track_info_t info;
+    CHECK(seek_index_track_info(f, ESP_CODEC_TYPE_M4A, &info));
+    CHECK_INT(info.skip_samples, 0x840);
+    CHECK_INT(info.total_samples, 0x1D2E6C);
+    CHECK_INT(info.sample_rate, 44100);
+    CHECK_INT(info.channels, 2);
+    CHECK_INT(info.bits, 16);
+
+    seek_point_t p;
+    CHECK(!seek_index_locate(f, ESP_CODEC_TYPE_M4A, 1000, NULL, &p));
+    fclose(f);
+}
+
+// Dekoder MP3 w modelu: wyjście = sygnał przesunięty o opóźnienie kodera i 529 próbek
+// syntezy, całe ramki po 1152 próbki. Próbka niesie (utwór, numer próbki oryginału).
+typedef struct {
+    int track;
+    uint32_t length;                // Próbki oryginału
+    uint32_t delay;
+    uint32_t frames;
+} model_track_t;
+
+static void decoded_sample(const model_track_t *t, uint32_t i, int16_t *lr)
+{
+    int64_t src = (int64_t)i - t->delay - DECODER_DELAY;
+    bool in = src >= 0 && src < t->length;
+    lr[0] = in ? (int16_t)(src & 0x7FFF) : -1;
+    lr[1] = in ? (int16_t)(t->track * 1000 + (src >> 15)) : -1;
+}
+
+// Porcje zapisu dekodera o losowej długości (wielokrotność próbki), jak sd_decoder_write_cb
+static uint32_t replay_track(const model_track_t *t, seek_trim_t *trim, uint64_t from_sample,
+                             int16_t *out, uint32_t out_frames)
+{
+    uint32_t produced = 0;
+    uint64_t total = (uint64_t)t->frames * MP3_SPF;
+    int16_t block[2 * 2048];
+    for (uint64_t i = from_sample; i < total;) {
+        uint32_t n = 1 + rnd() % 2048;
+        if (n > total - i) n = (uint32_t)(total - i);
+        for (uint32_t k = 0; k < n; k++) decoded_sample(t, (uint32_t)(i + k), block + 2 * k);
+        int skip;
+        int avail = seek_trim_block(trim, n * 4, &skip);
+        CHECK(skip % 4 == 0 && avail % 4 == 0 && avail >= 0);
+        if (avail > 0 && produced + avail / 4 <= out_frames) {
+            memcpy(out + 2 * produced, (uint8_t *)block + skip, avail);
+            produced += avail / 4;
+            seek_trim_written(trim, avail);
+        }
+        i += n;
+    }
+    return produced;
+}
+
+static void test_gapless_replay(void)
+{
+    enum { OUT_MAX = 3 * 1000 * MP3_SPF };
+    static int16_t out[2 * OUT_MAX];
+    static const model_track_t tracks[] = {
+        { 1, 1000000, 576, 0 },
+        { 2, 44100 * 7 + 13, 576, 0 },
+        { 3, 300000, 1105, 0 },             // Inny koder (np. iTunes)
+    };
+
+    uint32_t produced = 0;
+    for (int k = 0; k < 3; k++) {
+        model_track_t t = tracks[k];
+        // Koder dopełnia do pełnych ramek - co najmniej opóźnieniem syntezy dekodera
+        t.frames = (t.delay + t.length + DECODER_DELAY + MP3_SPF - 1) / MP3_SPF;
+        uint32_t padding = t.frames * MP3_SPF - t.delay - t.length;
+
+        FILE *f = lame_mp3(t.frames, t.delay, padding, "LAME");
+        seek_track_info_t info;
+        CHECK(seek_index_track_info(f, ESP_CODEC_TYPE_MP3, &info));
+        fclose(f);
+        CHECK_INT(info.total_samples, t.length);
+
+        seek_trim_t trim;
+        seek_trim_init(&trim, &info);
+        CHECK_INT(trim.frame_bytes, 4);
+        produced += replay_track(&t, &trim, 0, out + 2 * produced, OUT_MAX - produced);
+    }
+
+    // Utwory jeden za drugim: każda próbka oryginału dokładnie raz, bez ciszy między nimi
+    uint32_t pos = 0;
+    for (int k = 0; k < 3; k++) {
+        test_current = k == 0 ? "track 1" : k == 1 ? "track 2" : "track 3";
+        int bad = 0;
+        for (uint32_t i = 0; i < tracks[k].length && pos + i < produced; i++) {
+            const int16_t *lr = out + 2 * (pos + i);
+            if (lr[0] != (int16_t)(i & 0x7FFF) || lr[1] != (int16_t)(tracks[k].track * 1000 + (i >> 15))) {
+                if (bad++ == 0) {
+                    fprintf(stderr, "  sample %u: (%d, %d)\n", i, lr[0], lr[1]);
+                }
+            }
+        }
+        CHECK_INT(bad, 0);
+        pos += tracks[k].length;
+    }
+    CHECK_INT(produced, pos);
+}
+
+// Przewinięcie wewnątrz ramki: pierwsza próbka to dokładnie cel, koniec utworu bez zmian
+static void test_seek_trim(void)
+{
+    model_track_t t = { 1, 500000, 576, 0 };
+    t.frames = (t.delay + t.length + DECODER_DELAY + MP3_SPF - 1) / MP3_SPF;
+    uint32_t padding = t.frames * MP3_SPF - t.delay - t.length;
+    FILE *f = lame_mp3(t.frames, t.delay, padding, "LAME");
+    seek_track_info_t info;
+    CHECK(seek_index_track_info(f, ESP_CODEC_TYPE_MP3, &info));
+    fclose(f);
+
+    static int16_t out[2 * 600000];
+    uint32_t targets[] = { 0, 1000, 5000 };
+    for (int k = 0; k < 3; k++) {
+        // Punkt jak z seek_index_locate dla CBR z Info (dokładny)
+        uint64_t target = (uint64_t)targets[k] * RATE / 1000;
+        seek_point_t point = {0};
+        point.sample = target / MP3_SPF * MP3_SPF;
+        point.skip_samples = (uint32_t)(target - point.sample);
+        point.sample_rate = RATE;
+        point.exact = true;
+
+        seek_trim_t trim;
+        uint64_t first = seek_trim_seek(&trim, &info, &point, 0, 0, 0);
+        CHECK_INT(first, target);
+        uint32_t n = replay_track(&t, &trim, point.sample, out, 600000);
+        CHECK_INT(n, t.length - target);
+        CHECK_INT(out[0], (int16_t)(target & 0x7FFF));
+        CHECK_INT(out[2 * (n - 1)], (int16_t)((t.length - 1) & 0x7FFF));
+
+        // Format z dekodera inny niż punktu - bez przycinania w ramce
+        first = seek_trim_seek(&trim, &info, &point, 48000, 2, 16);
+        CHECK_INT(first, point.sample);
+        CHECK_INT(trim.skip_bytes, 0);
+    }
+}
+
+// Bez granic z nagłówka (lub format nieznany) - wszystko przechodzi
+static void test_trim_passthrough(void)
+{
+    seek_track_info_t info = {0};
+    seek_trim_t trim;
+    seek_trim_init(&trim, &info);
+    int skip;
+    CHECK_INT(seek_trim_block(&trim, 4096, &skip), 4096);
+    CHECK_INT(skip, 0);
+
+    info.sample_rate = 48000;
+    info.channels = 2;
+    info.bits = 24;
+    info.skip_samples = 10;
+    seek_trim_init(&trim, &info);
+    CHECK_INT(trim.frame_bytes, 6);
+    CHECK(!trim.trim_end);
+    CHECK_INT(seek_trim_block(&trim, 36, &skip), 0);
+    CHECK_INT(skip, 36);
+    CHECK_INT(seek_trim_block(&trim, 600, &skip), 576);
+    CHECK_INT(skip, 24);
+}
+
+int main(void)
+{
+    rnd_state = 7;
+    RUN_TEST(test_mp3_frame_table);
+    RUN_TEST(test_mp3_table_file);
+    RUN_TEST(test_mp3_vbri);
+    RUN_TEST(test_mp3_xing_toc);
+    RUN_TEST(test_mp3_info_cbr);
+    RUN_TEST(test_flac);
+    RUN_TEST(test_wav);
+    RUN_TEST(test_unsupported);
+    RUN_TEST(test_track_info_lame);
+    RUN_TEST(test_track_info_itunsmpb_mp3);
+    RUN_TEST(test_track_info_m4a);
+    RUN_TEST(test_gapless_replay);
+    RUN_TEST(test_seek_trim);
+    RUN_TEST(test_trim_passthrough);
+    return TEST_RESULT();
+}
@@ -0,0 +1,62 @@
+/*
+ * Minimalne asercje testów hosta - błąd jest zgłaszany i test biegnie dalej,
+ * kod wyjścia != 0, jeśli cokolwiek się nie zgadzało
+ */
+
+#ifndef TEST_UTIL_H
+#define TEST_UTIL_H
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+static int test_failures = 0;
+static const char *test_current = "";
+
+#define CHECK(cond) do {                                                        \
+        if (!(cond)) {                                                          \
+            fprintf(stderr, "%s:%d: %s: CHECK(%s) failed\n",                    \
+                    __FILE__, __LINE__, test_current, #cond);                   \
+            test_failures++;                                                    \
+        }                                                                       \
+    } while (0)
+
+#define CHECK_INT(actual, expected) do {                                        \
+        long long a_ = (long long)(actual), e_ = (long long)(expected);         \
+        if (a_ != e_) {                                                         \
+            fprintf(stderr, "%s:%d: %s: %s == %lld, expected %lld\n",           \
+                    __FILE__, __LINE__, test_current, #actual, a_, e_);         \
+            test_failures++;                                                    \
+        }                                                                       \
+    } while (0)
+
+#define CHECK_STR(actual, expected) do {                                        \
+        const char *a_ = (actual), *e_ = (expected);                            \
+        if (a_ == NULL || strcmp(a_, e_) != 0) {                                \
+            fprintf(stderr, "%s:%d: %s: %s == \"%s\", expected \"%s\"\n",       \
+                    __FILE__, __LINE__, test_current, #actual,                  \
+                    a_ ? a_ : "(null)", e_);                                    \
+            test_failures++;                                                    \
+        }                                                                       \
+    } while (0)
+
+#define CHECK_NEAR(actual, expected, tol) do {                                  \
+        double a_ = (actual), e_ = (expected);                                  \
+        if (!(fabs(a_ - e_) <= (tol))) {                                        \
+            fprintf(stderr, "%s:%d: %s: %s == %g, expected %g +- %g\n",         \
+                    __FILE__, __LINE__, test_current, #actual, a_, e_,          \
+                    (double)(tol));                                             \
+            test_failures++;                                                    \
+        }                                                                       \
+    } while (0)
+
+#define RUN_TEST(fn) do {                                                       \
+        test_current = #fn;                                                     \
+        int before_ = test_failures;                                            \
+        fn();                                                                   \
+        printf("%s %s\n", test_failures == before_ ? "PASS" : "FAIL", #fn);     \
+    } while (0)
+
+#define TEST_RESULT() (test_failures == 0 ? 0 : 1)
+
+#endif // TEST_UTIL_H
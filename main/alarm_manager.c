@@ -15,6 +15,7 @@
 #include "cJSON.h"
 
 #include "alarm_manager.h"
+#include "alarm_schedule.h"
 #include "config.h"
 
 static const char *TAG = "ALARM_MGR";
@@ -30,6 +31,7 @@ static bool alarm_active = false;
 static alarm_t *active_alarm = NULL;
 static time_t alarm_start_time = 0;
 static time_t snooze_until = 0;
+static time_t last_checked_minute = 0;
 
 // Użyj wartości z config.h lub domyślnych
 #ifndef ALARM_AUTO_STOP_MINUTES
@@ -109,32 +111,16 @@ static void alarm_check_task(void *pvParameters)
             continue;
         }
 
+        // Każda minuta sprawdzana raz - zapytanie co 5 s nie musi trafić w sekundę 0
+        time_t minute = now / 60;
+        if (minute == last_checked_minute) {
+            continue;
+        }
+        last_checked_minute = minute;
+
         // Sprawdź każdy alarm
         for (int i = 0; i < alarm_count; i++) {
-            if (!alarms[i].enabled) {
-                continue;
-            }
-
-            // Sprawdź godzinę i minutę
-            if (alarms[i].hour != timeinfo.tm_hour ||
-                alarms[i].minute != timeinfo.tm_min) {
-                continue;
-            }
-
-            // Sprawdź sekundę (tylko raz na minutę)
-            if (timeinfo.tm_sec != 0) {
-                continue;
-            }
-
-            // Sprawdź dzień tygodnia (0=niedziela w tm, ale w naszym formacie 0=poniedziałek)
-            int day_bit;
-            if (timeinfo.tm_wday == 0) {
-                day_bit = ALARM_DAY_SUNDAY;
-            } else {
-                day_bit = (1 << (timeinfo.tm_wday - 1));
-            }
-
-            if (!(alarms[i].days & day_bit)) {
+            if (!alarm_schedule_is_due(&alarms[i], &timeinfo)) {
                 continue;
             }
 
@@ -312,43 +298,14 @@ alarm_t *alarm_manager_get_next(void)
     struct tm timeinfo;
     localtime_r(&now, &timeinfo);
 
-    int current_minutes = timeinfo.tm_hour * 60 + timeinfo.tm_min;
-    int current_day = (timeinfo.tm_wday == 0) ? 6 : timeinfo.tm_wday - 1;  // 0=poniedziałek
-
     alarm_t *next_alarm = NULL;
     int min_diff = INT32_MAX;
 
     for (int i = 0; i < alarm_count; i++) {
-        if (!alarms[i].enabled) {
-            continue;
-        }
-
-        int alarm_minutes = alarms[i].hour * 60 + alarms[i].minute;
-
-        // Sprawdź dla każdego dnia tygodnia
-        for (int day = 0; day < 7; day++) {
-            int check_day = (current_day + day) % 7;
-            int day_bit = (1 << check_day);
-
-            if (!(alarms[i].days & day_bit)) {
-                continue;
-            }
-
-            int diff;
-            if (day == 0 && alarm_minutes > current_minutes) {
-                diff = alarm_minutes - current_minutes;
-            } else if (day > 0) {
-                diff = day * 24 * 60 + alarm_minutes - current_minutes;
-            } else {
-                continue;
-            }
-
-            if (diff < min_diff) {
-                min_diff = diff;
-                next_alarm = &alarms[i];
-            }
-
-            break;  // Tylko pierwszy pasujący dzień
+        int diff = alarm_schedule_minutes_until(&alarms[i], &timeinfo);
+        if (diff > 0 && diff < min_diff) {
+            min_diff = diff;
+            next_alarm = &alarms[i];
         }
     }
 
@@ -0,0 +1,39 @@
+/*
+ * Alarm Schedule
+ * Harmonogram budzika liczony z czasu lokalnego
+ */
+
+#include "alarm_schedule.h"
+
+uint8_t alarm_schedule_day_bit(int tm_wday)
+{
+    // 0 = niedziela w tm, w maskach ALARM_DAY_* 0 = poniedziałek
+    return tm_wday == 0 ? ALARM_DAY_SUNDAY : (uint8_t)(1 << (tm_wday - 1));
+}
+
+bool alarm_schedule_is_due(const alarm_t *alarm, const struct tm *now)
+{
+    return alarm->enabled &&
+           alarm->hour == now->tm_hour &&
+           alarm->minute == now->tm_min &&
+           (alarm->days & alarm_schedule_day_bit(now->tm_wday));
+}
+
+int alarm_schedule_minutes_until(const alarm_t *alarm, const struct tm *now)
+{
+    if (!alarm->enabled || !(alarm->days & ALARM_DAY_EVERYDAY)) {
+        return -1;
+    }
+
+    int current_minutes = now->tm_hour * 60 + now->tm_min;
+    int alarm_minutes = alarm->hour * 60 + alarm->minute;
+
+    // Dzień 7 to ten sam dzień tygodnia za tydzień - alarm tylko na dziś, już po czasie
+    for (int day = 0; day <= 7; day++) {
+        int diff = day * 24 * 60 + alarm_minutes - current_minutes;
+        if (diff > 0 && (alarm->days & alarm_schedule_day_bit((now->tm_wday + day) % 7))) {
+            return diff;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,25 @@
+/*
+ * Alarm Schedule
+ * Czyste funkcje harmonogramu budzika (bez zegara systemowego i NVS): czy alarm
+ * przypada na daną minutę i ile minut zostało do najbliższego wywołania.
+ * Czas lokalny podawany jako struct tm - można sprawdzać na hoście.
+ */
+
+#ifndef ALARM_SCHEDULE_H
+#define ALARM_SCHEDULE_H
+
+#include <stdbool.h>
+#include <time.h>
+#include "alarm_manager.h"
+
+// Bit ALARM_DAY_* dla tm_wday (0 = niedziela)
+uint8_t alarm_schedule_day_bit(int tm_wday);
+
+// Alarm włączony i przypada na minutę z now (sekundy bez znaczenia)
+bool alarm_schedule_is_due(const alarm_t *alarm, const struct tm *now);
+
+// Minuty od now do najbliższego wywołania (1 .. 7 * 24 * 60); -1 - nigdy.
+// Alarm z bieżącej minuty liczy się jako wywołany - następny jest za tydzień lub później.
+int alarm_schedule_minutes_until(const alarm_t *alarm, const struct tm *now);
+
+#endif // ALARM_SCHEDULE_H
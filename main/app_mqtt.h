@@ -72,7 +72,9 @@ esp_err_t app_mqtt_client_disconnect(void);
 esp_err_t mqtt_publish_state(const char *state);
 esp_err_t mqtt_publish_volume(int volume);
 esp_err_t mqtt_publish_media_info(const char *title, const char *artist, const char *album);
+esp_err_t mqtt_publish_media_position(uint32_t position_ms, uint32_t duration_ms, bool playing);
 esp_err_t mqtt_publish_availability(bool online);
+esp_err_t mqtt_publish_telemetry(const uint8_t *data, int len);  // Telemetria pipeline (binarnie)
 
 // Home Assistant Auto Discovery
 esp_err_t mqtt_send_ha_discovery(void);
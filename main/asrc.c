@@ -0,0 +1,151 @@
+/*
+ * Drift Correction Module
+ * Korekta dryfu zegara: resampler 1 ± kilka ppm + regulator zapełnienia bufora
+ */
+
+#include <string.h>
+#include "asrc.h"
+
+#define ASRC_ONE            (1LL << 32)
+
+// ============================================
+// Resampler
+// ============================================
+
+void asrc_reset(asrc_t *asrc, int channels)
+{
+    int32_t step_delta = asrc->step_delta;
+    memset(asrc, 0, sizeof(*asrc));
+    asrc->channels = channels > ASRC_MAX_CHANNELS ? ASRC_MAX_CHANNELS : channels;
+    asrc->step_delta = step_delta;
+}
+
+void asrc_set_ppm(asrc_t *asrc, float ppm)
+{
+    if (ppm > ASRC_MAX_PPM) ppm = ASRC_MAX_PPM;
+    if (ppm < -ASRC_MAX_PPM) ppm = -ASRC_MAX_PPM;
+    asrc->step_delta = (int32_t)(ppm * 4294.967296f);  // 2^32 / 10^6
+}
+
+bool asrc_set_ratio(asrc_t *asrc, int in_rate, int out_rate, float ppm)
+{
+    if (in_rate <= 0 || out_rate <= 0) return false;
+    if (ppm > ASRC_MAX_PPM) ppm = ASRC_MAX_PPM;
+    if (ppm < -ASRC_MAX_PPM) ppm = -ASRC_MAX_PPM;
+    int64_t delta = ((int64_t)(in_rate - out_rate) << 32) / out_rate +
+                    (int64_t)(ppm * 4294.967296f) * in_rate / out_rate;
+    if (delta >= INT32_MAX || delta <= -(ASRC_ONE / 2)) return false;
+    asrc->step_delta = (int32_t)delta;
+    return true;
+}
+
+static inline int16_t clip16(float v)
+{
+    if (v >= 32767.0f) return 32767;
+    if (v <= -32768.0f) return -32768;
+    return (int16_t)(v < 0 ? v - 0.5f : v + 0.5f);
+}
+
+int asrc_process(asrc_t *asrc, const int16_t *in, int in_frames, int16_t *out, int out_frames)
+{
+    const int ch = asrc->channels;
+    const int64_t step = ASRC_ONE + asrc->step_delta;
+    int n = 0;
+
+    for (int i = 0; i < in_frames; i++) {
+        const int16_t *x = in + i * ch;
+
+        // Wyjście między hist[1] a hist[2]; przy kroku ~1 zwykle jedna ramka na wejściową,
+        // co kilka tysięcy ramek zero lub dwie
+        while (asrc->pos < ASRC_ONE && n < out_frames) {
+            float t = (float)asrc->pos * (1.0f / 4294967296.0f);
+            for (int c = 0; c < ch; c++) {
+                float y0 = asrc->hist[0][c];
+                float y1 = asrc->hist[1][c];
+                float y2 = asrc->hist[2][c];
+                float y3 = x[c];
+                float c1 = 0.5f * (y2 - y0);
+                float c2 = y0 - 2.5f * y1 + 2.0f * y2 - 0.5f * y3;
+                float c3 = 0.5f * (y3 - y0) + 1.5f * (y1 - y2);
+                out[n * ch + c] = clip16(((c3 * t + c2) * t + c1) * t + y1);
+            }
+            n++;
+            asrc->pos += step;
+        }
+
+        asrc->pos -= ASRC_ONE;
+        if (asrc->pos < 0) asrc->pos = 0;  // Brak miejsca w out - nie powinno wystąpić
+
+        for (int c = 0; c < ch; c++) {
+            asrc->hist[0][c] = asrc->hist[1][c];
+            asrc->hist[1][c] = asrc->hist[2][c];
+            asrc->hist[2][c] = x[c];
+        }
+    }
+
+    return n;
+}
+
+// ============================================
+// Regulator dryfu
+// ============================================
+// Poziom bufora zmienia się o (dryf - korekta) * 1e-3 ms na sekundę. Regulator PI
+// o tłumieniu krytycznym: Kp = 2w, Ki = w^2 (w = 1 / ASRC_LOOP_TAU_S), przeliczone
+// z ms/s na ppm. Człon całkujący zbiega do rzeczywistego dryfu zegarów.
+
+void asrc_ctrl_reset(asrc_ctrl_t *ctrl)
+{
+    memset(ctrl, 0, sizeof(*ctrl));
+}
+
+void asrc_ctrl_relock(asrc_ctrl_t *ctrl)
+{
+    ctrl->locked = false;
+    ctrl->settle_ms = 0;
+    ctrl->level_ms = 0;
+    ctrl->ppm = ctrl->integral_ppm;  // Bez członu proporcjonalnego od starego punktu
+}
+
+float asrc_ctrl_update(asrc_ctrl_t *ctrl, int level_ms, uint32_t dt_ms)
+{
+    if (dt_ms == 0) return ctrl->ppm;
+
+    if (ctrl->settle_ms == 0) {
+        ctrl->level_ms = level_ms;
+    } else {
+        float alpha = (float)dt_ms / (ASRC_LEVEL_TAU_MS + dt_ms);
+        ctrl->level_ms += alpha * (level_ms - ctrl->level_ms);
+    }
+    ctrl->settle_ms += dt_ms;
+
+    if (!ctrl->locked) {
+        if (ctrl->settle_ms < ASRC_SETTLE_MS) {
+            return ctrl->ppm;
+        }
+        ctrl->setpoint_ms = ctrl->level_ms;
+        ctrl->locked = true;
+    }
+
+    const float w = 1.0f / ASRC_LOOP_TAU_S;
+    const float kp = 2.0f * w * 1000.0f;
+    const float ki = w * w * 1000.0f;
+    float dt_s = dt_ms / 1000.0f;
+    float error = ctrl->level_ms - ctrl->setpoint_ms;
+
+    ctrl->integral_ppm += ki * error * dt_s;
+    if (ctrl->integral_ppm > ASRC_MAX_PPM) ctrl->integral_ppm = ASRC_MAX_PPM;
+    if (ctrl->integral_ppm < -ASRC_MAX_PPM) ctrl->integral_ppm = -ASRC_MAX_PPM;
+
+    float target = kp * error + ctrl->integral_ppm;
+    if (target > ASRC_MAX_PPM) target = ASRC_MAX_PPM;
+    if (target < -ASRC_MAX_PPM) target = -ASRC_MAX_PPM;
+
+    // Ograniczenie szybkości zmian - skoki wysokości dźwięku są niesłyszalne, ale
+    // pojedynczy burst z sieci nie powinien przestawiać korekty
+    float slew = ASRC_SLEW_PPM_S * dt_s;
+    if (target > ctrl->ppm + slew) target = ctrl->ppm + slew;
+    if (target < ctrl->ppm - slew) target = ctrl->ppm - slew;
+    ctrl->ppm = target;
+
+    return ctrl->ppm;
+}
@@ -0,0 +1,76 @@
+/*
+ * Drift Correction Module
+ * Korekta dryfu zegara: serwer radia i zegar I2S (ES8388) nigdy nie mają dokładnie tej
+ * samej częstotliwości. Przez wiele godzin bufor powoli się opróżnia lub przepełnia.
+ * Resampler o stosunku 1 ± kilka ppm utrzymuje zapełnienie bufora wokół punktu pracy.
+ *
+ * Czyste C bez zależności od ESP-IDF - można kompilować i sprawdzać na hoście.
+ */
+
+#ifndef ASRC_H
+#define ASRC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ASRC_MAX_CHANNELS   2
+#define ASRC_MAX_PPM        300.0f      // Kwarce: typowo kilkadziesiąt ppm, do 200 ppm + zapas na człon P
+#define ASRC_EXTRA_FRAMES   2           // Wyjście może być dłuższe od wejścia o tyle ramek
+
+// Regulator zapełnienia bufora
+#define ASRC_LEVEL_TAU_MS   60000       // Uśrednianie poziomu - ukrywa paczki z sieci
+#define ASRC_SETTLE_MS      30000       // Po starcie poziom się stabilizuje, potem punkt pracy
+#define ASRC_LOOP_TAU_S     1800.0f     // Stała czasowa pętli (tłumienie krytyczne)
+#define ASRC_SLEW_PPM_S     0.5f        // Maksymalna zmiana korekty na sekundę
+
+// ============================================
+// Resampler (interpolacja Hermite'a, 16 bit)
+// ============================================
+
+typedef struct {
+    int channels;
+    int64_t pos;                        // Pozycja wyjścia między hist[1] a hist[2] (Q32)
+    volatile int32_t step_delta;        // Krok wejścia - 1 (Q32); > 0 - zużywa szybciej
+    int16_t hist[3][ASRC_MAX_CHANNELS];
+} asrc_t;
+
+// Zeruje historię (nowe źródło lub format); korekta zostaje
+void asrc_reset(asrc_t *asrc, int channels);
+
+// Korekta w ppm: dodatnia - wejście zużywane szybciej niż grane (bufor maleje).
+// Bezpieczne z innego taska niż asrc_process.
+void asrc_set_ppm(asrc_t *asrc, float ppm);
+
+// Stały stosunek częstotliwości zamiast korekty ppm (zmiana formatu, np. 48 kHz -> 44.1 kHz),
+// z dodatkową korektą ppm jak w asrc_set_ppm() (0 - bez korekty).
+// Bez filtra antyaliasingowego - przy 48 -> 44.1 kHz zawija się tylko pasmo powyżej 22 kHz.
+// false - stosunek poza zakresem resamplera (ok. 0.5 - 1.5).
+bool asrc_set_ratio(asrc_t *asrc, int in_rate, int out_rate, float ppm);
+
+// Przetwarza in_frames ramek przeplatanych. out musi pomieścić in_frames + ASRC_EXTRA_FRAMES
+// (przy stosunku < 1 odpowiednio więcej). Zwraca liczbę ramek wyjściowych.
+int asrc_process(asrc_t *asrc, const int16_t *in, int in_frames, int16_t *out, int out_frames);
+
+// ============================================
+// Regulator dryfu
+// ============================================
+
+typedef struct {
+    float level_ms;                     // Uśredniony poziom bufora
+    float setpoint_ms;                  // Punkt pracy ustalony po ASRC_SETTLE_MS
+    float integral_ppm;                 // Oszacowanie dryfu zegarów
+    float ppm;                          // Bieżąca korekta
+    uint32_t settle_ms;                 // Czas od (ponownego) startu
+    bool locked;                        // Punkt pracy ustalony - regulacja aktywna
+} asrc_ctrl_t;
+
+// Nowa stacja - inny serwer, inny zegar
+void asrc_ctrl_reset(asrc_ctrl_t *ctrl);
+
+// Nowy punkt pracy (np. po rebuforowaniu) z zachowaniem oszacowanego dryfu
+void asrc_ctrl_relock(asrc_ctrl_t *ctrl);
+
+// Kolejny pomiar poziomu bufora po dt_ms; zwraca korektę w ppm dla asrc_set_ppm()
+float asrc_ctrl_update(asrc_ctrl_t *ctrl, int level_ms, uint32_t dt_ms);
+
+#endif // ASRC_H
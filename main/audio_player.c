@@ -3,12 +3,16 @@
  * Handles audio streaming and playback using ESP-ADF
  */
 
+#include <stdio.h>
 #include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/timers.h"
 #include "freertos/semphr.h"
+#include "freertos/queue.h"
 #include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "sdkconfig.h"
 
 #include "audio_player.h"
 #include "config.h"
@@ -20,12 +24,21 @@
 #include "audio_event_iface.h"
 #include "audio_common.h"
 #include "ringbuf.h"
-#include "http_stream.h"
 #include "i2s_stream.h"
-#include "mp3_decoder.h"
-#include "aac_decoder.h"
 #include "filter_resample.h"
-#include "equalizer.h"
+#include "eq_filter.h"
+#include "codec_detect.h"
+#include "pipeline_stats.h"
+#include "asrc.h"
+#include "bluetooth_source.h"
+#include "bluetooth_sink.h"
+#include "aux_input.h"
+#include "station_profile.h"
+#include "stream_slot.h"
+#include "sd_source.h"
+#include "player_status.h"
+#include "sdcard_player.h"
+#include "media_index.h"
 #include "board.h"
 #include "esp_peripherals.h"
 #include "periph_touch.h"
@@ -34,32 +47,165 @@
 
 static const char *TAG = "AUDIO_PLAYER";
 
+// Pre-buffering - cel liczony w milisekundach audio na podstawie bitrate strumienia
+#define PREBUFFER_CHECK_MS          100     // Check buffer every 100ms
+#define PREBUFFER_LOW_WATERMARK_MS  250     // Poniżej - powrót do BUFFERING zamiast trzasków
+#define PREBUFFER_TIMEOUT_MS        10000   // Start mimo niepełnego bufora (łącze wolniejsze niż strumień)
+#define PREBUFFER_STABLE_MS         60000   // Minuta bez underrun - cel maleje o 25%
+
+// Warm standby: drugi slot strumienia, gdy po jego alokacji zostaje zapas PSRAM
+#define STANDBY_PSRAM_RESERVE       (512 * 1024)    // PSRAM, który musi zostać wolny
+
+// Etap wyjściowy czeka na dane źródła w krokach po 50ms (I2S gra wtedy ciszę)
+#define OUTPUT_IDLE_WAIT_MS         50
+#define OUTPUT_FORMAT_TIMEOUT_MS    1000    // Start bez music info dekodera po 1s
+
+// DMA I2S: 6 x 512 ramek (70 ms przy 44.1 kHz) - zapas na opóźnienia taska I2S,
+// a odbiornik Bluetooth mieści się w 150 ms od pakietu do głośnika
+#define OUTPUT_DMA_DESC             6
+#define OUTPUT_DMA_FRAMES           512
+
+// Źródła na żywo (odbiornik BT, AUX): zapas trzyma bufor jittera lub bufor ADC, przed I2S
+// krótka kolejka
+#define LIVE_QUEUE_BYTES            2048    // ~12 ms PCM między EQ a I2S
+#define LIVE_READ_BYTES             1024
+#define LIVE_POLL_MS                2
+
+// Korekta dryfu zegara serwera względem I2S
+#define DRIFT_BLOCK_FRAMES          512     // Ramki PCM na jeden odczyt etapu wyjściowego
+#define DRIFT_GAP_MS                1000    // Dłuższa przerwa w danych - nowy punkt pracy
+
+// Wyjście na głośnik Bluetooth (A2DP source): SBC przyjmuje 44.1 kHz stereo 16 bit
+#define BT_OUTPUT_RATE              44100
+#define BT_BLOCK_FRAMES             512     // Ramki PCM na jeden zapis do bufora A2DP
+
+// Źródło SD: etap wyjściowy czeka na PCM z nowej pozycji po przewinięciu
+#define SD_SEEK_POLL_MS             5
+
+// ============================================
 // Pipeline i elementy
-static audio_pipeline_handle_t pipeline = NULL;
-static audio_element_handle_t http_stream = NULL;
-static audio_element_handle_t decoder = NULL;
+// ============================================
+
+// Sloty strumieni (stream_slot.c): etap wyjściowy czyta pcm_rb aktywnego slotu
+static stream_slot_t stream_slots[STREAM_SLOT_COUNT] = {0};
+static stream_slot_t *active_slot = &stream_slots[0];
+static stream_slot_t *standby_slot = NULL;  // NULL = warm standby wyłączony
+
+#define CMD_SLOT_SD                 STREAM_SLOT_COUNT   // Komendy źródła SD (sd_source.c)
+
+// Etap wyjściowy: [eq ->] i2s, działa stale - źródła przełącza się podmieniając output_rb
+static audio_pipeline_handle_t output_pipeline = NULL;
 static audio_element_handle_t i2s_stream = NULL;
 static audio_element_handle_t rsp_filter = NULL;
 static audio_element_handle_t equalizer = NULL;
+static volatile ringbuf_handle_t output_rb = NULL;
+static volatile bool output_format_pending = false;
+static uint32_t output_format_pending_since = 0;
+static int output_rate = 0;
+static int output_channels = 0;
+static int output_bits = 0;
+
+// Resampler korekty dryfu w etapie wyjściowym (PCM 16 bit) i jego regulator (tick prebufora)
+static asrc_t output_asrc;
+static asrc_ctrl_t drift_ctrl;
+static volatile bool drift_flush = true;    // Nowe źródło - wyzeruj historię resamplera
+static volatile bool drift_restart = true;  // Nowa stacja - nowy regulator
+static bool drift_relock = false;           // Poziom bufora zmieniony nie przez dryf
+static int16_t drift_in[(DRIFT_BLOCK_FRAMES + 1) * ASRC_MAX_CHANNELS];
+static int drift_carry = 0;                 // Bajty niepełnej ramki na początku drift_in
+
+// Rozgałęzienie na głośnik Bluetooth za EQ (task EQ); tryb zmieniany w locie
+static volatile player_output_t output_mode = PLAYER_OUTPUT_I2S;
+static volatile bool bt_flush = true;       // Nowy format lub tryb - nowe parametry resamplera
+static asrc_t bt_asrc;                      // Stały stosunek częstotliwości, np. 48 -> 44.1 kHz
+static bool bt_resample = false;
+static bool bt_supported = false;           // Format, który da się przekazać do BT
+static int16_t bt_in[BT_BLOCK_FRAMES * 2];
+static int16_t bt_out[(BT_BLOCK_FRAMES * 2 + ASRC_EXTRA_FRAMES) * 2];
+
 static audio_event_iface_handle_t evt = NULL;
 static esp_periph_set_handle_t periph_set = NULL;
 
+// ============================================
+// Kolejka komend
+// ============================================
+
+// Wszystkie zmiany slotów, etapu wyjściowego i statusu wykonuje jeden task sterujący.
+// Pozostałe taski (web, MQTT, przyciski, http, zdarzenia) tylko wysyłają komendy.
+#define PLAYER_CMD_QUEUE_LEN    16
+
+typedef enum {
+    PLAYER_CMD_PLAY = 0,        // gen = numer żądania (starsze są pomijane)
+    PLAYER_CMD_STOP,
+    PLAYER_CMD_PAUSE,
+    PLAYER_CMD_RESUME,
+    PLAYER_CMD_VOLUME,          // Najnowsza wartość z requested_volume
+    PLAYER_CMD_MUTE,            // value = 0/1
+    PLAYER_CMD_RECONNECT,       // Pełny restart aktywnej stacji
+    PLAYER_CMD_DECODER_SWITCH,  // Restart slotu z dekoderem z profilu
+    PLAYER_CMD_STANDBY_ARM,
+    PLAYER_CMD_STANDBY_FAILED,
+    PLAYER_CMD_FORMAT,          // Slot zgłosił format audio
+    PLAYER_CMD_TITLE,           // Slot odebrał nowy StreamTitle
+    PLAYER_CMD_ERROR,           // value = AEL_STATUS_ERROR_*
+    PLAYER_CMD_NOTIFY,          // Powiadomienie o zmianie statusu spoza taska sterującego
+    PLAYER_CMD_SD_END,          // Etap wyjściowy odegrał plik SD do końca
+    PLAYER_CMD_SD_SEEK,         // Najnowsza pozycja z requested_seek_ms
+    PLAYER_CMD_SD_PRIME,        // Najnowszy następny plik z requested_next
+    PLAYER_CMD_SD_CHAIN,        // Dekoder SD skończył plik - przejście na następny
+    PLAYER_CMD_SD_NEXT,         // Etap wyjściowy doszedł do następnego pliku
+    PLAYER_CMD_BT_START,        // Odbiornik BT nadaje: value = częstotliwość, gen = kanały
+    PLAYER_CMD_BT_STOP,         // Telefon wstrzymał strumień lub się rozłączył
+    PLAYER_CMD_BT_TRACK,        // Nowe metadane lub pozycja z AVRCP
+    PLAYER_CMD_AUX_CAPTURE,     // value = 0/1 - czytnik ADC (wejście AUX włączone)
+    PLAYER_CMD_AUX_START,
+    PLAYER_CMD_AUX_STOP,
+    PLAYER_CMD_PREBUFFER_TICK,  // Timer prebufora: poziom bufora, underrun, dryf, standby
+} player_cmd_type_t;
+
+typedef struct {
+    uint8_t type;
+    int8_t slot;                // Indeks slotu lub -1
+    int32_t value;
+    uint32_t gen;               // Generacja slotu / numer żądania odtwarzania
+} player_cmd_t;
+
+static QueueHandle_t cmd_queue = NULL;
+static TaskHandle_t ctrl_task_handle = NULL;
+
+// Najnowsze żądania od użytkownika - kolejne wciśnięcia łączą się w jedno
+static SemaphoreHandle_t request_lock = NULL;
+static char requested_url[512] = "";      // URL stacji lub ścieżka pliku SD
+static audio_source_t requested_source = AUDIO_SOURCE_HTTP;
+static uint32_t requested_start_ms = 0;     // Pozycja startowa pliku SD (zakładka)
+static volatile uint32_t play_seq = 0;      // Numer najnowszego żądania odtwarzania
+static volatile uint32_t play_done_seq = 0; // Ostatnie wykonane (czytane też przez slot_superseded)
+static int requested_volume = DEFAULT_VOLUME;
+static bool volume_queued = false;
+static uint32_t requested_seek_ms = 0;
+static bool seek_queued = false;
+static char requested_next[256] = "";       // Następny plik SD ("" - brak)
+static bool next_queued = false;
+
 // EQ gain array for equalizer (stereo: 20 values, 10 per channel)
 static int eq_gain[20] = {0};
 
-// Stan odtwarzacza
-static player_status_t player_status = {
-    .state = PLAYER_STATE_IDLE,
-    .source = AUDIO_SOURCE_NONE,
-    .volume = DEFAULT_VOLUME,
-    .muted = false,
-    .current_url = "",
-    .current_title = "",
-    .current_artist = "",
-};
+// Pasmo w obu kanałach z przesunięciem balansu L/R (audio_settings) - zmiana pasma nie
+// może zerować balansu
+static void eq_store_band(int band, int gain_db)
+{
+    int left_atten, right_atten;
+    audio_settings_get_balance_db(&left_atten, &right_atten);
+    int left = gain_db + left_atten;
+    int right = gain_db + right_atten;
+    eq_gain[band] = left < -13 ? -13 : (left > 13 ? 13 : left);             // Left channel
+    eq_gain[band + 10] = right < -13 ? -13 : (right > 13 ? 13 : right);     // Right channel
+}
 
 // Callback
 static player_state_callback_t state_callback = NULL;
+static player_track_end_callback_t track_end_callback = NULL;
+static player_track_next_callback_t track_next_callback = NULL;
 
 // Audio board handle
 static audio_board_handle_t board_handle = NULL;
@@ -71,33 +217,469 @@ static TaskHandle_t event_task_handle = NULL;
 // Pomocnicze funkcje
 // ============================================
 
+static esp_err_t post_cmd(player_cmd_type_t type, int slot, int32_t value, uint32_t gen);
+
+static uint32_t now_ms(void);
+
+uint32_t audio_player_status_position_ms(const player_status_t *status)
+{
+    return player_status_position_ms(status, now_ms());
+}
+
+// Początek nowego źródła lub utworu - każda różnica pozycji jest zmianą
+static void status_set_position(uint32_t duration_ms, uint32_t position_ms, uint32_t at_ms)
+{
+    player_status_set_position(duration_ms, position_ms, at_ms, now_ms(), 0);
+}
+
+// Callback dostaje spójną kopię i maskę zmienionych pól. Wywoływany tylko z taska
+// sterującego (duży stos, bez współbieżnych wywołań) - inne taski zlecają powiadomienie.
 static void notify_state_change(void)
 {
-    if (state_callback) {
-        state_callback(&player_status);
+    if (ctrl_task_handle == NULL || xTaskGetCurrentTaskHandle() != ctrl_task_handle) {
+        post_cmd(PLAYER_CMD_NOTIFY, -1, 0, 0);
+        return;
+    }
+
+    uint32_t changed = player_status_take_changed();
+
+    if (changed == 0 || state_callback == NULL) {
+        return;
     }
+
+    player_status_t snapshot;
+    audio_player_get_status(&snapshot);
+    state_callback(&snapshot, changed);
 }
 
 static void set_state(player_state_t state)
 {
-    player_status.state = state;
+    player_status_set_state(state);
     notify_state_change();
 }
 
+static uint32_t now_ms(void)
+{
+    return xTaskGetTickCount() * portTICK_PERIOD_MS;
+}
+
 // Flaga do zapobiegania wielokrotnym reconnect
 static bool reconnect_in_progress = false;
 
-// Pre-buffering configuration
-#define PREBUFFER_THRESHOLD_KB  128  // Start playback when 128KB buffered (~8s at 128kbps)
-#define PREBUFFER_CHECK_MS      100  // Check buffer every 100ms
-#define HTTP_BUFFER_SIZE_KB     256  // Total HTTP buffer size in KB
+static esp_err_t post_cmd(player_cmd_type_t type, int slot, int32_t value, uint32_t gen)
+{
+    if (cmd_queue == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    player_cmd_t cmd = {.type = type, .slot = slot, .value = value, .gen = gen};
+    if (xQueueSend(cmd_queue, &cmd, 0) != pdTRUE) {
+        // Odtwarzanie i głośność wykona task po opróżnieniu kolejki (najnowsze żądanie)
+        ESP_LOGW(TAG, "Command queue full, command %d dropped", type);
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+// Następna stacja z listy po podanym URL (NULL jeśli brak stacji)
+static const char *next_station_url(const char *url, const char **name)
+{
+    uint8_t count = 0;
+    radio_station_t *stations = radio_stations_get_all(&count);
+    if (stations == NULL || count == 0) {
+        return NULL;
+    }
+
+    int current_index = -1;
+    for (int i = 0; i < count; i++) {
+        if (strcmp(stations[i].url, url) == 0) {
+            current_index = i;
+            break;
+        }
+    }
+
+    int next_index = (current_index + 1) % count;
+    if (name) {
+        *name = stations[next_index].name;
+    }
+    return stations[next_index].url;
+}
+
+// ============================================
+// Statystyki przełączania stacji
+// ============================================
+
+static uint32_t switch_started_ms = 0;     // 0 = brak pomiaru w toku
+static bool switch_warm = false;
+static player_switch_stats_t switch_stats = {0};
+
+// Statystyki sesji od resetu - porównywalne wyniki testów długotrwałych
+static player_session_stats_t session_stats = {0};
+static uint32_t session_started_ms = 0;
+static uint64_t session_first_audio_total = 0;
+static bool session_rebuffering = false;    // BUFFERING po underrun, nie po starcie stacji
+
+// Wywoływane przy pierwszych próbkach nowej stacji na wyjściu
+static void switch_latency_done(void)
+{
+    uint32_t started = switch_started_ms;
+    if (started == 0) return;
+
+    switch_started_ms = 0;
+    switch_stats.last_ms = now_ms() - started;
+    switch_stats.last_warm = switch_warm;
+
+    session_stats.starts++;
+    session_first_audio_total += switch_stats.last_ms;
+    session_stats.first_audio_last_ms = switch_stats.last_ms;
+    session_stats.first_audio_avg_ms = session_first_audio_total / session_stats.starts;
+    if (switch_stats.last_ms > session_stats.first_audio_max_ms) {
+        session_stats.first_audio_max_ms = switch_stats.last_ms;
+    }
+    ESP_LOGI(TAG, "Station switch: %lu ms (%s)", (unsigned long)switch_stats.last_ms,
+             switch_warm ? "warm standby" : "cold");
+}
+
+// ============================================
+// Etap wyjściowy
+// ============================================
+
+// Wejście etapu wyjściowego: PCM aktywnego źródła. Poza stanem PLAYING nic nie pobiera -
+// I2S gra ciszę, a bufor źródła się napełnia.
+// Odczyt źródła przez resampler korekty dryfu; zwraca bajty wejścia, *out_len - wyjścia
+static int output_read_drift(ringbuf_handle_t rb, char *buf, int len, int *out_len)
+{
+    int frame = output_channels * sizeof(int16_t);
+
+    if (drift_flush || output_asrc.channels != output_channels) {
+        drift_flush = false;
+        drift_carry = 0;
+        asrc_reset(&output_asrc, output_channels);
+    }
+
+    int frames = len / frame - ASRC_EXTRA_FRAMES;
+    if (frames > DRIFT_BLOCK_FRAMES) frames = DRIFT_BLOCK_FRAMES;
+
+    int rlen = rb_read(rb, (char *)drift_in + drift_carry, frames * frame - drift_carry,
+                       pdMS_TO_TICKS(OUTPUT_IDLE_WAIT_MS));
+    if (rlen <= 0) {
+        return rlen;
+    }
+
+    int total = drift_carry + rlen;
+    int in_frames = total / frame;
+    *out_len = asrc_process(&output_asrc, drift_in, in_frames, (int16_t *)buf, len / frame) * frame;
+
+    drift_carry = total - in_frames * frame;
+    if (drift_carry > 0) {
+        memmove(drift_in, (char *)drift_in + in_frames * frame, drift_carry);
+    }
+    return rlen;
+}
+
+// Wyjście faktycznie używane - dopóki głośnik BT nie odbiera strumienia, gra kodek
+// (pre-roll po starcie A2DP już idzie do bufora BT)
+static player_output_t output_route(void)
+{
+    player_output_t mode = output_mode;
+    if (mode != PLAYER_OUTPUT_I2S && !bt_source_wants_audio()) {
+        return PLAYER_OUTPUT_I2S;
+    }
+    return mode;
+}
+
+static void bt_tee_setup(void)
+{
+    bt_flush = false;
+    bt_resample = (output_rate != BT_OUTPUT_RATE);
+    bt_supported = (output_bits == 16 || output_bits == 32) &&
+                   (output_channels == 1 || output_channels == 2);
+    if (bt_supported) {
+        asrc_reset(&bt_asrc, 2);
+        bt_supported = asrc_set_ratio(&bt_asrc, output_rate, BT_OUTPUT_RATE, 0.0f);
+    }
+    if (!bt_supported) {
+        ESP_LOGW(TAG, "BT output: unsupported format %d Hz, %d ch, %d bit",
+                 output_rate, output_channels, output_bits);
+    }
+}
+
+// paced (tylko BT) - zapis czeka na miejsce w buforze, tempo wyznacza głośnik.
+// Inaczej tempo wyznacza I2S, a nadmiar ponad wolne miejsce jest odrzucany.
+static void bt_tee_send(const uint8_t *data, int len, bool paced)
+{
+    while (len > 0) {
+        int n;
+        if (paced) {
+            n = bt_source_write_audio(data, len);   // Czeka do 10ms
+            if (n == 0) {
+                if (output_route() != PLAYER_OUTPUT_BT || player_status->state != PLAYER_STATE_PLAYING) {
+                    break;
+                }
+                continue;
+            }
+        } else {
+            int space = bt_source_write_space() & ~3;
+            n = len < space ? len : space;
+            if (n == 0 || bt_source_write_audio(data, n) != n) {
+                break;
+            }
+        }
+        pipeline_stats_add_out(PSTAT_BT, n);
+        data += n;
+        len -= n;
+    }
+    if (len > 0) {
+        pipeline_stats_overrun(PSTAT_BT);
+    }
+}
+
+// PCM wyjścia (całe ramki) do bufora A2DP jako 44.1 kHz stereo 16 bit.
+// Bez wstrzymywania (tryb both) tempo wyznacza I2S - resampler koryguje je według trendu
+// zapełnienia bufora A2DP, żeby głośnik nie głodował ani nie narastało opóźnienie.
+static void bt_tee(const char *buf, int len, bool paced)
+{
+    if (bt_flush) {
+        bt_tee_setup();
+    }
+    if (!bt_supported) return;
+    pipeline_stats_add_in(PSTAT_BT, len);
+
+    float ppm = paced ? 0.0f : bt_source_get_pacing_ppm();
+    bool resample = bt_resample || ppm != 0.0f;
+    if (resample) {
+        asrc_set_ratio(&bt_asrc, output_rate, BT_OUTPUT_RATE, ppm);
+    }
+
+    const int ch = output_channels;
+    const int in_frame = ch * output_bits / 8;
+    int frames = len / in_frame;
+    while (frames > 0) {
+        int n = frames < BT_BLOCK_FRAMES ? frames : BT_BLOCK_FRAMES;
+        const int16_t *pcm = (const int16_t *)buf;
+        if (ch != 2 || output_bits != 16) {
+            // Mono powielane na oba kanały, 32 bit - starsze 16 bitów
+            for (int i = 0; i < n; i++) {
+                for (int c = 0; c < 2; c++) {
+                    int src = i * ch + (ch == 2 ? c : 0);
+                    bt_in[i * 2 + c] = output_bits == 16 ? ((const int16_t *)buf)[src]
+                                                         : (int16_t)(((const int32_t *)buf)[src] >> 16);
+                }
+            }
+            pcm = bt_in;
+        }
+        if (resample) {
+            int out = asrc_process(&bt_asrc, pcm, n, bt_out, sizeof(bt_out) / (2 * sizeof(int16_t)));
+            bt_tee_send((const uint8_t *)bt_out, out * 2 * sizeof(int16_t), paced);
+        } else {
+            bt_tee_send((const uint8_t *)pcm, n * 2 * sizeof(int16_t), paced);
+        }
+        buf += n * in_frame;
+        frames -= n;
+    }
+}
+
+// Wyjście EQ: bufor I2S i/lub bufor A2DP według trybu wyjścia
+static int output_write_cb(audio_element_handle_t el, char *buf, int len, TickType_t wait, void *ctx)
+{
+    player_output_t route = output_route();
+    if (route != PLAYER_OUTPUT_I2S) {
+        bt_tee(buf, len, route == PLAYER_OUTPUT_BT);
+    }
+    if (route == PLAYER_OUTPUT_BT) {
+        return len;     // I2S bez danych gra ciszę
+    }
+    return rb_write(audio_element_get_input_ringbuf(i2s_stream), buf, len, wait);
+}
+
+// Źródła na żywo: kolejka przed I2S trzymana krótko - opóźnienie wyznaczają bufor źródła
+// i DMA, nie bufor między EQ a I2S. true - kolejka pełna, odczyt odłożony.
+static bool output_live_queue_full(void)
+{
+    ringbuf_handle_t i2s_rb = equalizer ? audio_element_get_input_ringbuf(i2s_stream) : NULL;
+    if (i2s_rb) {
+        int filled = rb_bytes_filled(i2s_rb);
+        pipeline_stats_fill(PSTAT_I2S, filled, rb_get_size(i2s_rb));
+        if (filled > LIVE_QUEUE_BYTES) {
+            vTaskDelay(pdMS_TO_TICKS(LIVE_POLL_MS));
+            return true;
+        }
+    }
+    return false;
+}
+
+// Odbiornik Bluetooth: PCM z bufora jittera
+static int output_read_bt(char *buf, int len)
+{
+    if (output_live_queue_full()) {
+        return AEL_IO_TIMEOUT;
+    }
+
+    if (len > LIVE_READ_BYTES) len = LIVE_READ_BYTES;
+    int rlen = bluetooth_sink_read_pcm((uint8_t *)buf, len);
+    if (rlen <= 0) {
+        vTaskDelay(pdMS_TO_TICKS(LIVE_POLL_MS));  // Buforowanie lub przerwa w pakietach
+        return AEL_IO_TIMEOUT;
+    }
+    pipeline_stats_add_in(PSTAT_OUTPUT, rlen);
+    pipeline_stats_add_out(PSTAT_OUTPUT, rlen);
+    return rlen;
+}
+
+// Wejście AUX: PCM z ADC już po wzmocnieniu i pomiarze (aux_input.c)
+static int output_read_aux(char *buf, int len)
+{
+    if (output_live_queue_full()) {
+        return AEL_IO_TIMEOUT;
+    }
+
+    if (len > LIVE_READ_BYTES) len = LIVE_READ_BYTES;
+    int rlen = aux_input_read_pcm((uint8_t *)buf, len, OUTPUT_IDLE_WAIT_MS);
+    if (rlen <= 0) {
+        return AEL_IO_TIMEOUT;
+    }
+    pipeline_stats_add_in(PSTAT_OUTPUT, rlen);
+    pipeline_stats_add_out(PSTAT_OUTPUT, rlen);
+    return rlen;
+}
+
+static int output_read_cb(audio_element_handle_t el, char *buf, int len, TickType_t wait, void *ctx)
+{
+    ringbuf_handle_t rb = output_rb;
+    if (player_status->state == PLAYER_STATE_PLAYING && !output_format_pending) {
+        if (player_status->source == AUDIO_SOURCE_BLUETOOTH) {
+            return output_read_bt(buf, len);
+        }
+        if (player_status->source == AUDIO_SOURCE_AUX) {
+            return output_read_aux(buf, len);
+        }
+    }
+    if (rb == NULL || player_status->state != PLAYER_STATE_PLAYING || output_format_pending) {
+        vTaskDelay(pdMS_TO_TICKS(OUTPUT_IDLE_WAIT_MS));
+        return AEL_IO_TIMEOUT;
+    }
+    bool sd = (rb == sd_source->pcm_rb);
+    if (sd && sd_source_seek_pending()) {
+        vTaskDelay(pdMS_TO_TICKS(SD_SEEK_POLL_MS));  // Przewijanie - to nie underrun
+        return AEL_IO_TIMEOUT;
+    }
+    if (sd) {
+        len = sd_source_output_len(len);
+        if (len < 0) {
+            // Następny plik w innym formacie - wyjście czeka, aż task sterujący przestawi I2S
+            output_format_pending_since = now_ms();
+            output_format_pending = true;
+            return AEL_IO_TIMEOUT;
+        }
+    }
+
+    pipeline_stats_fill(PSTAT_OUTPUT, rb_bytes_filled(rb), rb_get_size(rb));
+    ringbuf_handle_t i2s_rb = audio_element_get_input_ringbuf(i2s_stream);
+    if (i2s_rb) {
+        pipeline_stats_fill(PSTAT_I2S, rb_bytes_filled(i2s_rb), rb_get_size(i2s_rb));
+    }
+
+    int rlen;
+    int out_len;
+    // Plik SD gra w tempie zegara I2S - bez resamplera (granica utworów w bajtach pcm_rb)
+    if (DRIFT_CORRECTION_ENABLED && !sd && output_bits == 16 &&
+        output_channels > 0 && output_channels <= ASRC_MAX_CHANNELS) {
+        rlen = output_read_drift(rb, buf, len, &out_len);
+    } else {
+        rlen = rb_read(rb, buf, len, pdMS_TO_TICKS(OUTPUT_IDLE_WAIT_MS));
+        out_len = rlen;
+    }
+
+    if (rlen > 0) {
+        if (sd) {
+            sd_source_output_read(rlen);
+        }
+        pipeline_stats_add_in(PSTAT_OUTPUT, rlen);
+        pipeline_stats_add_out(PSTAT_OUTPUT, out_len);  // Różnica tylko z korekty dryfu
+        switch_latency_done();
+        if (equalizer == NULL && out_len > 0) {
+            // Bez EQ rozgałęzienie tutaj; tempo zawsze wyznacza I2S (w trybie tylko BT - cisza)
+            player_output_t route = output_route();
+            if (route != PLAYER_OUTPUT_I2S) {
+                bt_tee(buf, out_len, false);
+                if (route == PLAYER_OUTPUT_BT) {
+                    memset(buf, 0, out_len);
+                }
+            }
+        }
+        return out_len > 0 ? out_len : AEL_IO_TIMEOUT;  // Niepełna ramka czeka na resztę
+    }
+    if (rlen == RB_TIMEOUT) {
+        pipeline_stats_underrun(PSTAT_OUTPUT);  // Słyszalna przerwa - I2S gra ciszę
+    } else {
+        if (rlen == RB_DONE && sd) {
+            sd_source_output_done();
+        }
+        // Bufor źródła zatrzymany (abort/done) - czekaj na restart źródła
+        vTaskDelay(pdMS_TO_TICKS(OUTPUT_IDLE_WAIT_MS));
+    }
+    return AEL_IO_TIMEOUT;
+}
+
+// Format wyjścia (EQ + zegar I2S) według źródła
+static void apply_output_format(int rate, int channels, int bits)
+{
+    if (rate <= 0 || channels <= 0) return;
+    if (bits <= 0) bits = 16;
+
+    if (rate != output_rate || channels != output_channels || bits != output_bits) {
+        ESP_LOGI(TAG, "Output format: %d Hz, %d ch, %d bit", rate, channels, bits);
+        // EQ przelicza współczynniki dla nowej częstotliwości próbkowania
+        if (equalizer) {
+            eq_filter_set_info(equalizer, rate, channels);
+        }
+        audio_element_set_music_info(i2s_stream, rate, channels, bits);
+        i2s_stream_set_clk(i2s_stream, rate, bits, channels);
+        output_rate = rate;
+        output_channels = channels;
+        output_bits = bits;
+        bt_flush = true;
+        aux_input_capture_set_rate(rate);
+    }
+    output_format_pending = false;
+}
+
+// Podłącza PCM źródła do etapu wyjściowego. Format znany z wcześniejszego music info
+// ustawiany od razu, w przeciwnym razie wyjście czeka na zdarzenie dekodera.
+static void output_select_rb(ringbuf_handle_t rb, int rate, int channels, int bits)
+{
+    output_format_pending_since = now_ms();
+    output_format_pending = true;
+    output_rb = rb;
+    drift_flush = true;
+    if (rate > 0) {
+        apply_output_format(rate, channels, bits);
+    }
+}
+
+static void output_select_slot(stream_slot_t *slot)
+{
+    output_select_rb(slot->pcm_rb, slot->sample_rate, slot->channels, slot->bits);
+}
+
+// ============================================
+// Pre-buffering
+// ============================================
 
 // Buffer monitoring
 static int current_buffer_percent = 0;
-static int prebuffer_counter = 0;
 static TimerHandle_t prebuffer_timer = NULL;
 
-#define PREBUFFER_TICKS  30  // 30 x 100ms = 3 seconds prebuffering
+static int buffered_ms = 0;
+static uint32_t buffering_started_ms = 0;
+static uint32_t stable_since_ms = 0;
+static uint32_t last_prebuffer_ms = 0;     // Czas od startu/rebuforowania do dźwięku
+
+// Ponowne połączenia aktywnego strumienia
+static uint32_t reconnect_count = 0;
+static uint32_t reconnect_audible = 0;      // Przerwa dłuższa niż zapas w buforze
+static uint32_t reconnect_last_gap_ms = 0;
+static uint32_t reconnect_max_gap_ms = 0;
 
 // Get buffer fill level (0-100%)
 int audio_player_get_buffer_level(void)
@@ -105,180 +687,1050 @@ int audio_player_get_buffer_level(void)
     return current_buffer_percent;
 }
 
-// Get real buffer fill level from I2S input ringbuffer (MP3 output)
-static int get_real_buffer_level(void)
+static int rb_filled(ringbuf_handle_t rb)
+{
+    return rb ? rb_bytes_filled(rb) : 0;
+}
+
+// Audio czekające na odtworzenie: aktywne źródło + PCM przed I2S
+static int get_buffered_ms(void)
 {
     if (i2s_stream == NULL) return 0;
 
-    ringbuf_handle_t rb = audio_element_get_input_ringbuf(i2s_stream);
-    if (rb == NULL) return 0;
+    int ms = player_status->source == AUDIO_SOURCE_SDCARD ? sd_source_buffered_ms()
+                                                          : stream_slot_buffered_ms(active_slot);
+    if (output_rate > 0 && output_channels > 0) {
+        int pcm = rb_filled(audio_element_get_input_ringbuf(i2s_stream));
+        ms += (int)((int64_t)pcm * 1000 / (output_rate * output_channels * 2));
+    }
+    return ms;
+}
+
+static void start_buffering(void)
+{
+    buffering_started_ms = now_ms();
+    current_buffer_percent = 0;
+    set_state(PLAYER_STATE_BUFFERING);
+}
+
+// Korekta dryfu: regulator trzyma średni poziom bufora w punkcie pracy stacji.
+// Przerwa w danych (reconnect) to nie dryf zegara - po niej nowy punkt pracy.
+static void drift_update(uint32_t now)
+{
+    if (drift_restart) {
+        drift_restart = false;
+        drift_relock = false;
+        asrc_ctrl_reset(&drift_ctrl);
+    }
 
-    int filled = rb_bytes_filled(rb);
-    int total = rb_get_size(rb);
+    if (now - active_slot->last_data_ms >= DRIFT_GAP_MS) {
+        drift_relock = true;
+        return;
+    }
+    if (drift_relock) {
+        drift_relock = false;
+        asrc_ctrl_relock(&drift_ctrl);
+    }
 
-    if (total <= 0) return 0;
-    return (filled * 100) / total;
+    bool was_locked = drift_ctrl.locked;
+    asrc_set_ppm(&output_asrc, asrc_ctrl_update(&drift_ctrl, buffered_ms, PREBUFFER_CHECK_MS));
+    if (drift_ctrl.locked && !was_locked) {
+        ESP_LOGI(TAG, "Drift correction: setpoint %d ms, %.1f ppm",
+                 (int)drift_ctrl.setpoint_ms, drift_ctrl.ppm);
+    }
 }
 
-// Pre-buffer timer callback - wait for buffer to fill, then start I2S
-static void prebuffer_timer_callback(TimerHandle_t xTimer)
+// Pre-buffer tick (task sterujący) - start output once the target duration is buffered,
+// return to buffering below the low watermark
+static void prebuffer_tick(void)
 {
-    // During buffering, count up and start I2S when buffer is full
-    if (player_status.state == PLAYER_STATE_BUFFERING) {
-        prebuffer_counter++;
+    uint32_t now = now_ms();
+    station_profile_t *profile = active_slot->profile;
+
+    // Telemetria: dane zapisane do I2S od poprzedniego sprawdzenia
+    static int64_t i2s_byte_pos = 0;
+    audio_element_info_t i2s_info = {0};
+    audio_element_getinfo(i2s_stream, &i2s_info);
+    if (i2s_info.byte_pos > i2s_byte_pos) {
+        uint32_t delta = (uint32_t)(i2s_info.byte_pos - i2s_byte_pos);
+        pipeline_stats_add_in(PSTAT_I2S, delta);
+        pipeline_stats_add_out(PSTAT_I2S, delta);
+    }
+    i2s_byte_pos = i2s_info.byte_pos;
+
+    // Szczyt zużycia pamięci w sesji (minimum od startu systemu nie daje się zerować)
+    size_t free_internal = heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    size_t free_psram = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    if (session_stats.min_free_internal == 0 || free_internal < session_stats.min_free_internal) {
+        session_stats.min_free_internal = free_internal;
+    }
+    if (session_stats.min_free_psram == 0 || free_psram < session_stats.min_free_psram) {
+        session_stats.min_free_psram = free_psram;
+    }
+
+    bool sd_active = (player_status->source == AUDIO_SOURCE_SDCARD);
+    if (sd_active) {
+        sd_source_stats_update(now);
+    }
+
+    // Dekoder nie zgłosił formatu - graj z dotychczasowym
+    if (output_format_pending && now - output_format_pending_since >= OUTPUT_FORMAT_TIMEOUT_MS) {
+        ESP_LOGW(TAG, "No music info from decoder, keeping current output format");
+        output_format_pending = false;
+    }
+
+    if (player_status->state == PLAYER_STATE_BUFFERING) {
+        buffered_ms = get_buffered_ms();
+        int target_ms = sd_active ? SD_PREBUFFER_MS : stream_slot_target_ms(active_slot);
 
-        // Use real buffer level during buffering
-        int real_level = get_real_buffer_level();
-        current_buffer_percent = real_level > 0 ? real_level : (prebuffer_counter * 100) / PREBUFFER_TICKS;
+        current_buffer_percent = buffered_ms * 100 / target_ms;
         if (current_buffer_percent > 100) current_buffer_percent = 100;
 
-        ESP_LOGI(TAG, "Buffering: %d%% (real: %d%%)", current_buffer_percent, real_level);
+        ESP_LOGD(TAG, "Buffering: %d/%d ms (%d kbps)", buffered_ms, target_ms,
+                 stream_slot_bitrate(active_slot));
 
-        if (prebuffer_counter >= PREBUFFER_TICKS) {
-            ESP_LOGI(TAG, "Prebuffer complete, resuming I2S output");
-            // Resume I2S - start playing from buffer
-            audio_element_resume(i2s_stream, 0, portMAX_DELAY);
+        // Krótki plik SD może się skończyć przed celem - dekoder zamknął bufor PCM
+        bool timeout = (now - buffering_started_ms >= PREBUFFER_TIMEOUT_MS) && buffered_ms > 0;
+        if (sd_active && sd_source->decode_done) {
+            timeout = true;
+        }
+        if (buffered_ms >= target_ms || timeout) {
+            last_prebuffer_ms = now - buffering_started_ms;
+            if (session_rebuffering) {
+                session_rebuffering = false;
+                session_stats.rebuffer_ms += last_prebuffer_ms;
+                if (last_prebuffer_ms > session_stats.rebuffer_max_ms) {
+                    session_stats.rebuffer_max_ms = last_prebuffer_ms;
+                }
+            }
+            ESP_LOGI(TAG, "Prebuffer complete in %lu ms (%d ms buffered%s), starting output",
+                     (unsigned long)last_prebuffer_ms, buffered_ms, timeout ? ", timeout" : "");
+            stable_since_ms = now;
             set_state(PLAYER_STATE_PLAYING);
-            current_buffer_percent = 100;
         }
     }
-    // During playback, monitor real buffer level
-    else if (player_status.state == PLAYER_STATE_PLAYING) {
-        current_buffer_percent = get_real_buffer_level();
-        prebuffer_counter = PREBUFFER_TICKS;
+    else if (player_status->state == PLAYER_STATE_PLAYING) {
+        buffered_ms = get_buffered_ms();
+        current_buffer_percent = sd_active ? sd_source_file_percent()
+                                           : stream_slot_http_percent(active_slot);
+
+        if (player_status->source != AUDIO_SOURCE_HTTP || profile == NULL) {
+            return;
+        }
+
+        if (buffered_ms < PREBUFFER_LOW_WATERMARK_MS && !reconnect_in_progress) {
+            // Underrun - wstrzymaj wyjście i zbuduj większy zapas dla tej stacji
+            station_profile_underrun(profile);
+            session_stats.underruns++;
+            session_rebuffering = true;
+            ESP_LOGW(TAG, "Buffer underrun (%d ms left, %u so far), rebuffering to %u ms",
+                     buffered_ms, profile->underruns, profile->target_ms);
+            start_buffering();
+            drift_relock = true;
+        } else if (now - stable_since_ms >= PREBUFFER_STABLE_MS) {
+            // Stabilne odtwarzanie - zmniejsz zapas dla szybszego startu następnym razem
+            station_profile_stable(profile);
+            stable_since_ms = now;
+        }
 
-        // Warn if buffer is getting low (< 30%)
-        if (current_buffer_percent < 30 && current_buffer_percent > 0) {
-            ESP_LOGW(TAG, "Buffer low: %d%%", current_buffer_percent);
+        if (player_status->state == PLAYER_STATE_PLAYING) {
+            drift_update(now);
         }
+        stream_slot_standby_check(standby_slot, now, player_status->current_url, stable_since_ms);
     }
     // Reset on stop/idle
     else {
-        prebuffer_counter = 0;
+        session_rebuffering = false;
         current_buffer_percent = 0;
+        buffered_ms = 0;
+    }
+
+    if (player_status->state != PLAYER_STATE_PLAYING) {
+        drift_relock = true;  // Pauza lub rebuforowanie zmienia poziom bufora
+    }
+}
+
+// Timer tylko zleca sprawdzenie - stan odtwarzacza zmienia wyłącznie task sterujący.
+// Najwyżej jedno zlecenie w kolejce, gdy task jest zajęty (np. zatrzymuje slot).
+static volatile bool prebuffer_tick_queued = false;
+
+static void prebuffer_timer_callback(TimerHandle_t xTimer)
+{
+    if (prebuffer_tick_queued) {
+        return;
+    }
+    prebuffer_tick_queued = true;
+    if (post_cmd(PLAYER_CMD_PREBUFFER_TICK, -1, 0, 0) != ESP_OK) {
+        prebuffer_tick_queued = false;
+    }
+}
+
+static void start_prebuffer_timer(void)
+{
+    // Create prebuffer timer if not exists
+    if (prebuffer_timer == NULL) {
+        prebuffer_timer = xTimerCreate("prebuf", pdMS_TO_TICKS(PREBUFFER_CHECK_MS),
+                                       pdTRUE, NULL, prebuffer_timer_callback);
+    }
+    xTimerStart(prebuffer_timer, 0);
+}
+
+void audio_player_get_buffer_stats(player_buffer_stats_t *stats)
+{
+    if (stats == NULL) return;
+
+    stats->bitrate_kbps = stream_slot_bitrate(active_slot);
+    stats->buffered_ms = buffered_ms;
+    stats->target_ms = stream_slot_target_ms(active_slot);
+    stats->underruns = active_slot->profile ? active_slot->profile->underruns : 0;
+    stats->prebuffer_ms = last_prebuffer_ms;
+    stats->reconnects = reconnect_count;
+    stats->reconnects_audible = reconnect_audible;
+    stats->reconnect_last_gap_ms = reconnect_last_gap_ms;
+    stats->reconnect_max_gap_ms = reconnect_max_gap_ms;
+    stats->drift_ppm = drift_ctrl.ppm;
+    stats->drift_locked = drift_ctrl.locked;
+    stats->drift_setpoint_ms = (int)drift_ctrl.setpoint_ms;
+    stats->drift_level_ms = (int)drift_ctrl.level_ms;
+}
+
+void audio_player_get_session_stats(player_session_stats_t *stats)
+{
+    if (stats == NULL) return;
+
+    *stats = session_stats;
+    stats->since_ms = now_ms() - session_started_ms;
+}
+
+void audio_player_reset_session_stats(void)
+{
+    // Wyścig z timerem prebufora najwyżej gubi jedną próbkę - bez blokady
+    memset(&session_stats, 0, sizeof(session_stats));
+    session_first_audio_total = 0;
+    session_started_ms = now_ms();
+    ESP_LOGI(TAG, "Session stats reset");
+}
+
+void audio_player_get_switch_stats(player_switch_stats_t *stats)
+{
+    if (stats == NULL) return;
+
+    *stats = switch_stats;
+    stats->standby_enabled = (standby_slot != NULL);
+    stats->standby_budget_kb = standby_slot ? STANDBY_BUFFER_KB : 0;
+    stats->standby_ready = standby_slot && standby_slot->running && !standby_slot->switch_pending;
+    stats->standby_buffered_ms = stats->standby_ready ? stream_slot_buffered_ms(standby_slot) : 0;
+    stats->standby_url = stats->standby_ready ? standby_slot->url : "";
+}
+
+// ============================================
+// Źródła: sloty strumieni i tor SD
+// ============================================
+
+static stream_slot_t *slot_for_element(void *el)
+{
+    for (int i = 0; i < STREAM_SLOT_COUNT; i++) {
+        if (stream_slot_owns(&stream_slots[i], el)) {
+            return &stream_slots[i];
+        }
+    }
+    return NULL;
+}
+
+// Zdarzenia slotu (task http_stream, tick prebufora) jako komendy taska sterującego
+static esp_err_t slot_post(stream_slot_t *slot, stream_slot_event_t event)
+{
+    switch (event) {
+        case SLOT_EVENT_DECODER_SWITCH:
+            return post_cmd(PLAYER_CMD_DECODER_SWITCH, slot->index, 0, slot->generation);
+        case SLOT_EVENT_TITLE:
+            return post_cmd(PLAYER_CMD_TITLE, slot->index, 0, slot->generation);
+        case SLOT_EVENT_STANDBY_ARM:
+            return post_cmd(PLAYER_CMD_STANDBY_ARM, slot->index, 0, slot->generation);
+        default:
+            return ESP_ERR_INVALID_ARG;
     }
 }
 
-// Jednorazowy task do zmiany stacji (wymaga większego stosu niż event task)
-static void next_station_task(void *pvParameters)
+// Aktywny slot połączył się ponownie w tasku http_stream
+static void slot_reconnected(uint32_t gap, int buffered_at_loss)
+{
+    reconnect_count++;
+    reconnect_last_gap_ms = gap;
+    if (gap > reconnect_max_gap_ms) reconnect_max_gap_ms = gap;
+    if ((int)gap >= buffered_at_loss) reconnect_audible++;
+    session_stats.reconnects++;
+    if (gap > session_stats.reconnect_max_gap_ms) session_stats.reconnect_max_gap_ms = gap;
+}
+
+// Nowsze żądanie odtwarzania czeka w kolejce - połączenie aktywnego slotu zbędne
+static bool slot_superseded(void)
+{
+    return play_seq != play_done_seq;
+}
+
+static const stream_slot_hooks_t slot_hooks = {
+    .post = slot_post,
+    .buffered_ms = get_buffered_ms,
+    .reconnected = slot_reconnected,
+    .superseded = slot_superseded,
+};
+
+// Tytuł aktywnego slotu do statusu odtwarzacza
+static void publish_slot_title(stream_slot_t *slot)
 {
-    audio_player_play_next_station();
-    vTaskDelete(NULL);
+    player_status_set_title(slot->icy_title);
+    player_status_set_artist(slot->icy_artist);
+    notify_state_change();
 }
 
-// Jednorazowy task do reconnect (nie blokuje event taska)
-static void reconnect_task(void *pvParameters)
+// Zdarzenia toru SD (task zdarzeń, etap wyjściowy) jako komendy taska sterującego
+static esp_err_t sd_post(sd_source_event_t event, int32_t value, uint32_t gen)
 {
-    const char *url = (const char *)pvParameters;
-    if (url && strlen(url) > 0) {
-        ESP_LOGI(TAG, "Reconnect task: reconnecting to %s", url);
-        vTaskDelay(pdMS_TO_TICKS(500));  // Krótka pauza przed reconnect
-        audio_player_play_url(url);
+    switch (event) {
+        case SD_EVENT_FORMAT:   return post_cmd(PLAYER_CMD_FORMAT, CMD_SLOT_SD, 0, gen);
+        case SD_EVENT_CHAIN:    return post_cmd(PLAYER_CMD_SD_CHAIN, CMD_SLOT_SD, 0, gen);
+        case SD_EVENT_NEXT:     return post_cmd(PLAYER_CMD_SD_NEXT, CMD_SLOT_SD, 0, gen);
+        case SD_EVENT_END:      return post_cmd(PLAYER_CMD_SD_END, CMD_SLOT_SD, 0, gen);
+        case SD_EVENT_ERROR:    return post_cmd(PLAYER_CMD_ERROR, CMD_SLOT_SD, value, gen);
+        default:                return ESP_ERR_INVALID_ARG;
+    }
+}
+
+static const sd_source_hooks_t sd_hooks = {
+    .post = sd_post,
+};
+
+// Zmiana głośności względem najnowszej żądanej (seria wciśnięć sumuje się)
+static void request_volume_step(int delta);
+
+// ============================================
+// Task obsługi zdarzeń audio
+// ============================================
+
+static void audio_event_task(void *pvParameters)
+{
+    while (1) {
+        audio_event_iface_msg_t msg;
+        esp_err_t ret = audio_event_iface_listen(evt, &msg, portMAX_DELAY);
+        if (ret != ESP_OK) {
+            continue;
+        }
+
+        stream_slot_t *slot = NULL;
+        if (msg.source_type == AUDIO_ELEMENT_TYPE_ELEMENT) {
+            slot = slot_for_element(msg.source);
+        }
+
+        // Zdarzenia HTTP stream / dekodera (format strumienia)
+        if (slot && msg.cmd == AEL_MSG_CMD_REPORT_MUSIC_INFO &&
+            stream_slot_music_info(slot, (audio_element_handle_t)msg.source)) {
+            post_cmd(PLAYER_CMD_FORMAT, slot->index, 0, slot->generation);
+        }
+
+        // Tor SD: format pliku, koniec danych i błędy (sd_source.c)
+        bool sd_event = sd_source_handle_event(&msg);
+
+        // HTTP stream zakończył pobieranie - ponowne łączenie w elemencie się nie powiodło,
+        // pełny restart stacji w tasku sterującym
+        if (slot && msg.source == (void *)slot->http &&
+            msg.cmd == AEL_MSG_CMD_REPORT_STATUS &&
+            (int)msg.data == AEL_STATUS_STATE_FINISHED) {
+
+            if (slot == standby_slot) {
+                post_cmd(PLAYER_CMD_STANDBY_FAILED, slot->index, 0, slot->generation);
+            } else if (player_status->source == AUDIO_SOURCE_HTTP &&
+                       player_status->state == PLAYER_STATE_PLAYING &&
+                       strlen(player_status->current_url) > 0 &&
+                       !reconnect_in_progress && !slot->switch_pending) {
+                ESP_LOGW(TAG, "HTTP stream ended, scheduling reconnect...");
+                reconnect_in_progress = true;
+                if (post_cmd(PLAYER_CMD_RECONNECT, slot->index, 0, slot->generation) != ESP_OK) {
+                    reconnect_in_progress = false;
+                }
+            }
+        }
+
+        // Zdarzenie błędu (AEL_STATUS_ERROR_* są w zakresie 1-7)
+        if (msg.source_type == AUDIO_ELEMENT_TYPE_ELEMENT && !sd_event &&
+            msg.cmd == AEL_MSG_CMD_REPORT_STATUS &&
+            (int)msg.data >= AEL_STATUS_ERROR_OPEN &&
+            (int)msg.data <= AEL_STATUS_ERROR_UNKNOWN) {
+
+            if (slot && slot->switch_pending) {
+                // Stary dekoder dostał dane w innym formacie - restart już zaplanowany
+                ESP_LOGW(TAG, "Error %d ignored during decoder switch", (int)msg.data);
+            } else if (slot && slot == standby_slot) {
+                post_cmd(PLAYER_CMD_STANDBY_FAILED, slot->index, 0, slot->generation);
+            } else {
+                post_cmd(PLAYER_CMD_ERROR, slot ? slot->index : -1, (int)msg.data,
+                         slot ? slot->generation : 0);
+            }
+        }
+
+        // Obsługa przycisków na płytce
+        if ((msg.source_type == PERIPH_ID_TOUCH || msg.source_type == PERIPH_ID_BUTTON)
+            && (msg.cmd == PERIPH_TOUCH_TAP || msg.cmd == PERIPH_BUTTON_PRESSED)) {
+            if ((int)msg.data == get_input_play_id()) {
+                ESP_LOGI(TAG, "Play/Pause button pressed");
+                if (player_status->state == PLAYER_STATE_PLAYING) {
+                    audio_player_pause();
+                } else {
+                    audio_player_resume();
+                }
+            } else if ((int)msg.data == get_input_volup_id()) {
+                ESP_LOGI(TAG, "Volume Up button pressed");
+                request_volume_step(5);
+            } else if ((int)msg.data == get_input_voldown_id()) {
+                ESP_LOGI(TAG, "Volume Down button pressed");
+                request_volume_step(-5);
+            } else if ((int)msg.data == get_input_set_id()) {
+                ESP_LOGI(TAG, "Set button pressed - next station");
+                audio_player_play_next_station();
+            } else if ((int)msg.data == get_input_rec_id()) {
+                ESP_LOGI(TAG, "Rec button pressed - next station");
+                audio_player_play_next_station();
+            }
+        }
+    }
+}
+
+// ============================================
+// Task sterujący
+// ============================================
+
+static esp_err_t ctrl_play_url(const char *url)
+{
+    esp_err_t ret = ESP_OK;
+
+    // Pomiar opóźnienia przełączenia: od wywołania do pierwszych próbek na wyjściu
+    uint32_t started = now_ms();
+    switch_started_ms = 0;
+    drift_restart = true;  // Inny serwer - inny zegar
+
+    // Wyjście przestaje pobierać dane - stara stacja milknie od razu
+    player_status_set_source(AUDIO_SOURCE_HTTP);
+    player_status_set_album("");
+    status_set_position(0, 0, 0);
+    start_buffering();  // Start as buffering, timer will switch to playing
+    sd_source_stop();
+
+    if (standby_slot && standby_slot->running && !standby_slot->switch_pending &&
+        strcmp(standby_slot->url, url) == 0) {
+        // Warm standby: stacja już połączona - zamień sloty i wznów dekoder
+        ESP_LOGI(TAG, "Switching to warm standby stream");
+        stream_slot_t *previous = active_slot;
+        active_slot = standby_slot;
+        standby_slot = previous;
+        active_slot->active = true;
+        standby_slot->active = false;
+
+        stream_slot_resume_decoder(active_slot);
+        output_select_slot(active_slot);
+        switch_warm = true;
+        switch_stats.standby_hits++;
+
+        // Poprzedni strumień zatrzymujemy po przełączeniu - nie opóźnia dźwięku
+        stream_slot_stop(standby_slot);
+        stream_slot_standby_reset();
+    } else {
+        // Zimny start: zatrzymaj obecne odtwarzanie i połącz od nowa
+        ESP_LOGI(TAG, "Starting pipeline with prebuffering...");
+        ret = stream_slot_start(active_slot, url);
+        output_select_slot(active_slot);
+        switch_warm = false;
+        if (standby_slot) {
+            switch_stats.standby_misses++;
+        }
+    }
+
+    if (ret == ESP_OK) {
+        if (url != player_status->current_url) {  // Reconnect przekazuje current_url
+            player_status_set_url(url);
+        }
+        switch_started_ms = started;
+        stable_since_ms = started;
+
+        // Tytuł nowej stacji: z metadanych standby lub pusty do pierwszego bloku ICY
+        publish_slot_title(active_slot);
+
+        // Zapisz URL dla autostartu
+        audio_settings_set_last_url(url);
+
+        // Start buffer monitoring
+        start_prebuffer_timer();
+    } else {
+        ESP_LOGE(TAG, "Failed to start pipeline: %s", esp_err_to_name(ret));
+        set_state(PLAYER_STATE_ERROR);
+    }
+
+    return ret;
+}
+
+static void ctrl_play_error(const char *what, const char *path, esp_err_t ret)
+{
+    ESP_LOGE(TAG, "%s: %s (%s)", what, path, esp_err_to_name(ret));
+    set_state(PLAYER_STATE_ERROR);
+}
+
+// Tytuł i wykonawca bieżącego pliku SD z indeksu biblioteki, bez niego - nazwa pliku
+static void publish_sd_track(void)
+{
+    static sd_file_info_t info;  // Tylko task sterujący
+    const char *path = sd_source->path;
+    if (!media_index_lookup(path, &info)) {
+        const char *name = strrchr(path, '/');
+        name = name ? name + 1 : path;
+        strncpy(info.title, name, sizeof(info.title) - 1);
+        info.title[sizeof(info.title) - 1] = '\0';
+        char *dot = strrchr(info.title, '.');
+        if (dot) *dot = '\0';
+        info.artist[0] = '\0';
+        info.album[0] = '\0';
+        info.duration_ms = 0;
+    }
+
+    player_status_set_url(path);
+    player_status_set_title(info.title);
+    player_status_set_artist(info.artist);
+    player_status_set_album(info.album);
+    status_set_position(info.duration_ms, 0, 0);   // Pozycja SD: audio_player_get_position_ms()
+    notify_state_change();
+
+    // MP3 VBR bez dokładnego TOC - tabela ramek budowana w tle na następne przewinięcia
+    if (sd_source->codec == ESP_CODEC_TYPE_MP3) {
+        media_index_request_seek_table(path);
+    }
+}
+
+// Plik z karty SD od pozycji start_ms. Etap wyjściowy (EQ, I2S) działa dalej - przełączenie
+// z radia zatrzymuje tylko sloty HTTP i podmienia źródło PCM.
+static esp_err_t ctrl_play_sd(const char *path, uint32_t start_ms)
+{
+    uint32_t started = now_ms();
+    switch_started_ms = 0;
+
+    if (!sdcard_player_is_card_inserted()) {
+        ctrl_play_error("SD card not available", path, ESP_ERR_NOT_FOUND);
+        return ESP_ERR_NOT_FOUND;
+    }
+    esp_err_t ret = sd_source_init(evt, &sd_hooks);
+    if (ret != ESP_OK) {
+        ctrl_play_error("SD pipeline init failed", path, ret);
+        return ret;
+    }
+
+    // Wyjście przestaje pobierać dane - poprzednie źródło milknie od razu
+    player_status_set_source(AUDIO_SOURCE_SDCARD);
+    start_buffering();
+
+    stream_slot_stop(active_slot);
+    if (standby_slot && standby_slot->running) {
+        stream_slot_stop(standby_slot);
+    }
+
+    ret = sd_source_start(path, start_ms);
+    if (ret != ESP_OK) {
+        set_state(PLAYER_STATE_ERROR);
+        return ret;
+    }
+
+    // Plik gra w tempie zegara I2S - korekta dryfu niepotrzebna
+    asrc_set_ppm(&output_asrc, 0);
+    output_select_rb(sd_source->pcm_rb, 0, 0, 0);
+    switch_warm = false;
+    switch_started_ms = started;
+    stable_since_ms = started;
+
+    publish_sd_track();
+    start_prebuffer_timer();
+    return ESP_OK;
+}
+
+// Następny plik do odtwarzania bez przerwy - przygotowany od razu, żeby przejście na końcu
+// bieżącego nie czekało na kartę
+static void ctrl_prime_request(void)
+{
+    char path[sizeof(requested_next)];
+
+    xSemaphoreTake(request_lock, portMAX_DELAY);
+    bool queued = next_queued;
+    next_queued = false;
+    strcpy(path, requested_next);
+    xSemaphoreGive(request_lock);
+
+    if (queued) {
+        sd_source_prime(path);
+    }
+}
+
+// Dekoder skończył plik - tor SD przechodzi na przygotowany następny (sd_source_chain)
+static void ctrl_chain_sd(void)
+{
+    sd_source_chain(player_status->state == PLAYER_STATE_PAUSED);
+}
+
+// Etap wyjściowy przeszedł granicę utworów - następny plik staje się bieżącym
+static void ctrl_sd_next(void)
+{
+    if (!sd_source_advance()) {
+        return;
+    }
+    if (output_format_pending && sd_source->sample_rate > 0) {
+        apply_output_format(sd_source->sample_rate, sd_source->channels, sd_source->bits);
+    }
+    publish_sd_track();
+
+    // Odtwarzacz SD przesuwa playlistę i przygotowuje kolejny plik
+    if (track_next_callback) {
+        track_next_callback(sd_source->path);
+    }
+}
+
+static void ctrl_seek_sd(uint32_t ms)
+{
+    if (player_status->source != AUDIO_SOURCE_SDCARD || !sd_source->running) {
+        return;
+    }
+
+    // Granica utworów minęła, a komenda SD_NEXT jeszcze czeka - przewijany jest nowy plik
+    if (sd_source_next_pending()) {
+        ctrl_sd_next();
+    }
+
+    esp_err_t ret = sd_source_seek(ms, player_status->state == PLAYER_STATE_PAUSED,
+                                   player_status->state == PLAYER_STATE_PLAYING);
+    if (ret == ESP_OK) {
+        drift_flush = true;
+    } else if (ret != ESP_ERR_NOT_SUPPORTED) {
+        set_state(PLAYER_STATE_ERROR);  // Tor nie wystartował od nowej pozycji
+    }
+}
+
+// Najnowsza żądana pozycja - seria przesunięć suwaka daje jedno przewinięcie
+static void ctrl_seek_request(void)
+{
+    xSemaphoreTake(request_lock, portMAX_DELAY);
+    bool queued = seek_queued;
+    seek_queued = false;
+    uint32_t ms = requested_seek_ms;
+    xSemaphoreGive(request_lock);
+
+    if (queued) {
+        ctrl_seek_sd(ms);
+    }
+}
+
+// Wykonuje żądanie odtwarzania o numerze seq, o ile nie zastąpiło go nowsze
+static void ctrl_play_request(uint32_t seq)
+{
+    char url[sizeof(requested_url)];
+    audio_source_t source = AUDIO_SOURCE_HTTP;
+    uint32_t start_ms = 0;
+
+    xSemaphoreTake(request_lock, portMAX_DELAY);
+    bool current = (seq == play_seq && seq != play_done_seq);
+    if (current) {
+        strcpy(url, requested_url);
+        source = requested_source;
+        start_ms = requested_start_ms;
+        play_done_seq = seq;
+    }
+    xSemaphoreGive(request_lock);
+
+    if (!current) {
+        return;
+    }
+    if (source == AUDIO_SOURCE_SDCARD) {
+        ESP_LOGI(TAG, "Playing file: %s", url);
+        ctrl_play_sd(url, start_ms);
+    } else {
+        ESP_LOGI(TAG, "Playing URL: %s", url);
+        ctrl_play_url(url);
+    }
+}
+
+// Metadane i pozycja AVRCP do wspólnego statusu (MQTT, WebSocket, /api/status).
+// Pola bez zmian nie generują powiadomienia.
+static void ctrl_bt_track(void)
+{
+    if (player_status->source != AUDIO_SOURCE_BLUETOOTH) {
+        return;
+    }
+    bluetooth_sink_publish_track();
+    notify_state_change();
+}
+
+// Źródło na żywo (BT, AUX) przejmuje wyjście: sloty HTTP i tor SD zatrzymane
+static void ctrl_release_sources(void)
+{
+    stream_slot_stop(active_slot);
+    if (standby_slot && standby_slot->running) {
+        stream_slot_stop(standby_slot);
+    }
+    sd_source_release();
+    output_rb = NULL;
+}
+
+// Odbiornik Bluetooth: PCM z bufora jittera prosto do etapu wyjściowego (EQ, I2S).
+// Sloty HTTP i tor SD są zatrzymywane - telefon ma pierwszeństwo jak w głośniku BT.
+static void ctrl_play_bt(int rate, int channels)
+{
+    ESP_LOGI(TAG, "Bluetooth sink stream: %d Hz, %d ch", rate, channels);
+    player_status_set_source(AUDIO_SOURCE_BLUETOOTH);
+    ctrl_release_sources();
+    apply_output_format(rate, channels, 16);
+    player_status_set_url("bluetooth");
+    ctrl_bt_track();
+    set_state(PLAYER_STATE_PLAYING);
+}
+
+static void ctrl_stop_bt(void)
+{
+    if (player_status->source == AUDIO_SOURCE_BLUETOOTH &&
+        player_status->state == PLAYER_STATE_PLAYING) {
+        ESP_LOGI(TAG, "Bluetooth sink stream stopped");
+        // Pauza na telefonie też zawiesza strumień A2DP - dla UI to pauza, nie stop
+        set_state(bluetooth_sink_get_playback_status() == BT_PLAYBACK_PAUSED ?
+                  PLAYER_STATE_PAUSED : PLAYER_STATE_STOPPED);
+    }
+}
+
+// Czytnik ADC włączany razem z wejściem AUX (aux_input_enable) - także bez odtwarzania AUX,
+// bo pomiar poziomu decyduje o automatycznym przełączeniu
+static void ctrl_aux_capture(bool on)
+{
+    if (on) {
+        aux_input_capture_start();
+        return;
+    }
+    if (!aux_input_is_capturing()) return;
+
+    if (player_status->source == AUDIO_SOURCE_AUX &&
+        (player_status->state == PLAYER_STATE_PLAYING || player_status->state == PLAYER_STATE_PAUSED)) {
+        set_state(PLAYER_STATE_STOPPED);
+    }
+    aux_input_capture_stop();
+}
+
+// Wejście AUX: PCM z ADC przez wspólny tor (wzmocnienie AUX, EQ, głośność kodeka) do I2S
+static void ctrl_play_aux(void)
+{
+    if (aux_input_capture_start() != ESP_OK) {
+        set_state(PLAYER_STATE_ERROR);
+        return;
+    }
+
+    ESP_LOGI(TAG, "Playing AUX input");
+    if (player_status->source == AUDIO_SOURCE_BLUETOOTH) {
+        bluetooth_sink_pause();     // Telefon przestaje nadawać do bufora, którego nikt nie czyta
+    }
+    player_status_set_source(AUDIO_SOURCE_AUX);
+    ctrl_release_sources();
+
+    aux_input_flush_pcm();
+    apply_output_format(AUX_SAMPLE_RATE, 2, 16);
+    player_status_set_url("aux");
+    player_status_set_title("AUX");
+    player_status_set_artist("");
+    player_status_set_album("");
+    status_set_position(0, 0, 0);
+    notify_state_change();
+    set_state(PLAYER_STATE_PLAYING);
+}
+
+static void ctrl_stop_aux(void)
+{
+    if (player_status->source == AUDIO_SOURCE_AUX &&
+        (player_status->state == PLAYER_STATE_PLAYING || player_status->state == PLAYER_STATE_PAUSED)) {
+        ESP_LOGI(TAG, "AUX playback stopped");
+        set_state(PLAYER_STATE_STOPPED);
+    }
+}
+
+static void ctrl_stop(void)
+{
+    if (player_status->source == AUDIO_SOURCE_BLUETOOTH) {
+        bluetooth_sink_pause();     // Inaczej telefon nadaje dalej do pełnego bufora
+    }
+    set_state(PLAYER_STATE_STOPPED);
+    sd_source_release();
+    stream_slot_stop(active_slot);
+
+    // Standby nie ma sensu po zatrzymaniu - zwolnij połączenie
+    if (standby_slot && standby_slot->running) {
+        stream_slot_stop(standby_slot);
+    }
+}
+
+// Pipeline aktywnego źródła (slot HTTP lub tor SD)
+static audio_pipeline_handle_t ctrl_source_pipeline(void)
+{
+    if (player_status->source == AUDIO_SOURCE_SDCARD && sd_source->pipeline) {
+        return sd_source->pipeline;
+    }
+    return active_slot->pipeline;
+}
+
+static void ctrl_pause(void)
+{
+    if (player_status->source == AUDIO_SOURCE_BLUETOOTH) {
+        bluetooth_sink_pause();
+        set_state(PLAYER_STATE_PAUSED);
+        return;
+    }
+    if (player_status->source == AUDIO_SOURCE_AUX) {
+        set_state(PLAYER_STATE_PAUSED);     // Czytnik dalej mierzy poziom, PCM odrzucany
+        return;
+    }
+    if (audio_pipeline_pause(ctrl_source_pipeline()) == ESP_OK) {
+        set_state(PLAYER_STATE_PAUSED);
+    }
+}
+
+static void ctrl_resume(void)
+{
+    if (player_status->source == AUDIO_SOURCE_BLUETOOTH) {
+        bluetooth_sink_play();      // Strumień wraca zdarzeniem startu A2DP
+        return;
+    }
+    if (player_status->source == AUDIO_SOURCE_AUX) {
+        ctrl_play_aux();
+        return;
+    }
+    if (player_status->source == AUDIO_SOURCE_SDCARD) {
+        sd_source_resumed();
+    }
+    if (audio_pipeline_resume(ctrl_source_pipeline()) == ESP_OK) {
+        stable_since_ms = now_ms();
+        set_state(PLAYER_STATE_PLAYING);
+    }
+}
+
+// Timer do debounce aktualizacji głośności kodeka
+static TimerHandle_t volume_timer = NULL;
+static int pending_volume = -1;
+
+static void volume_timer_callback(TimerHandle_t xTimer)
+{
+    if (pending_volume >= 0 && board_handle) {
+        audio_hal_set_volume(board_handle->audio_hal, pending_volume);
+        pending_volume = -1;
+    }
+}
+
+// Najnowsza żądana głośność - seria zmian suwaka daje jedną aktualizację
+static void ctrl_volume_request(void)
+{
+    xSemaphoreTake(request_lock, portMAX_DELAY);
+    volume_queued = false;
+    int volume = requested_volume;
+    xSemaphoreGive(request_lock);
+
+    if (volume == player_status->volume) {
+        return;
+    }
+    player_status_set_volume(volume);
+
+    // Zapisz głośność do NVS (już debounced w audio_settings)
+    audio_settings_set_volume(volume);
+
+    // Debounce aktualizacji kodeka - zapobiegaj mikro-przerwom przy przesuwaniu suwaka
+    if (!player_status->muted && board_handle) {
+        pending_volume = volume;
+
+        // Utwórz timer jeśli nie istnieje
+        if (volume_timer == NULL) {
+            volume_timer = xTimerCreate("vol_timer", pdMS_TO_TICKS(50), pdFALSE, NULL, volume_timer_callback);
+        }
+
+        // Reset timer - aktualizacja kodeka nastąpi 50ms po ostatniej zmianie
+        if (volume_timer) {
+            xTimerReset(volume_timer, 0);
+        }
+    }
+
+    notify_state_change();
+}
+
+static void ctrl_mute(bool mute)
+{
+    player_status_set_muted(mute);
+
+    if (board_handle) {
+        if (mute) {
+            audio_hal_set_volume(board_handle->audio_hal, 0);
+        } else {
+            audio_hal_set_volume(board_handle->audio_hal, player_status->volume);
+        }
+    }
+
+    ESP_LOGI(TAG, "Mute: %s", mute ? "ON" : "OFF");
+    notify_state_change();
+}
+
+// Połącz standby z następną stacją po bieżącej
+static void ctrl_standby_arm(void)
+{
+    const char *name = NULL;
+    const char *url = NULL;
+    if (player_status->source == AUDIO_SOURCE_HTTP) {
+        url = next_station_url(player_status->current_url, &name);
+    }
+    stream_slot_standby_arm(standby_slot, player_status->current_url, url, name);
+}
+
+// Slot, którego dotyczy komenda - NULL jeśli slot od tego czasu został zrestartowany
+static stream_slot_t *cmd_slot(const player_cmd_t *cmd)
+{
+    if (cmd->slot < 0 || cmd->slot >= STREAM_SLOT_COUNT) return NULL;
+    stream_slot_t *slot = &stream_slots[cmd->slot];
+    return slot->generation == cmd->gen ? slot : NULL;
+}
+
+static void ctrl_handle(const player_cmd_t *cmd)
+{
+    stream_slot_t *slot = cmd_slot(cmd);
+    bool http_active = (slot != NULL && slot == active_slot &&
+                        player_status->source == AUDIO_SOURCE_HTTP);
+    bool sd_active = (cmd->slot == CMD_SLOT_SD && cmd->gen == sd_source->generation &&
+                      player_status->source == AUDIO_SOURCE_SDCARD);
+
+    switch (cmd->type) {
+        case PLAYER_CMD_PLAY:
+            ctrl_play_request(cmd->gen);
+            break;
+        case PLAYER_CMD_STOP:
+            ESP_LOGI(TAG, "Stopping playback");
+            ctrl_stop();
+            break;
+        case PLAYER_CMD_PAUSE:
+            ESP_LOGI(TAG, "Pausing playback");
+            ctrl_pause();
+            break;
+        case PLAYER_CMD_RESUME:
+            ESP_LOGI(TAG, "Resuming playback");
+            ctrl_resume();
+            break;
+        case PLAYER_CMD_VOLUME:
+            ctrl_volume_request();
+            break;
+        case PLAYER_CMD_MUTE:
+            ctrl_mute(cmd->value != 0);
+            break;
+        case PLAYER_CMD_RECONNECT:
+            if (http_active) {
+                ESP_LOGI(TAG, "Reconnecting to %s", player_status->current_url);
+                ctrl_play_url(player_status->current_url);
+            }
+            reconnect_in_progress = false;
+            break;
+        case PLAYER_CMD_DECODER_SWITCH:
+            if (slot && slot->running) {
+                stream_slot_start(slot, slot->url);  // Dobierze dekoder z profilu stacji
+            }
+            stream_slots[cmd->slot].switch_pending = false;
+            break;
+        case PLAYER_CMD_STANDBY_ARM:
+            ctrl_standby_arm();
+            break;
+        case PLAYER_CMD_STANDBY_FAILED:
+            if (slot && slot == standby_slot) {
+                stream_slot_standby_failed(standby_slot);
+            }
+            break;
+        case PLAYER_CMD_FORMAT:
+            if (http_active) {
+                apply_output_format(slot->sample_rate, slot->channels, slot->bits);
+            } else if (sd_active) {
+                apply_output_format(sd_source->sample_rate, sd_source->channels, sd_source->bits);
+            }
+            break;
+        case PLAYER_CMD_TITLE:
+            if (http_active) {
+                publish_slot_title(slot);
+            }
+            break;
+        case PLAYER_CMD_NOTIFY:
+            notify_state_change();
+            break;
+        case PLAYER_CMD_ERROR:
+            // Błąd zrestartowanego slotu dotyczy poprzedniej stacji
+            if (cmd->slot < 0 || slot == active_slot || sd_active) {
+                ESP_LOGE(TAG, "Playback error: %d", (int)cmd->value);
+                set_state(PLAYER_STATE_ERROR);
+            }
+            break;
+        case PLAYER_CMD_SD_END:
+            if (sd_active) {
+                ESP_LOGI(TAG, "SD track finished: %s", sd_source->path);
+                sd_source_stop();
+                set_state(PLAYER_STATE_STOPPED);
+                // Następny utwór wybiera odtwarzacz SD (playlista, tryb powtarzania)
+                if (track_end_callback) {
+                    track_end_callback(sd_source->path);
+                }
+            }
+            break;
+        case PLAYER_CMD_SD_SEEK:
+            ctrl_seek_request();
+            break;
+        case PLAYER_CMD_SD_PRIME:
+            ctrl_prime_request();
+            break;
+        case PLAYER_CMD_SD_CHAIN:
+            if (sd_active) {
+                ctrl_chain_sd();
+            }
+            break;
+        case PLAYER_CMD_SD_NEXT:
+            if (sd_active) {
+                ctrl_sd_next();
+            }
+            break;
+        case PLAYER_CMD_BT_START:
+            ctrl_play_bt((int)cmd->value, (int)cmd->gen);
+            break;
+        case PLAYER_CMD_BT_STOP:
+            ctrl_stop_bt();
+            break;
+        case PLAYER_CMD_BT_TRACK:
+            ctrl_bt_track();
+            break;
+        case PLAYER_CMD_AUX_CAPTURE:
+            ctrl_aux_capture(cmd->value != 0);
+            break;
+        case PLAYER_CMD_AUX_START:
+            ctrl_play_aux();
+            break;
+        case PLAYER_CMD_AUX_STOP:
+            ctrl_stop_aux();
+            break;
+        case PLAYER_CMD_PREBUFFER_TICK:
+            prebuffer_tick_queued = false;
+            prebuffer_tick();
+            break;
+        default:
+            break;
     }
-    reconnect_in_progress = false;
-    vTaskDelete(NULL);
 }
 
-// ============================================
-// Task obsługi zdarzeń audio
-// ============================================
-
-static void audio_event_task(void *pvParameters)
+static void player_ctrl_task(void *pvParameters)
 {
+    player_cmd_t cmd;
+
     while (1) {
-        audio_event_iface_msg_t msg;
-        esp_err_t ret = audio_event_iface_listen(evt, &msg, portMAX_DELAY);
-        if (ret != ESP_OK) {
+        if (xQueueReceive(cmd_queue, &cmd, portMAX_DELAY) != pdTRUE) {
             continue;
         }
-
-        // Zdarzenia HTTP stream (metadane, etc.)
-        if (msg.source_type == AUDIO_ELEMENT_TYPE_ELEMENT &&
-            msg.source == (void *)http_stream &&
-            msg.cmd == AEL_MSG_CMD_REPORT_MUSIC_INFO) {
-
-            audio_element_info_t music_info = {0};
-            audio_element_getinfo(http_stream, &music_info);
-            ESP_LOGI(TAG, "Music info: sample_rate=%d, channels=%d, bits=%d",
-                     music_info.sample_rates, music_info.channels, music_info.bits);
-
-            // Konfiguracja filtra resampling jeśli potrzebna
-            audio_element_set_music_info(i2s_stream, music_info.sample_rates,
-                                         music_info.channels, music_info.bits);
-        }
-
-        // HTTP stream zakończył pobieranie - dla radia znaczy zerwane połączenie
-        // Używamy osobnego taska żeby nie blokować event loop i web server
-        if (msg.source_type == AUDIO_ELEMENT_TYPE_ELEMENT &&
-            msg.source == (void *)http_stream &&
-            msg.cmd == AEL_MSG_CMD_REPORT_STATUS &&
-            (int)msg.data == AEL_STATUS_STATE_FINISHED) {
-
-            if (player_status.source == AUDIO_SOURCE_HTTP &&
-                player_status.state == PLAYER_STATE_PLAYING &&
-                strlen(player_status.current_url) > 0 &&
-                !reconnect_in_progress) {
-                ESP_LOGW(TAG, "HTTP stream ended, scheduling reconnect...");
-                reconnect_in_progress = true;
-                xTaskCreate(reconnect_task, "reconnect", 8192,
-                           (void *)player_status.current_url, 5, NULL);
-            }
-        }
-
-        // Zdarzenie zakończenia odtwarzania na I2S (fallback dla HTTP + inne źródła)
-        if (msg.source_type == AUDIO_ELEMENT_TYPE_ELEMENT &&
-            msg.source == (void *)i2s_stream &&
-            msg.cmd == AEL_MSG_CMD_REPORT_STATUS &&
-            (int)msg.data == AEL_STATUS_STATE_FINISHED) {
-
-            if (player_status.source == AUDIO_SOURCE_HTTP &&
-                player_status.state == PLAYER_STATE_PLAYING &&
-                strlen(player_status.current_url) > 0 &&
-                !reconnect_in_progress) {
-                // Fallback - reconnect jeśli HTTP handler nie złapał
-                ESP_LOGW(TAG, "I2S finished, scheduling reconnect...");
-                reconnect_in_progress = true;
-                xTaskCreate(reconnect_task, "reconnect", 8192,
-                           (void *)player_status.current_url, 5, NULL);
-            } else if (player_status.source != AUDIO_SOURCE_HTTP) {
-                ESP_LOGI(TAG, "Playback finished");
-                set_state(PLAYER_STATE_STOPPED);
-            }
-        }
-
-        // Zdarzenie błędu (AEL_STATUS_ERROR_* są w zakresie 1-7)
-        if (msg.source_type == AUDIO_ELEMENT_TYPE_ELEMENT &&
-            msg.cmd == AEL_MSG_CMD_REPORT_STATUS &&
-            (int)msg.data >= AEL_STATUS_ERROR_OPEN &&
-            (int)msg.data <= AEL_STATUS_ERROR_UNKNOWN) {
-
-            ESP_LOGE(TAG, "Playback error: %d", (int)msg.data);
-            set_state(PLAYER_STATE_ERROR);
-        }
-
-        // Obsługa przycisków na płytce
-        if ((msg.source_type == PERIPH_ID_TOUCH || msg.source_type == PERIPH_ID_BUTTON)
-            && (msg.cmd == PERIPH_TOUCH_TAP || msg.cmd == PERIPH_BUTTON_PRESSED)) {
-            if ((int)msg.data == get_input_play_id()) {
-                ESP_LOGI(TAG, "Play/Pause button pressed");
-                if (player_status.state == PLAYER_STATE_PLAYING) {
-                    audio_player_pause();
-                } else {
-                    audio_player_resume();
-                }
-            } else if ((int)msg.data == get_input_volup_id()) {
-                ESP_LOGI(TAG, "Volume Up button pressed");
-                audio_player_set_volume(player_status.volume + 5);
-            } else if ((int)msg.data == get_input_voldown_id()) {
-                ESP_LOGI(TAG, "Volume Down button pressed");
-                audio_player_set_volume(player_status.volume - 5);
-            } else if ((int)msg.data == get_input_set_id()) {
-                ESP_LOGI(TAG, "Set button pressed - next station");
-                xTaskCreate(next_station_task, "next_st", 8192, NULL, 5, NULL);
-            } else if ((int)msg.data == get_input_rec_id()) {
-                ESP_LOGI(TAG, "Rec button pressed - next station");
-                xTaskCreate(next_station_task, "next_st", 8192, NULL, 5, NULL);
-            }
+        ctrl_handle(&cmd);
+
+        // Żądania, które nie zmieściły się w kolejce - wykonaj najnowsze
+        if (uxQueueMessagesWaiting(cmd_queue) == 0) {
+            ctrl_play_request(play_seq);
+            ctrl_volume_request();
+            ctrl_seek_request();
+            ctrl_prime_request();
         }
     }
 }
@@ -298,6 +1750,9 @@ esp_err_t audio_player_init(void)
         return ESP_FAIL;
     }
 
+    request_lock = xSemaphoreCreateMutex();
+    cmd_queue = xQueueCreate(PLAYER_CMD_QUEUE_LEN, sizeof(player_cmd_t));
+
     // Inicjalizacja peryferiów (przyciski, touch)
     esp_periph_config_t periph_cfg = DEFAULT_ESP_PERIPH_SET_CONFIG();
     periph_set = esp_periph_set_init(&periph_cfg);
@@ -320,49 +1775,61 @@ esp_err_t audio_player_init(void)
     esp_periph_handle_t button_periph = periph_button_init(&btn_cfg);
     esp_periph_start(periph_set, button_periph);
 
-    // Konfiguracja HTTP stream
-    // Note: HTTPS z pełnym certificate bundle wymaga zbyt dużo pamięci RAM
-    // Dla strumieniów radiowych używamy HTTP lub HTTPS bez weryfikacji certyfikatu
-    http_stream_cfg_t http_cfg = HTTP_STREAM_CFG_DEFAULT();
-    http_cfg.type = AUDIO_STREAM_READER;
-    http_cfg.enable_playlist_parser = true;
-    http_cfg.task_stack = 8 * 1024;  // Increased stack for better network handling
-    http_cfg.out_rb_size = 256 * 1024;  // 256KB buffer - ~16s at 128kbps (PSRAM)
-    http_cfg.task_prio = 22;  // High priority for HTTP stream
-    http_cfg.task_core = 0;  // Core 0 - together with WiFi for better network I/O
-    // HTTPS: wyłącz weryfikację certyfikatów (oszczędza RAM)
-    http_cfg.crt_bundle_attach = NULL;
-    http_stream = http_stream_init(&http_cfg);
-
-    // Konfiguracja dekodera MP3
-    mp3_decoder_cfg_t mp3_cfg = DEFAULT_MP3_DECODER_CONFIG();
-    mp3_cfg.task_stack = 8 * 1024;
-    mp3_cfg.out_rb_size = 64 * 1024;  // 64KB output buffer (PSRAM)
-    mp3_cfg.task_prio = 22;  // High priority for audio processing
-    mp3_cfg.task_core = 0;   // Core 0 - isolated from WiFi/web on core 0
-    decoder = mp3_decoder_init(&mp3_cfg);
+    // Konfiguracja event interface
+    audio_event_iface_cfg_t evt_cfg = AUDIO_EVENT_IFACE_DEFAULT_CFG();
+    evt = audio_event_iface_init(&evt_cfg);
+    audio_event_iface_set_listener(esp_periph_set_get_event_iface(periph_set), evt);
+
+    // Slot aktywny: http -> mp3/aac -> PCM
+    if (stream_slot_init(&stream_slots[0], 0, HTTP_BUFFER_SIZE_KB, evt, &slot_hooks) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    active_slot = &stream_slots[0];
+    active_slot->active = true;
+
+#if STANDBY_STREAM_ENABLED
+    // Warm standby: drugi slot połączony z następną stacją (budżet PSRAM z config.h)
+    size_t standby_bytes = STANDBY_BUFFER_KB * 1024 + SLOT_PCM_RB_SIZE;
+    if (heap_caps_get_free_size(MALLOC_CAP_SPIRAM) >= standby_bytes + STANDBY_PSRAM_RESERVE &&
+        stream_slot_init(&stream_slots[1], 1, STANDBY_BUFFER_KB, evt, &slot_hooks) == ESP_OK) {
+        standby_slot = &stream_slots[1];
+        ESP_LOGI(TAG, "Warm standby enabled (%d KB HTTP + %d KB PCM)",
+                 STANDBY_BUFFER_KB, SLOT_PCM_RB_SIZE / 1024);
+    } else {
+        stream_slot_deinit(&stream_slots[1]);
+        ESP_LOGW(TAG, "Not enough PSRAM for warm standby, disabled");
+    }
+#endif
 
     // Konfiguracja filtra resampling (44100 -> 48000)
     rsp_filter_cfg_t rsp_cfg = DEFAULT_RESAMPLE_FILTER_CONFIG();
-    rsp_cfg.src_rate = 48000;
+    rsp_cfg.src_rate = 44100;
     rsp_cfg.src_ch = 2;
-    rsp_cfg.dest_rate = 44100;
+    rsp_cfg.dest_rate = 48000;
     rsp_cfg.dest_ch = 2;
     rsp_filter = rsp_filter_init(&rsp_cfg);
 
-    // Inicjalizacja tablicy EQ gain z audio_settings
+    // Inicjalizacja tablicy EQ gain z audio_settings (z balansem L/R)
     audio_settings_t *settings = audio_settings_get();
     for (int i = 0; i < 10; i++) {
         // Konwersja z zakresu 0-24 (gdzie 12=0dB) na dB (-12 do +12)
-        int db = (int)settings->bands[i] - 12;
-        eq_gain[i] = db;       // Left channel
-        eq_gain[i + 10] = db;  // Right channel
+        eq_store_band(i, (int)settings->bands[i] - 12);
     }
 
-    // Equalizer wyłączony - zużywa ~28% CPU
-    // TODO: Zoptymalizować EQ lub użyć sprzętowego DSP
-    equalizer = NULL;
-    ESP_LOGI(TAG, "Equalizer disabled to save CPU");
+    // Equalizer stałoprzecinkowy (eq_filter) zamiast ADF equalizer (~28% CPU)
+    int band_freq[EQ_BANDS];
+    const eq_band_info_t *bands_info = audio_settings_get_all_bands_info();
+    for (int i = 0; i < EQ_BANDS; i++) {
+        band_freq[i] = bands_info[i].frequency;
+    }
+    eq_filter_cfg_t eq_cfg = DEFAULT_EQ_FILTER_CONFIG();
+    eq_cfg.band_freq = band_freq;
+    eq_cfg.set_gain = eq_gain;
+    eq_cfg.task_core = 1;  // Razem z I2S - dekoder MP3 zostaje na core 0
+    equalizer = eq_filter_init(&eq_cfg);
+    if (equalizer == NULL) {
+        ESP_LOGW(TAG, "Equalizer init failed, continuing without EQ");
+    }
 
     // Konfiguracja I2S stream (wyjście audio)
     i2s_stream_cfg_t i2s_cfg = I2S_STREAM_CFG_DEFAULT();
@@ -372,50 +1839,65 @@ esp_err_t audio_player_init(void)
     i2s_cfg.task_core = 1;  // Pin I2S to core 1 (isolated from WiFi on core 0)
     i2s_cfg.stack_in_ext = true;  // Use PSRAM for I2S task stack
     // Bufory DMA - bezpieczna konfiguracja
-    i2s_cfg.chan_cfg.dma_desc_num = 8;     // 8 deskryptorów DMA
-    i2s_cfg.chan_cfg.dma_frame_num = 1024; // 1024 ramki na deskryptor
+    i2s_cfg.chan_cfg.dma_desc_num = OUTPUT_DMA_DESC;
+    i2s_cfg.chan_cfg.dma_frame_num = OUTPUT_DMA_FRAMES;
     i2s_stream = i2s_stream_init(&i2s_cfg);
 
-    // Tworzenie pipeline
+    // Etap wyjściowy - działa stale, źródło wybiera output_read_cb
     audio_pipeline_cfg_t pipeline_cfg = DEFAULT_AUDIO_PIPELINE_CONFIG();
-    pipeline_cfg.rb_size = 128 * 1024;  // 128KB ringbuffer between elements (PSRAM)
-    pipeline = audio_pipeline_init(&pipeline_cfg);
-    if (pipeline == NULL) {
+    // Mały bufor do I2S - zapas PCM trzyma slot źródła, więc przełączenie nie czeka
+    // na odegranie starej stacji
+    pipeline_cfg.rb_size = 8 * 1024;
+    output_pipeline = audio_pipeline_init(&pipeline_cfg);
+    if (output_pipeline == NULL) {
         ESP_LOGE(TAG, "Failed to create pipeline");
         return ESP_FAIL;
     }
 
     // Rejestracja elementów
-    audio_pipeline_register(pipeline, http_stream, "http");
-    audio_pipeline_register(pipeline, decoder, "mp3");
-    audio_pipeline_register(pipeline, rsp_filter, "filter");
+    audio_pipeline_register(output_pipeline, rsp_filter, "filter");
     if (equalizer) {
-        audio_pipeline_register(pipeline, equalizer, "eq");
+        audio_pipeline_register(output_pipeline, equalizer, "eq");
     }
-    audio_pipeline_register(pipeline, i2s_stream, "i2s");
+    audio_pipeline_register(output_pipeline, i2s_stream, "i2s");
 
-    // Łączenie elementów: http -> mp3 -> eq -> i2s (bez resamplera - oszczędność CPU)
+    // Łączenie elementów: [slot PCM] -> eq -> i2s (bez resamplera - oszczędność CPU)
     if (equalizer) {
-        const char *link_tag[4] = {"http", "mp3", "eq", "i2s"};
-        audio_pipeline_link(pipeline, &link_tag[0], 4);
-        ESP_LOGI(TAG, "Pipeline: http -> mp3 -> eq -> i2s");
+        const char *link_tag[2] = {"eq", "i2s"};
+        audio_pipeline_link(output_pipeline, &link_tag[0], 2);
+        audio_element_set_read_cb(equalizer, output_read_cb, NULL);
+        // Wyjście EQ przez callback - rozgałęzienie na głośnik Bluetooth
+        audio_element_set_write_cb(equalizer, output_write_cb, NULL);
+        // Brak danych z EQ - I2S wypełnia DMA ciszą zamiast czekać bez końca
+        audio_element_set_input_timeout(i2s_stream, pdMS_TO_TICKS(OUTPUT_IDLE_WAIT_MS));
+        ESP_LOGI(TAG, "Pipeline: http -> mp3/aac -> eq -> i2s");
     } else {
-        const char *link_tag[3] = {"http", "mp3", "i2s"};
-        audio_pipeline_link(pipeline, &link_tag[0], 3);
-        ESP_LOGI(TAG, "Pipeline: http -> mp3 -> i2s (no equalizer)");
+        const char *link_tag[1] = {"i2s"};
+        audio_pipeline_link(output_pipeline, &link_tag[0], 1);
+        audio_element_set_read_cb(i2s_stream, output_read_cb, NULL);
+        ESP_LOGI(TAG, "Pipeline: http -> mp3/aac -> i2s (no equalizer)");
     }
+    audio_pipeline_set_listener(output_pipeline, evt);
 
-    // Konfiguracja event interface
-    audio_event_iface_cfg_t evt_cfg = AUDIO_EVENT_IFACE_DEFAULT_CFG();
-    evt = audio_event_iface_init(&evt_cfg);
-    audio_pipeline_set_listener(pipeline, evt);
-    audio_event_iface_set_listener(esp_periph_set_get_event_iface(periph_set), evt);
+    // Balans jest realizowany przez wzmocnienia L/R w EQ - zastosuj zapisany
+    if (equalizer && settings->balance != 0) {
+        audio_settings_set_balance(settings->balance);
+    }
 
     // Wczytaj zapisaną głośność z NVS
-    player_status.volume = audio_settings_get_volume();
-    ESP_LOGI(TAG, "Loaded saved volume: %d", player_status.volume);
+    player_status_set_volume(audio_settings_get_volume());
+    ESP_LOGI(TAG, "Loaded saved volume: %d", player_status->volume);
     // Ustaw głośność na kodeku
-    audio_hal_set_volume(board_handle->audio_hal, player_status.volume);
+    audio_hal_set_volume(board_handle->audio_hal, player_status->volume);
+
+    apply_output_format(44100, 2, 16);
+    output_select_slot(active_slot);
+    audio_pipeline_run(output_pipeline);
+
+    requested_volume = player_status->volume;
+
+    // Task sterujący - jedyny wykonawca komend odtwarzacza
+    xTaskCreate(player_ctrl_task, "player_ctrl", 8192, NULL, 10, &ctrl_task_handle);
 
     // Uruchom task obsługi zdarzeń
     xTaskCreate(audio_event_task, "audio_event", 4096, NULL, 15, &event_task_handle);  // Increased priority
@@ -431,24 +1913,48 @@ esp_err_t audio_player_deinit(void)
         event_task_handle = NULL;
     }
 
-    audio_pipeline_stop(pipeline);
-    audio_pipeline_wait_for_stop(pipeline);
-    audio_pipeline_terminate(pipeline);
+    if (ctrl_task_handle) {
+        vTaskDelete(ctrl_task_handle);
+        ctrl_task_handle = NULL;
+    }
+    if (cmd_queue) {
+        vQueueDelete(cmd_queue);
+        cmd_queue = NULL;
+    }
+
+    if (prebuffer_timer) {
+        xTimerStop(prebuffer_timer, 0);
+    }
+
+    for (int i = 0; i < STREAM_SLOT_COUNT; i++) {
+        stream_slot_deinit(&stream_slots[i]);
+    }
+    standby_slot = NULL;
+    sd_source_deinit();
+    aux_input_capture_deinit();
+    output_rb = NULL;
+
+    audio_pipeline_stop(output_pipeline);
+    audio_pipeline_wait_for_stop(output_pipeline);
+    audio_pipeline_terminate(output_pipeline);
 
-    audio_pipeline_unregister(pipeline, http_stream);
-    audio_pipeline_unregister(pipeline, decoder);
-    audio_pipeline_unregister(pipeline, rsp_filter);
-    audio_pipeline_unregister(pipeline, i2s_stream);
+    audio_pipeline_unregister(output_pipeline, rsp_filter);
+    if (equalizer) {
+        audio_pipeline_unregister(output_pipeline, equalizer);
+    }
+    audio_pipeline_unregister(output_pipeline, i2s_stream);
 
-    audio_pipeline_remove_listener(pipeline);
+    audio_pipeline_remove_listener(output_pipeline);
     esp_periph_set_stop_all(periph_set);
     audio_event_iface_remove_listener(esp_periph_set_get_event_iface(periph_set), evt);
     audio_event_iface_destroy(evt);
 
-    audio_pipeline_deinit(pipeline);
-    audio_element_deinit(http_stream);
-    audio_element_deinit(decoder);
+    audio_pipeline_deinit(output_pipeline);
     audio_element_deinit(rsp_filter);
+    if (equalizer) {
+        audio_element_deinit(equalizer);
+        equalizer = NULL;
+    }
     audio_element_deinit(i2s_stream);
     esp_periph_set_destroy(periph_set);
 
@@ -462,203 +1968,251 @@ esp_err_t audio_player_play_url(const char *url)
         return ESP_ERR_INVALID_ARG;
     }
 
-    if (pipeline == NULL) {
+    if (output_pipeline == NULL) {
         ESP_LOGE(TAG, "Pipeline not initialized!");
         return ESP_ERR_INVALID_STATE;
     }
 
-    ESP_LOGI(TAG, "Playing URL: %s", url);
+    // Nowsze żądanie zastępuje wszystkie wcześniejsze jeszcze nie wykonane
+    xSemaphoreTake(request_lock, portMAX_DELAY);
+    strncpy(requested_url, url, sizeof(requested_url) - 1);
+    requested_source = AUDIO_SOURCE_HTTP;
+    uint32_t seq = ++play_seq;
+    xSemaphoreGive(request_lock);
 
-    // Zatrzymaj obecne odtwarzanie
-    ESP_LOGI(TAG, "Stopping current playback...");
-    audio_pipeline_stop(pipeline);
-    audio_pipeline_wait_for_stop(pipeline);
+    post_cmd(PLAYER_CMD_PLAY, -1, 0, seq);
+    return ESP_OK;
+}
 
-    // Ustaw nowy URL
-    ESP_LOGI(TAG, "Setting URL on http_stream...");
-    audio_element_set_uri(http_stream, url);
-    strncpy(player_status.current_url, url, sizeof(player_status.current_url) - 1);
+esp_err_t audio_player_play_sdcard(const char *filepath)
+{
+    return audio_player_play_sdcard_from(filepath, 0);
+}
 
-    // Reset pipeline
-    ESP_LOGI(TAG, "Resetting pipeline...");
-    audio_pipeline_reset_ringbuffer(pipeline);
-    audio_pipeline_reset_elements(pipeline);
+esp_err_t audio_player_play_sdcard_from(const char *filepath, uint32_t position_ms)
+{
+    if (filepath == NULL || strlen(filepath) == 0) {
+        ESP_LOGE(TAG, "Invalid file path (null or empty)");
+        return ESP_ERR_INVALID_ARG;
+    }
 
-    // Uruchom pipeline z pre-bufferingiem
-    ESP_LOGI(TAG, "Starting pipeline with prebuffering...");
+    if (output_pipeline == NULL) {
+        ESP_LOGE(TAG, "Pipeline not initialized!");
+        return ESP_ERR_INVALID_STATE;
+    }
 
-    esp_err_t ret = audio_pipeline_run(pipeline);
-    
-    // Pause I2S immediately after pipeline starts - buffer will fill
-    if (ret == ESP_OK) {
-        audio_element_pause(i2s_stream);
-        ESP_LOGI(TAG, "I2S paused, filling buffer...");
+    // Ścieżka względna względem karty (np. "alarms/beep.mp3" lub "/music/a.flac")
+    char path[sizeof(sd_source->path)];
+    if (strncmp(filepath, SD_MOUNT_POINT "/", strlen(SD_MOUNT_POINT) + 1) == 0) {
+        snprintf(path, sizeof(path), "%s", filepath);
+    } else {
+        snprintf(path, sizeof(path), "%s%s%s", SD_MOUNT_POINT, filepath[0] == '/' ? "" : "/", filepath);
     }
-    if (ret == ESP_OK) {
-        ESP_LOGI(TAG, "Pipeline started, monitoring buffer...");
-        player_status.source = AUDIO_SOURCE_HTTP;
-        set_state(PLAYER_STATE_BUFFERING);  // Start as buffering, timer will switch to playing
 
-        // Zapisz URL dla autostartu
-        audio_settings_set_last_url(url);
+    xSemaphoreTake(request_lock, portMAX_DELAY);
+    strncpy(requested_url, path, sizeof(requested_url) - 1);
+    requested_source = AUDIO_SOURCE_SDCARD;
+    requested_start_ms = position_ms;
+    uint32_t seq = ++play_seq;
+    xSemaphoreGive(request_lock);
 
-        // Create prebuffer timer if not exists
-        if (prebuffer_timer == NULL) {
-            prebuffer_timer = xTimerCreate("prebuf", pdMS_TO_TICKS(PREBUFFER_CHECK_MS),
-                                           pdTRUE, NULL, prebuffer_timer_callback);
-        }
+    post_cmd(PLAYER_CMD_PLAY, -1, 0, seq);
+    return ESP_OK;
+}
 
-        // Reset and start buffer monitoring
-        prebuffer_counter = 0;
-        current_buffer_percent = 0;
-        xTimerStart(prebuffer_timer, 0);
-    } else {
-        ESP_LOGE(TAG, "Failed to start pipeline: %s", esp_err_to_name(ret));
-    }
+esp_err_t audio_player_stop(void)
+{
+    return post_cmd(PLAYER_CMD_STOP, -1, 0, 0);
+}
 
-    return ret;
+esp_err_t audio_player_pause(void)
+{
+    return post_cmd(PLAYER_CMD_PAUSE, -1, 0, 0);
 }
 
-esp_err_t audio_player_play_sdcard(const char *filepath)
+esp_err_t audio_player_resume(void)
 {
-    // TODO: Implementacja odtwarzania z karty SD
-    ESP_LOGW(TAG, "SD card playback not implemented yet");
-    return ESP_ERR_NOT_SUPPORTED;
+    return post_cmd(PLAYER_CMD_RESUME, -1, 0, 0);
 }
 
-esp_err_t audio_player_stop(void)
+esp_err_t audio_player_play_next_station(void)
 {
-    ESP_LOGI(TAG, "Stopping playback");
+    if (output_pipeline == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
 
-    esp_err_t ret = audio_pipeline_stop(pipeline);
-    audio_pipeline_wait_for_stop(pipeline);
+    // Liczone od ostatniego żądania - pięć szybkich wciśnięć to piąta stacja
+    xSemaphoreTake(request_lock, portMAX_DELAY);
+    const char *name = NULL;
+    const char *url = next_station_url(requested_url, &name);  // Pusty lub plik - pierwsza stacja
+    uint32_t seq = 0;
+    if (url) {
+        strncpy(requested_url, url, sizeof(requested_url) - 1);
+        requested_source = AUDIO_SOURCE_HTTP;
+        seq = ++play_seq;
+    }
+    xSemaphoreGive(request_lock);
 
-    if (ret == ESP_OK) {
-        set_state(PLAYER_STATE_STOPPED);
+    if (url == NULL) {
+        ESP_LOGW(TAG, "No stations available");
+        return ESP_ERR_NOT_FOUND;
     }
 
-    return ret;
+    ESP_LOGI(TAG, "Next station requested: %s", name);
+    post_cmd(PLAYER_CMD_PLAY, -1, 0, seq);
+    return ESP_OK;
 }
 
-esp_err_t audio_player_pause(void)
+// Zapisuje najnowszą głośność; komenda trafia do kolejki tylko jeśli żadna nie czeka
+static void request_volume_locked(int volume)
 {
-    ESP_LOGI(TAG, "Pausing playback");
+    if (volume < MIN_VOLUME) volume = MIN_VOLUME;
+    if (volume > MAX_VOLUME) volume = MAX_VOLUME;
 
-    esp_err_t ret = audio_pipeline_pause(pipeline);
-    if (ret == ESP_OK) {
-        set_state(PLAYER_STATE_PAUSED);
-    }
+    requested_volume = volume;
+    bool queued = volume_queued;
+    volume_queued = true;
+    xSemaphoreGive(request_lock);
 
-    return ret;
+    if (!queued) {
+        post_cmd(PLAYER_CMD_VOLUME, -1, 0, 0);
+    }
 }
 
-esp_err_t audio_player_resume(void)
+static void request_volume_step(int delta)
 {
-    ESP_LOGI(TAG, "Resuming playback");
+    xSemaphoreTake(request_lock, portMAX_DELAY);
+    request_volume_locked(requested_volume + delta);
+}
 
-    esp_err_t ret = audio_pipeline_resume(pipeline);
-    if (ret == ESP_OK) {
-        set_state(PLAYER_STATE_PLAYING);
+esp_err_t audio_player_set_volume(int volume)
+{
+    if (request_lock == NULL) {
+        return ESP_ERR_INVALID_STATE;
     }
 
-    return ret;
+    xSemaphoreTake(request_lock, portMAX_DELAY);
+    request_volume_locked(volume);
+    return ESP_OK;
 }
 
-esp_err_t audio_player_play_next_station(void)
+int audio_player_get_volume(void)
 {
-    uint8_t count = 0;
-    radio_station_t *stations = radio_stations_get_all(&count);
+    return requested_volume;  // Także jeszcze nie zastosowana
+}
 
-    if (stations == NULL || count == 0) {
-        ESP_LOGW(TAG, "No stations available");
-        return ESP_ERR_NOT_FOUND;
+esp_err_t audio_player_seek_sdcard(uint32_t position_ms)
+{
+    if (request_lock == NULL || player_status->source != AUDIO_SOURCE_SDCARD) {
+        return ESP_ERR_INVALID_STATE;
     }
-
-    // Find current station index
-    int current_index = -1;
-    for (int i = 0; i < count; i++) {
-        if (strcmp(stations[i].url, player_status.current_url) == 0) {
-            current_index = i;
-            break;
-        }
+    esp_codec_type_t codec = sd_source->codec;
+    if (codec != ESP_CODEC_TYPE_MP3 && codec != ESP_CODEC_TYPE_FLAC && codec != ESP_CODEC_TYPE_WAV) {
+        return ESP_ERR_NOT_SUPPORTED;
     }
 
-    // Calculate next index (wrap around)
-    int next_index = (current_index + 1) % count;
+    xSemaphoreTake(request_lock, portMAX_DELAY);
+    requested_seek_ms = position_ms;
+    bool queued = seek_queued;
+    seek_queued = true;
+    xSemaphoreGive(request_lock);
 
-    ESP_LOGI(TAG, "Playing next station: %s", stations[next_index].name);
-    return audio_player_play_url(stations[next_index].url);
+    if (!queued) {
+        post_cmd(PLAYER_CMD_SD_SEEK, -1, 0, 0);
+    }
+    return ESP_OK;
 }
 
-// Timer do debounce aktualizacji głośności kodeka
-static TimerHandle_t volume_timer = NULL;
-static int pending_volume = -1;
-
-static void volume_timer_callback(TimerHandle_t xTimer)
+esp_err_t audio_player_queue_next_sdcard(const char *filepath)
 {
-    if (pending_volume >= 0 && board_handle) {
-        audio_hal_set_volume(board_handle->audio_hal, pending_volume);
-        pending_volume = -1;
+    if (request_lock == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(request_lock, portMAX_DELAY);
+    strncpy(requested_next, filepath ? filepath : "", sizeof(requested_next) - 1);
+    bool queued = next_queued;
+    next_queued = true;
+    xSemaphoreGive(request_lock);
+
+    if (!queued) {
+        post_cmd(PLAYER_CMD_SD_PRIME, -1, 0, 0);
     }
+    return ESP_OK;
 }
 
-esp_err_t audio_player_set_volume(int volume)
+uint32_t audio_player_get_position_ms(void)
 {
-    // Ogranicz zakres
-    if (volume < MIN_VOLUME) volume = MIN_VOLUME;
-    if (volume > MAX_VOLUME) volume = MAX_VOLUME;
-
-    player_status.volume = volume;
+    if (player_status->source == AUDIO_SOURCE_BLUETOOTH) {
+        player_status_t status;
+        audio_player_get_status(&status);
+        return audio_player_status_position_ms(&status);
+    }
+    if (player_status->source != AUDIO_SOURCE_SDCARD || sd_source->pcm_rb == NULL) {
+        return 0;
+    }
+    return sd_source_position_ms();
+}
 
-    // Zapisz głośność do NVS (już debounced w audio_settings)
-    audio_settings_set_volume(volume);
+esp_err_t audio_player_mute(bool mute)
+{
+    return post_cmd(PLAYER_CMD_MUTE, -1, mute, 0);
+}
 
-    // Debounce aktualizacji kodeka - zapobiegaj mikro-przerwom przy przesuwaniu suwaka
-    if (!player_status.muted && board_handle) {
-        pending_volume = volume;
+esp_err_t audio_player_play_bluetooth(int sample_rate, int channels)
+{
+    if (sample_rate <= 0 || channels < 1 || channels > 2) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return post_cmd(PLAYER_CMD_BT_START, -1, sample_rate, channels);
+}
 
-        // Utwórz timer jeśli nie istnieje
-        if (volume_timer == NULL) {
-            volume_timer = xTimerCreate("vol_timer", pdMS_TO_TICKS(50), pdFALSE, NULL, volume_timer_callback);
-        }
+esp_err_t audio_player_stop_bluetooth(void)
+{
+    return post_cmd(PLAYER_CMD_BT_STOP, -1, 0, 0);
+}
 
-        // Reset timer - aktualizacja kodeka nastąpi 50ms po ostatniej zmianie
-        if (volume_timer) {
-            xTimerReset(volume_timer, 0);
-        }
-    }
+esp_err_t audio_player_bt_track_changed(void)
+{
+    return post_cmd(PLAYER_CMD_BT_TRACK, -1, 0, 0);
+}
 
-    notify_state_change();
+esp_err_t audio_player_aux_capture(bool enable)
+{
+    return post_cmd(PLAYER_CMD_AUX_CAPTURE, -1, enable, 0);
+}
 
-    return ESP_OK;
+esp_err_t audio_player_play_aux(void)
+{
+    return post_cmd(PLAYER_CMD_AUX_START, -1, 0, 0);
 }
 
-int audio_player_get_volume(void)
+esp_err_t audio_player_stop_aux(void)
 {
-    return player_status.volume;
+    return post_cmd(PLAYER_CMD_AUX_STOP, -1, 0, 0);
 }
 
-esp_err_t audio_player_mute(bool mute)
+int audio_player_get_output_delay_ms(void)
 {
-    player_status.muted = mute;
+    if (i2s_stream == NULL || output_rate <= 0 || output_channels <= 0) return 0;
 
-    if (board_handle) {
-        if (mute) {
-            audio_hal_set_volume(board_handle->audio_hal, 0);
-        } else {
-            audio_hal_set_volume(board_handle->audio_hal, player_status.volume);
-        }
+    int ms = OUTPUT_DMA_DESC * OUTPUT_DMA_FRAMES * 1000 / output_rate;
+    ringbuf_handle_t rb = audio_element_get_input_ringbuf(i2s_stream);
+    if (rb) {
+        ms += (int)((int64_t)rb_bytes_filled(rb) * 1000 / (output_rate * output_channels * 2));
     }
+    return ms;
+}
 
-    ESP_LOGI(TAG, "Mute: %s", mute ? "ON" : "OFF");
-    notify_state_change();
-
-    return ESP_OK;
+void audio_player_get_status(player_status_t *status)
+{
+    if (status == NULL) return;
+    player_status_get(status);
 }
 
-player_status_t *audio_player_get_status(void)
+player_state_t audio_player_get_state(void)
 {
-    return &player_status;
+    return player_status->state;  // Jedno słowo - odczyt zawsze spójny
 }
 
 void audio_player_register_callback(player_state_callback_t callback)
@@ -666,6 +2220,23 @@ void audio_player_register_callback(player_state_callback_t callback)
     state_callback = callback;
 }
 
+void audio_player_register_track_end_callback(player_track_end_callback_t callback)
+{
+    track_end_callback = callback;
+}
+
+void audio_player_register_track_next_callback(player_track_next_callback_t callback)
+{
+    track_next_callback = callback;
+}
+
+void audio_player_get_sd_stats(player_sd_stats_t *stats)
+{
+    if (stats == NULL) return;
+
+    sd_source_get_stats(stats);
+}
+
 // ============================================
 // Equalizer Control
 // ============================================
@@ -684,11 +2255,10 @@ esp_err_t audio_player_set_eq_band(int band, int gain_db)
     }
 
     // Update local array
-    eq_gain[band] = gain_db;       // Left channel
-    eq_gain[band + 10] = gain_db;  // Right channel
+    eq_store_band(band, gain_db);
 
-    // Apply to equalizer (true = same gain for both channels)
-    esp_err_t ret = equalizer_set_gain_info(equalizer, band, gain_db, true);
+    // Apply to equalizer (false = kanały osobno, z przesunięciem balansu)
+    esp_err_t ret = eq_filter_set_all_gains(equalizer, eq_gain, false);
     if (ret == ESP_OK) {
         ESP_LOGI(TAG, "EQ band %d set to %+d dB", band, gain_db);
     }
@@ -707,11 +2277,12 @@ esp_err_t audio_player_set_eq_all_bands(const int *gains_db)
         if (db < -13) db = -13;
         if (db > 13) db = 13;
 
-        eq_gain[i] = db;
-        eq_gain[i + 10] = db;
-        equalizer_set_gain_info(equalizer, i, db, true);
+        eq_store_band(i, db);
     }
 
+    // Jedno przeliczenie współczynników dla wszystkich pasm i obu kanałów
+    eq_filter_set_all_gains(equalizer, eq_gain, false);
+
     ESP_LOGI(TAG, "All EQ bands updated");
     return ESP_OK;
 }
@@ -720,3 +2291,35 @@ audio_element_handle_t audio_player_get_equalizer(void)
 {
     return equalizer;
 }
+
+// ============================================
+// Output Selection
+// ============================================
+
+esp_err_t audio_player_set_output(player_output_t output)
+{
+    if (output < PLAYER_OUTPUT_I2S || output > PLAYER_OUTPUT_BOTH) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (output != output_mode) {
+        ESP_LOGI(TAG, "Output: %s", audio_player_output_to_str(output));
+        bt_flush = true;
+        output_mode = output;
+    }
+    return ESP_OK;
+}
+
+player_output_t audio_player_get_output(void)
+{
+    return output_mode;
+}
+
+const char *audio_player_output_to_str(player_output_t output)
+{
+    switch (output) {
+        case PLAYER_OUTPUT_I2S:  return "i2s";
+        case PLAYER_OUTPUT_BT:   return "bt";
+        case PLAYER_OUTPUT_BOTH: return "both";
+        default:                 return "unknown";
+    }
+}
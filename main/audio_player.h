@@ -24,6 +24,13 @@ typedef enum {
     PLAYER_STATE_ERROR,
 } player_state_t;
 
+// Wyjście audio: kodek ES8388 (I2S), głośnik Bluetooth (A2DP source) lub oba naraz
+typedef enum {
+    PLAYER_OUTPUT_I2S = 0,
+    PLAYER_OUTPUT_BT,
+    PLAYER_OUTPUT_BOTH,
+} player_output_t;
+
 // Struktura stanu odtwarzacza
 typedef struct {
     player_state_t state;
@@ -33,10 +40,94 @@ typedef struct {
     char current_url[512];
     char current_title[128];
     char current_artist[128];
+    char current_album[128];
+    uint32_t duration_ms;       // 0 - nieznana (radio)
+    uint32_t position_ms;       // Pozycja w chwili position_at_ms
+    uint32_t position_at_ms;    // Czas pracy (tick w ms), od którego pozycja biegnie; 0 - stoi
 } player_status_t;
 
-// Callback dla zmiany stanu
-typedef void (*player_state_callback_t)(player_status_t *status);
+// Statystyki bufora strumienia (diagnostyka)
+typedef struct {
+    int bitrate_kbps;           // Zmierzony bitrate strumienia
+    int buffered_ms;            // Audio czekające w pipeline
+    int target_ms;              // Cel prebufora dla bieżącej stacji
+    int underruns;              // Historia underrun bieżącej stacji
+    uint32_t prebuffer_ms;      // Ostatni czas od startu/rebuforowania do dźwięku
+    uint32_t reconnects;        // Połączenia odnowione bez zatrzymania odtwarzania
+    uint32_t reconnects_audible;    // ...w tym dłuższe niż zapas w buforze
+    uint32_t reconnect_last_gap_ms; // Przerwa w danych przy ostatnim odnowieniu
+    uint32_t reconnect_max_gap_ms;
+    float drift_ppm;            // Korekta dryfu zegara serwera względem I2S
+    bool drift_locked;          // Punkt pracy ustalony - korekta aktywna
+    int drift_setpoint_ms;      // Poziom bufora utrzymywany przez korektę
+    int drift_level_ms;         // Uśredniony poziom bufora
+} player_buffer_stats_t;
+
+// Statystyki przełączania stacji i warm standby (diagnostyka)
+typedef struct {
+    uint32_t last_ms;           // Ostatnie przełączenie: od wywołania do pierwszych próbek
+    bool last_warm;             // Ostatnie przełączenie z warm standby
+    uint32_t standby_hits;      // Przełączenia obsłużone przez standby
+    uint32_t standby_misses;    // Zimne starty mimo włączonego standby
+    bool standby_enabled;       // false - wyłączony w config.h lub brak PSRAM
+    int standby_budget_kb;      // Bufor HTTP slotu standby
+    bool standby_ready;         // Standby połączony i gotowy do przełączenia
+    int standby_buffered_ms;    // Audio czekające w standby
+    const char *standby_url;    // Stacja w standby ("" jeśli brak)
+} player_switch_stats_t;
+
+// Pola statusu zmienione od poprzedniego powiadomienia (maska w callbacku)
+#define PLAYER_STATUS_STATE     (1 << 0)
+#define PLAYER_STATUS_SOURCE    (1 << 1)
+#define PLAYER_STATUS_VOLUME    (1 << 2)
+#define PLAYER_STATUS_MUTED     (1 << 3)
+#define PLAYER_STATUS_URL       (1 << 4)
+#define PLAYER_STATUS_TITLE     (1 << 5)
+#define PLAYER_STATUS_ARTIST    (1 << 6)
+#define PLAYER_STATUS_ALBUM     (1 << 7)
+#define PLAYER_STATUS_POSITION  (1 << 8)    // Długość, skok pozycji lub start/stop jej zegara
+
+// Statystyki sesji od resetu (testy długotrwałe: porównanie zmian buforowania)
+typedef struct {
+    uint32_t since_ms;              // Czas od resetu
+    uint32_t starts;                // Starty stacji zakończone dźwiękiem
+    uint32_t first_audio_last_ms;   // Od żądania do pierwszych próbek na wyjściu
+    uint32_t first_audio_avg_ms;
+    uint32_t first_audio_max_ms;
+    uint32_t underruns;             // Wszystkie stacje
+    uint32_t rebuffer_ms;           // Cisza z rebuforowania po underrun (suma)
+    uint32_t rebuffer_max_ms;
+    uint32_t reconnects;            // Połączenia odnowione w miejscu
+    uint32_t reconnect_max_gap_ms;
+    uint32_t min_free_internal;     // Najmniej wolnej pamięci w sesji (próbki co 100ms)
+    uint32_t min_free_psram;
+} player_session_stats_t;
+
+// Odtwarzanie z karty SD - czy tor plikowy nadąża za I2S (aktualizowane co sekundę)
+typedef struct {
+    bool active;                    // Źródło SD gra
+    const char *codec;              // Format bieżącego pliku ("" jeśli nieaktywne)
+    int read_block_kb;              // Rozmiar bloku odczytu z karty
+    uint32_t read_kbps;             // Przepustowość karty w czasie odczytu (kB/s)
+    uint32_t read_busy_permille;    // Udział czasu spędzonego na odczycie z karty
+    uint32_t decode_permille;       // Obciążenie CPU przez dekoder
+    uint32_t consume_kbps;          // Dane pobierane przez dekoder (kB/s)
+    int buffered_ms;                // PCM czekający przed etapem wyjściowym
+    uint32_t seeks;                 // Przewinięcia od startu
+    uint32_t last_seek_ms;          // Od żądania do dźwięku z nowej pozycji
+    uint32_t max_seek_ms;
+    uint32_t gapless;               // Przejścia do następnego pliku bez przerwy
+} player_sd_stats_t;
+
+// Callback dla zmiany stanu - spójna kopia statusu i maska zmienionych pól
+typedef void (*player_state_callback_t)(const player_status_t *status, uint32_t changed);
+
+// Plik z karty SD odegrany do końca (pełna ścieżka) - wywoływany z taska sterującego
+typedef void (*player_track_end_callback_t)(const char *path);
+
+// Odtwarzanie przeszło bez przerwy na plik z audio_player_queue_next_sdcard() (pełna
+// ścieżka) - wywoływany z taska sterującego
+typedef void (*player_track_next_callback_t)(const char *path);
 
 // Inicjalizacja i deinicjalizacja
 esp_err_t audio_player_init(void);
@@ -45,26 +136,70 @@ esp_err_t audio_player_deinit(void);
 // Sterowanie odtwarzaniem
 esp_err_t audio_player_play_url(const char *url);
 esp_err_t audio_player_play_sdcard(const char *filepath);
+esp_err_t audio_player_play_sdcard_from(const char *filepath, uint32_t position_ms);  // MP3/FLAC/WAV
 esp_err_t audio_player_play_next_station(void);  // Play next station from list
 esp_err_t audio_player_stop(void);
 esp_err_t audio_player_pause(void);
 esp_err_t audio_player_resume(void);
 
+// Przewijanie pliku SD (MP3, FLAC, WAV; kolejne żądania łączą się w najnowsze).
+// ESP_ERR_NOT_SUPPORTED - format bez przewijania (AAC/M4A)
+esp_err_t audio_player_seek_sdcard(uint32_t position_ms);
+uint32_t audio_player_get_position_ms(void);  // Pozycja pliku SD lub utworu z telefonu (0 dla radia)
+
+// Pozycja z kopii statusu liczona lokalnie od position_at_ms (bez odpytywania źródła)
+uint32_t audio_player_status_position_ms(const player_status_t *status);
+
+// Następny plik SD otwierany w tle i dekodowany od razu po bieżącym, bez przerwy;
+// opóźnienie i dopełnienie kodera (LAME/iTunSMPB) są przycinane. NULL - brak następnego.
+// Nowe odtwarzanie (audio_player_play_sdcard) unieważnia przygotowany plik.
+esp_err_t audio_player_queue_next_sdcard(const char *filepath);
+
+// Odbiornik Bluetooth (A2DP sink) - wołane przez bluetooth_sink przy starcie i końcu
+// strumienia z telefonu. PCM pobiera etap wyjściowy przez bluetooth_sink_read_pcm().
+esp_err_t audio_player_play_bluetooth(int sample_rate, int channels);
+esp_err_t audio_player_stop_bluetooth(void);
+// Metadane lub pozycja AVRCP zmienione - status odtwarzacza odświeżany przy źródle BLUETOOTH
+esp_err_t audio_player_bt_track_changed(void);
+
+// Wejście AUX (ADC kodeka): czytnik I2S włącza i wyłącza aux_input razem z wejściem,
+// odtwarzanie - użytkownik lub automatyczne przełączanie po wykryciu sygnału.
+// audio_player_stop_aux() działa tylko, gdy źródłem jest AUX.
+esp_err_t audio_player_aux_capture(bool enable);
+esp_err_t audio_player_play_aux(void);
+esp_err_t audio_player_stop_aux(void);
+
 // Sterowanie głośnością
 esp_err_t audio_player_set_volume(int volume);
 int audio_player_get_volume(void);
 esp_err_t audio_player_mute(bool mute);
 
-// Stan odtwarzacza
-player_status_t *audio_player_get_status(void);
+// Stan odtwarzacza - spójna kopia bez blokowania piszących (seqlock)
+void audio_player_get_status(player_status_t *status);
+player_state_t audio_player_get_state(void);
 void audio_player_register_callback(player_state_callback_t callback);
+void audio_player_register_track_end_callback(player_track_end_callback_t callback);
+void audio_player_register_track_next_callback(player_track_next_callback_t callback);
 
 // Buffer monitoring
 int audio_player_get_buffer_level(void);  // Returns 0-100%
+int audio_player_get_output_delay_ms(void);  // PCM przed I2S + bufory DMA
+void audio_player_get_buffer_stats(player_buffer_stats_t *stats);
+void audio_player_get_switch_stats(player_switch_stats_t *stats);
+void audio_player_get_session_stats(player_session_stats_t *stats);
+void audio_player_reset_session_stats(void);
+void audio_player_get_sd_stats(player_sd_stats_t *stats);
 
 // Equalizer control
 esp_err_t audio_player_set_eq_band(int band, int gain_db);
 esp_err_t audio_player_set_eq_all_bands(const int *gains_db);
 audio_element_handle_t audio_player_get_equalizer(void);
 
+// Wybór wyjścia w locie - dekodowanie i etap wyjściowy działają dalej. PCM za EQ trafia
+// do bufora A2DP (44.1 kHz stereo, inne częstotliwości przez resampler). Dopóki głośnik BT
+// nie odbiera strumienia, gra kodek. Przepływ i underruny: element "bt" w pipeline_stats.
+esp_err_t audio_player_set_output(player_output_t output);
+player_output_t audio_player_get_output(void);
+const char *audio_player_output_to_str(player_output_t output);
+
 #endif // AUDIO_PLAYER_H
@@ -14,7 +14,7 @@
 
 #include "audio_settings.h"
 #include "audio_player.h"
-#include "equalizer.h"
+#include "eq_filter.h"
 #include "config.h"
 
 static const char *TAG = "AUDIO_SET";
@@ -97,8 +97,9 @@ static nvs_handle_t audio_nvs_handle;
 // Audio board handle
 static audio_board_handle_t board_handle = NULL;
 
-// Forward declaration
+// Forward declarations
 static esp_err_t audio_settings_save_internal(void);
+static esp_err_t apply_balance_to_codec(void);
 
 // Timer callback - performs actual save after debounce period
 static void save_timer_callback(TimerHandle_t xTimer)
@@ -135,7 +136,7 @@ static esp_err_t apply_eq_to_codec(void)
         ESP_LOGI(TAG, "  %5s Hz: %+3d dB", band_info[i].label, gains_db[i]);
     }
 
-    // Apply to audio pipeline equalizer
+    // Apply to audio pipeline equalizer (odtwarzacz dokłada przesunięcie balansu L/R)
     esp_err_t ret = audio_player_set_eq_all_bands(gains_db);
     if (ret != ESP_OK) {
         ESP_LOGW(TAG, "Could not apply EQ to pipeline (equalizer may not be ready)");
@@ -149,46 +150,22 @@ static esp_err_t apply_balance_to_codec(void)
     // Balance is implemented by adjusting L/R channel gains in equalizer
     // Balance -100 = full left, 0 = center, +100 = full right
 
-    // Calculate attenuation for each channel (0 to -12 dB)
-    int left_atten = 0;   // dB attenuation for left
-    int right_atten = 0;  // dB attenuation for right
-
-    if (settings.balance < 0) {
-        // Balance to left - attenuate right channel
-        right_atten = (settings.balance * 12) / 100;  // -12 to 0 dB
-    } else if (settings.balance > 0) {
-        // Balance to right - attenuate left channel
-        left_atten = -(settings.balance * 12) / 100;  // -12 to 0 dB
-    }
-
+    int left_atten, right_atten;
+    audio_settings_get_balance_db(&left_atten, &right_atten);
     ESP_LOGI(TAG, "Balance: %d (L atten=%d dB, R atten=%d dB)",
              settings.balance, left_atten, right_atten);
 
-    // Apply balance through equalizer by adjusting all bands with offset
-    audio_element_handle_t eq = audio_player_get_equalizer();
-    if (eq == NULL) {
+    // Apply balance through equalizer - odtwarzacz przesuwa wszystkie pasma kanału
+    if (audio_player_get_equalizer() == NULL) {
         ESP_LOGW(TAG, "Equalizer not available for balance");
         return ESP_ERR_INVALID_STATE;
     }
 
-    // Re-apply all EQ bands with balance offset
+    int gains_db[EQ_BANDS];
     for (int i = 0; i < EQ_BANDS; i++) {
-        int base_db = (int)settings.bands[i] - 12;
-
-        // Left channel (index 0-9)
-        int left_db = base_db + left_atten;
-        if (left_db < -13) left_db = -13;
-        if (left_db > 13) left_db = 13;
-        equalizer_set_gain_info(eq, i, left_db, false);
-
-        // Right channel (index 10-19)
-        int right_db = base_db + right_atten;
-        if (right_db < -13) right_db = -13;
-        if (right_db > 13) right_db = 13;
-        equalizer_set_gain_info(eq, i + 10, right_db, false);
+        gains_db[i] = (int)settings.bands[i] - 12;
     }
-
-    return ESP_OK;
+    return audio_player_set_eq_all_bands(gains_db);
 }
 
 // ============================================
@@ -281,6 +258,20 @@ esp_err_t audio_settings_set_balance(int8_t balance)
     return apply_balance_to_codec();
 }
 
+void audio_settings_get_balance_db(int *left_db, int *right_db)
+{
+    // Calculate attenuation for each channel (0 to -12 dB)
+    *left_db = 0;
+    *right_db = 0;
+    if (settings.balance < 0) {
+        // Balance to left - attenuate right channel
+        *right_db = (settings.balance * 12) / 100;
+    } else if (settings.balance > 0) {
+        // Balance to right - attenuate left channel
+        *left_db = -(settings.balance * 12) / 100;
+    }
+}
+
 esp_err_t audio_settings_set_bass_boost(bool enable)
 {
     settings.bass_boost = enable;
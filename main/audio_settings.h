@@ -112,6 +112,7 @@ const eq_band_info_t *audio_settings_get_all_bands_info(void);
 
 // Balans
 esp_err_t audio_settings_set_balance(int8_t balance);
+void audio_settings_get_balance_db(int *left_db, int *right_db);   // Tłumienie kanałów (0..-12 dB)
 
 // Efekty
 esp_err_t audio_settings_set_bass_boost(bool enable);
@@ -8,11 +8,19 @@
 #include "freertos/task.h"
 #include "esp_log.h"
 #include "driver/gpio.h"
-#include "driver/adc.h"
 
 #include "aux_input.h"
+#include "aux_meter.h"
+#include "audio_player.h"
+#include "player_status.h"
+#include "pipeline_stats.h"
+#include "audio_pipeline.h"
+#include "audio_element.h"
+#include "i2s_stream.h"
+#include "ringbuf.h"
 #include "config.h"
 #include "board.h"
+#include "es8388.h"
 
 static const char *TAG = "AUX_INPUT";
 
@@ -20,19 +28,49 @@ static const char *TAG = "AUX_INPUT";
 // Configuration
 // ============================================
 #define AUX_DETECT_CHECK_INTERVAL_MS    1000  // Reduced from 200ms to save CPU
-#define AUX_SIGNAL_THRESHOLD            100     // ADC threshold for signal detection
-#define AUX_SIGNAL_SAMPLES              10      // Samples for signal level averaging
+#define AUX_GAIN_MIN_DB                 -12
+#define AUX_GAIN_MAX_DB                 12
+#define AUX_THRESHOLD_MIN_DB            -80
+#define AUX_THRESHOLD_MAX_DB            -10
+#define AUX_SILENCE_MIN_MS              1000
+#define AUX_SILENCE_MAX_MS              600000
+#define AUX_CAPTURE_BYTES               2048    // Blok z DMA ADC (~12 ms)
+#define AUX_CAPTURE_DMA_DESC            6       // Jak wyjście odtwarzacza (wspólny port I2S)
+#define AUX_CAPTURE_DMA_FRAMES          512
+#define AUX_PCM_RB_SIZE                 (8 * 1024)
 
 // ============================================
 // State variables
 // ============================================
 static aux_state_t current_state = AUX_STATE_DISABLED;
 static int current_gain = 0;  // dB
-static int signal_level = 0;
 static bool enabled = false;
+static volatile bool plugged = false;
 static TaskHandle_t aux_task_handle = NULL;
 static bool task_running = false;
 
+// Pomiar poziomu i bramka - aktualizowane w tasku czytnika I2S (aux_input_process)
+static aux_meter_t meter;
+static aux_gate_t gate;
+static int meter_rate = 0;
+static int meter_channels = 0;
+
+// Automatyczne przełączanie (task monitora)
+static bool auto_switch = AUX_AUTO_SWITCH;
+static bool auto_switched = false;          // Odtwarzacz przełączony na AUX przez sygnał
+static audio_source_t resume_source = AUDIO_SOURCE_NONE;
+static char resume_url[512];
+static uint32_t resume_position_ms = 0;
+
+// Czytnik ADC: i2s (odczyt) -> wzmocnienie i pomiar poziomu -> capture_rb -> etap wyjściowy.
+// Działa przez cały czas włączenia AUX - pomiar poziomu przełącza źródło. Start i stop
+// tylko z taska sterującego odtwarzacza.
+static audio_pipeline_handle_t capture_pipeline = NULL;
+static audio_element_handle_t capture_reader = NULL;
+static ringbuf_handle_t capture_rb = NULL;
+static bool capturing = false;
+static volatile int capture_rate = AUX_SAMPLE_RATE;
+
 // Callback
 static aux_state_callback_t state_callback = NULL;
 
@@ -64,29 +102,80 @@ static bool check_aux_plugged(void) {
     #endif
 }
 
-static int read_signal_level(void) {
-    // Read audio level from ADC (simplified - actual implementation
-    // would use I2S or codec's built-in level detection)
-    uint32_t sum = 0;
-    for (int i = 0; i < AUX_SIGNAL_SAMPLES; i++) {
-        // This is a placeholder - actual signal level would come from codec
-        sum += 0;  // adc1_get_raw() if ADC was connected to audio
-        vTaskDelay(pdMS_TO_TICKS(1));
+// ============================================
+// Automatyczne przełączanie źródła
+// ============================================
+
+// Sygnał na wejściu: zapamiętaj, co grało, i przełącz na AUX. Strumień z telefonu
+// (odbiornik BT) ma pierwszeństwo - użytkownik wybrał go świadomie.
+static void auto_switch_to_aux(void) {
+    static player_status_t status;  // Tylko task monitora
+    audio_player_get_status(&status);
+
+    bool playing = (status.state == PLAYER_STATE_PLAYING || status.state == PLAYER_STATE_BUFFERING);
+    if (status.source == AUDIO_SOURCE_AUX && playing) {
+        return;
+    }
+    if (status.source == AUDIO_SOURCE_BLUETOOTH && playing) {
+        ESP_LOGI(TAG, "Signal on AUX ignored - Bluetooth stream playing");
+        return;
+    }
+
+    resume_source = AUDIO_SOURCE_NONE;
+    if (playing && (status.source == AUDIO_SOURCE_HTTP || status.source == AUDIO_SOURCE_SDCARD)) {
+        resume_source = status.source;
+        strncpy(resume_url, status.current_url, sizeof(resume_url) - 1);
+        resume_url[sizeof(resume_url) - 1] = '\0';
+        resume_position_ms = status.source == AUDIO_SOURCE_SDCARD ? audio_player_get_position_ms() : 0;
+    }
+
+    ESP_LOGI(TAG, "Signal on AUX (%.1f dBFS) - switching source", meter.rms_db);
+    auto_switched = (audio_player_play_aux() == ESP_OK);
+}
+
+// Cisza na wejściu: wróć do źródła sprzed przełączenia. Źródło zmienione w międzyczasie
+// przez użytkownika zostaje.
+static void auto_switch_back(void) {
+    if (!auto_switched) {
+        return;
+    }
+    auto_switched = false;
+
+    static player_status_t status;  // Tylko task monitora
+    audio_player_get_status(&status);
+    if (status.source != AUDIO_SOURCE_AUX) {
+        return;
+    }
+
+    switch (resume_source) {
+        case AUDIO_SOURCE_HTTP:
+            ESP_LOGI(TAG, "AUX silent - back to %s", resume_url);
+            audio_player_play_url(resume_url);
+            break;
+        case AUDIO_SOURCE_SDCARD:
+            ESP_LOGI(TAG, "AUX silent - back to %s at %lu ms", resume_url,
+                     (unsigned long)resume_position_ms);
+            audio_player_play_sdcard_from(resume_url, resume_position_ms);
+            break;
+        default:
+            ESP_LOGI(TAG, "AUX silent - stopping");
+            audio_player_stop_aux();
+            break;
     }
-    return sum / AUX_SIGNAL_SAMPLES * 100 / 4095;
 }
 
 // ============================================
 // Monitoring task
 // ============================================
 
+// Budzony co AUX_DETECT_CHECK_INTERVAL_MS (wtyk) lub od razu przy zmianie bramki sygnału
 static void aux_monitor_task(void *pvParameters) {
     bool was_plugged = false;
-    int no_signal_count = 0;
 
     while (task_running) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(AUX_DETECT_CHECK_INTERVAL_MS));
         if (!enabled) {
-            vTaskDelay(pdMS_TO_TICKS(500));
+            was_plugged = false;
             continue;
         }
 
@@ -99,38 +188,182 @@ static void aux_monitor_task(void *pvParameters) {
         } else if (!is_plugged && was_plugged) {
             // Cable unplugged
             ESP_LOGI(TAG, "AUX cable disconnected");
+            aux_gate_reset(&gate);
             set_state(AUX_STATE_UNPLUGGED);
-            signal_level = 0;
         }
 
         was_plugged = is_plugged;
+        plugged = is_plugged;
 
-        // Check signal level if plugged
-        if (is_plugged) {
-            signal_level = read_signal_level();
-
-            if (signal_level > AUX_SIGNAL_THRESHOLD) {
-                if (current_state != AUX_STATE_ACTIVE) {
-                    set_state(AUX_STATE_ACTIVE);
-                }
-                no_signal_count = 0;
-            } else {
-                no_signal_count++;
-                // After 2 seconds of no signal, go back to plugged state
-                if (no_signal_count > (2000 / AUX_DETECT_CHECK_INTERVAL_MS)) {
-                    if (current_state == AUX_STATE_ACTIVE) {
-                        set_state(AUX_STATE_PLUGGED);
-                    }
-                }
+        bool active = is_plugged && gate.open;
+        if (active && current_state != AUX_STATE_ACTIVE) {
+            set_state(AUX_STATE_ACTIVE);
+            if (auto_switch) {
+                auto_switch_to_aux();
             }
+        } else if (!active && current_state == AUX_STATE_ACTIVE) {
+            set_state(AUX_STATE_PLUGGED);
+        }
+        if (!active) {
+            auto_switch_back();
         }
-
-        vTaskDelay(pdMS_TO_TICKS(AUX_DETECT_CHECK_INTERVAL_MS));
     }
 
     vTaskDelete(NULL);
 }
 
+// ============================================
+// Tor PCM (task czytnika I2S)
+// ============================================
+
+void aux_input_process(int16_t *pcm, int samples, int rate, int channels) {
+    if (rate != meter_rate || channels != meter_channels) {
+        meter_rate = rate;
+        meter_channels = channels;
+        aux_meter_set_format(&meter, rate, channels);
+    }
+    if (!aux_meter_process(&meter, pcm, samples)) {
+        return;
+    }
+    if (!enabled || !plugged) {
+        return;     // Szum niepodłączonego wejścia nie otwiera bramki
+    }
+    if (aux_gate_update(&gate, meter.rms_db, AUX_METER_WINDOW_MS) != AUX_GATE_NONE && aux_task_handle) {
+        xTaskNotifyGive(aux_task_handle);
+    }
+}
+
+// Blok z ADC (task czytnika): wzmocnienie i pomiar poziomu w miejscu, potem do bufora
+// etapu wyjściowego - tylko gdy AUX gra. Poza tym sam pomiar (automatyczne przełączanie).
+// Zegar I2S ustawia bieżące źródło - częstotliwość z formatu wyjścia.
+static int capture_write_cb(audio_element_handle_t el, char *buf, int len, TickType_t wait, void *ctx) {
+    aux_input_process((int16_t *)buf, len / sizeof(int16_t), capture_rate, 2);
+
+    if (player_status->source == AUDIO_SOURCE_AUX && player_status->state == PLAYER_STATE_PLAYING) {
+        // Bez czekania - czytnik nie może zgubić bloku DMA przez pełny bufor
+        if (rb_write(capture_rb, buf, len, 0) < len) {
+            pipeline_stats_overrun(PSTAT_OUTPUT);
+        }
+    }
+    return len;
+}
+
+static esp_err_t capture_init(void) {
+    if (capture_pipeline) return ESP_OK;
+
+    // Ten sam port co wyjście - ADF otwiera oba kierunki I2S_NUM_0 (full duplex, wspólny zegar)
+    i2s_stream_cfg_t i2s_cfg = I2S_STREAM_CFG_DEFAULT();
+    i2s_cfg.type = AUDIO_STREAM_READER;
+    i2s_cfg.buffer_len = AUX_CAPTURE_BYTES;
+    i2s_cfg.task_prio = 22;
+    i2s_cfg.task_core = 1;  // Razem z EQ i I2S wyjścia
+    i2s_cfg.stack_in_ext = true;
+    i2s_cfg.chan_cfg.dma_desc_num = AUX_CAPTURE_DMA_DESC;
+    i2s_cfg.chan_cfg.dma_frame_num = AUX_CAPTURE_DMA_FRAMES;
+    capture_reader = i2s_stream_init(&i2s_cfg);
+
+    capture_rb = rb_create(AUX_PCM_RB_SIZE, 1);
+
+    if (capture_reader == NULL || capture_rb == NULL) {
+        ESP_LOGE(TAG, "Failed to create AUX source");
+        return ESP_ERR_NO_MEM;
+    }
+
+    audio_pipeline_cfg_t pipeline_cfg = DEFAULT_AUDIO_PIPELINE_CONFIG();
+    capture_pipeline = audio_pipeline_init(&pipeline_cfg);
+    if (capture_pipeline == NULL) {
+        ESP_LOGE(TAG, "Failed to create AUX pipeline");
+        return ESP_FAIL;
+    }
+
+    audio_pipeline_register(capture_pipeline, capture_reader, "i2s_in");
+    const char *link_tag[1] = {"i2s_in"};
+    audio_pipeline_link(capture_pipeline, &link_tag[0], 1);
+    audio_element_set_write_cb(capture_reader, capture_write_cb, NULL);
+
+    ESP_LOGI(TAG, "AUX pipeline: i2s (ADC) -> gain/meter -> [output]");
+    return ESP_OK;
+}
+
+void aux_input_capture_deinit(void) {
+    if (capture_pipeline == NULL) return;
+
+    audio_pipeline_stop(capture_pipeline);
+    audio_pipeline_wait_for_stop(capture_pipeline);
+    audio_pipeline_terminate(capture_pipeline);
+    audio_pipeline_unregister(capture_pipeline, capture_reader);
+    audio_pipeline_deinit(capture_pipeline);
+    audio_element_deinit(capture_reader);
+    rb_destroy(capture_rb);
+    capture_pipeline = NULL;
+    capture_reader = NULL;
+    capture_rb = NULL;
+    capturing = false;
+}
+
+esp_err_t aux_input_capture_start(void) {
+    if (capturing) return ESP_OK;
+
+    esp_err_t ret = capture_init();
+    if (ret != ESP_OK) {
+        aux_input_capture_deinit();
+        return ret;
+    }
+    audio_pipeline_reset_elements(capture_pipeline);
+    ret = audio_pipeline_run(capture_pipeline);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start AUX capture");
+        return ret;
+    }
+    capturing = true;
+    ESP_LOGI(TAG, "AUX capture started");
+    return ESP_OK;
+}
+
+void aux_input_capture_stop(void) {
+    if (!capturing) return;
+
+    capturing = false;
+    audio_pipeline_stop(capture_pipeline);
+    audio_pipeline_wait_for_stop(capture_pipeline);
+    ESP_LOGI(TAG, "AUX capture stopped");
+}
+
+bool aux_input_is_capturing(void) {
+    return capturing;
+}
+
+void aux_input_capture_set_rate(int rate) {
+    capture_rate = rate > 0 ? rate : AUX_SAMPLE_RATE;
+}
+
+// Czytnik i wyjście na jednym zegarze - bufor nie dryfuje, odczyt czeka najwyżej jeden
+// blok DMA
+int aux_input_read_pcm(uint8_t *buf, int len, uint32_t wait_ms) {
+    if (capture_rb == NULL) {
+        vTaskDelay(pdMS_TO_TICKS(wait_ms));
+        return 0;
+    }
+
+    pipeline_stats_fill(PSTAT_OUTPUT, rb_bytes_filled(capture_rb), rb_get_size(capture_rb));
+    int rlen = rb_read(capture_rb, (char *)buf, len, pdMS_TO_TICKS(wait_ms));
+    if (rlen <= 0) {
+        if (rlen == RB_TIMEOUT) {
+            pipeline_stats_underrun(PSTAT_OUTPUT);
+        } else {
+            vTaskDelay(pdMS_TO_TICKS(wait_ms));  // Czytnik zatrzymany
+        }
+        return 0;
+    }
+    return rlen;
+}
+
+void aux_input_flush_pcm(void) {
+    if (capture_rb) {
+        rb_reset(capture_rb);
+    }
+}
+
 // ============================================
 // Public API
 // ============================================
@@ -158,19 +391,22 @@ esp_err_t aux_input_init(void) {
 
     current_state = AUX_STATE_DISABLED;
     current_gain = 0;
-    signal_level = 0;
+    aux_meter_init(&meter);
+    aux_gate_init(&gate, AUX_SIGNAL_THRESHOLD_DB, AUX_SILENCE_MS);
 
     // Start monitoring task
     task_running = true;
-    xTaskCreate(aux_monitor_task, "aux_monitor", 2048, NULL, 3, &aux_task_handle);
+    xTaskCreate(aux_monitor_task, "aux_monitor", 3072, NULL, 3, &aux_task_handle);
 
     ESP_LOGI(TAG, "AUX input initialized");
     return ESP_OK;
 }
 
 esp_err_t aux_input_deinit(void) {
+    aux_input_disable();
     task_running = false;
     if (aux_task_handle) {
+        xTaskNotifyGive(aux_task_handle);
         vTaskDelay(pdMS_TO_TICKS(300));
         aux_task_handle = NULL;
     }
@@ -185,15 +421,21 @@ esp_err_t aux_input_enable(void) {
         return ESP_ERR_INVALID_STATE;
     }
 
-    // Configure codec to use LINE_IN (AUX) as input
-    // ES8388 codec on LyraT has LINE_IN on IN2
+    // ADC i DAC naraz: wejście liniowe idzie przez I2S do odtwarzacza (EQ, głośność),
+    // nie analogowym obejściem kodeka (tryb LINE_IN)
     audio_hal_ctrl_codec(board_handle->audio_hal,
-                         AUDIO_HAL_CODEC_MODE_LINE_IN,
+                         AUDIO_HAL_CODEC_MODE_BOTH,
                          AUDIO_HAL_CTRL_START);
+    // ES8388 on LyraT has LINE_IN on IN2; PGA at 0 dB - line level clips the mic default
+    es8388_config_adc_input(ADC_INPUT_LINPUT2_RINPUT2);
+    es8388_set_mic_gain(MIC_GAIN_0DB);
 
+    aux_gate_reset(&gate);
+    plugged = check_aux_plugged();
     enabled = true;
+    audio_player_aux_capture(true);
 
-    if (check_aux_plugged()) {
+    if (plugged) {
         set_state(AUX_STATE_PLUGGED);
     } else {
         set_state(AUX_STATE_UNPLUGGED);
@@ -206,22 +448,27 @@ esp_err_t aux_input_disable(void) {
     ESP_LOGI(TAG, "Disabling AUX input");
 
     enabled = false;
+    auto_switched = false;
+    audio_player_aux_capture(false);
+    aux_gate_reset(&gate);
+    meter.rms_db = AUX_METER_FLOOR_DB;
+    meter.peak_db = AUX_METER_FLOOR_DB;
+    if (board_handle) {
+        es8388_stop(ES_MODULE_ADC);
+    }
     set_state(AUX_STATE_DISABLED);
 
     return ESP_OK;
 }
 
 esp_err_t aux_input_set_gain(int gain_db) {
-    if (gain_db < -12) gain_db = -12;
-    if (gain_db > 12) gain_db = 12;
+    if (gain_db < AUX_GAIN_MIN_DB) gain_db = AUX_GAIN_MIN_DB;
+    if (gain_db > AUX_GAIN_MAX_DB) gain_db = AUX_GAIN_MAX_DB;
 
     current_gain = gain_db;
+    aux_meter_set_gain_db(&meter, (float)gain_db);
     ESP_LOGI(TAG, "AUX gain set to: %d dB", gain_db);
 
-    // Set codec input gain
-    // This would need to be implemented via ES8388 register writes
-    // audio_hal_set_volume() is for output, not input gain
-
     return ESP_OK;
 }
 
@@ -229,6 +476,41 @@ int aux_input_get_gain(void) {
     return current_gain;
 }
 
+void aux_input_set_auto_switch(bool enable) {
+    auto_switch = enable;
+    ESP_LOGI(TAG, "AUX auto switch: %s", enable ? "on" : "off");
+}
+
+bool aux_input_get_auto_switch(void) {
+    return auto_switch;
+}
+
+esp_err_t aux_input_set_threshold(int threshold_db) {
+    if (threshold_db < AUX_THRESHOLD_MIN_DB || threshold_db > AUX_THRESHOLD_MAX_DB) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    gate.threshold_db = (float)threshold_db;
+    ESP_LOGI(TAG, "AUX signal threshold: %d dBFS", threshold_db);
+    return ESP_OK;
+}
+
+int aux_input_get_threshold(void) {
+    return (int)gate.threshold_db;
+}
+
+esp_err_t aux_input_set_silence_ms(uint32_t ms) {
+    if (ms < AUX_SILENCE_MIN_MS || ms > AUX_SILENCE_MAX_MS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    gate.silence_ms = ms;
+    ESP_LOGI(TAG, "AUX silence timeout: %lu ms", (unsigned long)ms);
+    return ESP_OK;
+}
+
+uint32_t aux_input_get_silence_ms(void) {
+    return gate.silence_ms;
+}
+
 aux_state_t aux_input_get_state(void) {
     return current_state;
 }
@@ -242,7 +524,19 @@ bool aux_input_is_active(void) {
 }
 
 int aux_input_get_signal_level(void) {
-    return signal_level;
+    return enabled ? aux_meter_level_percent(meter.rms_db) : 0;
+}
+
+float aux_input_get_rms_db(void) {
+    return meter.rms_db;
+}
+
+float aux_input_get_peak_db(void) {
+    return meter.peak_db;
+}
+
+uint32_t aux_input_get_clipped(void) {
+    return meter.clipped;
 }
 
 void aux_input_register_callback(aux_state_callback_t callback) {
@@ -7,6 +7,7 @@
 #define AUX_INPUT_H
 
 #include "esp_err.h"
+#include <stdint.h>
 #include <stdbool.h>
 
 // ============================================
@@ -35,9 +36,33 @@ esp_err_t aux_input_deinit(void);
 // ============================================
 esp_err_t aux_input_enable(void);
 esp_err_t aux_input_disable(void);
-esp_err_t aux_input_set_gain(int gain_db);  // -12 to +12 dB
+esp_err_t aux_input_set_gain(int gain_db);  // -12 to +12 dB, cyfrowo w torze PCM
 int aux_input_get_gain(void);
 
+// Automatyczne przełączanie: sygnał ponad progiem (RMS po wzmocnieniu) włącza źródło AUX,
+// cisza dłuższa niż silence_ms wraca do poprzedniego źródła (lub zatrzymuje)
+void aux_input_set_auto_switch(bool enable);
+bool aux_input_get_auto_switch(void);
+esp_err_t aux_input_set_threshold(int threshold_db);    // -80 to -10 dBFS
+int aux_input_get_threshold(void);
+esp_err_t aux_input_set_silence_ms(uint32_t ms);        // 1 s - 10 min
+uint32_t aux_input_get_silence_ms(void);
+
+// PCM z ADC (task czytnika I2S): wzmocnienie i pomiar poziomu w miejscu
+void aux_input_process(int16_t *pcm, int samples, int rate, int channels);
+
+// Czytnik ADC (task sterujący odtwarzacza). Włączany razem z wejściem AUX, także bez
+// odtwarzania AUX - pomiar poziomu decyduje o automatycznym przełączeniu.
+esp_err_t aux_input_capture_start(void);
+void aux_input_capture_stop(void);
+void aux_input_capture_deinit(void);
+bool aux_input_is_capturing(void);
+void aux_input_capture_set_rate(int rate);     // Zegar I2S wyjścia (wspólny z ADC)
+
+// PCM dla etapu wyjściowego (tylko gdy AUX gra); 0 - brak danych w wait_ms
+int aux_input_read_pcm(uint8_t *buf, int len, uint32_t wait_ms);
+void aux_input_flush_pcm(void);
+
 // ============================================
 // Status
 // ============================================
@@ -45,6 +70,9 @@ aux_state_t aux_input_get_state(void);
 bool aux_input_is_connected(void);
 bool aux_input_is_active(void);
 int aux_input_get_signal_level(void);  // 0-100
+float aux_input_get_rms_db(void);       // Ostatnie okno pomiarowe (dBFS)
+float aux_input_get_peak_db(void);
+uint32_t aux_input_get_clipped(void);   // Próbki obcięte przez wzmocnienie
 
 // ============================================
 // Callbacks
@@ -0,0 +1,135 @@
+/*
+ * AUX Meter Module
+ * Wzmocnienie, RMS/szczyt w miejscu na blokach PCM i bramka sygnału wejścia AUX
+ */
+
+#include <string.h>
+#include <math.h>
+#include "aux_meter.h"
+
+static float to_dbfs(float amplitude)
+{
+    if (amplitude < 1.0f) return AUX_METER_FLOOR_DB;
+    float db = 20.0f * log10f(amplitude / 32768.0f);
+    return db < AUX_METER_FLOOR_DB ? AUX_METER_FLOOR_DB : db;
+}
+
+void aux_meter_init(aux_meter_t *meter)
+{
+    memset(meter, 0, sizeof(*meter));
+    meter->gain_q12 = AUX_GAIN_Q12_UNITY;
+    meter->rms_db = AUX_METER_FLOOR_DB;
+    meter->peak_db = AUX_METER_FLOOR_DB;
+    aux_meter_set_format(meter, 44100, 2);
+}
+
+void aux_meter_set_format(aux_meter_t *meter, int rate, int channels)
+{
+    if (rate <= 0) rate = 44100;
+    if (channels <= 0) channels = 2;
+    meter->window_samples = (uint32_t)rate * channels * AUX_METER_WINDOW_MS / 1000;
+    meter->sum_sq = 0;
+    meter->count = 0;
+    meter->peak = 0;
+}
+
+void aux_meter_set_gain_db(aux_meter_t *meter, float gain_db)
+{
+    meter->gain_q12 = (int32_t)lroundf(AUX_GAIN_Q12_UNITY * powf(10.0f, gain_db / 20.0f));
+}
+
+bool aux_meter_process(aux_meter_t *meter, int16_t *pcm, int samples)
+{
+    const int32_t gain = meter->gain_q12;
+    uint64_t sum = 0;
+    int32_t peak = meter->peak;
+    uint32_t clipped = 0;
+
+    if (gain == AUX_GAIN_Q12_UNITY) {
+        for (int i = 0; i < samples; i++) {
+            int32_t v = pcm[i];
+            int32_t a = v < 0 ? -v : v;
+            sum += (uint32_t)(v * v);
+            if (a > peak) peak = a;
+        }
+    } else {
+        for (int i = 0; i < samples; i++) {
+            int32_t v = (pcm[i] * gain + (AUX_GAIN_Q12_UNITY / 2)) >> 12;
+            if (v > 32767) {
+                v = 32767;
+                clipped++;
+            } else if (v < -32768) {
+                v = -32768;
+                clipped++;
+            }
+            pcm[i] = (int16_t)v;
+            int32_t a = v < 0 ? -v : v;
+            sum += (uint32_t)(v * v);
+            if (a > peak) peak = a;
+        }
+    }
+
+    meter->sum_sq += sum;
+    meter->count += samples;
+    meter->peak = peak;
+    if (clipped) meter->clipped += clipped;
+
+    if (meter->count < meter->window_samples) {
+        return false;
+    }
+    meter->rms_db = to_dbfs(sqrtf((float)meter->sum_sq / meter->count));
+    meter->peak_db = to_dbfs((float)meter->peak);
+    meter->windows++;
+    meter->sum_sq = 0;
+    meter->count = 0;
+    meter->peak = 0;
+    return true;
+}
+
+int aux_meter_level_percent(float db)
+{
+    if (db <= -60.0f) return 0;
+    if (db >= 0.0f) return 100;
+    return (int)((db + 60.0f) * 100.0f / 60.0f);
+}
+
+// ============================================
+// Bramka sygnału
+// ============================================
+
+void aux_gate_init(aux_gate_t *gate, float threshold_db, uint32_t silence_ms)
+{
+    memset(gate, 0, sizeof(*gate));
+    gate->threshold_db = threshold_db;
+    gate->silence_ms = silence_ms;
+}
+
+void aux_gate_reset(aux_gate_t *gate)
+{
+    gate->open = false;
+    gate->above_ms = 0;
+    gate->below_ms = 0;
+}
+
+aux_gate_event_t aux_gate_update(aux_gate_t *gate, float rms_db, uint32_t dt_ms)
+{
+    if (!gate->open) {
+        // Atak liczony tylko przy ciągłym sygnale - pojedyncze trzaski nie otwierają
+        gate->above_ms = rms_db >= gate->threshold_db ? gate->above_ms + dt_ms : 0;
+        if (gate->above_ms >= AUX_GATE_ATTACK_MS) {
+            gate->open = true;
+            gate->below_ms = 0;
+            return AUX_GATE_OPEN;
+        }
+        return AUX_GATE_NONE;
+    }
+
+    // Każde okno ponad progiem zamknięcia zaczyna odliczanie ciszy od nowa
+    gate->below_ms = rms_db < gate->threshold_db - AUX_GATE_HYSTERESIS_DB ? gate->below_ms + dt_ms : 0;
+    if (gate->below_ms >= gate->silence_ms) {
+        gate->open = false;
+        gate->above_ms = 0;
+        return AUX_GATE_CLOSE;
+    }
+    return AUX_GATE_NONE;
+}
@@ -0,0 +1,73 @@
+/*
+ * AUX Meter Module
+ * Wzmocnienie i pomiar poziomu PCM z wejścia liniowego (ADC ES8388). Bloki z czytnika I2S
+ * są przetwarzane w miejscu: wzmocnienie Q12 z nasyceniem, suma kwadratów i szczyt
+ * w tym samym przejściu. Co okno pomiarowe - RMS i szczyt w dBFS.
+ *
+ * Bramka sygnału decyduje, czy na wejściu coś gra: próg z histerezą, sygnał musi się
+ * utrzymać przez czas ataku, cisza przez czas zwolnienia (konfigurowany).
+ * Czyste C - można kompilować i sprawdzać na hoście.
+ */
+
+#ifndef AUX_METER_H
+#define AUX_METER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define AUX_METER_WINDOW_MS     50      // Okno RMS - też krok bramki
+#define AUX_METER_FLOOR_DB      -96.0f  // Cisza cyfrowa (16 bit)
+#define AUX_GAIN_Q12_UNITY      4096
+
+#define AUX_GATE_HYSTERESIS_DB  6.0f    // Bramka zamyka się poniżej progu minus histereza
+#define AUX_GATE_ATTACK_MS      200     // Sygnał ponad progiem tyle czasu - to nie trzask wtyku
+
+typedef struct {
+    volatile int32_t gain_q12;      // Zmieniane z innego taska - jedno słowo
+    uint32_t window_samples;        // Próbki (wszystkie kanały) na okno
+    uint64_t sum_sq;
+    uint32_t count;
+    int32_t peak;
+
+    // Wynik ostatniego pełnego okna
+    volatile float rms_db;
+    volatile float peak_db;
+    volatile uint32_t windows;
+    volatile uint32_t clipped;      // Próbki obcięte przez wzmocnienie od startu
+} aux_meter_t;
+
+typedef enum {
+    AUX_GATE_NONE = 0,
+    AUX_GATE_OPEN,                  // Pojawił się sygnał
+    AUX_GATE_CLOSE,                 // Cisza dłużej niż silence_ms
+} aux_gate_event_t;
+
+typedef struct {
+    volatile float threshold_db;    // Otwarcie bramki (RMS)
+    volatile uint32_t silence_ms;
+    bool open;
+    uint32_t above_ms;
+    uint32_t below_ms;
+} aux_gate_t;
+
+void aux_meter_init(aux_meter_t *meter);
+
+// Długość okna dla formatu PCM; zeruje bieżące okno
+void aux_meter_set_format(aux_meter_t *meter, int rate, int channels);
+
+void aux_meter_set_gain_db(aux_meter_t *meter, float gain_db);
+
+// Blok PCM 16 bit (samples - wszystkie kanały) wzmacniany w miejscu.
+// true - zamknięte okno, nowe rms_db/peak_db.
+bool aux_meter_process(aux_meter_t *meter, int16_t *pcm, int samples);
+
+// Poziom 0-100 (-60..0 dBFS) dla wskaźnika w UI
+int aux_meter_level_percent(float db);
+
+void aux_gate_init(aux_gate_t *gate, float threshold_db, uint32_t silence_ms);
+void aux_gate_reset(aux_gate_t *gate);
+
+// Kolejne okno pomiarowe o długości dt_ms
+aux_gate_event_t aux_gate_update(aux_gate_t *gate, float rms_db, uint32_t dt_ms);
+
+#endif // AUX_METER_H
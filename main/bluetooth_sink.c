@@ -3,10 +3,14 @@
  * Receives audio from phones/computers via Bluetooth
  */
 
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
 #include "nvs_flash.h"
 #include "esp_bt.h"
 #include "esp_bt_main.h"
@@ -16,6 +20,9 @@
 #include "esp_avrc_api.h"
 
 #include "bluetooth_sink.h"
+#include "jitter_buffer.h"
+#include "audio_player.h"
+#include "player_status.h"
 #include "config.h"
 
 static const char *TAG = "BT_SINK";
@@ -28,13 +35,33 @@ static bt_playback_status_t playback_status = BT_PLAYBACK_STOPPED;
 static bt_track_info_t track_info = {0};
 static bt_device_info_t connected_device = {0};
 static uint8_t bt_volume = 64;  // 0-127
+static portMUX_TYPE track_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Etykiety transakcji AVRCP - osobne dla równolegle oczekujących zapytań
+enum {
+    AVRC_TL_METADATA = 0,
+    AVRC_TL_PLAY_STATUS,
+    AVRC_TL_RN_PLAY_STATUS,
+    AVRC_TL_RN_TRACK,
+};
+
+#define AVRC_METADATA_ATTRS     (ESP_AVRC_MD_ATTR_TITLE | ESP_AVRC_MD_ATTR_ARTIST | \
+                                 ESP_AVRC_MD_ATTR_ALBUM | ESP_AVRC_MD_ATTR_PLAYING_TIME)
 
 // Callbacks
 static bt_state_callback_t state_callback = NULL;
 static bt_track_callback_t track_callback = NULL;
 static bt_playback_callback_t playback_callback = NULL;
 
-// Note: audio_board_handle_t removed - not needed for basic Bluetooth sink
+// Odtwarzanie: callback danych A2DP -> bufor jittera -> etap wyjściowy odtwarzacza (EQ, I2S)
+#define SINK_JITTER_SIZE    (32 * 1024)     // 185 ms PCM 44.1 kHz stereo - ponad JITTER_MAX_MS
+#define SINK_ARRIVAL_TRACE  0               // 1 - log "A2DP_TRACE <us> <len>" dla host/fixtures/a2dp
+#define BT_POSITION_SLACK_MS 1500           // Mniejsza rozbieżność z pozycją AVRCP to nie przewinięcie
+
+static jitter_buffer_t sink_jb;
+static bool sink_jb_ready = false;
+static int sink_rate = 44100;
+static int sink_channels = 2;
 
 // ============================================
 // Helper functions
@@ -50,6 +77,36 @@ static void set_state(bt_state_t new_state) {
     }
 }
 
+static uint32_t track_now_ms(void) {
+    return xTaskGetTickCount() * portTICK_PERIOD_MS;
+}
+
+// Pozycja nie jest odpytywana okresowo - odtwarzacz liczy ją lokalnie od ostatniej
+// odpowiedzi. Telefon pytany tylko przy zmianie utworu lub stanu odtwarzania.
+static void track_set_position(uint32_t position_ms, bool playing) {
+    taskENTER_CRITICAL(&track_mux);
+    track_info.position_ms = position_ms;
+    track_info.position_at_ms = track_now_ms();
+    track_info.playing = playing;
+    taskEXIT_CRITICAL(&track_mux);
+}
+
+static uint32_t track_position_now(void) {
+    uint32_t pos = track_info.position_ms;
+    if (track_info.playing) {
+        pos += track_now_ms() - track_info.position_at_ms;
+    }
+    return pos;
+}
+
+// Metadane lub pozycja zmienione - callback i status odtwarzacza (ten sam status co radio/SD)
+static void track_updated(void) {
+    if (track_callback) {
+        track_callback(&track_info);
+    }
+    audio_player_bt_track_changed();
+}
+
 static void set_playback_status(bt_playback_status_t status) {
     if (status != playback_status) {
         playback_status = status;
@@ -119,8 +176,13 @@ static void bt_a2dp_sink_callback(esp_a2d_cb_event_t event, esp_a2d_cb_param_t *
             } else if (param->conn_stat.state == ESP_A2D_CONNECTION_STATE_DISCONNECTED) {
                 ESP_LOGI(TAG, "A2DP disconnected");
                 memset(&connected_device, 0, sizeof(connected_device));
+                taskENTER_CRITICAL(&track_mux);
                 memset(&track_info, 0, sizeof(track_info));
+                taskEXIT_CRITICAL(&track_mux);
                 set_playback_status(BT_PLAYBACK_STOPPED);
+                if (current_state == BT_STATE_STREAMING) {
+                    audio_player_stop_bluetooth();
+                }
                 set_state(BT_STATE_DISCOVERABLE);
             } else if (param->conn_stat.state == ESP_A2D_CONNECTION_STATE_CONNECTING) {
                 set_state(BT_STATE_CONNECTING);
@@ -130,22 +192,34 @@ static void bt_a2dp_sink_callback(esp_a2d_cb_event_t event, esp_a2d_cb_param_t *
         case ESP_A2D_AUDIO_STATE_EVT:
             if (param->audio_stat.state == ESP_A2D_AUDIO_STATE_STARTED) {
                 ESP_LOGI(TAG, "A2DP audio streaming started");
+                if (sink_jb_ready) {
+                    // Callback danych pisze dopiero po tym zdarzeniu - ten sam task Bluedroid
+                    jitter_buffer_start(&sink_jb, sink_rate, sink_channels * 2);
+                    audio_player_play_bluetooth(sink_rate, sink_channels);
+                }
                 set_state(BT_STATE_STREAMING);
             } else if (param->audio_stat.state == ESP_A2D_AUDIO_STATE_STOPPED ||
                        param->audio_stat.state == ESP_A2D_AUDIO_STATE_REMOTE_SUSPEND) {
                 ESP_LOGI(TAG, "A2DP audio streaming stopped");
                 if (current_state == BT_STATE_STREAMING) {
+                    audio_player_stop_bluetooth();
                     set_state(BT_STATE_CONNECTED);
                 }
             }
             break;
 
-        case ESP_A2D_AUDIO_CFG_EVT:
+        case ESP_A2D_AUDIO_CFG_EVT: {
             // Use sbc_info instead of deprecated sbc array
+            // samp_freq i ch_mode to maski bitowe z nagłówka SBC
+            int freq = param->audio_cfg.mcc.cie.sbc_info.samp_freq;
+            int mode = param->audio_cfg.mcc.cie.sbc_info.ch_mode;
+            sink_rate = (freq & 0x8) ? 16000 : (freq & 0x4) ? 32000 :
+                        (freq & 0x1) ? 48000 : 44100;
+            sink_channels = (mode & 0x8) ? 1 : 2;
             ESP_LOGI(TAG, "A2DP audio config: sample_rate=%d, channels=%d",
-                     param->audio_cfg.mcc.cie.sbc_info.samp_freq,
-                     param->audio_cfg.mcc.cie.sbc_info.ch_mode);
+                     sink_rate, sink_channels);
             break;
+        }
 
         default:
             break;
@@ -157,8 +231,14 @@ static void bt_a2dp_sink_callback(esp_a2d_cb_event_t event, esp_a2d_cb_param_t *
 // ============================================
 
 static void bt_a2dp_sink_data_callback(const uint8_t *data, uint32_t len) {
-    // Audio data is automatically routed to I2S by ESP-ADF
-    // This callback can be used for visualization or processing
+    // PCM 16-bit po dekodowaniu SBC; czas przyjścia steruje głębokością bufora
+    if (sink_jb_ready) {
+        int64_t now = esp_timer_get_time();
+#if SINK_ARRIVAL_TRACE
+        ESP_LOGI(TAG, "A2DP_TRACE %lld %lu", (long long)now, (unsigned long)len);
+#endif
+        jitter_buffer_write(&sink_jb, data, len, now);
+    }
 }
 
 // ============================================
@@ -171,10 +251,13 @@ static void bt_avrc_ct_callback(esp_avrc_ct_cb_event_t event, esp_avrc_ct_cb_par
             ESP_LOGI(TAG, "AVRC connection state: %d", param->conn_stat.connected);
             if (param->conn_stat.connected) {
                 // Request track info
-                esp_avrc_ct_send_metadata_cmd(0, ESP_AVRC_MD_ATTR_TITLE |
-                                                 ESP_AVRC_MD_ATTR_ARTIST |
-                                                 ESP_AVRC_MD_ATTR_ALBUM |
-                                                 ESP_AVRC_MD_ATTR_PLAYING_TIME);
+                esp_avrc_ct_send_metadata_cmd(AVRC_TL_METADATA, AVRC_METADATA_ATTRS);
+                esp_avrc_ct_send_get_play_status_cmd(AVRC_TL_PLAY_STATUS);
+                // Powiadomienia zamiast odpytywania - odnawiane po każdym zdarzeniu
+                esp_avrc_ct_send_register_notification_cmd(AVRC_TL_RN_PLAY_STATUS,
+                    ESP_AVRC_RN_PLAY_STATUS_CHANGE, 0);
+                esp_avrc_ct_send_register_notification_cmd(AVRC_TL_RN_TRACK,
+                    ESP_AVRC_RN_TRACK_CHANGE, 0);
             }
             break;
 
@@ -185,26 +268,30 @@ static void bt_avrc_ct_callback(esp_avrc_ct_cb_event_t event, esp_avrc_ct_cb_par
 
         case ESP_AVRC_CT_METADATA_RSP_EVT:
             ESP_LOGI(TAG, "AVRC metadata: attr_id=%d", param->meta_rsp.attr_id);
+            taskENTER_CRITICAL(&track_mux);
             switch (param->meta_rsp.attr_id) {
                 case ESP_AVRC_MD_ATTR_TITLE:
-                    strncpy(track_info.title, (char *)param->meta_rsp.attr_text,
-                            sizeof(track_info.title) - 1);
+                    snprintf(track_info.title, sizeof(track_info.title), "%.*s",
+                             param->meta_rsp.attr_length, (char *)param->meta_rsp.attr_text);
                     break;
                 case ESP_AVRC_MD_ATTR_ARTIST:
-                    strncpy(track_info.artist, (char *)param->meta_rsp.attr_text,
-                            sizeof(track_info.artist) - 1);
+                    snprintf(track_info.artist, sizeof(track_info.artist), "%.*s",
+                             param->meta_rsp.attr_length, (char *)param->meta_rsp.attr_text);
                     break;
                 case ESP_AVRC_MD_ATTR_ALBUM:
-                    strncpy(track_info.album, (char *)param->meta_rsp.attr_text,
-                            sizeof(track_info.album) - 1);
+                    snprintf(track_info.album, sizeof(track_info.album), "%.*s",
+                             param->meta_rsp.attr_length, (char *)param->meta_rsp.attr_text);
                     break;
-                case ESP_AVRC_MD_ATTR_PLAYING_TIME:
-                    track_info.duration_ms = atoi((char *)param->meta_rsp.attr_text);
+                case ESP_AVRC_MD_ATTR_PLAYING_TIME: {
+                    char ms[12];    // Tekst bez zera na końcu
+                    snprintf(ms, sizeof(ms), "%.*s",
+                             param->meta_rsp.attr_length, (char *)param->meta_rsp.attr_text);
+                    track_info.duration_ms = atoi(ms);
                     break;
+                }
             }
-            if (track_callback) {
-                track_callback(&track_info);
-            }
+            taskEXIT_CRITICAL(&track_mux);
+            track_updated();
             break;
 
         case ESP_AVRC_CT_CHANGE_NOTIFY_EVT:
@@ -229,23 +316,37 @@ static void bt_avrc_ct_callback(esp_avrc_ct_cb_event_t event, esp_avrc_ct_cb_par
                         set_playback_status(BT_PLAYBACK_ERROR);
                         break;
                 }
+                // Zegar pozycji zatrzymany/wznowiony od razu, dokładna pozycja z odpowiedzi
+                track_set_position(track_position_now(), playback_status == BT_PLAYBACK_PLAYING);
+                track_updated();
+                esp_avrc_ct_send_get_play_status_cmd(AVRC_TL_PLAY_STATUS);
                 // Re-register for notification
-                esp_avrc_ct_send_register_notification_cmd(0,
+                esp_avrc_ct_send_register_notification_cmd(AVRC_TL_RN_PLAY_STATUS,
                     ESP_AVRC_RN_PLAY_STATUS_CHANGE, 0);
             } else if (param->change_ntf.event_id == ESP_AVRC_RN_TRACK_CHANGE) {
+                track_set_position(0, playback_status == BT_PLAYBACK_PLAYING);
                 // Request new track info
-                esp_avrc_ct_send_metadata_cmd(0, ESP_AVRC_MD_ATTR_TITLE |
-                                                 ESP_AVRC_MD_ATTR_ARTIST |
-                                                 ESP_AVRC_MD_ATTR_ALBUM);
-                esp_avrc_ct_send_register_notification_cmd(0,
+                esp_avrc_ct_send_metadata_cmd(AVRC_TL_METADATA, AVRC_METADATA_ATTRS);
+                esp_avrc_ct_send_get_play_status_cmd(AVRC_TL_PLAY_STATUS);
+                esp_avrc_ct_send_register_notification_cmd(AVRC_TL_RN_TRACK,
                     ESP_AVRC_RN_TRACK_CHANGE, 0);
             }
             break;
 
-        case ESP_AVRC_CT_PLAY_STATUS_RSP_EVT:
-            track_info.duration_ms = param->play_status_rsp.song_length;
-            track_info.position_ms = param->play_status_rsp.song_position;
+        case ESP_AVRC_CT_PLAY_STATUS_RSP_EVT: {
+            // 0xFFFFFFFF - telefon nie podaje długości/pozycji
+            uint32_t length = param->play_status_rsp.song_length;
+            uint32_t position = param->play_status_rsp.song_position;
+            if (length != 0xFFFFFFFF) {
+                track_info.duration_ms = length;
+            }
+            if (position != 0xFFFFFFFF) {
+                track_set_position(position,
+                                   param->play_status_rsp.play_status == ESP_AVRC_PLAYBACK_PLAYING);
+            }
+            track_updated();
             break;
+        }
 
         default:
             break;
@@ -259,6 +360,18 @@ static void bt_avrc_ct_callback(esp_avrc_ct_cb_event_t event, esp_avrc_ct_cb_par
 esp_err_t bluetooth_sink_init(const char *device_name) {
     ESP_LOGI(TAG, "Initializing Bluetooth A2DP Sink...");
 
+    if (!sink_jb_ready) {
+        uint8_t *buf = heap_caps_malloc(SINK_JITTER_SIZE, MALLOC_CAP_SPIRAM);
+        if (buf == NULL) {
+            buf = heap_caps_malloc(SINK_JITTER_SIZE, MALLOC_CAP_8BIT);
+        }
+        if (buf == NULL || !jitter_buffer_init(&sink_jb, buf, SINK_JITTER_SIZE)) {
+            ESP_LOGE(TAG, "No memory for jitter buffer");
+            return ESP_ERR_NO_MEM;
+        }
+        sink_jb_ready = true;
+    }
+
     // Release BLE memory (we only use classic BT)
     ESP_ERROR_CHECK(esp_bt_controller_mem_release(ESP_BT_MODE_BLE));
 
@@ -405,6 +518,28 @@ const bt_track_info_t *bluetooth_sink_get_track_info(void) {
     return &track_info;
 }
 
+void bluetooth_sink_get_track(bt_track_info_t *track) {
+    taskENTER_CRITICAL(&track_mux);
+    memcpy(track, &track_info, sizeof(*track));
+    taskEXIT_CRITICAL(&track_mux);
+}
+
+// Pola bez zmian nie oznaczają statusu jako zmienionego - powiadomienie wysyła odtwarzacz
+void bluetooth_sink_publish_track(void) {
+    static bt_track_info_t track;  // Tylko task sterujący odtwarzacza
+    bluetooth_sink_get_track(&track);
+
+    player_status_set_title(track.title);
+    player_status_set_artist(track.artist);
+    player_status_set_album(track.album);
+    uint32_t at = 0;
+    if (track.playing) {
+        at = track.position_at_ms ? track.position_at_ms : 1;   // 0 znaczy "stoi"
+    }
+    player_status_set_position(track.duration_ms, track.position_ms, at, track_now_ms(),
+                               BT_POSITION_SLACK_MS);
+}
+
 const bt_device_info_t *bluetooth_sink_get_connected_device(void) {
     return &connected_device;
 }
@@ -417,6 +552,32 @@ bool bluetooth_sink_is_streaming(void) {
     return current_state == BT_STATE_STREAMING;
 }
 
+int bluetooth_sink_read_pcm(uint8_t *buf, int len) {
+    if (!sink_jb_ready) {
+        return 0;
+    }
+    return jitter_buffer_read(&sink_jb, buf, len);
+}
+
+void bluetooth_sink_get_stats(bt_sink_stats_t *stats) {
+    memset(stats, 0, sizeof(*stats));
+    if (!sink_jb_ready) {
+        return;
+    }
+    jitter_buffer_stats_t jb;
+    jitter_buffer_get_stats(&sink_jb, &jb);
+    stats->depth_ms = jb.depth_ms;
+    stats->target_ms = jb.target_ms;
+    stats->jitter_ms = jb.jitter_ms;
+    stats->packets = jb.packets;
+    stats->late = jb.late;
+    stats->lost = jb.lost;
+    stats->underruns = jb.underruns;
+    stats->slipped = jb.slipped;
+    stats->sample_rate = sink_rate;
+    stats->latency_ms = jb.depth_ms + audio_player_get_output_delay_ms();
+}
+
 void bluetooth_sink_register_state_callback(bt_state_callback_t callback) {
     state_callback = callback;
 }
@@ -8,6 +8,7 @@
 
 #include "esp_err.h"
 #include <stdbool.h>
+#include <stdint.h>
 
 // ============================================
 // Bluetooth connection states
@@ -41,7 +42,9 @@ typedef struct {
     char artist[128];
     char album[128];
     uint32_t duration_ms;
-    uint32_t position_ms;
+    uint32_t position_ms;       // Pozycja w chwili position_at_ms
+    uint32_t position_at_ms;    // Czas pracy (tick w ms) ostatniej odpowiedzi AVRCP
+    bool playing;               // Pozycja biegnie od position_at_ms
 } bt_track_info_t;
 
 // ============================================
@@ -53,6 +56,22 @@ typedef struct {
     int rssi;
 } bt_device_info_t;
 
+// ============================================
+// Playback pipeline stats (jitter buffer)
+// ============================================
+typedef struct {
+    uint32_t latency_ms;        // Bufor jittera + PCM przed I2S + DMA
+    uint32_t depth_ms;          // PCM w buforze jittera
+    uint32_t target_ms;         // Głębokość docelowa z opóźnień pakietów
+    uint32_t jitter_ms;         // Szczyt opóźnienia pakietów
+    uint32_t sample_rate;
+    uint32_t packets;
+    uint32_t late;              // Pakiety po opróżnieniu bufora
+    uint32_t lost;              // Pakiety odrzucone - bufor pełny
+    uint32_t underruns;
+    uint32_t slipped;           // Ramki pominięte/powtórzone przez korektę dryfu
+} bt_sink_stats_t;
+
 // ============================================
 // Callbacks
 // ============================================
@@ -96,10 +115,19 @@ uint8_t bluetooth_sink_get_volume(void);
 bt_state_t bluetooth_sink_get_state(void);
 bt_playback_status_t bluetooth_sink_get_playback_status(void);
 const bt_track_info_t *bluetooth_sink_get_track_info(void);
+void bluetooth_sink_get_track(bt_track_info_t *track);  // Spójna kopia (inny task niż BT)
+void bluetooth_sink_publish_track(void);  // Metadane i pozycja AVRCP do statusu odtwarzacza
 const bt_device_info_t *bluetooth_sink_get_connected_device(void);
 bool bluetooth_sink_is_connected(void);
 bool bluetooth_sink_is_streaming(void);
 
+// ============================================
+// Playback pipeline
+// ============================================
+// PCM z bufora jittera dla etapu wyjściowego odtwarzacza; 0 - buforowanie lub brak danych
+int bluetooth_sink_read_pcm(uint8_t *buf, int len);
+void bluetooth_sink_get_stats(bt_sink_stats_t *stats);
+
 // ============================================
 // Callbacks
 // ============================================
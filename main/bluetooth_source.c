@@ -10,6 +10,8 @@
 #include "freertos/semphr.h"
 #include "freertos/ringbuf.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs_flash.h"
 #include "esp_bt.h"
 #include "esp_bt_main.h"
 #include "esp_bt_device.h"
@@ -18,14 +20,22 @@
 #include "esp_avrc_api.h"
 
 #include "bluetooth_source.h"
+#include "bt_sink_cache.h"
+#include "bt_pacing.h"
+#include "pipeline_stats.h"
 #include "config.h"
 
 static const char *TAG = "BT_SOURCE";
 
 // Ring buffer for audio data
-#define BT_SOURCE_RINGBUF_SIZE (8 * 1024)
+#define BT_SOURCE_RINGBUF_SIZE (16 * 1024)  // 93 ms PCM 44.1 kHz stereo
+#define BT_SOURCE_BYTES_PER_MS BT_PACING_BYTES_PER_MS
 static RingbufHandle_t s_ringbuf = NULL;
 
+// Pre-roll i tempo producenta (strona czytająca: callback danych)
+static bt_pacing_t s_pacing = { .preroll_ms = BT_SOURCE_PREROLL_MS };
+static volatile bool s_media_started = false;   // Po starcie A2DP - producent ma pisać
+
 // Status and state
 static bt_source_status_t s_status = {0};
 static SemaphoreHandle_t s_status_mutex = NULL;
@@ -40,8 +50,19 @@ static bool s_a2dp_connected = false;
 static bool s_avrc_connected = false;
 static bool s_initialized = false;
 
+// Zapamiętane głośniki (NVS) i szybkie łączenie bez wyszukiwania.
+// s_sinks chroniony przez s_status_mutex.
+#define BT_SOURCE_NVS_NAMESPACE "bt_source"
+#define BT_SOURCE_NVS_SINKS     "sinks"
+static bt_sink_cache_t s_sinks;
+static bool s_sinks_loaded = false;
+static int s_reconnect_idx = -1;            // Próbowany głośnik (od najnowszego), -1 - brak
+static bool s_quick_scan = false;           // Wyszukiwanie w tle, bez stanu DISCOVERING
+static int64_t s_connect_start_us = 0;      // Pomiar czasu do pierwszego dźwięku
+
 // Audio data callback timer
 static int32_t s_audio_data_cb(uint8_t *data, int32_t len);
+static esp_err_t connect_bda(const uint8_t *bda);
 
 // ============================================
 // Helper functions
@@ -54,6 +75,9 @@ static void set_state(bt_source_state_t state) {
     }
 
     ESP_LOGI(TAG, "State changed: %s", bt_source_state_to_str(state));
+    if (state != BT_SOURCE_STATE_STREAMING && state != BT_SOURCE_STATE_CONNECTED) {
+        s_media_started = false;
+    }
 
     if (s_state_callback) {
         s_state_callback(state, s_status.connected_device.name);
@@ -70,6 +94,96 @@ static void set_error(const char *msg) {
     ESP_LOGE(TAG, "Error: %s", msg);
 }
 
+static void sinks_load(void) {
+    bt_sink_cache_init(&s_sinks);
+    s_sinks_loaded = true;
+
+    nvs_handle_t nvs;
+    if (nvs_open(BT_SOURCE_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+        return;     // Brak przestrzeni - jeszcze nic nie zapisano
+    }
+    size_t size = sizeof(s_sinks);
+    esp_err_t ret = nvs_get_blob(nvs, BT_SOURCE_NVS_SINKS, &s_sinks, &size);
+    if (ret != ESP_OK || size != sizeof(s_sinks) || !bt_sink_cache_validate(&s_sinks)) {
+        if (ret != ESP_ERR_NVS_NOT_FOUND) {
+            ESP_LOGW(TAG, "Sink cache invalid, starting empty");
+        }
+        bt_sink_cache_init(&s_sinks);
+    }
+    nvs_close(nvs);
+    ESP_LOGI(TAG, "Sink cache: %d sinks", s_sinks.count);
+}
+
+static void sinks_save(void) {
+    nvs_handle_t nvs;
+    esp_err_t ret = nvs_open(BT_SOURCE_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (ret == ESP_OK) {
+        ret = nvs_set_blob(nvs, BT_SOURCE_NVS_SINKS, &s_sinks, sizeof(s_sinks));
+        if (ret == ESP_OK) {
+            ret = nvs_commit(nvs);
+        }
+        nvs_close(nvs);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Sink cache save failed: %s", esp_err_to_name(ret));
+    }
+}
+
+// Kolejny zapamiętany głośnik; false - lista wyczerpana
+static bool reconnect_next(void) {
+    uint8_t bda[6];
+    bool found = false;
+
+    while (!found && s_reconnect_idx >= 0 && s_reconnect_idx < BT_SOURCE_RECONNECT_TRIES) {
+        if (xSemaphoreTake(s_status_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+            break;
+        }
+        const bt_sink_cache_entry_t *e = bt_sink_cache_nth_recent(&s_sinks, s_reconnect_idx);
+        if (e) {
+            memcpy(bda, e->bda, 6);
+            ESP_LOGI(TAG, "Reconnecting to cached sink '%s' (%d)", e->name, s_reconnect_idx);
+        }
+        xSemaphoreGive(s_status_mutex);
+        if (e == NULL) {
+            break;
+        }
+        found = (connect_bda(bda) == ESP_OK);
+        if (!found) {
+            s_reconnect_idx++;
+        }
+    }
+    if (!found) {
+        s_reconnect_idx = -1;
+    }
+    s_status.reconnecting = found;
+    return found;
+}
+
+// Połączony głośnik na początek listy; nazwa z wyszukiwania lub z cache
+static void sinks_connected(const uint8_t *bda) {
+    if (xSemaphoreTake(s_status_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return;
+    }
+    const char *name = s_status.connected_device.name[0] ? s_status.connected_device.name : NULL;
+    bt_sink_cache_entry_t *e = bt_sink_cache_touch(&s_sinks, bda, name);
+    if (name == NULL && e->name[0]) {
+        strncpy(s_status.connected_device.name, e->name, BT_SOURCE_DEVICE_NAME_LEN - 1);
+    }
+    s_status.connected_device.rssi = e->rssi;
+    sinks_save();
+    xSemaphoreGive(s_status_mutex);
+}
+
+static size_t ring_filled(void) {
+    return BT_SOURCE_RINGBUF_SIZE - xRingbufferGetCurFreeSize(s_ringbuf);
+}
+
+// Cisza do głośnika, dopóki producent nie zapełni bufora do pre-rollu (bt_source_write_audio)
+static void start_preroll(void) {
+    bt_pacing_start_preroll(&s_pacing);
+    s_media_started = true;
+}
+
 static void add_discovered_device(esp_bt_gap_cb_param_t *param) {
     if (xSemaphoreTake(s_status_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
         return;
@@ -86,6 +200,12 @@ static void add_discovered_device(esp_bt_gap_cb_param_t *param) {
         }
     }
 
+    // Zapamiętany głośnik w zasięgu - RSSI trafi do NVS przy następnym połączeniu
+    bt_sink_cache_entry_t *cached = bt_sink_cache_find(&s_sinks, param->disc_res.bda);
+    if (cached && rssi) {
+        cached->rssi = (int8_t)rssi;
+    }
+
     // Check if device already exists
     for (int i = 0; i < s_status.device_count; i++) {
         if (memcmp(s_status.devices[i].bda, param->disc_res.bda, 6) == 0) {
@@ -189,6 +309,7 @@ static void bt_gap_cb(esp_bt_gap_cb_event_t event, esp_bt_gap_cb_param_t *param)
         case ESP_BT_GAP_DISC_STATE_CHANGED_EVT:
             if (param->disc_st_chg.state == ESP_BT_GAP_DISCOVERY_STOPPED) {
                 ESP_LOGI(TAG, "Discovery stopped, found %d devices", s_status.device_count);
+                s_quick_scan = false;
                 if (s_status.state == BT_SOURCE_STATE_DISCOVERING) {
                     set_state(BT_SOURCE_STATE_IDLE);
                 }
@@ -241,11 +362,13 @@ static void bt_a2dp_source_cb(esp_a2d_cb_event_t event, esp_a2d_cb_param_t *para
             if (param->conn_stat.state == ESP_A2D_CONNECTION_STATE_CONNECTED) {
                 ESP_LOGI(TAG, "A2DP connected");
                 s_a2dp_connected = true;
+                bt_pacing_new_clock(&s_pacing);     // Inny głośnik - inny zegar
                 memcpy(s_peer_bda, param->conn_stat.remote_bda, 6);
 
                 // Update connected device info
                 if (xSemaphoreTake(s_status_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
                     memcpy(s_status.connected_device.bda, s_peer_bda, 6);
+                    s_status.connected_device.name[0] = '\0';  // Bez wyszukiwania - nazwa z cache
                     // Find name from discovered devices
                     for (int i = 0; i < s_status.device_count; i++) {
                         if (memcmp(s_status.devices[i].bda, s_peer_bda, 6) == 0) {
@@ -257,12 +380,24 @@ static void bt_a2dp_source_cb(esp_a2d_cb_event_t event, esp_a2d_cb_param_t *para
                     xSemaphoreGive(s_status_mutex);
                 }
 
+                s_reconnect_idx = -1;
+                s_status.reconnecting = false;
+                sinks_connected(s_peer_bda);
                 set_state(BT_SOURCE_STATE_CONNECTED);
+
+                // Strumień audio startuje dopiero po potwierdzeniu gotowości źródła
+                esp_a2d_media_ctrl(ESP_A2D_MEDIA_CTRL_CHECK_SRC_RDY);
             }
             else if (param->conn_stat.state == ESP_A2D_CONNECTION_STATE_DISCONNECTED) {
                 ESP_LOGI(TAG, "A2DP disconnected");
+                bool was_connected = s_a2dp_connected;
                 s_a2dp_connected = false;
                 set_state(BT_SOURCE_STATE_IDLE);
+                // Zapamiętany głośnik wyłączony lub poza zasięgiem - następny z listy
+                if (!was_connected && s_reconnect_idx >= 0) {
+                    s_reconnect_idx++;
+                    reconnect_next();
+                }
             }
             else if (param->conn_stat.state == ESP_A2D_CONNECTION_STATE_CONNECTING) {
                 ESP_LOGI(TAG, "A2DP connecting...");
@@ -276,26 +411,54 @@ static void bt_a2dp_source_cb(esp_a2d_cb_event_t event, esp_a2d_cb_param_t *para
 
         case ESP_A2D_AUDIO_STATE_EVT:
             if (param->audio_stat.state == ESP_A2D_AUDIO_STATE_STARTED) {
-                ESP_LOGI(TAG, "Audio streaming started");
-                set_state(BT_SOURCE_STATE_STREAMING);
+                // STREAMING dopiero po pre-rollu - zgłasza bt_source_write_audio()
+                ESP_LOGI(TAG, "Audio started, pre-roll %d ms", s_pacing.preroll_ms);
+                // Resztki poprzedniego strumienia nie wchodzą do pre-rollu
+                size_t stale;
+                uint8_t *item;
+                while ((item = xRingbufferReceiveUpTo(s_ringbuf, &stale, 0, BT_SOURCE_RINGBUF_SIZE)) != NULL) {
+                    vRingbufferReturnItem(s_ringbuf, item);
+                }
+                start_preroll();
             }
             else if (param->audio_stat.state == ESP_A2D_AUDIO_STATE_STOPPED ||
                      param->audio_stat.state == ESP_A2D_AUDIO_STATE_REMOTE_SUSPEND) {
                 ESP_LOGI(TAG, "Audio streaming stopped");
+                s_media_started = false;
+                s_pacing.prerolling = false;
                 if (s_a2dp_connected) {
                     set_state(BT_SOURCE_STATE_CONNECTED);
                 }
             }
             break;
 
-        case ESP_A2D_AUDIO_CFG_EVT:
+        case ESP_A2D_AUDIO_CFG_EVT: {
             ESP_LOGI(TAG, "Audio config: sample_rate=%d",
                      param->audio_cfg.mcc.cie.sbc_info.samp_freq);
+            // Kodek wynegocjowany z głośnikiem - do listy zapamiętanych
+            int freq = param->audio_cfg.mcc.cie.sbc_info.samp_freq;
+            if (xSemaphoreTake(s_status_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+                bt_sink_cache_entry_t *e = bt_sink_cache_find(&s_sinks, param->audio_cfg.remote_bda);
+                if (e) {
+                    e->sample_rate = (freq & 0x8) ? 16000 : (freq & 0x4) ? 32000 :
+                                     (freq & 0x1) ? 48000 : 44100;
+                    e->channels = (param->audio_cfg.mcc.cie.sbc_info.ch_mode & 0x8) ? 1 : 2;
+                    e->min_bitpool = param->audio_cfg.mcc.cie.sbc_info.min_bitpool;
+                    e->max_bitpool = param->audio_cfg.mcc.cie.sbc_info.max_bitpool;
+                    sinks_save();
+                }
+                xSemaphoreGive(s_status_mutex);
+            }
             break;
+        }
 
         case ESP_A2D_MEDIA_CTRL_ACK_EVT:
             ESP_LOGD(TAG, "Media control ACK: cmd=%d, status=%d",
                      param->media_ctrl_stat.cmd, param->media_ctrl_stat.status);
+            if (param->media_ctrl_stat.cmd == ESP_A2D_MEDIA_CTRL_CHECK_SRC_RDY &&
+                param->media_ctrl_stat.status == ESP_A2D_MEDIA_CTRL_ACK_SUCCESS && s_a2dp_connected) {
+                esp_a2d_media_ctrl(ESP_A2D_MEDIA_CTRL_START);
+            }
             break;
 
         default:
@@ -309,28 +472,55 @@ static void bt_a2dp_source_cb(esp_a2d_cb_event_t event, esp_a2d_cb_param_t *para
 // ============================================
 
 static int32_t s_audio_data_cb(uint8_t *data, int32_t len) {
-    if (s_ringbuf == NULL || data == NULL || len <= 0) {
-        // Return silence
+    if (data == NULL || len <= 0) {
+        return 0;
+    }
+    if (s_ringbuf == NULL || s_pacing.prerolling) {
         memset(data, 0, len);
         return len;
     }
 
-    size_t bytes_read = 0;
-    uint8_t *buf = xRingbufferReceiveUpTo(s_ringbuf, &bytes_read, 0, len);
-
-    if (buf && bytes_read > 0) {
-        memcpy(data, buf, bytes_read);
+    // Bufor bajtowy może zwrócić dane w dwóch kawałkach (zawinięcie) - drugi odczyt
+    size_t filled = 0;
+    for (int part = 0; part < 2 && filled < (size_t)len; part++) {
+        size_t bytes_read = 0;
+        uint8_t *buf = xRingbufferReceiveUpTo(s_ringbuf, &bytes_read, 0, len - filled);
+        if (buf == NULL) {
+            break;
+        }
+        memcpy(data + filled, buf, bytes_read);
         vRingbufferReturnItem(s_ringbuf, buf);
+        filled += bytes_read;
+    }
 
-        // Fill remaining with silence
-        if (bytes_read < len) {
-            memset(data + bytes_read, 0, len - bytes_read);
-        }
+    if (s_status.state != BT_SOURCE_STATE_STREAMING) {
+        memset(data + filled, 0, len - filled);
         return len;
     }
-
-    // No data available - return silence
-    memset(data, 0, len);
+    s_status.callbacks++;
+
+    bt_pacing_result_t result = bt_pacing_callback(&s_pacing, len, filled, ring_filled());
+    if (result == BT_PACING_STARVED) {
+        // Odtwarzacz stoi - nowy pre-roll (bt_pacing), STREAMING po jego zapełnieniu
+        memset(data + filled, 0, len - filled);
+        ESP_LOGW(TAG, "Audio starved, pre-roll again");
+        set_state(BT_SOURCE_STATE_CONNECTED);
+        return len;
+    }
+    if (result != BT_PACING_FULL) {
+        // Brak PCM od odtwarzacza - głośnik słyszy ciszę
+        memset(data + filled, 0, len - filled);
+        if (result == BT_PACING_PARTIAL) {
+            s_status.partial_callbacks++;
+        } else {
+            s_status.empty_callbacks++;
+        }
+        s_status.underruns++;
+        s_status.silence_ms += (len - filled + BT_SOURCE_BYTES_PER_MS / 2) / BT_SOURCE_BYTES_PER_MS;
+        pipeline_stats_underrun(PSTAT_BT);
+    }
+    s_status.fill_ms = (uint16_t)s_pacing.level_ms;
+    s_status.pacing_ppm = (int16_t)s_pacing.ppm;
     return len;
 }
 
@@ -394,10 +584,16 @@ esp_err_t bt_source_init(void) {
         }
     }
 
+    s_connect_start_us = esp_timer_get_time();
+    if (!s_sinks_loaded) {
+        sinks_load();
+    }
+
     // Initialize status
     memset(&s_status, 0, sizeof(s_status));
     s_status.state = BT_SOURCE_STATE_IDLE;
     s_status.volume = 100;
+    s_status.preroll_ms = s_pacing.preroll_ms;
 
     // Release BT classic memory for BLE if needed
     esp_err_t ret;
@@ -474,6 +670,18 @@ esp_err_t bt_source_init(void) {
 
     s_initialized = true;
     ESP_LOGI(TAG, "Bluetooth A2DP Source initialized");
+
+#if BT_SOURCE_AUTO_RECONNECT
+    // Znany głośnik bez wyszukiwania - strona (page) trwa ułamek sekundy zamiast 10+ s inquiry
+    if (bt_source_reconnect() == ESP_OK && BT_SOURCE_QUICK_SCAN_LEN > 0) {
+        bt_source_clear_devices();
+        s_quick_scan = true;
+        if (esp_bt_gap_start_discovery(ESP_BT_INQ_MODE_GENERAL_INQUIRY,
+                                       BT_SOURCE_QUICK_SCAN_LEN, 0) != ESP_OK) {
+            s_quick_scan = false;
+        }
+    }
+#endif
     return ESP_OK;
 }
 
@@ -510,6 +718,14 @@ esp_err_t bt_source_start_discovery(uint8_t duration_sec) {
 
     ESP_LOGI(TAG, "Starting device discovery for %d seconds", duration_sec);
 
+    // Użytkownik wybiera głośnik sam - koniec prób z listy zapamiętanych
+    s_reconnect_idx = -1;
+    s_status.reconnecting = false;
+    if (s_quick_scan) {
+        esp_bt_gap_cancel_discovery();
+        s_quick_scan = false;
+    }
+
     // Clear previous devices
     bt_source_clear_devices();
 
@@ -543,6 +759,24 @@ esp_err_t bt_source_connect(const uint8_t *bda) {
         return ESP_ERR_INVALID_ARG;
     }
 
+    s_reconnect_idx = -1;
+    s_status.reconnecting = false;
+    s_connect_start_us = esp_timer_get_time();
+    return connect_bda(bda);
+}
+
+esp_err_t bt_source_reconnect(void) {
+    if (!s_initialized || s_a2dp_connected) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (s_sinks.count == 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    s_reconnect_idx = 0;
+    return reconnect_next() ? ESP_OK : ESP_FAIL;
+}
+
+static esp_err_t connect_bda(const uint8_t *bda) {
     if (s_a2dp_connected) {
         ESP_LOGW(TAG, "Already connected, disconnect first");
         return ESP_ERR_INVALID_STATE;
@@ -617,6 +851,74 @@ bool bt_source_is_streaming(void) {
     return s_status.state == BT_SOURCE_STATE_STREAMING;
 }
 
+uint8_t bt_source_get_paired(bt_sink_cache_entry_t *sinks, uint8_t max_sinks) {
+    if (sinks == NULL || max_sinks == 0) {
+        return 0;
+    }
+    // Przed bt_source_init nie ma mutexu ani stosu BT - nikt inny nie zmienia listy
+    if (s_status_mutex && xSemaphoreTake(s_status_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return 0;
+    }
+    if (!s_sinks_loaded) {
+        sinks_load();
+    }
+    uint8_t count = 0;
+    const bt_sink_cache_entry_t *e;
+    while (count < max_sinks && (e = bt_sink_cache_nth_recent(&s_sinks, count)) != NULL) {
+        sinks[count++] = *e;
+    }
+    if (s_status_mutex) {
+        xSemaphoreGive(s_status_mutex);
+    }
+    return count;
+}
+
+esp_err_t bt_source_forget(const uint8_t *bda) {
+    if (bda == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_status_mutex && xSemaphoreTake(s_status_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+    if (!s_sinks_loaded) {
+        sinks_load();
+    }
+    bool removed = bt_sink_cache_remove(&s_sinks, bda);
+    if (removed) {
+        sinks_save();
+    }
+    if (s_status_mutex) {
+        xSemaphoreGive(s_status_mutex);
+    }
+    if (!removed) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    // Klucze parowania są w Bluedroid - bez niego zostają do następnego init
+    if (s_initialized) {
+        esp_bt_gap_remove_bond_device((uint8_t *)bda);
+    }
+    return ESP_OK;
+}
+
+bool bt_source_wants_audio(void) {
+    return s_media_started && s_a2dp_connected;
+}
+
+esp_err_t bt_source_set_preroll_ms(uint16_t ms) {
+    // Zapas ponad pre-roll na paczki z EQ i regulację tempa
+    const uint16_t max_ms = BT_SOURCE_RINGBUF_SIZE / BT_SOURCE_BYTES_PER_MS / 2;
+    if (ms < 10) ms = 10;
+    if (ms > max_ms) ms = max_ms;
+    s_pacing.preroll_ms = ms;
+    s_status.preroll_ms = ms;
+    return ESP_OK;
+}
+
+float bt_source_get_pacing_ppm(void) {
+    return s_status.state == BT_SOURCE_STATE_STREAMING ? s_pacing.ppm : 0.0f;
+}
+
 esp_err_t bt_source_set_volume(uint8_t volume) {
     if (volume > 127) {
         volume = 127;
@@ -678,11 +980,26 @@ int bt_source_write_audio(const uint8_t *data, size_t len) {
     }
 
     // Send to ring buffer
-    if (xRingbufferSend(s_ringbuf, data, len, pdMS_TO_TICKS(10)) == pdTRUE) {
-        return len;
+    if (xRingbufferSend(s_ringbuf, data, len, pdMS_TO_TICKS(10)) != pdTRUE) {
+        return 0;
     }
 
-    return 0;
+    if (s_pacing.prerolling && bt_pacing_written(&s_pacing, ring_filled())) {
+        if (s_connect_start_us) {
+            s_status.time_to_audio_ms = (uint32_t)((esp_timer_get_time() - s_connect_start_us) / 1000);
+            s_connect_start_us = 0;     // Ponowny pre-roll po przerwie to nie nowe połączenie
+            ESP_LOGI(TAG, "Time to audio: %lu ms", (unsigned long)s_status.time_to_audio_ms);
+        }
+        set_state(BT_SOURCE_STATE_STREAMING);
+    }
+    return len;
+}
+
+size_t bt_source_write_space(void) {
+    if (s_ringbuf == NULL || !s_a2dp_connected) {
+        return 0;
+    }
+    return xRingbufferGetCurFreeSize(s_ringbuf);
 }
 
 const char *bt_source_state_to_str(bt_source_state_t state) {
@@ -9,6 +9,8 @@
 #include "esp_err.h"
 #include <stdbool.h>
 #include <stdint.h>
+#include <stddef.h>
+#include "bt_sink_cache.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -45,6 +47,16 @@ typedef struct {
     uint8_t device_count;                     // Number of discovered devices
     uint8_t volume;                           // Current volume (0-127)
     char error_msg[64];                       // Error message if any
+    uint32_t underruns;                       // Data callbacks padded with silence while streaming
+    uint32_t callbacks;                       // Data callbacks while streaming
+    uint32_t partial_callbacks;               // Callbacks partly padded with silence
+    uint32_t empty_callbacks;                 // Callbacks with no PCM at all
+    uint32_t silence_ms;                      // Silence inserted by padding
+    uint16_t preroll_ms;                      // PCM buffered before reporting streaming
+    uint16_t fill_ms;                         // Averaged ring buffer fill
+    int16_t pacing_ppm;                       // Rate correction requested from the producer
+    bool reconnecting;                        // Connecting to a cached sink after init
+    uint32_t time_to_audio_ms;                // Last connect request (or init) to streaming
 } bt_source_status_t;
 
 // Callback for state changes
@@ -86,6 +98,28 @@ esp_err_t bt_source_stop_discovery(void);
  */
 esp_err_t bt_source_connect(const uint8_t *bda);
 
+/**
+ * @brief Connect to the most recently used cached sink without discovery
+ * @note Called by bt_source_init(); on failure the next cached sinks are tried
+ * @return ESP_OK if a connection attempt was started, ESP_ERR_NOT_FOUND if cache is empty
+ */
+esp_err_t bt_source_reconnect(void);
+
+/**
+ * @brief Get cached (previously connected) sinks, most recent first
+ * @param sinks Output array
+ * @param max_sinks Maximum entries to return
+ * @return Number of entries copied
+ */
+uint8_t bt_source_get_paired(bt_sink_cache_entry_t *sinks, uint8_t max_sinks);
+
+/**
+ * @brief Remove a sink from the cache and its bonding keys
+ * @param bda Bluetooth Device Address (6 bytes)
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if not cached
+ */
+esp_err_t bt_source_forget(const uint8_t *bda);
+
 /**
  * @brief Connect to a Bluetooth device by index from discovered list
  * @param device_index Index in the discovered devices list
@@ -125,10 +159,33 @@ bool bt_source_is_connected(void);
 
 /**
  * @brief Check if currently streaming
+ * @note Reported only after the pre-roll has been buffered
  * @return true if streaming audio
  */
 bool bt_source_is_streaming(void);
 
+/**
+ * @brief Check if the sink expects audio
+ * @note True from A2DP media start (pre-roll included) until stop - producers should write
+ * @return true if audio should be written
+ */
+bool bt_source_wants_audio(void);
+
+/**
+ * @brief Set the pre-roll buffered before streaming starts (and after starvation)
+ * @param ms Pre-roll in milliseconds, clamped to the ring buffer capacity
+ * @return ESP_OK on success
+ */
+esp_err_t bt_source_set_preroll_ms(uint16_t ms);
+
+/**
+ * @brief Rate correction for a producer not paced by the BT link
+ * @note Derived from the ring buffer fill trend around the pre-roll level.
+ *       Positive - ring is filling, produce fewer samples (resampler ppm convention).
+ * @return Correction in ppm
+ */
+float bt_source_get_pacing_ppm(void);
+
 /**
  * @brief Set volume for Bluetooth output
  * @param volume Volume level (0-127)
@@ -175,6 +232,13 @@ void bt_source_clear_devices(void);
  */
 int bt_source_write_audio(const uint8_t *data, size_t len);
 
+/**
+ * @brief Free space in the audio ring buffer
+ * @note Lets a producer paced by I2S write only what fits instead of blocking
+ * @return Bytes that can be written without waiting (0 when not connected)
+ */
+size_t bt_source_write_space(void);
+
 /**
  * @brief Get state name as string
  * @param state State enum value
@@ -0,0 +1,70 @@
+/*
+ * BT Pacing Module
+ * Pre-roll i regulator PI tempa producenta źródła A2DP
+ */
+
+#include "bt_pacing.h"
+
+void bt_pacing_init(bt_pacing_t *p, uint16_t preroll_ms)
+{
+    p->preroll_ms = preroll_ms;
+    p->prerolling = false;
+    p->starve_bytes = 0;
+    p->level_ms = preroll_ms;
+    p->integral = 0.0f;
+    p->ppm = 0.0f;
+}
+
+void bt_pacing_start_preroll(bt_pacing_t *p)
+{
+    p->level_ms = p->preroll_ms;
+    p->ppm = 0.0f;
+    p->starve_bytes = 0;
+    p->prerolling = true;
+}
+
+void bt_pacing_new_clock(bt_pacing_t *p)
+{
+    p->integral = 0.0f;
+    p->ppm = 0.0f;
+}
+
+bool bt_pacing_written(bt_pacing_t *p, size_t filled_bytes)
+{
+    if (p->prerolling && filled_bytes >= (size_t)p->preroll_ms * BT_PACING_BYTES_PER_MS) {
+        p->prerolling = false;
+        return true;
+    }
+    return false;
+}
+
+bt_pacing_result_t bt_pacing_callback(bt_pacing_t *p, size_t len, size_t got, size_t filled_bytes)
+{
+    bt_pacing_result_t result = BT_PACING_FULL;
+    if (got < len) {
+        p->starve_bytes = got ? len - got : p->starve_bytes + len;
+        if (p->starve_bytes >= BT_PACING_STARVE_MS * BT_PACING_BYTES_PER_MS) {
+            // Odtwarzacz stoi - dalsze puste callbacki to nie przerwy. Nowy pre-roll daje
+            // pełny zapas po wznowieniu.
+            bt_pacing_start_preroll(p);
+            return BT_PACING_STARVED;
+        }
+        result = got ? BT_PACING_PARTIAL : BT_PACING_EMPTY;
+    } else {
+        p->starve_bytes = 0;
+    }
+
+    // Trend zapełnienia wokół pre-rollu -> korekta tempa producenta
+    float dt_ms = (float)len / BT_PACING_BYTES_PER_MS;
+    float level_ms = (float)filled_bytes / BT_PACING_BYTES_PER_MS;
+    p->level_ms += (level_ms - p->level_ms) * dt_ms / (BT_PACING_LEVEL_TAU_MS + dt_ms);
+    float error_ms = p->level_ms - p->preroll_ms;
+    p->integral += BT_PACING_KI * error_ms * dt_ms / 1000.0f;
+    if (p->integral > BT_PACING_MAX_PPM) p->integral = BT_PACING_MAX_PPM;
+    if (p->integral < -BT_PACING_MAX_PPM) p->integral = -BT_PACING_MAX_PPM;
+    float ppm = BT_PACING_KP * error_ms + p->integral;
+    if (ppm > BT_PACING_MAX_PPM) ppm = BT_PACING_MAX_PPM;
+    if (ppm < -BT_PACING_MAX_PPM) ppm = -BT_PACING_MAX_PPM;
+    p->ppm = ppm;
+    return result;
+}
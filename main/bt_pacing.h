@@ -0,0 +1,56 @@
+/*
+ * BT Pacing Module
+ * Tempo producenta PCM dla źródła A2DP: głośnik pobiera dane w swoim takcie (callback
+ * danych), odtwarzacz pisze w takcie I2S. Pre-roll przed startem strumienia, klasyfikacja
+ * callbacków (pełny, częściowy, pusty, zagłodzony) i regulator PI, który z trendu
+ * zapełnienia bufora wylicza korektę ppm dla resamplera producenta.
+ *
+ * Zapełnienie bufora podaje wywołujący. Czyste C - można kompilować i sprawdzać na hoście.
+ */
+
+#ifndef BT_PACING_H
+#define BT_PACING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define BT_PACING_BYTES_PER_MS  (44100 * 4 / 1000)     // 44.1 kHz stereo 16 bit
+#define BT_PACING_STARVE_MS     100         // Dłuższy brak PCM - ponowny pre-roll zamiast liczenia
+#define BT_PACING_LEVEL_TAU_MS  1000        // Uśrednianie zapełnienia (paczki z EQ)
+#define BT_PACING_KP            50.0f       // ppm na ms odchyłki od pre-rollu
+#define BT_PACING_KI            0.625f      // ppm na ms*s - tłumienie krytyczne z KP
+#define BT_PACING_MAX_PPM       200.0f
+
+typedef enum {
+    BT_PACING_FULL,             // Callback dostał cały PCM
+    BT_PACING_PARTIAL,          // Część - reszta to cisza
+    BT_PACING_EMPTY,            // Sama cisza
+    BT_PACING_STARVED,          // Producent stoi - nowy pre-roll, cisza nie jest liczona
+} bt_pacing_result_t;
+
+typedef struct {
+    uint16_t preroll_ms;
+    volatile bool prerolling;   // Callback gra ciszę, aż bufor dojdzie do pre-rollu
+    uint32_t starve_bytes;      // Cisza z kolejnych pustych callbacków
+    float level_ms;             // Uśrednione zapełnienie bufora
+    float integral;             // Oszacowanie różnicy zegarów
+    volatile float ppm;         // Korekta tempa producenta (> 0 - pisać wolniej)
+} bt_pacing_t;
+
+void bt_pacing_init(bt_pacing_t *p, uint16_t preroll_ms);
+
+// Start strumienia lub wznowienie po zagłodzeniu: cisza do głośnika do pełnego pre-rollu
+void bt_pacing_start_preroll(bt_pacing_t *p);
+
+// Inny głośnik - inny zegar: oszacowanie od zera
+void bt_pacing_new_clock(bt_pacing_t *p);
+
+// Po zapisie producenta. true - bufor właśnie doszedł do pre-rollu, strumień gra.
+bool bt_pacing_written(bt_pacing_t *p, size_t filled_bytes);
+
+// Callback danych: len żądanych bajtów, got z nich pobrane z bufora, filled_bytes zostało
+// w buforze. Aktualizuje korektę tempa (poza BT_PACING_STARVED).
+bt_pacing_result_t bt_pacing_callback(bt_pacing_t *p, size_t len, size_t got, size_t filled_bytes);
+
+#endif // BT_PACING_H
@@ -0,0 +1,88 @@
+/*
+ * BT Sink Cache Module
+ * Tablica zapamiętanych głośników uporządkowana numerem ostatniego połączenia
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "bt_sink_cache.h"
+
+void bt_sink_cache_init(bt_sink_cache_t *cache)
+{
+    memset(cache, 0, sizeof(*cache));
+    cache->version = BT_SINK_CACHE_VERSION;
+}
+
+bool bt_sink_cache_validate(bt_sink_cache_t *cache)
+{
+    if (cache->version != BT_SINK_CACHE_VERSION || cache->count > BT_SINK_CACHE_MAX) {
+        bt_sink_cache_init(cache);
+        return false;
+    }
+    for (int i = 0; i < cache->count; i++) {
+        bt_sink_cache_entry_t *e = &cache->entries[i];
+        e->name[BT_SINK_CACHE_NAME_LEN - 1] = '\0';
+        if (e->seq > cache->seq) cache->seq = e->seq;
+    }
+    return true;
+}
+
+bt_sink_cache_entry_t *bt_sink_cache_find(bt_sink_cache_t *cache, const uint8_t *bda)
+{
+    for (int i = 0; i < cache->count; i++) {
+        if (memcmp(cache->entries[i].bda, bda, 6) == 0) {
+            return &cache->entries[i];
+        }
+    }
+    return NULL;
+}
+
+bt_sink_cache_entry_t *bt_sink_cache_touch(bt_sink_cache_t *cache, const uint8_t *bda, const char *name)
+{
+    bt_sink_cache_entry_t *e = bt_sink_cache_find(cache, bda);
+    if (e == NULL) {
+        if (cache->count < BT_SINK_CACHE_MAX) {
+            e = &cache->entries[cache->count++];
+        } else {
+            e = &cache->entries[0];
+            for (int i = 1; i < cache->count; i++) {
+                if (cache->entries[i].seq < e->seq) e = &cache->entries[i];
+            }
+        }
+        memset(e, 0, sizeof(*e));
+        memcpy(e->bda, bda, 6);
+    }
+    if (name && name[0]) {
+        snprintf(e->name, sizeof(e->name), "%s", name);
+    }
+    e->seq = ++cache->seq;
+    return e;
+}
+
+const bt_sink_cache_entry_t *bt_sink_cache_nth_recent(const bt_sink_cache_t *cache, int n)
+{
+    // Najwyżej 8 wpisów - wybór n-tego największego bez sortowania tablicy
+    uint32_t below = UINT32_MAX;
+    const bt_sink_cache_entry_t *found = NULL;
+    for (int k = 0; k <= n; k++) {
+        found = NULL;
+        for (int i = 0; i < cache->count; i++) {
+            const bt_sink_cache_entry_t *e = &cache->entries[i];
+            if (e->seq < below && (found == NULL || e->seq > found->seq)) {
+                found = e;
+            }
+        }
+        if (found == NULL) return NULL;
+        below = found->seq;
+    }
+    return found;
+}
+
+bool bt_sink_cache_remove(bt_sink_cache_t *cache, const uint8_t *bda)
+{
+    bt_sink_cache_entry_t *e = bt_sink_cache_find(cache, bda);
+    if (e == NULL) return false;
+    *e = cache->entries[--cache->count];
+    memset(&cache->entries[cache->count], 0, sizeof(*e));
+    return true;
+}
@@ -0,0 +1,54 @@
+/*
+ * BT Sink Cache Module
+ * Zapamiętane głośniki Bluetooth (A2DP source): adres, nazwa, ostatnie RSSI i negocjowany
+ * kodek. Po starcie łączymy się od razu z ostatnio używanym głośnikiem zamiast czekać na
+ * pełne wyszukiwanie. Klucze parowania trzyma Bluedroid - tu tylko to, czego nie pamięta.
+ *
+ * Cała tablica zapisywana jako jeden blob (NVS w bluetooth_source.c).
+ * Czyste C - można kompilować i sprawdzać na hoście.
+ */
+
+#ifndef BT_SINK_CACHE_H
+#define BT_SINK_CACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define BT_SINK_CACHE_MAX       8       // Najdawniej używany głośnik wypierany
+#define BT_SINK_CACHE_NAME_LEN  64
+#define BT_SINK_CACHE_VERSION   1
+
+typedef struct {
+    uint8_t bda[6];
+    char name[BT_SINK_CACHE_NAME_LEN];
+    int8_t rssi;                    // 0 - nieznane (głośnik nie widziany w wyszukiwaniu)
+    uint8_t channels;               // Kodek z ostatniego połączenia (0 - nieznany)
+    uint16_t sample_rate;
+    uint8_t min_bitpool;
+    uint8_t max_bitpool;
+    uint32_t seq;                   // Numer ostatniego połączenia - najwyższy to najnowszy
+} bt_sink_cache_entry_t;
+
+typedef struct {
+    uint8_t version;
+    uint8_t count;
+    uint32_t seq;
+    bt_sink_cache_entry_t entries[BT_SINK_CACHE_MAX];
+} bt_sink_cache_t;
+
+void bt_sink_cache_init(bt_sink_cache_t *cache);
+
+// Sprawdza blob odczytany z pamięci; false - inna wersja lub uszkodzony (cache wyzerowany)
+bool bt_sink_cache_validate(bt_sink_cache_t *cache);
+
+bt_sink_cache_entry_t *bt_sink_cache_find(bt_sink_cache_t *cache, const uint8_t *bda);
+
+// Udane połączenie: głośnik staje się najnowszym (dodany, gdy go nie było). name może być NULL.
+bt_sink_cache_entry_t *bt_sink_cache_touch(bt_sink_cache_t *cache, const uint8_t *bda, const char *name);
+
+// Kolejność prób połączenia: n-ty głośnik od najnowszego; NULL - brak
+const bt_sink_cache_entry_t *bt_sink_cache_nth_recent(const bt_sink_cache_t *cache, int n);
+
+bool bt_sink_cache_remove(bt_sink_cache_t *cache, const uint8_t *bda);
+
+#endif // BT_SINK_CACHE_H
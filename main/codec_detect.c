@@ -0,0 +1,232 @@
+/*
+ * Codec Detection Module
+ * Rozpoznawanie formatu strumienia po synchronizacji ramki (MP3 / AAC ADTS / M4A)
+ */
+
+#include <string.h>
+#include <strings.h>
+#include "codec_detect.h"
+
+// Tabele bitrate MP3 (kbps), indeks 0 = free format (nieobsługiwany)
+static const uint16_t mp3_bitrate_v1[3][15] = {
+    {0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448},  // Layer I
+    {0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384},     // Layer II
+    {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320},      // Layer III
+};
+static const uint16_t mp3_bitrate_v2[3][15] = {
+    {0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256},     // Layer I
+    {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160},          // Layer II
+    {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160},          // Layer III
+};
+static const uint32_t mp3_samplerate_v1[3] = {44100, 48000, 32000};
+
+static const uint32_t adts_samplerate[13] = {
+    96000, 88200, 64000, 48000, 44100, 32000, 24000, 22050, 16000, 12000, 11025, 8000, 7350
+};
+
+// Minimalna liczba bajtów potrzebna do odczytu nagłówka ramki
+#define FRAME_HEADER_MIN    7
+
+// ============================================
+// Nagłówki ramek
+// ============================================
+
+// Parsuje nagłówek MP3 (MPEG 1/2/2.5, Layer I-III). Zwraca długość ramki lub 0.
+static int parse_mp3_header(const uint8_t *p, codec_frame_info_t *info)
+{
+    if (p[0] != 0xFF || (p[1] & 0xE0) != 0xE0) return 0;
+
+    int version = (p[1] >> 3) & 0x03;   // 0 = 2.5, 1 = reserved, 2 = MPEG2, 3 = MPEG1
+    int layer = (p[1] >> 1) & 0x03;     // 1 = III, 2 = II, 3 = I
+    int br_idx = p[2] >> 4;
+    int sr_idx = (p[2] >> 2) & 0x03;
+    int padding = (p[2] >> 1) & 0x01;
+
+    if (version == 1 || layer == 0 || br_idx == 0 || br_idx == 15 || sr_idx == 3) {
+        return 0;
+    }
+
+    int layer_idx = 3 - layer;          // 0 = I, 1 = II, 2 = III
+    int bitrate = (version == 3) ? mp3_bitrate_v1[layer_idx][br_idx]
+                                 : mp3_bitrate_v2[layer_idx][br_idx];
+    int sample_rate = mp3_samplerate_v1[sr_idx] >> (version == 3 ? 0 : (version == 2 ? 1 : 2));
+
+    int frame_len;
+    if (layer_idx == 0) {
+        frame_len = (12 * bitrate * 1000 / sample_rate + padding) * 4;
+    } else if (layer_idx == 2 && version != 3) {
+        frame_len = 72 * bitrate * 1000 / sample_rate + padding;
+    } else {
+        frame_len = 144 * bitrate * 1000 / sample_rate + padding;
+    }
+
+    if (info) {
+        info->frame_len = frame_len;
+        info->sample_rate = sample_rate;
+        info->channels = ((p[3] >> 6) == 3) ? 1 : 2;
+        info->bitrate_kbps = bitrate;
+    }
+    return frame_len;
+}
+
+// Parsuje nagłówek ADTS (AAC-LC / HE-AAC). Zwraca długość ramki lub 0.
+static int parse_adts_header(const uint8_t *p, codec_frame_info_t *info)
+{
+    if (p[0] != 0xFF || (p[1] & 0xF6) != 0xF0) return 0;
+
+    int sr_idx = (p[2] >> 2) & 0x0F;
+    int channels = ((p[2] & 0x01) << 2) | (p[3] >> 6);
+    int frame_len = ((p[3] & 0x03) << 11) | (p[4] << 3) | (p[5] >> 5);
+    int header_len = (p[1] & 0x01) ? 7 : 9;
+
+    if (sr_idx >= 13 || frame_len <= header_len) {
+        return 0;
+    }
+
+    if (info) {
+        int sample_rate = adts_samplerate[sr_idx];
+        info->frame_len = frame_len;
+        info->sample_rate = sample_rate;
+        info->channels = channels ? channels : 2;
+        // 1024 próbki na ramkę (dla HE-AAC - próbki rdzenia, więc wynik nadal poprawny)
+        info->bitrate_kbps = (int)((int64_t)frame_len * 8 * sample_rate / 1024 / 1000);
+    }
+    return frame_len;
+}
+
+// Czy dwa nagłówki MP3 należą do tego samego strumienia (wersja, warstwa, częstotliwość)
+static bool mp3_headers_match(const uint8_t *a, const uint8_t *b)
+{
+    return (a[1] & 0xFE) == (b[1] & 0xFE) && (a[2] & 0x0C) == (b[2] & 0x0C);
+}
+
+// Czy dwa nagłówki ADTS mają ten sam profil i częstotliwość
+static bool adts_headers_match(const uint8_t *a, const uint8_t *b)
+{
+    return (a[1] & 0xF6) == (b[1] & 0xF6) && (a[2] & 0xFC) == (b[2] & 0xFC);
+}
+
+// Rozmiar tagu ID3v2 na początku strumienia (0 jeśli brak)
+static int id3v2_size(const uint8_t *buf, int len)
+{
+    if (len < 10 || memcmp(buf, "ID3", 3) != 0) return 0;
+
+    int size = ((buf[6] & 0x7F) << 21) | ((buf[7] & 0x7F) << 14) |
+               ((buf[8] & 0x7F) << 7) | (buf[9] & 0x7F);
+    size += 10;
+    if (buf[5] & 0x10) {
+        size += 10;     // Stopka
+    }
+    return size;
+}
+
+// ============================================
+// Publiczne API
+// ============================================
+
+esp_codec_type_t codec_detect_probe(const uint8_t *buf, int len, codec_frame_info_t *info)
+{
+    if (buf == NULL || len < FRAME_HEADER_MIN) {
+        return ESP_CODEC_TYPE_UNKNOW;
+    }
+
+    int start = id3v2_size(buf, len);
+    if (start + FRAME_HEADER_MIN > len) {
+        // Tag ID3 większy niż bufor - decyzję podejmie Content-Type
+        return ESP_CODEC_TYPE_UNKNOW;
+    }
+
+    // Kontener MP4: box 'ftyp' (lub 'styp' dla fragmentów) na początku
+    if (start + 8 <= len &&
+        (memcmp(buf + start + 4, "ftyp", 4) == 0 || memcmp(buf + start + 4, "styp", 4) == 0)) {
+        if (info) {
+            memset(info, 0, sizeof(*info));
+            info->offset = start;
+        }
+        return ESP_CODEC_TYPE_M4A;
+    }
+
+    codec_frame_info_t frame = {0};
+    for (int i = start; i + FRAME_HEADER_MIN <= len; i++) {
+        if (buf[i] != 0xFF) continue;
+
+        esp_codec_type_t codec = ESP_CODEC_TYPE_UNKNOW;
+        int frame_len = parse_adts_header(buf + i, &frame);
+        if (frame_len > 0) {
+            codec = ESP_CODEC_TYPE_AAC;
+        } else {
+            frame_len = parse_mp3_header(buf + i, &frame);
+            if (frame_len > 0) codec = ESP_CODEC_TYPE_MP3;
+        }
+        if (codec == ESP_CODEC_TYPE_UNKNOW) continue;
+
+        // Potwierdzenie: następna ramka musi zaczynać się zgodnym nagłówkiem.
+        // Jeśli nie mieści się w buforze, akceptujemy tylko ramkę na samym początku.
+        int next = i + frame_len;
+        bool confirmed;
+        if (next + FRAME_HEADER_MIN <= len) {
+            confirmed = (codec == ESP_CODEC_TYPE_AAC)
+                        ? adts_headers_match(buf + i, buf + next)
+                        : mp3_headers_match(buf + i, buf + next);
+        } else {
+            confirmed = (i == start);
+        }
+        if (!confirmed) continue;
+
+        if (info) {
+            frame.offset = i;
+            *info = frame;
+        }
+        return codec;
+    }
+
+    return ESP_CODEC_TYPE_UNKNOW;
+}
+
+esp_codec_type_t codec_detect_file(const uint8_t *buf, int len, const char *path)
+{
+    if (buf && len >= 12) {
+        if (memcmp(buf, "fLaC", 4) == 0) return ESP_CODEC_TYPE_FLAC;
+        if (memcmp(buf, "RIFF", 4) == 0 && memcmp(buf + 8, "WAVE", 4) == 0) return ESP_CODEC_TYPE_WAV;
+        if (memcmp(buf, "OggS", 4) == 0) return ESP_CODEC_TYPE_OGG;
+    }
+
+    // Tag ID3v2 (okładka potrafi mieć setki KB) - synchronizacja ramek w nagłówku
+    // dałaby fałszywe trafienia, decyduje rozszerzenie
+    bool id3 = buf && len >= 3 && memcmp(buf, "ID3", 3) == 0;
+    esp_codec_type_t codec = id3 ? ESP_CODEC_TYPE_UNKNOW : codec_detect_probe(buf, len, NULL);
+    if (codec != ESP_CODEC_TYPE_UNKNOW || path == NULL) {
+        return id3 ? ESP_CODEC_TYPE_MP3 : codec;
+    }
+
+    const char *ext = strrchr(path, '.');
+    if (ext == NULL) return id3 ? ESP_CODEC_TYPE_MP3 : ESP_CODEC_TYPE_UNKNOW;
+    if (strcasecmp(ext, ".mp3") == 0) return ESP_CODEC_TYPE_MP3;
+    if (strcasecmp(ext, ".aac") == 0) return ESP_CODEC_TYPE_AAC;
+    if (strcasecmp(ext, ".m4a") == 0) return ESP_CODEC_TYPE_M4A;
+    if (strcasecmp(ext, ".flac") == 0) return ESP_CODEC_TYPE_FLAC;
+    if (strcasecmp(ext, ".wav") == 0) return ESP_CODEC_TYPE_WAV;
+    if (strcasecmp(ext, ".ogg") == 0) return ESP_CODEC_TYPE_OGG;
+    return id3 ? ESP_CODEC_TYPE_MP3 : ESP_CODEC_TYPE_UNKNOW;
+}
+
+bool codec_detect_is_aac_family(esp_codec_type_t codec)
+{
+    return codec == ESP_CODEC_TYPE_AAC ||
+           codec == ESP_CODEC_TYPE_M4A ||
+           codec == ESP_CODEC_TYPE_TSAAC;
+}
+
+const char *codec_detect_name(esp_codec_type_t codec)
+{
+    switch (codec) {
+        case ESP_CODEC_TYPE_MP3:    return "mp3";
+        case ESP_CODEC_TYPE_AAC:    return "aac";
+        case ESP_CODEC_TYPE_M4A:    return "m4a";
+        case ESP_CODEC_TYPE_TSAAC:  return "ts-aac";
+        case ESP_CODEC_TYPE_FLAC:   return "flac";
+        case ESP_CODEC_TYPE_WAV:    return "wav";
+        case ESP_CODEC_TYPE_OGG:    return "ogg";
+        default:                    return "unknown";
+    }
+}
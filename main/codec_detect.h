@@ -0,0 +1,44 @@
+/*
+ * Codec Detection Module
+ * Rozpoznawanie formatu strumienia po synchronizacji ramki (MP3 / AAC ADTS / M4A)
+ * oraz formatu pliku po sygnaturze i rozszerzeniu (także FLAC / WAV / OGG)
+ */
+
+#ifndef CODEC_DETECT_H
+#define CODEC_DETECT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "audio_common.h"
+
+// ============================================
+// Parametry pierwszej rozpoznanej ramki
+// ============================================
+typedef struct {
+    int offset;             // Pozycja nagłówka ramki w buforze (po tagu ID3)
+    int frame_len;          // Długość ramki w bajtach (0 dla M4A)
+    int sample_rate;        // Hz
+    int channels;
+    int bitrate_kbps;       // MP3: z nagłówka, AAC: oszacowane z długości ramki
+} codec_frame_info_t;
+
+// ============================================
+// Detekcja
+// ============================================
+
+// Szuka synchronizacji ramki w pierwszych bajtach strumienia.
+// Zwraca ESP_CODEC_TYPE_MP3, ESP_CODEC_TYPE_AAC (ADTS, także HE-AAC),
+// ESP_CODEC_TYPE_M4A albo ESP_CODEC_TYPE_UNKNOW. info może być NULL.
+esp_codec_type_t codec_detect_probe(const uint8_t *buf, int len, codec_frame_info_t *info);
+
+// Format pliku z karty SD: sygnatura (fLaC, RIFF/WAVE, OggS), synchronizacja ramki,
+// a gdy początek pliku nic nie mówi (np. duży tag ID3 z okładką) - rozszerzenie ścieżki
+esp_codec_type_t codec_detect_file(const uint8_t *buf, int len, const char *path);
+
+// Czy dany format jest dekodowany przez dekoder AAC (AAC, M4A, TS-AAC)
+bool codec_detect_is_aac_family(esp_codec_type_t codec);
+
+// Nazwa formatu do logów / diagnostyki
+const char *codec_detect_name(esp_codec_type_t codec);
+
+#endif // CODEC_DETECT_H
@@ -29,6 +29,10 @@
 // ============================================
 #define HEADPHONE_DETECT_GPIO       19      // GPIO19 - headphone jack detect
 #define AUX_DETECT_GPIO             21      // GPIO21 - AUX jack detect (DIP SW7 = ON)
+#define AUX_SAMPLE_RATE             44100   // ADC i DAC na wspólnym zegarze I2S
+#define AUX_AUTO_SWITCH             1       // Sygnał na wejściu AUX przełącza odtwarzacz na AUX
+#define AUX_SIGNAL_THRESHOLD_DB     -45     // RMS (dBFS, po wzmocnieniu) uznawany za sygnał
+#define AUX_SILENCE_MS              10000   // Cisza na AUX - powrót do poprzedniego źródła
 
 // ============================================
 // Monitorowanie baterii (wymaga modyfikacji HW)
@@ -45,12 +49,28 @@
 // ============================================
 #define BT_DEVICE_NAME              DEVICE_NAME
 #define BT_DISCOVERABLE_TIMEOUT     300     // Sekund (0 = zawsze widoczny)
+#define BT_SOURCE_PREROLL_MS        40      // PCM w buforze A2DP przed startem strumienia do głośnika
+#define BT_SOURCE_AUTO_RECONNECT    1       // Po bt_source_init łącz z ostatnio używanym głośnikiem
+#define BT_SOURCE_RECONNECT_TRIES   3       // Zapamiętane głośniki próbowane po kolei (od najnowszego)
+// Krótkie wyszukiwanie równolegle z szybkim łączeniem (x 1.28 s, 0 - wyłączone).
+// Wyszukiwanie dzieli radio ze stronicowaniem i opóźnia samo połączenie.
+#define BT_SOURCE_QUICK_SCAN_LEN    0
 
 // ============================================
 // Konfiguracja karty SD
 // ============================================
 #define SD_MOUNT_POINT              "/sdcard"
 #define SD_MAX_FILES                5
+#define MEDIA_INDEX_ENABLED         1       // Indeks tagów biblioteki (skan w tle)
+#define MEDIA_INDEX_FILE            SD_MOUNT_POINT "/.media_index"
+#define MEDIA_SEEK_DIR              SD_MOUNT_POINT "/.media_seek"  // Tabele ramek MP3 VBR
+#define SD_BOOKMARK_JOURNAL         SD_MOUNT_POINT "/.media_bookmarks"  // Zakładki długich plików
+#define SD_BOOKMARK_MIN_LENGTH_MS   (20 * 60 * 1000)    // Zakładka dla plików od 20 minut
+#define SD_BOOKMARK_MIN_FILE_SIZE   (20 * 1024 * 1024)  // Długość nieznana (bez indeksu) - rozmiar
+#define SD_BOOKMARK_SAVE_MS         30000   // Najczęstszy zapis w trakcie odtwarzania
+#define SD_BOOKMARK_END_MS          30000   // Zatrzymany tuż przed końcem - plik odegrany
+#define SD_BOOKMARK_REWIND_MS       3000    // Wznowienie kilka sekund przed zakładką
+#define SD_POSITION_POLL_MS         1000    // Odświeżanie pozycji odtwarzacza SD
 
 // ============================================
 // Konfiguracja Audio
@@ -59,6 +79,15 @@
 #define MAX_VOLUME 100
 #define MIN_VOLUME 0
 
+// Warm standby - drugi strumień HTTP połączony z następną stacją (szybkie przełączanie)
+// Budżet PSRAM: STANDBY_BUFFER_KB (bufor HTTP) + 64KB PCM. Sloty zamieniają się rolami,
+// więc po przełączeniu stacja gra z mniejszego bufora do następnego zimnego startu.
+#define STANDBY_STREAM_ENABLED 1
+#define STANDBY_BUFFER_KB 128
+
+// Korekta dryfu zegara serwera radia względem I2S (resampler ±kilka ppm w etapie wyjściowym)
+#define DRIFT_CORRECTION_ENABLED 1
+
 // ============================================
 // Konfiguracja Web Server
 // ============================================
@@ -78,6 +107,7 @@
 #define MQTT_TOPIC_STATE_STATIONS   MQTT_TOPIC_BASE "/state/stations"
 #define MQTT_TOPIC_STATE_ALARMS     MQTT_TOPIC_BASE "/state/alarms"
 #define MQTT_TOPIC_AVAILABILITY     MQTT_TOPIC_BASE "/availability"
+#define MQTT_TOPIC_TELEMETRY        MQTT_TOPIC_BASE "/telemetry"     // Binarnie, pipeline_stats_pack()
 
 // Komendy (HA -> ESP32)
 #define MQTT_TOPIC_CMD              MQTT_TOPIC_BASE "/cmd"
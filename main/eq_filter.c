@@ -0,0 +1,535 @@
+/*
+ * Fixed-point 10-band Equalizer Element
+ *
+ * Zamiennik elementu `equalizer` z ESP-ADF (który zużywał ~28% CPU).
+ * Każde pasmo to filtr peaking (RBJ cookbook) w postaci Direct Form I:
+ *  - współczynniki Q28 w int32 (zakres ±8, dokładność wystarczająca dla 31 Hz),
+ *  - próbki Q31, iloczyny 32x32 -> 64 bity (MULL + MULSH na Xtensa),
+ *  - akumulacja Q59 w 64 bitach, wynik Q27 (zapas ±16, bez przepełnień pośrednich),
+ *  - kształtowanie błędu pierwszego rzędu: odcięte młodsze bity wyniku wracają do
+ *    sumy w następnej próbce. Samo obcięcie (>> 32) w pętli sprzężenia dawało
+ *    przesunięcie DC rzędu dziesiątek LSB przy pasmach basowych (biegun tuż przy 1).
+ *
+ * Współczynniki liczone są tylko przy zmianie pasma/formatu, poza zadaniem audio.
+ * Płaskie pasma (0 dB) są usuwane z kaskady przy przeliczaniu, więc pętla
+ * próbek nie ma żadnych rozgałęzień. Bufor pozostaje przeplatany (L/R),
+ * każda sekcja przechodzi cały blok dla jednego kanału ze stride = channels.
+ */
+
+#include <string.h>
+#include <math.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
+#include "sdkconfig.h"
+
+#include "audio_element.h"
+#include "audio_common.h"
+#include "eq_filter.h"
+
+static const char *TAG = "EQ_FILTER";
+
+#define EQ_FILTER_BUF_SIZE      (4096)      // Bajty na jedno wywołanie process (1024 ramki stereo)
+#define EQ_FILTER_Q             1.41        // Szerokość pasma ~1 oktawa
+#define EQ_COEF_SHIFT           28          // Współczynniki Q28
+#define EQ_MAX_FREQ_RATIO       0.45f       // Pasma powyżej 0.45 * fs są pomijane
+#define EQ_LOAD_WINDOW_MS       1000        // Okno uśredniania obciążenia CPU
+
+// Współczynniki jednej sekcji (a1, a2 już zanegowane - sama suma w pętli)
+typedef struct {
+    int32_t b0, b1, b2, a1, a2;
+} eq_biquad_coef_t;
+
+typedef struct {
+    int32_t x1, x2, y1, y2;
+    uint32_t err;                           // Odcięte bity Q59 poprzedniego wyniku
+} eq_biquad_state_t;
+
+// Kaskada dla jednego kanału - tylko aktywne pasma, w kolejności
+typedef struct {
+    eq_biquad_coef_t coef[EQ_FILTER_BANDS];
+    uint8_t band[EQ_FILTER_BANDS];          // Indeks pasma dla stanu
+    int count;
+} eq_cascade_t;
+
+// Parametry, z których liczona jest kaskada (kopia pod blokadą)
+typedef struct {
+    int gain[EQ_FILTER_CHANNELS][EQ_FILTER_BANDS];
+    int sample_rate;
+    int channels;
+    uint32_t seq;                           // Numer zmiany - starsza kopia nie nadpisze nowszej
+} eq_params_t;
+
+typedef struct {
+    // Parametry (zapisywane z zadań sterujących pod lock)
+    int gain[EQ_FILTER_CHANNELS][EQ_FILTER_BANDS];
+    int freq[EQ_FILTER_BANDS];
+    int sample_rate;
+    int channels;
+    uint32_t params_seq;
+
+    // Kaskada używana przez zadanie audio
+    eq_cascade_t cascade[EQ_FILTER_CHANNELS];
+    eq_biquad_state_t state[EQ_FILTER_CHANNELS][EQ_FILTER_BANDS];
+    int active_channels;
+
+    // Kaskada przygotowana przez setter, podmieniana na początku bloku
+    eq_cascade_t pending[EQ_FILTER_CHANNELS];
+    int pending_channels;
+    uint32_t pending_seq;
+    volatile bool has_pending;
+    portMUX_TYPE lock;
+
+    // Bufor roboczy Q31 (wewnętrzny RAM - pętla jest gorąca)
+    int32_t *work;
+
+    // Niepełna ramka z końca poprzedniego odczytu
+    uint8_t carry[EQ_FILTER_CHANNELS * sizeof(int16_t)];
+    int carry_len;
+
+    // Pomiar obciążenia CPU
+    uint32_t cycles_acc;
+    uint32_t frames_acc;
+    int load_permille;
+} eq_filter_t;
+
+// ============================================
+// Współczynniki
+// ============================================
+
+static inline int32_t to_q28(double v)
+{
+    return (int32_t)lrint(v * (double)(1 << EQ_COEF_SHIFT));
+}
+
+// Peaking EQ (RBJ Audio EQ Cookbook), znormalizowany przez a0.
+// W double: float (24 bity mantysy) jest grubszy niż Q28 i przy niskich pasmach
+// dokładał więcej błędu niż sama arytmetyka stałoprzecinkowa. Liczone tylko przy zmianie.
+static bool compute_peaking(eq_biquad_coef_t *c, int freq, int gain_db, int sample_rate)
+{
+    if (gain_db == 0 || sample_rate <= 0 || freq >= sample_rate * EQ_MAX_FREQ_RATIO) {
+        return false;
+    }
+
+    double a = pow(10.0, gain_db / 40.0);
+    double w0 = 2.0 * M_PI * freq / sample_rate;
+    double cs = cos(w0);
+    double alpha = sin(w0) / (2.0 * EQ_FILTER_Q);
+
+    double a0 = 1.0 + alpha / a;
+    c->b0 = to_q28((1.0 + alpha * a) / a0);
+    c->b1 = to_q28((-2.0 * cs) / a0);
+    c->b2 = to_q28((1.0 - alpha * a) / a0);
+    c->a1 = to_q28((2.0 * cs) / a0);                // -a1
+    c->a2 = to_q28(-(1.0 - alpha / a) / a0);        // -a2
+    return true;
+}
+
+static void build_cascades(const int *freq, const eq_params_t *p, eq_cascade_t *out, int *out_channels)
+{
+    int channels = p->channels > EQ_FILTER_CHANNELS ? EQ_FILTER_CHANNELS : p->channels;
+    if (channels < 1) channels = 1;
+
+    for (int ch = 0; ch < channels; ch++) {
+        eq_cascade_t *cas = &out[ch];
+        cas->count = 0;
+        for (int b = 0; b < EQ_FILTER_BANDS; b++) {
+            if (compute_peaking(&cas->coef[cas->count], freq[b],
+                                p->gain[ch][b], p->sample_rate)) {
+                cas->band[cas->count] = b;
+                cas->count++;
+            }
+        }
+    }
+    *out_channels = channels;
+}
+
+// Kopia parametrów - wołane pod eq->lock
+static void snapshot_params(eq_filter_t *eq, eq_params_t *p)
+{
+    memcpy(p->gain, eq->gain, sizeof(p->gain));
+    p->sample_rate = eq->sample_rate;
+    p->channels = eq->channels;
+    p->seq = ++eq->params_seq;
+}
+
+// Wywoływane z zadań sterujących po zmianie parametrów (pod lock): współczynniki
+// liczone z kopii, poza blokadą i poza zadaniem audio. Dwa równoległe settery mogą
+// skończyć liczenie w dowolnej kolejności - publikowana jest tylko nowsza kopia.
+static void publish_coefficients(eq_filter_t *eq)
+{
+    eq_params_t params;
+    portENTER_CRITICAL(&eq->lock);
+    snapshot_params(eq, &params);
+    portEXIT_CRITICAL(&eq->lock);
+
+    eq_cascade_t next[EQ_FILTER_CHANNELS];
+    int channels;
+    build_cascades(eq->freq, &params, next, &channels);
+
+    portENTER_CRITICAL(&eq->lock);
+    if ((int32_t)(params.seq - eq->pending_seq) > 0) {
+        memcpy(eq->pending, next, sizeof(next));
+        eq->pending_channels = channels;
+        eq->pending_seq = params.seq;
+        eq->has_pending = true;
+    }
+    portEXIT_CRITICAL(&eq->lock);
+}
+
+// Wywoływane z zadania audio na granicy bloku
+static void apply_pending(eq_filter_t *eq)
+{
+    if (!eq->has_pending) {
+        return;
+    }
+
+    bool was_active[EQ_FILTER_CHANNELS][EQ_FILTER_BANDS] = {0};
+    for (int ch = 0; ch < eq->active_channels; ch++) {
+        for (int i = 0; i < eq->cascade[ch].count; i++) {
+            was_active[ch][eq->cascade[ch].band[i]] = true;
+        }
+    }
+
+    portENTER_CRITICAL(&eq->lock);
+    memcpy(eq->cascade, eq->pending, sizeof(eq->cascade));
+    eq->active_channels = eq->pending_channels;
+    eq->has_pending = false;
+    portEXIT_CRITICAL(&eq->lock);
+
+    // Pasma włączone na nowo startują z czystym stanem, pozostałe zachowują
+    // historię - brak trzasków przy przesuwaniu suwaka
+    for (int ch = 0; ch < eq->active_channels; ch++) {
+        for (int i = 0; i < eq->cascade[ch].count; i++) {
+            int b = eq->cascade[ch].band[i];
+            if (!was_active[ch][b]) {
+                memset(&eq->state[ch][b], 0, sizeof(eq_biquad_state_t));
+            }
+        }
+    }
+}
+
+// ============================================
+// Pętla próbek
+// ============================================
+
+// Pełny iloczyn 64-bitowy w arytmetyce modulo 2^64
+static inline uint64_t mul_full(int32_t a, int32_t b)
+{
+    return (uint64_t)((int64_t)a * b);
+}
+
+// Q27 -> Q31 z nasyceniem (MIN/MAX, bez skoków)
+static inline int32_t sat_q27_to_q31(int32_t v)
+{
+    const int32_t lim = (1 << 27) - 1;
+    v = v > lim ? lim : v;
+    v = v < -lim ? -lim : v;
+    return v << 4;
+}
+
+static void biquad_run(const eq_biquad_coef_t *c, eq_biquad_state_t *s,
+                       int32_t *x, int frames, int stride)
+{
+    const int32_t b0 = c->b0, b1 = c->b1, b2 = c->b2, a1 = c->a1, a2 = c->a2;
+    int32_t x1 = s->x1, x2 = s->x2, y1 = s->y1, y2 = s->y2;
+    uint32_t err = s->err;
+
+    for (int i = 0; i < frames; i++) {
+        int32_t in = *x;
+        // Suma w arytmetyce modulo 2^64 - przepełnienia pośrednie się znoszą
+        uint64_t acc = mul_full(b0, in) + mul_full(b1, x1) + mul_full(b2, x2) +
+                       mul_full(a1, y1) + mul_full(a2, y2) + err;
+        err = (uint32_t)acc;
+        int32_t out = sat_q27_to_q31((int32_t)(acc >> 32));
+        x2 = x1;
+        x1 = in;
+        y2 = y1;
+        y1 = out;
+        *x = out;
+        x += stride;
+    }
+
+    s->x1 = x1;
+    s->x2 = x2;
+    s->y1 = y1;
+    s->y2 = y2;
+    s->err = err;
+}
+
+static void eq_process_block(eq_filter_t *eq, int16_t *pcm, int samples)
+{
+    int channels = eq->active_channels;
+    int frames = samples / channels;
+    int32_t *w = eq->work;
+
+    for (int i = 0; i < samples; i++) {
+        w[i] = (int32_t)pcm[i] << 16;
+    }
+
+    for (int ch = 0; ch < channels; ch++) {
+        eq_cascade_t *cas = &eq->cascade[ch];
+        for (int i = 0; i < cas->count; i++) {
+            biquad_run(&cas->coef[i], &eq->state[ch][cas->band[i]], w + ch, frames, channels);
+        }
+    }
+
+    // Q31 -> int16 z zaokrągleniem (wartości są już nasycone do ±(2^31 - 16))
+    for (int i = 0; i < samples; i++) {
+        pcm[i] = (int16_t)((w[i] + (1 << 15)) >> 16);
+    }
+}
+
+// ============================================
+// Callbacki elementu
+// ============================================
+
+static esp_err_t _eq_filter_open(audio_element_handle_t self)
+{
+    eq_filter_t *eq = (eq_filter_t *)audio_element_getdata(self);
+
+    audio_element_info_t info = {0};
+    audio_element_getinfo(self, &info);
+    if (info.sample_rates > 0 && info.channels > 0) {
+        portENTER_CRITICAL(&eq->lock);
+        eq->sample_rate = info.sample_rates;
+        eq->channels = info.channels;
+        portEXIT_CRITICAL(&eq->lock);
+    }
+
+    if (eq->work == NULL) {
+        eq->work = heap_caps_malloc(EQ_FILTER_BUF_SIZE / sizeof(int16_t) * sizeof(int32_t),
+                                    MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (eq->work == NULL) {
+            ESP_LOGE(TAG, "No memory for work buffer");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    memset(eq->state, 0, sizeof(eq->state));
+    eq->carry_len = 0;
+    eq->cycles_acc = 0;
+    eq->frames_acc = 0;
+    publish_coefficients(eq);
+
+    ESP_LOGI(TAG, "Open: %d Hz, %d ch", eq->sample_rate, eq->channels);
+    return ESP_OK;
+}
+
+static esp_err_t _eq_filter_close(audio_element_handle_t self)
+{
+    eq_filter_t *eq = (eq_filter_t *)audio_element_getdata(self);
+    if (eq->work) {
+        free(eq->work);
+        eq->work = NULL;
+    }
+    eq->load_permille = 0;
+    return ESP_OK;
+}
+
+static esp_err_t _eq_filter_destroy(audio_element_handle_t self)
+{
+    eq_filter_t *eq = (eq_filter_t *)audio_element_getdata(self);
+    if (eq) {
+        free(eq->work);
+        free(eq);
+    }
+    return ESP_OK;
+}
+
+static void account_load(eq_filter_t *eq, uint32_t cycles, int frames)
+{
+    eq->cycles_acc += cycles;
+    eq->frames_acc += frames;
+
+    if (eq->sample_rate > 0 &&
+        eq->frames_acc >= (uint32_t)(eq->sample_rate * EQ_LOAD_WINDOW_MS / 1000)) {
+        // cykle / (czas audio * taktowanie CPU) w promilach
+        uint64_t budget = (uint64_t)eq->frames_acc * CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * 1000000ULL
+                          / eq->sample_rate;
+        eq->load_permille = (int)((uint64_t)eq->cycles_acc * 1000 / budget);
+        eq->cycles_acc = 0;
+        eq->frames_acc = 0;
+    }
+}
+
+static int _eq_filter_process(audio_element_handle_t self, char *in_buffer, int in_len)
+{
+    eq_filter_t *eq = (eq_filter_t *)audio_element_getdata(self);
+
+    // Ring buffer oddaje dowolną liczbę bajtów - resztę niepełnej ramki dokładamy na
+    // początek następnego bloku, inaczej stan filtrów L/R trafiałby w cudze próbki
+    int carry = eq->carry_len;
+    memcpy(in_buffer, eq->carry, carry);
+    int r_size = audio_element_input(self, in_buffer + carry, in_len - carry);
+    if (r_size <= 0) {
+        return r_size;
+    }
+
+    apply_pending(eq);
+
+    int frame_bytes = eq->active_channels * sizeof(int16_t);
+    int total = carry + r_size;
+    int frames = total / frame_bytes;
+    eq->carry_len = total - frames * frame_bytes;
+    memcpy(eq->carry, in_buffer + frames * frame_bytes, eq->carry_len);
+    if (frames == 0) {
+        return r_size;      // Cała ramka jeszcze nie dotarła
+    }
+
+    uint32_t start = esp_cpu_get_cycle_count();
+    eq_process_block(eq, (int16_t *)in_buffer, frames * eq->active_channels);
+    account_load(eq, esp_cpu_get_cycle_count() - start, frames);
+
+    return audio_element_output(self, in_buffer, frames * frame_bytes);
+}
+
+// ============================================
+// Publiczne API
+// ============================================
+
+audio_element_handle_t eq_filter_init(eq_filter_cfg_t *config)
+{
+    if (config == NULL || config->band_freq == NULL) {
+        ESP_LOGE(TAG, "Invalid config");
+        return NULL;
+    }
+
+    eq_filter_t *eq = heap_caps_calloc(1, sizeof(eq_filter_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (eq == NULL) {
+        ESP_LOGE(TAG, "No memory for eq_filter");
+        return NULL;
+    }
+
+    eq->sample_rate = config->samplerate;
+    eq->channels = config->channel;
+    portMUX_INITIALIZE(&eq->lock);
+    for (int b = 0; b < EQ_FILTER_BANDS; b++) {
+        eq->freq[b] = config->band_freq[b];
+        for (int ch = 0; ch < EQ_FILTER_CHANNELS; ch++) {
+            eq->gain[ch][b] = config->set_gain ? config->set_gain[ch * EQ_FILTER_BANDS + b] : 0;
+        }
+    }
+    eq_params_t params;
+    snapshot_params(eq, &params);
+    build_cascades(eq->freq, &params, eq->cascade, &eq->active_channels);
+
+    audio_element_cfg_t cfg = DEFAULT_AUDIO_ELEMENT_CONFIG();
+    cfg.open = _eq_filter_open;
+    cfg.close = _eq_filter_close;
+    cfg.process = _eq_filter_process;
+    cfg.destroy = _eq_filter_destroy;
+    cfg.buffer_len = EQ_FILTER_BUF_SIZE;
+    cfg.out_rb_size = config->out_rb_size;
+    cfg.task_stack = config->task_stack;
+    cfg.task_core = config->task_core;
+    cfg.task_prio = config->task_prio;
+    cfg.stack_in_ext = config->stack_in_ext;
+    cfg.tag = "eq";
+
+    audio_element_handle_t el = audio_element_init(&cfg);
+    if (el == NULL) {
+        free(eq);
+        return NULL;
+    }
+    audio_element_setdata(el, eq);
+
+    audio_element_info_t info = {0};
+    audio_element_getinfo(el, &info);
+    info.sample_rates = config->samplerate;
+    info.channels = config->channel;
+    info.bits = 16;
+    audio_element_setinfo(el, &info);
+
+    ESP_LOGI(TAG, "Created: %d bands, %d active", EQ_FILTER_BANDS, eq->cascade[0].count);
+    return el;
+}
+
+esp_err_t eq_filter_set_info(audio_element_handle_t self, int rate, int ch)
+{
+    if (self == NULL || rate <= 0 || ch <= 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    eq_filter_t *eq = (eq_filter_t *)audio_element_getdata(self);
+    portENTER_CRITICAL(&eq->lock);
+    bool same = eq->sample_rate == rate && eq->channels == ch;
+    eq->sample_rate = rate;
+    eq->channels = ch;
+    portEXIT_CRITICAL(&eq->lock);
+    if (same) {
+        return ESP_OK;
+    }
+
+    audio_element_set_music_info(self, rate, ch, 16);
+    publish_coefficients(eq);
+
+    ESP_LOGI(TAG, "Format: %d Hz, %d ch", rate, ch);
+    return ESP_OK;
+}
+
+static int clamp_gain(int db)
+{
+    if (db < EQ_FILTER_GAIN_MIN) return EQ_FILTER_GAIN_MIN;
+    if (db > EQ_FILTER_GAIN_MAX) return EQ_FILTER_GAIN_MAX;
+    return db;
+}
+
+esp_err_t eq_filter_set_gain_info(audio_element_handle_t self, int index, int value_gain,
+                                  bool is_channels_gain_equal)
+{
+    if (self == NULL || index < 0 || index >= EQ_FILTER_BANDS * EQ_FILTER_CHANNELS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    eq_filter_t *eq = (eq_filter_t *)audio_element_getdata(self);
+
+    int band = index % EQ_FILTER_BANDS;
+    int db = clamp_gain(value_gain);
+    portENTER_CRITICAL(&eq->lock);
+    if (is_channels_gain_equal) {
+        eq->gain[0][band] = db;
+        eq->gain[1][band] = db;
+    } else {
+        eq->gain[index / EQ_FILTER_BANDS][band] = db;
+    }
+    portEXIT_CRITICAL(&eq->lock);
+
+    publish_coefficients(eq);
+    return ESP_OK;
+}
+
+esp_err_t eq_filter_set_all_gains(audio_element_handle_t self, const int *gains_db,
+                                  bool is_channels_gain_equal)
+{
+    if (self == NULL || gains_db == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    eq_filter_t *eq = (eq_filter_t *)audio_element_getdata(self);
+
+    int gain[EQ_FILTER_CHANNELS][EQ_FILTER_BANDS];
+    for (int b = 0; b < EQ_FILTER_BANDS; b++) {
+        gain[0][b] = clamp_gain(gains_db[b]);
+        gain[1][b] = is_channels_gain_equal ? gain[0][b] : clamp_gain(gains_db[b + EQ_FILTER_BANDS]);
+    }
+    portENTER_CRITICAL(&eq->lock);
+    memcpy(eq->gain, gain, sizeof(gain));
+    portEXIT_CRITICAL(&eq->lock);
+
+    publish_coefficients(eq);
+    return ESP_OK;
+}
+
+int eq_filter_get_load_permille(audio_element_handle_t self)
+{
+    if (self == NULL) return 0;
+    eq_filter_t *eq = (eq_filter_t *)audio_element_getdata(self);
+    return eq->load_permille;
+}
+
+int eq_filter_get_active_bands(audio_element_handle_t self)
+{
+    if (self == NULL) return 0;
+    eq_filter_t *eq = (eq_filter_t *)audio_element_getdata(self);
+    return eq->cascade[0].count;
+}
@@ -0,0 +1,68 @@
+/*
+ * Fixed-point 10-band Equalizer Element
+ * Cascaded peaking biquads (Q28 coefficients, Q31 samples) for ESP-ADF pipeline
+ */
+
+#ifndef EQ_FILTER_H
+#define EQ_FILTER_H
+
+#include "esp_err.h"
+#include "audio_element.h"
+
+#define EQ_FILTER_BANDS     10
+#define EQ_FILTER_CHANNELS  2
+#define EQ_FILTER_GAIN_MIN  -13     // dB
+#define EQ_FILTER_GAIN_MAX  13      // dB
+
+// Konfiguracja elementu (odpowiednik equalizer_cfg_t z ESP-ADF)
+typedef struct {
+    int samplerate;                     // Początkowa częstotliwość próbkowania
+    int channel;                        // 1 lub 2 (interleaved)
+    const int *band_freq;               // EQ_FILTER_BANDS częstotliwości środkowych (Hz)
+    const int *set_gain;                // 2 * EQ_FILTER_BANDS wartości dB (L: 0-9, R: 10-19), NULL = 0 dB
+    int out_rb_size;
+    int task_stack;
+    int task_core;
+    int task_prio;
+    bool stack_in_ext;
+} eq_filter_cfg_t;
+
+#define EQ_FILTER_TASK_STACK    (4 * 1024)
+#define EQ_FILTER_TASK_CORE     (1)
+#define EQ_FILTER_TASK_PRIO     (22)
+#define EQ_FILTER_RINGBUFFER_SIZE (8 * 1024)
+
+#define DEFAULT_EQ_FILTER_CONFIG() {                \
+    .samplerate     = 44100,                        \
+    .channel        = 2,                            \
+    .band_freq      = NULL,                         \
+    .set_gain       = NULL,                         \
+    .out_rb_size    = EQ_FILTER_RINGBUFFER_SIZE,    \
+    .task_stack     = EQ_FILTER_TASK_STACK,         \
+    .task_core      = EQ_FILTER_TASK_CORE,          \
+    .task_prio      = EQ_FILTER_TASK_PRIO,          \
+    .stack_in_ext   = true,                         \
+}
+
+// Tworzenie elementu
+audio_element_handle_t eq_filter_init(eq_filter_cfg_t *config);
+
+// Zmiana formatu strumienia (przelicza współczynniki przed następnym blokiem)
+esp_err_t eq_filter_set_info(audio_element_handle_t self, int rate, int ch);
+
+// Ustawienie wzmocnienia pasma - ten sam kontrakt co equalizer_set_gain_info():
+// index 0-9 = lewy kanał, 10-19 = prawy; is_channels_gain_equal ustawia oba kanały
+esp_err_t eq_filter_set_gain_info(audio_element_handle_t self, int index, int value_gain,
+                                  bool is_channels_gain_equal);
+
+// Ustawienie wszystkich pasm naraz (jedno przeliczenie współczynników)
+esp_err_t eq_filter_set_all_gains(audio_element_handle_t self, const int *gains_db,
+                                  bool is_channels_gain_equal);
+
+// Obciążenie CPU przez EQ w promilach jednego rdzenia (średnia z ostatniej sekundy audio)
+int eq_filter_get_load_permille(audio_element_handle_t self);
+
+// Liczba aktywnych (nie-płaskich) sekcji biquad na kanał
+int eq_filter_get_active_bands(audio_element_handle_t self);
+
+#endif // EQ_FILTER_H
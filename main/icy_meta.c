@@ -0,0 +1,276 @@
+/*
+ * ICY Metadata Module
+ * Metadane Shoutcast/Icecast przeplatane ze strumieniem audio (Icy-MetaData: 1)
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include "icy_meta.h"
+
+#define ICY_TITLE_TAG       "StreamTitle='"
+#define ICY_TITLE_TAG_LEN   13
+#define ICY_METAINT_MIN     512             // Mniejsze odstępy - fałszywe trafienie w danych audio
+#define ICY_METAINT_MAX     (64 * 1024)     // Icecast/Shoutcast: 8192-32768, więcej - błędny nagłówek
+#define ICY_SEARCH_LIMIT    (128 * 1024)    // Bez bloku w tym zakresie - serwer nie wysyła metadanych
+
+// ============================================
+// Wyszukiwanie pierwszego bloku
+// ============================================
+
+// Bajt strumienia wyszukiwania: k < 0 - koniec poprzedniego odczytu, k >= 0 - bieżący odczyt
+static uint8_t search_byte(const icy_meta_t *icy, const uint8_t *buf, int k)
+{
+    return k < 0 ? icy->tail[icy->tail_len + k] : buf[k];
+}
+
+static bool search_match(const icy_meta_t *icy, const uint8_t *buf, int s)
+{
+    for (int j = 0; j < ICY_TITLE_TAG_LEN; j++) {
+        if (search_byte(icy, buf, s + j) != (uint8_t)ICY_TITLE_TAG[j]) return false;
+    }
+    return true;
+}
+
+static void meta_append(icy_meta_t *icy, const uint8_t *data, int n)
+{
+    int room = ICY_META_TEXT_MAX - icy->meta_len;
+    if (n > room) n = room;
+    if (n > 0) {
+        memcpy(icy->meta + icy->meta_len, data, n);
+        icy->meta_len += n;
+    }
+}
+
+// Fallback bez nagłówka icy-metaint. Szuka "StreamTitle='" poprzedzonego bajtem długości.
+// Pierwszy blok stoi dokładnie na pozycji icy-metaint (Icecast/Shoutcast wysyłają bieżący
+// tytuł nowemu słuchaczowi); po pustych blokach na początku odstęp wyjdzie za duży
+// i parser przejdzie w OFF na pierwszym błędnym bloku.
+// Zwraca indeks w buf, od którego parser kontynuuje w stanie META, lub -1.
+static int search_first_block(icy_meta_t *icy, const uint8_t *buf, int len, int *audio_len)
+{
+    for (int s = 1 - icy->tail_len; s + ICY_TITLE_TAG_LEN <= len; s++) {
+        if (!search_match(icy, buf, s)) continue;
+
+        int length = search_byte(icy, buf, s - 1);
+        int metaint = (int)icy->search_pos + s - 1;
+        if (length == 0 || metaint < ICY_METAINT_MIN) continue;
+
+        icy->metaint = metaint;
+        icy->meta_left = length * 16;
+        icy->meta_len = 0;
+        icy->state = ICY_STATE_META;
+
+        // Początek bloku z poprzedniego odczytu poszedł już dalej - tekst odtwarzamy z tail
+        for (int k = s; k < 0 && icy->meta_left > 0; k++) {
+            uint8_t b = search_byte(icy, buf, k);
+            meta_append(icy, &b, 1);
+            icy->meta_left--;
+        }
+
+        *audio_len = s > 1 ? s - 1 : 0;
+        return s > 0 ? s : 0;
+    }
+
+    // Brak - zachowaj koniec odczytu (wzorzec może przechodzić przez granicę)
+    uint8_t tail[sizeof(icy->tail)];
+    int keep = icy->tail_len + len;
+    if (keep > (int)sizeof(tail)) keep = sizeof(tail);
+    for (int j = 0; j < keep; j++) {
+        tail[j] = search_byte(icy, buf, len - keep + j);
+    }
+    memcpy(icy->tail, tail, keep);
+    icy->tail_len = keep;
+
+    icy->search_pos += len;
+    if (icy->search_pos > ICY_SEARCH_LIMIT) {
+        icy->state = ICY_STATE_OFF;
+    }
+    return -1;
+}
+
+// Koniec bloku: tekst do callbacku, dalej metaint bajtów audio
+static bool finish_block(icy_meta_t *icy)
+{
+    icy->meta[icy->meta_len] = '\0';
+    icy->state = ICY_STATE_AUDIO;
+    icy->audio_left = icy->metaint;
+
+    if (icy->meta_len == 0 || icy->meta[0] == '\0') {
+        return true;
+    }
+    // Blok musi wyglądać jak "Klucz='wartość';" - inaczej synchronizacja jest utracona
+    if (strchr(icy->meta, '=') == NULL) {
+        icy->state = ICY_STATE_OFF;
+        return false;
+    }
+    if (icy->callback) {
+        icy->callback(icy->meta, icy->ctx);
+    }
+    return true;
+}
+
+// ============================================
+// Publiczne API
+// ============================================
+
+void icy_meta_reset(icy_meta_t *icy, icy_meta_cb_t callback, void *ctx)
+{
+    memset(icy, 0, sizeof(*icy));
+    icy->state = ICY_STATE_SEARCH;
+    icy->callback = callback;
+    icy->ctx = ctx;
+}
+
+bool icy_meta_set_interval(icy_meta_t *icy, const char *metaint)
+{
+    if (metaint == NULL || icy->state != ICY_STATE_SEARCH || icy->search_pos > 0) {
+        return false;
+    }
+
+    char *end;
+    long value = strtol(metaint, &end, 10);
+    while (*end == ' ') end++;
+    if (end == metaint || *end != '\0' || value < ICY_METAINT_MIN || value > ICY_METAINT_MAX) {
+        // Serwer wysyła metadane, ale w nieznanym odstępie - nie ruszamy danych
+        icy->state = ICY_STATE_OFF;
+        return false;
+    }
+
+    icy->metaint = (int)value;
+    icy->audio_left = icy->metaint;
+    icy->state = ICY_STATE_AUDIO;
+    return true;
+}
+
+int icy_meta_strip(icy_meta_t *icy, uint8_t *buf, int len)
+{
+    int in = 0;     // Pozycja odczytu
+    int out = 0;    // Koniec danych audio (przesuwane tylko gdy blok jest w środku odczytu)
+
+    if (icy->state == ICY_STATE_SEARCH) {
+        in = search_first_block(icy, buf, len, &out);
+        if (in < 0) {
+            return len;
+        }
+    }
+
+    while (in < len) {
+        switch (icy->state) {
+            case ICY_STATE_AUDIO: {
+                int n = len - in;
+                if (n > icy->audio_left) n = icy->audio_left;
+                if (out != in) {
+                    memmove(buf + out, buf + in, n);
+                }
+                out += n;
+                in += n;
+                icy->audio_left -= n;
+                if (icy->audio_left == 0) {
+                    icy->state = ICY_STATE_LENGTH;
+                }
+                break;
+            }
+
+            case ICY_STATE_LENGTH:
+                icy->meta_left = buf[in++] * 16;
+                icy->meta_len = 0;
+                icy->state = ICY_STATE_META;
+                if (icy->meta_left == 0) {
+                    finish_block(icy);
+                }
+                break;
+
+            case ICY_STATE_META: {
+                int n = len - in;
+                if (n > icy->meta_left) n = icy->meta_left;
+                meta_append(icy, buf + in, n);
+                in += n;
+                icy->meta_left -= n;
+                if (icy->meta_left == 0) {
+                    finish_block(icy);
+                }
+                break;
+            }
+
+            default:
+                // OFF (utrata synchronizacji) - reszta przechodzi bez zmian
+                if (out != in) {
+                    memmove(buf + out, buf + in, len - in);
+                }
+                out += len - in;
+                in = len;
+                break;
+        }
+    }
+
+    return out;
+}
+
+int icy_meta_read_size(const icy_meta_t *icy, int len)
+{
+    switch (icy->state) {
+        case ICY_STATE_AUDIO:
+            return len < icy->audio_left ? len : icy->audio_left;
+        case ICY_STATE_LENGTH:
+            return 1;
+        case ICY_STATE_META:
+            return len < icy->meta_left ? len : icy->meta_left;
+        default:
+            return len;
+    }
+}
+
+bool icy_meta_active(const icy_meta_t *icy)
+{
+    return icy->state != ICY_STATE_OFF;
+}
+
+// ============================================
+// StreamTitle
+// ============================================
+
+// Kopiuje [start, end) bez spacji na brzegach
+static void copy_trimmed(char *dst, size_t dst_len, const char *start, const char *end)
+{
+    while (start < end && *start == ' ') start++;
+    while (end > start && end[-1] == ' ') end--;
+
+    size_t n = end - start;
+    if (n >= dst_len) n = dst_len - 1;
+    memcpy(dst, start, n);
+    dst[n] = '\0';
+}
+
+bool icy_meta_parse_title(const char *meta, char *artist, size_t artist_len,
+                          char *title, size_t title_len)
+{
+    const char *start = strstr(meta, ICY_TITLE_TAG);
+    if (start == NULL) {
+        return false;
+    }
+    start += ICY_TITLE_TAG_LEN;
+
+    // Wartość kończy "';" - apostrofy w tytule są dozwolone
+    const char *end = strstr(start, "';");
+    if (end == NULL) {
+        end = start + strlen(start);
+        if (end > start && end[-1] == '\'') end--;
+    }
+
+    const char *sep = NULL;
+    for (const char *p = start; p + 3 <= end; p++) {
+        if (p[0] == ' ' && p[1] == '-' && p[2] == ' ') {
+            sep = p;
+            break;
+        }
+    }
+
+    if (sep) {
+        copy_trimmed(artist, artist_len, start, sep);
+        copy_trimmed(title, title_len, sep + 3, end);
+    } else {
+        artist[0] = '\0';
+        copy_trimmed(title, title_len, start, end);
+    }
+    return true;
+}
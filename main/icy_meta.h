@@ -0,0 +1,73 @@
+/*
+ * ICY Metadata Module
+ * Metadane Shoutcast/Icecast przeplatane ze strumieniem audio (Icy-MetaData: 1)
+ */
+
+#ifndef ICY_META_H
+#define ICY_META_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define ICY_META_TEXT_MAX   512     // Zachowywany początek bloku (StreamTitle jest na początku)
+
+// Callback wywoływany po odebraniu kompletnego, niepustego bloku metadanych
+typedef void (*icy_meta_cb_t)(const char *meta, void *ctx);
+
+typedef enum {
+    ICY_STATE_SEARCH = 0,   // Szukanie pierwszego bloku (icy-metaint bez nagłówka)
+    ICY_STATE_AUDIO,        // Dane audio do następnego bloku
+    ICY_STATE_LENGTH,       // Bajt długości bloku (x16)
+    ICY_STATE_META,         // Treść bloku
+    ICY_STATE_OFF,          // Strumień bez metadanych - dane przechodzą bez zmian
+} icy_state_t;
+
+typedef struct {
+    icy_state_t state;
+    int metaint;                    // Odstęp bloków w bajtach audio (0 = nieznany)
+    int audio_left;                 // Bajty audio do następnego bajtu długości
+    int meta_left;                  // Bajty bloku do odebrania
+    int meta_len;
+    char meta[ICY_META_TEXT_MAX + 1];
+    uint32_t search_pos;            // Pozycja w body podczas wyszukiwania
+    uint8_t tail[16];               // Koniec poprzedniego odczytu (wzorzec na granicy)
+    int tail_len;
+    icy_meta_cb_t callback;
+    void *ctx;
+} icy_meta_t;
+
+// ============================================
+// Parser strumienia
+// ============================================
+
+// Przygotowanie do nowego połączenia. Bez icy_meta_set_interval odstęp jest zgadywany
+// z położenia pierwszego bloku "StreamTitle='" w body (zawodzi przy pustych blokach na początku).
+void icy_meta_reset(icy_meta_t *icy, icy_meta_cb_t callback, void *ctx);
+
+// Odstęp z nagłówka icy-metaint (NULL - brak nagłówka, zostaje wyszukiwanie).
+// Wołane przed pierwszym icy_meta_strip połączenia. Nieprawidłowa wartość wyłącza parser -
+// dane przechodzą bez zmian. Zwraca true, jeśli odstęp został przyjęty.
+bool icy_meta_set_interval(icy_meta_t *icy, const char *metaint);
+
+// Usuwa bloki metadanych z buf w miejscu. Zwraca liczbę bajtów audio na początku buf
+// (0 - cały odczyt był metadanymi). Bloki mogą przechodzić przez granice odczytów.
+int icy_meta_strip(icy_meta_t *icy, uint8_t *buf, int len);
+
+// Maksymalny rozmiar następnego odczytu, tak by kończył się na granicy bloku.
+// Odczyt jest wtedy w całości audio albo w całości metadanymi - strip nie przesuwa danych.
+int icy_meta_read_size(const icy_meta_t *icy, int len);
+
+// Czy parser musi widzieć dane strumienia
+bool icy_meta_active(const icy_meta_t *icy);
+
+// ============================================
+// StreamTitle
+// ============================================
+
+// Wyciąga StreamTitle i dzieli "Artysta - Tytuł". Bez separatora cały tekst trafia do title.
+// Zwraca false, jeśli blok nie zawiera StreamTitle.
+bool icy_meta_parse_title(const char *meta, char *artist, size_t artist_len,
+                          char *title, size_t title_len);
+
+#endif // ICY_META_H
@@ -123,8 +123,7 @@ static void handle_touch_event(touch_button_t btn, touch_event_t event) {
     switch (btn) {
         case TOUCH_BTN_PLAY:
             if (event == TOUCH_EVENT_TAP) {
-                player_status_t *status = audio_player_get_status();
-                if (status->state == PLAYER_STATE_PLAYING) {
+                if (audio_player_get_state() == PLAYER_STATE_PLAYING) {
                     audio_player_pause();
                 } else {
                     audio_player_resume();
@@ -0,0 +1,186 @@
+/*
+ * Jitter Buffer Module
+ * Bufor PCM odbiornika Bluetooth: głębokość z opóźnień pakietów, korekta dryfu przez
+ * gubienie/powtarzanie pojedynczych ramek
+ */
+
+#include <string.h>
+#include "jitter_buffer.h"
+
+static int64_t bytes_to_us(const jitter_buffer_t *jb, uint32_t bytes)
+{
+    return (int64_t)bytes * 1000000 / ((int64_t)jb->rate * jb->frame_bytes);
+}
+
+static uint32_t bytes_to_ms(const jitter_buffer_t *jb, uint32_t bytes)
+{
+    return (uint32_t)((uint64_t)bytes * 1000 / ((uint64_t)jb->rate * jb->frame_bytes));
+}
+
+bool jitter_buffer_init(jitter_buffer_t *jb, uint8_t *data, uint32_t size)
+{
+    memset(jb, 0, sizeof(*jb));
+    if (data == NULL || size == 0 || (size & (size - 1)) != 0) {
+        return false;
+    }
+    jb->data = data;
+    jb->size = size;
+    jb->rate = 44100;
+    jb->frame_bytes = 4;
+    jb->target_ms = JITTER_MIN_MS;
+    return true;
+}
+
+void jitter_buffer_start(jitter_buffer_t *jb, uint32_t rate, uint32_t frame_bytes)
+{
+    jb->rate = rate ? rate : 44100;
+    jb->frame_bytes = frame_bytes ? frame_bytes : 4;
+    jb->last_us = 0;
+    jb->lag_us = 0;
+    jb->peak_us = 0;
+    jb->target_ms = JITTER_MIN_MS;
+    __sync_synchronize();
+    jb->epoch++;
+}
+
+// ============================================
+// Zapis (callback danych A2DP)
+// ============================================
+
+// Opóźnienie pakietu względem najwcześniejszego harmonogramu (rekurencja Lindleya):
+// pakiet po przerwie dłuższej niż audio poprzedniego zwiększa je, paczka pakietów
+// zmniejsza do zera. Bufor głęboki na szczyt opóźnienia i jeden pakiet nie ma przerw.
+static void update_target(jitter_buffer_t *jb, uint32_t len, int64_t now_us)
+{
+    if (jb->last_us) {
+        int64_t gap = now_us - jb->last_us;
+        if (gap > (int64_t)JITTER_GAP_MS * 1000) {
+            jb->lag_us = 0;     // Pauza nadawcy - czytający i tak zacznie od buforowania
+        } else {
+            jb->lag_us += gap - jb->last_dur_us - gap * JITTER_LEAK_PERMILLE / 1000;
+            if (jb->lag_us < 0) jb->lag_us = 0;
+            // Zaokrąglenie w górę - obcięte do zera zatrzymywało zanik poniżej ~1.7 ms
+            const int64_t decay_us = (int64_t)JITTER_PEAK_DECAY_MS * 1000;
+            jb->peak_us -= (jb->peak_us * gap + decay_us - 1) / decay_us;
+            if (jb->peak_us < 0) jb->peak_us = 0;
+        }
+        if (jb->lag_us > jb->peak_us) jb->peak_us = jb->lag_us;
+    }
+    jb->last_us = now_us;
+    jb->last_dur_us = bytes_to_us(jb, len);
+
+    int64_t target = (jb->peak_us + jb->last_dur_us) / 1000 + JITTER_MARGIN_MS;
+    if (target < JITTER_MIN_MS) target = JITTER_MIN_MS;
+    if (target > JITTER_MAX_MS) target = JITTER_MAX_MS;
+    jb->target_ms = (uint32_t)target;
+}
+
+void jitter_buffer_write(jitter_buffer_t *jb, const uint8_t *data, uint32_t len, int64_t now_us)
+{
+    if (len == 0) return;
+    jb->packets++;
+    update_target(jb, len, now_us);
+
+    uint32_t underruns = jb->underruns;
+    if (underruns != jb->underruns_seen) {
+        jb->underruns_seen = underruns;
+        jb->late++;     // Czytający czekał na ten pakiet
+    }
+
+    uint32_t head = jb->head;
+    uint32_t space = jb->size - (head - jb->tail);
+    uint32_t n = len < space ? len : space;
+    if (n < len) {
+        jb->lost++;
+    }
+
+    uint32_t pos = head & (jb->size - 1);
+    uint32_t first = jb->size - pos;
+    if (first > n) first = n;
+    memcpy(jb->data + pos, data, first);
+    memcpy(jb->data, data + first, n - first);
+
+    __sync_synchronize();   // Dane widoczne przed przesunięciem head
+    jb->head = head + n;
+}
+
+// ============================================
+// Odczyt (etap wyjściowy)
+// ============================================
+
+static void copy_out(const jitter_buffer_t *jb, uint32_t tail, uint8_t *out, uint32_t n)
+{
+    uint32_t pos = tail & (jb->size - 1);
+    uint32_t first = jb->size - pos;
+    if (first > n) first = n;
+    memcpy(out, jb->data + pos, first);
+    memcpy(out + first, jb->data, n - first);
+}
+
+int jitter_buffer_read(jitter_buffer_t *jb, uint8_t *out, int len)
+{
+    uint32_t epoch = jb->epoch;
+    if (epoch != jb->epoch_seen) {
+        jb->epoch_seen = epoch;
+        jb->tail = jb->head;
+        jb->buffering = true;
+    }
+
+    const uint32_t frame = jb->frame_bytes;
+    uint32_t tail = jb->tail;
+    uint32_t avail = jb->head - tail;
+    __sync_synchronize();   // Dane czytane po odczycie head
+    uint32_t depth_ms = bytes_to_ms(jb, avail);
+    uint32_t target_ms = jb->target_ms;
+
+    if (jb->buffering) {
+        if (depth_ms < target_ms) {
+            return 0;
+        }
+        jb->buffering = false;
+        jb->level_ms = depth_ms;
+    }
+    if (avail < frame || len < (int)frame) {
+        if (avail < frame) {
+            jb->underruns++;
+            jb->buffering = true;
+        }
+        return 0;
+    }
+
+    uint32_t n = ((uint32_t)len < avail ? (uint32_t)len : avail) / frame * frame;
+    float alpha = (float)bytes_to_ms(jb, n) / (JITTER_LEVEL_TAU_MS + bytes_to_ms(jb, n));
+    jb->level_ms += alpha * ((float)depth_ms - jb->level_ms);
+
+    // Dryf zegara telefonu względem I2S - jedna ramka na odczyt
+    uint32_t consumed = n;
+    if (jb->level_ms > target_ms + JITTER_SLIP_MS && avail >= n + frame) {
+        tail += frame;          // Pominięta ramka
+        jb->slipped++;
+    } else if (jb->level_ms < target_ms * 0.75f && n >= 2 * frame) {
+        consumed = n - frame;   // Ostatnia ramka powtórzona
+        jb->slipped++;
+    }
+
+    copy_out(jb, tail, out, consumed);
+    if (consumed < n) {
+        memcpy(out + consumed, out + consumed - frame, frame);
+    }
+
+    __sync_synchronize();   // Dane skopiowane przed zwolnieniem miejsca
+    jb->tail = tail + consumed;
+    return (int)n;
+}
+
+void jitter_buffer_get_stats(const jitter_buffer_t *jb, jitter_buffer_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->depth_ms = bytes_to_ms(jb, jb->head - jb->tail);
+    stats->target_ms = jb->target_ms;
+    stats->jitter_ms = (uint32_t)(jb->peak_us / 1000);
+    stats->packets = jb->packets;
+    stats->late = jb->late;
+    stats->lost = jb->lost;
+    stats->underruns = jb->underruns;
+    stats->slipped = jb->slipped;
+}
@@ -0,0 +1,82 @@
+/*
+ * Jitter Buffer Module
+ * Bufor PCM odbiornika Bluetooth (A2DP sink): pakiety przychodzą nierówno (paczki, przerwy
+ * przy współdzieleniu anteny z WiFi), I2S pobiera równo. Głębokość bufora dobierana
+ * z obserwowanych opóźnień pakietów - tylko tyle, ile trzeba, żeby nie było przerw.
+ *
+ * Jeden zapisujący (callback danych A2DP) i jeden czytający (etap wyjściowy) bez blokad.
+ * Czas przyjścia pakietu podaje wywołujący - zapis czasów z urządzenia można odtworzyć
+ * na hoście. Czyste C - można kompilować i sprawdzać na hoście.
+ */
+
+#ifndef JITTER_BUFFER_H
+#define JITTER_BUFFER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define JITTER_MIN_MS           20      // Dolna granica głębokości docelowej
+#define JITTER_MAX_MS           70      // Górna - razem z DMA I2S mieści się w 150 ms
+#define JITTER_MARGIN_MS        8       // Zapas ponad najgorsze ostatnie opóźnienie
+#define JITTER_PEAK_DECAY_MS    20000   // Stała zaniku szczytu opóźnienia
+#define JITTER_LEAK_PERMILLE    2       // Opóźnienie maleje o 2 ms/s - zegar telefonu wolniejszy
+#define JITTER_GAP_MS           500     // Dłuższa przerwa to pauza nadawcy, nie jitter
+#define JITTER_LEVEL_TAU_MS     2000    // Uśrednianie głębokości do korekty dryfu
+#define JITTER_SLIP_MS          15      // Głębokość ponad cel, przy której ramki są gubione
+
+typedef struct {
+    uint32_t depth_ms;          // PCM w buforze
+    uint32_t target_ms;         // Głębokość docelowa (start i wznowienie po przerwie)
+    uint32_t jitter_ms;         // Szczyt opóźnienia pakietów względem harmonogramu
+    uint32_t packets;
+    uint32_t late;              // Pakiety, które przyszły po opróżnieniu bufora
+    uint32_t lost;              // Pakiety (w całości lub części) odrzucone - bufor pełny
+    uint32_t underruns;         // Opróżnienia bufora w trakcie odtwarzania
+    uint32_t slipped;           // Ramki pominięte lub powtórzone przez korektę dryfu
+} jitter_buffer_stats_t;
+
+typedef struct {
+    uint8_t *data;
+    uint32_t size;                  // Potęga dwójki
+    volatile uint32_t head;         // Bajty zapisane (tylko zapisujący)
+    volatile uint32_t tail;         // Bajty odczytane (tylko czytający)
+    volatile uint32_t epoch;        // Zmiana - czytający porzuca zawartość (nowy strumień)
+    volatile uint32_t target_ms;
+    uint32_t rate;
+    uint32_t frame_bytes;
+
+    // Strona zapisu
+    int64_t last_us;
+    int64_t last_dur_us;            // Czas trwania audio poprzedniego pakietu
+    int64_t lag_us;                 // Opóźnienie bieżącego pakietu względem harmonogramu
+    int64_t peak_us;
+    uint32_t underruns_seen;
+    uint32_t packets;
+    uint32_t late;
+    uint32_t lost;
+
+    // Strona odczytu
+    uint32_t epoch_seen;
+    bool buffering;
+    float level_ms;
+    volatile uint32_t underruns;
+    uint32_t slipped;
+} jitter_buffer_t;
+
+// data - bufor o rozmiarze size (potęga dwójki); false - zły rozmiar
+bool jitter_buffer_init(jitter_buffer_t *jb, uint8_t *data, uint32_t size);
+
+// Nowy strumień (zapisujący): format PCM, statystyki opóźnień od zera, czytający porzuca
+// zawartość i buforuje do głębokości docelowej
+void jitter_buffer_start(jitter_buffer_t *jb, uint32_t rate, uint32_t frame_bytes);
+
+// Pakiet PCM, który przyszedł w chwili now_us. Nadmiar ponad wolne miejsce jest odrzucany.
+void jitter_buffer_write(jitter_buffer_t *jb, const uint8_t *data, uint32_t len, int64_t now_us);
+
+// Do len bajtów (całe ramki); 0 - bufor pusty lub buforuje po starcie/przerwie.
+// Uśredniona głębokość ponad celem gubi ramkę, poniżej 3/4 celu - powtarza.
+int jitter_buffer_read(jitter_buffer_t *jb, uint8_t *out, int len);
+
+void jitter_buffer_get_stats(const jitter_buffer_t *jb, jitter_buffer_stats_t *stats);
+
+#endif // JITTER_BUFFER_H
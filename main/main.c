@@ -11,6 +11,7 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -26,9 +27,12 @@
 #include "audio_pipeline.h"
 #include "audio_event_iface.h"
 #include "audio_common.h"
+#include "cJSON.h"
 
 #include "config.h"
 #include "audio_player.h"
+#include "aux_input.h"
+#include "pipeline_stats.h"
 #include "audio_settings.h"
 #include "wifi_manager.h"
 #include "web_server.h"
@@ -70,11 +74,11 @@ static void wifi_state_handler(wifi_state_t state, const char *ip)
     }
 }
 
-static void player_state_handler(player_status_t *status)
+static void player_state_handler(const player_status_t *status, uint32_t changed)
 {
     memcpy(&current_status, status, sizeof(player_status_t));
 
-    // Publikuj stan do MQTT (Home Assistant)
+    // Publikuj do MQTT (Home Assistant) tylko zmienione pola
     const char *state_str = "idle";
     switch (status->state) {
         case PLAYER_STATE_PLAYING: state_str = "playing"; break;
@@ -82,17 +86,46 @@ static void player_state_handler(player_status_t *status)
         case PLAYER_STATE_STOPPED: state_str = "idle"; break;
         default: break;
     }
-    mqtt_publish_state(state_str);
-    mqtt_publish_volume(status->volume);
-    mqtt_publish_media_info(status->current_title, status->current_artist, "");
-
-    // Wyślij aktualizację do WebSocket
-    char json[512];
-    snprintf(json, sizeof(json),
-        "{\"state\":\"%s\",\"volume\":%d,\"muted\":%s,\"title\":\"%s\",\"artist\":\"%s\"}",
-        state_str, status->volume, status->muted ? "true" : "false",
-        status->current_title, status->current_artist);
-    web_server_send_state_update(json);
+    if (changed & PLAYER_STATUS_STATE) {
+        mqtt_publish_state(state_str);
+    }
+    if (changed & PLAYER_STATUS_VOLUME) {
+        mqtt_publish_volume(status->volume);
+    }
+    if (changed & (PLAYER_STATUS_TITLE | PLAYER_STATUS_ARTIST | PLAYER_STATUS_ALBUM)) {
+        mqtt_publish_media_info(status->current_title, status->current_artist, status->current_album);
+    }
+    // Pozycja tylko przy skoku lub start/stop - między nimi odbiorca liczy ją sam
+    uint32_t position_ms = audio_player_status_position_ms(status);
+    if (changed & PLAYER_STATUS_POSITION) {
+        mqtt_publish_media_position(position_ms, status->duration_ms, status->position_at_ms != 0);
+    }
+
+    // Wyślij aktualizację do WebSocket (URL i źródło nie są w nim wyświetlane)
+    if (!(changed & (PLAYER_STATUS_STATE | PLAYER_STATUS_VOLUME | PLAYER_STATUS_MUTED |
+                     PLAYER_STATUS_TITLE | PLAYER_STATUS_ARTIST | PLAYER_STATUS_ALBUM |
+                     PLAYER_STATUS_POSITION))) {
+        return;
+    }
+    // Tytuł/wykonawca z ICY i AVRCP to dowolny tekst - cJSON go escapuje
+    cJSON *root = cJSON_CreateObject();
+    if (root == NULL) return;
+    cJSON_AddStringToObject(root, "state", state_str);
+    cJSON_AddNumberToObject(root, "volume", status->volume);
+    cJSON_AddBoolToObject(root, "muted", status->muted);
+    cJSON_AddStringToObject(root, "title", status->current_title);
+    cJSON_AddStringToObject(root, "artist", status->current_artist);
+    cJSON_AddStringToObject(root, "album", status->current_album);
+    cJSON_AddNumberToObject(root, "duration_ms", status->duration_ms);
+    cJSON_AddNumberToObject(root, "position_ms", position_ms);
+    cJSON_AddBoolToObject(root, "position_running", status->position_at_ms != 0);
+
+    char *json = cJSON_PrintUnformatted(root);
+    if (json) {
+        web_server_send_state_update(json);
+        free(json);
+    }
+    cJSON_Delete(root);
 }
 
 static void mqtt_command_handler(mqtt_command_t *cmd)
@@ -351,6 +384,11 @@ void app_main(void)
     ESP_ERROR_CHECK(tone_generator_init());
     ESP_LOGI(TAG, "Tone generator initialized");
 
+    // 5c. Wejście AUX - czytnik ADC i pomiar poziomu ruszają po włączeniu wejścia
+    if (aux_input_init() != ESP_OK) {
+        ESP_LOGW(TAG, "AUX input not available");
+    }
+
     // 6. Ładowanie stacji radiowych
     ESP_ERROR_CHECK(radio_stations_init());
     if (radio_stations_load() != ESP_OK) {
@@ -421,6 +459,16 @@ void app_main(void)
             }
         }
 
+        // Co sekundę - okno telemetrii pipeline, co 10 sekund wysyłka przez MQTT
+        pipeline_stats_tick();
+        if (counter % 10 == 0 && app_mqtt_get_state() == MQTT_STATE_CONNECTED) {
+            uint8_t telemetry[192];
+            int len = pipeline_stats_pack(telemetry, sizeof(telemetry));
+            if (len > 0) {
+                mqtt_publish_telemetry(telemetry, len);
+            }
+        }
+
         // Co 30 sekund - heartbeat MQTT
         if (counter % 30 == 0) {
             if (app_mqtt_get_state() == MQTT_STATE_CONNECTED) {
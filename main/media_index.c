@@ -0,0 +1,1091 @@
+/*
+ * Media Index Module
+ * Skan przyrostowy karty SD i zapytania do indeksu biblioteki
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <stdlib.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+
+#include "media_index.h"
+#include "media_tags.h"
+#include "seek_index.h"
+#include "codec_detect.h"
+#include "audio_player.h"
+#include "config.h"
+
+static const char *TAG = "MEDIA_INDEX";
+
+#define INDEX_MAGIC             0x5844494d  // "MIDX"
+#define INDEX_VERSION           1
+#define INDEX_NONE              0xffffffff
+#define INDEX_TMP_FILE          MEDIA_INDEX_FILE ".tmp"
+
+#define INDEXER_STACK_SIZE      6144
+#define INDEXER_PRIORITY        2           // Poniżej wszystkiego, co dotyczy audio i sieci
+#define INDEXER_SD_PLAY_DELAY_MS 20         // Przerwa po pliku, gdy gra karta SD
+#define INDEX_PATH_MAX          256
+
+// Bity powiadomienia taska indeksera
+#define INDEXER_RESCAN          (1 << 0)
+#define INDEXER_SEEK_TABLE      (1 << 1)    // Tabela ramek dla seek_pending
+
+// ============================================
+// Format pliku indeksu (taki sam w PSRAM)
+// ============================================
+// [nagłówek][katalogi][utwory][napisy]. Napisy zakończone zerem, bez powtórzeń -
+// offset napisu identyfikuje wartość (np. wykonawcę). Offset 0 to "".
+// Katalogi w kolejności przechodzenia wszerz: dzieci i utwory katalogu leżą obok siebie.
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;
+    uint32_t dir_count;
+    uint32_t track_count;
+    uint32_t strings_size;
+    uint32_t checksum;              // FNV-1a wszystkiego za nagłówkiem
+} index_header_t;
+
+typedef struct {
+    uint32_t path;                  // "/muzyka/rock" (korzeń "/")
+    uint32_t parent;
+    uint32_t mtime;
+    uint32_t signature;             // Hash listy nazw - FAT nie zmienia mtime katalogu
+                                    // przy dodaniu pliku, więc sam mtime nie wystarcza
+    uint32_t first_child;
+    uint32_t child_count;
+    uint32_t first_track;
+    uint32_t track_count;
+} index_dir_t;
+
+typedef struct {
+    uint32_t name;
+    uint32_t title;
+    uint32_t artist;
+    uint32_t album;
+    uint32_t size;
+    uint32_t duration_ms;
+    uint32_t dir;
+    uint16_t track;
+    uint16_t reserved;
+} index_track_t;
+
+typedef struct {
+    uint8_t *blob;
+    uint32_t size;
+    const index_header_t *hdr;
+    const index_dir_t *dirs;
+    const index_track_t *tracks;
+    const char *strings;
+} media_index_t;
+
+// Indeks w trakcie budowy (tablice rosnące w PSRAM)
+typedef struct {
+    index_dir_t *dirs;
+    uint32_t dir_count;
+    uint32_t dir_cap;
+    index_track_t *tracks;
+    uint32_t track_count;
+    uint32_t track_cap;
+    char *strings;
+    uint32_t strings_size;
+    uint32_t strings_cap;
+    uint32_t *hash;                 // Offset napisu + 1 (0 - wolne)
+    uint32_t hash_cap;
+    uint32_t hash_used;
+    bool failed;                    // Brak pamięci - skan przerwany
+} index_builder_t;
+
+// Nazwy jednego katalogu (podkatalogi i pliki audio) do posortowania
+typedef struct {
+    char *names;
+    uint32_t names_size;
+    uint32_t names_cap;
+    uint32_t *offsets;
+    uint32_t count;
+    uint32_t cap;
+    uint32_t dir_count;             // Pierwsze dir_count wpisów to katalogi
+} name_list_t;
+
+static media_index_t *current = NULL;
+static SemaphoreHandle_t index_lock = NULL;
+static TaskHandle_t indexer_task_handle = NULL;
+static media_index_status_t scan_status = {0};
+static char seek_pending[INDEX_PATH_MAX] = "";  // Pod index_lock
+
+// ============================================
+// Pomocnicze
+// ============================================
+
+static uint32_t fnv1a(uint32_t h, const void *data, size_t len)
+{
+    const uint8_t *p = data;
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ p[i]) * 16777619u;
+    }
+    return h;
+}
+
+static uint32_t now_ms(void)
+{
+    return xTaskGetTickCount() * portTICK_PERIOD_MS;
+}
+
+static bool grow(void **ptr, uint32_t *cap, uint32_t need, size_t elem)
+{
+    if (need <= *cap) return true;
+    uint32_t new_cap = *cap ? *cap : 64;
+    while (new_cap < need) new_cap *= 2;
+    void *p = heap_caps_realloc(*ptr, (size_t)new_cap * elem, MALLOC_CAP_SPIRAM);
+    if (p == NULL) return false;
+    *ptr = p;
+    *cap = new_cap;
+    return true;
+}
+
+// "/sdcard/a//b.mp3", "a/b.mp3/" -> "/a/b.mp3"
+static void normalize_path(const char *in, char *out, size_t size)
+{
+    size_t mount_len = strlen(SD_MOUNT_POINT);
+    if (strncmp(in, SD_MOUNT_POINT, mount_len) == 0 && (in[mount_len] == '/' || in[mount_len] == '\0')) {
+        in += mount_len;
+    }
+
+    size_t n = 0;
+    out[n++] = '/';
+    for (; *in && n < size - 1; in++) {
+        if (*in == '/' && out[n - 1] == '/') continue;
+        out[n++] = *in;
+    }
+    if (n > 1 && out[n - 1] == '/') n--;
+    out[n] = '\0';
+}
+
+// Podciąg bez rozróżniania wielkości liter (ASCII)
+static bool contains_nocase(const char *haystack, const char *needle, size_t needle_len)
+{
+    for (; *haystack; haystack++) {
+        if (strncasecmp(haystack, needle, needle_len) == 0) return true;
+    }
+    return false;
+}
+
+static bool is_audio_name(const char *name)
+{
+    esp_codec_type_t codec = codec_detect_file(NULL, 0, name);
+    return codec != ESP_CODEC_TYPE_UNKNOW && codec != ESP_CODEC_TYPE_OGG;  // OGG bez dekodera
+}
+
+// ============================================
+// Budowa indeksu
+// ============================================
+
+static void builder_free(index_builder_t *b)
+{
+    free(b->dirs);
+    free(b->tracks);
+    free(b->strings);
+    free(b->hash);
+    memset(b, 0, sizeof(*b));
+}
+
+static bool builder_rehash(index_builder_t *b, uint32_t cap)
+{
+    uint32_t *table = heap_caps_calloc(cap, sizeof(uint32_t), MALLOC_CAP_SPIRAM);
+    if (table == NULL) return false;
+
+    for (uint32_t i = 0; i < b->hash_cap; i++) {
+        if (b->hash[i] == 0) continue;
+        const char *s = b->strings + b->hash[i] - 1;
+        uint32_t h = fnv1a(2166136261u, s, strlen(s)) & (cap - 1);
+        while (table[h]) h = (h + 1) & (cap - 1);
+        table[h] = b->hash[i];
+    }
+    free(b->hash);
+    b->hash = table;
+    b->hash_cap = cap;
+    return true;
+}
+
+// Offset napisu w tablicy (dodaje, jeśli go jeszcze nie ma)
+static uint32_t builder_string(index_builder_t *b, const char *s)
+{
+    if (s == NULL || s[0] == '\0' || b->failed) return 0;
+
+    if ((b->hash_used + 1) * 2 > b->hash_cap &&
+        !builder_rehash(b, b->hash_cap ? b->hash_cap * 2 : 1024)) {
+        b->failed = true;
+        return 0;
+    }
+
+    size_t len = strlen(s);
+    uint32_t h = fnv1a(2166136261u, s, len) & (b->hash_cap - 1);
+    while (b->hash[h]) {
+        if (strcmp(b->strings + b->hash[h] - 1, s) == 0) {
+            return b->hash[h] - 1;
+        }
+        h = (h + 1) & (b->hash_cap - 1);
+    }
+
+    if (!grow((void **)&b->strings, &b->strings_cap, b->strings_size + len + 1, 1)) {
+        b->failed = true;
+        return 0;
+    }
+    uint32_t offset = b->strings_size;
+    memcpy(b->strings + offset, s, len + 1);
+    b->strings_size += len + 1;
+    b->hash[h] = offset + 1;
+    b->hash_used++;
+    return offset;
+}
+
+static bool builder_init(index_builder_t *b)
+{
+    memset(b, 0, sizeof(*b));
+    if (!grow((void **)&b->strings, &b->strings_cap, 4096, 1)) return false;
+    b->strings[0] = '\0';  // Offset 0 - pusty napis
+    b->strings_size = 1;
+    return true;
+}
+
+static uint32_t builder_add_dir(index_builder_t *b, const char *path, uint32_t parent)
+{
+    if (b->dir_count >= MEDIA_INDEX_MAX_DIRS ||
+        !grow((void **)&b->dirs, &b->dir_cap, b->dir_count + 1, sizeof(index_dir_t))) {
+        return INDEX_NONE;
+    }
+    index_dir_t *dir = &b->dirs[b->dir_count];
+    memset(dir, 0, sizeof(*dir));
+    dir->path = builder_string(b, path);
+    dir->parent = parent;
+    return b->dir_count++;
+}
+
+static index_track_t *builder_add_track(index_builder_t *b)
+{
+    if (b->track_count >= MEDIA_INDEX_MAX_TRACKS ||
+        !grow((void **)&b->tracks, &b->track_cap, b->track_count + 1, sizeof(index_track_t))) {
+        return NULL;
+    }
+    index_track_t *track = &b->tracks[b->track_count++];
+    memset(track, 0, sizeof(*track));
+    return track;
+}
+
+// Indeks z tablic buildera w jednym bloku (ten sam układ co plik)
+static media_index_t *builder_finish(index_builder_t *b)
+{
+    size_t dirs_size = b->dir_count * sizeof(index_dir_t);
+    size_t tracks_size = b->track_count * sizeof(index_track_t);
+    size_t size = sizeof(index_header_t) + dirs_size + tracks_size + b->strings_size;
+
+    media_index_t *index = calloc(1, sizeof(media_index_t));
+    uint8_t *blob = heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+    if (index == NULL || blob == NULL) {
+        free(index);
+        free(blob);
+        return NULL;
+    }
+
+    uint8_t *p = blob + sizeof(index_header_t);
+    memcpy(p, b->dirs, dirs_size);
+    memcpy(p + dirs_size, b->tracks, tracks_size);
+    memcpy(p + dirs_size + tracks_size, b->strings, b->strings_size);
+
+    index_header_t *hdr = (index_header_t *)blob;
+    hdr->magic = INDEX_MAGIC;
+    hdr->version = INDEX_VERSION;
+    hdr->header_size = sizeof(index_header_t);
+    hdr->dir_count = b->dir_count;
+    hdr->track_count = b->track_count;
+    hdr->strings_size = b->strings_size;
+    hdr->checksum = fnv1a(2166136261u, p, size - sizeof(index_header_t));
+
+    index->blob = blob;
+    index->size = size;
+    index->hdr = hdr;
+    index->dirs = (const index_dir_t *)p;
+    index->tracks = (const index_track_t *)(p + dirs_size);
+    index->strings = (const char *)(p + dirs_size + tracks_size);
+    return index;
+}
+
+static void index_free(media_index_t *index)
+{
+    if (index == NULL) return;
+    free(index->blob);
+    free(index);
+}
+
+// ============================================
+// Plik indeksu
+// ============================================
+
+static media_index_t *index_load(void)
+{
+    FILE *f = fopen(MEDIA_INDEX_FILE, "rb");
+    if (f == NULL) return NULL;
+
+    index_header_t hdr;
+    media_index_t *index = NULL;
+    if (fread(&hdr, 1, sizeof(hdr), f) != sizeof(hdr) || hdr.magic != INDEX_MAGIC ||
+        hdr.version != INDEX_VERSION || hdr.header_size != sizeof(hdr) ||
+        hdr.dir_count > MEDIA_INDEX_MAX_DIRS || hdr.track_count > MEDIA_INDEX_MAX_TRACKS ||
+        hdr.strings_size == 0) {
+        ESP_LOGW(TAG, "Index file invalid or from another version, rebuilding");
+        fclose(f);
+        return NULL;
+    }
+
+    size_t size = sizeof(hdr) + hdr.dir_count * sizeof(index_dir_t) +
+                  hdr.track_count * sizeof(index_track_t) + hdr.strings_size;
+    uint8_t *blob = heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+    index = calloc(1, sizeof(media_index_t));
+    if (blob && index) {
+        memcpy(blob, &hdr, sizeof(hdr));
+        size_t body = size - sizeof(hdr);
+        if (fread(blob + sizeof(hdr), 1, body, f) == body &&
+            fnv1a(2166136261u, blob + sizeof(hdr), body) == hdr.checksum &&
+            blob[size - 1] == '\0') {
+            uint8_t *p = blob + sizeof(hdr);
+            index->blob = blob;
+            index->size = size;
+            index->hdr = (const index_header_t *)blob;
+            index->dirs = (const index_dir_t *)p;
+            index->tracks = (const index_track_t *)(p + hdr.dir_count * sizeof(index_dir_t));
+            index->strings = (const char *)(p + hdr.dir_count * sizeof(index_dir_t) +
+                                            hdr.track_count * sizeof(index_track_t));
+            fclose(f);
+            return index;
+        }
+        ESP_LOGW(TAG, "Index file corrupted, rebuilding");
+    }
+
+    fclose(f);
+    free(blob);
+    free(index);
+    return NULL;
+}
+
+// Zapis przez plik tymczasowy - przerwany zapis nie niszczy poprzedniego indeksu
+static bool index_save(const media_index_t *index)
+{
+    FILE *f = fopen(INDEX_TMP_FILE, "wb");
+    if (f == NULL) {
+        ESP_LOGE(TAG, "Cannot create %s", INDEX_TMP_FILE);
+        return false;
+    }
+    bool ok = fwrite(index->blob, 1, index->size, f) == index->size;
+    ok = (fclose(f) == 0) && ok;
+
+    if (ok) {
+        unlink(MEDIA_INDEX_FILE);  // FAT: rename nie nadpisuje istniejącego pliku
+        ok = rename(INDEX_TMP_FILE, MEDIA_INDEX_FILE) == 0;
+    }
+    if (!ok) {
+        ESP_LOGE(TAG, "Failed to write index file");
+        unlink(INDEX_TMP_FILE);
+    }
+    return ok;
+}
+
+// ============================================
+// Skan karty
+// ============================================
+
+static void names_free(name_list_t *list)
+{
+    free(list->names);
+    free(list->offsets);
+    memset(list, 0, sizeof(*list));
+}
+
+static bool names_add(name_list_t *list, const char *name)
+{
+    size_t len = strlen(name) + 1;
+    if (!grow((void **)&list->names, &list->names_cap, list->names_size + len, 1) ||
+        !grow((void **)&list->offsets, &list->cap, list->count + 1, sizeof(uint32_t))) {
+        return false;
+    }
+    memcpy(list->names + list->names_size, name, len);
+    list->offsets[list->count++] = list->names_size;
+    list->names_size += len;
+    return true;
+}
+
+static const char *sort_names;  // qsort bez kontekstu - skan działa w jednym tasku
+
+static int name_cmp(const void *a, const void *b)
+{
+    return strcasecmp(sort_names + *(const uint32_t *)a, sort_names + *(const uint32_t *)b);
+}
+
+// Czyta katalog jednym przebiegiem readdir (bez stat): podkatalogi, potem pliki audio,
+// każda grupa alfabetycznie. Zwraca false, jeśli katalogu nie da się otworzyć.
+static bool read_dir_names(const char *full_path, name_list_t *list, uint32_t *signature)
+{
+    DIR *dir = opendir(full_path);
+    if (dir == NULL) return false;
+
+    name_list_t files = {0};
+    list->count = 0;
+    list->names_size = 0;
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.' || strcmp(entry->d_name, "System Volume Information") == 0) {
+            continue;  // Ukryte, w tym sam plik indeksu
+        }
+        if (entry->d_type == DT_DIR) {
+            names_add(list, entry->d_name);
+        } else if (is_audio_name(entry->d_name)) {
+            names_add(&files, entry->d_name);
+        }
+    }
+    closedir(dir);
+
+    list->dir_count = list->count;
+    for (uint32_t i = 0; i < files.count; i++) {
+        names_add(list, files.names + files.offsets[i]);
+    }
+    names_free(&files);
+
+    sort_names = list->names;
+    qsort(list->offsets, list->dir_count, sizeof(uint32_t), name_cmp);
+    qsort(list->offsets + list->dir_count, list->count - list->dir_count, sizeof(uint32_t), name_cmp);
+
+    uint32_t h = 2166136261u;
+    for (uint32_t i = 0; i < list->count; i++) {
+        const char *name = list->names + list->offsets[i];
+        h = fnv1a(h, name, strlen(name) + 1);
+    }
+    h = fnv1a(h, &list->dir_count, sizeof(list->dir_count));
+    *signature = h;
+    return true;
+}
+
+// Katalog w starym indeksie (zwykle pod tym samym numerem - najpierw podpowiedź)
+static const index_dir_t *old_dir_find(const media_index_t *old, const char *path, uint32_t hint)
+{
+    if (old == NULL) return NULL;
+    uint32_t count = old->hdr->dir_count;
+    if (hint < count && strcmp(old->strings + old->dirs[hint].path, path) == 0) {
+        return &old->dirs[hint];
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        if (strcmp(old->strings + old->dirs[i].path, path) == 0) {
+            return &old->dirs[i];
+        }
+    }
+    return NULL;
+}
+
+static const index_track_t *old_track_find(const media_index_t *old, const index_dir_t *dir,
+                                           const char *name)
+{
+    if (old == NULL || dir == NULL) return NULL;
+    for (uint32_t i = 0; i < dir->track_count; i++) {
+        const index_track_t *t = &old->tracks[dir->first_track + i];
+        if (strcmp(old->strings + t->name, name) == 0) return t;
+    }
+    return NULL;
+}
+
+static void copy_track(index_builder_t *b, index_track_t *dst, const media_index_t *old,
+                       const index_track_t *src)
+{
+    dst->title = builder_string(b, old->strings + src->title);
+    dst->artist = builder_string(b, old->strings + src->artist);
+    dst->album = builder_string(b, old->strings + src->album);
+    dst->size = src->size;
+    dst->duration_ms = src->duration_ms;
+    dst->track = src->track;
+}
+
+static void read_track_tags(index_builder_t *b, index_track_t *track, const char *full_path)
+{
+    media_tags_t tags;
+    FILE *f = fopen(full_path, "rb");
+    if (f == NULL) return;
+    media_tags_read(f, &tags);
+    fclose(f);
+
+    track->title = builder_string(b, tags.title);
+    track->artist = builder_string(b, tags.artist);
+    track->album = builder_string(b, tags.album);
+    track->duration_ms = tags.duration_ms;
+    track->track = tags.track;
+}
+
+// Przerwa po każdym otwartym pliku - gdy gra karta, odczyt dla odtwarzania ma pierwszeństwo
+static void scan_yield(void)
+{
+    player_status_t status;
+    audio_player_get_status(&status);
+    bool sd_playing = status.source == AUDIO_SOURCE_SDCARD && status.state != PLAYER_STATE_STOPPED;
+    vTaskDelay(sd_playing ? pdMS_TO_TICKS(INDEXER_SD_PLAY_DELAY_MS) : 1);
+}
+
+// Pełne przejście karty. Katalog z tym samym mtime i podpisem nazw jest przepisywany
+// ze starego indeksu; w zmienionym ponownie czytane są tylko pliki nowe lub o innym
+// rozmiarze. Zwraca nowy indeks lub NULL, jeśli nic się nie zmieniło (albo błąd).
+static media_index_t *scan_card(const media_index_t *old)
+{
+    index_builder_t b;
+    name_list_t names = {0};
+    static char full_path[INDEX_PATH_MAX + 32];
+    static char child[INDEX_PATH_MAX];
+    bool changed = (old == NULL);
+
+    if (!builder_init(&b) || builder_add_dir(&b, "/", INDEX_NONE) == INDEX_NONE) {
+        builder_free(&b);
+        return NULL;
+    }
+
+    for (uint32_t d = 0; d < b.dir_count && !b.failed; d++) {
+        // Kopia ścieżki - tablica napisów może się przenieść przy dodawaniu
+        char path[INDEX_PATH_MAX];
+        strncpy(path, b.strings + b.dirs[d].path, sizeof(path) - 1);
+        path[sizeof(path) - 1] = '\0';
+        const char *sep = strcmp(path, "/") == 0 ? "" : path;
+        snprintf(full_path, sizeof(full_path), "%s%s", SD_MOUNT_POINT, sep);
+
+        uint32_t signature = 0;
+        if (!read_dir_names(full_path, &names, &signature)) {
+            if (d == 0) {
+                ESP_LOGW(TAG, "Card not readable, scan aborted");
+                b.failed = true;
+            }
+            continue;
+        }
+
+        struct stat st;
+        uint32_t mtime = (stat(full_path, &st) == 0) ? (uint32_t)st.st_mtime : 0;
+        const index_dir_t *old_dir = old_dir_find(old, path, d);
+        // Sam mtime bez zmiany listy nazw nie wymaga zapisu indeksu (np. zapis pliku indeksu
+        // w katalogu głównym) - pliki są wtedy tylko sprawdzane po rozmiarze
+        bool same = old_dir && old_dir->mtime == mtime && old_dir->signature == signature;
+        if (old_dir == NULL || old_dir->signature != signature) changed = true;
+
+        b.dirs[d].mtime = mtime;
+        b.dirs[d].signature = signature;
+        b.dirs[d].first_track = b.track_count;
+
+        for (uint32_t i = names.dir_count; i < names.count; i++) {
+            const char *name = names.names + names.offsets[i];
+            index_track_t *track = builder_add_track(&b);
+            if (track == NULL) {
+                ESP_LOGW(TAG, "Track limit reached (%d)", MEDIA_INDEX_MAX_TRACKS);
+                break;
+            }
+            track->name = builder_string(&b, name);
+            track->dir = d;
+
+            const index_track_t *old_track = old_track_find(old, old_dir, name);
+            if (same && old_track) {
+                copy_track(&b, track, old, old_track);
+                continue;
+            }
+
+            snprintf(full_path, sizeof(full_path), "%s%s/%s", SD_MOUNT_POINT, sep, name);
+            track->size = (stat(full_path, &st) == 0) ? (uint32_t)st.st_size : 0;
+            if (old_track && old_track->size == track->size) {
+                copy_track(&b, track, old, old_track);  // Ten sam plik w zmienionym katalogu
+            } else {
+                read_track_tags(&b, track, full_path);
+                scan_status.scan_parsed++;
+                changed = true;
+                scan_yield();
+            }
+        }
+        b.dirs[d].track_count = b.track_count - b.dirs[d].first_track;
+
+        b.dirs[d].first_child = b.dir_count;
+        for (uint32_t i = 0; i < names.dir_count; i++) {
+            int len = snprintf(child, sizeof(child), "%s/%s", sep, names.names + names.offsets[i]);
+            if (len >= (int)sizeof(child)) continue;  // Za długa ścieżka
+            if (builder_add_dir(&b, child, d) == INDEX_NONE) {
+                ESP_LOGW(TAG, "Directory limit reached (%d)", MEDIA_INDEX_MAX_DIRS);
+                break;
+            }
+        }
+        b.dirs[d].child_count = b.dir_count - b.dirs[d].first_child;
+
+        scan_status.scan_dirs = d + 1;
+        vTaskDelay(1);
+    }
+    names_free(&names);
+
+    if (old && (old->hdr->dir_count != b.dir_count || old->hdr->track_count != b.track_count)) {
+        changed = true;  // Usunięte katalogi lub pliki
+    }
+
+    media_index_t *index = NULL;
+    if (b.failed) {
+        ESP_LOGE(TAG, "Scan failed (out of memory or card removed)");
+    } else if (changed) {
+        index = builder_finish(&b);
+    }
+    builder_free(&b);
+    return index;
+}
+
+// ============================================
+// Tabele ramek MP3
+// ============================================
+
+// Plik tabeli w MEDIA_SEEK_DIR - nazwa z hasha ścieżki względem karty
+static void seek_table_path(const char *path, char *out, size_t size)
+{
+    char rel[INDEX_PATH_MAX];
+    normalize_path(path, rel, sizeof(rel));
+    snprintf(out, size, MEDIA_SEEK_DIR "/%08lx.idx",
+             (unsigned long)fnv1a(2166136261u, rel, strlen(rel)));
+}
+
+// Przejście po ramkach pliku odtwarzanego po raz pierwszy. MP3 z VBRI lub stałym
+// bitrate pozycjonuje się bez tabeli - dla nich plik nie jest czytany do końca.
+static void build_seek_table(void)
+{
+    char path[INDEX_PATH_MAX];
+    xSemaphoreTake(index_lock, portMAX_DELAY);
+    strcpy(path, seek_pending);
+    seek_pending[0] = '\0';
+    xSemaphoreGive(index_lock);
+
+    struct stat st;
+    if (path[0] == '\0' || stat(path, &st) != 0) return;
+
+    char table_path[sizeof(MEDIA_SEEK_DIR) + 16];
+    seek_table_path(path, table_path, sizeof(table_path));
+    seek_mp3_table_t table;
+    if (seek_index_mp3_load(table_path, st.st_size, &table)) {
+        seek_index_mp3_free(&table);
+        return;  // Zbudowana przy poprzednim odtworzeniu
+    }
+
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) return;
+
+    uint32_t started = now_ms();
+    bool built = seek_index_mp3_needs_table(f) && seek_index_mp3_build(f, &table);
+    fclose(f);
+    if (!built) return;
+
+    mkdir(MEDIA_SEEK_DIR, 0775);
+    bool saved = seek_index_mp3_save(table_path, &table);
+    ESP_LOGI(TAG, "Seek table for %s: %lu frames in %lu ms%s", path,
+             (unsigned long)table.total_frames, (unsigned long)(now_ms() - started),
+             saved ? "" : " (not saved)");
+    seek_index_mp3_free(&table);
+}
+
+static void indexer_task(void *pvParameters)
+{
+    while (1) {
+        uint32_t bits = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &bits, portMAX_DELAY);
+
+        // Tabela dla odtwarzanego pliku przed skanem - przewijanie czeka na nią
+        if (bits & INDEXER_SEEK_TABLE) {
+            build_seek_table();
+        }
+        if (!(bits & INDEXER_RESCAN)) {
+            continue;
+        }
+
+        uint32_t started = now_ms();
+        scan_status.scanning = true;
+        scan_status.scan_dirs = 0;
+        scan_status.scan_parsed = 0;
+
+        // Stary indeks tylko do odczytu - zapytania korzystają z niego w trakcie skanu
+        media_index_t *index = scan_card(current);
+        if (index) {
+            index_save(index);
+
+            xSemaphoreTake(index_lock, portMAX_DELAY);
+            media_index_t *old = current;
+            current = index;
+            xSemaphoreGive(index_lock);
+            index_free(old);
+        }
+
+        scan_status.last_scan_ms = now_ms() - started;
+        scan_status.scanning = false;
+        ESP_LOGI(TAG, "Scan done in %lu ms: %lu dirs, %lu files parsed%s",
+                 (unsigned long)scan_status.last_scan_ms, (unsigned long)scan_status.scan_dirs,
+                 (unsigned long)scan_status.scan_parsed, index ? "" : " (index unchanged)");
+    }
+}
+
+// ============================================
+// Zapytania
+// ============================================
+
+static const index_dir_t *dir_find(const media_index_t *index, const char *path)
+{
+    for (uint32_t i = 0; i < index->hdr->dir_count; i++) {
+        if (strcmp(index->strings + index->dirs[i].path, path) == 0) {
+            return &index->dirs[i];
+        }
+    }
+    return NULL;
+}
+
+static void fill_track_info(const media_index_t *index, const index_track_t *t, sd_file_info_t *info)
+{
+    const char *dir = index->strings + index->dirs[t->dir].path;
+    const char *name = index->strings + t->name;
+
+    memset(info, 0, sizeof(*info));
+    strncpy(info->filename, name, sizeof(info->filename) - 1);
+    snprintf(info->filepath, sizeof(info->filepath), "%s/%s", strcmp(dir, "/") ? dir : "", name);
+    if (t->title) {
+        strncpy(info->title, index->strings + t->title, sizeof(info->title) - 1);
+    } else {
+        // Bez tagu - tytuł z nazwy pliku jak w sdcard_player
+        strncpy(info->title, name, sizeof(info->title) - 1);
+        char *dot = strrchr(info->title, '.');
+        if (dot) *dot = '\0';
+    }
+    strncpy(info->artist, index->strings + t->artist, sizeof(info->artist) - 1);
+    strncpy(info->album, index->strings + t->album, sizeof(info->album) - 1);
+    info->duration_ms = t->duration_ms;
+    info->file_size = t->size;
+}
+
+static sd_file_info_t *alloc_files(int count)
+{
+    // Jak sdcard_player_scan_directory - zwalniane przez free()
+    return heap_caps_malloc((count > 0 ? count : 1) * sizeof(sd_file_info_t),
+                            MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+}
+
+bool media_index_lookup(const char *path, sd_file_info_t *info)
+{
+    if (index_lock == NULL) return false;
+
+    char norm[INDEX_PATH_MAX];
+    normalize_path(path, norm, sizeof(norm));
+    char *slash = strrchr(norm, '/');
+    const char *name = slash + 1;
+    *slash = '\0';
+    const char *dir_path = norm[0] ? norm : "/";
+
+    bool found = false;
+    xSemaphoreTake(index_lock, portMAX_DELAY);
+    const index_dir_t *dir = current ? dir_find(current, dir_path) : NULL;
+    if (dir) {
+        // Utwory katalogu posortowane - wyszukiwanie binarne
+        int lo = 0, hi = (int)dir->track_count - 1;
+        while (lo <= hi) {
+            int mid = (lo + hi) / 2;
+            const index_track_t *t = &current->tracks[dir->first_track + mid];
+            int cmp = strcasecmp(name, current->strings + t->name);
+            if (cmp == 0) {
+                fill_track_info(current, t, info);
+                found = true;
+                break;
+            }
+            if (cmp < 0) hi = mid - 1; else lo = mid + 1;
+        }
+    }
+    xSemaphoreGive(index_lock);
+    return found;
+}
+
+esp_err_t media_index_list_dir(const char *path, sd_file_info_t **files, int *count)
+{
+    if (index_lock == NULL) return ESP_ERR_NOT_FOUND;
+
+    char norm[INDEX_PATH_MAX];
+    normalize_path(path, norm, sizeof(norm));
+
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    xSemaphoreTake(index_lock, portMAX_DELAY);
+    const index_dir_t *dir = current ? dir_find(current, norm) : NULL;
+    if (dir) {
+        int total = dir->child_count + dir->track_count;
+        *files = alloc_files(total);
+        if (*files == NULL) {
+            ret = ESP_ERR_NO_MEM;
+        } else {
+            int n = 0;
+            for (uint32_t i = 0; i < dir->child_count; i++) {
+                const char *child = current->strings + current->dirs[dir->first_child + i].path;
+                const char *name = strrchr(child, '/') + 1;
+                sd_file_info_t *info = &(*files)[n++];
+                memset(info, 0, sizeof(*info));
+                strncpy(info->filename, name, sizeof(info->filename) - 1);
+                strncpy(info->filepath, child, sizeof(info->filepath) - 1);
+                info->is_directory = true;
+            }
+            for (uint32_t i = 0; i < dir->track_count; i++) {
+                fill_track_info(current, &current->tracks[dir->first_track + i], &(*files)[n++]);
+            }
+            *count = n;
+            ret = ESP_OK;
+        }
+    }
+    xSemaphoreGive(index_lock);
+    return ret;
+}
+
+int media_index_list_dir_page(const char *path, int offset, int limit,
+                              media_index_entry_cb_t cb, void *ctx)
+{
+    if (index_lock == NULL) return -1;
+
+    char norm[INDEX_PATH_MAX];
+    normalize_path(path, norm, sizeof(norm));
+
+    int total = -1;
+    xSemaphoreTake(index_lock, portMAX_DELAY);
+    const index_dir_t *dir = current ? dir_find(current, norm) : NULL;
+    if (dir) {
+        static sd_file_info_t info;  // Pod index_lock - poza stosem wołającego
+        total = dir->child_count + dir->track_count;
+        for (int i = offset; i < total && i < offset + limit; i++) {
+            if (i < (int)dir->child_count) {
+                const char *child = current->strings + current->dirs[dir->first_child + i].path;
+                memset(&info, 0, sizeof(info));
+                strncpy(info.filename, strrchr(child, '/') + 1, sizeof(info.filename) - 1);
+                strncpy(info.filepath, child, sizeof(info.filepath) - 1);
+                info.is_directory = true;
+            } else {
+                fill_track_info(current, &current->tracks[dir->first_track + i - dir->child_count], &info);
+            }
+            if (!cb(&info, ctx)) break;
+        }
+    }
+    xSemaphoreGive(index_lock);
+    return total;
+}
+
+static bool track_matches(const media_index_t *index, const index_track_t *t, media_field_t field,
+                          const char *value, size_t value_len, bool exact)
+{
+    uint32_t offsets[4];
+    int n = 0;
+    if (field == MEDIA_FIELD_TITLE || field == MEDIA_FIELD_ANY) offsets[n++] = t->title;
+    if (field == MEDIA_FIELD_ARTIST || field == MEDIA_FIELD_ANY) offsets[n++] = t->artist;
+    if (field == MEDIA_FIELD_ALBUM || field == MEDIA_FIELD_ANY) offsets[n++] = t->album;
+    if (field == MEDIA_FIELD_ANY) offsets[n++] = t->name;
+
+    for (int i = 0; i < n; i++) {
+        const char *s = index->strings + offsets[i];
+        if (exact ? strcasecmp(s, value) == 0 : contains_nocase(s, value, value_len)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static const media_index_t *sort_index;  // qsort bez kontekstu - pod index_lock
+
+static int track_order_cmp(const void *a, const void *b)
+{
+    const index_track_t *ta = &sort_index->tracks[*(const uint32_t *)a];
+    const index_track_t *tb = &sort_index->tracks[*(const uint32_t *)b];
+    if (ta->track != tb->track) return (int)ta->track - (int)tb->track;
+    return (int)(*(const uint32_t *)a - *(const uint32_t *)b);  // Kolejność w katalogu
+}
+
+esp_err_t media_index_find(media_field_t field, const char *value, bool exact,
+                           int offset, int limit, sd_file_info_t **files, int *count, int *total)
+{
+    if (value == NULL || value[0] == '\0' || offset < 0 || limit <= 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (index_lock == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    *files = NULL;
+    *count = 0;
+    *total = 0;
+
+    xSemaphoreTake(index_lock, portMAX_DELAY);
+    if (current == NULL) {
+        xSemaphoreGive(index_lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint32_t track_count = current->hdr->track_count;
+    uint32_t *matches = heap_caps_malloc((track_count ? track_count : 1) * sizeof(uint32_t),
+                                         MALLOC_CAP_SPIRAM);
+    if (matches == NULL) {
+        xSemaphoreGive(index_lock);
+        return ESP_ERR_NO_MEM;
+    }
+
+    size_t value_len = strlen(value);
+    int n = 0;
+    for (uint32_t i = 0; i < track_count; i++) {
+        if (track_matches(current, &current->tracks[i], field, value, value_len, exact)) {
+            matches[n++] = i;
+        }
+    }
+    if (field == MEDIA_FIELD_ALBUM && exact) {
+        sort_index = current;
+        qsort(matches, n, sizeof(uint32_t), track_order_cmp);
+    }
+
+    int returned = n - offset;
+    if (returned > limit) returned = limit;
+    esp_err_t ret = ESP_OK;
+    if (returned > 0) {
+        *files = alloc_files(returned);
+        if (*files == NULL) {
+            ret = ESP_ERR_NO_MEM;
+            returned = 0;
+        }
+        for (int i = 0; i < returned; i++) {
+            fill_track_info(current, &current->tracks[matches[offset + i]], &(*files)[i]);
+        }
+    }
+    xSemaphoreGive(index_lock);
+
+    free(matches);
+    *count = returned > 0 ? returned : 0;
+    *total = n;
+    return ret;
+}
+
+static int value_cmp(const void *a, const void *b)
+{
+    return strcasecmp(sort_index->strings + *(const uint32_t *)a,
+                      sort_index->strings + *(const uint32_t *)b);
+}
+
+int media_index_list_values(media_field_t field, int offset, int limit,
+                            media_index_value_cb_t cb, void *ctx)
+{
+    if ((field != MEDIA_FIELD_ARTIST && field != MEDIA_FIELD_ALBUM) || index_lock == NULL) {
+        return -1;
+    }
+
+    xSemaphoreTake(index_lock, portMAX_DELAY);
+    if (current == NULL) {
+        xSemaphoreGive(index_lock);
+        return -1;
+    }
+
+    // Napisy są bez powtórzeń - różne wartości to różne offsety (mapa bitowa po offsetach)
+    uint32_t track_count = current->hdr->track_count;
+    uint32_t strings_size = current->hdr->strings_size;
+    uint8_t *seen = heap_caps_calloc(strings_size / 8 + 1, 1, MALLOC_CAP_SPIRAM);
+    uint32_t *values = heap_caps_malloc((track_count ? track_count : 1) * sizeof(uint32_t),
+                                        MALLOC_CAP_SPIRAM);
+    int n = -1;
+    if (seen && values) {
+        n = 0;
+        for (uint32_t i = 0; i < track_count; i++) {
+            const index_track_t *t = &current->tracks[i];
+            uint32_t s = (field == MEDIA_FIELD_ARTIST) ? t->artist : t->album;
+            if (s == 0 || (seen[s / 8] & (1 << (s % 8)))) continue;
+            seen[s / 8] |= 1 << (s % 8);
+            values[n++] = s;
+        }
+        sort_index = current;
+        qsort(values, n, sizeof(uint32_t), value_cmp);
+        for (int i = offset; i < n && i < offset + limit; i++) {
+            cb(current->strings + values[i], ctx);
+        }
+    }
+    xSemaphoreGive(index_lock);
+
+    free(seen);
+    free(values);
+    return n;
+}
+
+// ============================================
+// Publiczne API
+// ============================================
+
+esp_err_t media_index_init(void)
+{
+    if (indexer_task_handle) {
+        return media_index_rescan();
+    }
+
+    if (index_lock == NULL) {
+        index_lock = xSemaphoreCreateMutex();
+        if (index_lock == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    uint32_t started = now_ms();
+    if (current == NULL) {
+        current = index_load();
+    }
+    if (current) {
+        ESP_LOGI(TAG, "Index loaded in %lu ms: %lu dirs, %lu tracks, %lu bytes",
+                 (unsigned long)(now_ms() - started), (unsigned long)current->hdr->dir_count,
+                 (unsigned long)current->hdr->track_count, (unsigned long)current->size);
+    }
+
+    if (xTaskCreate(indexer_task, "media_index", INDEXER_STACK_SIZE, NULL, INDEXER_PRIORITY,
+                    &indexer_task_handle) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create indexer task");
+        return ESP_FAIL;
+    }
+    return media_index_rescan();
+}
+
+esp_err_t media_index_rescan(void)
+{
+    if (indexer_task_handle == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xTaskNotify(indexer_task_handle, INDEXER_RESCAN, eSetBits);  // W trakcie skanu - jeden kolejny
+    return ESP_OK;
+}
+
+esp_err_t media_index_request_seek_table(const char *path)
+{
+    if (indexer_task_handle == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(index_lock, portMAX_DELAY);
+    strncpy(seek_pending, path, sizeof(seek_pending) - 1);  // Tylko najnowszy plik
+    xSemaphoreGive(index_lock);
+    xTaskNotify(indexer_task_handle, INDEXER_SEEK_TABLE, eSetBits);
+    return ESP_OK;
+}
+
+bool media_index_load_seek_table(const char *path, uint32_t file_size, seek_mp3_table_t *table)
+{
+    char table_path[sizeof(MEDIA_SEEK_DIR) + 16];
+    seek_table_path(path, table_path, sizeof(table_path));
+    return seek_index_mp3_load(table_path, file_size, table);
+}
+
+void media_index_get_status(media_index_status_t *status)
+{
+    if (status == NULL) return;
+
+    *status = scan_status;
+    if (index_lock == NULL) return;
+
+    xSemaphoreTake(index_lock, portMAX_DELAY);
+    status->ready = (current != NULL);
+    if (current) {
+        status->dirs = current->hdr->dir_count;
+        status->tracks = current->hdr->track_count;
+        status->index_bytes = current->size;
+    }
+    xSemaphoreGive(index_lock);
+}
@@ -0,0 +1,84 @@
+/*
+ * Media Index Module
+ * Indeks biblioteki na karcie SD: katalogi, pliki audio i ich tagi w jednym pliku
+ * binarnym (MEDIA_INDEX_FILE). Task o niskim priorytecie skanuje kartę przyrostowo -
+ * katalogi bez zmian są przepisywane ze starego indeksu bez otwierania plików.
+ * Przeglądanie, wyszukiwanie i playlisty według wykonawcy/albumu bez skanowania FAT.
+ */
+
+#ifndef MEDIA_INDEX_H
+#define MEDIA_INDEX_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include "sdcard_player.h"
+#include "seek_index.h"
+
+#define MEDIA_INDEX_MAX_DIRS        4096
+#define MEDIA_INDEX_MAX_TRACKS      20000
+
+// Pole tagu w zapytaniach
+typedef enum {
+    MEDIA_FIELD_ANY = 0,        // Tytuł, wykonawca, album lub nazwa pliku
+    MEDIA_FIELD_TITLE,
+    MEDIA_FIELD_ARTIST,
+    MEDIA_FIELD_ALBUM,
+} media_field_t;
+
+typedef struct {
+    bool ready;                 // Indeks wczytany - zapytania działają
+    bool scanning;              // Skan w toku (zapytania odpowiadają ze starego indeksu)
+    uint32_t dirs;
+    uint32_t tracks;
+    uint32_t index_bytes;       // Rozmiar indeksu (plik i kopia w PSRAM)
+    uint32_t scan_dirs;         // Postęp bieżącego / wynik ostatniego skanu
+    uint32_t scan_parsed;       // Pliki, których tagi czytano (reszta z poprzedniego indeksu)
+    uint32_t last_scan_ms;      // Czas ostatniego skanu
+} media_index_status_t;
+
+typedef void (*media_index_value_cb_t)(const char *value, void *ctx);
+
+// Wczytuje indeks z karty i zleca skan przyrostowy (kolejne wywołania - tylko skan)
+esp_err_t media_index_init(void);
+esp_err_t media_index_rescan(void);
+void media_index_get_status(media_index_status_t *status);
+
+// Ścieżki względem karty ("/muzyka/a.mp3"); przyjmowane także z SD_MOUNT_POINT na początku.
+// Wyniki alokowane jak w sdcard_player_scan_directory() - zwalniane przez
+// sdcard_player_free_file_list().
+
+// Tagi pliku z indeksu; false - pliku nie ma w indeksie
+bool media_index_lookup(const char *path, sd_file_info_t *info);
+
+// Zawartość katalogu (podkatalogi, potem pliki; alfabetycznie).
+// ESP_ERR_NOT_FOUND - katalogu nie ma w indeksie (np. przed pierwszym skanem)
+esp_err_t media_index_list_dir(const char *path, sd_file_info_t **files, int *count);
+
+// Strona katalogu bez alokacji listy: cb dla wpisów [offset, offset + limit), false - koniec.
+// cb wołane pod blokadą indeksu. Zwraca liczbę wszystkich wpisów lub -1, gdy katalogu
+// nie ma w indeksie.
+typedef bool (*media_index_entry_cb_t)(const sd_file_info_t *info, void *ctx);
+int media_index_list_dir_page(const char *path, int offset, int limit,
+                              media_index_entry_cb_t cb, void *ctx);
+
+// Utwory pasujące do zapytania: exact - równe wartości pola, inaczej - zawierające
+// (bez rozróżniania wielkości liter). Album w kolejności numerów utworów.
+// *total - wszystkie trafienia, *count - zwrócone od offset (najwyżej limit).
+esp_err_t media_index_find(media_field_t field, const char *value, bool exact,
+                           int offset, int limit, sd_file_info_t **files, int *count, int *total);
+
+// Różne wartości pola (wykonawcy, albumy) alfabetycznie, od offset najwyżej limit.
+// Zwraca liczbę wszystkich wartości lub -1 gdy indeks niegotowy.
+int media_index_list_values(media_field_t field, int offset, int limit,
+                            media_index_value_cb_t cb, void *ctx);
+
+// Tabela ramek MP3 do przewijania (seek_index): task indeksera buduje ją w tle dla pliku
+// bez dokładnego TOC i zapisuje w MEDIA_SEEK_DIR. Wcześniejsze niewykonane żądanie
+// jest zastępowane.
+esp_err_t media_index_request_seek_table(const char *path);
+
+// Zapisana tabela pliku; false - jeszcze nie zbudowana lub plik się zmienił
+bool media_index_load_seek_table(const char *path, uint32_t file_size, seek_mp3_table_t *table);
+
+#endif // MEDIA_INDEX_H
@@ -0,0 +1,521 @@
+/*
+ * Media Tags Module
+ * Parsery tagów ID3v2/ID3v1, FLAC (Vorbis comment), MP4 (ilst) i WAV (LIST/INFO)
+ */
+
+#include <string.h>
+#include <strings.h>
+#include <stdlib.h>
+#include "media_tags.h"
+#include "codec_detect.h"
+
+#define TAG_FRAME_MAX       512     // Dłuższe ramki tekstowe są przycinane
+#define MP3_PROBE_SIZE      2048    // Dane za tagiem ID3 do odczytu bitrate
+
+// ============================================
+// Pomocnicze
+// ============================================
+
+static uint32_t be16(const uint8_t *p) { return (p[0] << 8) | p[1]; }
+static uint32_t be24(const uint8_t *p) { return (p[0] << 16) | (p[1] << 8) | p[2]; }
+static uint32_t be32(const uint8_t *p) { return ((uint32_t)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3]; }
+static uint32_t le32(const uint8_t *p) { return ((uint32_t)p[3] << 24) | (p[2] << 16) | (p[1] << 8) | p[0]; }
+static uint32_t syncsafe32(const uint8_t *p)
+{
+    return ((p[0] & 0x7f) << 21) | ((p[1] & 0x7f) << 14) | ((p[2] & 0x7f) << 7) | (p[3] & 0x7f);
+}
+
+static long file_size(FILE *f)
+{
+    long pos = ftell(f);
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, pos, SEEK_SET);
+    return size;
+}
+
+static bool read_at(FILE *f, long pos, void *buf, size_t len)
+{
+    return fseek(f, pos, SEEK_SET) == 0 && fread(buf, 1, len, f) == len;
+}
+
+static void put_utf8(char *out, size_t size, size_t *pos, uint32_t cp)
+{
+    char tmp[4];
+    size_t n;
+    if (cp < 0x80) {
+        tmp[0] = cp; n = 1;
+    } else if (cp < 0x800) {
+        tmp[0] = 0xc0 | (cp >> 6); tmp[1] = 0x80 | (cp & 0x3f); n = 2;
+    } else if (cp < 0x10000) {
+        tmp[0] = 0xe0 | (cp >> 12); tmp[1] = 0x80 | ((cp >> 6) & 0x3f);
+        tmp[2] = 0x80 | (cp & 0x3f); n = 3;
+    } else {
+        tmp[0] = 0xf0 | (cp >> 18); tmp[1] = 0x80 | ((cp >> 12) & 0x3f);
+        tmp[2] = 0x80 | ((cp >> 6) & 0x3f); tmp[3] = 0x80 | (cp & 0x3f); n = 4;
+    }
+    if (*pos + n >= size) return;  // Nie ucinaj znaku w połowie
+    memcpy(out + *pos, tmp, n);
+    *pos += n;
+}
+
+// Przycina białe znaki na końcu (ID3v1 dopełnia spacjami)
+static void trim_right(char *s)
+{
+    size_t len = strlen(s);
+    while (len > 0 && (s[len - 1] == ' ' || s[len - 1] == '\r' || s[len - 1] == '\n')) {
+        s[--len] = '\0';
+    }
+}
+
+static void copy_latin1(char *out, size_t size, const uint8_t *data, int len)
+{
+    size_t pos = 0;
+    for (int i = 0; i < len && data[i]; i++) {
+        put_utf8(out, size, &pos, data[i]);
+    }
+    out[pos] = '\0';
+    trim_right(out);
+}
+
+static void copy_utf8(char *out, size_t size, const uint8_t *data, int len)
+{
+    size_t n = 0;
+    while ((int)n < len && data[n]) n++;
+    if (n >= size) {
+        n = size - 1;
+        while (n > 0 && ((uint8_t)data[n] & 0xc0) == 0x80) n--;  // Granica znaku UTF-8
+    }
+    memcpy(out, data, n);
+    out[n] = '\0';
+    trim_right(out);
+}
+
+static void copy_utf16(char *out, size_t size, const uint8_t *data, int len, bool big_endian)
+{
+    if (len >= 2 && data[0] == 0xff && data[1] == 0xfe) {
+        big_endian = false; data += 2; len -= 2;
+    } else if (len >= 2 && data[0] == 0xfe && data[1] == 0xff) {
+        big_endian = true; data += 2; len -= 2;
+    }
+
+    size_t pos = 0;
+    for (int i = 0; i + 1 < len; i += 2) {
+        uint32_t cu = big_endian ? (data[i] << 8) | data[i + 1] : (data[i + 1] << 8) | data[i];
+        if (cu == 0) break;
+        if (cu >= 0xd800 && cu < 0xdc00 && i + 3 < len) {
+            uint32_t lo = big_endian ? (data[i + 2] << 8) | data[i + 3] : (data[i + 3] << 8) | data[i + 2];
+            if (lo >= 0xdc00 && lo < 0xe000) {
+                cu = 0x10000 + ((cu - 0xd800) << 10) + (lo - 0xdc00);
+                i += 2;
+            }
+        }
+        put_utf8(out, size, &pos, cu);
+    }
+    out[pos] = '\0';
+    trim_right(out);
+}
+
+static bool tags_found(const media_tags_t *tags)
+{
+    return tags->title[0] || tags->artist[0] || tags->album[0] || tags->duration_ms > 0;
+}
+
+// "3/12" -> 3
+static uint16_t parse_track(const char *s)
+{
+    int n = atoi(s);
+    return (n > 0 && n < 65536) ? n : 0;
+}
+
+// ============================================
+// ID3v2 / ID3v1
+// ============================================
+
+// Ramka tekstowa ID3v2: bajt kodowania + tekst
+static void id3_text(const uint8_t *data, int len, char *out, size_t size)
+{
+    if (len < 1) return;
+    switch (data[0]) {
+        case 0:  copy_latin1(out, size, data + 1, len - 1); break;
+        case 1:  copy_utf16(out, size, data + 1, len - 1, false); break;
+        case 2:  copy_utf16(out, size, data + 1, len - 1, true); break;
+        default: copy_utf8(out, size, data + 1, len - 1); break;
+    }
+}
+
+// Parsuje tag ID3v2 na początku pliku. Zwraca rozmiar tagu (0 - brak tagu).
+static long id3v2_read(FILE *f, media_tags_t *tags)
+{
+    uint8_t hdr[10];
+    if (!read_at(f, 0, hdr, sizeof(hdr)) || memcmp(hdr, "ID3", 3) != 0) {
+        return 0;
+    }
+
+    int version = hdr[3];
+    long tag_size = 10 + syncsafe32(hdr + 6) + ((hdr[5] & 0x10) ? 10 : 0);  // + stopka v2.4
+    if (version < 2 || version > 4) {
+        return tag_size;
+    }
+
+    long pos = 10;
+    long end = 10 + syncsafe32(hdr + 6);
+    if ((hdr[5] & 0x40) && version >= 3) {
+        // Nagłówek rozszerzony: v2.3 rozmiar bez pola rozmiaru, v2.4 syncsafe z polem
+        uint8_t ext[4];
+        if (!read_at(f, pos, ext, 4)) return tag_size;
+        pos += (version == 3) ? 4 + be32(ext) : syncsafe32(ext);
+    }
+
+    char album_artist[MEDIA_TAG_TEXT_LEN] = "";
+    uint8_t frame[TAG_FRAME_MAX];
+    int header_len = (version == 2) ? 6 : 10;
+
+    while (pos + header_len <= end) {
+        uint8_t fh[10];
+        if (!read_at(f, pos, fh, header_len) || fh[0] == 0) {
+            break;  // Dopełnienie zerami
+        }
+
+        char id[5] = {0};
+        uint32_t size;
+        if (version == 2) {
+            memcpy(id, fh, 3);
+            size = be24(fh + 3);
+        } else {
+            memcpy(id, fh, 4);
+            size = (version == 4) ? syncsafe32(fh + 4) : be32(fh + 4);
+        }
+        pos += header_len;
+        if (size == 0 || pos + (long)size > end) {
+            break;
+        }
+
+        char *field = NULL;
+        if (!strcmp(id, "TIT2") || !strcmp(id, "TT2")) field = tags->title;
+        else if (!strcmp(id, "TPE1") || !strcmp(id, "TP1")) field = tags->artist;
+        else if (!strcmp(id, "TALB") || !strcmp(id, "TAL")) field = tags->album;
+        else if (!strcmp(id, "TPE2") || !strcmp(id, "TP2")) field = album_artist;
+
+        bool is_track = !strcmp(id, "TRCK") || !strcmp(id, "TRK");
+        // Kompresja/szyfrowanie ramki (v2.3/v2.4) - pomijamy
+        bool plain = version == 2 || (version == 3 ? !(fh[9] & 0xc0) : !(fh[9] & 0x0c));
+
+        if ((field || is_track) && plain) {
+            int len = size < sizeof(frame) ? size : sizeof(frame);
+            if (read_at(f, pos, frame, len)) {
+                if (field) {
+                    id3_text(frame, len, field, MEDIA_TAG_TEXT_LEN);
+                } else {
+                    char track[16] = "";
+                    id3_text(frame, len, track, sizeof(track));
+                    tags->track = parse_track(track);
+                }
+            }
+        }
+        pos += size;  // Okładki (APIC) pomijane bez czytania
+    }
+
+    if (tags->artist[0] == '\0' && album_artist[0]) {
+        strcpy(tags->artist, album_artist);
+    }
+    return tag_size;
+}
+
+// ID3v1 na końcu pliku - tylko gdy ID3v2 nic nie dał
+static void id3v1_read(FILE *f, long size, media_tags_t *tags)
+{
+    uint8_t tag[128];
+    if (size < 128 || !read_at(f, size - 128, tag, sizeof(tag)) || memcmp(tag, "TAG", 3) != 0) {
+        return;
+    }
+    if (tags->title[0] == '\0') copy_latin1(tags->title, sizeof(tags->title), tag + 3, 30);
+    if (tags->artist[0] == '\0') copy_latin1(tags->artist, sizeof(tags->artist), tag + 33, 30);
+    if (tags->album[0] == '\0') copy_latin1(tags->album, sizeof(tags->album), tag + 63, 30);
+    if (tags->track == 0 && tag[125] == 0 && tag[126] != 0) {
+        tags->track = tag[126];  // ID3v1.1
+    }
+}
+
+// Długość MP3 z bitrate pierwszej ramki (dokładna dla CBR, szacunek dla VBR)
+static void mp3_duration(FILE *f, long audio_start, long size, media_tags_t *tags)
+{
+    uint8_t buf[MP3_PROBE_SIZE];
+    if (fseek(f, audio_start, SEEK_SET) != 0) return;
+    int len = fread(buf, 1, sizeof(buf), f);
+
+    codec_frame_info_t info = {0};
+    if (codec_detect_probe(buf, len, &info) == ESP_CODEC_TYPE_MP3 && info.bitrate_kbps > 0) {
+        int64_t audio_bytes = size - audio_start - info.offset;
+        tags->duration_ms = (uint32_t)(audio_bytes * 8 / info.bitrate_kbps);
+    }
+}
+
+// ============================================
+// FLAC
+// ============================================
+
+static void vorbis_comment(const char *comment, int len, media_tags_t *tags, char *album_artist)
+{
+    const char *eq = memchr(comment, '=', len);
+    if (eq == NULL) return;
+    int key_len = eq - comment;
+    const uint8_t *value = (const uint8_t *)eq + 1;
+    int value_len = len - key_len - 1;
+
+    if (key_len == 5 && !strncasecmp(comment, "TITLE", 5)) {
+        copy_utf8(tags->title, sizeof(tags->title), value, value_len);
+    } else if (key_len == 6 && !strncasecmp(comment, "ARTIST", 6)) {
+        copy_utf8(tags->artist, sizeof(tags->artist), value, value_len);
+    } else if (key_len == 5 && !strncasecmp(comment, "ALBUM", 5)) {
+        copy_utf8(tags->album, sizeof(tags->album), value, value_len);
+    } else if (key_len == 11 && !strncasecmp(comment, "ALBUMARTIST", 11)) {
+        copy_utf8(album_artist, MEDIA_TAG_TEXT_LEN, value, value_len);
+    } else if (key_len == 11 && !strncasecmp(comment, "TRACKNUMBER", 11)) {
+        char track[16];
+        copy_utf8(track, sizeof(track), value, value_len);
+        tags->track = parse_track(track);
+    }
+}
+
+static void flac_read(FILE *f, long pos, media_tags_t *tags)
+{
+    char album_artist[MEDIA_TAG_TEXT_LEN] = "";
+    char comment[TAG_FRAME_MAX];
+    pos += 4;  // "fLaC"
+
+    for (int blocks = 0; blocks < 64; blocks++) {
+        uint8_t hdr[4];
+        if (!read_at(f, pos, hdr, sizeof(hdr))) break;
+        bool last = hdr[0] & 0x80;
+        int type = hdr[0] & 0x7f;
+        uint32_t len = be24(hdr + 1);
+        long data = pos + 4;
+
+        if (type == 0 && len >= 18) {
+            // STREAMINFO: częstotliwość 20 bitów, liczba próbek 36 bitów
+            uint8_t si[18];
+            if (read_at(f, data, si, sizeof(si))) {
+                uint32_t rate = (si[10] << 12) | (si[11] << 4) | (si[12] >> 4);
+                uint64_t samples = ((uint64_t)(si[13] & 0x0f) << 32) | be32(si + 14);
+                if (rate > 0) {
+                    tags->duration_ms = (uint32_t)(samples * 1000 / rate);
+                }
+            }
+        } else if (type == 4) {
+            // VORBIS_COMMENT (little endian): vendor, liczba komentarzy, "KLUCZ=wartość"
+            uint8_t n[4];
+            long p = data;
+            long end = data + len;
+            if (!read_at(f, p, n, 4)) break;
+            p += 4 + le32(n);
+            if (!read_at(f, p, n, 4)) break;
+            uint32_t count = le32(n);
+            p += 4;
+            for (uint32_t i = 0; i < count && p + 4 <= end; i++) {
+                if (!read_at(f, p, n, 4)) break;
+                uint32_t clen = le32(n);
+                p += 4;
+                if (clen < sizeof(comment) && read_at(f, p, comment, clen)) {
+                    vorbis_comment(comment, clen, tags, album_artist);
+                }
+                p += clen;  // Długie (np. METADATA_BLOCK_PICTURE) pomijane
+            }
+        }
+
+        pos = data + len;
+        if (last) break;
+    }
+
+    if (tags->artist[0] == '\0' && album_artist[0]) {
+        strcpy(tags->artist, album_artist);
+    }
+}
+
+// ============================================
+// MP4 / M4A
+// ============================================
+
+// Szuka atomu type w zakresie [start, end); zwraca początek i rozmiar danych
+static bool mp4_find(FILE *f, long start, long end, const char *type, long *data, long *len)
+{
+    long pos = start;
+    while (pos + 8 <= end) {
+        uint8_t hdr[16];
+        if (!read_at(f, pos, hdr, 8)) return false;
+        uint64_t size = be32(hdr);
+        long header = 8;
+        if (size == 1) {
+            if (!read_at(f, pos + 8, hdr + 8, 8)) return false;
+            size = ((uint64_t)be32(hdr + 8) << 32) | be32(hdr + 12);
+            header = 16;
+        } else if (size == 0) {
+            size = end - pos;  // Do końca pliku
+        }
+        if (size < (uint64_t)header || pos + size > (uint64_t)end) return false;
+
+        if (memcmp(hdr + 4, type, 4) == 0) {
+            *data = pos + header;
+            *len = size - header;
+            return true;
+        }
+        pos += size;
+    }
+    return false;
+}
+
+// Wartość elementu ilst: atom "data" (typ, locale, wartość)
+static int mp4_item_value(FILE *f, long item, long item_len, uint8_t *buf, int buf_size)
+{
+    long data, len;
+    if (!mp4_find(f, item, item + item_len, "data", &data, &len) || len < 8) {
+        return -1;
+    }
+    int n = (len - 8) < buf_size ? (len - 8) : buf_size;
+    return read_at(f, data + 8, buf, n) ? n : -1;
+}
+
+static void mp4_read(FILE *f, long size, media_tags_t *tags)
+{
+    long moov, moov_len;
+    if (!mp4_find(f, 0, size, "moov", &moov, &moov_len)) {
+        return;
+    }
+
+    long mvhd, mvhd_len;
+    uint8_t hdr[32];
+    if (mp4_find(f, moov, moov + moov_len, "mvhd", &mvhd, &mvhd_len) && mvhd_len >= 32 &&
+        read_at(f, mvhd, hdr, 32)) {
+        uint32_t timescale;
+        uint64_t duration;
+        if (hdr[0] == 1) {
+            timescale = be32(hdr + 20);
+            duration = ((uint64_t)be32(hdr + 24) << 32) | be32(hdr + 28);
+        } else {
+            timescale = be32(hdr + 12);
+            duration = be32(hdr + 16);
+        }
+        if (timescale > 0) {
+            tags->duration_ms = (uint32_t)(duration * 1000 / timescale);
+        }
+    }
+
+    long udta, udta_len, meta, meta_len, ilst, ilst_len;
+    if (!mp4_find(f, moov, moov + moov_len, "udta", &udta, &udta_len) ||
+        !mp4_find(f, udta, udta + udta_len, "meta", &meta, &meta_len)) {
+        return;
+    }
+    // "meta" w ISO ma wersję/flagi, w QuickTime nie - rozpoznanie po atomie hdlr
+    if (read_at(f, meta + 4, hdr, 4) && memcmp(hdr, "hdlr", 4) != 0) {
+        meta += 4;
+        meta_len -= 4;
+    }
+    if (!mp4_find(f, meta, meta + meta_len, "ilst", &ilst, &ilst_len)) {
+        return;
+    }
+
+    char album_artist[MEDIA_TAG_TEXT_LEN] = "";
+    uint8_t value[TAG_FRAME_MAX];
+    long pos = ilst;
+    long end = ilst + ilst_len;
+    while (pos + 8 <= end) {
+        if (!read_at(f, pos, hdr, 8)) break;
+        long item_len = be32(hdr);
+        if (item_len < 8 || pos + item_len > end) break;
+
+        char *field = NULL;
+        if (!memcmp(hdr + 4, "\xa9nam", 4)) field = tags->title;
+        else if (!memcmp(hdr + 4, "\xa9" "ART", 4)) field = tags->artist;
+        else if (!memcmp(hdr + 4, "\xa9" "alb", 4)) field = tags->album;
+        else if (!memcmp(hdr + 4, "aART", 4)) field = album_artist;
+
+        if (field) {
+            int n = mp4_item_value(f, pos + 8, item_len - 8, value, sizeof(value));
+            if (n > 0) copy_utf8(field, MEDIA_TAG_TEXT_LEN, value, n);
+        } else if (!memcmp(hdr + 4, "trkn", 4)) {
+            int n = mp4_item_value(f, pos + 8, item_len - 8, value, sizeof(value));
+            if (n >= 4) tags->track = be16(value + 2);
+        }
+        pos += item_len;
+    }
+
+    if (tags->artist[0] == '\0' && album_artist[0]) {
+        strcpy(tags->artist, album_artist);
+    }
+}
+
+// ============================================
+// WAV
+// ============================================
+
+static void wav_read(FILE *f, long size, media_tags_t *tags)
+{
+    uint32_t byte_rate = 0;
+    uint32_t data_size = 0;
+    uint8_t hdr[8];
+    uint8_t value[TAG_FRAME_MAX];
+    long pos = 12;
+
+    while (pos + 8 <= size) {
+        if (!read_at(f, pos, hdr, 8)) break;
+        uint32_t len = le32(hdr + 4);
+        long data = pos + 8;
+
+        if (!memcmp(hdr, "fmt ", 4) && len >= 12) {
+            uint8_t fmt[12];
+            if (read_at(f, data, fmt, sizeof(fmt))) byte_rate = le32(fmt + 8);
+        } else if (!memcmp(hdr, "data", 4)) {
+            data_size = len;
+        } else if (!memcmp(hdr, "LIST", 4) && len >= 4 && read_at(f, data, value, 4) &&
+                   !memcmp(value, "INFO", 4)) {
+            long p = data + 4;
+            long end = data + len;
+            while (p + 8 <= end && read_at(f, p, hdr, 8)) {
+                uint32_t ilen = le32(hdr + 4);
+                char *field = NULL;
+                if (!memcmp(hdr, "INAM", 4)) field = tags->title;
+                else if (!memcmp(hdr, "IART", 4)) field = tags->artist;
+                else if (!memcmp(hdr, "IPRD", 4)) field = tags->album;
+                if (field && ilen < sizeof(value) && read_at(f, p + 8, value, ilen)) {
+                    copy_latin1(field, MEDIA_TAG_TEXT_LEN, value, ilen);
+                }
+                p += 8 + ilen + (ilen & 1);
+            }
+        }
+        pos = data + len + (len & 1);  // Chunki wyrównane do 2 bajtów
+    }
+
+    if (byte_rate > 0 && data_size > 0) {
+        tags->duration_ms = (uint32_t)((uint64_t)data_size * 1000 / byte_rate);
+    }
+}
+
+// ============================================
+// API
+// ============================================
+
+bool media_tags_read(FILE *f, media_tags_t *tags)
+{
+    memset(tags, 0, sizeof(*tags));
+    if (f == NULL) return false;
+
+    long size = file_size(f);
+    long start = id3v2_read(f, tags);  // ID3v2 bywa też przed FLAC
+
+    uint8_t head[12];
+    if (!read_at(f, start, head, sizeof(head))) {
+        return tags_found(tags);
+    }
+
+    if (!memcmp(head, "fLaC", 4)) {
+        flac_read(f, start, tags);
+    } else if (!memcmp(head, "RIFF", 4) && !memcmp(head + 8, "WAVE", 4)) {
+        wav_read(f, size, tags);
+    } else if (!memcmp(head + 4, "ftyp", 4)) {
+        mp4_read(f, size, tags);
+    } else {
+        id3v1_read(f, size, tags);
+        mp3_duration(f, start, size, tags);
+    }
+    return tags_found(tags);
+}
@@ -0,0 +1,31 @@
+/*
+ * Media Tags Module
+ * Odczyt tagów plików audio: ID3v2 (v2.2-v2.4) z ID3v1 jako zapasem, komentarze
+ * Vorbis we FLAC, atomy iTunes (ilst) w MP4/M4A oraz LIST/INFO w WAV.
+ * Długość utworu z nagłówków (STREAMINFO, mvhd, fmt/data, bitrate pierwszej ramki MP3).
+ *
+ * Czyste C (stdio + codec_detect) - parsery można sprawdzać na hoście na próbkach plików.
+ */
+
+#ifndef MEDIA_TAGS_H
+#define MEDIA_TAGS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MEDIA_TAG_TEXT_LEN  128     // Jak pola sd_file_info_t
+
+typedef struct {
+    char title[MEDIA_TAG_TEXT_LEN];     // UTF-8, "" jeśli brak
+    char artist[MEDIA_TAG_TEXT_LEN];    // Wykonawca utworu, zapasowo wykonawca albumu
+    char album[MEDIA_TAG_TEXT_LEN];
+    uint16_t track;                     // Numer na płycie (0 - brak)
+    uint32_t duration_ms;               // 0 - nieznana (MP3 VBR bez nagłówka: szacunek)
+} media_tags_t;
+
+// Czyta tagi z otwartego pliku (format po sygnaturze, nie po rozszerzeniu).
+// Zwraca true, jeśli znaleziono tytuł, wykonawcę, album lub długość.
+bool media_tags_read(FILE *f, media_tags_t *tags);
+
+#endif // MEDIA_TAGS_H
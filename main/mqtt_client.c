@@ -4,6 +4,7 @@
  */
 
 #include <string.h>
+#include <time.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_log.h"
@@ -221,6 +222,36 @@ esp_err_t mqtt_publish_media_info(const char *title, const char *artist, const c
     return ESP_OK;
 }
 
+// Publikowane tylko przy skoku pozycji lub start/stop - Home Assistant liczy pozycję
+// od media_position_updated_at (czas z SNTP; bez niego sama pozycja)
+esp_err_t mqtt_publish_media_position(uint32_t position_ms, uint32_t duration_ms, bool playing)
+{
+    if (current_state != MQTT_STATE_CONNECTED) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "media_position", position_ms / 1000);
+    cJSON_AddNumberToObject(root, "media_duration", duration_ms / 1000);
+    cJSON_AddBoolToObject(root, "media_position_running", playing);
+    time_t now = time(NULL);
+    if (now > 1600000000) {
+        struct tm tm_utc;
+        char stamp[32];
+        gmtime_r(&now, &tm_utc);
+        strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%SZ", &tm_utc);
+        cJSON_AddStringToObject(root, "media_position_updated_at", stamp);
+    }
+
+    char *json = cJSON_PrintUnformatted(root);
+    esp_mqtt_client_publish(mqtt_client, MQTT_TOPIC_STATE "/position",
+                            json, 0, 1, true);
+
+    free(json);
+    cJSON_Delete(root);
+    return ESP_OK;
+}
+
 esp_err_t mqtt_publish_availability(bool online)
 {
     if (mqtt_client == NULL) {
@@ -232,6 +263,17 @@ esp_err_t mqtt_publish_availability(bool online)
     return ESP_OK;
 }
 
+esp_err_t mqtt_publish_telemetry(const uint8_t *data, int len)
+{
+    if (current_state != MQTT_STATE_CONNECTED) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // QoS 0, bez retain - kolejne próbki i tak nadejdą
+    esp_mqtt_client_publish(mqtt_client, MQTT_TOPIC_TELEMETRY, (const char *)data, len, 0, false);
+    return ESP_OK;
+}
+
 esp_err_t mqtt_send_ha_discovery(void)
 {
     if (current_state != MQTT_STATE_CONNECTED) {
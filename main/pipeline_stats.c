@@ -0,0 +1,255 @@
+/*
+ * Pipeline Statistics Module
+ * Telemetria elementów audio: przepływ, zapełnienie buforów, underrun/overrun, czas dekodowania
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_cpu.h"
+#include "esp_timer.h"
+
+#include "pipeline_stats.h"
+
+// Liczniki jednego elementu na jednym rdzeniu. Zapisujących bywa kilku (EQ i timer dla
+// I2S, dekodery slotów i SD), a task bez przypięcia może zmienić rdzeń w trakcie - stąd
+// operacje atomowe, bez blokad.
+typedef struct {
+    uint32_t bytes_in;
+    uint32_t bytes_out;
+    uint32_t underruns;
+    uint32_t overruns;
+    uint32_t fill_min;
+    uint32_t fill_max;
+    uint32_t fill_size;
+    uint32_t fill_window;       // Okno, do którego należą fill_min/fill_max
+} pstat_counter_t;
+
+static pstat_counter_t counters[portNUM_PROCESSORS][PSTAT_ELEMENT_COUNT];
+static uint32_t histogram[portNUM_PROCESSORS][PSTAT_HIST_BUCKETS];
+
+// Okno pomiarowe (1s) - zmiana numeru zeruje min/max u zapisujących, bez ich blokowania
+static volatile uint32_t current_window = 1;
+
+// Wynik ostatniego zamkniętego okna
+static pstat_element_info_t snapshot[PSTAT_ELEMENT_COUNT];
+static uint32_t prev_in[PSTAT_ELEMENT_COUNT];
+static uint32_t prev_out[PSTAT_ELEMENT_COUNT];
+static int64_t prev_tick_us = 0;
+
+static const char *element_names[PSTAT_ELEMENT_COUNT] = {
+    "http", "decoder", "output", "i2s", "sd", "bt",
+};
+
+static inline pstat_counter_t *counter(pstat_element_t el)
+{
+    return &counters[esp_cpu_get_core_id()][el];
+}
+
+static inline void atomic_add(uint32_t *v, uint32_t n)
+{
+    __atomic_fetch_add(v, n, __ATOMIC_RELAXED);
+}
+
+static inline void atomic_min(uint32_t *v, uint32_t n)
+{
+    uint32_t cur = __atomic_load_n(v, __ATOMIC_RELAXED);
+    while (n < cur && !__atomic_compare_exchange_n(v, &cur, n, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+static inline void atomic_max(uint32_t *v, uint32_t n)
+{
+    uint32_t cur = __atomic_load_n(v, __ATOMIC_RELAXED);
+    while (n > cur && !__atomic_compare_exchange_n(v, &cur, n, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+// ============================================
+// Liczniki
+// ============================================
+
+void pipeline_stats_add_in(pstat_element_t el, uint32_t bytes)
+{
+    atomic_add(&counter(el)->bytes_in, bytes);
+}
+
+void pipeline_stats_add_out(pstat_element_t el, uint32_t bytes)
+{
+    atomic_add(&counter(el)->bytes_out, bytes);
+}
+
+void pipeline_stats_underrun(pstat_element_t el)
+{
+    atomic_add(&counter(el)->underruns, 1);
+}
+
+void pipeline_stats_overrun(pstat_element_t el)
+{
+    atomic_add(&counter(el)->overruns, 1);
+}
+
+void pipeline_stats_fill(pstat_element_t el, int filled, int size)
+{
+    pstat_counter_t *c = counter(el);
+    uint32_t window = current_window;
+
+    __atomic_store_n(&c->fill_size, size, __ATOMIC_RELAXED);
+    // Pierwszy zapis w nowym oknie zaczyna min/max od bieżącej wartości
+    if (__atomic_exchange_n(&c->fill_window, window, __ATOMIC_RELAXED) != window) {
+        __atomic_store_n(&c->fill_min, filled, __ATOMIC_RELAXED);
+        __atomic_store_n(&c->fill_max, filled, __ATOMIC_RELAXED);
+        return;
+    }
+    atomic_min(&c->fill_min, filled);
+    atomic_max(&c->fill_max, filled);
+}
+
+void pipeline_stats_decode_time(uint32_t us)
+{
+    int bucket = us > 1 ? 31 - __builtin_clz(us) : 0;
+    if (bucket >= PSTAT_HIST_BUCKETS) bucket = PSTAT_HIST_BUCKETS - 1;
+    atomic_add(&histogram[esp_cpu_get_core_id()][bucket], 1);
+}
+
+// ============================================
+// Odczyt
+// ============================================
+
+void pipeline_stats_tick(void)
+{
+    int64_t now = esp_timer_get_time();
+    int64_t elapsed_ms = prev_tick_us ? (now - prev_tick_us) / 1000 : 0;
+    prev_tick_us = now;
+
+    uint32_t window = current_window;
+
+    for (int el = 0; el < PSTAT_ELEMENT_COUNT; el++) {
+        pstat_element_info_t info = {0};
+        uint32_t total_in = 0;
+        uint32_t total_out = 0;
+        bool have_fill = false;
+
+        for (int core = 0; core < portNUM_PROCESSORS; core++) {
+            const pstat_counter_t *c = &counters[core][el];
+            total_in += c->bytes_in;
+            total_out += c->bytes_out;
+            info.underruns += c->underruns;
+            info.overruns += c->overruns;
+
+            if (c->fill_window == window) {
+                if (!have_fill || c->fill_min < info.fill_min) info.fill_min = c->fill_min;
+                if (c->fill_max > info.fill_max) info.fill_max = c->fill_max;
+                info.fill_size = c->fill_size;
+                have_fill = true;
+            }
+        }
+
+        if (elapsed_ms > 0) {
+            info.in_bps = (uint32_t)((uint64_t)(total_in - prev_in[el]) * 1000 / elapsed_ms);
+            info.out_bps = (uint32_t)((uint64_t)(total_out - prev_out[el]) * 1000 / elapsed_ms);
+        }
+        prev_in[el] = total_in;
+        prev_out[el] = total_out;
+        snapshot[el] = info;
+    }
+
+    current_window = window + 1;
+}
+
+void pipeline_stats_get(pstat_element_t el, pstat_element_info_t *info)
+{
+    if (info == NULL || el >= PSTAT_ELEMENT_COUNT) return;
+    *info = snapshot[el];
+}
+
+const char *pipeline_stats_name(pstat_element_t el)
+{
+    return el < PSTAT_ELEMENT_COUNT ? element_names[el] : "unknown";
+}
+
+void pipeline_stats_get_histogram(uint32_t hist[PSTAT_HIST_BUCKETS])
+{
+    for (int b = 0; b < PSTAT_HIST_BUCKETS; b++) {
+        hist[b] = 0;
+        for (int core = 0; core < portNUM_PROCESSORS; core++) {
+            hist[b] += histogram[core][b];
+        }
+    }
+}
+
+uint32_t pipeline_stats_decode_percentile(int percent)
+{
+    uint32_t hist[PSTAT_HIST_BUCKETS];
+    pipeline_stats_get_histogram(hist);
+
+    uint64_t total = 0;
+    for (int b = 0; b < PSTAT_HIST_BUCKETS; b++) total += hist[b];
+    if (total == 0) return 0;
+
+    uint64_t threshold = (total * percent + 99) / 100;
+    uint64_t acc = 0;
+    for (int b = 0; b < PSTAT_HIST_BUCKETS; b++) {
+        acc += hist[b];
+        if (acc >= threshold) {
+            return 2u << b;
+        }
+    }
+    return 2u << (PSTAT_HIST_BUCKETS - 1);
+}
+
+// ============================================
+// Format binarny
+// ============================================
+
+static uint8_t *put_u16(uint8_t *p, uint32_t v)
+{
+    if (v > 0xFFFF) v = 0xFFFF;  // Nasycenie zamiast przepełnienia
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+    return p + 2;
+}
+
+static uint8_t *put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = v >> 24;
+    return p + 4;
+}
+
+static uint32_t fill_permille(uint32_t filled, uint32_t size)
+{
+    return size ? (uint32_t)((uint64_t)filled * 1000 / size) : 0;
+}
+
+int pipeline_stats_pack(uint8_t *buf, int len)
+{
+    int needed = 2 + PSTAT_ELEMENT_COUNT * 16 + 1 + PSTAT_HIST_BUCKETS * 4;
+    if (buf == NULL || len < needed) {
+        return 0;
+    }
+
+    uint8_t *p = buf;
+    *p++ = PSTAT_PACK_VERSION;
+    *p++ = PSTAT_ELEMENT_COUNT;
+
+    for (int el = 0; el < PSTAT_ELEMENT_COUNT; el++) {
+        const pstat_element_info_t *info = &snapshot[el];
+        p = put_u32(p, info->in_bps);
+        p = put_u32(p, info->out_bps);
+        p = put_u16(p, fill_permille(info->fill_min, info->fill_size));
+        p = put_u16(p, fill_permille(info->fill_max, info->fill_size));
+        p = put_u16(p, info->underruns);
+        p = put_u16(p, info->overruns);
+    }
+
+    uint32_t hist[PSTAT_HIST_BUCKETS];
+    pipeline_stats_get_histogram(hist);
+    *p++ = PSTAT_HIST_BUCKETS;
+    for (int b = 0; b < PSTAT_HIST_BUCKETS; b++) {
+        p = put_u32(p, hist[b]);
+    }
+
+    return p - buf;
+}
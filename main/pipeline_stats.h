@@ -0,0 +1,74 @@
+/*
+ * Pipeline Statistics Module
+ * Telemetria elementów audio: przepływ, zapełnienie buforów, underrun/overrun, czas dekodowania
+ */
+
+#ifndef PIPELINE_STATS_H
+#define PIPELINE_STATS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Elementy toru aktywnego źródła
+typedef enum {
+    PSTAT_HTTP = 0,         // Sieć -> bufor HTTP (wejście z metadanymi ICY, wyjście bez)
+    PSTAT_DECODER,          // Bufor HTTP/pliku -> dekoder -> PCM źródła
+    PSTAT_OUTPUT,           // PCM źródła -> EQ
+    PSTAT_I2S,              // Bufor przed I2S -> DMA
+    PSTAT_SD,               // Karta SD -> bufor pliku (fatfs)
+    PSTAT_BT,               // PCM za EQ -> bufor A2DP source (underrun z callbacku danych BT)
+    PSTAT_ELEMENT_COUNT,
+} pstat_element_t;
+
+// Histogram czasu dekodowania ramki: kubełek i = [2^i, 2^(i+1)) µs
+#define PSTAT_HIST_BUCKETS  16
+
+// Wersja formatu binarnego (MQTT)
+#define PSTAT_PACK_VERSION  1
+
+// Stan elementu z ostatniej pełnej sekundy
+typedef struct {
+    uint32_t in_bps;        // Bajty na sekundę na wejściu
+    uint32_t out_bps;       // Bajty na sekundę na wyjściu
+    uint32_t fill_min;      // Zapełnienie bufora wejściowego (bajty)
+    uint32_t fill_max;
+    uint32_t fill_size;     // Rozmiar bufora wejściowego (0 - brak)
+    uint32_t underruns;     // Od startu: odczyt z pustego bufora
+    uint32_t overruns;      // Od startu: zapis do pełnego bufora
+} pstat_element_info_t;
+
+// ============================================
+// Liczniki (wywoływane z tasków elementów)
+// ============================================
+// Liczniki osobne dla każdego rdzenia, aktualizowane atomowo - bez blokad, także gdy jeden
+// element zasila kilka tasków.
+
+void pipeline_stats_add_in(pstat_element_t el, uint32_t bytes);
+void pipeline_stats_add_out(pstat_element_t el, uint32_t bytes);
+void pipeline_stats_underrun(pstat_element_t el);
+void pipeline_stats_overrun(pstat_element_t el);
+void pipeline_stats_fill(pstat_element_t el, int filled, int size);
+void pipeline_stats_decode_time(uint32_t us);
+
+// ============================================
+// Odczyt
+// ============================================
+
+// Zamyka okno pomiarowe - wywoływane co sekundę
+void pipeline_stats_tick(void);
+
+void pipeline_stats_get(pstat_element_t el, pstat_element_info_t *info);
+const char *pipeline_stats_name(pstat_element_t el);
+
+// Histogram od startu; percentyl jako górna granica kubełka w µs
+void pipeline_stats_get_histogram(uint32_t hist[PSTAT_HIST_BUCKETS]);
+uint32_t pipeline_stats_decode_percentile(int percent);
+
+// Zwarta postać binarna (little-endian) dla MQTT:
+//   u8 wersja, u8 liczba elementów,
+//   na element: u32 in_bps, u32 out_bps, u16 fill_min‰, u16 fill_max‰, u16 underruns, u16 overruns
+//   u8 liczba kubełków, u32 na kubełek
+// Zwraca długość lub 0 gdy bufor za mały.
+int pipeline_stats_pack(uint8_t *buf, int len);
+
+#endif // PIPELINE_STATS_H
@@ -0,0 +1,166 @@
+/*
+ * Player Status Module
+ * Seqlock statusu odtwarzacza
+ */
+
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "player_status.h"
+#include "config.h"
+
+static player_status_t status = {
+    .state = PLAYER_STATE_IDLE,
+    .source = AUDIO_SOURCE_NONE,
+    .volume = DEFAULT_VOLUME,
+    .muted = false,
+    .current_url = "",
+    .current_title = "",
+    .current_artist = "",
+    .current_album = "",
+};
+
+const player_status_t *const player_status = &status;
+
+static portMUX_TYPE status_mux = portMUX_INITIALIZER_UNLOCKED;
+static volatile uint32_t status_seq = 0;
+static uint32_t status_changed = 0;     // PLAYER_STATUS_* od ostatniego powiadomienia
+
+player_status_t *player_status_write_begin(void)
+{
+    taskENTER_CRITICAL(&status_mux);
+    status_seq++;
+    __sync_synchronize();
+    return &status;
+}
+
+void player_status_write_end(uint32_t changed)
+{
+    __sync_synchronize();
+    status_seq++;
+    status_changed |= changed;
+    taskEXIT_CRITICAL(&status_mux);
+}
+
+// ============================================
+// Settery pojedynczych pól
+// ============================================
+
+static void set_str(char *field, size_t size, const char *value, uint32_t bit)
+{
+    if (value == NULL) {
+        value = "";
+    }
+    player_status_write_begin();
+    bool changed = (strncmp(field, value, size - 1) != 0);
+    if (changed) {
+        strncpy(field, value, size - 1);
+        field[size - 1] = '\0';
+    }
+    player_status_write_end(changed ? bit : 0);
+}
+
+void player_status_set_state(player_state_t state)
+{
+    player_status_write_begin();
+    bool changed = (status.state != state);
+    status.state = state;
+    player_status_write_end(changed ? PLAYER_STATUS_STATE : 0);
+}
+
+void player_status_set_source(audio_source_t source)
+{
+    player_status_write_begin();
+    bool changed = (status.source != source);
+    status.source = source;
+    player_status_write_end(changed ? PLAYER_STATUS_SOURCE : 0);
+}
+
+void player_status_set_volume(int volume)
+{
+    player_status_write_begin();
+    bool changed = (status.volume != volume);
+    status.volume = volume;
+    player_status_write_end(changed ? PLAYER_STATUS_VOLUME : 0);
+}
+
+void player_status_set_muted(bool muted)
+{
+    player_status_write_begin();
+    bool changed = (status.muted != muted);
+    status.muted = muted;
+    player_status_write_end(changed ? PLAYER_STATUS_MUTED : 0);
+}
+
+void player_status_set_url(const char *url)
+{
+    set_str(status.current_url, sizeof(status.current_url), url, PLAYER_STATUS_URL);
+}
+
+void player_status_set_title(const char *title)
+{
+    set_str(status.current_title, sizeof(status.current_title), title, PLAYER_STATUS_TITLE);
+}
+
+void player_status_set_artist(const char *artist)
+{
+    set_str(status.current_artist, sizeof(status.current_artist), artist, PLAYER_STATUS_ARTIST);
+}
+
+void player_status_set_album(const char *album)
+{
+    set_str(status.current_album, sizeof(status.current_album), album, PLAYER_STATUS_ALBUM);
+}
+
+uint32_t player_status_position_ms(const player_status_t *s, uint32_t now_ms)
+{
+    uint32_t pos = s->position_ms;
+    if (s->position_at_ms) {
+        pos += now_ms - s->position_at_ms;
+    }
+    if (s->duration_ms && pos > s->duration_ms) {
+        pos = s->duration_ms;
+    }
+    return pos;
+}
+
+void player_status_set_position(uint32_t duration_ms, uint32_t position_ms, uint32_t at_ms,
+                                uint32_t now_ms, uint32_t slack_ms)
+{
+    uint32_t expected = player_status_position_ms(&status, now_ms);
+    uint32_t measured = position_ms + (at_ms ? now_ms - at_ms : 0);
+    uint32_t diff = measured > expected ? measured - expected : expected - measured;
+
+    player_status_write_begin();
+    bool changed = status.duration_ms != duration_ms ||
+                   (status.position_at_ms != 0) != (at_ms != 0) ||
+                   diff > slack_ms;
+    status.duration_ms = duration_ms;
+    status.position_ms = position_ms;
+    status.position_at_ms = at_ms;
+    player_status_write_end(changed ? PLAYER_STATUS_POSITION : 0);
+}
+
+void player_status_get(player_status_t *out)
+{
+    uint32_t seq;
+    do {
+        seq = status_seq;
+        if (seq & 1) {
+            continue;  // Zapis w toku (na drugim rdzeniu) - trwa mikrosekundy
+        }
+        __sync_synchronize();
+        memcpy(out, &status, sizeof(*out));
+        __sync_synchronize();
+    } while ((seq & 1) || seq != status_seq);
+}
+
+uint32_t player_status_take_changed(void)
+{
+    taskENTER_CRITICAL(&status_mux);
+    uint32_t changed = status_changed;
+    status_changed = 0;
+    taskEXIT_CRITICAL(&status_mux);
+    return changed;
+}
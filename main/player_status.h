@@ -0,0 +1,48 @@
+/*
+ * Player Status Module
+ * Status odtwarzacza publikowany przez seqlock: piszący zmieniają pola w krótkiej sekcji
+ * krytycznej, zwiększając licznik przed i po zmianie. Czytelnicy kopiują bez blokady
+ * i powtarzają kopię, gdy licznik był nieparzysty lub się zmienił - tor audio nie czeka
+ * na mutex. Zmienione pola zbierane są w masce PLAYER_STATUS_* do powiadomienia.
+ */
+
+#ifndef PLAYER_STATUS_H
+#define PLAYER_STATUS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "audio_player.h"
+
+// Pola statusu dla taska sterującego: odczyt pojedynczych pól bez kopii. Zapis tylko
+// przez settery albo wskaźnik z player_status_write_begin()
+extern const player_status_t *const player_status;
+
+// Kilka pól w jednym zapisie: wskaźnik do zapisu ważny do player_status_write_end()
+player_status_t *player_status_write_begin(void);
+void player_status_write_end(uint32_t changed);
+
+// Pojedyncze pole w osobnym zapisie - bit w masce tylko przy rzeczywistej zmianie
+void player_status_set_state(player_state_t state);
+void player_status_set_source(audio_source_t source);
+void player_status_set_volume(int volume);
+void player_status_set_muted(bool muted);
+void player_status_set_url(const char *url);
+void player_status_set_title(const char *title);
+void player_status_set_artist(const char *artist);
+void player_status_set_album(const char *album);
+
+// Pozycja biegnie lokalnie od at_ms (0 - stoi). Zmiana zgłaszana tylko przy innej długości,
+// skoku większym niż slack_ms lub zatrzymaniu/wznowieniu zegara - nie co sekundę.
+void player_status_set_position(uint32_t duration_ms, uint32_t position_ms, uint32_t at_ms,
+                                uint32_t now_ms, uint32_t slack_ms);
+
+// Spójna kopia (dowolny task)
+void player_status_get(player_status_t *status);
+
+// Maska pól zmienionych od poprzedniego wywołania (i jej wyzerowanie)
+uint32_t player_status_take_changed(void);
+
+// Pozycja z kopii statusu w chwili now_ms
+uint32_t player_status_position_ms(const player_status_t *status, uint32_t now_ms);
+
+#endif // PLAYER_STATUS_H
@@ -106,7 +106,9 @@ esp_err_t radio_stations_add(const char *name, const char *url, const char *logo
         }
     }
 
+    // Slot mógł zostać po przesunięciu listy w radio_stations_remove()
     radio_station_t *station = &stations[station_count];
+    memset(station, 0, sizeof(*station));
     station->id = new_id;
     strncpy(station->name, name, sizeof(station->name) - 1);
     strncpy(station->url, url, sizeof(station->url) - 1);
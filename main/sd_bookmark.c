@@ -0,0 +1,227 @@
+/*
+ * SD Bookmark Module
+ * Dziennik zakładek: rekordy {klucz, pozycja, numer zapisu, suma kontrolna}
+ */
+
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include "sd_bookmark.h"
+
+#define RECORD_MAGIC    0x314b4d42  // "BMK1" - wchodzi do sumy kontrolnej rekordu
+
+typedef struct {
+    uint32_t key;
+    uint32_t position_ms;
+    uint32_t seq;
+    uint32_t check;
+} record_t;
+
+static uint32_t fnv1a(uint32_t h, const void *data, size_t len)
+{
+    const uint8_t *p = data;
+    while (len--) {
+        h ^= *p++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static uint32_t record_check(const record_t *r)
+{
+    return fnv1a(2166136261u, r, offsetof(record_t, check)) ^ RECORD_MAGIC;
+}
+
+static uint32_t path_key(const char *path)
+{
+    return fnv1a(2166136261u, path, strlen(path));
+}
+
+static sd_bookmark_entry_t *find(const sd_bookmarks_t *bm, uint32_t key)
+{
+    for (uint32_t i = 0; i < bm->count; i++) {
+        if (bm->entries[i].key == key) {
+            return (sd_bookmark_entry_t *)&bm->entries[i];
+        }
+    }
+    return NULL;
+}
+
+static void remove_entry(sd_bookmarks_t *bm, sd_bookmark_entry_t *e)
+{
+    *e = bm->entries[--bm->count];
+}
+
+// Wpis dla klucza; przy pełnej tablicy zastępuje najdawniej zapisaną zakładkę
+static sd_bookmark_entry_t *find_or_add(sd_bookmarks_t *bm, uint32_t key)
+{
+    sd_bookmark_entry_t *e = find(bm, key);
+    if (e) return e;
+
+    if (bm->count < SD_BOOKMARK_MAX) {
+        e = &bm->entries[bm->count++];
+    } else {
+        e = &bm->entries[0];
+        for (uint32_t i = 1; i < bm->count; i++) {
+            if (bm->entries[i].seq < e->seq) e = &bm->entries[i];
+        }
+        bm->rewrite = true;     // Wyparta zakładka zostałaby w dzienniku
+    }
+    memset(e, 0, sizeof(*e));
+    e->key = key;
+    return e;
+}
+
+void sd_bookmark_load(sd_bookmarks_t *bm, const char *journal)
+{
+    memset(bm, 0, sizeof(*bm));
+    snprintf(bm->journal, sizeof(bm->journal), "%s", journal);
+
+    FILE *f = fopen(journal, "rb");
+    if (f == NULL) {
+        // Przepisywanie przerwane między usunięciem starego dziennika a zmianą nazwy nowego
+        char tmp[sizeof(bm->journal) + 4];
+        snprintf(tmp, sizeof(tmp), "%s.tmp", bm->journal);
+        f = fopen(tmp, "rb");
+        if (f == NULL) {
+            return;
+        }
+        bm->rewrite = true;
+    }
+    record_t r;
+    size_t n;
+    while ((n = fread(&r, 1, sizeof(r), f)) == sizeof(r)) {
+        bm->records++;
+        if (r.check != record_check(&r)) {
+            bm->rewrite = true;     // Uszkodzony rekord - pomijany, dziennik do przepisania
+            continue;
+        }
+        if (r.seq > bm->seq) bm->seq = r.seq;
+
+        sd_bookmark_entry_t *e = find(bm, r.key);
+        if (r.position_ms == 0) {
+            if (e) remove_entry(bm, e);
+            continue;
+        }
+        if (e == NULL) {
+            e = find_or_add(bm, r.key);
+        }
+        e->position_ms = r.position_ms;
+        e->seq = r.seq;
+    }
+    if (n > 0) {
+        bm->rewrite = true;         // Urwany ostatni rekord - dopisywanie przesunęłoby kolejne
+    }
+    fclose(f);
+}
+
+bool sd_bookmark_get(const sd_bookmarks_t *bm, const char *path, uint32_t *position_ms)
+{
+    sd_bookmark_entry_t *e = find(bm, path_key(path));
+    if (e == NULL || e->position_ms == 0) {
+        return false;
+    }
+    *position_ms = e->position_ms;
+    return true;
+}
+
+void sd_bookmark_set(sd_bookmarks_t *bm, const char *path, uint32_t position_ms)
+{
+    uint32_t key = path_key(path);
+    sd_bookmark_entry_t *e = position_ms ? find_or_add(bm, key) : find(bm, key);
+    if (e == NULL || (e->position_ms == position_ms && e->seq)) {
+        return;     // Usunięcie nieistniejącej lub ta sama pozycja
+    }
+    e->position_ms = position_ms;
+    e->seq = ++bm->seq;
+    e->dirty = true;
+}
+
+bool sd_bookmark_dirty(const sd_bookmarks_t *bm)
+{
+    if (bm->rewrite) return true;
+    for (uint32_t i = 0; i < bm->count; i++) {
+        if (bm->entries[i].dirty) return true;
+    }
+    return false;
+}
+
+static bool write_entry(FILE *f, const sd_bookmark_entry_t *e)
+{
+    record_t r = { .key = e->key, .position_ms = e->position_ms, .seq = e->seq };
+    r.check = record_check(&r);
+    return fwrite(&r, sizeof(r), 1, f) == 1;
+}
+
+// Nowy dziennik z samymi aktualnymi zakładkami; podmiana przez rename - przerwany zapis
+// zostawia stary dziennik
+static bool rewrite_journal(sd_bookmarks_t *bm)
+{
+    char tmp[sizeof(bm->journal) + 4];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", bm->journal);
+
+    FILE *f = fopen(tmp, "wb");
+    if (f == NULL) return false;
+    bool ok = true;
+    uint32_t records = 0;
+    for (uint32_t i = 0; i < bm->count && ok; i++) {
+        if (bm->entries[i].position_ms) {
+            ok = write_entry(f, &bm->entries[i]);
+            records++;
+        }
+    }
+    ok = (fclose(f) == 0) && ok;
+    if (!ok) {
+        remove(tmp);        // Niepełny zapis (pełna karta, błąd I/O) - stary dziennik zostaje
+        return false;
+    }
+    remove(bm->journal);    // FAT: rename nie nadpisuje istniejącego pliku
+    if (rename(tmp, bm->journal) != 0) {
+        return false;       // Kompletny .tmp zostaje - sd_bookmark_load odczyta go zamiast dziennika
+    }
+    bm->records = records;
+    bm->rewrite = false;
+    return true;
+}
+
+bool sd_bookmark_flush(sd_bookmarks_t *bm)
+{
+    uint32_t dirty = 0;
+    for (uint32_t i = 0; i < bm->count; i++) {
+        if (bm->entries[i].dirty) dirty++;
+    }
+    if (dirty == 0 && !bm->rewrite) {
+        return true;
+    }
+
+    bool ok;
+    bm->writes++;
+    if (bm->rewrite || bm->records + dirty > SD_BOOKMARK_JOURNAL_MAX) {
+        ok = rewrite_journal(bm);
+    } else {
+        FILE *f = fopen(bm->journal, "ab");
+        ok = (f != NULL);
+        for (uint32_t i = 0; i < bm->count && ok; i++) {
+            if (bm->entries[i].dirty) {
+                ok = write_entry(f, &bm->entries[i]);
+                bm->records++;
+            }
+        }
+        if (f && fclose(f) != 0) ok = false;
+    }
+    if (!ok) {
+        bm->rewrite = true;     // Rekord mógł zostać zapisany w części
+        return false;
+    }
+
+    // Usunięte zakładki są już w dzienniku - znikają z pamięci
+    for (uint32_t i = 0; i < bm->count;) {
+        bm->entries[i].dirty = false;
+        if (bm->entries[i].position_ms == 0) {
+            remove_entry(bm, &bm->entries[i]);
+        } else {
+            i++;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,51 @@
+/*
+ * SD Bookmark Module
+ * Zakładki długich plików z karty SD (audiobooki, podcasty): pozycja odtwarzania według
+ * skrótu ścieżki. Dziennik na karcie jest tylko dopisywany - zapis zakładki to jeden
+ * 16-bajtowy rekord; plik jest przepisywany dopiero, gdy urośnie lub ma uszkodzony rekord
+ * (przerwany zapis przy zaniku zasilania). Kolejność zapisów decyduje przy odczycie.
+ *
+ * Czyste C (stdio) - można kompilować i sprawdzać na hoście.
+ */
+
+#ifndef SD_BOOKMARK_H
+#define SD_BOOKMARK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SD_BOOKMARK_MAX             128     // Zakładki w pamięci (najstarsze wypierane)
+#define SD_BOOKMARK_JOURNAL_MAX     1024    // Rekordy dziennika (16 KB) przed przepisaniem
+
+typedef struct {
+    uint32_t key;               // FNV-1a ścieżki
+    uint32_t position_ms;       // 0 - zakładka usunięta (plik odegrany do końca)
+    uint32_t seq;               // Numer zapisu - najstarsza zakładka wypierana pierwsza
+    bool dirty;                 // Zmiana jeszcze nie dopisana do dziennika
+} sd_bookmark_entry_t;
+
+typedef struct {
+    char journal[128];
+    sd_bookmark_entry_t entries[SD_BOOKMARK_MAX];
+    uint32_t count;
+    uint32_t seq;
+    uint32_t records;           // Rekordy w pliku dziennika
+    bool rewrite;               // Przy następnym zapisie przepisz dziennik od nowa
+    uint32_t writes;            // Operacje zapisu na karcie (dopisania i przepisania)
+} sd_bookmarks_t;
+
+// Odtwarza dziennik do pamięci (brak pliku - pusta lista)
+void sd_bookmark_load(sd_bookmarks_t *bm, const char *journal);
+
+// Pozycja zapisana dla ścieżki; false - brak zakładki
+bool sd_bookmark_get(const sd_bookmarks_t *bm, const char *path, uint32_t *position_ms);
+
+// Zmiana tylko w pamięci, na kartę trafia przy sd_bookmark_flush(). position_ms 0 - usuń.
+void sd_bookmark_set(sd_bookmarks_t *bm, const char *path, uint32_t position_ms);
+
+bool sd_bookmark_dirty(const sd_bookmarks_t *bm);
+
+// Dopisuje zmienione zakładki (lub przepisuje dziennik). false - błąd zapisu na karcie
+bool sd_bookmark_flush(sd_bookmarks_t *bm);
+
+#endif // SD_BOOKMARK_H
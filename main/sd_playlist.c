@@ -0,0 +1,254 @@
+/*
+ * SD Playlist Module
+ * Arena ścieżek z tablicą offsetów
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "sd_playlist.h"
+
+#define ENTRY_HEADER_SIZE   2       // Numer katalogu i kod rozszerzenia przed nazwą pliku
+#define EXT_SHIFT           13      // Nagłówek: [3 bity rozszerzenie][13 bitów katalog]
+#define DIR_MASK            ((1 << EXT_SHIFT) - 1)
+#define MIN_ENTRIES         256
+#define MIN_ARENA           4096
+
+// ============================================
+// Pomocnicze
+// ============================================
+
+// Wzrost o połowę - mniejszy zapas niż przy podwajaniu, a nadal niewiele realokacji
+static bool grow(void **ptr, uint32_t *capacity, uint32_t needed, size_t elem, uint32_t min)
+{
+    if (needed <= *capacity) return true;
+
+    uint32_t new_capacity = *capacity ? *capacity : min;
+    while (new_capacity < needed) {
+        new_capacity += new_capacity / 2;
+    }
+    void *p = realloc(*ptr, (size_t)new_capacity * elem);
+    if (p == NULL) return false;
+    *ptr = p;
+    *capacity = new_capacity;
+    return true;
+}
+
+// Typowe rozszerzenia zapisane kodem w nagłówku wpisu zamiast w nazwie (kod 0 - brak)
+static const char *const extensions[] = { NULL, ".mp3", ".flac", ".m4a", ".aac", ".wav" };
+#define EXT_COUNT (sizeof(extensions) / sizeof(extensions[0]))
+
+static uint16_t entry_header(const sd_playlist_t *pl, uint32_t offset)
+{
+    uint16_t header;
+    memcpy(&header, pl->arena + offset, sizeof(header));  // Offset wpisu bez wyrównania
+    return header;
+}
+
+static const char *entry_name(const sd_playlist_t *pl, uint32_t offset)
+{
+    return pl->arena + offset + ENTRY_HEADER_SIZE;
+}
+
+static bool arena_append(sd_playlist_t *pl, const void *data, size_t len)
+{
+    if (!grow((void **)&pl->arena, &pl->arena_capacity, pl->arena_size + len, 1, MIN_ARENA)) {
+        return false;
+    }
+    memcpy(pl->arena + pl->arena_size, data, len);
+    pl->arena_size += len;
+    return true;
+}
+
+// Numer katalogu (dodaje go, jeśli jeszcze nie ma); -1 przy braku pamięci lub limicie
+static int dir_index(sd_playlist_t *pl, const char *dir, size_t len)
+{
+    if (pl->last_dir < pl->dir_count) {
+        const char *last = pl->arena + pl->dirs[pl->last_dir];
+        if (strncmp(last, dir, len) == 0 && last[len] == '\0') {
+            return pl->last_dir;
+        }
+    }
+    for (uint32_t i = 0; i < pl->dir_count; i++) {
+        const char *s = pl->arena + pl->dirs[i];
+        if (strncmp(s, dir, len) == 0 && s[len] == '\0') {
+            pl->last_dir = i;
+            return i;
+        }
+    }
+
+    if (pl->dir_count >= SD_PLAYLIST_MAX_DIRS ||
+        !grow((void **)&pl->dirs, &pl->dir_capacity, pl->dir_count + 1, sizeof(uint32_t), 16)) {
+        return -1;
+    }
+    uint32_t offset = pl->arena_size;
+    if (!arena_append(pl, dir, len) || !arena_append(pl, "", 1)) {
+        pl->arena_size = offset;
+        return -1;
+    }
+    pl->dirs[pl->dir_count] = offset;
+    pl->last_dir = pl->dir_count;
+    return pl->dir_count++;
+}
+
+// ============================================
+// Public API
+// ============================================
+
+void sd_playlist_init(sd_playlist_t *pl, uint32_t max_entries)
+{
+    memset(pl, 0, sizeof(*pl));
+    pl->max_entries = max_entries;
+}
+
+void sd_playlist_clear(sd_playlist_t *pl)
+{
+    pl->count = 0;
+    pl->arena_size = 0;
+    pl->dir_count = 0;
+    pl->last_dir = 0;
+}
+
+void sd_playlist_free(sd_playlist_t *pl)
+{
+    free(pl->entries);
+    free(pl->arena);
+    free(pl->dirs);
+    sd_playlist_init(pl, pl->max_entries);
+}
+
+bool sd_playlist_add(sd_playlist_t *pl, const char *path)
+{
+    if (pl->count >= pl->max_entries) {
+        return false;
+    }
+
+    const char *slash = strrchr(path, '/');
+    const char *name = slash ? slash + 1 : path;
+    size_t dir_len = slash ? (size_t)(slash - path) : 0;
+    if (name[0] == '\0') {
+        return false;
+    }
+
+    if (!grow((void **)&pl->entries, &pl->capacity, pl->count + 1, sizeof(uint32_t), MIN_ENTRIES)) {
+        return false;
+    }
+    int dir = dir_index(pl, path, dir_len);
+    if (dir < 0) {
+        return false;
+    }
+
+    size_t name_len = strlen(name);
+    uint16_t ext = 0;
+    for (uint16_t i = 1; i < EXT_COUNT; i++) {
+        size_t ext_len = strlen(extensions[i]);
+        if (name_len > ext_len && strcmp(name + name_len - ext_len, extensions[i]) == 0) {
+            ext = i;
+            name_len -= ext_len;
+            break;
+        }
+    }
+
+    uint32_t offset = pl->arena_size;
+    uint16_t header = (ext << EXT_SHIFT) | dir;
+    if (!arena_append(pl, &header, sizeof(header)) || !arena_append(pl, name, name_len) ||
+        !arena_append(pl, "", 1)) {
+        pl->arena_size = offset;
+        return false;
+    }
+    pl->entries[pl->count++] = offset;
+    return true;
+}
+
+size_t sd_playlist_get_path(const sd_playlist_t *pl, uint32_t index, char *buf, size_t size)
+{
+    if (index >= pl->count || size == 0) {
+        return 0;
+    }
+    uint32_t offset = pl->entries[index];
+    uint16_t header = entry_header(pl, offset);
+    const char *dir = pl->arena + pl->dirs[header & DIR_MASK];
+    const char *name = entry_name(pl, offset);
+    const char *ext = extensions[header >> EXT_SHIFT];
+    size_t dir_len = strlen(dir);
+    size_t name_len = strlen(name);
+    size_t ext_len = ext ? strlen(ext) : 0;
+    if (dir_len + 1 + name_len + ext_len + 1 > size) {
+        return 0;
+    }
+
+    memcpy(buf, dir, dir_len);
+    buf[dir_len] = '/';
+    memcpy(buf + dir_len + 1, name, name_len);
+    memcpy(buf + dir_len + 1 + name_len, ext ? ext : "", ext_len + 1);
+    return dir_len + 1 + name_len + ext_len;
+}
+
+static const sd_playlist_t *sort_playlist;  // qsort bez kontekstu
+
+static int entry_name_cmp(const void *a, const void *b)
+{
+    return strcasecmp(entry_name(sort_playlist, *(const uint32_t *)a),
+                      entry_name(sort_playlist, *(const uint32_t *)b));
+}
+
+void sd_playlist_compact(sd_playlist_t *pl)
+{
+    // Jedna realokacja na playlistę zamiast do 50% zapasu w PSRAM
+    if (pl->count && pl->count < pl->capacity) {
+        uint32_t *p = realloc(pl->entries, pl->count * sizeof(uint32_t));
+        if (p) {
+            pl->entries = p;
+            pl->capacity = pl->count;
+        }
+    }
+    if (pl->arena_size && pl->arena_size < pl->arena_capacity) {
+        char *p = realloc(pl->arena, pl->arena_size);
+        if (p) {
+            pl->arena = p;
+            pl->arena_capacity = pl->arena_size;
+        }
+    }
+}
+
+void sd_playlist_sort_tail(sd_playlist_t *pl, uint32_t from)
+{
+    if (from + 1 >= pl->count) return;
+    sort_playlist = pl;
+    qsort(pl->entries + from, pl->count - from, sizeof(uint32_t), entry_name_cmp);
+}
+
+int sd_playlist_shuffle(sd_playlist_t *pl, int keep, uint32_t (*random)(void))
+{
+    if (pl->count < 2) {
+        return (keep >= 0 && (uint32_t)keep < pl->count) ? 0 : -1;
+    }
+
+    uint32_t kept = (keep >= 0 && (uint32_t)keep < pl->count) ? pl->entries[keep] : 0;
+    for (uint32_t i = pl->count - 1; i > 0; i--) {
+        uint32_t j = random() % (i + 1);
+        uint32_t temp = pl->entries[i];
+        pl->entries[i] = pl->entries[j];
+        pl->entries[j] = temp;
+    }
+    if (keep < 0 || (uint32_t)keep >= pl->count) {
+        return -1;
+    }
+
+    // Bieżący utwór na początek - offset wpisu jednoznacznie go identyfikuje
+    for (uint32_t i = 0; i < pl->count; i++) {
+        if (pl->entries[i] == kept) {
+            pl->entries[i] = pl->entries[0];
+            pl->entries[0] = kept;
+            break;
+        }
+    }
+    return 0;
+}
+
+size_t sd_playlist_memory(const sd_playlist_t *pl)
+{
+    return (size_t)pl->capacity * sizeof(uint32_t) + pl->arena_capacity +
+           (size_t)pl->dir_capacity * sizeof(uint32_t);
+}
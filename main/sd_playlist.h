@@ -0,0 +1,61 @@
+/*
+ * SD Playlist Module
+ * Zwarta playlista odtwarzacza SD: tablica 32-bitowych offsetów do areny ścieżek.
+ * Katalog zapisany raz, wpis to 2 bajty (numer katalogu, kod rozszerzenia) i nazwa
+ * pliku bez typowego rozszerzenia. Metadane utworów nie są przechowywane - odtwarzacz
+ * czyta je z indeksu biblioteki lub pliku przy odtwarzaniu.
+ * Wpis to 4 + 3 + długość nazwy bajtów: 10 000 plików "NN - Tytuł.mp3" z 12-znakowym
+ * rdzeniem nazwy to ~190 KB (poprzednio ~9 MB w sd_file_info_t).
+ *
+ * Czyste C bez zależności od ESP-IDF - można kompilować i sprawdzać na hoście.
+ */
+
+#ifndef SD_PLAYLIST_H
+#define SD_PLAYLIST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SD_PLAYLIST_MAX_DIRS    8192    // Numer katalogu zajmuje 13 bitów nagłówka wpisu
+
+typedef struct {
+    uint32_t *entries;          // Offset wpisu w arenie, w kolejności odtwarzania
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t max_entries;
+    char *arena;                // Katalogi "/muzyka/rock\0" i wpisy [uint16 nagłówek][nazwa\0]
+    uint32_t arena_size;
+    uint32_t arena_capacity;
+    uint32_t *dirs;             // Offsety katalogów w arenie
+    uint32_t dir_count;
+    uint32_t dir_capacity;
+    uint32_t last_dir;          // Ostatnio dodany katalog - kolejne pliki zwykle z tego samego
+} sd_playlist_t;
+
+void sd_playlist_init(sd_playlist_t *pl, uint32_t max_entries);
+
+// Czyści playlistę, zostawiając bufory na następną (bez ponownych alokacji)
+void sd_playlist_clear(sd_playlist_t *pl);
+void sd_playlist_free(sd_playlist_t *pl);
+
+// Dodaje ścieżkę ("/katalog/plik.mp3"). false - limit wpisów lub brak pamięci
+bool sd_playlist_add(sd_playlist_t *pl, const char *path);
+
+// Pełna ścieżka wpisu do bufora; zwraca jej długość (0 - zły indeks lub za mały bufor)
+size_t sd_playlist_get_path(const sd_playlist_t *pl, uint32_t index, char *buf, size_t size);
+
+// Zwalnia zapas buforów po zbudowaniu playlisty
+void sd_playlist_compact(sd_playlist_t *pl);
+
+// Sortuje wpisy [from, count) po nazwie pliku (bez rozróżniania wielkości liter)
+void sd_playlist_sort_tail(sd_playlist_t *pl, uint32_t from);
+
+// Losowa kolejność (permutacja tablicy offsetów). keep >= 0 - ten wpis trafia na początek.
+// Zwraca nową pozycję wpisu keep (0) lub -1.
+int sd_playlist_shuffle(sd_playlist_t *pl, int keep, uint32_t (*random)(void));
+
+// Pamięć zajęta przez playlistę (z zapasem buforów)
+size_t sd_playlist_memory(const sd_playlist_t *pl);
+
+#endif // SD_PLAYLIST_H
@@ -0,0 +1,787 @@
+/*
+ * SD Source Module
+ * Tor odtwarzania plików z karty SD (wybór dekodera MP3 / AAC / FLAC / WAV), przewijanie
+ * i przejście na następny plik bez przerwy
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_cpu.h"
+#include "sdkconfig.h"
+
+#include "sd_source.h"
+#include "player_status.h"
+#include "pipeline_stats.h"
+#include "media_index.h"
+#include "fatfs_stream.h"
+#include "mp3_decoder.h"
+#include "aac_decoder.h"
+#include "flac_decoder.h"
+#include "wav_decoder.h"
+
+static const char *TAG = "SD_SOURCE";
+
+#define SD_FILE_RB_SIZE             (128 * 1024)    // Skompresowane dane z karty (PSRAM)
+#define SD_PCM_RB_SIZE              (64 * 1024)     // PCM za dekoderem SD (PSRAM)
+#define SD_PROBE_SIZE               4096    // Nagłówek pliku do rozpoznania formatu
+#define SD_SEEK_RESUME_MS           40      // PCM z nowej pozycji, zanim wyjście znów pobiera
+
+static sd_source_t src = {0};
+const sd_source_t *const sd_source = &src;
+
+// Plik SD przygotowany do odtwarzania bez przerwy: sd_next czeka na koniec dekodowania
+// bieżącego, sd_chain jest już dekodowany za nim (do granicy w pcm_rb). Tylko task sterujący.
+typedef struct {
+    bool valid;
+    char path[256];
+    esp_codec_type_t codec;
+    seek_track_info_t track;
+} sd_next_t;
+
+static sd_next_t sd_next = {0};
+static sd_next_t sd_chain = {0};
+
+static audio_event_iface_handle_t sd_evt = NULL;
+static const sd_source_hooks_t *sd_hooks = NULL;
+
+static uint32_t now_ms(void)
+{
+    return xTaskGetTickCount() * portTICK_PERIOD_MS;
+}
+
+// ============================================
+// Tor SD
+// ============================================
+
+static player_sd_stats_t sd_stats = {0};
+
+static bool sd_element(void *el)
+{
+    return src.pipeline && el &&
+           (el == src.file || el == src.mp3 || el == src.aac ||
+            el == src.flac || el == src.wav);
+}
+
+// Wyjście elementu fatfs: czas między zapisami (bez czekania na miejsce w buforze)
+// to czas odczytu bloku z karty
+static int sd_file_write_cb(audio_element_handle_t el, char *buf, int len, TickType_t wait, void *ctx)
+{
+    uint32_t cycles = esp_cpu_get_cycle_count() - src.read_mark;
+    src.read_us += cycles / CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+    src.read_bytes += len;
+    pipeline_stats_add_in(PSTAT_SD, len);
+
+    ringbuf_handle_t rb = audio_element_get_output_ringbuf(el);
+    if (src.inject_len > 0) {
+        // Po przewinięciu FLAC/WAV: nagłówek strumienia przed danymi z nowej pozycji
+        int hlen = rb_write(rb, (char *)src.inject, src.inject_len, wait);
+        if (hlen < 0) {
+            return hlen;
+        }
+        src.inject_len = 0;
+    }
+    if (rb_bytes_available(rb) < len && player_status->state == PLAYER_STATE_PLAYING) {
+        pipeline_stats_overrun(PSTAT_SD);  // Karta szybsza niż dekoder - oczekiwane
+    }
+
+    int wlen = rb_write(rb, buf, len, wait);
+    if (wlen > 0) {
+        pipeline_stats_add_out(PSTAT_SD, wlen);
+    }
+    pipeline_stats_fill(PSTAT_SD, rb_bytes_filled(rb), rb_get_size(rb));
+
+    src.read_mark = esp_cpu_get_cycle_count();
+    return wlen;
+}
+
+// Wejście dekodera SD: dane z karty. Jak w slotach - czas między odczytami/zapisami
+// to czas dekodowania.
+static int sd_decoder_read_cb(audio_element_handle_t el, char *buf, int len, TickType_t wait, void *ctx)
+{
+    src.decode_cycles += esp_cpu_get_cycle_count() - src.io_mark;
+
+    ringbuf_handle_t rb = audio_element_get_input_ringbuf(el);
+    int filled = rb_bytes_filled(rb);
+    pipeline_stats_fill(PSTAT_DECODER, filled, rb_get_size(rb));
+    if (filled == 0 && player_status->state == PLAYER_STATE_PLAYING) {
+        pipeline_stats_underrun(PSTAT_DECODER);  // Karta nie nadąża
+    }
+
+    int rlen = rb_read(rb, buf, len, wait);
+    if (rlen > 0) {
+        pipeline_stats_add_in(PSTAT_DECODER, rlen);
+        src.consumed_bytes += rlen;
+    }
+
+    src.io_mark = esp_cpu_get_cycle_count();
+    return rlen;
+}
+
+static int sd_decoder_write_cb(audio_element_handle_t el, char *buf, int len, TickType_t wait, void *ctx)
+{
+    src.decode_cycles += esp_cpu_get_cycle_count() - src.io_mark;
+
+    uint32_t decode_us = src.decode_cycles / CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+    src.decode_us += decode_us;
+    pipeline_stats_decode_time(decode_us);
+    pipeline_stats_add_out(PSTAT_DECODER, len);
+    src.decode_cycles = 0;
+
+    // Opóźnienie kodera na początku utworu (po przewinięciu - próbki ramki przed celem)
+    // i dopełnienie za ostatnią próbką - odcięte, dekoder uznaje je za zapisane
+    int skipped;
+    int avail = seek_trim_block(&src.trim, len, &skipped);
+    int wlen = avail > 0 ? rb_write(src.pcm_rb, buf + skipped, avail, wait) : 0;
+    if (wlen > 0) {
+        src.pcm_written += wlen;
+        seek_trim_written(&src.trim, wlen);
+    }
+    src.io_mark = esp_cpu_get_cycle_count();
+    if (wlen < 0) {
+        return wlen;
+    }
+    return wlen == avail ? len : skipped + wlen;
+}
+
+static audio_element_handle_t sd_decoder_for_codec(esp_codec_type_t codec)
+{
+    switch (codec) {
+        case ESP_CODEC_TYPE_MP3:    return src.mp3;
+        case ESP_CODEC_TYPE_AAC:
+        case ESP_CODEC_TYPE_M4A:    return src.aac;
+        case ESP_CODEC_TYPE_FLAC:   return src.flac;
+        case ESP_CODEC_TYPE_WAV:    return src.wav;
+        default:                    return NULL;  // OGG - brak dekodera w tej konfiguracji
+    }
+}
+
+// Podłącza dekoder dla formatu pliku. Pipeline SD musi być zatrzymany.
+static bool sd_link_decoder(esp_codec_type_t codec)
+{
+    audio_element_handle_t dec = sd_decoder_for_codec(codec);
+    if (dec == NULL) {
+        return false;
+    }
+
+    if (dec == src.decoder) {
+        return true;
+    }
+
+    const char *link_tag[2] = {"file", audio_element_get_tag(dec)};
+
+    audio_pipeline_remove_listener(src.pipeline);
+    audio_pipeline_breakup_elements(src.pipeline, src.decoder);
+    audio_pipeline_relink(src.pipeline, link_tag, 2);
+    // Relink przywraca zapis/odczyt przez ringbuffer - callbacki po każdym połączeniu
+    audio_element_set_write_cb(src.file, sd_file_write_cb, NULL);
+    audio_element_set_read_cb(dec, sd_decoder_read_cb, NULL);
+    audio_element_set_write_cb(dec, sd_decoder_write_cb, NULL);
+    audio_pipeline_set_listener(src.pipeline, sd_evt);
+    src.decoder = dec;
+
+    ESP_LOGI(TAG, "SD decoder relinked: %s", link_tag[1]);
+    return true;
+}
+
+// Tworzy tor SD: fatfs + dekodery + bufor PCM, połączone file -> mp3
+esp_err_t sd_source_init(audio_event_iface_handle_t evt, const sd_source_hooks_t *hooks)
+{
+    if (src.pipeline) return ESP_OK;
+
+    sd_evt = evt;
+    sd_hooks = hooks;
+
+    // Odczyt blokami wielkości klastra - bufor elementu wyrównany do sektorów
+    fatfs_stream_cfg_t file_cfg = FATFS_STREAM_CFG_DEFAULT();
+    file_cfg.type = AUDIO_STREAM_READER;
+    file_cfg.buf_sz = SD_READ_BLOCK_SIZE;
+    file_cfg.out_rb_size = SD_FILE_RB_SIZE;
+    file_cfg.task_stack = 4 * 1024;
+    file_cfg.task_prio = 21;
+    file_cfg.task_core = 0;
+    src.file = fatfs_stream_init(&file_cfg);
+
+    mp3_decoder_cfg_t mp3_cfg = DEFAULT_MP3_DECODER_CONFIG();
+    mp3_cfg.task_stack = 8 * 1024;
+    mp3_cfg.out_rb_size = 64 * 1024;
+    mp3_cfg.task_prio = 22;
+    mp3_cfg.task_core = 0;
+    src.mp3 = mp3_decoder_init(&mp3_cfg);
+
+    aac_decoder_cfg_t aac_cfg = DEFAULT_AAC_DECODER_CONFIG();
+    aac_cfg.task_stack = 8 * 1024;
+    aac_cfg.out_rb_size = 64 * 1024;
+    aac_cfg.task_prio = 22;
+    aac_cfg.task_core = 0;
+    aac_cfg.stack_in_ext = true;
+    aac_cfg.plus_enable = true;
+    src.aac = aac_decoder_init(&aac_cfg);
+
+    flac_decoder_cfg_t flac_cfg = DEFAULT_FLAC_DECODER_CONFIG();
+    flac_cfg.task_stack = 8 * 1024;
+    flac_cfg.out_rb_size = 64 * 1024;
+    flac_cfg.task_prio = 22;
+    flac_cfg.task_core = 0;
+    flac_cfg.stack_in_ext = true;
+    src.flac = flac_decoder_init(&flac_cfg);
+
+    wav_decoder_cfg_t wav_cfg = DEFAULT_WAV_DECODER_CONFIG();
+    wav_cfg.task_stack = 4 * 1024;
+    wav_cfg.out_rb_size = 64 * 1024;
+    wav_cfg.task_prio = 22;
+    wav_cfg.task_core = 0;
+    wav_cfg.stack_in_ext = true;
+    src.wav = wav_decoder_init(&wav_cfg);
+
+    src.pcm_rb = rb_create(SD_PCM_RB_SIZE, 1);
+
+    if (src.file == NULL || src.mp3 == NULL || src.aac == NULL ||
+        src.flac == NULL || src.wav == NULL || src.pcm_rb == NULL) {
+        ESP_LOGE(TAG, "Failed to create SD source");
+        return ESP_ERR_NO_MEM;
+    }
+
+    audio_pipeline_cfg_t pipeline_cfg = DEFAULT_AUDIO_PIPELINE_CONFIG();
+    pipeline_cfg.rb_size = SD_FILE_RB_SIZE;
+    src.pipeline = audio_pipeline_init(&pipeline_cfg);
+    if (src.pipeline == NULL) {
+        ESP_LOGE(TAG, "Failed to create SD pipeline");
+        return ESP_FAIL;
+    }
+
+    audio_pipeline_register(src.pipeline, src.file, "file");
+    audio_pipeline_register(src.pipeline, src.mp3, "mp3");
+    audio_pipeline_register(src.pipeline, src.aac, "aac");
+    audio_pipeline_register(src.pipeline, src.flac, "flac");
+    audio_pipeline_register(src.pipeline, src.wav, "wav");
+
+    const char *link_tag[2] = {"file", "mp3"};
+    audio_pipeline_link(src.pipeline, &link_tag[0], 2);
+    audio_element_set_write_cb(src.file, sd_file_write_cb, NULL);
+    audio_element_set_read_cb(src.mp3, sd_decoder_read_cb, NULL);
+    audio_element_set_write_cb(src.mp3, sd_decoder_write_cb, NULL);
+    src.decoder = src.mp3;
+
+    audio_pipeline_set_listener(src.pipeline, sd_evt);
+    ESP_LOGI(TAG, "SD pipeline: file -> mp3/aac/flac/wav -> [output]");
+    return ESP_OK;
+}
+
+void sd_source_deinit(void)
+{
+    if (src.pipeline == NULL) return;
+
+    audio_pipeline_stop(src.pipeline);
+    audio_pipeline_wait_for_stop(src.pipeline);
+    audio_pipeline_terminate(src.pipeline);
+
+    audio_pipeline_unregister(src.pipeline, src.file);
+    audio_pipeline_unregister(src.pipeline, src.mp3);
+    audio_pipeline_unregister(src.pipeline, src.aac);
+    audio_pipeline_unregister(src.pipeline, src.flac);
+    audio_pipeline_unregister(src.pipeline, src.wav);
+    audio_pipeline_remove_listener(src.pipeline);
+
+    audio_pipeline_deinit(src.pipeline);
+    audio_element_deinit(src.file);
+    audio_element_deinit(src.mp3);
+    audio_element_deinit(src.aac);
+    audio_element_deinit(src.flac);
+    audio_element_deinit(src.wav);
+    rb_destroy(src.pcm_rb);
+    memset(&src, 0, sizeof(src));
+}
+
+void sd_source_stop(void)
+{
+    if (src.pipeline == NULL || !src.running) return;
+
+    src.running = false;
+    rb_abort(src.pcm_rb);  // Dekoder może czekać na miejsce w PCM, którego nikt nie czyta
+    audio_pipeline_stop(src.pipeline);
+    audio_pipeline_wait_for_stop(src.pipeline);
+}
+
+// Audio czekające w torze SD: PCM za dekoderem (dane z karty dochodzą w milisekundach,
+// więc skompresowany zapas nie jest liczony)
+int sd_source_buffered_ms(void)
+{
+    if (src.pcm_rb == NULL) return 0;
+
+    int rate = src.sample_rate > 0 ? src.sample_rate : 44100;
+    int channels = src.channels > 0 ? src.channels : 2;
+    int bytes = (src.bits > 16 ? src.bits / 8 : 2);
+    return (int)((int64_t)rb_bytes_filled(src.pcm_rb) * 1000 / (rate * channels * bytes));
+}
+
+// Pozycja w pliku: start, cel przewinięcia lub granica utworów plus PCM pobrany od tej
+// chwili przez etap wyjściowy
+uint32_t sd_source_position_ms(void)
+{
+    int rate = src.sample_rate;
+    int frame = src.channels * (src.bits > 16 ? src.bits / 8 : 2);
+    if (rate <= 0 || frame <= 0) {
+        return src.position_ms;
+    }
+    uint32_t played = src.pcm_read - src.position_mark;
+    return src.position_ms + (uint32_t)((uint64_t)(played / frame) * 1000 / rate);
+}
+
+// Po przewinięciu wyjście rusza, gdy dekoder oddał trochę PCM z nowej pozycji
+static bool sd_seek_ready(void)
+{
+    if (sd_source_buffered_ms() < SD_SEEK_RESUME_MS && !src.decode_done) {
+        return false;
+    }
+    src.seeking = false;
+    sd_stats.last_seek_ms = now_ms() - src.seek_started_ms;
+    if (sd_stats.last_seek_ms > sd_stats.max_seek_ms) {
+        sd_stats.max_seek_ms = sd_stats.last_seek_ms;
+    }
+    return true;
+}
+
+// Raz na sekundę (tick prebufora): przepustowość karty i obciążenie dekodera.
+// read_busy < 1000 i zapełniony bufor pliku - tor SD nie zagłodzi I2S.
+void sd_source_stats_update(uint32_t now)
+{
+    static uint32_t last_ms, last_read_us, last_read_bytes, last_decode_us, last_consumed;
+
+    uint32_t wall_ms = now - last_ms;
+    if (wall_ms < 1000) return;
+
+    uint32_t read_us = src.read_us - last_read_us;
+    uint32_t read_bytes = src.read_bytes - last_read_bytes;
+    uint32_t decode_us = src.decode_us - last_decode_us;
+    uint32_t consumed = src.consumed_bytes - last_consumed;
+
+    if (last_ms != 0) {
+        // Bajty na milisekundę = kB/s
+        sd_stats.read_kbps = read_us ? (uint32_t)((uint64_t)read_bytes * 1000 / read_us) : 0;
+        sd_stats.read_busy_permille = read_us / wall_ms;
+        sd_stats.decode_permille = decode_us / wall_ms;
+        sd_stats.consume_kbps = consumed / wall_ms;
+    }
+
+    last_ms = now;
+    last_read_us = src.read_us;
+    last_read_bytes = src.read_bytes;
+    last_decode_us = src.decode_us;
+    last_consumed = src.consumed_bytes;
+}
+
+// ============================================
+// Sterowanie (task sterujący)
+// ============================================
+
+// Format z nagłówka pliku (rozszerzenie tylko gdy nagłówek nic nie mówi) i granice utworu
+static bool sd_probe_file(const char *path, esp_codec_type_t *codec, seek_track_info_t *track)
+{
+    static uint8_t probe[SD_PROBE_SIZE];  // Tylko task sterujący
+
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return false;
+    }
+    int len = fread(probe, 1, sizeof(probe), f);
+    *codec = codec_detect_file(probe, len, path);
+    if (!seek_index_track_info(f, *codec, track)) {
+        memset(track, 0, sizeof(*track));   // Uszkodzony nagłówek - dekoder od początku pliku
+    }
+    fclose(f);
+    return true;
+}
+
+// Punkt startu dekodowania dla pozycji ms (z tabelą ramek MP3, jeśli zbudowana)
+static bool sd_locate(const char *path, esp_codec_type_t codec, uint32_t ms, seek_point_t *point)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        ESP_LOGW(TAG, "Seek: cannot open %s", path);
+        return false;
+    }
+    seek_mp3_table_t table = {0};
+    if (codec == ESP_CODEC_TYPE_MP3 && fseek(f, 0, SEEK_END) == 0) {
+        media_index_load_seek_table(path, ftell(f), &table);
+    }
+    bool found = seek_index_locate(f, codec, ms, &table, point);
+    fclose(f);
+    seek_index_mp3_free(&table);
+    if (!found) {
+        ESP_LOGW(TAG, "Seek not supported for %s file", codec_detect_name(codec));
+    }
+    return found;
+}
+
+// Tor SD zaczyna od punktu z seek_index: nagłówek do wstrzyknięcia, próbki do odrzucenia
+// i pozycja. Wołane po wyzerowaniu buforów toru, przed audio_pipeline_run().
+static void sd_apply_seek_point(const seek_point_t *point)
+{
+    memcpy(src.inject, point->header, point->header_len);
+    src.inject_len = point->header_len;
+
+    // Format z music info tego pliku, przed nim z nagłówka
+    uint64_t first = seek_trim_seek(&src.trim, &src.track, point, src.sample_rate,
+                                    src.channels, src.bits);
+    src.position_ms = (uint32_t)(first * 1000 / point->sample_rate);
+    src.position_mark = src.pcm_read;
+    audio_element_set_byte_pos(src.file, point->byte_pos);  // fatfs otworzy plik od offsetu
+}
+
+// Wspólny restart toru od pozycji w bieżącym lub nowym pliku: bufory za czytnikiem
+// wyzerowane, generacja zwiększona (zdarzenia i koniec pliku sprzed restartu są nieaktualne)
+static void sd_restart_prepare(void)
+{
+    audio_element_set_uri(src.file, src.path);
+    src.generation++;
+    src.decode_done = false;
+    src.end_posted = false;
+    src.inject_len = 0;
+
+    audio_pipeline_reset_ringbuffer(src.pipeline);
+    audio_pipeline_reset_elements(src.pipeline);
+    rb_reset(src.pcm_rb);
+}
+
+static esp_err_t sd_run(void)
+{
+    src.read_mark = esp_cpu_get_cycle_count();
+    src.io_mark = src.read_mark;
+    src.decode_cycles = 0;
+
+    esp_err_t ret = audio_pipeline_run(src.pipeline);
+    src.running = (ret == ESP_OK);
+    return ret;
+}
+
+void sd_source_release(void)
+{
+    sd_source_stop();
+    sd_next.valid = false;
+    sd_chain.valid = false;
+    src.chained = false;
+}
+
+// Z radia lub innego pliku: poprzedni plik i przygotowany następny porzucone
+esp_err_t sd_source_start(const char *path, uint32_t start_ms)
+{
+    if (src.pipeline == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    // Przygotowany następny plik dotyczył poprzedniego utworu
+    sd_source_release();
+
+    esp_codec_type_t codec;
+    seek_track_info_t track;
+    if (!sd_probe_file(path, &codec, &track)) {
+        ESP_LOGE(TAG, "Cannot open file: %s", path);
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (!sd_link_decoder(codec)) {
+        ESP_LOGE(TAG, "Unsupported format: %s", path);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    ESP_LOGI(TAG, "SD file format: %s", codec_detect_name(codec));
+
+    src.codec = codec;
+    src.sample_rate = 0;
+    src.track = track;
+    seek_trim_init(&src.trim, &track);
+    src.seeking = false;
+    if (src.path != path) {
+        strncpy(src.path, path, sizeof(src.path) - 1);
+        src.path[sizeof(src.path) - 1] = '\0';
+    }
+    sd_restart_prepare();
+
+    seek_point_t point;
+    if (start_ms > 0 && sd_locate(src.path, codec, start_ms, &point)) {
+        sd_apply_seek_point(&point);
+        ESP_LOGI(TAG, "SD start at %lu ms: offset %lu", (unsigned long)src.position_ms,
+                 (unsigned long)point.byte_pos);
+    } else {
+        audio_element_set_byte_pos(src.file, track.start_pos);  // MP3 - za ramką Xing/Info
+        src.position_ms = 0;
+        src.position_mark = src.pcm_read;
+    }
+
+    esp_err_t ret = sd_run();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to start SD pipeline: %s (%s)", path, esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+// Format i granice utworu czytane teraz, żeby przejście na końcu bieżącego nie czekało
+// na kartę
+void sd_source_prime(const char *path)
+{
+    sd_next.valid = false;
+    if (path == NULL || path[0] == '\0') {
+        return;
+    }
+    if (!sd_probe_file(path, &sd_next.codec, &sd_next.track)) {
+        ESP_LOGW(TAG, "Next track: cannot open %s", path);
+        return;
+    }
+    if (sd_decoder_for_codec(sd_next.codec) == NULL) {
+        ESP_LOGW(TAG, "Next track: unsupported format %s", path);
+        return;
+    }
+    strncpy(sd_next.path, path, sizeof(sd_next.path) - 1);
+    sd_next.path[sizeof(sd_next.path) - 1] = '\0';
+    sd_next.valid = true;
+    ESP_LOGI(TAG, "Next track primed: %s (%s, skip %lu, %llu samples)", path,
+             codec_detect_name(sd_next.codec), (unsigned long)sd_next.track.skip_samples,
+             (unsigned long long)sd_next.track.total_samples);
+}
+
+// Z przygotowanym następnym tor SD przechodzi na niego od razu, a końcówka bieżącego
+// zostaje w pcm_rb - etap wyjściowy gra oba pliki bez przerwy. Bez następnego bufor PCM
+// jest zamykany i koniec zgłosi etap wyjściowy (SD_EVENT_END).
+void sd_source_chain(bool paused)
+{
+    if (sd_next.valid && src.running && !src.chained) {
+        // Element w pauzie nie przyjmuje stop (jak przy przewijaniu)
+        if (paused) {
+            audio_pipeline_resume(src.pipeline);
+        }
+        // Dekoder skończył - nie czeka na pcm_rb, bufor zostaje z końcówką utworu
+        audio_pipeline_stop(src.pipeline);
+        audio_pipeline_wait_for_stop(src.pipeline);
+
+        sd_chain = sd_next;
+        sd_next.valid = false;
+        sd_link_decoder(sd_chain.codec);
+        audio_element_set_uri(src.file, sd_chain.path);
+        audio_pipeline_reset_ringbuffer(src.pipeline);
+        audio_pipeline_reset_elements(src.pipeline);
+        audio_element_set_byte_pos(src.file, sd_chain.track.start_pos);
+
+        seek_trim_init(&src.trim, &sd_chain.track);
+        src.next_rate = sd_chain.track.sample_rate;
+        src.next_channels = sd_chain.track.channels;
+        src.next_bits = sd_chain.track.bits;
+        src.boundary = src.pcm_written;
+        src.chained = true;
+        src.read_mark = esp_cpu_get_cycle_count();
+        src.io_mark = src.read_mark;
+        src.decode_cycles = 0;
+
+        if (audio_pipeline_run(src.pipeline) == ESP_OK) {
+            ESP_LOGI(TAG, "SD gapless: decoding %s", sd_chain.path);
+            return;
+        }
+        ESP_LOGE(TAG, "Failed to start next SD file: %s", sd_chain.path);
+        src.chained = false;
+        sd_chain.valid = false;
+    }
+    src.decode_done = true;
+    rb_done_write(src.pcm_rb);
+}
+
+bool sd_source_advance(void)
+{
+    if (!sd_chain.valid) {
+        return false;
+    }
+    strcpy(src.path, sd_chain.path);
+    src.codec = sd_chain.codec;
+    src.track = sd_chain.track;
+    sd_chain.valid = false;
+    sd_stats.gapless++;
+    ESP_LOGI(TAG, "SD track changed: %s", src.path);
+    return true;
+}
+
+bool sd_source_next_pending(void)
+{
+    return sd_chain.valid && !src.chained;
+}
+
+// Pozycja z seek_index, restart toru od nowego offsetu. Etap wyjściowy (EQ, I2S) gra
+// dalej - opróżniane są tylko bufory za czytnikiem pliku.
+esp_err_t sd_source_seek(uint32_t ms, bool paused, bool playing)
+{
+    if (!src.running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    uint32_t started = now_ms();
+
+    // Pozycja liczona, zanim tor stanie - do tej chwili gra stara pozycja
+    seek_point_t point;
+    if (!sd_locate(src.path, src.codec, ms, &point)) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    // Element w pauzie nie przyjmuje stop - wznowienie toru, wyjście i tak nie pobiera
+    if (paused) {
+        audio_pipeline_resume(src.pipeline);
+    }
+    sd_source_stop();
+
+    // Dekoder mógł już czytać następny plik - wraca na bieżący, następny czeka jak wcześniej
+    if (src.chained) {
+        src.chained = false;
+        if (!sd_next.valid) {
+            sd_next = sd_chain;
+        }
+        sd_chain.valid = false;
+    }
+    sd_link_decoder(src.codec);
+    sd_restart_prepare();
+    sd_apply_seek_point(&point);
+    src.seek_started_ms = started;
+    src.seeking = playing;
+
+    esp_err_t ret = sd_run();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to restart SD pipeline after seek: %s (%s)", src.path,
+                 esp_err_to_name(ret));
+        return ret;
+    }
+    sd_stats.seeks++;
+    ESP_LOGI(TAG, "SD seek to %lu ms: offset %lu, %s", (unsigned long)src.position_ms,
+             (unsigned long)point.byte_pos, point.exact ? "exact" : "estimated");
+    return ESP_OK;
+}
+
+void sd_source_resumed(void)
+{
+    if (src.io_mark) {
+        src.io_mark = esp_cpu_get_cycle_count();  // Czas w pauzie to nie dekodowanie
+        src.read_mark = src.io_mark;
+    }
+}
+
+// ============================================
+// Etap wyjściowy
+// ============================================
+
+bool sd_source_seek_pending(void)
+{
+    return src.seeking && !sd_seek_ready();
+}
+
+// Etap wyjściowy doszedł do pierwszej próbki następnego pliku. Format inny niż bieżący -
+// wyjście czeka, aż task sterujący przestawi I2S (jedyna przerwa przy przejściu).
+static bool sd_track_boundary(void)
+{
+    bool format_changed = false;
+
+    src.chained = false;
+    src.position_ms = 0;
+    src.position_mark = src.pcm_read;
+    if (src.next_rate != src.sample_rate || src.next_channels != src.channels ||
+        src.next_bits != src.bits) {
+        src.sample_rate = src.next_rate;    // 0 - format dopiero z music info
+        src.channels = src.next_channels;
+        src.bits = src.next_bits;
+        format_changed = true;
+    }
+    sd_hooks->post(SD_EVENT_NEXT, 0, src.generation);
+    return format_changed;
+}
+
+// Odczyt kończy się na granicy utworów - za nią może być inny format
+int sd_source_output_len(int len)
+{
+    if (!src.chained) {
+        return len;
+    }
+    uint32_t left = src.boundary - src.pcm_read;
+    if (left == 0) {
+        return sd_track_boundary() ? -1 : len;
+    }
+    return (uint32_t)len > left ? (int)left : len;
+}
+
+void sd_source_output_read(int len)
+{
+    src.pcm_read += len;
+}
+
+// Plik odegrany do końca (także PCM w buforze) - następny utwór wybiera task sterujący
+void sd_source_output_done(void)
+{
+    if (!src.end_posted) {
+        src.end_posted = true;
+        sd_hooks->post(SD_EVENT_END, 0, src.generation);
+    }
+}
+
+// ============================================
+// Zdarzenia elementów
+// ============================================
+
+// Format pliku i koniec danych. Elementy z zapisem przez callback nie zamykają bufora
+// wyjściowego same - czytający dostaje RB_DONE dopiero stąd.
+bool sd_source_handle_event(const audio_event_iface_msg_t *msg)
+{
+    if (msg->source_type != AUDIO_ELEMENT_TYPE_ELEMENT || !sd_element(msg->source)) {
+        return false;
+    }
+    audio_element_handle_t el = (audio_element_handle_t)msg->source;
+
+    if (msg->cmd == AEL_MSG_CMD_REPORT_STATUS &&
+        (int)msg->data >= AEL_STATUS_ERROR_OPEN && (int)msg->data <= AEL_STATUS_ERROR_UNKNOWN) {
+        sd_hooks->post(SD_EVENT_ERROR, (int)msg->data, src.generation);
+        return true;
+    }
+    if (!src.running) {
+        return true;
+    }
+
+    if (msg->cmd == AEL_MSG_CMD_REPORT_MUSIC_INFO && el == src.decoder) {
+        audio_element_info_t music_info = {0};
+        audio_element_getinfo(el, &music_info);
+        ESP_LOGI(TAG, "SD music info: sample_rate=%d, channels=%d, bits=%d",
+                 music_info.sample_rates, music_info.channels, music_info.bits);
+
+        if (music_info.sample_rates > 0 && music_info.channels > 0 && src.chained) {
+            // Następny plik - w buforze gra jeszcze końcówka bieżącego
+            src.next_rate = music_info.sample_rates;
+            src.next_channels = music_info.channels;
+            src.next_bits = music_info.bits;
+        } else if (music_info.sample_rates > 0 && music_info.channels > 0) {
+            src.sample_rate = music_info.sample_rates;
+            src.channels = music_info.channels;
+            src.bits = music_info.bits;
+            sd_hooks->post(SD_EVENT_FORMAT, 0, src.generation);
+        }
+    } else if (msg->cmd == AEL_MSG_CMD_REPORT_STATUS &&
+               (int)msg->data == AEL_STATUS_STATE_FINISHED) {
+        if (el == src.file) {
+            rb_done_write(audio_element_get_output_ringbuf(el));
+        } else if (el == src.decoder) {
+            // Bufor PCM zamyka task sterujący, jeśli nie ma następnego pliku
+            if (src.chained || sd_hooks->post(SD_EVENT_CHAIN, 0, src.generation) != ESP_OK) {
+                src.decode_done = true;
+                rb_done_write(src.pcm_rb);
+            }
+        }
+    }
+    return true;
+}
+
+// ============================================
+// Statystyki
+// ============================================
+
+int sd_source_file_percent(void)
+{
+    ringbuf_handle_t rb = src.file ? audio_element_get_output_ringbuf(src.file) : NULL;
+    return rb ? rb_bytes_filled(rb) * 100 / rb_get_size(rb) : 0;
+}
+
+void sd_source_get_stats(player_sd_stats_t *stats)
+{
+    *stats = sd_stats;
+    stats->active = (player_status->source == AUDIO_SOURCE_SDCARD && src.running);
+    stats->codec = stats->active ? codec_detect_name(src.codec) : "";
+    stats->read_block_kb = SD_READ_BLOCK_SIZE / 1024;
+    stats->buffered_ms = stats->active ? sd_source_buffered_ms() : 0;
+}
@@ -0,0 +1,125 @@
+/*
+ * SD Source Module
+ * Źródło SD: fatfs -> mp3/aac/flac/wav -> pcm_rb. Tworzone przy pierwszym odtworzeniu
+ * pliku; etap wyjściowy audio_player.c ten sam co dla radia (przełączenie podmienia tylko
+ * bufor PCM). Przewijanie przez seek_index, przejście na następny plik bez przerwy.
+ *
+ * Sterowanie tylko z taska sterującego odtwarzacza. Zdarzenia z taska zdarzeń i etapu
+ * wyjściowego wracają do niego przez hooks->post z generacją toru.
+ */
+
+#ifndef SD_SOURCE_H
+#define SD_SOURCE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "audio_pipeline.h"
+#include "audio_element.h"
+#include "audio_event_iface.h"
+#include "ringbuf.h"
+#include "audio_player.h"
+#include "codec_detect.h"
+#include "seek_index.h"
+
+#define SD_READ_BLOCK_SIZE          (32 * 1024)     // Całe klastry FAT - mniej wywołań f_read i transferów SDMMC
+#define SD_PREBUFFER_MS             200     // Karta odpowiada w milisekundach - krótki start
+
+typedef enum {
+    SD_EVENT_FORMAT,                // Dekoder zgłosił format bieżącego pliku
+    SD_EVENT_CHAIN,                 // Dekoder skończył plik - przejście na następny
+    SD_EVENT_NEXT,                  // Etap wyjściowy doszedł do następnego pliku
+    SD_EVENT_END,                   // Etap wyjściowy odegrał plik do końca
+    SD_EVENT_ERROR,                 // value = AEL_STATUS_ERROR_*
+} sd_source_event_t;
+
+typedef struct {
+    esp_err_t (*post)(sd_source_event_t event, int32_t value, uint32_t gen);
+} sd_source_hooks_t;
+
+typedef struct {
+    audio_pipeline_handle_t pipeline;
+    audio_element_handle_t file;
+    audio_element_handle_t mp3;
+    audio_element_handle_t aac;
+    audio_element_handle_t flac;
+    audio_element_handle_t wav;
+    audio_element_handle_t decoder;         // Aktualnie podłączony dekoder
+    ringbuf_handle_t pcm_rb;
+    char path[256];
+    esp_codec_type_t codec;
+    volatile bool running;
+    volatile bool decode_done;              // Dekoder skończył plik (bufor PCM zamknięty)
+    volatile bool end_posted;               // Koniec pliku zgłoszony przez etap wyjściowy
+    uint32_t generation;                    // Zwiększany przy każdym starcie - odrzuca stare komendy
+    int sample_rate;
+    int channels;
+    int bits;
+    uint32_t read_mark;                     // Cykle CPU: koniec ostatniego zapisu elementu fatfs
+    uint32_t read_us;                       // Czas odczytu z karty (licznik narastający)
+    uint32_t read_bytes;
+    uint32_t consumed_bytes;                // Dane pobrane przez dekoder
+    uint32_t io_mark;                       // Cykle CPU: koniec ostatniego odczytu/zapisu dekodera
+    uint32_t decode_cycles;                 // Cykle dekodowania od ostatniej ramki
+    uint32_t decode_us;                     // Czas dekodowania (licznik narastający)
+    uint8_t inject[SEEK_HEADER_MAX];        // Nagłówek strumienia przed danymi z nowej pozycji
+    volatile int inject_len;
+    seek_trim_t trim;                       // Opóźnienie i dopełnienie kodera do odcięcia za dekoderem
+    seek_track_info_t track;                // Granice i format bieżącego utworu z nagłówka
+    volatile uint32_t pcm_written;          // PCM zapisany do pcm_rb (licznik narastający)
+    volatile uint32_t pcm_read;             // PCM pobrany przez etap wyjściowy (licznik narastający)
+    uint32_t position_ms;                   // Pozycja pierwszej próbki po starcie / przewinięciu
+    uint32_t position_mark;                 // pcm_read w chwili position_ms
+    volatile bool seeking;                  // Wyjście czeka na PCM z nowej pozycji
+    uint32_t seek_started_ms;
+    volatile bool chained;                  // Dekoder czyta już następny plik, granica w pcm_rb
+    volatile uint32_t boundary;             // pcm_written na końcu bieżącego utworu
+    int next_rate;                          // Format następnego pliku do chwili granicy
+    int next_channels;
+    int next_bits;
+} sd_source_t;
+
+// Stan toru tylko do odczytu - zmienia go wyłącznie ten moduł
+extern const sd_source_t *const sd_source;
+
+// Tor tworzony przy pierwszym odtworzeniu (kolejne wywołania nic nie robią)
+esp_err_t sd_source_init(audio_event_iface_handle_t evt, const sd_source_hooks_t *hooks);
+void sd_source_deinit(void);
+
+void sd_source_stop(void);
+void sd_source_release(void);           // Stop i porzucenie przygotowanego następnego pliku
+
+// Plik od pozycji start_ms (0 - od początku). Błędy logowane tutaj.
+esp_err_t sd_source_start(const char *path, uint32_t start_ms);
+
+// Następny plik do odtwarzania bez przerwy ("" lub NULL - brak)
+void sd_source_prime(const char *path);
+
+// SD_EVENT_CHAIN: dekoder skończył plik - przejście na przygotowany następny lub
+// zamknięcie bufora PCM. paused - tor w pauzie.
+void sd_source_chain(bool paused);
+
+// SD_EVENT_NEXT: następny plik staje się bieżącym; false - nic do przejęcia
+bool sd_source_advance(void);
+bool sd_source_next_pending(void);      // Granica minięta, SD_EVENT_NEXT jeszcze nie obsłużone
+
+// Przewinięcie bieżącego pliku. ESP_ERR_NOT_SUPPORTED - pozycja nieosiągalna, tor gra dalej.
+esp_err_t sd_source_seek(uint32_t ms, bool paused, bool playing);
+void sd_source_resumed(void);           // Po wznowieniu z pauzy
+
+// Etap wyjściowy (task EQ)
+bool sd_source_seek_pending(void);      // Przewijanie - wyjście czeka, to nie underrun
+int sd_source_output_len(int len);      // Odczyt do granicy utworów; -1 - granica, inny format
+void sd_source_output_read(int len);
+void sd_source_output_done(void);       // Bufor PCM zamknięty - koniec pliku
+
+// Zdarzenia elementów (task zdarzeń); true - element toru SD
+bool sd_source_handle_event(const audio_event_iface_msg_t *msg);
+
+int sd_source_buffered_ms(void);
+uint32_t sd_source_position_ms(void);
+int sd_source_file_percent(void);       // Zapełnienie bufora danych z karty
+void sd_source_stats_update(uint32_t now);
+void sd_source_get_stats(player_sd_stats_t *stats);
+
+#endif // SD_SOURCE_H
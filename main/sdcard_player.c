@@ -4,11 +4,13 @@
  */
 
 #include <string.h>
+#include <strings.h>
 #include <ctype.h>
 #include <dirent.h>
 #include <sys/stat.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "esp_log.h"
 #include "esp_random.h"
 #include "esp_vfs_fat.h"
@@ -17,6 +19,9 @@
 
 #include "sdcard_player.h"
 #include "audio_player.h"
+#include "media_index.h"
+#include "sd_playlist.h"
+#include "sd_bookmark.h"
 #include "config.h"
 
 static const char *TAG = "SD_PLAYER";
@@ -25,18 +30,27 @@ static const char *TAG = "SD_PLAYER";
 // Constants
 // ============================================
 #define SD_MOUNT_POINT      "/sdcard"
-#define MAX_PLAYLIST_SIZE   500
-#define SUPPORTED_EXTENSIONS ".mp3.flac.wav.ogg.aac.m4a"
+#define MAX_PLAYLIST_SIZE   10000
+#define SUPPORTED_EXTENSIONS ".mp3.flac.wav.aac.m4a"  // Formaty z dekoderem w audio_player
 
 // ============================================
 // State variables
 // ============================================
 static sd_player_status_t player_status = {0};
-static sd_file_info_t *playlist = NULL;
-static int playlist_count = 0;
-static int playlist_capacity = 0;
+static sd_playlist_t playlist = { .max_entries = MAX_PLAYLIST_SIZE };  // Same ścieżki, tagi przy odtwarzaniu
 static bool card_mounted = false;
 static sdmmc_card_t *card = NULL;
+static char primed_path[256] = "";  // Następny utwór przekazany do audio_player (gapless)
+static int primed_index = -1;
+
+// Zakładki długich plików - dostęp pod bookmark_lock, zapis na kartę w bookmark_task
+static sd_bookmarks_t bookmarks;
+static bool bookmarks_loaded = false;
+static SemaphoreHandle_t bookmark_lock = NULL;
+static TaskHandle_t bookmark_task_handle = NULL;
+static char bookmark_path[256] = "";    // Bieżący plik z zakładką ("" - krótki plik)
+static uint32_t bookmark_duration_ms = 0;
+static uint32_t bookmark_flushed_ms = 0;
 
 // Callbacks
 static sd_state_callback_t state_callback = NULL;
@@ -61,6 +75,37 @@ static bool is_audio_file(const char *filename) {
     return strstr(SUPPORTED_EXTENSIONS, ext_lower) != NULL;
 }
 
+// Ścieżka względem karty: "/sdcard/a/" lub "a" -> "/a", korzeń "/"
+static size_t card_relative_path(const char *path, char *out, size_t size) {
+    if (strncmp(path, SD_MOUNT_POINT, strlen(SD_MOUNT_POINT)) == 0) {
+        path += strlen(SD_MOUNT_POINT);
+    }
+    snprintf(out, size, "%s%s", path[0] == '/' ? "" : "/", path);
+    size_t len = strlen(out);
+    if (len > 1 && out[len - 1] == '/') {
+        out[--len] = '\0';
+    }
+    return len;
+}
+
+// Pełna ścieżka pliku: "/sdcard/..." bez zmian, względna - od punktu montowania
+static void card_full_path(const char *filepath, char *out, size_t size) {
+    if (strncmp(filepath, SD_MOUNT_POINT, strlen(SD_MOUNT_POINT)) == 0) {
+        snprintf(out, size, "%s", filepath);
+    } else if (filepath[0] == '/') {
+        snprintf(out, size, "%s%s", SD_MOUNT_POINT, filepath);
+    } else {
+        snprintf(out, size, "%s/%s", SD_MOUNT_POINT, filepath);
+    }
+}
+
+// Ścieżka audio_player (pełna) kończy się ścieżką odtwarzacza SD (względną lub pełną)
+static bool path_matches(const char *full, const char *path) {
+    size_t full_len = strlen(full);
+    size_t len = strlen(path);
+    return len > 0 && len <= full_len && strcmp(full + full_len - len, path) == 0;
+}
+
 static void notify_state_change(void) {
     if (state_callback) {
         state_callback(&player_status);
@@ -113,6 +158,10 @@ static esp_err_t mount_sdcard(void) {
     ESP_LOGI(TAG, "SD card mounted: %s, %lluMB",
              card->cid.name, ((uint64_t)card->csd.capacity) * card->csd.sector_size / (1024 * 1024));
 
+#if MEDIA_INDEX_ENABLED
+    media_index_init();  // Wczytuje indeks i zleca skan przyrostowy (także po wymianie karty)
+#endif
+
     return ESP_OK;
 }
 
@@ -129,34 +178,273 @@ static esp_err_t unmount_sdcard(void) {
 }
 
 // ============================================
-// Playlist management
+// Bookmarks
 // ============================================
 
-static esp_err_t playlist_ensure_capacity(int needed) {
-    if (playlist_capacity >= needed) {
-        return ESP_OK;
+static uint32_t bookmark_now_ms(void) {
+    return xTaskGetTickCount() * portTICK_PERIOD_MS;
+}
+
+// Zapis zakładek na kartę w tle (bookmark_task) - wołający nie czeka na kartę
+static void bookmark_flush_async(void) {
+    if (bookmark_task_handle) {
+        xTaskNotifyGive(bookmark_task_handle);
     }
+}
 
-    int new_capacity = (needed + 50) > MAX_PLAYLIST_SIZE ? MAX_PLAYLIST_SIZE : (needed + 50);
-    sd_file_info_t *new_playlist = realloc(playlist, new_capacity * sizeof(sd_file_info_t));
-    if (new_playlist == NULL) {
-        return ESP_ERR_NO_MEM;
+// Pozycja bieżącego pliku SD z audio_player; false - gra inny plik lub inne źródło
+static bool bookmark_position(const char *path, uint32_t *position_ms) {
+    player_status_t status;
+    audio_player_get_status(&status);
+    if (status.source != AUDIO_SOURCE_SDCARD || !path_matches(status.current_url, path)) {
+        return false;
     }
+    *position_ms = audio_player_get_position_ms();
+    return true;
+}
 
-    playlist = new_playlist;
-    playlist_capacity = new_capacity;
-    return ESP_OK;
+// Zapamiętuje pozycję opuszczanego pliku (zmiana utworu, stop). Tuż przed końcem - od początku.
+static void bookmark_leave(void) {
+    xSemaphoreTake(bookmark_lock, portMAX_DELAY);
+    uint32_t position;
+    if (bookmark_path[0] && bookmark_position(bookmark_path, &position)) {
+        if (bookmark_duration_ms && position + SD_BOOKMARK_END_MS >= bookmark_duration_ms) {
+            position = 0;
+        }
+        sd_bookmark_set(&bookmarks, bookmark_path, position);
+    }
+    bookmark_path[0] = '\0';
+    xSemaphoreGive(bookmark_lock);
+    bookmark_flush_async();
+}
+
+// Plik odegrany do końca - następne odtworzenie od początku
+static void bookmark_finish(void) {
+    xSemaphoreTake(bookmark_lock, portMAX_DELAY);
+    if (bookmark_path[0]) {
+        sd_bookmark_set(&bookmarks, bookmark_path, 0);
+        bookmark_path[0] = '\0';
+    }
+    xSemaphoreGive(bookmark_lock);
+    bookmark_flush_async();
+}
+
+// Nowy bieżący plik: długi dostaje zakładkę. Zwraca pozycję wznowienia (0 - od początku).
+static uint32_t bookmark_enter(const char *filepath) {
+    char rel_path[256];
+    char full_path[300];
+    card_relative_path(filepath, rel_path, sizeof(rel_path));
+    card_full_path(filepath, full_path, sizeof(full_path));
+
+    // Długość z indeksu, bez niego - plik duży jak kilkadziesiąt minut audio
+    uint32_t duration = player_status.current_file.duration_ms;
+    bool is_long = duration >= SD_BOOKMARK_MIN_LENGTH_MS;
+    struct stat st;
+    if (duration == 0 && stat(full_path, &st) == 0) {
+        is_long = st.st_size >= SD_BOOKMARK_MIN_FILE_SIZE;
+    }
+
+    uint32_t resume = 0;
+    xSemaphoreTake(bookmark_lock, portMAX_DELAY);
+    if (!bookmarks_loaded && card_mounted) {
+        sd_bookmark_load(&bookmarks, SD_BOOKMARK_JOURNAL);
+        bookmarks_loaded = true;
+        ESP_LOGI(TAG, "Bookmarks: %lu loaded", (unsigned long)bookmarks.count);
+    }
+    bookmark_path[0] = '\0';
+    if (is_long && bookmarks_loaded) {
+        strcpy(bookmark_path, rel_path);
+        bookmark_duration_ms = duration;
+        if (sd_bookmark_get(&bookmarks, rel_path, &resume)) {
+            resume = resume > SD_BOOKMARK_REWIND_MS ? resume - SD_BOOKMARK_REWIND_MS : 0;
+        }
+    }
+    xSemaphoreGive(bookmark_lock);
+    return resume;
+}
+
+static bool bookmark_has(const char *filepath) {
+    char rel_path[256];
+    uint32_t position;
+    card_relative_path(filepath, rel_path, sizeof(rel_path));
+
+    xSemaphoreTake(bookmark_lock, portMAX_DELAY);
+    bool has = bookmarks_loaded && sd_bookmark_get(&bookmarks, rel_path, &position);
+    xSemaphoreGive(bookmark_lock);
+    return has;
+}
+
+// Pozycja odtwarzacza co SD_POSITION_POLL_MS; zakładka na kartę najwyżej co
+// SD_BOOKMARK_SAVE_MS, od razu po pauzie, stopie i zmianie pliku
+static void bookmark_task(void *pvParameters) {
+    while (1) {
+        bool now_requested = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(SD_POSITION_POLL_MS)) > 0;
+        uint32_t position;
+
+        if (player_status.state == SD_STATE_PLAYING &&
+            bookmark_position(player_status.current_file.filepath, &position)) {
+            player_status.position_ms = position;
+        }
+
+        xSemaphoreTake(bookmark_lock, portMAX_DELAY);
+        if (bookmark_path[0] && player_status.state == SD_STATE_PLAYING &&
+            bookmark_position(bookmark_path, &position) && position > 0) {
+            sd_bookmark_set(&bookmarks, bookmark_path, position);
+        }
+        uint32_t now = bookmark_now_ms();
+        if (bookmarks_loaded && sd_bookmark_dirty(&bookmarks) &&
+            (now_requested || now - bookmark_flushed_ms >= SD_BOOKMARK_SAVE_MS)) {
+            if (!sd_bookmark_flush(&bookmarks)) {
+                ESP_LOGW(TAG, "Bookmark journal write failed");
+            }
+            bookmark_flushed_ms = now;
+        }
+        xSemaphoreGive(bookmark_lock);
+    }
 }
 
+// ============================================
+// Playlist management
+// ============================================
+
 static void shuffle_playlist(void) {
-    if (playlist_count < 2) return;
+    sd_playlist_shuffle(&playlist, -1, esp_random);
+}
+
+// Start playlisty od pierwszego wpisu (po ewentualnym przetasowaniu)
+static esp_err_t playlist_start(void) {
+    if (playlist.count == 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    if (player_status.play_mode == SD_PLAY_MODE_SHUFFLE) {
+        shuffle_playlist();
+    }
+
+    sd_playlist_compact(&playlist);
+    player_status.playlist_total = playlist.count;
+    ESP_LOGI(TAG, "Playlist: %lu tracks, %u KB", (unsigned long)playlist.count,
+             (unsigned)(sd_playlist_memory(&playlist) / 1024));
+    return sdcard_player_play_index(0);
+}
+
+// Koniec pliku zgłoszony przez audio_player (z jego taska sterującego)
+static void track_end_handler(const char *path) {
+    const char *current = player_status.current_file.filepath;
+
+    // Plik spoza odtwarzacza SD (np. dźwięk alarmu) albo już inny utwór
+    if (player_status.state != SD_STATE_PLAYING || !path_matches(path, current)) {
+        return;
+    }
+    bookmark_finish();
+
+    if (player_status.play_mode == SD_PLAY_MODE_REPEAT_ONE) {
+        char filepath[sizeof(player_status.current_file.filepath)];
+        strcpy(filepath, current);  // play_file czyści current_file
+        sdcard_player_play_file(filepath);
+    } else if (playlist.count > 0) {
+        sdcard_player_next();
+    } else {
+        player_status.state = SD_STATE_STOPPED;
+        player_status.position_ms = 0;
+        notify_state_change();
+    }
+}
+
+// Następny utwór według trybu (kolejność playlisty już przetasowana) - audio_player
+// otwiera go w tle i gra od razu po bieżącym. Koniec playlisty - brak następnego.
+static void prime_next_track(void) {
+    char path[sizeof(primed_path)] = "";
+    int index = -1;
+
+    if (player_status.play_mode == SD_PLAY_MODE_REPEAT_ONE) {
+        strncpy(path, player_status.current_file.filepath, sizeof(path) - 1);
+        index = player_status.playlist_index;
+    } else if (playlist.count > 0) {
+        index = player_status.playlist_index + 1;
+        if (index >= (int)playlist.count) {
+            index = player_status.play_mode == SD_PLAY_MODE_REPEAT_ALL ? 0 : -1;
+        }
+        if (index < 0 || sd_playlist_get_path(&playlist, index, path, sizeof(path)) == 0) {
+            path[0] = '\0';
+        }
+        // Plik z zakładką startuje od niej - przez zwykły koniec utworu, bez przejścia gapless
+        if (path[0] && bookmark_has(path)) {
+            path[0] = '\0';
+        }
+    }
+
+    if (path[0] == '\0') {
+        primed_path[0] = '\0';
+        primed_index = -1;
+        audio_player_queue_next_sdcard(NULL);
+        return;
+    }
+    strcpy(primed_path, path);
+    primed_index = index;
+
+    char full_path[300];
+    card_full_path(path, full_path, sizeof(full_path));
+    audio_player_queue_next_sdcard(full_path);
+}
+
+static void set_current_file(const char *filepath) {
+    memset(&player_status.current_file, 0, sizeof(sd_file_info_t));
+    strncpy(player_status.current_file.filepath, filepath,
+            sizeof(player_status.current_file.filepath) - 1);
+
+    // Extract filename
+    const char *filename = strrchr(filepath, '/');
+    filename = filename ? filename + 1 : filepath;
+    strncpy(player_status.current_file.filename, filename,
+            sizeof(player_status.current_file.filename) - 1);
+
+    // Extract title
+    strncpy(player_status.current_file.title, filename,
+            sizeof(player_status.current_file.title) - 1);
+    char *dot = strrchr(player_status.current_file.title, '.');
+    if (dot) *dot = '\0';
+
+#if MEDIA_INDEX_ENABLED
+    // Tagi z indeksu (ścieżka w current_file zostaje taka, jaką podał wołający)
+    sd_file_info_t info;
+    if (media_index_lookup(filepath, &info)) {
+        strcpy(player_status.current_file.title, info.title);
+        strcpy(player_status.current_file.artist, info.artist);
+        strcpy(player_status.current_file.album, info.album);
+        player_status.current_file.duration_ms = info.duration_ms;
+        player_status.current_file.file_size = info.file_size;
+    }
+#endif
+}
 
-    for (int i = playlist_count - 1; i > 0; i--) {
-        int j = esp_random() % (i + 1);
-        sd_file_info_t temp = playlist[i];
-        playlist[i] = playlist[j];
-        playlist[j] = temp;
+// audio_player przeszedł bez przerwy na przygotowany plik (z jego taska sterującego)
+static void track_next_handler(const char *path) {
+    if (player_status.state != SD_STATE_PLAYING && player_status.state != SD_STATE_PAUSED) {
+        return;
+    }
+
+    bookmark_finish();
+    if (path_matches(path, primed_path)) {
+        if (primed_index >= 0) {
+            player_status.playlist_index = primed_index;
+        }
+        char filepath[sizeof(primed_path)];
+        strcpy(filepath, primed_path);
+        set_current_file(filepath);
+    } else {
+        // Następny zmieniony już po starcie dekodowania - indeks playlisty bez zmian
+        char rel_path[256];
+        card_relative_path(path, rel_path, sizeof(rel_path));
+        set_current_file(rel_path);
     }
+    bookmark_enter(player_status.current_file.filepath);  // Plik z zakładką nie jest przygotowywany
+    ESP_LOGI(TAG, "Gapless: %s", player_status.current_file.filepath);
+
+    player_status.position_ms = 0;
+    notify_state_change();
+    notify_track_change();
+    prime_next_track();
 }
 
 // ============================================
@@ -169,6 +457,11 @@ esp_err_t sdcard_player_init(void) {
     memset(&player_status, 0, sizeof(player_status));
     player_status.state = SD_STATE_IDLE;
     player_status.play_mode = SD_PLAY_MODE_NORMAL;
+    audio_player_register_track_end_callback(track_end_handler);
+    audio_player_register_track_next_callback(track_next_handler);
+
+    bookmark_lock = xSemaphoreCreateMutex();
+    xTaskCreate(bookmark_task, "sd_bookmark", 3072, NULL, 2, &bookmark_task_handle);
 
     esp_err_t ret = mount_sdcard();
     if (ret != ESP_OK) {
@@ -183,6 +476,7 @@ esp_err_t sdcard_player_init(void) {
 esp_err_t sdcard_player_deinit(void) {
     sdcard_player_stop();
     sdcard_player_clear_playlist();
+    sd_playlist_free(&playlist);
     unmount_sdcard();
     return ESP_OK;
 }
@@ -202,6 +496,13 @@ esp_err_t sdcard_player_scan_directory(const char *path, sd_file_info_t **files,
         if (ret != ESP_OK) return ret;
     }
 
+#if MEDIA_INDEX_ENABLED
+    // Z indeksu: bez readdir/stat i z tagami zamiast nazw plików
+    if (media_index_list_dir(path, files, count) == ESP_OK) {
+        return ESP_OK;
+    }
+#endif
+
     char full_path[300];
     if (path[0] != '/') {
         snprintf(full_path, sizeof(full_path), "%s/%s", SD_MOUNT_POINT, path);
@@ -274,6 +575,159 @@ esp_err_t sdcard_player_scan_directory(const char *path, sd_file_info_t **files,
 }
 #pragma GCC diagnostic pop
 
+// ============================================
+// Paged directory browsing
+// ============================================
+// Bez indeksu biblioteki: jeden przebieg readdir (tylko d_type, bez stat) do migawki
+// katalogu - nazwy w jednym buforze i posortowana tablica offsetów. Kolejne strony
+// (kursor z numerem migawki) czytają migawkę, bufory zostają dla następnego katalogu.
+
+#define BROWSE_OFFSET_BITS  20
+#define BROWSE_OFFSET_MASK  ((1u << BROWSE_OFFSET_BITS) - 1)
+#define BROWSE_MAX_ENTRIES  BROWSE_OFFSET_MASK
+
+typedef struct {
+    char path[256];             // Względem karty
+    uint32_t id;                // Numer migawki w kursorze (0 - brak)
+    char *names;                // [1 - katalog, 0 - plik][nazwa\0] ...
+    uint32_t names_size;
+    uint32_t names_capacity;
+    uint32_t *keys;             // Offsety w names: katalogi, potem pliki, alfabetycznie
+    uint32_t count;
+    uint32_t keys_capacity;
+} browse_snapshot_t;
+
+static browse_snapshot_t browse = {0};  // Tylko task serwera HTTP
+
+static bool browse_grow(void **ptr, uint32_t *capacity, uint32_t needed, size_t elem) {
+    if (needed <= *capacity) return true;
+    uint32_t new_capacity = *capacity ? *capacity * 2 : 256;
+    while (new_capacity < needed) new_capacity *= 2;
+    void *p = realloc(*ptr, (size_t)new_capacity * elem);
+    if (p == NULL) return false;
+    *ptr = p;
+    *capacity = new_capacity;
+    return true;
+}
+
+static int browse_key_cmp(const void *a, const void *b) {
+    const char *ka = browse.names + *(const uint32_t *)a;
+    const char *kb = browse.names + *(const uint32_t *)b;
+    if (ka[0] != kb[0]) return kb[0] - ka[0];  // Katalogi przed plikami
+    return strcasecmp(ka + 1, kb + 1);
+}
+
+static esp_err_t browse_snapshot(const char *rel_path) {
+    char full_path[300];
+    snprintf(full_path, sizeof(full_path), "%s%s", SD_MOUNT_POINT, strcmp(rel_path, "/") ? rel_path : "");
+
+    DIR *dir = opendir(full_path);
+    if (dir == NULL) {
+        ESP_LOGE(TAG, "Failed to open directory: %s", full_path);
+        return ESP_FAIL;
+    }
+
+    browse.id = 0;
+    browse.count = 0;
+    browse.names_size = 0;
+    esp_err_t ret = ESP_OK;
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL && browse.count < BROWSE_MAX_ENTRIES) {
+        if (entry->d_name[0] == '.') continue;
+        bool is_dir = (entry->d_type == DT_DIR);
+        if (!is_dir && !is_audio_file(entry->d_name)) continue;
+
+        size_t len = strlen(entry->d_name) + 1;
+        if (!browse_grow((void **)&browse.names, &browse.names_capacity, browse.names_size + 1 + len, 1) ||
+            !browse_grow((void **)&browse.keys, &browse.keys_capacity, browse.count + 1, sizeof(uint32_t))) {
+            ret = ESP_ERR_NO_MEM;
+            break;
+        }
+        browse.keys[browse.count++] = browse.names_size;
+        browse.names[browse.names_size] = is_dir;
+        memcpy(browse.names + browse.names_size + 1, entry->d_name, len);
+        browse.names_size += 1 + len;
+    }
+    closedir(dir);
+    if (ret != ESP_OK) {
+        browse.count = 0;
+        return ret;
+    }
+
+    qsort(browse.keys, browse.count, sizeof(uint32_t), browse_key_cmp);
+
+    static uint32_t next_id = 0;
+    next_id = (next_id % ((1u << (32 - BROWSE_OFFSET_BITS)) - 1)) + 1;
+    browse.id = next_id;
+    strncpy(browse.path, rel_path, sizeof(browse.path) - 1);
+    browse.path[sizeof(browse.path) - 1] = '\0';
+    return ESP_OK;
+}
+
+esp_err_t sdcard_player_browse(const char *path, uint32_t *cursor, int limit, bool with_sizes,
+                               sd_browse_cb_t callback, void *ctx, int *total) {
+    if (!card_mounted) {
+        esp_err_t ret = mount_sdcard();
+        if (ret != ESP_OK) return ret;
+    }
+    if (limit <= 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    char rel_path[256];
+    size_t rel_len = card_relative_path(path, rel_path, sizeof(rel_path));
+    uint32_t offset = *cursor & BROWSE_OFFSET_MASK;
+    uint32_t id = *cursor >> BROWSE_OFFSET_BITS;
+
+#if MEDIA_INDEX_ENABLED
+    // Katalog w indeksie - strona prosto z indeksu (rozmiary i tagi bez dostępu do karty)
+    int indexed = media_index_list_dir_page(rel_path, offset, limit, callback, ctx);
+    if (indexed >= 0) {
+        *total = indexed;
+        *cursor = (offset + limit < (uint32_t)indexed) ? offset + limit : 0;
+        return ESP_OK;
+    }
+#endif
+
+    // Pierwsza strona (lub migawka innego katalogu) - nowy odczyt katalogu
+    if (id == 0 || id != browse.id || strcmp(browse.path, rel_path) != 0) {
+        esp_err_t ret = browse_snapshot(rel_path);
+        if (ret != ESP_OK) return ret;
+    }
+
+    static sd_file_info_t info;  // Tylko task serwera HTTP
+    uint32_t end = offset + limit < browse.count ? offset + limit : browse.count;
+    for (uint32_t i = offset; i < end; i++) {
+        const char *key = browse.names + browse.keys[i];
+        const char *name = key + 1;
+
+        memset(&info, 0, sizeof(info));
+        strncpy(info.filename, name, sizeof(info.filename) - 1);
+        snprintf(info.filepath, sizeof(info.filepath), "%s/%s", rel_len > 1 ? rel_path : "", name);
+        info.is_directory = key[0];
+        if (!info.is_directory) {
+            strncpy(info.title, name, sizeof(info.title) - 1);
+            char *dot = strrchr(info.title, '.');
+            if (dot) *dot = '\0';
+
+            if (with_sizes) {
+                char stat_path[300];
+                struct stat st;
+                snprintf(stat_path, sizeof(stat_path), "%s%s", SD_MOUNT_POINT, info.filepath);
+                if (stat(stat_path, &st) == 0) {
+                    info.file_size = st.st_size;
+                }
+            }
+        }
+        if (!callback(&info, ctx)) break;
+    }
+
+    *total = browse.count;
+    *cursor = end < browse.count ? (browse.id << BROWSE_OFFSET_BITS) | end : 0;
+    return ESP_OK;
+}
+
 esp_err_t sdcard_player_free_file_list(sd_file_info_t *files, int count) {
     if (files) {
         free(files);
@@ -308,40 +762,28 @@ esp_err_t sdcard_player_play_file(const char *filepath) {
     }
 
     char full_path[300];
-    if (strncmp(filepath, SD_MOUNT_POINT, strlen(SD_MOUNT_POINT)) == 0) {
-        strncpy(full_path, filepath, sizeof(full_path) - 1);
-    } else if (filepath[0] == '/') {
-        snprintf(full_path, sizeof(full_path), "%s%s", SD_MOUNT_POINT, filepath);
-    } else {
-        snprintf(full_path, sizeof(full_path), "%s/%s", SD_MOUNT_POINT, filepath);
-    }
+    card_full_path(filepath, full_path, sizeof(full_path));
 
     ESP_LOGI(TAG, "Playing file: %s", full_path);
 
-    // Update current file info
-    memset(&player_status.current_file, 0, sizeof(sd_file_info_t));
-    strncpy(player_status.current_file.filepath, filepath,
-            sizeof(player_status.current_file.filepath) - 1);
+    // Pozycja poprzedniego pliku, zanim audio_player przejdzie na nowy
+    bookmark_leave();
 
-    // Extract filename
-    const char *filename = strrchr(filepath, '/');
-    filename = filename ? filename + 1 : filepath;
-    strncpy(player_status.current_file.filename, filename,
-            sizeof(player_status.current_file.filename) - 1);
-
-    // Extract title
-    strncpy(player_status.current_file.title, filename,
-            sizeof(player_status.current_file.title) - 1);
-    char *dot = strrchr(player_status.current_file.title, '.');
-    if (dot) *dot = '\0';
+    // Update current file info
+    set_current_file(filepath);
+    uint32_t resume_ms = bookmark_enter(filepath);
+    if (resume_ms > 0) {
+        ESP_LOGI(TAG, "Resuming at %lu ms", (unsigned long)resume_ms);
+    }
 
     // Use audio_player to play
-    esp_err_t ret = audio_player_play_sdcard(full_path);
+    esp_err_t ret = audio_player_play_sdcard_from(full_path, resume_ms);
     if (ret == ESP_OK) {
         player_status.state = SD_STATE_PLAYING;
-        player_status.position_ms = 0;
+        player_status.position_ms = resume_ms;
         notify_state_change();
         notify_track_change();
+        prime_next_track();
     } else {
         player_status.state = SD_STATE_ERROR;
         notify_state_change();
@@ -350,49 +792,91 @@ esp_err_t sdcard_player_play_file(const char *filepath) {
     return ret;
 }
 
+// Pliki katalogu wprost do playlisty: jeden przebieg readdir, bez stat i bez
+// tymczasowej listy sd_file_info_t (przy tysiącach plików - megabajty)
 esp_err_t sdcard_player_play_directory(const char *dirpath) {
-    sdcard_player_clear_playlist();
+    if (!card_mounted) {
+        esp_err_t ret = mount_sdcard();
+        if (ret != ESP_OK) return ret;
+    }
 
-    sd_file_info_t *files;
-    int count;
-    esp_err_t ret = sdcard_player_scan_directory(dirpath, &files, &count);
-    if (ret != ESP_OK) return ret;
+    char full_path[300];
+    char rel_path[256];
+    size_t rel_len = card_relative_path(dirpath, rel_path, sizeof(rel_path));
+    snprintf(full_path, sizeof(full_path), "%s%s", SD_MOUNT_POINT, rel_path);
 
-    // Add audio files to playlist
-    for (int i = 0; i < count; i++) {
-        if (!files[i].is_directory) {
-            sdcard_player_add_to_playlist(files[i].filepath);
-        }
+    DIR *dir = opendir(full_path);
+    if (dir == NULL) {
+        ESP_LOGE(TAG, "Failed to open directory: %s", full_path);
+        return ESP_FAIL;
     }
 
-    sdcard_player_free_file_list(files, count);
+    sdcard_player_clear_playlist();
 
-    if (playlist_count == 0) {
-        return ESP_ERR_NOT_FOUND;
+    char path[384];
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.' || entry->d_type == DT_DIR || !is_audio_file(entry->d_name)) {
+            continue;
+        }
+        snprintf(path, sizeof(path), "%s/%s", rel_len > 1 ? rel_path : "", entry->d_name);
+        if (sdcard_player_add_to_playlist(path) != ESP_OK) {
+            break;  // Limit playlisty
+        }
     }
+    closedir(dir);
 
-    // Shuffle if needed
-    if (player_status.play_mode == SD_PLAY_MODE_SHUFFLE) {
-        shuffle_playlist();
-    }
+    sd_playlist_sort_tail(&playlist, 0);  // Kolejność jak w indeksie i przeglądarce
+    return playlist_start();
+}
 
-    // Start playing first track
-    player_status.playlist_index = 0;
-    player_status.playlist_total = playlist_count;
+// Playlista z utworów o danym wykonawcy/albumie (z indeksu, bez skanowania karty)
+static esp_err_t play_from_index(media_field_t field, const char *value) {
+#if MEDIA_INDEX_ENABLED
+    // Stronami - wyniki zapytania to pełne sd_file_info_t
+    const int page = 64;
+    int offset = 0, total = 0;
+
+    sdcard_player_clear_playlist();
+    do {
+        sd_file_info_t *files;
+        int count;
+        esp_err_t ret = media_index_find(field, value, true, offset, page, &files, &count, &total);
+        if (ret != ESP_OK) return ret;
 
-    return sdcard_player_play_file(playlist[0].filepath);
+        for (int i = 0; i < count; i++) {
+            sdcard_player_add_to_playlist(files[i].filepath);
+        }
+        sdcard_player_free_file_list(files, count);
+        offset += page;
+    } while (offset < total && offset < MAX_PLAYLIST_SIZE);
+
+    return playlist_start();
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t sdcard_player_play_artist(const char *artist) {
+    return play_from_index(MEDIA_FIELD_ARTIST, artist);
+}
+
+esp_err_t sdcard_player_play_album(const char *album) {
+    return play_from_index(MEDIA_FIELD_ALBUM, album);
 }
 
 esp_err_t sdcard_player_play_index(int index) {
-    if (index < 0 || index >= playlist_count) {
+    char path[sizeof(player_status.current_file.filepath)];
+    if (index < 0 || sd_playlist_get_path(&playlist, index, path, sizeof(path)) == 0) {
         return ESP_ERR_INVALID_ARG;
     }
 
     player_status.playlist_index = index;
-    return sdcard_player_play_file(playlist[index].filepath);
+    return sdcard_player_play_file(path);
 }
 
 esp_err_t sdcard_player_stop(void) {
+    bookmark_leave();
     audio_player_stop();
     player_status.state = SD_STATE_STOPPED;
     player_status.position_ms = 0;
@@ -407,6 +891,7 @@ esp_err_t sdcard_player_pause(void) {
 
     audio_player_pause();
     player_status.state = SD_STATE_PAUSED;
+    bookmark_flush_async();
     notify_state_change();
     return ESP_OK;
 }
@@ -423,13 +908,13 @@ esp_err_t sdcard_player_resume(void) {
 }
 
 esp_err_t sdcard_player_next(void) {
-    if (playlist_count == 0) {
+    if (playlist.count == 0) {
         return ESP_ERR_INVALID_STATE;
     }
 
     int next_index = player_status.playlist_index + 1;
 
-    if (next_index >= playlist_count) {
+    if (next_index >= (int)playlist.count) {
         if (player_status.play_mode == SD_PLAY_MODE_REPEAT_ALL) {
             next_index = 0;
             if (player_status.play_mode == SD_PLAY_MODE_SHUFFLE) {
@@ -446,19 +931,20 @@ esp_err_t sdcard_player_next(void) {
 }
 
 esp_err_t sdcard_player_prev(void) {
-    if (playlist_count == 0) {
+    if (playlist.count == 0) {
         return ESP_ERR_INVALID_STATE;
     }
 
     // If more than 3 seconds into track, restart current track
     if (player_status.position_ms > 3000) {
+        bookmark_finish();  // Od początku, nie od zakładki
         return sdcard_player_play_index(player_status.playlist_index);
     }
 
     int prev_index = player_status.playlist_index - 1;
     if (prev_index < 0) {
         if (player_status.play_mode == SD_PLAY_MODE_REPEAT_ALL) {
-            prev_index = playlist_count - 1;
+            prev_index = playlist.count - 1;
         } else {
             prev_index = 0;
         }
@@ -468,32 +954,31 @@ esp_err_t sdcard_player_prev(void) {
 }
 
 esp_err_t sdcard_player_seek(uint32_t position_ms) {
-    // Seeking would require ESP-ADF pipeline manipulation
-    // For now, just update position for UI
-    player_status.position_ms = position_ms;
-    return ESP_OK;
+    if (player_status.state != SD_STATE_PLAYING && player_status.state != SD_STATE_PAUSED) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    // Pozycja w pliku z seek_index, tor SD startuje od nowego offsetu
+    esp_err_t ret = audio_player_seek_sdcard(position_ms);
+    if (ret == ESP_OK) {
+        player_status.position_ms = position_ms;
+    }
+    return ret;
 }
 
 esp_err_t sdcard_player_set_play_mode(sd_play_mode_t mode) {
     player_status.play_mode = mode;
     ESP_LOGI(TAG, "Play mode set to: %d", mode);
 
-    if (mode == SD_PLAY_MODE_SHUFFLE && playlist_count > 1) {
-        // Save current track
-        sd_file_info_t current = playlist[player_status.playlist_index];
-        shuffle_playlist();
-        // Move current track to front
-        for (int i = 0; i < playlist_count; i++) {
-            if (strcmp(playlist[i].filepath, current.filepath) == 0) {
-                sd_file_info_t temp = playlist[0];
-                playlist[0] = playlist[i];
-                playlist[i] = temp;
-                break;
-            }
-        }
+    if (mode == SD_PLAY_MODE_SHUFFLE && playlist.count > 1) {
+        // Current track moves to front
+        sd_playlist_shuffle(&playlist, player_status.playlist_index, esp_random);
         player_status.playlist_index = 0;
     }
 
+    // Następny utwór zależy od trybu
+    if (player_status.state == SD_STATE_PLAYING || player_status.state == SD_STATE_PAUSED) {
+        prime_next_track();
+    }
     return ESP_OK;
 }
 
@@ -502,49 +987,55 @@ sd_play_mode_t sdcard_player_get_play_mode(void) {
 }
 
 esp_err_t sdcard_player_add_to_playlist(const char *filepath) {
-    if (playlist_count >= MAX_PLAYLIST_SIZE) {
+    if (!sd_playlist_add(&playlist, filepath)) {
         return ESP_ERR_NO_MEM;
     }
-
-    esp_err_t ret = playlist_ensure_capacity(playlist_count + 1);
-    if (ret != ESP_OK) return ret;
-
-    sd_file_info_t *file = &playlist[playlist_count];
-    memset(file, 0, sizeof(sd_file_info_t));
-
-    strncpy(file->filepath, filepath, sizeof(file->filepath) - 1);
-
-    const char *filename = strrchr(filepath, '/');
-    filename = filename ? filename + 1 : filepath;
-    strncpy(file->filename, filename, sizeof(file->filename) - 1);
-
-    strncpy(file->title, filename, sizeof(file->title) - 1);
-    char *dot = strrchr(file->title, '.');
-    if (dot) *dot = '\0';
-
-    playlist_count++;
-    player_status.playlist_total = playlist_count;
-
+    player_status.playlist_total = playlist.count;
     return ESP_OK;
 }
 
 esp_err_t sdcard_player_clear_playlist(void) {
-    if (playlist) {
-        free(playlist);
-        playlist = NULL;
-    }
-    playlist_count = 0;
-    playlist_capacity = 0;
+    sd_playlist_clear(&playlist);  // Bufory zostają dla następnej playlisty
     player_status.playlist_index = 0;
     player_status.playlist_total = 0;
+    if (primed_path[0]) {
+        prime_next_track();  // Przygotowany wpis nie należy już do playlisty
+    }
     return ESP_OK;
 }
 
 int sdcard_player_get_playlist_count(void) {
-    return playlist_count;
+    return playlist.count;
+}
+
+// Metadane wpisu na żądanie: z indeksu biblioteki, bez niego - z nazwy pliku
+esp_err_t sdcard_player_get_playlist_entry(int index, sd_file_info_t *info) {
+    char path[sizeof(info->filepath)];
+    if (index < 0 || sd_playlist_get_path(&playlist, index, path, sizeof(path)) == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+#if MEDIA_INDEX_ENABLED
+    if (media_index_lookup(path, info)) {
+        strcpy(info->filepath, path);  // Ścieżka w postaci z playlisty
+        return ESP_OK;
+    }
+#endif
+
+    memset(info, 0, sizeof(*info));
+    strcpy(info->filepath, path);
+    const char *filename = strrchr(path, '/') + 1;
+    strncpy(info->filename, filename, sizeof(info->filename) - 1);
+    strncpy(info->title, filename, sizeof(info->title) - 1);
+    char *dot = strrchr(info->title, '.');
+    if (dot) *dot = '\0';
+    return ESP_OK;
 }
 
 sd_player_status_t *sdcard_player_get_status(void) {
+    if (player_status.state == SD_STATE_PLAYING || player_status.state == SD_STATE_PAUSED) {
+        player_status.position_ms = audio_player_get_position_ms();
+    }
     return &player_status;
 }
 
@@ -75,6 +75,14 @@ bool sdcard_player_is_card_inserted(void);
 // ============================================
 esp_err_t sdcard_player_scan_directory(const char *path, sd_file_info_t **files, int *count);
 esp_err_t sdcard_player_free_file_list(sd_file_info_t *files, int count);
+
+// Stronicowane przeglądanie katalogu (podkatalogi, potem pliki; alfabetycznie).
+// *cursor: 0 - pierwsza strona, po wywołaniu - kursor następnej strony lub 0 na końcu.
+// callback dla każdego wpisu strony (false - przerwij); wpis ważny tylko w wywołaniu.
+// Rozmiary plików tylko z with_sizes (stat na wpis) albo z indeksu biblioteki.
+typedef bool (*sd_browse_cb_t)(const sd_file_info_t *entry, void *ctx);
+esp_err_t sdcard_player_browse(const char *path, uint32_t *cursor, int limit, bool with_sizes,
+                               sd_browse_cb_t callback, void *ctx, int *total);
 esp_err_t sdcard_player_get_card_info(uint64_t *total_bytes, uint64_t *free_bytes);
 
 // ============================================
@@ -83,6 +91,8 @@ esp_err_t sdcard_player_get_card_info(uint64_t *total_bytes, uint64_t *free_byte
 esp_err_t sdcard_player_play_file(const char *filepath);
 esp_err_t sdcard_player_play_directory(const char *dirpath);
 esp_err_t sdcard_player_play_index(int index);  // Play from playlist
+esp_err_t sdcard_player_play_artist(const char *artist);  // Playlista z indeksu biblioteki
+esp_err_t sdcard_player_play_album(const char *album);    // W kolejności numerów utworów
 esp_err_t sdcard_player_stop(void);
 esp_err_t sdcard_player_pause(void);
 esp_err_t sdcard_player_resume(void);
@@ -98,6 +108,7 @@ sd_play_mode_t sdcard_player_get_play_mode(void);
 esp_err_t sdcard_player_add_to_playlist(const char *filepath);
 esp_err_t sdcard_player_clear_playlist(void);
 int sdcard_player_get_playlist_count(void);
+esp_err_t sdcard_player_get_playlist_entry(int index, sd_file_info_t *info);  // Tagi na żądanie
 
 // ============================================
 // Status
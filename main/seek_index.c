@@ -0,0 +1,1137 @@
+/*
+ * Seek Index Module
+ * Pozycjonowanie MP3 / FLAC / WAV do próbki, granice utworu z LAME / iTunSMPB
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include "seek_index.h"
+
+#define READ_BUFFER_SIZE    4096        // Bufor wyszukiwania ramek przy przewijaniu
+#define BUILD_BUFFER_SIZE   16384       // Bufor przejścia po całym pliku MP3
+#define MP3_SYNC_LIMIT      16384       // Najdalej szukana synchronizacja ramki MP3
+#define MP3_CBR_CHECK       64          // Ramki sprawdzane, czy bitrate jest stały
+#define FLAC_SYNC_LIMIT     65536       // Najdłuższa ramka FLAC, jaką przeskakujemy szukając
+#define FLAC_MAX_STEPS      12          // Kroki bisekcji między punktami SEEKTABLE
+#define FLAC_MAX_WALK       64          // Ramki przechodzone po kolei na końcu wyszukiwania
+#define FLAC_HEADER_MAX     16          // Najdłuższy nagłówek ramki FLAC z CRC-8
+#define TABLE_MAGIC         0x31494b53  // "SKI1"
+#define MP3_DECODER_DELAY   529         // Opóźnienie syntezy dekodera MP3 (próbki)
+
+// ============================================
+// Pomocnicze
+// ============================================
+
+static uint32_t be16(const uint8_t *p) { return (p[0] << 8) | p[1]; }
+static uint32_t be24(const uint8_t *p) { return (p[0] << 16) | (p[1] << 8) | p[2]; }
+static uint32_t be32(const uint8_t *p) { return ((uint32_t)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3]; }
+static uint64_t be64(const uint8_t *p) { return ((uint64_t)be32(p) << 32) | be32(p + 4); }
+static uint32_t le16(const uint8_t *p) { return (p[1] << 8) | p[0]; }
+static uint32_t le32(const uint8_t *p) { return ((uint32_t)p[3] << 24) | (p[2] << 16) | (p[1] << 8) | p[0]; }
+
+static void put_le16(uint8_t *p, uint32_t v) { p[0] = v; p[1] = v >> 8; }
+static void put_le32(uint8_t *p, uint32_t v) { p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24; }
+
+static uint32_t file_size(FILE *f)
+{
+    if (fseek(f, 0, SEEK_END) != 0) return 0;
+    long size = ftell(f);
+    return size > 0 ? (uint32_t)size : 0;
+}
+
+static bool read_at(FILE *f, uint32_t pos, void *buf, size_t len)
+{
+    return fseek(f, pos, SEEK_SET) == 0 && fread(buf, 1, len, f) == len;
+}
+
+// Okno pliku w buforze - wyszukiwanie ramek bajt po bajcie bez fseek na każdy bajt
+typedef struct {
+    FILE *f;
+    uint8_t *buf;
+    uint32_t size;
+    uint32_t start;
+    uint32_t len;
+} reader_t;
+
+static bool reader_init(reader_t *r, FILE *f, uint32_t size)
+{
+    r->f = f;
+    r->buf = malloc(size);
+    r->size = size;
+    r->start = 0;
+    r->len = 0;
+    return r->buf != NULL;
+}
+
+static void reader_free(reader_t *r)
+{
+    free(r->buf);
+    r->buf = NULL;
+}
+
+// n bajtów od pos (n <= size) lub NULL za końcem pliku
+static const uint8_t *reader_peek(reader_t *r, uint32_t pos, uint32_t n)
+{
+    if (pos < r->start || pos + n > r->start + r->len) {
+        if (fseek(r->f, pos, SEEK_SET) != 0) return NULL;
+        r->start = pos;
+        r->len = fread(r->buf, 1, r->size, r->f);
+        if (n > r->len) return NULL;
+    }
+    return r->buf + (pos - r->start);
+}
+
+static uint32_t id3v2_end(FILE *f)
+{
+    uint8_t hdr[10];
+    if (!read_at(f, 0, hdr, sizeof(hdr)) || memcmp(hdr, "ID3", 3) != 0) {
+        return 0;
+    }
+    uint32_t size = ((hdr[6] & 0x7f) << 21) | ((hdr[7] & 0x7f) << 14) |
+                    ((hdr[8] & 0x7f) << 7) | (hdr[9] & 0x7f);
+    return 10 + size + ((hdr[5] & 0x10) ? 10 : 0);
+}
+
+// ============================================
+// MP3
+// ============================================
+
+static const uint16_t mp3_bitrate[2][3][15] = {
+    {   // MPEG1: Layer I, II, III
+        {0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448},
+        {0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384},
+        {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320},
+    },
+    {   // MPEG2 / 2.5
+        {0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256},
+        {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160},
+        {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160},
+    },
+};
+static const uint32_t mp3_samplerate[3] = {44100, 48000, 32000};
+
+typedef struct {
+    uint32_t frame_len;
+    uint32_t sample_rate;
+    uint32_t samples;       // Próbki na ramkę
+    uint32_t bitrate_kbps;
+    bool mpeg1;
+    bool mono;
+} mp3_header_t;
+
+static bool mp3_parse(const uint8_t *p, mp3_header_t *h)
+{
+    if (p[0] != 0xFF || (p[1] & 0xE0) != 0xE0) return false;
+
+    int version = (p[1] >> 3) & 0x03;   // 0 = 2.5, 1 = reserved, 2 = MPEG2, 3 = MPEG1
+    int layer = (p[1] >> 1) & 0x03;     // 1 = III, 2 = II, 3 = I
+    int br_idx = p[2] >> 4;
+    int sr_idx = (p[2] >> 2) & 0x03;
+    if (version == 1 || layer == 0 || br_idx == 0 || br_idx == 15 || sr_idx == 3) {
+        return false;
+    }
+
+    int layer_idx = 3 - layer;
+    h->mpeg1 = version == 3;
+    h->mono = (p[3] >> 6) == 3;
+    h->bitrate_kbps = mp3_bitrate[h->mpeg1 ? 0 : 1][layer_idx][br_idx];
+    h->sample_rate = mp3_samplerate[sr_idx] >> (h->mpeg1 ? 0 : (version == 2 ? 1 : 2));
+
+    int padding = (p[2] >> 1) & 0x01;
+    if (layer_idx == 0) {
+        h->samples = 384;
+        h->frame_len = (12 * h->bitrate_kbps * 1000 / h->sample_rate + padding) * 4;
+    } else if (layer_idx == 2 && !h->mpeg1) {
+        h->samples = 576;
+        h->frame_len = 72 * h->bitrate_kbps * 1000 / h->sample_rate + padding;
+    } else {
+        h->samples = 1152;
+        h->frame_len = 144 * h->bitrate_kbps * 1000 / h->sample_rate + padding;
+    }
+    return true;
+}
+
+// Ten sam strumień: wersja, warstwa i częstotliwość (bitrate może się zmieniać - VBR)
+static bool mp3_match(const uint8_t *a, const uint8_t *b)
+{
+    return (a[1] & 0xFE) == (b[1] & 0xFE) && (a[2] & 0x0C) == (b[2] & 0x0C);
+}
+
+typedef struct {
+    uint32_t first_frame;       // Pierwsza ramka (także ramka Xing/VBRI)
+    uint32_t audio_start;       // Pierwsza ramka audio
+    uint32_t audio_end;         // Koniec danych (bez ID3v1)
+    uint8_t ref[4];             // Nagłówek pierwszej ramki - wzorzec synchronizacji
+    mp3_header_t hdr;
+    uint32_t total_frames;      // Z Xing/VBRI (0 - brak)
+    uint32_t total_bytes;
+    bool xing;                  // Ramka "Xing" - VBR
+    bool info;                  // Ramka "Info" - koder zadeklarował CBR
+    bool has_toc;
+    uint8_t toc[100];
+    uint32_t vbri_entries;      // Tabela VBRI: rozmiary kolejnych odcinków w bajtach
+    uint32_t vbri_table;
+    uint32_t vbri_entry_size;
+    uint32_t vbri_scale;
+    uint32_t vbri_frames;       // Ramki na odcinek
+    bool lame;                  // Znacznik LAME za polami Xing/Info
+    uint32_t enc_delay;         // Próbki ciszy dodane przez koder na początku
+    uint32_t enc_padding;       // i na końcu ostatniej ramki
+} mp3_stream_t;
+
+// Następny nagłówek ramki zgodny ze wzorcem (ref NULL - dowolny), potwierdzony nagłówkiem
+// kolejnej ramki. Ramka przy końcu danych nie ma następnej - wystarczy jej nagłówek.
+static bool mp3_sync(reader_t *r, uint32_t from, uint32_t end, const uint8_t *ref, uint32_t *pos)
+{
+    uint32_t limit = from + MP3_SYNC_LIMIT < end ? from + MP3_SYNC_LIMIT : end;
+    for (uint32_t p = from; p + 4 <= limit; p++) {
+        const uint8_t *h = reader_peek(r, p, 4);
+        mp3_header_t hdr;
+        if (h == NULL) return false;
+        if (h[0] != 0xFF || !mp3_parse(h, &hdr) || (ref && !mp3_match(h, ref))) {
+            continue;
+        }
+        uint8_t first[4];
+        memcpy(first, h, 4);
+        if (p + hdr.frame_len + 4 > end) {
+            *pos = p;
+            return true;
+        }
+        const uint8_t *next = reader_peek(r, p + hdr.frame_len, 4);
+        mp3_header_t next_hdr;
+        if (next && mp3_parse(next, &next_hdr) && mp3_match(next, first)) {
+            *pos = p;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool mp3_open(reader_t *r, mp3_stream_t *s)
+{
+    memset(s, 0, sizeof(*s));
+    uint32_t size = file_size(r->f);
+    uint8_t tag[3];
+    s->audio_end = size;
+    if (size >= 128 && read_at(r->f, size - 128, tag, 3) && memcmp(tag, "TAG", 3) == 0) {
+        s->audio_end = size - 128;
+    }
+
+    if (!mp3_sync(r, id3v2_end(r->f), s->audio_end, NULL, &s->first_frame)) {
+        return false;
+    }
+    const uint8_t *p = reader_peek(r, s->first_frame, 4);
+    if (p == NULL) return false;
+    memcpy(s->ref, p, 4);
+    mp3_parse(s->ref, &s->hdr);
+    s->audio_start = s->first_frame;
+
+    // Xing/Info za informacją poboczną, VBRI zawsze 32 bajty za nagłówkiem
+    uint32_t side = s->hdr.mpeg1 ? (s->hdr.mono ? 17 : 32) : (s->hdr.mono ? 9 : 17);
+    const uint8_t *x = reader_peek(r, s->first_frame + 4 + side, 120);
+    if (x && (memcmp(x, "Xing", 4) == 0 || memcmp(x, "Info", 4) == 0)) {
+        s->xing = x[0] == 'X';
+        s->info = !s->xing;
+        uint32_t flags = be32(x + 4);
+        const uint8_t *field = x + 8;
+        if (flags & 0x1) { s->total_frames = be32(field); field += 4; }
+        if (flags & 0x2) { s->total_bytes = be32(field); field += 4; }
+        if (flags & 0x4) { memcpy(s->toc, field, 100); s->has_toc = true; field += 100; }
+        if (flags & 0x8) field += 4;
+        s->audio_start = s->first_frame + s->hdr.frame_len;
+
+        // Znacznik LAME (także "Lavc" z ffmpeg): opóźnienie i dopełnienie po 12 bitów
+        uint32_t lame_pos = s->first_frame + 4 + side + (uint32_t)(field - x);
+        const uint8_t *l = lame_pos + 24 <= s->audio_start ? reader_peek(r, lame_pos, 24) : NULL;
+        if (l && (memcmp(l, "LAME", 4) == 0 || memcmp(l, "Lavc", 4) == 0 || memcmp(l, "Lavf", 4) == 0)) {
+            uint32_t delay = (l[21] << 4) | (l[22] >> 4);
+            uint32_t padding = ((l[22] & 0x0f) << 8) | l[23];
+            if (delay <= 2 * s->hdr.samples && padding <= 3 * s->hdr.samples) {
+                s->lame = true;
+                s->enc_delay = delay;
+                s->enc_padding = padding;
+            }
+        }
+        return true;
+    }
+
+    const uint8_t *v = reader_peek(r, s->first_frame + 4 + 32, 26);
+    if (v && memcmp(v, "VBRI", 4) == 0) {
+        s->total_bytes = be32(v + 10);
+        s->total_frames = be32(v + 14);
+        s->vbri_entries = be16(v + 18);
+        s->vbri_scale = be16(v + 20);
+        s->vbri_entry_size = be16(v + 22);
+        s->vbri_frames = be16(v + 24);
+        s->vbri_table = s->first_frame + 4 + 32 + 26;
+        if (s->vbri_entry_size < 1 || s->vbri_entry_size > 4 || s->vbri_frames == 0) {
+            s->vbri_entries = 0;
+        }
+        s->audio_start = s->first_frame + s->hdr.frame_len;
+    }
+    return true;
+}
+
+// Od ramki o znanym numerze do ramki target (po długościach z nagłówków)
+static bool mp3_walk(reader_t *r, const mp3_stream_t *s, uint32_t pos, uint32_t frame,
+                     uint32_t target, uint32_t *out_pos, uint32_t *out_frame)
+{
+    while (frame < target) {
+        const uint8_t *h = reader_peek(r, pos, 4);
+        mp3_header_t hdr;
+        if (h == NULL || !mp3_parse(h, &hdr) || !mp3_match(h, s->ref)) {
+            return false;
+        }
+        if (pos + hdr.frame_len + 4 > s->audio_end) {
+            break;  // Ostatnia ramka - cel za końcem pliku
+        }
+        pos += hdr.frame_len;
+        frame++;
+    }
+    *out_pos = pos;
+    *out_frame = frame;
+    return true;
+}
+
+static bool mp3_locate(FILE *f, uint32_t target_ms, const seek_mp3_table_t *table, seek_point_t *point)
+{
+    reader_t r;
+    if (!reader_init(&r, f, READ_BUFFER_SIZE)) return false;
+
+    mp3_stream_t s;
+    bool ok = mp3_open(&r, &s);
+    if (!ok) {
+        reader_free(&r);
+        return false;
+    }
+
+    uint32_t spf = s.hdr.samples;
+    uint64_t target = (uint64_t)target_ms * s.hdr.sample_rate / 1000;
+    uint32_t frame = target / spf;
+    if (s.total_frames && frame >= s.total_frames) {
+        frame = s.total_frames - 1;
+        target = (uint64_t)frame * spf;
+    }
+    point->sample_rate = s.hdr.sample_rate;
+    point->header_len = 0;
+
+    uint32_t pos = 0, found = 0;
+    ok = false;
+
+    if (table && table->offsets && table->count && table->sample_rate == s.hdr.sample_rate &&
+        table->samples_per_frame == spf) {
+        // Tabela ramek: najbliższy wpis przed celem i co najwyżej 31 ramek dalej
+        if (table->total_frames && frame >= table->total_frames) {
+            frame = table->total_frames - 1;
+            target = (uint64_t)frame * spf;
+        }
+        uint32_t entry = frame / SEEK_MP3_FRAMES_PER_ENTRY;
+        if (entry >= table->count) entry = table->count - 1;
+        ok = mp3_walk(&r, &s, table->offsets[entry], entry * SEEK_MP3_FRAMES_PER_ENTRY,
+                      frame, &pos, &found);
+        point->exact = ok;
+    }
+
+    if (!ok && s.vbri_entries) {
+        // VBRI: granice odcinków są początkami ramek - dalej po nagłówkach
+        uint32_t entry_frames = s.vbri_frames;
+        uint32_t entries = frame / entry_frames;
+        if (entries > s.vbri_entries) entries = s.vbri_entries;
+        uint32_t bytes = 0;
+        for (uint32_t i = 0; i < entries; i++) {
+            const uint8_t *e = reader_peek(&r, s.vbri_table + i * s.vbri_entry_size, s.vbri_entry_size);
+            if (e == NULL) break;
+            uint32_t v = 0;
+            for (uint32_t b = 0; b < s.vbri_entry_size; b++) v = (v << 8) | e[b];
+            bytes += v * s.vbri_scale;
+        }
+        ok = mp3_walk(&r, &s, s.audio_start + bytes, entries * entry_frames, frame, &pos, &found);
+        point->exact = ok;
+    }
+
+    if (!ok) {
+        // TOC Xing (1% pliku) albo CBR - szacunek i synchronizacja do najbliższej ramki
+        uint32_t estimate;
+        if (s.has_toc && s.total_frames && s.total_bytes) {
+            double percent = (double)frame * 100.0 / s.total_frames;
+            int i = percent < 99.0 ? (int)percent : 99;
+            double a = s.toc[i];
+            double b = i < 99 ? s.toc[i + 1] : 256.0;
+            estimate = s.first_frame + (uint32_t)((a + (b - a) * (percent - i)) / 256.0 * s.total_bytes);
+        } else if (s.total_frames && s.total_bytes > s.audio_start - s.first_frame) {
+            // Rozmiar z Xing/Info obejmuje ramkę informacyjną, liczba ramek - nie
+            uint64_t audio_bytes = s.total_bytes - (s.audio_start - s.first_frame);
+            estimate = s.audio_start + (uint32_t)((uint64_t)frame * audio_bytes / s.total_frames);
+        } else {
+            estimate = s.audio_start +
+                       (uint32_t)((uint64_t)frame * spf * s.hdr.bitrate_kbps * 125 / s.hdr.sample_rate);
+        }
+        // Przy CBR szacunek trafia w ramkę z dokładnością do bajtu dopełnienia
+        uint32_t from = estimate > s.audio_start + 4 ? estimate - 4 : s.audio_start;
+        ok = mp3_sync(&r, from, s.audio_end, s.ref, &pos);
+        bool at_end = false;
+        if (!ok && from > s.audio_start) {
+            // Szacunek w ostatniej ramce lub za końcem danych - któraś z ostatnich ramek,
+            // jej numer nie jest znany
+            from = s.audio_end > s.audio_start + MP3_SYNC_LIMIT / 4 ?
+                   s.audio_end - MP3_SYNC_LIMIT / 4 : s.audio_start;
+            ok = mp3_sync(&r, from, s.audio_end, s.ref, &pos);
+            at_end = true;
+        }
+        found = frame;
+        point->exact = ok && !at_end && s.info && !s.has_toc && pos <= estimate + 4;
+    }
+
+    if (ok) {
+        point->byte_pos = pos;
+        point->sample = (uint64_t)found * spf;
+        // Po szacunku numer ramki nie jest pewny - bez przycinania w ramce
+        point->skip_samples = point->exact && target > point->sample ?
+                              (uint32_t)(target - point->sample) : 0;
+    }
+    reader_free(&r);
+    return ok;
+}
+
+// ============================================
+// FLAC
+// ============================================
+
+typedef struct {
+    uint8_t streaminfo[34];
+    uint32_t sample_rate;
+    uint32_t channels;
+    uint32_t bits;
+    uint32_t fixed_blocksize;   // min == max w STREAMINFO (0 - zmienny rozmiar bloku)
+    uint32_t max_framesize;
+    uint64_t total_samples;
+    uint32_t audio_start;
+    uint32_t audio_end;
+    uint32_t seektable;         // Pozycja punktów SEEKTABLE (0 - brak)
+    uint32_t seekpoints;
+} flac_stream_t;
+
+typedef struct {
+    uint64_t sample;            // Pierwsza próbka ramki
+    uint32_t blocksize;
+} flac_frame_t;
+
+static uint8_t crc8(const uint8_t *p, int len)
+{
+    uint8_t crc = 0;
+    while (len--) {
+        crc ^= *p++;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+static bool flac_open(FILE *f, flac_stream_t *s)
+{
+    memset(s, 0, sizeof(*s));
+    uint8_t hdr[4];
+    uint32_t pos = id3v2_end(f);
+    if (!read_at(f, pos, hdr, 4) || memcmp(hdr, "fLaC", 4) != 0) {
+        return false;
+    }
+    pos += 4;
+
+    bool have_info = false, last = false;
+    while (!last) {
+        if (!read_at(f, pos, hdr, 4)) return false;
+        last = hdr[0] & 0x80;
+        int type = hdr[0] & 0x7f;
+        uint32_t len = be24(hdr + 1);
+        pos += 4;
+        if (type == 0 && len == 34) {
+            if (!read_at(f, pos, s->streaminfo, 34)) return false;
+            have_info = true;
+        } else if (type == 3) {
+            s->seektable = pos;
+            s->seekpoints = len / 18;
+        }
+        pos += len;
+    }
+    if (!have_info) return false;
+
+    const uint8_t *si = s->streaminfo;
+    uint32_t min_block = be16(si), max_block = be16(si + 2);
+    s->fixed_blocksize = min_block == max_block ? max_block : 0;
+    s->max_framesize = be24(si + 7);
+    s->sample_rate = (si[10] << 12) | (si[11] << 4) | (si[12] >> 4);
+    s->channels = ((si[12] >> 1) & 0x07) + 1;
+    s->bits = (((si[12] & 0x01) << 4) | (si[13] >> 4)) + 1;
+    s->total_samples = ((uint64_t)(si[13] & 0x0f) << 32) | be32(si + 14);
+    s->audio_start = pos;
+    s->audio_end = file_size(f);
+    return s->sample_rate > 0;
+}
+
+// Nagłówek ramki FLAC ze sprawdzeniem CRC-8 i zgodności z STREAMINFO
+static bool flac_parse_frame(const uint8_t *p, const flac_stream_t *s, flac_frame_t *fr)
+{
+    if (p[0] != 0xFF || (p[1] & 0xFE) != 0xF8) return false;
+
+    int bs_code = p[2] >> 4, sr_code = p[2] & 0x0f;
+    int ch_code = p[3] >> 4, bps_code = (p[3] >> 1) & 0x07;
+    if (bs_code == 0 || sr_code == 15 || ch_code > 10 || bps_code == 3 || (p[3] & 0x01)) {
+        return false;
+    }
+    static const uint8_t bps_table[8] = {0, 8, 12, 0, 16, 20, 24, 32};
+    if (bps_code && bps_table[bps_code] != s->bits) return false;
+    uint32_t channels = ch_code < 8 ? ch_code + 1 : 2;
+    if (channels != s->channels) return false;
+
+    // Numer ramki (stały blok) lub próbki (zmienny) w kodowaniu UTF-8
+    int i = 4, extra;
+    uint64_t number = p[i];
+    if (!(number & 0x80)) { extra = 0; }
+    else if ((number & 0xe0) == 0xc0) { extra = 1; number &= 0x1f; }
+    else if ((number & 0xf0) == 0xe0) { extra = 2; number &= 0x0f; }
+    else if ((number & 0xf8) == 0xf0) { extra = 3; number &= 0x07; }
+    else if ((number & 0xfc) == 0xf8) { extra = 4; number &= 0x03; }
+    else if ((number & 0xfe) == 0xfc) { extra = 5; number &= 0x01; }
+    else if (number == 0xfe && (p[1] & 0x01)) { extra = 6; number = 0; }
+    else return false;
+    i++;
+    for (int k = 0; k < extra; k++, i++) {
+        if ((p[i] & 0xc0) != 0x80) return false;
+        number = (number << 6) | (p[i] & 0x3f);
+    }
+
+    uint32_t blocksize;
+    if (bs_code == 1) blocksize = 192;
+    else if (bs_code <= 5) blocksize = 576 << (bs_code - 2);
+    else if (bs_code == 6) blocksize = p[i++] + 1;
+    else if (bs_code == 7) { blocksize = be16(p + i) + 1; i += 2; }
+    else blocksize = 256 << (bs_code - 8);
+
+    if (sr_code == 12) i += 1;
+    else if (sr_code == 13 || sr_code == 14) i += 2;
+
+    if (crc8(p, i) != p[i]) return false;
+
+    fr->blocksize = blocksize;
+    if (p[1] & 0x01) {
+        fr->sample = number;
+    } else {
+        fr->sample = number * (s->fixed_blocksize ? s->fixed_blocksize : blocksize);
+    }
+    return s->total_samples == 0 || fr->sample < s->total_samples;
+}
+
+// Pierwsza ramka od pozycji from (szukanie synchronizacji przez dane poprzedniej ramki)
+static bool flac_sync(reader_t *r, const flac_stream_t *s, uint32_t from, uint32_t *pos, flac_frame_t *fr)
+{
+    uint32_t limit = from + FLAC_SYNC_LIMIT + s->max_framesize;
+    if (limit > s->audio_end) limit = s->audio_end;
+    for (uint32_t p = from; p + 2 <= limit; p++) {
+        const uint8_t *h = reader_peek(r, p, 2);
+        if (h == NULL) return false;
+        if (h[0] != 0xFF || (h[1] & 0xFE) != 0xF8) continue;
+        // Kopia z dopełnieniem zerami - nagłówek przy końcu pliku może być krótszy
+        uint8_t header[FLAC_HEADER_MAX] = {0};
+        uint32_t n = s->audio_end - p < FLAC_HEADER_MAX ? s->audio_end - p : FLAC_HEADER_MAX;
+        h = reader_peek(r, p, n);
+        if (h == NULL) return false;
+        memcpy(header, h, n);
+        if (flac_parse_frame(header, s, fr)) {
+            *pos = p;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool flac_locate(FILE *f, uint32_t target_ms, seek_point_t *point)
+{
+    flac_stream_t s;
+    if (!flac_open(f, &s)) return false;
+
+    uint64_t target = (uint64_t)target_ms * s.sample_rate / 1000;
+    if (s.total_samples && target >= s.total_samples) {
+        target = s.total_samples - 1;
+    }
+
+    // Punkty SEEKTABLE otaczające cel (offsety względem pierwszej ramki)
+    uint64_t lo_sample = 0, hi_sample = s.total_samples;
+    uint32_t lo_pos = s.audio_start, hi_pos = s.audio_end;
+    for (uint32_t i = 0; i < s.seekpoints; i++) {
+        uint8_t sp[18];
+        if (!read_at(f, s.seektable + i * 18, sp, sizeof(sp))) break;
+        uint64_t sample = be64(sp);
+        if (sample == UINT64_MAX) break;    // Punkty zastępcze na końcu tabeli
+        uint64_t offset = be64(sp + 8);
+        if (s.audio_start + offset >= s.audio_end) break;
+        if (sample <= target) {
+            lo_sample = sample;
+            lo_pos = s.audio_start + offset;
+        } else {
+            hi_sample = sample;
+            hi_pos = s.audio_start + offset;
+            break;
+        }
+    }
+
+    reader_t r;
+    if (!reader_init(&r, f, READ_BUFFER_SIZE)) return false;
+
+    flac_frame_t fr;
+    uint32_t pos;
+    if (!flac_sync(&r, &s, lo_pos, &pos, &fr)) {
+        reader_free(&r);
+        return false;
+    }
+    lo_pos = pos;
+    lo_sample = fr.sample;
+    uint32_t lo_block = fr.blocksize;
+
+    // Bisekcja z interpolacją po bajtach, dopóki cel nie jest kilka ramek dalej
+    for (int step = 0; step < FLAC_MAX_STEPS && target >= lo_sample + 4 * (uint64_t)lo_block; step++) {
+        if (hi_sample <= lo_sample || hi_pos <= lo_pos) break;
+        uint32_t guess = lo_pos + (uint32_t)((double)(hi_pos - lo_pos) *
+                                             (double)(target - lo_sample) / (double)(hi_sample - lo_sample));
+        // Zapas na ramkę przed celem - lepiej lądować przed niż za
+        guess = guess > lo_pos + s.max_framesize + 1 ? guess - s.max_framesize : lo_pos + 1;
+        if (!flac_sync(&r, &s, guess, &pos, &fr) || pos >= hi_pos) {
+            hi_pos = guess;
+            continue;
+        }
+        if (fr.sample > target) {
+            hi_pos = pos;
+            hi_sample = fr.sample;
+        } else {
+            lo_pos = pos;
+            lo_sample = fr.sample;
+            lo_block = fr.blocksize;
+        }
+    }
+
+    // Ostatnie ramki po kolei
+    for (int i = 0; i < FLAC_MAX_WALK && target >= lo_sample + lo_block; i++) {
+        if (!flac_sync(&r, &s, lo_pos + 1, &pos, &fr) || fr.sample > target) {
+            break;
+        }
+        lo_pos = pos;
+        lo_sample = fr.sample;
+        lo_block = fr.blocksize;
+    }
+    reader_free(&r);
+
+    point->byte_pos = lo_pos;
+    point->sample = lo_sample;
+    point->skip_samples = (uint32_t)(target - lo_sample);
+    point->sample_rate = s.sample_rate;
+    point->exact = true;
+
+    // Dekoder potrzebuje STREAMINFO przed pierwszą ramką
+    memcpy(point->header, "fLaC", 4);
+    point->header[4] = 0x80;    // Ostatni blok metadanych, STREAMINFO
+    point->header[5] = 0;
+    point->header[6] = 0;
+    point->header[7] = 34;
+    memcpy(point->header + 8, s.streaminfo, 34);
+    point->header_len = 42;
+    return true;
+}
+
+// ============================================
+// WAV
+// ============================================
+
+static bool wav_locate(FILE *f, uint32_t target_ms, seek_point_t *point)
+{
+    uint8_t hdr[12];
+    if (!read_at(f, 0, hdr, sizeof(hdr)) || memcmp(hdr, "RIFF", 4) != 0 || memcmp(hdr + 8, "WAVE", 4) != 0) {
+        return false;
+    }
+
+    uint8_t fmt[16];
+    bool have_fmt = false;
+    uint32_t pos = 12, size = file_size(f);
+    while (pos + 8 <= size) {
+        uint8_t chunk[8];
+        if (!read_at(f, pos, chunk, sizeof(chunk))) return false;
+        uint32_t len = le32(chunk + 4);
+        pos += 8;
+        if (memcmp(chunk, "fmt ", 4) == 0 && len >= 16) {
+            if (!read_at(f, pos, fmt, sizeof(fmt))) return false;
+            have_fmt = true;
+        } else if (memcmp(chunk, "data", 4) == 0 && have_fmt) {
+            uint32_t block_align = le16(fmt + 12);
+            uint32_t rate = le32(fmt + 4);
+            if (block_align == 0 || rate == 0) return false;
+            if (len > size - pos) len = size - pos;     // Nagrania przerwane przed zapisem rozmiaru
+
+            uint64_t frames = len / block_align;
+            uint64_t target = (uint64_t)target_ms * rate / 1000;
+            if (target >= frames) target = frames ? frames - 1 : 0;
+
+            point->byte_pos = pos + (uint32_t)(target * block_align);
+            point->sample = target;
+            point->skip_samples = 0;
+            point->sample_rate = rate;
+            point->exact = true;
+
+            // Kanoniczny nagłówek PCM z rozmiarem pozostałych danych
+            uint32_t remaining = len - (uint32_t)(target * block_align);
+            uint16_t format = le16(fmt) == 0xFFFE ? 1 : le16(fmt);    // EXTENSIBLE -> PCM
+            uint8_t *h = point->header;
+            memcpy(h, "RIFF", 4);
+            put_le32(h + 4, 36 + remaining);
+            memcpy(h + 8, "WAVEfmt ", 8);
+            put_le32(h + 16, 16);
+            put_le16(h + 20, format);
+            memcpy(h + 22, fmt + 2, 14);
+            memcpy(h + 36, "data", 4);
+            put_le32(h + 40, remaining);
+            point->header_len = 44;
+            return true;
+        }
+        pos += len + (len & 1);     // Chunki wyrównane do 2 bajtów
+    }
+    return false;
+}
+
+// ============================================
+// Granice utworu (odtwarzanie bez przerw)
+// ============================================
+
+// iTunSMPB: " 00000000 DDDDDDDD PPPPPPPP NNNNNNNNNNNNNNNN ..." - opóźnienie, dopełnienie,
+// liczba próbek oryginału (szesnastkowo)
+static bool parse_itunsmpb(const char *text, seek_track_info_t *info)
+{
+    unsigned long reserved, delay, padding;
+    unsigned long long samples;
+    if (sscanf(text, "%lx %lx %lx %llx", &reserved, &delay, &padding, &samples) != 4 ||
+        samples == 0 || delay > 8192) {
+        return false;
+    }
+    info->skip_samples = delay;
+    info->total_samples = samples;
+    return true;
+}
+
+// Tekst ramki ID3v2 do ASCII: Latin-1/UTF-8 wprost, z UTF-16 młodsze bajty znaków
+static int id3_text(const uint8_t *p, int len, int encoding, char *out, int out_size)
+{
+    int n = 0;
+    bool wide = encoding == 1 || encoding == 2;
+    bool le = encoding == 1 && len >= 2 && p[0] == 0xFF && p[1] == 0xFE;
+    if (encoding == 1 && len >= 2 && ((p[0] == 0xFF && p[1] == 0xFE) || (p[0] == 0xFE && p[1] == 0xFF))) {
+        p += 2;
+        len -= 2;
+    }
+    for (int i = 0; i + (wide ? 1 : 0) < len && n < out_size - 1; i += wide ? 2 : 1) {
+        char c = wide ? (char)(le ? p[i] : p[i + 1]) : (char)p[i];
+        if (c == 0) break;
+        out[n++] = c;
+    }
+    out[n] = '\0';
+    return n;
+}
+
+// Ramka COMM "iTunSMPB" z ID3v2.3/2.4 (zapisuje ją iTunes także w MP3)
+static bool id3_itunsmpb(FILE *f, seek_track_info_t *info)
+{
+    uint8_t hdr[10];
+    if (!read_at(f, 0, hdr, sizeof(hdr)) || memcmp(hdr, "ID3", 3) != 0 ||
+        (hdr[3] != 3 && hdr[3] != 4) || (hdr[5] & 0x80)) {
+        return false;   // Bez v2.2 i tagów z unsynchronisation
+    }
+    uint32_t end = id3v2_end(f) - ((hdr[5] & 0x10) ? 10 : 0);
+    uint32_t pos = 10;
+    if (hdr[5] & 0x40) {
+        uint8_t ext[4];
+        if (!read_at(f, pos, ext, 4)) return false;
+        pos += hdr[3] == 4 ? (((ext[0] & 0x7f) << 21) | ((ext[1] & 0x7f) << 14) |
+                              ((ext[2] & 0x7f) << 7) | (ext[3] & 0x7f)) : be32(ext) + 4;
+    }
+
+    while (pos + 10 <= end) {
+        uint8_t fh[10];
+        if (!read_at(f, pos, fh, sizeof(fh)) || fh[0] == 0) break;
+        uint32_t len = hdr[3] == 4 ? (((fh[4] & 0x7f) << 21) | ((fh[5] & 0x7f) << 14) |
+                                      ((fh[6] & 0x7f) << 7) | (fh[7] & 0x7f)) : be32(fh + 4);
+        pos += 10;
+        if (len > end - pos) break;
+        if (memcmp(fh, "COMM", 4) == 0 && len > 14 && len <= 256) {
+            uint8_t body[256];
+            char desc[16], text[128];
+            if (!read_at(f, pos, body, len)) return false;
+            int encoding = body[0];
+            bool wide = encoding == 1 || encoding == 2;
+            // Opis za kodowaniem i językiem, zakończony zerem (w UTF-16 - dwoma)
+            uint32_t i = 4;
+            while (i + (wide ? 1 : 0) < len && (body[i] || (wide && body[i + 1]))) i += wide ? 2 : 1;
+            id3_text(body + 4, i - 4, encoding, desc, sizeof(desc));
+            i += wide ? 2 : 1;
+            if (strcmp(desc, "iTunSMPB") == 0 && i < len) {
+                id3_text(body + i, len - i, encoding, text, sizeof(text));
+                return parse_itunsmpb(text, info);
+            }
+        }
+        pos += len;
+    }
+    return false;
+}
+
+static bool mp3_track_info(FILE *f, seek_track_info_t *info)
+{
+    reader_t r;
+    if (!reader_init(&r, f, READ_BUFFER_SIZE)) return false;
+    mp3_stream_t s;
+    bool ok = mp3_open(&r, &s);
+    reader_free(&r);
+    if (!ok) return false;
+
+    info->sample_rate = s.hdr.sample_rate;
+    info->channels = s.hdr.mono ? 1 : 2;
+    info->bits = 16;
+    // Ramka Xing/Info nie niesie dźwięku - dekoder dostaje dane od pierwszej ramki audio
+    info->start_pos = s.audio_start;
+
+    if (s.lame && s.total_frames) {
+        // Koder przesunął sygnał o enc_delay, dekoder dokłada 529 próbek opóźnienia filtrów
+        uint64_t total = (uint64_t)s.total_frames * s.hdr.samples;
+        if (total > s.enc_delay + s.enc_padding) {
+            info->skip_samples = s.enc_delay + MP3_DECODER_DELAY;
+            info->total_samples = total - s.enc_delay - s.enc_padding;
+        }
+    } else {
+        id3_itunsmpb(f, info);
+    }
+    return true;
+}
+
+// Atom MP4 typu type w [start, end) - pozycja i rozmiar zawartości
+static bool mp4_find(FILE *f, uint32_t start, uint32_t end, const char *type,
+                     uint32_t *body, uint32_t *body_len)
+{
+    uint32_t pos = start;
+    while (pos + 8 <= end) {
+        uint8_t h[16];
+        if (!read_at(f, pos, h, 8)) return false;
+        uint64_t size = be32(h);
+        uint32_t hdr_len = 8;
+        if (size == 1) {
+            if (!read_at(f, pos + 8, h + 8, 8)) return false;
+            size = be64(h + 8);
+            hdr_len = 16;
+        } else if (size == 0) {
+            size = end - pos;
+        }
+        if (size < hdr_len || size > end - pos) return false;
+        if (memcmp(h + 4, type, 4) == 0) {
+            *body = pos + hdr_len;
+            *body_len = (uint32_t)size - hdr_len;
+            return true;
+        }
+        pos += (uint32_t)size;
+    }
+    return false;
+}
+
+// Ścieżka atomów oddzielonych '/', np. "moov/trak/mdia"
+static bool mp4_path(FILE *f, uint32_t start, uint32_t end, const char *path,
+                     uint32_t *body, uint32_t *body_len)
+{
+    *body = start;
+    *body_len = end - start;
+    for (const char *p = path;; p += 5) {
+        if (!mp4_find(f, *body, *body + *body_len, p, body, body_len)) return false;
+        if (memcmp(p, "meta", 4) == 0) {
+            // meta jest pełnym atomem - wersja i flagi przed dziećmi
+            if (*body_len < 4) return false;
+            *body += 4;
+            *body_len -= 4;
+        }
+        if (p[4] != '/') return true;
+    }
+}
+
+static bool m4a_track_info(FILE *f, seek_track_info_t *info)
+{
+    uint32_t size = file_size(f), moov, moov_len;
+    if (!mp4_find(f, 0, size, "moov", &moov, &moov_len)) return false;
+    uint32_t moov_end = moov + moov_len;
+
+    // Format z pierwszego wpisu stsd: mp4a, kanały i częstotliwość (16.16)
+    uint32_t stsd, stsd_len;
+    uint8_t entry[36];
+    if (mp4_path(f, moov, moov_end, "trak/mdia/minf/stbl/stsd", &stsd, &stsd_len) &&
+        stsd_len >= 8 + sizeof(entry) && read_at(f, stsd + 8, entry, sizeof(entry)) &&
+        memcmp(entry + 4, "mp4a", 4) == 0) {
+        info->channels = be16(entry + 24);
+        info->sample_rate = be16(entry + 32);
+        info->bits = 16;
+    }
+
+    // Wpis "----" z nazwą iTunSMPB w ilst
+    uint32_t ilst, ilst_len;
+    if (!mp4_path(f, moov, moov_end, "udta/meta/ilst", &ilst, &ilst_len)) return true;
+    uint32_t pos = ilst, end = ilst + ilst_len;
+    while (pos + 8 <= end) {
+        uint8_t h[8];
+        if (!read_at(f, pos, h, sizeof(h)) || be32(h) < 8 || be32(h) > end - pos) break;
+        uint32_t item = pos + 8, item_len = be32(h) - 8;
+        uint32_t name, name_len, data, data_len;
+        char text[128];
+        if (memcmp(h + 4, "----", 4) == 0 &&
+            mp4_find(f, item, item + item_len, "name", &name, &name_len) && name_len == 4 + 8 &&
+            read_at(f, name + 4, text, 8) && memcmp(text, "iTunSMPB", 8) == 0 &&
+            mp4_find(f, item, item + item_len, "data", &data, &data_len) && data_len > 8) {
+            uint32_t n = data_len - 8 < sizeof(text) - 1 ? data_len - 8 : sizeof(text) - 1;
+            if (read_at(f, data + 8, text, n)) {
+                text[n] = '\0';
+                parse_itunsmpb(text, info);
+            }
+            break;
+        }
+        pos += be32(h);
+    }
+    return true;
+}
+
+static bool wav_track_info(FILE *f, seek_track_info_t *info)
+{
+    // Format z kanonicznego nagłówka tworzonego przy przewijaniu
+    seek_point_t point;
+    if (!wav_locate(f, 0, &point)) return false;
+    info->sample_rate = le32(point.header + 24);
+    info->channels = le16(point.header + 22);
+    info->bits = le16(point.header + 34);
+    return true;
+}
+
+static uint32_t pcm_frame_bytes(int channels, int bits)
+{
+    return channels * (bits > 16 ? bits / 8 : 2);
+}
+
+// ============================================
+// Public API
+// ============================================
+
+bool seek_index_locate(FILE *f, esp_codec_type_t codec, uint32_t target_ms,
+                       const seek_mp3_table_t *table, seek_point_t *point)
+{
+    memset(point, 0, sizeof(*point));
+    switch (codec) {
+        case ESP_CODEC_TYPE_MP3:
+            return mp3_locate(f, target_ms, table, point);
+        case ESP_CODEC_TYPE_FLAC:
+            return flac_locate(f, target_ms, point);
+        case ESP_CODEC_TYPE_WAV:
+            return wav_locate(f, target_ms, point);
+        default:
+            return false;   // AAC/M4A - pozycja wymagałaby tablic stco/stsz z moov
+    }
+}
+
+bool seek_index_track_info(FILE *f, esp_codec_type_t codec, seek_track_info_t *info)
+{
+    memset(info, 0, sizeof(*info));
+    switch (codec) {
+        case ESP_CODEC_TYPE_MP3:
+            return mp3_track_info(f, info);
+        case ESP_CODEC_TYPE_M4A:
+            return m4a_track_info(f, info);
+        case ESP_CODEC_TYPE_FLAC: {
+            flac_stream_t s;
+            if (!flac_open(f, &s)) return false;
+            info->sample_rate = s.sample_rate;
+            info->channels = s.channels;
+            info->bits = s.bits;
+            return true;
+        }
+        case ESP_CODEC_TYPE_WAV:
+            return wav_track_info(f, info);
+        default:
+            return true;    // Bez przycinania i z formatem z dekodera
+    }
+}
+
+bool seek_index_mp3_needs_table(FILE *f)
+{
+    reader_t r;
+    if (!reader_init(&r, f, READ_BUFFER_SIZE)) return false;
+
+    mp3_stream_t s;
+    bool needs = false;
+    if (mp3_open(&r, &s) && !s.info && !s.vbri_entries) {
+        // Xing (TOC co 1% pliku) lub brak ramki informacyjnej - sprawdź, czy bitrate jest stały
+        needs = s.xing;
+        uint32_t pos = s.audio_start;
+        for (int i = 0; i < MP3_CBR_CHECK && !needs; i++) {
+            const uint8_t *h = reader_peek(&r, pos, 4);
+            mp3_header_t hdr;
+            if (h == NULL || !mp3_parse(h, &hdr) || !mp3_match(h, s.ref)) break;
+            needs = hdr.bitrate_kbps != s.hdr.bitrate_kbps;
+            pos += hdr.frame_len;
+        }
+    }
+    reader_free(&r);
+    return needs;
+}
+
+bool seek_index_mp3_build(FILE *f, seek_mp3_table_t *table)
+{
+    memset(table, 0, sizeof(*table));
+    reader_t r;
+    if (!reader_init(&r, f, BUILD_BUFFER_SIZE)) return false;
+
+    mp3_stream_t s;
+    if (!mp3_open(&r, &s)) {
+        reader_free(&r);
+        return false;
+    }
+    table->file_size = file_size(f);
+    table->samples_per_frame = s.hdr.samples;
+    table->sample_rate = s.hdr.sample_rate;
+
+    uint32_t capacity = 0, frame = 0, pos = s.audio_start;
+    bool ok = true;
+    while (pos + 4 <= s.audio_end) {
+        const uint8_t *h = reader_peek(&r, pos, 4);
+        mp3_header_t hdr;
+        if (h == NULL) break;
+        if (!mp3_parse(h, &hdr) || !mp3_match(h, s.ref)) {
+            // Śmieci w środku pliku - dekoder też je przeskoczy
+            if (!mp3_sync(&r, pos + 1, s.audio_end, s.ref, &pos)) break;
+            continue;
+        }
+        if (frame % SEEK_MP3_FRAMES_PER_ENTRY == 0) {
+            if (table->count == capacity) {
+                uint32_t new_capacity = capacity ? capacity * 2 : 256;
+                uint32_t *p = realloc(table->offsets, new_capacity * sizeof(uint32_t));
+                if (p == NULL) {
+                    ok = false;
+                    break;
+                }
+                table->offsets = p;
+                capacity = new_capacity;
+            }
+            table->offsets[table->count++] = pos;
+        }
+        frame++;
+        pos += hdr.frame_len;
+    }
+    reader_free(&r);
+
+    table->total_frames = frame;
+    if (!ok || table->count == 0) {
+        seek_index_mp3_free(table);
+        return false;
+    }
+    return true;
+}
+
+void seek_index_mp3_free(seek_mp3_table_t *table)
+{
+    free(table->offsets);
+    memset(table, 0, sizeof(*table));
+}
+
+bool seek_index_mp3_save(const char *path, const seek_mp3_table_t *table)
+{
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) return false;
+
+    uint32_t header[6] = {
+        TABLE_MAGIC, table->file_size, table->samples_per_frame,
+        table->sample_rate, table->total_frames, table->count,
+    };
+    bool ok = fwrite(header, sizeof(header), 1, f) == 1 &&
+              fwrite(table->offsets, sizeof(uint32_t), table->count, f) == table->count;
+    ok = (fclose(f) == 0) && ok;
+    if (!ok) remove(path);
+    return ok;
+}
+
+bool seek_index_mp3_load(const char *path, uint32_t file_size, seek_mp3_table_t *table)
+{
+    memset(table, 0, sizeof(*table));
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) return false;
+
+    uint32_t header[6];
+    bool ok = fread(header, sizeof(header), 1, f) == 1 && header[0] == TABLE_MAGIC &&
+              header[1] == file_size && header[5] > 0 &&
+              header[5] <= header[4] / SEEK_MP3_FRAMES_PER_ENTRY + 1;
+    if (ok) {
+        table->offsets = malloc(header[5] * sizeof(uint32_t));
+        ok = table->offsets && fread(table->offsets, sizeof(uint32_t), header[5], f) == header[5];
+    }
+    fclose(f);
+
+    if (!ok) {
+        seek_index_mp3_free(table);
+        return false;
+    }
+    table->file_size = header[1];
+    table->samples_per_frame = header[2];
+    table->sample_rate = header[3];
+    table->total_frames = header[4];
+    table->count = header[5];
+    return true;
+}
+
+void seek_trim_init(seek_trim_t *trim, const seek_track_info_t *track)
+{
+    trim->frame_bytes = track->sample_rate ? pcm_frame_bytes(track->channels, track->bits) : 0;
+    trim->skip_bytes = track->skip_samples * trim->frame_bytes;
+    trim->trim_end = trim->frame_bytes > 0 && track->total_samples > 0;
+    trim->keep_bytes = track->total_samples * trim->frame_bytes;
+}
+
+uint64_t seek_trim_seek(seek_trim_t *trim, const seek_track_info_t *track, const seek_point_t *point,
+                        int rate, int channels, int bits)
+{
+    seek_trim_init(trim, track);
+    if (rate <= 0) {
+        rate = track->sample_rate;
+        channels = track->channels;
+        bits = track->bits;
+    }
+
+    // Cel wewnątrz ramki; dekoder oddaje próbki przesunięte o opóźnienie kodera, ale tylko
+    // pozycja dokładna jest liczona od początku dekodowania
+    uint32_t frame = pcm_frame_bytes(channels, bits);
+    uint64_t first = point->sample;
+    if (frame > 0 && rate == (int)point->sample_rate) {
+        uint32_t delay = point->exact ? track->skip_samples : 0;
+        trim->skip_bytes = (point->skip_samples + delay) * frame;
+        first += point->skip_samples;
+    } else {
+        trim->skip_bytes = 0;
+    }
+    if (trim->trim_end) {
+        uint64_t total = track->total_samples;
+        trim->keep_bytes = total > first && frame > 0 ? (total - first) * frame : 0;
+    }
+    return first;
+}
+
+int seek_trim_block(seek_trim_t *trim, int len, int *skip)
+{
+    *skip = 0;
+    if (trim->skip_bytes > 0) {
+        *skip = len < (int)trim->skip_bytes ? len : (int)trim->skip_bytes;
+        trim->skip_bytes -= *skip;
+    }
+    int avail = len - *skip;
+    if (trim->trim_end && (uint64_t)avail > trim->keep_bytes) {
+        avail = (int)trim->keep_bytes;
+    }
+    return avail;
+}
+
+void seek_trim_written(seek_trim_t *trim, int written)
+{
+    if (trim->trim_end && written > 0) {
+        trim->keep_bytes -= written;
+    }
+}
@@ -0,0 +1,98 @@
+/*
+ * Seek Index Module
+ * Pozycjonowanie w plikach z karty SD: offset w pliku, od którego czyta fatfs, numer
+ * pierwszej próbki na tej pozycji i liczba próbek do odrzucenia za dekoderem.
+ *  - MP3: tabela ramek (jeśli zbudowana), VBRI, TOC Xing, CBR z bitrate
+ *  - FLAC: SEEKTABLE i wyszukiwanie ramki (numer próbki z nagłówka ramki, CRC-8)
+ *  - WAV: offset wprost z block_align
+ * FLAC i WAV nie dekodują się bez nagłówka strumienia - jest zwracany do wstrzyknięcia
+ * przed danymi z nowej pozycji.
+ * Granice utworu do odtwarzania bez przerw: opóźnienie i dopełnienie kodera ze znacznika
+ * LAME (MP3) albo iTunSMPB (M4A, MP3 z iTunes).
+ *
+ * Czyste C (stdio + codec_detect) - można sprawdzać na hoście na próbkach plików.
+ */
+
+#ifndef SEEK_INDEX_H
+#define SEEK_INDEX_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "audio_common.h"
+
+#define SEEK_HEADER_MAX             64      // fLaC + STREAMINFO (42) / kanoniczny RIFF (44)
+#define SEEK_MP3_FRAMES_PER_ENTRY   32      // Gęstość tabeli ramek MP3 (~0.8 s przy 44.1 kHz)
+
+typedef struct {
+    uint32_t byte_pos;              // Początek odczytu w pliku (początek ramki)
+    uint64_t sample;                // Pierwsza próbka dekodowana od byte_pos
+    uint32_t skip_samples;          // Próbki do odrzucenia za dekoderem (do celu)
+    uint32_t sample_rate;
+    bool exact;                     // false - pozycja z TOC/szacunku (±kilka ramek)
+    uint8_t header[SEEK_HEADER_MAX];
+    uint8_t header_len;             // 0 - dekoder zsynchronizuje się sam (MP3)
+} seek_point_t;
+
+// Rzadka tabela ramek MP3 VBR bez TOC: offset co SEEK_MP3_FRAMES_PER_ENTRY ramek
+typedef struct {
+    uint32_t file_size;             // Plik, dla którego zbudowano (inny rozmiar - nieważna)
+    uint32_t samples_per_frame;
+    uint32_t sample_rate;
+    uint32_t total_frames;
+    uint32_t count;
+    uint32_t *offsets;
+} seek_mp3_table_t;
+
+// Format i granice utworu. PCM z dekodera od start_pos: pierwsze skip_samples próbek
+// i wszystko za total_samples to opóźnienie/dopełnienie kodera.
+typedef struct {
+    uint32_t start_pos;             // Początek odczytu (MP3: za ramką Xing/Info)
+    uint32_t skip_samples;          // Próbki do odrzucenia na początku
+    uint64_t total_samples;         // Długość utworu w próbkach (0 - nieznana, do końca)
+    uint32_t sample_rate;           // 0 - format dopiero z dekodera
+    uint8_t channels;
+    uint8_t bits;
+} seek_track_info_t;
+
+// Przycinanie PCM z dekodera do granic utworu (opóźnienie i dopełnienie kodera)
+typedef struct {
+    uint32_t frame_bytes;           // Bajty próbki wszystkich kanałów (0 - format nieznany)
+    uint32_t skip_bytes;            // PCM do odrzucenia (opóźnienie kodera, cel wewnątrz ramki)
+    bool trim_end;                  // Dopełnienie kodera za końcem utworu jest odcinane
+    uint64_t keep_bytes;            // PCM do końca utworu (przy trim_end)
+} seek_trim_t;
+
+// Pozycja dla czasu target_ms. table - opcjonalna tabela ramek MP3 (NULL - bez).
+// false - format bez obsługi przewijania (AAC/M4A) lub uszkodzony plik.
+bool seek_index_locate(FILE *f, esp_codec_type_t codec, uint32_t target_ms,
+                       const seek_mp3_table_t *table, seek_point_t *point);
+
+// false - uszkodzony plik; format bez znaczników daje info bez przycinania
+bool seek_index_track_info(FILE *f, esp_codec_type_t codec, seek_track_info_t *info);
+
+// MP3 bez TOC (Xing/VBRI) o zmiennym bitrate - tylko tabela ramek daje dokładną pozycję
+bool seek_index_mp3_needs_table(FILE *f);
+
+// Przejście po wszystkich ramkach pliku. false - to nie MP3 lub brak pamięci.
+bool seek_index_mp3_build(FILE *f, seek_mp3_table_t *table);
+void seek_index_mp3_free(seek_mp3_table_t *table);
+
+// Plik tabeli (nagłówek + offsety). load zwraca false także dla tabeli innego pliku.
+bool seek_index_mp3_save(const char *path, const seek_mp3_table_t *table);
+bool seek_index_mp3_load(const char *path, uint32_t file_size, seek_mp3_table_t *table);
+
+// Utwór dekodowany od start_pos
+void seek_trim_init(seek_trim_t *trim, const seek_track_info_t *track);
+
+// Utwór dekodowany od punktu przewinięcia. rate/channels/bits - format z dekodera (rate 0 -
+// jeszcze nieznany, z nagłówka). Zwraca pierwszą odtwarzaną próbkę.
+uint64_t seek_trim_seek(seek_trim_t *trim, const seek_track_info_t *track, const seek_point_t *point,
+                        int rate, int channels, int bits);
+
+// Porcja len bajtów z dekodera: *skip bajtów z początku do odrzucenia, zwraca liczbę bajtów
+// za nimi do zapisania (reszta to dopełnienie kodera)
+int seek_trim_block(seek_trim_t *trim, int len, int *skip);
+void seek_trim_written(seek_trim_t *trim, int written);
+
+#endif // SEEK_INDEX_H
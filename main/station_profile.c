@@ -0,0 +1,61 @@
+/*
+ * Station Profile Module
+ * Pamięć ostatnio granych stacji i polityka adaptacji prebufora
+ */
+
+#include <string.h>
+#include "station_profile.h"
+
+static station_profile_t station_profiles[STATION_PROFILE_COUNT] = {0};
+static int station_profile_next = 0;
+
+uint32_t station_profile_hash(const char *url)
+{
+    uint32_t hash = 2166136261u;
+    while (*url) {
+        hash ^= (uint8_t)*url++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+station_profile_t *station_profile_get(const char *url)
+{
+    uint32_t hash = station_profile_hash(url);
+    for (int i = 0; i < STATION_PROFILE_COUNT; i++) {
+        if (station_profiles[i].target_ms != 0 && station_profiles[i].url_hash == hash) {
+            return &station_profiles[i];
+        }
+    }
+
+    station_profile_t *profile = &station_profiles[station_profile_next];
+    station_profile_next = (station_profile_next + 1) % STATION_PROFILE_COUNT;
+    profile->url_hash = hash;
+    profile->codec = ESP_CODEC_TYPE_UNKNOW;
+    profile->target_ms = PREBUFFER_TARGET_DEFAULT_MS;
+    profile->underruns = 0;
+    return profile;
+}
+
+int station_profile_target_ms(const station_profile_t *profile, int capacity_ms)
+{
+    int target = profile ? profile->target_ms : PREBUFFER_TARGET_DEFAULT_MS;
+    capacity_ms = capacity_ms * 3 / 4;
+    return target < capacity_ms ? target : capacity_ms;
+}
+
+void station_profile_underrun(station_profile_t *profile)
+{
+    profile->underruns++;
+    int target = profile->target_ms * 2;
+    profile->target_ms = target > PREBUFFER_TARGET_MAX_MS ? PREBUFFER_TARGET_MAX_MS : target;
+}
+
+void station_profile_stable(station_profile_t *profile)
+{
+    int target = profile->target_ms * 3 / 4;
+    profile->target_ms = target < PREBUFFER_TARGET_MIN_MS ? PREBUFFER_TARGET_MIN_MS : target;
+    if (profile->underruns > 0) {
+        profile->underruns--;
+    }
+}
@@ -0,0 +1,46 @@
+/*
+ * Station Profile Module
+ * Pamięć ostatnio granych stacji (format, cel prebufora, historia underrun) i polityka
+ * adaptacji prebufora.
+ *
+ * Czyste C bez zależności od ESP-IDF - logikę buforowania odtwarzacza można
+ * kompilować i sprawdzać na hoście.
+ */
+
+#ifndef STATION_PROFILE_H
+#define STATION_PROFILE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "audio_common.h"
+
+// Ostatnio grane stacje - kolejne włączenie od razu z właściwym dekoderem i celem prebufora
+#define STATION_PROFILE_COUNT       16
+
+#define PREBUFFER_TARGET_DEFAULT_MS 500     // Nowa stacja - start po ~0.5s audio w buforze
+#define PREBUFFER_TARGET_MIN_MS     300
+#define PREBUFFER_TARGET_MAX_MS     8000
+
+typedef struct {
+    uint32_t url_hash;
+    esp_codec_type_t codec;         // Format rozpoznany przy ostatnim odtwarzaniu
+    uint16_t target_ms;             // Cel prebufora dopasowany do historii underrun
+    uint16_t underruns;             // Maleje po stabilnym odtwarzaniu
+} station_profile_t;
+
+// FNV-1a adresu stacji
+uint32_t station_profile_hash(const char *url);
+
+// Zwraca profil stacji, tworząc nowy (w miejsce najstarszego) jeśli nie istnieje
+station_profile_t *station_profile_get(const char *url);
+
+// Cel prebufora ograniczony do 3/4 pojemności bufora (profile NULL - domyślny)
+int station_profile_target_ms(const station_profile_t *profile, int capacity_ms);
+
+// Underrun - dwukrotnie większy zapas przy następnym buforowaniu
+void station_profile_underrun(station_profile_t *profile);
+
+// Stabilne odtwarzanie - cel maleje o 25% dla szybszego startu następnym razem
+void station_profile_stable(station_profile_t *profile);
+
+#endif // STATION_PROFILE_H
@@ -0,0 +1,693 @@
+/*
+ * Stream Slot Module
+ * Sloty strumieni radia (wybór dekodera MP3 / AAC / M4A), warm standby i ponowne
+ * łączenie w tasku http_stream
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_random.h"
+#include "esp_cpu.h"
+#include "sdkconfig.h"
+
+#include "stream_slot.h"
+#include "player_status.h"
+#include "pipeline_stats.h"
+#include "codec_detect.h"
+#include "http_stream.h"
+#include "mp3_decoder.h"
+#include "aac_decoder.h"
+#include "esp_http_client.h"
+
+static const char *TAG = "STREAM_SLOT";
+
+// Standby
+#define STANDBY_ARM_DELAY_MS        5000    // Standby łączy się po 5s stabilnego odtwarzania
+#define STANDBY_RETRY_MAX_MS        300000  // Maksymalny odstęp ponownych prób standby
+#define STANDBY_EXTRA_MS            500     // Zapas ponad cel prebufora trzymany w standby
+
+// Ponowne łączenie w miejscu (task http_stream)
+#define HTTP_CONNECT_TIMEOUT_MS     3000    // Połączenie i nagłówki - tyle najdłużej czeka stop slotu
+#define HTTP_READ_TIMEOUT_MS        5000    // Brak danych dłużej - połączenie uznane za zerwane
+#define RECONNECT_BACKOFF_MIN_MS    250
+#define RECONNECT_BACKOFF_MAX_MS    8000
+#define RECONNECT_GIVE_UP_MS        60000   // Potem pełny restart przez task sterujący
+
+// Standby: ponowne próby z rosnącym odstępem
+static bool standby_arming = false;
+static uint32_t standby_retry_ms = STANDBY_ARM_DELAY_MS;
+static uint32_t standby_failed_at = 0;
+
+static uint32_t now_ms(void)
+{
+    return xTaskGetTickCount() * portTICK_PERIOD_MS;
+}
+
+static int rb_filled(ringbuf_handle_t rb)
+{
+    return rb ? rb_bytes_filled(rb) : 0;
+}
+
+// ============================================
+// Dekoder slotu
+// ============================================
+
+// Wejście dekodera: bufor HTTP slotu. Czas między odczytami/zapisami (bez czekania na dane)
+// to czas dekodowania ramki.
+static int decoder_read_cb(audio_element_handle_t el, char *buf, int len, TickType_t wait, void *ctx)
+{
+    stream_slot_t *slot = (stream_slot_t *)ctx;
+    slot->decode_cycles += esp_cpu_get_cycle_count() - slot->io_mark;
+
+    ringbuf_handle_t rb = audio_element_get_input_ringbuf(el);
+    bool active = slot->active;
+    if (active) {
+        int filled = rb_bytes_filled(rb);
+        pipeline_stats_fill(PSTAT_DECODER, filled, rb_get_size(rb));
+        if (filled == 0 && player_status->state == PLAYER_STATE_PLAYING) {
+            pipeline_stats_underrun(PSTAT_DECODER);
+        }
+    }
+
+    int rlen = rb_read(rb, buf, len, wait);
+    if (active && rlen > 0) {
+        pipeline_stats_add_in(PSTAT_DECODER, rlen);
+    }
+
+    slot->io_mark = esp_cpu_get_cycle_count();
+    return rlen;
+}
+
+// Wyjście dekodera: PCM slotu (jedna ramka na zapis)
+static int decoder_write_cb(audio_element_handle_t el, char *buf, int len, TickType_t wait, void *ctx)
+{
+    stream_slot_t *slot = (stream_slot_t *)ctx;
+    slot->decode_cycles += esp_cpu_get_cycle_count() - slot->io_mark;
+
+    if (slot->active) {
+        pipeline_stats_decode_time(slot->decode_cycles / CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ);
+        pipeline_stats_add_out(PSTAT_DECODER, len);
+        if (rb_bytes_available(slot->pcm_rb) < len && player_status->state == PLAYER_STATE_PLAYING) {
+            pipeline_stats_overrun(PSTAT_DECODER);
+        }
+    }
+    slot->decode_cycles = 0;
+
+    int wlen = rb_write(slot->pcm_rb, buf, len, wait);
+    slot->io_mark = esp_cpu_get_cycle_count();
+    return wlen;
+}
+
+// Link/relink przywraca odczyt z ringbuffera - callbacki ustawiane po każdym połączeniu
+static void slot_attach_decoder_io(stream_slot_t *slot, audio_element_handle_t dec)
+{
+    audio_element_set_read_cb(dec, decoder_read_cb, slot);
+    audio_element_set_write_cb(dec, decoder_write_cb, slot);
+}
+
+static audio_element_handle_t decoder_for_codec(stream_slot_t *slot, esp_codec_type_t codec)
+{
+    return codec_detect_is_aac_family(codec) ? slot->aac : slot->mp3;
+}
+
+// Podłącza dekoder dla danego formatu. Pipeline slotu musi być zatrzymany.
+// Oba dekodery są utworzone przy starcie - relink tylko przepina ringbuffery.
+static void slot_link_decoder(stream_slot_t *slot, esp_codec_type_t codec)
+{
+    audio_element_handle_t dec = decoder_for_codec(slot, codec);
+    if (dec == slot->decoder) {
+        return;
+    }
+
+    const char *link_tag[2] = {"http", (dec == slot->aac) ? "aac" : "mp3"};
+
+    audio_pipeline_remove_listener(slot->pipeline);
+    audio_pipeline_breakup_elements(slot->pipeline, slot->decoder);
+    audio_pipeline_relink(slot->pipeline, link_tag, 2);
+    slot_attach_decoder_io(slot, dec);
+    audio_pipeline_set_listener(slot->pipeline, slot->evt);
+    slot->decoder = dec;
+
+    ESP_LOGI(TAG, "Slot %d decoder relinked: %s", slot->index, link_tag[1]);
+}
+
+void stream_slot_stop(stream_slot_t *slot)
+{
+    slot->running = false;
+    rb_abort(slot->pcm_rb);  // Dekoder może czekać na miejsce w PCM, którego nikt nie czyta
+    audio_pipeline_stop(slot->pipeline);
+    audio_pipeline_wait_for_stop(slot->pipeline);
+}
+
+// Dekoder według profilu stacji lub URL - ostateczna weryfikacja w hooku http
+esp_err_t stream_slot_start(stream_slot_t *slot, const char *url)
+{
+    stream_slot_stop(slot);
+    slot->generation++;
+
+    if (slot->url != url) {
+        strncpy(slot->url, url, sizeof(slot->url) - 1);
+        slot->url[sizeof(slot->url) - 1] = '\0';
+    }
+    audio_element_set_uri(slot->http, slot->url);
+
+    // Profil stacji: format i cel prebufora z poprzednich odtwarzań
+    slot->profile = station_profile_get(slot->url);
+    slot->bitrate_kbps = DEFAULT_BITRATE_KBPS;
+    slot->sample_rate = 0;
+    slot->icy_title[0] = '\0';
+    slot->icy_artist[0] = '\0';
+
+    esp_codec_type_t codec = slot->profile->codec;
+    if (codec == ESP_CODEC_TYPE_UNKNOW) {
+        // Piped/YouTube: mime=audio/mp4 w parametrach, pliki .m4a/.aac
+        bool aac_hint = strstr(slot->url, "mime=audio%2Fmp4") || strstr(slot->url, ".m4a") ||
+                        strstr(slot->url, ".aac");
+        codec = aac_hint ? ESP_CODEC_TYPE_M4A : ESP_CODEC_TYPE_MP3;
+    }
+    slot_link_decoder(slot, codec);
+
+    audio_pipeline_reset_ringbuffer(slot->pipeline);
+    audio_pipeline_reset_elements(slot->pipeline);
+    rb_reset(slot->pcm_rb);
+    slot->io_mark = esp_cpu_get_cycle_count();
+    slot->decode_cycles = 0;
+
+    // Przed startem - task http_stream (wyższy priorytet) łączy się jeszcze w
+    // audio_pipeline_run, a hook PRE_REQUEST odrzuca połączenia zatrzymanego slotu
+    slot->running = true;
+    esp_err_t ret = audio_pipeline_run(slot->pipeline);
+    if (ret != ESP_OK) {
+        slot->running = false;
+    } else if (!slot->active) {
+        // Standby nie dekoduje - dekoder rusza dopiero po przełączeniu
+        audio_element_pause(slot->decoder);
+    }
+    return ret;
+}
+
+void stream_slot_resume_decoder(stream_slot_t *slot)
+{
+    slot->io_mark = esp_cpu_get_cycle_count();  // Czas w pauzie to nie dekodowanie
+    audio_element_resume(slot->decoder, 0, 0);
+}
+
+bool stream_slot_owns(const stream_slot_t *slot, void *el)
+{
+    return slot->pipeline && el && (el == slot->http || el == slot->mp3 || el == slot->aac);
+}
+
+bool stream_slot_music_info(stream_slot_t *slot, audio_element_handle_t el)
+{
+    audio_element_info_t music_info = {0};
+    audio_element_getinfo(el, &music_info);
+    ESP_LOGI(TAG, "Slot %d music info: sample_rate=%d, channels=%d, bits=%d", slot->index,
+             music_info.sample_rates, music_info.channels, music_info.bits);
+
+    if (music_info.bps >= 8000 && music_info.bps <= 1000000) {
+        slot->bitrate_kbps = music_info.bps / 1000;  // Bitrate zgłoszony przez dekoder
+    }
+
+    if (music_info.sample_rates > 0 && music_info.channels > 0) {
+        slot->sample_rate = music_info.sample_rates;
+        slot->channels = music_info.channels;
+        slot->bits = music_info.bits;
+        return true;
+    }
+    return false;
+}
+
+// ============================================
+// Hook http_stream
+// ============================================
+
+// Rozpoznanie formatu z pierwszych bajtów odpowiedzi (wywoływane w tasku http_stream).
+// Synchronizacja ramki ma pierwszeństwo - Content-Type bywa błędny (np. octet-stream).
+static void probe_stream_codec(stream_slot_t *slot, const uint8_t *data, int len)
+{
+    audio_element_info_t info = {0};
+    audio_element_getinfo(slot->http, &info);
+
+    codec_frame_info_t frame = {0};
+    esp_codec_type_t codec = codec_detect_probe(data, len, &frame);
+    if (codec == ESP_CODEC_TYPE_UNKNOW) {
+        codec = info.codec_fmt;  // Content-Type zmapowany przez http_stream
+    }
+
+    if (codec != ESP_CODEC_TYPE_MP3 && !codec_detect_is_aac_family(codec)) {
+        ESP_LOGW(TAG, "Stream codec not recognized (%s), keeping current decoder",
+                 codec_detect_name(codec));
+        return;
+    }
+
+    ESP_LOGI(TAG, "Slot %d stream codec: %s (Content-Type: %s, %d kbps)", slot->index,
+             codec_detect_name(codec), codec_detect_name(info.codec_fmt), frame.bitrate_kbps);
+    if (frame.bitrate_kbps > 0) {
+        slot->bitrate_kbps = frame.bitrate_kbps;
+    }
+    if (slot->profile) {
+        slot->profile->codec = codec;
+    }
+
+    // Zły dekoder - restart slotu z właściwym (wyjście wciąż czeka na prebuffering)
+    if (decoder_for_codec(slot, codec) != slot->decoder && !slot->switch_pending) {
+        slot->switch_pending = true;
+        if (slot->hooks->post(slot, SLOT_EVENT_DECODER_SWITCH) != ESP_OK) {
+            slot->switch_pending = false;
+        }
+    }
+}
+
+// Blok metadanych ICY (task http_stream) - powiadomienie tylko przy zmianie tytułu
+static void icy_meta_callback(const char *meta, void *ctx)
+{
+    stream_slot_t *slot = (stream_slot_t *)ctx;
+
+    char artist[sizeof(slot->icy_artist)];
+    char title[sizeof(slot->icy_title)];
+    if (!icy_meta_parse_title(meta, artist, sizeof(artist), title, sizeof(title))) {
+        return;
+    }
+    if (strcmp(artist, slot->icy_artist) == 0 && strcmp(title, slot->icy_title) == 0) {
+        return;
+    }
+
+    strcpy(slot->icy_artist, artist);
+    strcpy(slot->icy_title, title);
+    ESP_LOGI(TAG, "Slot %d now playing: %s%s%s", slot->index,
+             artist, artist[0] ? " - " : "", title);
+
+    slot->hooks->post(slot, SLOT_EVENT_TITLE);
+}
+
+// Czeka ms, przerywając gdy slot jest zatrzymywany
+// Połączenie nadal potrzebne: slot nie zatrzymany, a aktywny nie czeka na zmianę stacji
+static bool slot_wanted(stream_slot_t *slot)
+{
+    return slot->running && !(slot->active && slot->hooks->superseded());
+}
+
+static bool slot_wait(stream_slot_t *slot, uint32_t ms)
+{
+    while (ms > 0 && slot_wanted(slot)) {
+        uint32_t step = ms < 50 ? ms : 50;
+        vTaskDelay(pdMS_TO_TICKS(step));
+        ms -= step;
+    }
+    return slot_wanted(slot);
+}
+
+// Plik bez obsługi Range - pomiń już odebraną część
+static bool slot_skip_body(stream_slot_t *slot, esp_http_client_handle_t client, char *buf, int buf_len)
+{
+    int64_t left = slot->body_pos;
+    while (left > 0 && slot->running) {
+        int rlen = esp_http_client_read(client, buf, left < buf_len ? (int)left : buf_len);
+        if (rlen <= 0) return false;
+        left -= rlen;
+    }
+    return left == 0;
+}
+
+// Odstęp bloków ICY z nagłówka odpowiedzi; bez nagłówka zostaje wyszukiwanie w body
+static void slot_apply_metaint(stream_slot_t *slot, esp_http_client_handle_t client)
+{
+    char *metaint = NULL;
+    if (esp_http_client_get_header(client, "icy-metaint", &metaint) != ESP_OK || metaint == NULL) {
+        return;
+    }
+    if (!icy_meta_set_interval(&slot->icy, metaint)) {
+        ESP_LOGW(TAG, "Slot %d: invalid icy-metaint '%s', metadata ignored", slot->index, metaint);
+    }
+}
+
+// Ponowne połączenie w tasku http_stream - dekoder dalej opróżnia bufor, więc przerwa
+// krótsza niż zapas audio jest niesłyszalna. Backoff wykładniczy z losowym rozrzutem.
+static bool slot_reconnect(stream_slot_t *slot, esp_http_client_handle_t client, char *buf, int buf_len)
+{
+    bool active = slot->active;
+    int buffered_at_loss = active ? slot->hooks->buffered_ms() : 0;
+    uint32_t backoff = RECONNECT_BACKOFF_MIN_MS;
+
+    ESP_LOGW(TAG, "Slot %d connection lost (%d ms buffered), reconnecting in place",
+             slot->index, buffered_at_loss);
+
+    for (int attempt = 1; slot_wanted(slot) && now_ms() - slot->last_data_ms < RECONNECT_GIVE_UP_MS; attempt++) {
+        // Połowa odstępu stała, połowa losowa - wiele urządzeń nie wraca naraz
+        uint32_t wait = backoff / 2 + esp_random() % (backoff / 2 + 1);
+        if (!slot_wait(slot, wait)) break;
+        backoff = backoff * 2 > RECONNECT_BACKOFF_MAX_MS ? RECONNECT_BACKOFF_MAX_MS : backoff * 2;
+
+        esp_http_client_close(client);
+        bool resume = slot->content_length > 0 && slot->body_pos > 0;
+        if (resume) {
+            char range[40];
+            snprintf(range, sizeof(range), "bytes=%lld-", (long long)slot->body_pos);
+            esp_http_client_set_header(client, "Range", range);
+        }
+
+        esp_http_client_set_timeout_ms(client, HTTP_CONNECT_TIMEOUT_MS);
+        if (esp_http_client_open(client, 0) != ESP_OK) {
+            ESP_LOGW(TAG, "Reconnect attempt %d failed", attempt);
+            continue;
+        }
+        esp_http_client_fetch_headers(client);
+        esp_http_client_set_timeout_ms(client, HTTP_READ_TIMEOUT_MS);
+        int status = esp_http_client_get_status_code(client);
+        if (status != 200 && status != 206) {
+            ESP_LOGW(TAG, "Reconnect attempt %d: HTTP %d", attempt, status);
+            continue;
+        }
+
+        if (resume && status == 200 && !slot_skip_body(slot, client, buf, buf_len)) {
+            continue;
+        }
+        if (!resume) {
+            // Strumień na żywo: nowe połączenie zaczyna nowy cykl icy-metaint
+            icy_meta_reset(&slot->icy, icy_meta_callback, slot);
+            slot_apply_metaint(slot, client);
+        }
+
+        uint32_t gap = now_ms() - slot->last_data_ms;
+        if (active) {
+            slot->hooks->reconnected(gap, buffered_at_loss);
+        }
+        ESP_LOGI(TAG, "Reconnected after %lu ms (attempt %d%s)", (unsigned long)gap, attempt,
+                 resume ? (status == 206 ? ", range resume" : ", skipped to position") : "");
+        return true;
+    }
+
+    return false;
+}
+
+// Hook http_stream: dane czytamy sami - odczyty kończą się na granicy bloku ICY, więc audio
+// trafia do bufora bez kopiowania, a zerwane połączenie jest odnawiane bez zatrzymania pipeline
+static int http_stream_event_handle(http_stream_event_msg_t *msg)
+{
+    stream_slot_t *slot = (stream_slot_t *)msg->user_data;
+
+    if (msg->event_id == HTTP_STREAM_PRE_REQUEST) {
+        // Slot zatrzymany albo stacja już zmieniona - nie otwieraj połączenia, stop nie czeka
+        if (!slot_wanted(slot)) {
+            ESP_LOGI(TAG, "Slot %d: connect cancelled", slot->index);
+            return ESP_FAIL;
+        }
+        slot->probe_done = false;
+        slot->content_length = 0;
+        slot->body_pos = 0;
+        icy_meta_reset(&slot->icy, icy_meta_callback, slot);
+        esp_http_client_set_header(msg->http_client, "Icy-MetaData", "1");
+        esp_http_client_delete_header(msg->http_client, "Range");
+        // Krótki limit na połączenie - nowsza komenda nie czeka długo na zatrzymanie slotu
+        esp_http_client_set_timeout_ms(msg->http_client, HTTP_CONNECT_TIMEOUT_MS);
+        return ESP_OK;
+    }
+
+    if (msg->event_id != HTTP_STREAM_ON_RESPONSE) {
+        return ESP_OK;
+    }
+
+    if (!slot->probe_done && slot->body_pos == 0) {
+        slot->content_length = esp_http_client_get_content_length(msg->http_client);
+        slot->last_data_ms = now_ms();
+        esp_http_client_set_timeout_ms(msg->http_client, HTTP_READ_TIMEOUT_MS);
+        slot_apply_metaint(slot, msg->http_client);
+    }
+
+    uint8_t *buf = (uint8_t *)msg->buffer;
+    int rlen;
+    do {
+        int want = icy_meta_read_size(&slot->icy, msg->buffer_len);
+        rlen = esp_http_client_read(msg->http_client, (char *)buf, want);
+        if (rlen <= 0) {
+            // Koniec pliku - normalne zakończenie
+            if (slot->content_length > 0 && slot->body_pos >= slot->content_length) {
+                return 0;
+            }
+            if (!slot_reconnect(slot, msg->http_client, (char *)buf, msg->buffer_len)) {
+                return rlen;  // Zakończenie elementu - pełny restart w tasku sterującym
+            }
+            continue;
+        }
+        slot->body_pos += rlen;
+        slot->last_data_ms = now_ms();
+        if (slot->active) {
+            pipeline_stats_add_in(PSTAT_HTTP, rlen);
+        }
+        rlen = icy_meta_strip(&slot->icy, buf, rlen);
+    } while (rlen <= 0);  // Odczyt zawierał tylko metadane lub nastąpiło ponowne połączenie
+
+    if (slot->active) {
+        pipeline_stats_add_out(PSTAT_HTTP, rlen);
+        // Bufor HTTP pełny - zapis poczeka na dekoder
+        ringbuf_handle_t out_rb = audio_element_get_output_ringbuf(slot->http);
+        if (out_rb && rb_bytes_available(out_rb) < rlen && player_status->state == PLAYER_STATE_PLAYING) {
+            pipeline_stats_overrun(PSTAT_HTTP);
+        }
+    }
+
+    // Pierwsze dane odpowiedzi - rozpoznanie formatu
+    if (!slot->probe_done) {
+        slot->probe_done = true;
+        probe_stream_codec(slot, buf, rlen);
+    }
+    return rlen;
+}
+
+// ============================================
+// Tworzenie slotu
+// ============================================
+
+esp_err_t stream_slot_init(stream_slot_t *slot, int index, int http_rb_kb,
+                           audio_event_iface_handle_t evt, const stream_slot_hooks_t *hooks)
+{
+    slot->index = index;
+    slot->evt = evt;
+    slot->hooks = hooks;
+
+    // Konfiguracja HTTP stream
+    // Note: HTTPS z pełnym certificate bundle wymaga zbyt dużo pamięci RAM
+    // Dla strumieniów radiowych używamy HTTP lub HTTPS bez weryfikacji certyfikatu
+    http_stream_cfg_t http_cfg = HTTP_STREAM_CFG_DEFAULT();
+    http_cfg.type = AUDIO_STREAM_READER;
+    http_cfg.enable_playlist_parser = true;
+    http_cfg.task_stack = 8 * 1024;  // Increased stack for better network handling
+    http_cfg.out_rb_size = http_rb_kb * 1024;  // 256KB buffer - ~16s at 128kbps (PSRAM)
+    http_cfg.task_prio = 22;  // High priority for HTTP stream
+    http_cfg.task_core = 0;  // Core 0 - together with WiFi for better network I/O
+    // HTTPS: wyłącz weryfikację certyfikatów (oszczędza RAM)
+    http_cfg.crt_bundle_attach = NULL;
+    http_cfg.event_handle = http_stream_event_handle;  // Rozpoznanie formatu strumienia
+    http_cfg.user_data = slot;
+    slot->http = http_stream_init(&http_cfg);
+
+    // Konfiguracja dekodera MP3
+    mp3_decoder_cfg_t mp3_cfg = DEFAULT_MP3_DECODER_CONFIG();
+    mp3_cfg.task_stack = 8 * 1024;
+    mp3_cfg.out_rb_size = 64 * 1024;  // 64KB output buffer (PSRAM)
+    mp3_cfg.task_prio = 22;  // High priority for audio processing
+    mp3_cfg.task_core = 0;   // Core 0 - isolated from WiFi/web on core 0
+    slot->mp3 = mp3_decoder_init(&mp3_cfg);
+
+    // Konfiguracja dekodera AAC (AAC-LC, HE-AAC v1/v2, M4A) - tworzony od razu,
+    // żeby przełączenie formatu nie wymagało alokacji
+    aac_decoder_cfg_t aac_cfg = DEFAULT_AAC_DECODER_CONFIG();
+    aac_cfg.task_stack = 8 * 1024;
+    aac_cfg.out_rb_size = 64 * 1024;  // 64KB output buffer (PSRAM)
+    aac_cfg.task_prio = 22;
+    aac_cfg.task_core = 0;
+    aac_cfg.stack_in_ext = true;
+    aac_cfg.plus_enable = true;  // HE-AAC (SBR/PS) - typowe dla stacji "aacp"
+    slot->aac = aac_decoder_init(&aac_cfg);
+
+    // Wyjście dekodera - czytane przez etap wyjściowy, gdy slot jest aktywny
+    slot->pcm_rb = rb_create(SLOT_PCM_RB_SIZE, 1);
+
+    if (slot->http == NULL || slot->mp3 == NULL || slot->aac == NULL || slot->pcm_rb == NULL) {
+        ESP_LOGE(TAG, "Failed to create stream slot");
+        return ESP_ERR_NO_MEM;
+    }
+
+    audio_pipeline_cfg_t pipeline_cfg = DEFAULT_AUDIO_PIPELINE_CONFIG();
+    pipeline_cfg.rb_size = 128 * 1024;  // 128KB ringbuffer between elements (PSRAM)
+    slot->pipeline = audio_pipeline_init(&pipeline_cfg);
+    if (slot->pipeline == NULL) {
+        ESP_LOGE(TAG, "Failed to create pipeline");
+        return ESP_FAIL;
+    }
+
+    audio_pipeline_register(slot->pipeline, slot->http, "http");
+    audio_pipeline_register(slot->pipeline, slot->mp3, "mp3");
+    audio_pipeline_register(slot->pipeline, slot->aac, "aac");
+
+    // Domyślnie MP3 - format zweryfikowany po pierwszych bajtach strumienia
+    const char *link_tag[2] = {"http", "mp3"};
+    audio_pipeline_link(slot->pipeline, &link_tag[0], 2);
+    slot_attach_decoder_io(slot, slot->mp3);
+    slot->decoder = slot->mp3;
+
+    audio_pipeline_set_listener(slot->pipeline, evt);
+    return ESP_OK;
+}
+
+void stream_slot_deinit(stream_slot_t *slot)
+{
+    if (slot->pipeline == NULL) return;
+
+    audio_pipeline_stop(slot->pipeline);
+    audio_pipeline_wait_for_stop(slot->pipeline);
+    audio_pipeline_terminate(slot->pipeline);
+
+    audio_pipeline_unregister(slot->pipeline, slot->http);
+    audio_pipeline_unregister(slot->pipeline, slot->mp3);
+    audio_pipeline_unregister(slot->pipeline, slot->aac);
+    audio_pipeline_remove_listener(slot->pipeline);
+
+    audio_pipeline_deinit(slot->pipeline);
+    audio_element_deinit(slot->http);
+    audio_element_deinit(slot->mp3);
+    audio_element_deinit(slot->aac);
+    rb_destroy(slot->pcm_rb);
+    memset(slot, 0, sizeof(*slot));
+}
+
+// ============================================
+// Poziom bufora
+// ============================================
+
+int stream_slot_bitrate(const stream_slot_t *slot)
+{
+    return slot->bitrate_kbps > 0 ? slot->bitrate_kbps : DEFAULT_BITRATE_KBPS;
+}
+
+// Ile milisekund audio czeka w slocie: skompresowane dane w buforze HTTP
+// (przeliczone przez bitrate) + PCM za dekoderem
+int stream_slot_buffered_ms(const stream_slot_t *slot)
+{
+    if (slot == NULL || slot->http == NULL) return 0;
+
+    int compressed = rb_filled(audio_element_get_output_ringbuf(slot->http));
+    int pcm = rb_filled(slot->pcm_rb);
+
+    int rate = slot->sample_rate > 0 ? slot->sample_rate : 44100;
+    int channels = slot->channels > 0 ? slot->channels : 2;
+    int pcm_bytes_per_sec = rate * channels * 2;
+
+    return compressed * 8 / stream_slot_bitrate(slot) + (int)((int64_t)pcm * 1000 / pcm_bytes_per_sec);
+}
+
+static int slot_http_rb_size(const stream_slot_t *slot)
+{
+    ringbuf_handle_t rb = audio_element_get_output_ringbuf(slot->http);
+    return rb ? rb_get_size(rb) : HTTP_BUFFER_SIZE_KB * 1024;
+}
+
+// Cel prebufora dla stacji slotu, ograniczony pojemnością bufora HTTP slotu
+int stream_slot_target_ms(const stream_slot_t *slot)
+{
+    int capacity_ms = (int)((int64_t)slot_http_rb_size(slot) * 8 / stream_slot_bitrate(slot));
+    return station_profile_target_ms(slot->profile, capacity_ms);
+}
+
+// Fill level of the HTTP (network) buffer
+int stream_slot_http_percent(const stream_slot_t *slot)
+{
+    ringbuf_handle_t rb = audio_element_get_output_ringbuf(slot->http);
+    if (rb == NULL) return 0;
+
+    int total = rb_get_size(rb);
+    if (total <= 0) return 0;
+    return (rb_bytes_filled(rb) * 100) / total;
+}
+
+// ============================================
+// Warm standby
+// ============================================
+
+// Standby trzyma tylko świeży zapas: nadmiar najstarszych danych HTTP jest odrzucany,
+// więc po przełączeniu gra się bieżąca audycja, a połączenie nie jest dławione
+static void standby_trim(stream_slot_t *slot)
+{
+    static char discard[2048];
+
+    ringbuf_handle_t rb = audio_element_get_output_ringbuf(slot->http);
+    if (rb == NULL) return;
+
+    // Kontener MP4 nie toleruje utraty danych - bufor po prostu się zapełni
+    if (slot->profile && slot->profile->codec == ESP_CODEC_TYPE_M4A) return;
+
+    int keep = (stream_slot_target_ms(slot) + STANDBY_EXTRA_MS) * stream_slot_bitrate(slot) / 8;
+    int excess = rb_bytes_filled(rb) - keep;
+    while (excess > 0) {
+        int chunk = excess < (int)sizeof(discard) ? excess : (int)sizeof(discard);
+        int rlen = rb_read(rb, discard, chunk, 0);
+        if (rlen <= 0) break;
+        excess -= rlen;
+    }
+}
+
+// Po stabilnym starcie połącz następną stację (lub połącz ponownie po błędzie)
+void stream_slot_standby_check(stream_slot_t *standby, uint32_t now, const char *current_url,
+                               uint32_t stable_since_ms)
+{
+    if (standby == NULL || standby_arming) return;
+
+    if (standby->running) {
+        if (standby->decoder && !standby->switch_pending) {
+            standby_trim(standby);
+        }
+        // Przewidziany dla innej stacji - połącz z następną po bieżącej
+        if (standby->armed_for == station_profile_hash(current_url)) {
+            return;
+        }
+    }
+
+    if (now - stable_since_ms < STANDBY_ARM_DELAY_MS ||
+        now - standby_failed_at < standby_retry_ms) {
+        return;
+    }
+
+    standby_arming = true;
+    if (standby->hooks->post(standby, SLOT_EVENT_STANDBY_ARM) != ESP_OK) {
+        standby_arming = false;
+    }
+}
+
+// Połącz standby z następną stacją po bieżącej
+void stream_slot_standby_arm(stream_slot_t *standby, const char *current_url,
+                             const char *next_url, const char *next_name)
+{
+    if (standby && next_url && strcmp(next_url, current_url) != 0) {
+        ESP_LOGI(TAG, "Standby: pre-connecting %s", next_name);
+        standby->armed_for = station_profile_hash(current_url);
+        if (stream_slot_start(standby, next_url) == ESP_OK) {
+            standby_retry_ms = STANDBY_ARM_DELAY_MS;
+        } else {
+            standby_failed_at = now_ms();
+        }
+    }
+
+    standby_arming = false;
+}
+
+// Błąd lub koniec strumienia standby - zwolnij połączenie, ponów później z dłuższym odstępem
+void stream_slot_standby_failed(stream_slot_t *standby)
+{
+    if (standby == NULL || !standby->running) return;
+
+    ESP_LOGW(TAG, "Standby stream failed, retry in %lu s", (unsigned long)(standby_retry_ms / 1000));
+    standby->running = false;
+    standby_failed_at = now_ms();
+    standby_retry_ms = standby_retry_ms * 2 > STANDBY_RETRY_MAX_MS ? STANDBY_RETRY_MAX_MS
+                                                                   : standby_retry_ms * 2;
+    stream_slot_stop(standby);
+}
+
+void stream_slot_standby_reset(void)
+{
+    standby_retry_ms = STANDBY_ARM_DELAY_MS;
+    standby_failed_at = 0;
+}
@@ -0,0 +1,108 @@
+/*
+ * Stream Slot Module
+ * Slot strumienia radia: http -> mp3/aac -> bufor PCM. Etap wyjściowy odtwarzacza czyta
+ * PCM aktywnego slotu, drugi slot (warm standby) trzyma połączenie z następną stacją.
+ * Hook http_stream czyta dane sam: metadane ICY, rozpoznanie formatu i ponowne łączenie
+ * bez zatrzymania pipeline.
+ *
+ * Start, stop i standby tylko z taska sterującego audio_player.c - zdarzenia z taska
+ * http_stream wracają do niego przez hooks->post.
+ */
+
+#ifndef STREAM_SLOT_H
+#define STREAM_SLOT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "audio_pipeline.h"
+#include "audio_element.h"
+#include "audio_event_iface.h"
+#include "ringbuf.h"
+#include "icy_meta.h"
+#include "station_profile.h"
+
+#define STREAM_SLOT_COUNT           2       // Aktywny + opcjonalny warm standby
+#define SLOT_PCM_RB_SIZE            (64 * 1024)     // PCM za dekoderem slotu (PSRAM)
+#define HTTP_BUFFER_SIZE_KB         256     // Bufor HTTP aktywnego slotu
+#define DEFAULT_BITRATE_KBPS        128     // Zanim bitrate zostanie zmierzony
+
+typedef enum {
+    SLOT_EVENT_DECODER_SWITCH,      // Zły dekoder - restart slotu (task http_stream)
+    SLOT_EVENT_TITLE,               // Nowy StreamTitle (task http_stream)
+    SLOT_EVENT_STANDBY_ARM,         // Czas połączyć standby (tick prebufora)
+} stream_slot_event_t;
+
+typedef struct stream_slot stream_slot_t;
+
+// Odtwarzacz dla slotów
+typedef struct {
+    esp_err_t (*post)(stream_slot_t *slot, stream_slot_event_t event);  // Komenda dla taska sterującego
+    int (*buffered_ms)(void);       // Zapas audio przed wyjściem (aktywny slot)
+    void (*reconnected)(uint32_t gap_ms, int buffered_at_loss_ms);      // Aktywny slot, statystyki
+    bool (*superseded)(void);       // Czeka nowsze żądanie odtwarzania (task http_stream)
+} stream_slot_hooks_t;
+
+struct stream_slot {
+    audio_pipeline_handle_t pipeline;
+    audio_element_handle_t http;
+    audio_element_handle_t mp3;
+    audio_element_handle_t aac;
+    audio_element_handle_t decoder;         // Aktualnie podłączony dekoder
+    ringbuf_handle_t pcm_rb;
+    int index;
+    volatile bool active;                   // Czytany przez etap wyjściowy; inaczej standby
+    char url[512];
+    station_profile_t *profile;
+    volatile bool running;
+    volatile bool probe_done;
+    volatile bool switch_pending;           // Restart z innym dekoderem zaplanowany
+    volatile int bitrate_kbps;
+    int sample_rate;
+    int channels;
+    int bits;
+    uint32_t armed_for;                     // Standby: hash URL stacji, dla której przewidziano
+    icy_meta_t icy;                         // Metadane przeplatane ze strumieniem
+    char icy_title[128];                    // Ostatni StreamTitle slotu
+    char icy_artist[128];
+    int64_t content_length;                 // > 0 - plik skończony, wznowienie przez Range
+    int64_t body_pos;                       // Bajty body odebrane od początku
+    uint32_t last_data_ms;                  // Ostatni udany odczyt (początek przerwy)
+    uint32_t generation;                    // Zwiększany przy każdym starcie - odrzuca stare komendy
+    uint32_t io_mark;                       // Cykle CPU: koniec ostatniego odczytu/zapisu dekodera
+    uint32_t decode_cycles;                 // Cykle dekodowania od ostatniej ramki
+    audio_event_iface_handle_t evt;
+    const stream_slot_hooks_t *hooks;
+};
+
+// Tworzy slot: http (bufor http_rb_kb) + oba dekodery + bufor PCM, połączone http -> mp3
+esp_err_t stream_slot_init(stream_slot_t *slot, int index, int http_rb_kb,
+                           audio_event_iface_handle_t evt, const stream_slot_hooks_t *hooks);
+void stream_slot_deinit(stream_slot_t *slot);
+
+// (Re)start z podanym URL, dekoder według profilu stacji. Slot nieaktywny (standby)
+// łączy się, ale dekoder rusza dopiero po stream_slot_resume_decoder().
+esp_err_t stream_slot_start(stream_slot_t *slot, const char *url);
+void stream_slot_stop(stream_slot_t *slot);
+void stream_slot_resume_decoder(stream_slot_t *slot);
+
+bool stream_slot_owns(const stream_slot_t *slot, void *el);
+
+// Music info z elementu slotu (task zdarzeń); true - znany format PCM
+bool stream_slot_music_info(stream_slot_t *slot, audio_element_handle_t el);
+
+int stream_slot_bitrate(const stream_slot_t *slot);
+int stream_slot_buffered_ms(const stream_slot_t *slot);    // Skompresowane (przez bitrate) + PCM
+int stream_slot_target_ms(const stream_slot_t *slot);      // Cel prebufora stacji
+int stream_slot_http_percent(const stream_slot_t *slot);
+
+// Warm standby: ponowne próby z rosnącym odstępem. Wszystko z taska sterującego: check -
+// tick prebufora przy stabilnym odtwarzaniu radia. next_url NULL - brak następnej stacji.
+void stream_slot_standby_check(stream_slot_t *standby, uint32_t now, const char *current_url,
+                               uint32_t stable_since_ms);
+void stream_slot_standby_arm(stream_slot_t *standby, const char *current_url,
+                             const char *next_url, const char *next_name);
+void stream_slot_standby_failed(stream_slot_t *standby);
+void stream_slot_standby_reset(void);       // Po przełączeniu na standby
+
+#endif // STREAM_SLOT_H
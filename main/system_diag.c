@@ -7,6 +7,9 @@
 #include "esp_heap_caps.h"
 #include "esp_timer.h"
 #include "cJSON.h"
+#include "audio_player.h"
+#include "eq_filter.h"
+#include "pipeline_stats.h"
 
 char* system_diag_get_json(void)
 {
@@ -63,6 +66,116 @@ char* system_diag_get_json(void)
     cJSON_AddItemToObject(root, "tasks", tasks);
 #endif
 
+    // Bufor strumienia (adaptacyjny prebuffer)
+    player_buffer_stats_t buf_stats;
+    audio_player_get_buffer_stats(&buf_stats);
+    cJSON *stream = cJSON_CreateObject();
+    cJSON_AddNumberToObject(stream, "bitrate_kbps", buf_stats.bitrate_kbps);
+    cJSON_AddNumberToObject(stream, "buffered_ms", buf_stats.buffered_ms);
+    cJSON_AddNumberToObject(stream, "target_ms", buf_stats.target_ms);
+    cJSON_AddNumberToObject(stream, "underruns", buf_stats.underruns);
+    cJSON_AddNumberToObject(stream, "prebuffer_ms", buf_stats.prebuffer_ms);
+    cJSON_AddNumberToObject(stream, "reconnects", buf_stats.reconnects);
+    cJSON_AddNumberToObject(stream, "reconnects_audible", buf_stats.reconnects_audible);
+    cJSON_AddNumberToObject(stream, "reconnect_last_gap_ms", buf_stats.reconnect_last_gap_ms);
+    cJSON_AddNumberToObject(stream, "reconnect_max_gap_ms", buf_stats.reconnect_max_gap_ms);
+    cJSON_AddNumberToObject(stream, "drift_ppm", buf_stats.drift_ppm);
+    cJSON_AddBoolToObject(stream, "drift_locked", buf_stats.drift_locked);
+    cJSON_AddNumberToObject(stream, "drift_setpoint_ms", buf_stats.drift_setpoint_ms);
+    cJSON_AddNumberToObject(stream, "drift_level_ms", buf_stats.drift_level_ms);
+    cJSON_AddItemToObject(root, "stream", stream);
+
+    // Przełączanie stacji i warm standby
+    player_switch_stats_t sw;
+    audio_player_get_switch_stats(&sw);
+    cJSON *switch_obj = cJSON_CreateObject();
+    cJSON_AddNumberToObject(switch_obj, "last_ms", sw.last_ms);
+    cJSON_AddBoolToObject(switch_obj, "last_warm", sw.last_warm);
+    cJSON_AddBoolToObject(switch_obj, "standby_enabled", sw.standby_enabled);
+    cJSON_AddNumberToObject(switch_obj, "standby_budget_kb", sw.standby_budget_kb);
+    cJSON_AddBoolToObject(switch_obj, "standby_ready", sw.standby_ready);
+    cJSON_AddNumberToObject(switch_obj, "standby_buffered_ms", sw.standby_buffered_ms);
+    cJSON_AddStringToObject(switch_obj, "standby_url", sw.standby_url);
+    cJSON_AddNumberToObject(switch_obj, "standby_hits", sw.standby_hits);
+    cJSON_AddNumberToObject(switch_obj, "standby_misses", sw.standby_misses);
+    cJSON_AddItemToObject(root, "switch", switch_obj);
+
+    // Sesja od ostatniego resetu (POST /api/system/diag/reset)
+    player_session_stats_t ses;
+    audio_player_get_session_stats(&ses);
+    cJSON *session = cJSON_CreateObject();
+    cJSON_AddNumberToObject(session, "since_ms", ses.since_ms);
+    cJSON_AddNumberToObject(session, "starts", ses.starts);
+    cJSON_AddNumberToObject(session, "first_audio_last_ms", ses.first_audio_last_ms);
+    cJSON_AddNumberToObject(session, "first_audio_avg_ms", ses.first_audio_avg_ms);
+    cJSON_AddNumberToObject(session, "first_audio_max_ms", ses.first_audio_max_ms);
+    cJSON_AddNumberToObject(session, "underruns", ses.underruns);
+    cJSON_AddNumberToObject(session, "rebuffer_ms", ses.rebuffer_ms);
+    cJSON_AddNumberToObject(session, "rebuffer_max_ms", ses.rebuffer_max_ms);
+    cJSON_AddNumberToObject(session, "reconnects", ses.reconnects);
+    cJSON_AddNumberToObject(session, "reconnect_max_gap_ms", ses.reconnect_max_gap_ms);
+    cJSON_AddNumberToObject(session, "min_free_internal", ses.min_free_internal);
+    cJSON_AddNumberToObject(session, "min_free_psram", ses.min_free_psram);
+    cJSON_AddItemToObject(root, "session", session);
+
+    // Tor SD: czy odczyt z karty i dekoder nadążają za I2S
+    player_sd_stats_t sd;
+    audio_player_get_sd_stats(&sd);
+    cJSON *sd_obj = cJSON_CreateObject();
+    cJSON_AddBoolToObject(sd_obj, "active", sd.active);
+    cJSON_AddStringToObject(sd_obj, "codec", sd.codec);
+    cJSON_AddNumberToObject(sd_obj, "read_block_kb", sd.read_block_kb);
+    cJSON_AddNumberToObject(sd_obj, "read_kbps", sd.read_kbps);
+    cJSON_AddNumberToObject(sd_obj, "read_busy_permille", sd.read_busy_permille);
+    cJSON_AddNumberToObject(sd_obj, "decode_permille", sd.decode_permille);
+    cJSON_AddNumberToObject(sd_obj, "consume_kbps", sd.consume_kbps);
+    cJSON_AddNumberToObject(sd_obj, "buffered_ms", sd.buffered_ms);
+    cJSON_AddNumberToObject(sd_obj, "seeks", sd.seeks);
+    cJSON_AddNumberToObject(sd_obj, "last_seek_ms", sd.last_seek_ms);
+    cJSON_AddNumberToObject(sd_obj, "max_seek_ms", sd.max_seek_ms);
+    cJSON_AddNumberToObject(sd_obj, "gapless", sd.gapless);
+    cJSON_AddItemToObject(root, "sd", sd_obj);
+
+    // Telemetria elementów pipeline (ostatnia sekunda)
+    cJSON *pipeline = cJSON_CreateArray();
+    for (int el = 0; el < PSTAT_ELEMENT_COUNT; el++) {
+        pstat_element_info_t info;
+        pipeline_stats_get(el, &info);
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddStringToObject(item, "name", pipeline_stats_name(el));
+        cJSON_AddNumberToObject(item, "in_bps", info.in_bps);
+        cJSON_AddNumberToObject(item, "out_bps", info.out_bps);
+        cJSON_AddNumberToObject(item, "fill_min", info.fill_min);
+        cJSON_AddNumberToObject(item, "fill_max", info.fill_max);
+        cJSON_AddNumberToObject(item, "fill_size", info.fill_size);
+        cJSON_AddNumberToObject(item, "underruns", info.underruns);
+        cJSON_AddNumberToObject(item, "overruns", info.overruns);
+        cJSON_AddItemToArray(pipeline, item);
+    }
+    cJSON_AddItemToObject(root, "pipeline", pipeline);
+
+    // Czas dekodowania ramki - histogram log2 (kubełek i: 2^i..2^(i+1) µs)
+    uint32_t hist[PSTAT_HIST_BUCKETS];
+    pipeline_stats_get_histogram(hist);
+    cJSON *decode = cJSON_CreateObject();
+    cJSON *buckets = cJSON_CreateArray();
+    for (int b = 0; b < PSTAT_HIST_BUCKETS; b++) {
+        cJSON_AddItemToArray(buckets, cJSON_CreateNumber(hist[b]));
+    }
+    cJSON_AddItemToObject(decode, "hist_log2_us", buckets);
+    cJSON_AddNumberToObject(decode, "p50_us", pipeline_stats_decode_percentile(50));
+    cJSON_AddNumberToObject(decode, "p99_us", pipeline_stats_decode_percentile(99));
+    cJSON_AddItemToObject(root, "decode", decode);
+
+    // Equalizer (eq_filter) - obciążenie CPU w promilach jednego rdzenia
+    audio_element_handle_t eq = audio_player_get_equalizer();
+    if (eq) {
+        cJSON *eq_obj = cJSON_CreateObject();
+        cJSON_AddNumberToObject(eq_obj, "load_permille", eq_filter_get_load_permille(eq));
+        cJSON_AddNumberToObject(eq_obj, "active_bands", eq_filter_get_active_bands(eq));
+        cJSON_AddItemToObject(root, "eq", eq_obj);
+    }
+
     cJSON_AddNumberToObject(root, "uptime_ms", (uint32_t)(esp_timer_get_time() / 1000));
 
     char *json = cJSON_PrintUnformatted(root);
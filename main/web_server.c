@@ -3,6 +3,10 @@
  * HTTP server with REST API and WebSocket support
  */
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <ctype.h>
 #include <string.h>
 #include <sys/param.h>
 #include <sys/socket.h>
@@ -28,6 +32,7 @@
 #include "input_controls.h"
 #include "bluetooth_sink.h"
 #include "sdcard_player.h"
+#include "media_index.h"
 #include "aux_input.h"
 #include "battery_monitor.h"
 #include "piped_client.h"
@@ -104,10 +109,11 @@ static esp_err_t api_status_handler(httpd_req_t *req)
     add_cors_headers(req);
     httpd_resp_set_type(req, "application/json");
 
-    player_status_t *status = audio_player_get_status();
+    player_status_t status;
+    audio_player_get_status(&status);
 
     const char *state_str = "idle";
-    switch (status->state) {
+    switch (status.state) {
         case PLAYER_STATE_BUFFERING: state_str = "buffering"; break;
         case PLAYER_STATE_PLAYING: state_str = "playing"; break;
         case PLAYER_STATE_PAUSED:  state_str = "paused"; break;
@@ -117,12 +123,15 @@ static esp_err_t api_status_handler(httpd_req_t *req)
 
     cJSON *root = cJSON_CreateObject();
     cJSON_AddStringToObject(root, "state", state_str);
-    cJSON_AddNumberToObject(root, "volume", status->volume);
-    cJSON_AddBoolToObject(root, "muted", status->muted);
-    cJSON_AddStringToObject(root, "url", status->current_url);
-    cJSON_AddStringToObject(root, "title", status->current_title);
-    cJSON_AddStringToObject(root, "artist", status->current_artist);
-    cJSON_AddStringToObject(root, "ip", wifi_manager_get_ip());
+    cJSON_AddNumberToObject(root, "volume", status.volume);
+    cJSON_AddBoolToObject(root, "muted", status.muted);
+    cJSON_AddStringToObject(root, "url", status.current_url);
+    cJSON_AddStringToObject(root, "title", status.current_title);
+    cJSON_AddStringToObject(root, "artist", status.current_artist);
+    cJSON_AddStringToObject(root, "album", status.current_album);
+    cJSON_AddNumberToObject(root, "duration_ms", status.duration_ms);
+    cJSON_AddNumberToObject(root, "position_ms", status.source == AUDIO_SOURCE_BLUETOOTH ?
+                            audio_player_status_position_ms(&status) : audio_player_get_position_ms());
     cJSON_AddNumberToObject(root, "rssi", wifi_manager_get_rssi());
     cJSON_AddNumberToObject(root, "buffer_level", audio_player_get_buffer_level());
 
@@ -1108,6 +1117,21 @@ static esp_err_t api_bluetooth_handler(httpd_req_t *req)
             cJSON_AddStringToObject(root, "artist", track->artist);
             cJSON_AddStringToObject(root, "album", track->album);
         }
+
+        bt_sink_stats_t stats;
+        bluetooth_sink_get_stats(&stats);
+        cJSON *pipe = cJSON_CreateObject();
+        cJSON_AddNumberToObject(pipe, "latency_ms", stats.latency_ms);
+        cJSON_AddNumberToObject(pipe, "depth_ms", stats.depth_ms);
+        cJSON_AddNumberToObject(pipe, "target_ms", stats.target_ms);
+        cJSON_AddNumberToObject(pipe, "jitter_ms", stats.jitter_ms);
+        cJSON_AddNumberToObject(pipe, "sample_rate", stats.sample_rate);
+        cJSON_AddNumberToObject(pipe, "packets", stats.packets);
+        cJSON_AddNumberToObject(pipe, "late", stats.late);
+        cJSON_AddNumberToObject(pipe, "lost", stats.lost);
+        cJSON_AddNumberToObject(pipe, "underruns", stats.underruns);
+        cJSON_AddNumberToObject(pipe, "slipped", stats.slipped);
+        cJSON_AddItemToObject(root, "pipeline", pipe);
     }
 
     char *json = cJSON_PrintUnformatted(root);
@@ -1200,52 +1224,189 @@ static esp_err_t api_sdcard_status_handler(httpd_req_t *req)
     return ESP_OK;
 }
 
+// Dekodowanie %XX i '+' w parametrze zapytania (nazwy wykonawców/albumów)
+static void url_decode_inplace(char *s)
+{
+    char *out = s;
+    for (; *s; s++) {
+        if (*s == '+') {
+            *out++ = ' ';
+        } else if (*s == '%' && isxdigit((unsigned char)s[1]) && isxdigit((unsigned char)s[2])) {
+            char hex[3] = { s[1], s[2], '\0' };
+            *out++ = (char)strtol(hex, NULL, 16);
+            s += 2;
+        } else {
+            *out++ = *s;
+        }
+    }
+    *out = '\0';
+}
+
+// JSON pisany wprost do gniazda (chunked) - pamięć stała niezależnie od liczby wpisów
+typedef struct {
+    httpd_req_t *req;
+    char buf[1024];
+    size_t len;
+    bool failed;
+} json_chunk_writer_t;
+
+static void chunk_flush(json_chunk_writer_t *w)
+{
+    if (w->len && !w->failed && httpd_resp_send_chunk(w->req, w->buf, w->len) != ESP_OK) {
+        w->failed = true;  // Klient zamknął połączenie
+    }
+    w->len = 0;
+}
+
+static void chunk_write(json_chunk_writer_t *w, const char *data, size_t len)
+{
+    while (len > 0 && !w->failed) {
+        size_t n = MIN(len, sizeof(w->buf) - w->len);
+        memcpy(w->buf + w->len, data, n);
+        w->len += n;
+        data += n;
+        len -= n;
+        if (w->len == sizeof(w->buf)) {
+            chunk_flush(w);
+        }
+    }
+}
+
+#define chunk_write_literal(w, s)   chunk_write((w), (s), sizeof(s) - 1)
+
+static void chunk_printf(json_chunk_writer_t *w, const char *fmt, ...)
+{
+    char tmp[96];
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(tmp, sizeof(tmp), fmt, args);
+    va_end(args);
+    if (len > 0) {
+        chunk_write(w, tmp, MIN(len, (int)sizeof(tmp) - 1));
+    }
+}
+
+// Napis JSON w cudzysłowach (nazwy plików mogą zawierać " i \)
+static void chunk_write_string(json_chunk_writer_t *w, const char *s)
+{
+    chunk_write_literal(w, "\"");
+    const char *run = s;
+    for (; *s; s++) {
+        unsigned char c = *s;
+        if (c != '"' && c != '\\' && c >= 0x20) continue;
+        chunk_write(w, run, s - run);
+        if (c == '"' || c == '\\') {
+            char esc[2] = { '\\', c };
+            chunk_write(w, esc, 2);
+        } else {
+            chunk_printf(w, "\\u%04x", c);
+        }
+        run = s + 1;
+    }
+    chunk_write(w, run, s - run);
+    chunk_write_literal(w, "\"");
+}
+
+typedef struct {
+    json_chunk_writer_t writer;
+    bool with_sizes;
+    int count;
+} browse_ctx_t;
+
+static bool browse_entry_cb(const sd_file_info_t *entry, void *arg)
+{
+    browse_ctx_t *ctx = arg;
+    json_chunk_writer_t *w = &ctx->writer;
+
+    if (ctx->count) {
+        chunk_write_literal(w, ",");
+    }
+    chunk_write_literal(w, "{\"name\":");
+    chunk_write_string(w, entry->filename);
+    chunk_write_literal(w, ",\"path\":");
+    chunk_write_string(w, entry->filepath);
+    if (entry->is_directory) {
+        chunk_write_literal(w, ",\"is_dir\":true}");
+    } else {
+        chunk_write_literal(w, ",\"is_dir\":false,\"title\":");
+        chunk_write_string(w, entry->title);
+        if (entry->artist[0]) {
+            chunk_write_literal(w, ",\"artist\":");
+            chunk_write_string(w, entry->artist);
+        }
+        if (ctx->with_sizes || entry->file_size) {
+            chunk_printf(w, ",\"size\":%lu", (unsigned long)entry->file_size);
+        }
+        chunk_write_literal(w, "}");
+    }
+    ctx->count++;
+    return !w->failed;
+}
+
+// GET /api/sdcard/browse?path=/muzyka&limit=100&cursor=N&sizes=1
+// Strona katalogu; "cursor" z odpowiedzi pobiera następną (brak - koniec katalogu).
 static esp_err_t api_sdcard_browse_handler(httpd_req_t *req)
 {
     add_cors_headers(req);
     httpd_resp_set_type(req, "application/json");
 
-    // Get path from query string
     char path[256] = "/";
-    char query[256];
-    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
-        char param[256];
-        if (httpd_query_key_value(query, "path", param, sizeof(param)) == ESP_OK) {
-            strncpy(path, param, sizeof(path) - 1);
+    char num[16];
+    uint32_t cursor = 0;
+    int limit = 100;
+    bool with_sizes = false;
+
+    size_t buf_len = httpd_req_get_url_query_len(req) + 1;
+    if (buf_len > 1) {
+        char *buf = malloc(buf_len);
+        if (buf && httpd_req_get_url_query_str(req, buf, buf_len) == ESP_OK) {
+            httpd_query_key_value(buf, "path", path, sizeof(path));
+            if (httpd_query_key_value(buf, "cursor", num, sizeof(num)) == ESP_OK) {
+                cursor = strtoul(num, NULL, 10);
+            }
+            if (httpd_query_key_value(buf, "limit", num, sizeof(num)) == ESP_OK) {
+                limit = atoi(num);
+            }
+            if (httpd_query_key_value(buf, "sizes", num, sizeof(num)) == ESP_OK) {
+                with_sizes = (num[0] == '1' || num[0] == 't');
+            }
         }
+        free(buf);
     }
+    url_decode_inplace(path);
+    if (limit <= 0 || limit > 500) limit = 100;
 
-    sd_file_info_t *files;
-    int count;
-    esp_err_t ret = sdcard_player_scan_directory(path, &files, &count);
+    browse_ctx_t *ctx = calloc(1, sizeof(browse_ctx_t));
+    if (ctx == NULL) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+        return ESP_FAIL;
+    }
+    ctx->writer.req = req;
+    ctx->with_sizes = with_sizes;
+    json_chunk_writer_t *w = &ctx->writer;
 
-    cJSON *root = cJSON_CreateObject();
-    cJSON_AddStringToObject(root, "path", path);
-
-    if (ret == ESP_OK) {
-        cJSON *items = cJSON_CreateArray();
-        for (int i = 0; i < count; i++) {
-            cJSON *item = cJSON_CreateObject();
-            cJSON_AddStringToObject(item, "name", files[i].filename);
-            cJSON_AddStringToObject(item, "path", files[i].filepath);
-            cJSON_AddBoolToObject(item, "is_dir", files[i].is_directory);
-            if (!files[i].is_directory) {
-                cJSON_AddNumberToObject(item, "size", files[i].file_size);
-            }
-            cJSON_AddItemToArray(items, item);
-        }
-        cJSON_AddItemToObject(root, "files", items);
-        cJSON_AddNumberToObject(root, "count", count);
-        sdcard_player_free_file_list(files, count);
-    } else {
-        cJSON_AddStringToObject(root, "error", "Failed to read directory");
+    chunk_write_literal(w, "{\"path\":");
+    chunk_write_string(w, path);
+    chunk_write_literal(w, ",\"files\":[");
+
+    int total = 0;
+    esp_err_t ret = sdcard_player_browse(path, &cursor, limit, with_sizes, browse_entry_cb, ctx, &total);
+
+    chunk_printf(w, "],\"count\":%d,\"total\":%d", ctx->count, total);
+    if (ret != ESP_OK) {
+        chunk_write_literal(w, ",\"error\":\"Failed to read directory\"");
+    } else if (cursor) {
+        chunk_printf(w, ",\"cursor\":%lu", (unsigned long)cursor);
     }
+    chunk_write_literal(w, "}");
+    chunk_flush(w);
 
-    char *json = cJSON_PrintUnformatted(root);
-    httpd_resp_sendstr(req, json);
-    free(json);
-    cJSON_Delete(root);
-    return ESP_OK;
+    bool failed = w->failed;
+    free(ctx);
+    if (!failed) {
+        httpd_resp_send_chunk(req, NULL, 0);
+    }
+    return failed ? ESP_FAIL : ESP_OK;
 }
 
 static esp_err_t api_sdcard_play_handler(httpd_req_t *req)
@@ -1265,12 +1426,17 @@ static esp_err_t api_sdcard_play_handler(httpd_req_t *req)
     if (root) {
         cJSON *path = cJSON_GetObjectItem(root, "path");
         cJSON *action = cJSON_GetObjectItem(root, "action");
+        cJSON *value = cJSON_GetObjectItem(root, "value");  // Wykonawca/album dla play_artist/play_album
 
         if (action && cJSON_IsString(action)) {
             if (strcmp(action->valuestring, "play") == 0 && path) {
                 sdcard_player_play_file(path->valuestring);
             } else if (strcmp(action->valuestring, "play_dir") == 0 && path) {
                 sdcard_player_play_directory(path->valuestring);
+            } else if (strcmp(action->valuestring, "play_artist") == 0 && cJSON_IsString(value)) {
+                sdcard_player_play_artist(value->valuestring);
+            } else if (strcmp(action->valuestring, "play_album") == 0 && cJSON_IsString(value)) {
+                sdcard_player_play_album(value->valuestring);
             } else if (strcmp(action->valuestring, "pause") == 0) {
                 sdcard_player_pause();
             } else if (strcmp(action->valuestring, "resume") == 0) {
@@ -1281,6 +1447,11 @@ static esp_err_t api_sdcard_play_handler(httpd_req_t *req)
                 sdcard_player_next();
             } else if (strcmp(action->valuestring, "prev") == 0) {
                 sdcard_player_prev();
+            } else if (strcmp(action->valuestring, "seek") == 0) {
+                cJSON *position = cJSON_GetObjectItem(root, "position_ms");
+                if (position && cJSON_IsNumber(position) && position->valueint >= 0) {
+                    sdcard_player_seek(position->valueint);
+                }
             } else if (strcmp(action->valuestring, "mode") == 0) {
                 cJSON *mode = cJSON_GetObjectItem(root, "mode");
                 if (mode && cJSON_IsNumber(mode)) {
@@ -1295,6 +1466,120 @@ static esp_err_t api_sdcard_play_handler(httpd_req_t *req)
     return ESP_OK;
 }
 
+static void library_add_value(const char *value, void *ctx)
+{
+    cJSON_AddItemToArray((cJSON *)ctx, cJSON_CreateString(value));
+}
+
+// GET /api/sdcard/library
+//   ?field=artist|album       - lista wykonawców/albumów
+//   ?q=tekst                  - wyszukiwanie w tytule, wykonawcy, albumie i nazwie pliku
+//   ?artist=X / ?album=X      - utwory wykonawcy / albumu
+//   &offset=N&limit=N         - stronicowanie (domyślnie 0 i 100)
+static esp_err_t api_sdcard_library_handler(httpd_req_t *req)
+{
+    add_cors_headers(req);
+    httpd_resp_set_type(req, "application/json");
+
+    char field[16] = {0};
+    char value[160] = {0};
+    char num[12];
+    media_field_t find_field = MEDIA_FIELD_ANY;
+    bool exact = false;
+    int offset = 0;
+    int limit = 100;
+
+    size_t buf_len = httpd_req_get_url_query_len(req) + 1;
+    if (buf_len > 1) {
+        char *buf = malloc(buf_len);
+        if (buf && httpd_req_get_url_query_str(req, buf, buf_len) == ESP_OK) {
+            httpd_query_key_value(buf, "field", field, sizeof(field));
+            if (httpd_query_key_value(buf, "artist", value, sizeof(value)) == ESP_OK) {
+                find_field = MEDIA_FIELD_ARTIST;
+                exact = true;
+            } else if (httpd_query_key_value(buf, "album", value, sizeof(value)) == ESP_OK) {
+                find_field = MEDIA_FIELD_ALBUM;
+                exact = true;
+            } else {
+                httpd_query_key_value(buf, "q", value, sizeof(value));
+            }
+            if (httpd_query_key_value(buf, "offset", num, sizeof(num)) == ESP_OK) {
+                offset = atoi(num);
+            }
+            if (httpd_query_key_value(buf, "limit", num, sizeof(num)) == ESP_OK) {
+                limit = atoi(num);
+            }
+        }
+        free(buf);
+    }
+    url_decode_inplace(value);
+    if (offset < 0) offset = 0;
+    if (limit <= 0 || limit > 500) limit = 100;
+
+    cJSON *root = cJSON_CreateObject();
+
+    media_index_status_t status;
+    media_index_get_status(&status);
+    cJSON *index = cJSON_CreateObject();
+    cJSON_AddBoolToObject(index, "ready", status.ready);
+    cJSON_AddBoolToObject(index, "scanning", status.scanning);
+    cJSON_AddNumberToObject(index, "dirs", status.dirs);
+    cJSON_AddNumberToObject(index, "tracks", status.tracks);
+    cJSON_AddNumberToObject(index, "bytes", status.index_bytes);
+    cJSON_AddNumberToObject(index, "scan_dirs", status.scan_dirs);
+    cJSON_AddNumberToObject(index, "scan_parsed", status.scan_parsed);
+    cJSON_AddNumberToObject(index, "last_scan_ms", status.last_scan_ms);
+    cJSON_AddItemToObject(root, "index", index);
+
+    if (strcmp(field, "artist") == 0 || strcmp(field, "album") == 0) {
+        cJSON *values = cJSON_CreateArray();
+        int total = media_index_list_values(field[1] == 'r' ? MEDIA_FIELD_ARTIST : MEDIA_FIELD_ALBUM,
+                                            offset, limit, library_add_value, values);
+        cJSON_AddItemToObject(root, "values", values);
+        cJSON_AddNumberToObject(root, "total", total > 0 ? total : 0);
+    } else if (value[0]) {
+        sd_file_info_t *files = NULL;
+        int count = 0, total = 0;
+        if (media_index_find(find_field, value, exact, offset, limit, &files, &count, &total) == ESP_OK) {
+            cJSON *tracks = cJSON_CreateArray();
+            for (int i = 0; i < count; i++) {
+                cJSON *item = cJSON_CreateObject();
+                cJSON_AddStringToObject(item, "path", files[i].filepath);
+                cJSON_AddStringToObject(item, "title", files[i].title);
+                cJSON_AddStringToObject(item, "artist", files[i].artist);
+                cJSON_AddStringToObject(item, "album", files[i].album);
+                cJSON_AddNumberToObject(item, "duration_ms", files[i].duration_ms);
+                cJSON_AddItemToArray(tracks, item);
+            }
+            cJSON_AddItemToObject(root, "tracks", tracks);
+            cJSON_AddNumberToObject(root, "total", total);
+            sdcard_player_free_file_list(files, count);
+        } else {
+            cJSON_AddStringToObject(root, "error", "Library index not ready");
+        }
+    }
+
+    char *json = cJSON_PrintUnformatted(root);
+    httpd_resp_sendstr(req, json);
+    free(json);
+    cJSON_Delete(root);
+    return ESP_OK;
+}
+
+// POST /api/sdcard/library - ponowny skan karty (przyrostowy)
+static esp_err_t api_sdcard_rescan_handler(httpd_req_t *req)
+{
+    add_cors_headers(req);
+    httpd_resp_set_type(req, "application/json");
+
+    if (media_index_rescan() != ESP_OK) {
+        httpd_resp_sendstr(req, "{\"status\":\"error\",\"message\":\"SD card not mounted\"}");
+        return ESP_OK;
+    }
+    httpd_resp_sendstr(req, "{\"status\":\"ok\"}");
+    return ESP_OK;
+}
+
 // ============================================
 // API handlers - AUX Input
 // ============================================
@@ -1314,13 +1599,19 @@ static esp_err_t api_aux_handler(httpd_req_t *req)
         cJSON_AddBoolToObject(root, "active", aux_input_is_active());
         cJSON_AddNumberToObject(root, "gain", aux_input_get_gain());
         cJSON_AddNumberToObject(root, "signal_level", aux_input_get_signal_level());
+        cJSON_AddNumberToObject(root, "rms_db", aux_input_get_rms_db());
+        cJSON_AddNumberToObject(root, "peak_db", aux_input_get_peak_db());
+        cJSON_AddNumberToObject(root, "clipped", aux_input_get_clipped());
+        cJSON_AddBoolToObject(root, "auto_switch", aux_input_get_auto_switch());
+        cJSON_AddNumberToObject(root, "threshold_db", aux_input_get_threshold());
+        cJSON_AddNumberToObject(root, "silence_ms", aux_input_get_silence_ms());
 
         char *json = cJSON_PrintUnformatted(root);
         httpd_resp_sendstr(req, json);
         free(json);
         cJSON_Delete(root);
     } else {
-        char content[128];
+        char content[192];
         int ret = httpd_req_recv(req, content, sizeof(content) - 1);
         if (ret <= 0) {
             httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "No content");
@@ -1336,12 +1627,28 @@ static esp_err_t api_aux_handler(httpd_req_t *req)
                     aux_input_enable();
                 } else if (strcmp(action->valuestring, "disable") == 0) {
                     aux_input_disable();
+                } else if (strcmp(action->valuestring, "play") == 0) {
+                    audio_player_play_aux();
+                } else if (strcmp(action->valuestring, "stop") == 0) {
+                    audio_player_stop_aux();
                 }
             }
             cJSON *gain = cJSON_GetObjectItem(root, "gain");
             if (gain && cJSON_IsNumber(gain)) {
                 aux_input_set_gain(gain->valueint);
             }
+            cJSON *auto_switch = cJSON_GetObjectItem(root, "auto_switch");
+            if (auto_switch && cJSON_IsBool(auto_switch)) {
+                aux_input_set_auto_switch(cJSON_IsTrue(auto_switch));
+            }
+            cJSON *threshold = cJSON_GetObjectItem(root, "threshold_db");
+            if (threshold && cJSON_IsNumber(threshold)) {
+                aux_input_set_threshold(threshold->valueint);
+            }
+            cJSON *silence = cJSON_GetObjectItem(root, "silence_ms");
+            if (silence && cJSON_IsNumber(silence)) {
+                aux_input_set_silence_ms((uint32_t)silence->valuedouble);
+            }
             cJSON_Delete(root);
         }
         httpd_resp_sendstr(req, "{\"status\":\"ok\"}");
@@ -1447,6 +1754,15 @@ static esp_err_t api_system_diag_handler(httpd_req_t *req) {
     return ESP_OK;
 }
 
+// Początek nowej sesji pomiarowej (np. przed przebiegiem testu długotrwałego)
+static esp_err_t api_system_diag_reset_handler(httpd_req_t *req) {
+    add_cors_headers(req);
+    httpd_resp_set_type(req, "application/json");
+    audio_player_reset_session_stats();
+    httpd_resp_sendstr(req, "{\"success\":true}");
+    return ESP_OK;
+}
+
 // API handlers - Piped (YouTube Music)
 // ============================================
 
@@ -1882,7 +2198,7 @@ static esp_err_t api_bt_source_status_handler(httpd_req_t *req)
 
     const bt_source_status_t *status = bt_source_get_status();
 
-    char json[512];
+    char json[640];
     char connected_bda[18] = "";
     if (bt_source_is_connected()) {
         bt_source_bda_to_str(status->connected_device.bda, connected_bda);
@@ -1891,7 +2207,11 @@ static esp_err_t api_bt_source_status_handler(httpd_req_t *req)
     snprintf(json, sizeof(json),
         "{\"initialized\":%s,\"state\":\"%s\",\"connected\":%s,\"streaming\":%s,"
         "\"device_name\":\"%s\",\"device_bda\":\"%s\","
-        "\"device_count\":%d,\"volume\":%d,\"error\":\"%s\"}",
+        "\"device_count\":%d,\"volume\":%d,\"error\":\"%s\","
+        "\"output\":\"%s\",\"underruns\":%lu,\"callbacks\":%lu,"
+        "\"partial_callbacks\":%lu,\"empty_callbacks\":%lu,\"silence_ms\":%lu,"
+        "\"preroll_ms\":%u,\"fill_ms\":%u,\"pacing_ppm\":%d,"
+        "\"reconnecting\":%s,\"time_to_audio_ms\":%lu}",
         bt_source_is_initialized() ? "true" : "false",
         bt_source_state_to_str(status->state),
         bt_source_is_connected() ? "true" : "false",
@@ -1900,7 +2220,18 @@ static esp_err_t api_bt_source_status_handler(httpd_req_t *req)
         connected_bda,
         status->device_count,
         status->volume,
-        status->error_msg);
+        status->error_msg,
+        audio_player_output_to_str(audio_player_get_output()),
+        (unsigned long)status->underruns,
+        (unsigned long)status->callbacks,
+        (unsigned long)status->partial_callbacks,
+        (unsigned long)status->empty_callbacks,
+        (unsigned long)status->silence_ms,
+        status->preroll_ms,
+        status->fill_ms,
+        status->pacing_ppm,
+        status->reconnecting ? "true" : "false",
+        (unsigned long)status->time_to_audio_ms);
 
     httpd_resp_sendstr(req, json);
     return ESP_OK;
@@ -2033,6 +2364,74 @@ static esp_err_t api_bt_source_disconnect_handler(httpd_req_t *req)
     return ESP_OK;
 }
 
+static esp_err_t api_bt_source_paired_handler(httpd_req_t *req)
+{
+    add_cors_headers(req);
+    httpd_resp_set_type(req, "application/json");
+
+    bt_sink_cache_entry_t sinks[BT_SINK_CACHE_MAX];
+    uint8_t count = bt_source_get_paired(sinks, BT_SINK_CACHE_MAX);
+
+    cJSON *root = cJSON_CreateArray();
+    for (int i = 0; i < count; i++) {
+        char bda_str[18];
+        bt_source_bda_to_str(sinks[i].bda, bda_str);
+
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddStringToObject(item, "name", sinks[i].name);
+        cJSON_AddStringToObject(item, "bda", bda_str);
+        cJSON_AddNumberToObject(item, "rssi", sinks[i].rssi);
+        cJSON_AddNumberToObject(item, "sample_rate", sinks[i].sample_rate);
+        cJSON_AddNumberToObject(item, "channels", sinks[i].channels);
+        cJSON_AddNumberToObject(item, "min_bitpool", sinks[i].min_bitpool);
+        cJSON_AddNumberToObject(item, "max_bitpool", sinks[i].max_bitpool);
+        cJSON_AddItemToArray(root, item);
+    }
+
+    char *json = cJSON_PrintUnformatted(root);
+    httpd_resp_sendstr(req, json ? json : "[]");
+    free(json);
+    cJSON_Delete(root);
+    return ESP_OK;
+}
+
+static esp_err_t api_bt_source_forget_handler(httpd_req_t *req)
+{
+    add_cors_headers(req);
+    httpd_resp_set_type(req, "application/json");
+
+    char buf[64];
+    int ret = httpd_req_recv(req, buf, sizeof(buf) - 1);
+    if (ret <= 0) {
+        httpd_resp_sendstr(req, "{\"success\":false,\"error\":\"No data\"}");
+        return ESP_OK;
+    }
+    buf[ret] = '\0';
+
+    cJSON *root = cJSON_Parse(buf);
+    if (!root) {
+        httpd_resp_sendstr(req, "{\"success\":false,\"error\":\"Invalid JSON\"}");
+        return ESP_OK;
+    }
+
+    esp_err_t err = ESP_ERR_INVALID_ARG;
+    cJSON *bda_json = cJSON_GetObjectItem(root, "bda");
+    if (bda_json && cJSON_IsString(bda_json)) {
+        uint8_t bda[6];
+        if (bt_source_str_to_bda(bda_json->valuestring, bda) == ESP_OK) {
+            err = bt_source_forget(bda);
+        }
+    }
+    cJSON_Delete(root);
+
+    if (err == ESP_OK) {
+        httpd_resp_sendstr(req, "{\"success\":true}");
+    } else {
+        httpd_resp_sendstr(req, "{\"success\":false,\"error\":\"Unknown device\"}");
+    }
+    return ESP_OK;
+}
+
 static esp_err_t api_bt_source_init_handler(httpd_req_t *req)
 {
     add_cors_headers(req);
@@ -2063,6 +2462,52 @@ static esp_err_t api_bt_source_deinit_handler(httpd_req_t *req)
     return ESP_OK;
 }
 
+// Wyjście odtwarzacza: {"mode": "i2s" | "bt" | "both"} - przełączane bez restartu dekodowania
+static esp_err_t api_bt_source_output_handler(httpd_req_t *req)
+{
+    add_cors_headers(req);
+    httpd_resp_set_type(req, "application/json");
+
+    char buf[96];
+    int ret = httpd_req_recv(req, buf, sizeof(buf) - 1);
+    if (ret <= 0) {
+        httpd_resp_sendstr(req, "{\"success\":false,\"error\":\"No data\"}");
+        return ESP_OK;
+    }
+    buf[ret] = '\0';
+
+    cJSON *root = cJSON_Parse(buf);
+    if (!root) {
+        httpd_resp_sendstr(req, "{\"success\":false,\"error\":\"Invalid JSON\"}");
+        return ESP_OK;
+    }
+
+    esp_err_t err = ESP_ERR_INVALID_ARG;
+    cJSON *preroll = cJSON_GetObjectItem(root, "preroll_ms");
+    if (preroll && cJSON_IsNumber(preroll) && preroll->valueint >= 0 && preroll->valueint <= 1000) {
+        err = bt_source_set_preroll_ms((uint16_t)preroll->valueint);
+    }
+    cJSON *mode = cJSON_GetObjectItem(root, "mode");
+    if (mode && cJSON_IsString(mode)) {
+        err = ESP_ERR_INVALID_ARG;
+        for (player_output_t out = PLAYER_OUTPUT_I2S; out <= PLAYER_OUTPUT_BOTH; out++) {
+            if (strcmp(mode->valuestring, audio_player_output_to_str(out)) == 0) {
+                err = audio_player_set_output(out);
+                break;
+            }
+        }
+    }
+    cJSON_Delete(root);
+
+    if (err == ESP_OK) {
+        httpd_resp_sendstr(req, "{\"success\":true}");
+    } else {
+        httpd_resp_sendstr(req, "{\"success\":false,\"error\":\"Invalid mode or preroll_ms\"}");
+    }
+
+    return ESP_OK;
+}
+
 // ============================================
 // API handlers - Audio Settings (EQ, Balance, Effects)
 // ============================================
@@ -2279,7 +2724,7 @@ esp_err_t web_server_init(void)
     ESP_LOGI(TAG, "Starting web server...");
 
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
-    config.max_uri_handlers = 64;  // Increased for all API endpoints
+    config.max_uri_handlers = 72;  // Increased for all API endpoints
     config.stack_size = 8192;
     config.uri_match_fn = httpd_uri_match_wildcard;
     config.core_id = 0;  // Pin web server to core 0, leave core 1 for audio
@@ -2337,6 +2782,8 @@ esp_err_t web_server_init(void)
     httpd_uri_t sd_status_uri = { .uri = "/api/sdcard", .method = HTTP_GET, .handler = api_sdcard_status_handler };
     httpd_uri_t sd_browse_uri = { .uri = "/api/sdcard/browse", .method = HTTP_GET, .handler = api_sdcard_browse_handler };
     httpd_uri_t sd_play_uri = { .uri = "/api/sdcard/play", .method = HTTP_POST, .handler = api_sdcard_play_handler };
+    httpd_uri_t sd_library_uri = { .uri = "/api/sdcard/library", .method = HTTP_GET, .handler = api_sdcard_library_handler };
+    httpd_uri_t sd_rescan_uri = { .uri = "/api/sdcard/library", .method = HTTP_POST, .handler = api_sdcard_rescan_handler };
 
     // AUX Input API
     httpd_uri_t aux_get_uri = { .uri = "/api/aux", .method = HTTP_GET, .handler = api_aux_handler };
@@ -2348,6 +2795,7 @@ esp_err_t web_server_init(void)
     // System Info API
     httpd_uri_t sysinfo_uri = { .uri = "/api/system", .method = HTTP_GET, .handler = api_system_info_handler };
     httpd_uri_t sysdiag_uri = { .uri = "/api/system/diag", .method = HTTP_GET, .handler = api_system_diag_handler };
+    httpd_uri_t sysdiag_reset_uri = { .uri = "/api/system/diag/reset", .method = HTTP_POST, .handler = api_system_diag_reset_handler };
 
     // Piped (YouTube Music) API
     httpd_uri_t piped_search_uri = { .uri = "/api/piped/search", .method = HTTP_GET, .handler = api_piped_search_handler };
@@ -2371,6 +2819,9 @@ esp_err_t web_server_init(void)
     httpd_uri_t bt_source_devices_uri = { .uri = "/api/bt/source/devices", .method = HTTP_GET, .handler = api_bt_source_devices_handler };
     httpd_uri_t bt_source_connect_uri = { .uri = "/api/bt/source/connect", .method = HTTP_POST, .handler = api_bt_source_connect_handler };
     httpd_uri_t bt_source_disconnect_uri = { .uri = "/api/bt/source/disconnect", .method = HTTP_POST, .handler = api_bt_source_disconnect_handler };
+    httpd_uri_t bt_source_output_uri = { .uri = "/api/bt/source/output", .method = HTTP_POST, .handler = api_bt_source_output_handler };
+    httpd_uri_t bt_source_paired_uri = { .uri = "/api/bt/source/paired", .method = HTTP_GET, .handler = api_bt_source_paired_handler };
+    httpd_uri_t bt_source_forget_uri = { .uri = "/api/bt/source/forget", .method = HTTP_POST, .handler = api_bt_source_forget_handler };
 
     // Audio Settings API (EQ, Balance, Effects)
     httpd_uri_t audio_get_uri = { .uri = "/api/audio", .method = HTTP_GET, .handler = api_audio_get_handler };
@@ -2440,6 +2891,8 @@ esp_err_t web_server_init(void)
     httpd_register_uri_handler(server, &sd_status_uri);
     httpd_register_uri_handler(server, &sd_browse_uri);
     httpd_register_uri_handler(server, &sd_play_uri);
+    httpd_register_uri_handler(server, &sd_library_uri);
+    httpd_register_uri_handler(server, &sd_rescan_uri);
 
     // Rejestracja - AUX API
     httpd_register_uri_handler(server, &aux_get_uri);
@@ -2449,6 +2902,7 @@ esp_err_t web_server_init(void)
     httpd_register_uri_handler(server, &battery_uri);
     httpd_register_uri_handler(server, &sysinfo_uri);
     httpd_register_uri_handler(server, &sysdiag_uri);
+    httpd_register_uri_handler(server, &sysdiag_reset_uri);
 
     // Rejestracja - Piped API
     httpd_register_uri_handler(server, &piped_search_uri);
@@ -2472,6 +2926,9 @@ esp_err_t web_server_init(void)
     httpd_register_uri_handler(server, &bt_source_devices_uri);
     httpd_register_uri_handler(server, &bt_source_connect_uri);
     httpd_register_uri_handler(server, &bt_source_disconnect_uri);
+    httpd_register_uri_handler(server, &bt_source_output_uri);
+    httpd_register_uri_handler(server, &bt_source_paired_uri);
+    httpd_register_uri_handler(server, &bt_source_forget_uri);
 
     // Rejestracja - Audio Settings API
     httpd_register_uri_handler(server, &audio_get_uri);